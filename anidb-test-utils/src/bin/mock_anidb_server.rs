@@ -0,0 +1,94 @@
+//! Standalone mock AniDB UDP API server
+//!
+//! Runs a [`MockUdpServer`] until interrupted, for load generators that
+//! run outside this process such as the Node addon benchmark. The address
+//! is printed on the first line of stdout and the server's counters on
+//! exit.
+//!
+//! Usage: mock_anidb_server [--bind ADDR] [--latency-ms N] [--jitter-ms N]
+//!        [--loss P] [--flood-rate N] [--flood-burst N]
+//!        [--flood-response drop|busy|banned] [--ban-secs N]
+//!        [--not-found P] [--anime N] [--seed N]
+
+use anidb_test_utils::mocks::{FloodResponse, MockServerConfig, MockUdpServer};
+use std::process::ExitCode;
+use std::time::Duration;
+
+const USAGE: &str = "Usage: mock_anidb_server [--bind ADDR] [--latency-ms N] [--jitter-ms N] \
+[--loss P] [--flood-rate N] [--flood-burst N] [--flood-response drop|busy|banned] \
+[--ban-secs N] [--not-found P] [--anime N] [--seed N]";
+
+fn parse_args() -> Result<MockServerConfig, String> {
+    let mut config = MockServerConfig::default();
+    let mut flood_response = "drop".to_string();
+    let mut ban = Duration::from_secs(30);
+
+    let mut args = std::env::args().skip(1);
+    while let Some(flag) = args.next() {
+        let value = args.next().ok_or_else(|| format!("{flag} needs a value"))?;
+        let number = || {
+            value
+                .parse::<f64>()
+                .map_err(|_| format!("{flag}: not a number: {value}"))
+        };
+        match flag.as_str() {
+            "--bind" => {
+                config.bind_addr = value
+                    .parse()
+                    .map_err(|_| format!("--bind: not an address: {value}"))?
+            }
+            "--latency-ms" => config.latency = Duration::from_secs_f64(number()? / 1000.0),
+            "--jitter-ms" => config.jitter = Duration::from_secs_f64(number()? / 1000.0),
+            "--loss" => config.packet_loss = number()?,
+            "--flood-rate" => config.flood_rate = Some(number()?),
+            "--flood-burst" => config.flood_burst = number()?,
+            "--flood-response" => flood_response = value.clone(),
+            "--ban-secs" => ban = Duration::from_secs_f64(number()?),
+            "--not-found" => config.not_found_ratio = number()?,
+            "--anime" => config.anime_count = number()? as u64,
+            "--seed" => config.seed = number()? as u64,
+            _ => return Err(format!("unknown option {flag}")),
+        }
+    }
+
+    config.flood_response = match flood_response.as_str() {
+        "drop" => FloodResponse::Drop,
+        "busy" => FloodResponse::Busy,
+        "banned" => FloodResponse::Banned(ban),
+        other => return Err(format!("--flood-response: unknown response {other}")),
+    };
+    Ok(config)
+}
+
+#[tokio::main]
+async fn main() -> ExitCode {
+    let config = match parse_args() {
+        Ok(config) => config,
+        Err(e) => {
+            eprintln!("{e}\n{USAGE}");
+            return ExitCode::FAILURE;
+        }
+    };
+
+    let server = match MockUdpServer::start(config).await {
+        Ok(server) => server,
+        Err(e) => {
+            eprintln!("Failed to start the mock server: {e}");
+            return ExitCode::FAILURE;
+        }
+    };
+    println!("{}", server.addr());
+
+    let _ = tokio::signal::ctrl_c().await;
+    let stats = server.stats();
+    eprintln!(
+        "packets {} retransmits {} requests lost {} replies lost {} flooded {} replies {}",
+        stats.packets_received,
+        stats.retransmits,
+        stats.requests_lost,
+        stats.replies_lost,
+        stats.flooded,
+        stats.replies_sent
+    );
+    ExitCode::SUCCESS
+}
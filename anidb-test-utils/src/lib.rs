@@ -9,5 +9,5 @@ pub mod performance;
 
 // Re-export commonly used types
 pub use builders::{TestDataBuilder, TestFileBuilder};
-pub use mocks::{MockAniDBClient, MockFileSystem};
+pub use mocks::{MockAniDBClient, MockFileSystem, MockServerConfig, MockUdpServer};
 pub use performance::{CoverageReporter, PerformanceTracker, TestHarness};
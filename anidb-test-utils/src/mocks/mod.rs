@@ -2,6 +2,8 @@
 
 mod client;
 mod filesystem;
+mod udp_server;
 
 pub use client::{MockAniDBClient, MockHashCalculator};
 pub use filesystem::MockFileSystem;
+pub use udp_server::{FloodResponse, MockServerConfig, MockServerStats, MockUdpServer};
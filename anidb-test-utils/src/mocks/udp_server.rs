@@ -0,0 +1,470 @@
+//! Mock AniDB UDP API server
+//!
+//! Benchmarking `ProtocolClient` and the identification path against the
+//! real API is slow and gets the account banned. [`MockUdpServer`] answers
+//! AUTH, FILE, ANIME, EPISODE, GROUP, PING and LOGOUT the way AniDB does,
+//! on a local UDP socket, with configurable latency, packet loss and flood
+//! protection.
+//!
+//! Files are made up from their ED2K hash, so any hash is identified (or
+//! reported unknown) the same way on every run. Files are spread over
+//! [`MockServerConfig::anime_count`] anime and groups, which exercises the
+//! client's memo of anime and group names like a real library would.
+//!
+//! Flood protection follows the API definition: each client IP gets a token
+//! bucket, every packet takes a token (dropped ones included) and packets
+//! over the limit get the configured [`FloodResponse`].
+
+use std::collections::HashMap;
+use std::io;
+use std::net::{IpAddr, SocketAddr};
+use std::sync::Arc;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+use tokio::net::UdpSocket;
+use tokio::task::JoinHandle;
+
+/// What the server does with packets over the flood limit
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FloodResponse {
+    /// Drop them without a reply, as AniDB does
+    Drop,
+    /// Reply `602 SERVER BUSY`
+    Busy,
+    /// Reply `555 BANNED` to every packet for the given time
+    Banned(Duration),
+}
+
+/// Behaviour of a [`MockUdpServer`]
+#[derive(Debug, Clone)]
+pub struct MockServerConfig {
+    /// Address to listen on; port 0 picks a free port
+    pub bind_addr: SocketAddr,
+    /// Time before each reply is sent
+    pub latency: Duration,
+    /// Extra delay up to this much, drawn for each reply
+    pub jitter: Duration,
+    /// Chance, 0.0 - 1.0, that a request or a reply is lost. Each direction
+    /// is drawn separately.
+    pub packet_loss: f64,
+    /// Packets per second each client IP may send, `None` for no limit
+    pub flood_rate: Option<f64>,
+    /// Packets a client may send at once before the limit applies
+    pub flood_burst: f64,
+    /// Reply to packets over the flood limit
+    pub flood_response: FloodResponse,
+    /// Share of files, 0.0 - 1.0, answered with `320 NO SUCH FILE`
+    pub not_found_ratio: f64,
+    /// Anime (and groups) files are spread over
+    pub anime_count: u64,
+    /// Seed of the loss and jitter draws
+    pub seed: u64,
+}
+
+impl Default for MockServerConfig {
+    fn default() -> Self {
+        Self {
+            bind_addr: SocketAddr::from(([127, 0, 0, 1], 0)),
+            latency: Duration::ZERO,
+            jitter: Duration::ZERO,
+            packet_loss: 0.0,
+            flood_rate: None,
+            // AniDB enforces its limit after the first five packets
+            flood_burst: 5.0,
+            flood_response: FloodResponse::Drop,
+            not_found_ratio: 0.0,
+            anime_count: 16,
+            seed: 0x5eed,
+        }
+    }
+}
+
+/// Counters of a [`MockUdpServer`]
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct MockServerStats {
+    /// Packets that arrived, lost requests included
+    pub packets_received: u64,
+    /// Packets identical to the previous one from the same client
+    pub retransmits: u64,
+    /// Requests lost before the server saw them
+    pub requests_lost: u64,
+    /// Replies lost on the way back
+    pub replies_lost: u64,
+    /// Packets over the flood limit
+    pub flooded: u64,
+    /// Replies sent
+    pub replies_sent: u64,
+}
+
+#[derive(Default)]
+struct Counters {
+    packets_received: AtomicU64,
+    retransmits: AtomicU64,
+    requests_lost: AtomicU64,
+    replies_lost: AtomicU64,
+    flooded: AtomicU64,
+    replies_sent: AtomicU64,
+}
+
+impl Counters {
+    fn snapshot(&self) -> MockServerStats {
+        MockServerStats {
+            packets_received: self.packets_received.load(Ordering::Relaxed),
+            retransmits: self.retransmits.load(Ordering::Relaxed),
+            requests_lost: self.requests_lost.load(Ordering::Relaxed),
+            replies_lost: self.replies_lost.load(Ordering::Relaxed),
+            flooded: self.flooded.load(Ordering::Relaxed),
+            replies_sent: self.replies_sent.load(Ordering::Relaxed),
+        }
+    }
+}
+
+/// Flood state of one client IP
+struct FloodBucket {
+    tokens: f64,
+    updated_at: Instant,
+    banned_until: Option<Instant>,
+}
+
+/// State of the receive loop
+struct State {
+    rng: u64,
+    flood: HashMap<IpAddr, FloodBucket>,
+    /// Last packet of each client, to spot retransmits
+    last_packet: HashMap<SocketAddr, String>,
+    /// Sessions handed out by AUTH
+    sessions: HashMap<String, SocketAddr>,
+    next_session: u64,
+}
+
+impl State {
+    /// Next draw in [0, 1), from a SplitMix64 sequence
+    fn draw(&mut self) -> f64 {
+        self.rng = self.rng.wrapping_add(0x9e37_79b9_7f4a_7c15);
+        let mut z = self.rng;
+        z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+        z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+        z ^= z >> 31;
+        (z >> 11) as f64 / (1u64 << 53) as f64
+    }
+
+    /// Whether a packet from `ip` is over the flood limit; counts it either way
+    fn flooded(&mut self, config: &MockServerConfig, ip: IpAddr, now: Instant) -> bool {
+        let Some(rate) = config.flood_rate else {
+            return false;
+        };
+        let burst = config.flood_burst.max(1.0);
+        let bucket = self.flood.entry(ip).or_insert(FloodBucket {
+            tokens: burst,
+            updated_at: now,
+            banned_until: None,
+        });
+
+        if let Some(until) = bucket.banned_until {
+            if now < until {
+                return true;
+            }
+            bucket.banned_until = None;
+        }
+
+        let elapsed = now
+            .saturating_duration_since(bucket.updated_at)
+            .as_secs_f64();
+        bucket.tokens = (bucket.tokens + elapsed * rate).min(burst);
+        bucket.updated_at = now;
+        // Packets over the limit still count, down to a burst's worth of debt
+        bucket.tokens = (bucket.tokens - 1.0).max(-burst);
+        if bucket.tokens >= 0.0 {
+            return false;
+        }
+        if let FloodResponse::Banned(duration) = config.flood_response {
+            bucket.banned_until = Some(now + duration);
+        }
+        true
+    }
+}
+
+/// A mock AniDB UDP API server, running until dropped
+pub struct MockUdpServer {
+    addr: SocketAddr,
+    counters: Arc<Counters>,
+    task: JoinHandle<()>,
+}
+
+impl MockUdpServer {
+    /// Bind the socket and start answering on the current tokio runtime
+    pub async fn start(config: MockServerConfig) -> io::Result<Self> {
+        let socket = Arc::new(UdpSocket::bind(config.bind_addr).await?);
+        let addr = socket.local_addr()?;
+        let counters = Arc::new(Counters::default());
+        let state = State {
+            rng: config.seed,
+            flood: HashMap::new(),
+            last_packet: HashMap::new(),
+            sessions: HashMap::new(),
+            next_session: 1,
+        };
+        let task = tokio::spawn(serve(socket, config, state, counters.clone()));
+        Ok(Self {
+            addr,
+            counters,
+            task,
+        })
+    }
+
+    /// Address the server listens on
+    pub fn addr(&self) -> SocketAddr {
+        self.addr
+    }
+
+    /// Counters so far
+    pub fn stats(&self) -> MockServerStats {
+        self.counters.snapshot()
+    }
+}
+
+impl Drop for MockUdpServer {
+    fn drop(&mut self) {
+        self.task.abort();
+    }
+}
+
+async fn serve(
+    socket: Arc<UdpSocket>,
+    config: MockServerConfig,
+    mut state: State,
+    counters: Arc<Counters>,
+) {
+    let mut buffer = vec![0u8; 1500];
+    loop {
+        let Ok((len, peer)) = socket.recv_from(&mut buffer).await else {
+            continue;
+        };
+        counters.packets_received.fetch_add(1, Ordering::Relaxed);
+        let packet = String::from_utf8_lossy(&buffer[..len]).trim().to_string();
+
+        // A lost request never reaches the server, so it is not counted
+        // against the flood limit either
+        if state.draw() < config.packet_loss {
+            counters.requests_lost.fetch_add(1, Ordering::Relaxed);
+            continue;
+        }
+        if state.last_packet.get(&peer) == Some(&packet) {
+            counters.retransmits.fetch_add(1, Ordering::Relaxed);
+        }
+        state.last_packet.insert(peer, packet.clone());
+
+        let reply = if state.flooded(&config, peer.ip(), Instant::now()) {
+            counters.flooded.fetch_add(1, Ordering::Relaxed);
+            match config.flood_response {
+                FloodResponse::Drop => continue,
+                FloodResponse::Busy => "602 SERVER BUSY - TRY AGAIN LATER\n".to_string(),
+                FloodResponse::Banned(_) => "555 BANNED\nflood limit\n".to_string(),
+            }
+        } else {
+            answer(&config, &mut state, peer, &packet)
+        };
+        let wait = config.latency + config.jitter.mul_f64(state.draw());
+        let lost = state.draw() < config.packet_loss;
+
+        let socket = socket.clone();
+        let counters = counters.clone();
+        tokio::spawn(async move {
+            if !wait.is_zero() {
+                tokio::time::sleep(wait).await;
+            }
+            if lost {
+                counters.replies_lost.fetch_add(1, Ordering::Relaxed);
+            } else if socket.send_to(reply.as_bytes(), peer).await.is_ok() {
+                counters.replies_sent.fetch_add(1, Ordering::Relaxed);
+            }
+        });
+    }
+}
+
+/// Split `COMMAND key=value&key=value` into its name and parameters
+fn parse_command(packet: &str) -> (&str, HashMap<&str, &str>) {
+    let (name, params) = packet.split_once(' ').unwrap_or((packet, ""));
+    let params = params
+        .split('&')
+        .filter_map(|pair| pair.split_once('='))
+        .collect();
+    (name, params)
+}
+
+/// Reply to one request
+fn answer(config: &MockServerConfig, state: &mut State, peer: SocketAddr, packet: &str) -> String {
+    let (name, params) = parse_command(packet);
+
+    match name {
+        "PING" => return "300 PONG\n".to_string(),
+        "AUTH" => {
+            if !params.contains_key("user") || !params.contains_key("pass") {
+                return "505 ILLEGAL INPUT OR ACCESS DENIED\n".to_string();
+            }
+            let session = format!("mock{}", state.next_session);
+            state.next_session += 1;
+            state.sessions.insert(session.clone(), peer);
+            return format!("200 {session} LOGIN ACCEPTED\n");
+        }
+        _ => {}
+    }
+
+    // Everything else needs the session of this client
+    match params.get("s") {
+        Some(session) if state.sessions.get(*session) == Some(&peer) => {}
+        Some(_) => return "506 INVALID SESSION\n".to_string(),
+        None => return "501 LOGIN FIRST\n".to_string(),
+    }
+
+    let id = |key: &str| params.get(key).and_then(|v| v.parse::<u64>().ok());
+    match name {
+        "LOGOUT" => {
+            if let Some(session) = params.get("s") {
+                state.sessions.remove(*session);
+            }
+            "203 LOGGED OUT\n".to_string()
+        }
+        "FILE" => match (params.get("ed2k"), id("size")) {
+            (Some(ed2k), Some(size)) => file_reply(config, ed2k, size),
+            _ => "505 ILLEGAL INPUT OR ACCESS DENIED\n".to_string(),
+        },
+        "ANIME" => match id("aid") {
+            Some(aid) => format!(
+                "230 ANIME\n{aid}|2020-2020|TV Series|Action,Comedy|Mock Anime {aid}|\
+                 モック{aid}|Mock Anime {aid} (en)|12|12\n"
+            ),
+            None => "505 ILLEGAL INPUT OR ACCESS DENIED\n".to_string(),
+        },
+        "EPISODE" => match id("eid") {
+            Some(eid) => {
+                let aid = eid / 100;
+                let number = eid % 100;
+                format!(
+                    "240 EPISODE\n{eid}|{aid}|24|800|10|{number}|Episode {number}|\
+                     Dai {number} Wa|第{number}話|1600000000|1\n"
+                )
+            }
+            None => "505 ILLEGAL INPUT OR ACCESS DENIED\n".to_string(),
+        },
+        "GROUP" => match id("gid") {
+            Some(gid) => format!(
+                "250 GROUP\n{gid}|800|100|10|500|Mock Group {gid}|MG{gid}|#mock|irc.mock|\
+                 https://mock.invalid|0\n"
+            ),
+            None => "505 ILLEGAL INPUT OR ACCESS DENIED\n".to_string(),
+        },
+        _ => "598 UNKNOWN COMMAND\n".to_string(),
+    }
+}
+
+/// FILE reply for the made-up file with this hash, in fmask 78C8FEF8 order
+fn file_reply(config: &MockServerConfig, ed2k: &str, size: u64) -> String {
+    // FNV-1a of the hash picks the file
+    let key = ed2k
+        .bytes()
+        .map(|b| b.to_ascii_lowercase())
+        .fold(0xcbf2_9ce4_8422_2325u64, |h, b| {
+            (h ^ b as u64).wrapping_mul(0x0100_0000_01b3)
+        });
+    if (key % 10_000) as f64 / 10_000.0 < config.not_found_ratio {
+        return "320 NO SUCH FILE\n".to_string();
+    }
+
+    let fid = key % 1_000_000_000 + 1;
+    let aid = key % config.anime_count.max(1) + 1;
+    let eid = aid * 100 + (key >> 32) % 24 + 1;
+    let gid = aid;
+    format!(
+        "220 FILE\n{fid}|{aid}|{eid}|{gid}|1|{size}|{ed2k}|0badf00d|high|www|AAC|128|H264/AVC|\
+         2000|1920x1080|japanese|english|1440|mock file|1600000000\n"
+    )
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    async fn exchange(socket: &UdpSocket, request: &str) -> Option<String> {
+        socket.send(request.as_bytes()).await.ok()?;
+        let mut buffer = [0u8; 1500];
+        let len = tokio::time::timeout(Duration::from_millis(500), socket.recv(&mut buffer))
+            .await
+            .ok()?
+            .ok()?;
+        Some(String::from_utf8_lossy(&buffer[..len]).into_owned())
+    }
+
+    async fn start(config: MockServerConfig) -> Option<(MockUdpServer, UdpSocket)> {
+        // UDP sockets may be unavailable in sandboxed environments
+        let server = MockUdpServer::start(config).await.ok()?;
+        let socket = UdpSocket::bind("127.0.0.1:0").await.ok()?;
+        socket.connect(server.addr()).await.ok()?;
+        Some((server, socket))
+    }
+
+    #[tokio::test]
+    async fn test_auth_then_file() {
+        let Some((server, socket)) = start(MockServerConfig::default()).await else {
+            eprintln!("Skipping test_auth_then_file: UDP sockets unavailable");
+            return;
+        };
+
+        let ed2k = "0123456789abcdef0123456789abcdef";
+        let reply = exchange(&socket, &format!("FILE size=1&ed2k={ed2k}")).await;
+        assert_eq!(reply.as_deref(), Some("501 LOGIN FIRST\n"));
+
+        let reply = exchange(
+            &socket,
+            "AUTH user=u&pass=p&protover=3&client=c&clientver=1",
+        )
+        .await
+        .unwrap();
+        assert!(reply.starts_with("200 mock1 LOGIN ACCEPTED"), "{reply}");
+
+        let request = format!("FILE size=42&ed2k={ed2k}&s=mock1");
+        let first = exchange(&socket, &request).await.unwrap();
+        assert!(first.starts_with("220 FILE\n"), "{first}");
+        assert!(first.contains(&format!("|42|{ed2k}|")));
+        assert_eq!(exchange(&socket, &request).await.unwrap(), first);
+        assert_eq!(server.stats().retransmits, 1);
+    }
+
+    #[tokio::test]
+    async fn test_flood_limit() {
+        let config = MockServerConfig {
+            flood_rate: Some(0.5),
+            flood_burst: 2.0,
+            flood_response: FloodResponse::Busy,
+            ..Default::default()
+        };
+        let Some((server, socket)) = start(config).await else {
+            eprintln!("Skipping test_flood_limit: UDP sockets unavailable");
+            return;
+        };
+
+        for i in 0..4 {
+            let reply = exchange(&socket, "PING").await.unwrap();
+            let expected = if i < 2 {
+                "300 PONG\n"
+            } else {
+                "602 SERVER BUSY"
+            };
+            assert!(reply.starts_with(expected), "packet {i}: {reply}");
+        }
+        assert_eq!(server.stats().flooded, 2);
+    }
+
+    #[test]
+    fn test_files_are_stable() {
+        let config = MockServerConfig::default();
+        let ed2k = "00112233445566778899aabbccddeeff";
+        assert_eq!(file_reply(&config, ed2k, 7), file_reply(&config, ed2k, 7));
+
+        let unknown = MockServerConfig {
+            not_found_ratio: 1.0,
+            ..Default::default()
+        };
+        assert_eq!(file_reply(&unknown, ed2k, 7), "320 NO SUCH FILE\n");
+    }
+}
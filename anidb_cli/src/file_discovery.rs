@@ -0,0 +1,6 @@
+//! File discovery for finding files based on glob patterns
+//!
+//! The walker lives in the core library so the FFI can scan directories
+//! natively; this module re-exports it under its original path.
+
+pub use anidb_client_core::file_discovery::*;
@@ -92,6 +92,21 @@ impl ProgressRenderer {
                 self.update_hash_progress(algorithm, bytes_processed, total_bytes);
             }
 
+            ProgressUpdate::DeviceProgress {
+                device,
+                files_completed,
+                files_total,
+                throughput_mbps,
+                ..
+            } => {
+                // Summarize each device once it has been drained
+                if files_completed == files_total {
+                    self.show_status(format!(
+                        "Device {device:x}: {files_total} files at {throughput_mbps:.1} MB/s"
+                    ));
+                }
+            }
+
             ProgressUpdate::Status { message } => {
                 self.show_status(message);
             }
@@ -21,7 +21,7 @@ fn benchmark_ffi_overhead(c: &mut Criterion) {
     let mut group = c.benchmark_group("ffi_overhead");
 
     // Initialize library
-    anidb_init(1);
+    anidb_init(ANIDB_ABI_VERSION);
 
     // Benchmark simple function calls
     group.bench_function("get_version", |b| {
@@ -131,11 +131,7 @@ fn benchmark_client_lifecycle(c: &mut Criterion) {
             max_concurrent_files: 4,
             chunk_size: 65536,
             max_memory_usage: 500_000_000,
-            enable_debug_logging: 0,
-            username: ptr::null(),
-            password: ptr::null(),
-            client_name: ptr::null(),
-            client_version: ptr::null(),
+            ..Default::default()
         };
 
         b.iter(|| {
@@ -280,7 +276,7 @@ fn benchmark_callbacks(c: &mut Criterion) {
             algorithm_count: algorithms.len(),
             enable_progress: 1,
             progress_callback: Some(progress_callback),
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         b.iter(|| {
@@ -338,9 +334,7 @@ fn benchmark_file_processing(c: &mut Criterion) {
                 let options = AniDBProcessOptions {
                     algorithms: algorithms.as_ptr(),
                     algorithm_count: algorithms.len(),
-                    enable_progress: 0,
-                    progress_callback: None,
-                    user_data: ptr::null_mut(),
+                    ..Default::default()
                 };
 
                 b.iter(|| {
@@ -372,9 +366,7 @@ fn benchmark_file_processing(c: &mut Criterion) {
                 let options = AniDBProcessOptions {
                     algorithms: algorithms.as_ptr(),
                     algorithm_count: algorithms.len(),
-                    enable_progress: 0,
-                    progress_callback: None,
-                    user_data: ptr::null_mut(),
+                    ..Default::default()
                 };
 
                 b.iter(|| {
@@ -473,9 +465,7 @@ fn benchmark_parallel_operations(c: &mut Criterion) {
                             let options = AniDBProcessOptions {
                                 algorithms: algorithms.as_ptr(),
                                 algorithm_count: algorithms.len(),
-                                enable_progress: 0,
-                                progress_callback: None,
-                                user_data: ptr::null_mut(),
+                                ..Default::default()
                             };
 
                             let mut result: *mut AniDBFileResult = ptr::null_mut();
@@ -580,9 +570,7 @@ fn benchmark_result_structures(c: &mut Criterion) {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         b.iter(|| {
@@ -607,9 +595,7 @@ fn benchmark_result_structures(c: &mut Criterion) {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         b.iter(|| {
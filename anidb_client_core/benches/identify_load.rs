@@ -0,0 +1,358 @@
+//! Load generator for the identification path
+//!
+//! Drives `anidb_identify_file` or `anidb_identify_batch` through the C ABI
+//! against the mock AniDB server from `anidb-test-utils`, so concurrency
+//! and rate-limit handling can be tuned without touching the real API.
+//! Every request uses a distinct hash, so each one goes to the network.
+//!
+//! Reports achieved QPS, result codes, retries and timeouts (from
+//! `anidb_get_metrics`) and latency percentiles. With `--server` it drives
+//! an external server, e.g. `mock_anidb_server`, instead of starting one
+//! in process. `--output` writes the JSON format of
+//! `scripts/bench-compare.py`.
+//!
+//! Usage: cargo bench --bench identify_load -- [--requests N] [--clients N]
+//!        [--mode single|batch] [--rate N] [--timeout-ms N] [--latency-ms N]
+//!        [--jitter-ms N] [--loss P] [--flood-rate N]
+//!        [--flood-response drop|busy|banned] [--not-found P]
+//!        [--server HOST:PORT] [--output FILE]
+
+use anidb_client_core::ffi::*;
+use anidb_test_utils::mocks::{FloodResponse, MockServerConfig, MockUdpServer};
+use std::ffi::{CString, c_int, c_void};
+use std::ptr;
+use std::sync::Mutex;
+use std::thread;
+use std::time::{Duration, Instant};
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Mode {
+    Single,
+    Batch,
+}
+
+struct Options {
+    requests: usize,
+    clients: usize,
+    mode: Mode,
+    /// Packets per second each client may send
+    rate: f64,
+    timeout_ms: u32,
+    server: Option<String>,
+    mock: MockServerConfig,
+    output: Option<String>,
+}
+
+const USAGE: &str = "Usage: identify_load [--requests N] [--clients N] [--mode single|batch] \
+[--rate N] [--timeout-ms N] [--latency-ms N] [--jitter-ms N] [--loss P] [--flood-rate N] \
+[--flood-response drop|busy|banned] [--not-found P] [--server HOST:PORT] [--output FILE]";
+
+fn parse_args() -> Result<Options, String> {
+    let mut options = Options {
+        requests: 200,
+        clients: 1,
+        mode: Mode::Single,
+        rate: 50.0,
+        timeout_ms: 1000,
+        server: None,
+        mock: MockServerConfig::default(),
+        output: None,
+    };
+
+    let mut args = std::env::args().skip(1);
+    while let Some(flag) = args.next() {
+        // cargo bench passes --bench to every bench binary
+        if flag == "--bench" {
+            continue;
+        }
+        let value = args.next().ok_or_else(|| format!("{flag} needs a value"))?;
+        let number = || {
+            value
+                .parse::<f64>()
+                .map_err(|_| format!("{flag}: not a number: {value}"))
+        };
+        match flag.as_str() {
+            "--requests" => options.requests = number()? as usize,
+            "--clients" => options.clients = (number()? as usize).max(1),
+            "--mode" => {
+                options.mode = match value.as_str() {
+                    "single" => Mode::Single,
+                    "batch" => Mode::Batch,
+                    other => return Err(format!("--mode: unknown mode {other}")),
+                }
+            }
+            "--rate" => options.rate = number()?,
+            "--timeout-ms" => options.timeout_ms = number()? as u32,
+            "--latency-ms" => options.mock.latency = Duration::from_secs_f64(number()? / 1000.0),
+            "--jitter-ms" => options.mock.jitter = Duration::from_secs_f64(number()? / 1000.0),
+            "--loss" => options.mock.packet_loss = number()?,
+            "--flood-rate" => options.mock.flood_rate = Some(number()?),
+            "--flood-response" => {
+                options.mock.flood_response = match value.as_str() {
+                    "drop" => FloodResponse::Drop,
+                    "busy" => FloodResponse::Busy,
+                    "banned" => FloodResponse::Banned(Duration::from_secs(30)),
+                    other => return Err(format!("--flood-response: unknown response {other}")),
+                }
+            }
+            "--not-found" => options.mock.not_found_ratio = number()?,
+            "--server" => options.server = Some(value.clone()),
+            "--output" => options.output = Some(value.clone()),
+            _ => return Err(format!("unknown option {flag}")),
+        }
+    }
+    Ok(options)
+}
+
+/// Distinct hash of request `index`
+fn ed2k_hash(index: usize) -> CString {
+    let mixed = (index as u128 + 1).wrapping_mul(0x9e37_79b9_7f4a_7c15_f39c_c060_5ced_c835);
+    CString::new(format!("{mixed:032x}")).unwrap()
+}
+
+/// What one client saw
+#[derive(Default)]
+struct ClientReport {
+    latencies: Vec<Duration>,
+    identified: u64,
+    not_found: u64,
+    failed: u64,
+    metrics: AniDBMetrics,
+}
+
+impl ClientReport {
+    fn count(&mut self, code: AniDBResult) {
+        match code {
+            AniDBResult::Success => self.identified += 1,
+            AniDBResult::ErrorFileNotFound => self.not_found += 1,
+            _ => self.failed += 1,
+        }
+    }
+}
+
+fn create_client(options: &Options, server: &CString) -> *mut c_void {
+    let username = CString::new("bench").unwrap();
+    let client_name = CString::new("anidbbench").unwrap();
+    let client_version = CString::new("1").unwrap();
+    let config = AniDBConfig {
+        max_concurrent_files: 4,
+        chunk_size: 64 * 1024,
+        username: username.as_ptr(),
+        password: username.as_ptr(),
+        client_name: client_name.as_ptr(),
+        client_version: client_version.as_ptr(),
+        server: server.as_ptr(),
+        request_rate: options.rate,
+        request_timeout_ms: options.timeout_ms,
+        ..Default::default()
+    };
+
+    let mut handle = ptr::null_mut();
+    let result = anidb_client_create_with_config(&config, &mut handle);
+    assert_eq!(result, AniDBResult::Success, "failed to create a client");
+    handle
+}
+
+struct BatchState {
+    start: Instant,
+    report: Mutex<ClientReport>,
+}
+
+extern "C" fn on_identified(
+    _index: usize,
+    code: AniDBResult,
+    _info: *const AniDBAnimeInfo,
+    user_data: *mut c_void,
+) -> c_int {
+    let state = unsafe { &*(user_data as *const BatchState) };
+    let mut report = state.report.lock().unwrap();
+    report.latencies.push(state.start.elapsed());
+    report.count(code);
+    0
+}
+
+/// Identify `hashes` on a new client
+fn run_client(options: &Options, server: &CString, hashes: &[(CString, u64)]) -> ClientReport {
+    let handle = create_client(options, server);
+    let mut report = ClientReport::default();
+
+    match options.mode {
+        Mode::Single => {
+            for (hash, size) in hashes {
+                let mut info = ptr::null_mut();
+                let start = Instant::now();
+                let code = anidb_identify_file(handle, hash.as_ptr(), *size, &mut info);
+                report.latencies.push(start.elapsed());
+                report.count(code);
+                if !info.is_null() {
+                    anidb_free_anime_info(info);
+                }
+            }
+        }
+        Mode::Batch => {
+            let pointers: Vec<_> = hashes.iter().map(|(hash, _)| hash.as_ptr()).collect();
+            let sizes: Vec<_> = hashes.iter().map(|(_, size)| *size).collect();
+            let state = BatchState {
+                start: Instant::now(),
+                report: Mutex::new(ClientReport::default()),
+            };
+            let code = anidb_identify_batch(
+                handle,
+                pointers.as_ptr(),
+                sizes.as_ptr(),
+                hashes.len(),
+                Some(on_identified),
+                &state as *const BatchState as *mut c_void,
+            );
+            assert_eq!(code, AniDBResult::Success, "anidb_identify_batch failed");
+            report = state.report.into_inner().unwrap();
+        }
+    }
+
+    anidb_get_metrics(handle, &mut report.metrics);
+    anidb_client_destroy(handle);
+    report
+}
+
+fn percentile(sorted: &[Duration], p: f64) -> f64 {
+    if sorted.is_empty() {
+        return 0.0;
+    }
+    let rank = ((sorted.len() - 1) as f64 * p).round() as usize;
+    sorted[rank].as_secs_f64() * 1000.0
+}
+
+fn write_json(path: &str, metrics: &[(&str, f64, &str, &str)]) -> std::io::Result<()> {
+    let metrics: serde_json::Map<_, _> = metrics
+        .iter()
+        .map(|(name, value, unit, better)| {
+            (
+                name.to_string(),
+                serde_json::json!({"value": value, "unit": unit, "better": better}),
+            )
+        })
+        .collect();
+    let document = serde_json::json!({
+        "suite": "identify_load",
+        "metrics": metrics,
+    });
+    std::fs::write(path, serde_json::to_string_pretty(&document)? + "\n")
+}
+
+fn main() {
+    let options = match parse_args() {
+        Ok(options) => options,
+        Err(e) => {
+            eprintln!("{e}\n{USAGE}");
+            std::process::exit(2);
+        }
+    };
+
+    // The mock answers from its own runtime while clients block on theirs
+    let runtime = tokio::runtime::Runtime::new().unwrap();
+    let mock = match &options.server {
+        Some(_) => None,
+        None => Some(
+            runtime
+                .block_on(MockUdpServer::start(options.mock.clone()))
+                .expect("failed to start the mock server"),
+        ),
+    };
+    let server = CString::new(match (&options.server, &mock) {
+        (Some(server), _) => server.clone(),
+        (None, Some(mock)) => mock.addr().to_string(),
+        (None, None) => unreachable!(),
+    })
+    .unwrap();
+
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let hashes: Vec<_> = (0..options.requests)
+        .map(|i| (ed2k_hash(i), 350 * 1024 * 1024 + i as u64))
+        .collect();
+    let share = options.requests.div_ceil(options.clients).max(1);
+
+    eprintln!(
+        "Identifying {} files ({:?}) on {} client(s) at {} packets/s each via {}",
+        options.requests,
+        options.mode,
+        options.clients,
+        options.rate,
+        server.to_string_lossy()
+    );
+    let start = Instant::now();
+    let reports: Vec<ClientReport> = thread::scope(|scope| {
+        let workers: Vec<_> = hashes
+            .chunks(share)
+            .map(|chunk| scope.spawn(|| run_client(&options, &server, chunk)))
+            .collect();
+        workers.into_iter().map(|w| w.join().unwrap()).collect()
+    });
+    let elapsed = start.elapsed().as_secs_f64();
+
+    let mut latencies: Vec<Duration> = reports.iter().flat_map(|r| r.latencies.clone()).collect();
+    latencies.sort();
+    let sum = |f: fn(&ClientReport) -> u64| reports.iter().map(f).sum::<u64>();
+    let identified = sum(|r| r.identified);
+    let not_found = sum(|r| r.not_found);
+    let failed = sum(|r| r.failed);
+    let retries = sum(|r| r.metrics.network_retries);
+    let timeouts = sum(|r| r.metrics.network_timeouts);
+    let rate_limit_wait_ms = sum(|r| r.metrics.rate_limit_wait_us) as f64 / 1000.0;
+    let qps = latencies.len() as f64 / elapsed;
+
+    eprintln!(
+        "  {} results in {elapsed:.2} s: {qps:.1} QPS",
+        latencies.len()
+    );
+    eprintln!("  identified {identified}, not found {not_found}, failed {failed}");
+    eprintln!(
+        "  retries {retries}, timeouts {timeouts}, rate limit wait {rate_limit_wait_ms:.0} ms"
+    );
+    eprintln!(
+        "  latency p50 {:.1} ms, p90 {:.1} ms, p99 {:.1} ms, max {:.1} ms",
+        percentile(&latencies, 0.50),
+        percentile(&latencies, 0.90),
+        percentile(&latencies, 0.99),
+        percentile(&latencies, 1.0)
+    );
+    if let Some(mock) = &mock {
+        let stats = mock.stats();
+        eprintln!(
+            "  server: {} packets ({:.2} per file), {} retransmits, {} requests and {} \
+             replies lost, {} flooded",
+            stats.packets_received,
+            stats.packets_received as f64 / options.requests.max(1) as f64,
+            stats.retransmits,
+            stats.requests_lost,
+            stats.replies_lost,
+            stats.flooded
+        );
+    }
+
+    if let Some(output) = &options.output {
+        let metrics = [
+            ("identify.qps", qps, "req/s", "higher"),
+            (
+                "identify.latency_p50_ms",
+                percentile(&latencies, 0.50),
+                "ms",
+                "lower",
+            ),
+            (
+                "identify.latency_p99_ms",
+                percentile(&latencies, 0.99),
+                "ms",
+                "lower",
+            ),
+            ("identify.retries", retries as f64, "count", "lower"),
+            ("identify.failed", failed as f64, "count", "lower"),
+        ];
+        if let Err(e) = write_json(output, &metrics) {
+            eprintln!("Failed to write {output}: {e}");
+            std::process::exit(1);
+        }
+    }
+
+    anidb_cleanup();
+}
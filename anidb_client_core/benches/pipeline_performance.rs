@@ -4,6 +4,7 @@ use anidb_client_core::hashing::HashAlgorithm;
 use anidb_client_core::pipeline::{
     HashingStage, PipelineConfig, StreamingPipelineBuilder, ValidationStage,
 };
+use anidb_client_core::platform::IoMode;
 use criterion::{BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
 use std::hint::black_box;
 use std::time::Duration;
@@ -189,6 +190,7 @@ fn bench_memory_configs(c: &mut Criterion) {
                             chunk_size: 64 * 1024,
                             parallel_stages: false,
                             max_memory,
+                            io_mode: IoMode::Auto,
                         };
 
                         let hashing = Box::new(HashingStage::new(&[HashAlgorithm::ED2K]));
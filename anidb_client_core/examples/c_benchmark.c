@@ -0,0 +1,401 @@
+/**
+ * Benchmarks of the AniDB C ABI
+ *
+ * Measures hashing throughput of anidb_calculate_hash_buffer per algorithm,
+ * the fixed cost of an FFI call, progress and event delivery latency, and
+ * batch throughput as max_concurrent grows. Results are written as JSON
+ * (see scripts/bench-compare.py) so runs can be checked against a stored
+ * baseline; a human-readable summary goes to stderr.
+ *
+ * Usage: c_benchmark [--quick] [--threads N] [--output FILE]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/anidb.h"
+
+#define MAX_METRICS 64
+#define MAX_BATCH_FILES 16
+
+typedef struct {
+    char name[64];
+    double value;
+    const char* unit;
+    int higher_is_better;
+    /** Allowed relative change before a regression is reported (0 = default) */
+    double tolerance;
+} metric_t;
+
+static metric_t metrics[MAX_METRICS];
+static size_t metric_count = 0;
+
+/* Sizes, shrunk by --quick */
+static size_t hash_bytes = 64u << 20;
+static size_t file_bytes = 64u << 20;
+static size_t batch_file_bytes = 16u << 20;
+static size_t batch_files = 8;
+static uint64_t call_iterations = 1000000;
+static int max_threads = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void record(const char* name, double value, const char* unit,
+                   int higher_is_better, double tolerance) {
+    if (metric_count == MAX_METRICS) {
+        return;
+    }
+    metric_t* m = &metrics[metric_count++];
+    snprintf(m->name, sizeof(m->name), "%s", name);
+    m->value = value;
+    m->unit = unit;
+    m->higher_is_better = higher_is_better;
+    m->tolerance = tolerance;
+    fprintf(stderr, "  %-32s %12.3f %s\n", name, value, unit);
+}
+
+static int check(anidb_result_t result, const char* what) {
+    if (result != ANIDB_SUCCESS) {
+        fprintf(stderr, "%s failed: %s\n", what, anidb_error_string(result));
+        return 0;
+    }
+    return 1;
+}
+
+/* Write `size` bytes of a fixed pattern to a new temporary file */
+static int create_file(char* path, size_t path_size, size_t size, unsigned seed) {
+    const char* dir = getenv("TMPDIR");
+    snprintf(path, path_size, "%s/anidb_bench_XXXXXX", dir && *dir ? dir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 0;
+    }
+
+    uint8_t chunk[1 << 16];
+    for (size_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = (uint8_t)(i * 31 + seed);
+    }
+    for (size_t written = 0; written < size;) {
+        size_t n = size - written < sizeof(chunk) ? size - written : sizeof(chunk);
+        if (write(fd, chunk, n) != (ssize_t)n) {
+            perror("write");
+            close(fd);
+            return 0;
+        }
+        written += n;
+    }
+    close(fd);
+    return 1;
+}
+
+/* ==== Hash throughput =================================================== */
+
+static void bench_hash_buffer(void) {
+    static const struct {
+        anidb_hash_algorithm_t algorithm;
+        const char* name;
+    } algorithms[] = {
+        {ANIDB_HASH_ED2K, "ed2k"},
+        {ANIDB_HASH_CRC32, "crc32"},
+        {ANIDB_HASH_MD5, "md5"},
+        {ANIDB_HASH_SHA1, "sha1"},
+        {ANIDB_HASH_TTH, "tth"},
+    };
+
+    uint8_t* data = malloc(hash_bytes);
+    if (!data) {
+        return;
+    }
+    for (size_t i = 0; i < hash_bytes; i++) {
+        data[i] = (uint8_t)(i * 2654435761u >> 24);
+    }
+
+    fprintf(stderr, "Hash throughput (%zu MiB buffer)\n", hash_bytes >> 20);
+    for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+        char hash[256];
+        double best = 0.0;
+        double started = now_seconds();
+        /* Best of at least three runs, or as many as fit in half a second */
+        for (int run = 0; run < 3 || now_seconds() - started < 0.5; run++) {
+            double t0 = now_seconds();
+            if (!check(anidb_calculate_hash_buffer(data, hash_bytes, algorithms[a].algorithm,
+                                                   hash, sizeof(hash)),
+                       "anidb_calculate_hash_buffer")) {
+                break;
+            }
+            double rate = (double)hash_bytes / (now_seconds() - t0) / 1e9;
+            if (rate > best) {
+                best = rate;
+            }
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "hash_buffer.%s", algorithms[a].name);
+        record(name, best, "GB/s", 1, 0);
+    }
+    free(data);
+}
+
+/* ==== FFI call overhead ================================================= */
+
+static void bench_call_overhead(void) {
+    fprintf(stderr, "FFI call overhead\n");
+
+    volatile size_t sink = 0;
+    double t0 = now_seconds();
+    for (uint64_t i = 0; i < call_iterations; i++) {
+        sink += anidb_hash_buffer_size(ANIDB_HASH_ED2K);
+    }
+    record("ffi.hash_buffer_size", (now_seconds() - t0) * 1e9 / (double)call_iterations,
+           "ns/call", 0, 0.5);
+
+    /* A full entry point: validation, panic guard and an empty hash */
+    char hash[16];
+    uint64_t iterations = call_iterations / 10;
+    t0 = now_seconds();
+    for (uint64_t i = 0; i < iterations; i++) {
+        anidb_calculate_hash_buffer(NULL, 0, ANIDB_HASH_CRC32, hash, sizeof(hash));
+    }
+    record("ffi.hash_buffer_empty", (now_seconds() - t0) * 1e9 / (double)iterations,
+           "ns/call", 0, 0.5);
+
+    anidb_memory_stats_t stats;
+    t0 = now_seconds();
+    for (uint64_t i = 0; i < iterations; i++) {
+        anidb_get_memory_stats(&stats);
+    }
+    record("ffi.get_memory_stats", (now_seconds() - t0) * 1e9 / (double)iterations,
+           "ns/call", 0, 0.5);
+    (void)sink;
+}
+
+/* ==== Progress and event delivery ======================================= */
+
+typedef struct {
+    double started;
+    double first;
+    double last;
+    double max_gap;
+    uint64_t count;
+} progress_timing_t;
+
+static void on_progress(float percentage, uint64_t processed, uint64_t total, void* user_data) {
+    progress_timing_t* timing = user_data;
+    double now = now_seconds();
+    double gap = now - (timing->count ? timing->last : timing->started);
+    if (timing->count == 0) {
+        timing->first = now - timing->started;
+    }
+    if (gap > timing->max_gap) {
+        timing->max_gap = gap;
+    }
+    timing->last = now;
+    timing->count++;
+    (void)percentage;
+    (void)processed;
+    (void)total;
+}
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ms;
+    uint64_t max_ms;
+} event_timing_t;
+
+/* Runs on the client's event thread; read only after disconnecting */
+static void on_event(const anidb_event_t* event, void* user_data) {
+    event_timing_t* timing = user_data;
+    uint64_t now = wall_ms();
+    uint64_t latency = now > event->timestamp ? now - event->timestamp : 0;
+    timing->count++;
+    timing->total_ms += latency;
+    if (latency > timing->max_ms) {
+        timing->max_ms = latency;
+    }
+}
+
+static void bench_delivery(anidb_client_handle_t client, const char* path) {
+    fprintf(stderr, "Progress and event delivery (%zu MiB file)\n", file_bytes >> 20);
+
+    event_timing_t events = {0};
+    if (!check(anidb_event_connect(client, on_event, &events), "anidb_event_connect")) {
+        return;
+    }
+
+    anidb_hash_algorithm_t algorithm = ANIDB_HASH_ED2K;
+    progress_timing_t progress = {0};
+    anidb_process_options_t options = {
+        .algorithms = &algorithm,
+        .algorithm_count = 1,
+        .enable_progress = 1,
+        .progress_callback = on_progress,
+        .user_data = &progress,
+    };
+    anidb_file_result_t* result = NULL;
+    progress.started = now_seconds();
+    anidb_result_t status = anidb_process_file(client, path, &options, &result);
+    double elapsed = now_seconds() - progress.started;
+    anidb_event_disconnect(client);
+    if (!check(status, "anidb_process_file")) {
+        return;
+    }
+    anidb_free_file_result(result);
+
+    record("process_file.ed2k", (double)file_bytes / elapsed / 1e9, "GB/s", 1, 0);
+    if (progress.count > 0) {
+        record("progress.first_ms", progress.first * 1e3, "ms", 0, 1.0);
+        record("progress.max_gap_ms", progress.max_gap * 1e3, "ms", 0, 1.0);
+        record("progress.rate", (double)progress.count / elapsed, "updates/s", 1, 0.5);
+    }
+    if (events.count > 0) {
+        record("events.latency_mean_ms", (double)events.total_ms / (double)events.count, "ms",
+               0, 1.0);
+        record("events.latency_max_ms", (double)events.max_ms, "ms", 0, 1.0);
+    }
+}
+
+/* ==== Batch scaling ===================================================== */
+
+static void bench_batch_scaling(const char** paths, size_t count) {
+    fprintf(stderr, "Batch scaling (%zu x %zu MiB)\n", count, batch_file_bytes >> 20);
+
+    double single = 0.0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        /* A fresh client each time so nothing is answered from its cache */
+        anidb_client_handle_t client = NULL;
+        if (!check(anidb_client_create(&client), "anidb_client_create")) {
+            return;
+        }
+
+        anidb_hash_algorithm_t algorithm = ANIDB_HASH_ED2K;
+        anidb_batch_options_t options = {
+            .algorithms = &algorithm,
+            .algorithm_count = 1,
+            .max_concurrent = (size_t)threads,
+            .continue_on_error = 1,
+        };
+        anidb_batch_result_t* result = NULL;
+        double t0 = now_seconds();
+        anidb_result_t status = anidb_process_batch(client, paths, count, &options, &result);
+        double elapsed = now_seconds() - t0;
+        anidb_client_destroy(client);
+        if (!check(status, "anidb_process_batch")) {
+            return;
+        }
+        anidb_free_batch_result(result);
+
+        double rate = (double)(count * batch_file_bytes) / elapsed / 1e9;
+        char name[64];
+        snprintf(name, sizeof(name), "batch.threads_%d", threads);
+        record(name, rate, "GB/s", 1, 0);
+        if (threads == 1) {
+            single = rate;
+        } else {
+            snprintf(name, sizeof(name), "batch.speedup_%d", threads);
+            record(name, rate / single, "x", 1, 0);
+        }
+    }
+}
+
+/* ==== Output ============================================================ */
+
+static int write_json(const char* output) {
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        perror(output);
+        return 0;
+    }
+
+    fprintf(out, "{\n  \"suite\": \"c_abi\",\n  \"library_version\": \"%s\",\n",
+            anidb_get_version());
+    fprintf(out, "  \"metrics\": {\n");
+    for (size_t i = 0; i < metric_count; i++) {
+        const metric_t* m = &metrics[i];
+        fprintf(out, "    \"%s\": {\"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\"",
+                m->name, m->value, m->unit, m->higher_is_better ? "higher" : "lower");
+        if (m->tolerance > 0) {
+            fprintf(out, ", \"tolerance\": %.2f", m->tolerance);
+        }
+        fprintf(out, "}%s\n", i + 1 < metric_count ? "," : "");
+    }
+    fprintf(out, "  }\n}\n");
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    const char* output = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            hash_bytes = 8u << 20;
+            file_bytes = 8u << 20;
+            batch_file_bytes = 2u << 20;
+            call_iterations = 100000;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--threads N] [--output FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (max_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max_threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    if (!check(anidb_init(ANIDB_ABI_VERSION), "anidb_init")) {
+        return 1;
+    }
+
+    char file[512];
+    char batch_paths[MAX_BATCH_FILES][512];
+    const char* batch[MAX_BATCH_FILES];
+    size_t created = 0;
+    int ok = create_file(file, sizeof(file), file_bytes, 0);
+    while (ok && created < batch_files) {
+        ok = create_file(batch_paths[created], sizeof(batch_paths[created]), batch_file_bytes,
+                         (unsigned)created + 1);
+        if (ok) {
+            batch[created] = batch_paths[created];
+            created++;
+        }
+    }
+
+    anidb_client_handle_t client = NULL;
+    if (ok && check(anidb_client_create(&client), "anidb_client_create")) {
+        bench_hash_buffer();
+        bench_call_overhead();
+        bench_delivery(client, file);
+        bench_batch_scaling(batch, created);
+        anidb_client_destroy(client);
+    }
+
+    unlink(file);
+    for (size_t i = 0; i < created; i++) {
+        unlink(batch_paths[i]);
+    }
+    anidb_cleanup();
+
+    return ok && write_json(output) ? 0 : 1;
+}
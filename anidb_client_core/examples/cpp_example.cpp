@@ -0,0 +1,95 @@
+/**
+ * AniDB Client Example in C++
+ *
+ * This example demonstrates the header-only wrapper in anidb.hpp:
+ * - RAII client and result handles (no anidb_free_* calls)
+ * - Results read in place through views
+ * - A batch whose paths share one buffer
+ * - Incremental hashing with a compile-time algorithm set
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "../include/anidb.hpp"
+
+static void print_result(anidb::FileResultView result) {
+    std::string_view path = result.path();
+    std::printf("%.*s (%llu bytes, %llu ms)\n", static_cast<int>(path.size()), path.data(),
+                static_cast<unsigned long long>(result.size()),
+                static_cast<unsigned long long>(result.processing_time_ms()));
+
+    if (result.has_error()) {
+        std::string_view error = result.error();
+        std::printf("  error: %.*s\n", static_cast<int>(error.size()), error.data());
+        return;
+    }
+
+    for (anidb::HashView hash : result.hashes()) {
+        std::string_view value = hash.value();
+        std::printf("  %-6s %.*s\n", anidb_hash_algorithm_name(hash.algorithm()),
+                    static_cast<int>(value.size()), value.data());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <file> [file...]\n", argv[0]);
+        return 1;
+    }
+
+    if (anidb_result_t result = anidb::init(); result != ANIDB_SUCCESS) {
+        std::fprintf(stderr, "Failed to initialize library: %s\n", anidb::error_string(result));
+        return 1;
+    }
+
+    auto client = anidb::Client::create();
+    if (!client) {
+        std::fprintf(stderr, "Failed to create client: %s\n", anidb::error_string(client.code()));
+        anidb_cleanup();
+        return 1;
+    }
+
+    // Single file; the result is freed when it goes out of scope
+    anidb::ProcessOptions options(anidb::algorithms<anidb::ED2K, anidb::CRC32, anidb::MD5>());
+    if (auto result = client->process_file(argv[1], options)) {
+        print_result(result->view());
+    } else {
+        std::fprintf(stderr, "Failed to process %s: %s\n", argv[1],
+                     anidb::error_string(result.code()));
+    }
+
+    // Every argument as one batch
+    anidb::PathList paths;
+    for (int i = 1; i < argc; i++) {
+        paths.add(argv[i]);
+    }
+    anidb::BatchOptions batch_options(anidb::algorithms<anidb::ED2K>());
+    batch_options.continue_on_error();
+    if (auto batch = client->process_batch(paths, batch_options)) {
+        std::printf("\nBatch: %zu of %zu files in %llu ms\n", batch->successful_files(),
+                    batch->total_files(), static_cast<unsigned long long>(batch->total_time_ms()));
+        for (anidb::FileResultView result : batch->results()) {
+            print_result(result);
+        }
+    }
+
+    // Incremental hashing; the algorithm set is checked at compile time and
+    // the output needs no allocation
+    if (auto hasher = anidb::Hasher<anidb::ED2K, anidb::SHA1>::create()) {
+        std::ifstream file(argv[1], std::ios::binary);
+        std::vector<char> chunk(1 << 20);
+        while (file) {
+            file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            hasher->update(anidb::ByteSpan(chunk.data(), static_cast<size_t>(file.gcount())));
+        }
+        if (auto hashes = hasher->finalize()) {
+            std::string_view sha1 = hashes->get<anidb::SHA1>();
+            std::printf("\nStreamed SHA1: %.*s\n", static_cast<int>(sha1.size()), sha1.data());
+        }
+    }
+
+    client->reset();
+    anidb_cleanup();
+    return 0;
+}
@@ -36,8 +36,14 @@ extern "C" {
 /** Full version string */
 #define ANIDB_VERSION_STRING "0.1.0-alpha"
 
-/** ABI version for compatibility checking */
-#define ANIDB_ABI_VERSION 1
+/**
+ * ABI version for compatibility checking
+ *
+ * Bumped whenever a struct passed to or returned by the library changes
+ * size, so callers built against an older header fail anidb_init instead
+ * of passing or reading structs of the wrong size.
+ */
+#define ANIDB_ABI_VERSION 2
 
 /* ========================================================================== */
 /*                              Type Definitions                               */
@@ -66,6 +72,14 @@ typedef struct anidb_operation_t* anidb_operation_handle_t;
  */
 typedef struct anidb_batch_t* anidb_batch_handle_t;
 
+/**
+ * @brief Opaque handle to an incremental hashing context
+ * 
+ * Created with anidb_hasher_create(), fed with anidb_hasher_update() and
+ * destroyed with anidb_hasher_destroy().
+ */
+typedef struct anidb_hasher_t* anidb_hasher_handle_t;
+
 /**
  * @brief Result codes for API operations
  */
@@ -159,6 +173,46 @@ typedef enum {
     ANIDB_STATUS_CANCELLED = 4
 } anidb_status_t;
 
+/**
+ * @brief How file data is read from disk
+ */
+typedef enum {
+    /** Let the library choose (currently buffered reads) */
+    ANIDB_IO_MODE_AUTO = 0,
+    
+    /** Page-cached reads with sequential readahead */
+    ANIDB_IO_MODE_BUFFERED = 1,
+    
+    /** Memory-map files read-only (Unix; falls back to buffered) */
+    ANIDB_IO_MODE_MMAP = 2,
+    
+    /** Bypass the page cache with aligned reads (Linux/macOS; falls back
+     *  to buffered reads that drop consumed pages from the cache) */
+    ANIDB_IO_MODE_DIRECT = 3,
+    
+    /** Read ahead through a shared io_uring into registered buffers
+     *  (Linux; falls back to buffered reads) */
+    ANIDB_IO_MODE_IO_URING = 4
+} anidb_io_mode_t;
+
+/**
+ * @brief Scheduling priority of file work
+ *
+ * Hashing slots and the UDP rate limiter serve higher priorities first,
+ * and background files pause at chunk boundaries while interactive work
+ * is running.
+ */
+typedef enum {
+    /** Regular work */
+    ANIDB_PRIORITY_NORMAL = 0,
+    
+    /** Bulk work such as library scans; yields to everything else */
+    ANIDB_PRIORITY_BACKGROUND = 1,
+    
+    /** Work a user is waiting on */
+    ANIDB_PRIORITY_INTERACTIVE = 2
+} anidb_priority_t;
+
 /* ========================================================================== */
 /*                            Callback Definitions                             */
 /* ========================================================================== */
@@ -253,6 +307,22 @@ typedef void (*anidb_completion_callback_t)(
     void* user_data
 );
 
+/**
+ * @brief Async operation completion callback function type
+ * 
+ * Invoked exactly once per operation, from a library worker thread unless
+ * registered after the operation finished.
+ * 
+ * @param operation Operation that finished
+ * @param result ANIDB_SUCCESS, ANIDB_ERROR_CANCELLED, or the failure code
+ * @param user_data User-provided data pointer
+ */
+typedef void (*anidb_operation_callback_t)(
+    anidb_operation_handle_t operation,
+    anidb_result_t result,
+    void* user_data
+);
+
 /**
  * @brief Event data union for different event types
  */
@@ -324,7 +394,8 @@ typedef void (*anidb_event_callback_t)(
  * @brief Client configuration structure
  */
 typedef struct {
-    /** Cache directory path (UTF-8 encoded) */
+    /** Hash cache directory path (UTF-8 encoded); setting it enables the
+     *  hash cache, saved in this directory */
     const char* cache_dir;
     
     /** Maximum concurrent file operations */
@@ -350,6 +421,32 @@ typedef struct {
     
     /** AniDB client version (optional) */
     const char* client_version;
+    
+    /** How file data is read from disk */
+    anidb_io_mode_t io_mode;
+    
+    /** Nonzero to tune chunk size, hashing queue depth and readers per
+     *  device from observed throughput, within max_memory_usage; chunk_size
+     *  and max_concurrent_files become starting points and upper bounds,
+     *  and files hashed with ED2K read whole ED2K chunks when they fit.
+     *  The values in use are reported by anidb_get_metrics() */
+    int auto_tune;
+    
+    /** AniDB UDP API server as "host:port", NULL for api.anidb.net:9000.
+     *  Meant for test servers such as the mock in anidb-test-utils */
+    const char* server;
+    
+    /** Packets per second sent to server, 0 for AniDB's flood limits.
+     *  Ignored unless server is set; AniDB bans clients exceeding them */
+    double request_rate;
+    
+    /** How long to wait for each AniDB response in milliseconds, 0 for
+     *  the default of 30 seconds */
+    uint32_t request_timeout_ms;
+    
+    /** Nonzero to keep a hash cache in memory for the client's lifetime
+     *  when cache_dir is NULL. Without either the client has no cache */
+    int enable_hash_cache;
 } anidb_config_t;
 
 /**
@@ -365,14 +462,27 @@ typedef struct {
     /** Enable progress reporting */
     int enable_progress;
     
-    /** Verify existing hashes in cache */
+    /** Hash the file even when its hashes are cached, refreshing the entry */
     int verify_existing;
     
+    /**
+     * Cache per-chunk ED2K digests and CRC32s and, when a cached file
+     * has changed, re-read only the chunks that look different. Change
+     * detection samples each chunk, so an edit that leaves the sampled
+     * bytes of a chunk intact is missed; set verify_existing for a full
+     * rehash. Chunks are only reused when ED2K and CRC32 are the only
+     * algorithms needed.
+     */
+    int partial_rehash;
+    
     /** Progress callback (optional) */
     anidb_progress_callback_t progress_callback;
     
     /** User data for callbacks */
     void* user_data;
+    
+    /** Scheduling priority of this file */
+    anidb_priority_t priority;
 } anidb_process_options_t;
 
 /**
@@ -387,10 +497,42 @@ typedef struct {
     
     /** Length of the hash string */
     size_t hash_length;
+    
+    /** Time this algorithm spent hashing in microseconds (0 if cached) */
+    uint64_t hash_time_us;
 } anidb_hash_result_t;
 
+/**
+ * @brief Time spent in each stage of processing one file
+ *
+ * All times are in microseconds. Stages that did not run are 0: a file
+ * answered from the hash cache only has a cache lookup, and a partial
+ * rehash counts its reads as hashing. Identification is not part of file
+ * processing; its network time is reported by anidb_get_metrics().
+ */
+typedef struct {
+    /** Opening the file for reading */
+    uint64_t open_us;
+    
+    /** Waiting for data from the disk */
+    uint64_t read_us;
+    
+    /** Waiting for a hashing slot or for hashing workers to take a chunk */
+    uint64_t pool_wait_us;
+    
+    /** Hashing, wall clock for all algorithms together */
+    uint64_t hash_us;
+    
+    /** Stat'ing the file and looking it up in the hash cache */
+    uint64_t cache_lookup_us;
+} anidb_stage_timings_t;
+
 /**
  * @brief File processing result
+ *
+ * A result returned by the library is a single allocation: the structure,
+ * its hash array and every string it points to. The pointers stay valid
+ * until the result (or the batch result holding it) is freed.
  */
 typedef struct {
     /** File path */
@@ -413,8 +555,29 @@ typedef struct {
     
     /** Error message (NULL if no error) */
     char* error_message;
+    
+    /** Where the processing time went (all 0 for failed files) */
+    anidb_stage_timings_t timings;
 } anidb_file_result_t;
 
+/**
+ * @brief Streaming batch result callback function type
+ *
+ * Invoked once per input path as soon as that file finishes, in completion
+ * order. Ownership of the result passes to the callee, which must release
+ * it with anidb_free_file_result().
+ *
+ * @param index Index of the file in the caller's path array, or its
+ *              discovery order for anidb_scan_and_process()
+ * @param result Result for the file (failed and cancelled files included)
+ * @param user_data User data from the batch options
+ */
+typedef void (*anidb_result_callback_t)(
+    size_t index,
+    anidb_file_result_t* result,
+    void* user_data
+);
+
 /**
  * @brief Anime identification information
  */
@@ -438,6 +601,28 @@ typedef struct {
     int source;
 } anidb_anime_info_t;
 
+/**
+ * @brief Batch identification callback function type
+ *
+ * Invoked once per input hash on the thread that called
+ * anidb_identify_batch(). Cache hits are reported first, then files in
+ * lookup order; duplicates of a file are reported together.
+ *
+ * @param index Index of the file in the caller's arrays
+ * @param result ANIDB_SUCCESS, ANIDB_ERROR_FILE_NOT_FOUND if AniDB does not
+ *               know the file, or the error that stopped the lookup
+ * @param info Identification on success, NULL otherwise. Borrowed: only
+ *             valid until the callback returns
+ * @param user_data User data passed to anidb_identify_batch()
+ * @return 0 to continue, nonzero to stop the batch
+ */
+typedef int (*anidb_identify_callback_t)(
+    size_t index,
+    anidb_result_t result,
+    const anidb_anime_info_t* info,
+    void* user_data
+);
+
 /**
  * @brief Batch processing options
  */
@@ -448,16 +633,18 @@ typedef struct {
     /** Number of algorithms in the array */
     size_t algorithm_count;
     
-    /** Maximum concurrent operations */
+    /** Maximum concurrent operations (0 = client's max_concurrent_files) */
     size_t max_concurrent;
     
-    /** Continue processing on error */
+    /** Continue processing on error (0 = cancel remaining files on first failure) */
     int continue_on_error;
     
-    /** Skip files already in cache */
+    /** Kept for compatibility and ignored: paths resolving to the same file
+     *  are always hashed once */
     int skip_existing;
     
-    /** Progress callback (optional) */
+    /** Progress callback (optional), called once per finished file with
+     *  (percentage, completed_files, total_files, user_data) */
     anidb_progress_callback_t progress_callback;
     
     /** Completion callback (optional) */
@@ -465,8 +652,55 @@ typedef struct {
     
     /** User data for callbacks */
     void* user_data;
+    
+    /** Scheduling priority of every file in the batch */
+    anidb_priority_t priority;
 } anidb_batch_options_t;
 
+/**
+ * @brief Directory scan options
+ *
+ * Patterns are glob patterns matched against full paths; excludes win over
+ * includes. Pass NULL instead of the struct for the defaults: default media
+ * extensions, recursive, no symlinks, unlimited depth.
+ */
+typedef struct {
+    /** Glob patterns to include (may be NULL when include_count is 0) */
+    const char* const* include_patterns;
+    
+    /** Number of include patterns */
+    size_t include_count;
+    
+    /** Glob patterns to exclude (may be NULL when exclude_count is 0) */
+    const char* const* exclude_patterns;
+    
+    /** Number of exclude patterns */
+    size_t exclude_count;
+    
+    /** Match the default media extensions when there are no include patterns */
+    int use_defaults;
+    
+    /** Descend into subdirectories */
+    int recursive;
+    
+    /** Follow symbolic links */
+    int follow_links;
+    
+    /** Maximum depth below the root when recursive (0 = unlimited) */
+    size_t max_depth;
+} anidb_scan_options_t;
+
+/**
+ * @brief A file of a batch that shares its size with another file
+ */
+typedef struct {
+    /** Size in bytes shared by the group */
+    uint64_t file_size;
+    
+    /** Index of the file's first path in the batch's file_paths */
+    size_t path_index;
+} anidb_size_collision_t;
+
 /**
  * @brief Batch processing result
  */
@@ -485,8 +719,328 @@ typedef struct {
     
     /** Total processing time in milliseconds */
     uint64_t total_time_ms;
+    
+    /** Distinct files of equal size, sorted by size so that consecutive
+     *  entries of the same size form one group (NULL if there are none) */
+    anidb_size_collision_t* size_collisions;
+    
+    /** Number of entries in size_collisions */
+    size_t size_collision_count;
 } anidb_batch_result_t;
 
+/**
+ * @brief Progress snapshot of an async operation
+ */
+typedef struct {
+    /** Bytes processed so far */
+    uint64_t bytes_processed;
+    
+    /** Total bytes to process (0 until the file size is known) */
+    uint64_t total_bytes;
+    
+    /** Number of updates published so far; unchanged means no new progress */
+    uint64_t updates;
+} anidb_progress_snapshot_t;
+
+/**
+ * @brief Progress of the files a batch reads from one storage device
+ */
+typedef struct {
+    /** Device identifier (st_dev on Unix, a volume hash elsewhere) */
+    uint64_t device_id;
+    
+    /** Number of files scheduled on this device */
+    size_t files_total;
+    
+    /** Number of those files that have finished */
+    size_t files_completed;
+    
+    /** Bytes read from this device by finished files */
+    uint64_t bytes_processed;
+    
+    /** Read throughput in MiB/s since the device's first file started */
+    double throughput_mbps;
+} anidb_device_stats_t;
+
+/**
+ * @brief How a file compares to the hash cache before it is read in full
+ */
+typedef enum {
+    /** Nothing cached matches; the file needs a full hash */
+    ANIDB_PREFILTER_UNKNOWN = 0,
+    
+    /** The file's path and metadata are cached, so its hashes are known */
+    ANIDB_PREFILTER_KNOWN_IDENTITY = 1,
+    
+    /** A cached file has the same quick fingerprint, so the contents were
+     *  most likely hashed before under another path */
+    ANIDB_PREFILTER_KNOWN_CONTENT = 2
+} anidb_prefilter_status_t;
+
+/**
+ * @brief Prefilter outcome for one file
+ */
+typedef struct {
+    anidb_prefilter_status_t status;
+    
+    /** File size in bytes (0 if the file could not be stat'ed) */
+    uint64_t file_size;
+    
+    /** Quick fingerprint of the contents (0 if none was computed) */
+    uint64_t fingerprint;
+    
+    /** Bytes read to compute the fingerprint */
+    uint64_t bytes_read;
+} anidb_prefilter_result_t;
+
+/**
+ * @brief MD4 kernels used for ED2K chunk hashing
+ */
+typedef enum {
+    /** One chunk at a time */
+    ANIDB_MD4_KERNEL_SCALAR = 0,
+    
+    /** Four chunks at once with SSE4.1 */
+    ANIDB_MD4_KERNEL_SSE41 = 1,
+    
+    /** Eight chunks at once with AVX2 */
+    ANIDB_MD4_KERNEL_AVX2 = 2,
+    
+    /** Sixteen chunks at once with AVX-512 */
+    ANIDB_MD4_KERNEL_AVX512 = 3,
+    
+    /** Four chunks at once with NEON */
+    ANIDB_MD4_KERNEL_NEON = 4
+} anidb_md4_kernel_t;
+
+/**
+ * @brief CRC32 kernels
+ */
+typedef enum {
+    /** Portable lookup tables */
+    ANIDB_CRC32_KERNEL_TABLE = 0,
+    
+    /** Carry-less multiplication folding (x86) */
+    ANIDB_CRC32_KERNEL_PCLMULQDQ = 1,
+    
+    /** ARMv8 CRC32 instructions */
+    ANIDB_CRC32_KERNEL_ARMV8 = 2
+} anidb_crc32_kernel_t;
+
+/**
+ * @brief CPU features detected at startup and the kernels selected from them
+ *
+ * Feature fields are 1 when present and 0 otherwise. Features of other
+ * architectures are always 0.
+ */
+typedef struct {
+    /** x86 SSE2 */
+    int sse2;
+    
+    /** x86 SSE4.1 */
+    int sse4_1;
+    
+    /** x86 AVX2 */
+    int avx2;
+    
+    /** x86 AVX-512 Foundation */
+    int avx512f;
+    
+    /** x86 carry-less multiplication */
+    int pclmulqdq;
+    
+    /** ARM NEON */
+    int neon;
+    
+    /** ARMv8 CRC32 instructions */
+    int crc32;
+    
+    /** Kernel used for ED2K chunk hashing */
+    anidb_md4_kernel_t md4_kernel;
+    
+    /** Number of ED2K chunks the MD4 kernel hashes at once */
+    uint32_t md4_lanes;
+    
+    /** Kernel used for CRC32 */
+    anidb_crc32_kernel_t crc32_kernel;
+} anidb_cpu_features_t;
+
+/**
+ * @brief Memory usage of the library
+ *
+ * Pooled buffers count as used until they are freed by anidb_memory_gc(),
+ * anidb_memory_shrink() or anidb_memory_evict_stale().
+ */
+typedef struct {
+    /** Bytes counted against the memory limit, pooled buffers included */
+    uint64_t total_memory_used;
+    
+    /** Bytes currently returned to the caller through the FFI */
+    uint64_t ffi_allocated;
+    
+    /** Highest ffi_allocated seen */
+    uint64_t ffi_peak;
+    
+    /** Bytes held idle in the buffer pools */
+    uint64_t pool_memory;
+    
+    /** Allocations served from a buffer pool */
+    uint64_t pool_hits;
+    
+    /** Allocations that found their buffer pool empty */
+    uint64_t pool_misses;
+    
+    /** Allocations returned to the caller and not yet freed */
+    uint64_t active_allocations;
+    
+    /** Memory limit in bytes */
+    uint64_t memory_limit;
+    
+    /** 0=Low, 1=Medium, 2=High, 3=Critical */
+    uint32_t memory_pressure;
+} anidb_memory_stats_t;
+
+/** Number of buffer pools reported by anidb_memory_get_pool_stats() */
+#define ANIDB_MEMORY_POOL_COUNT 4
+
+/**
+ * @brief Statistics of one buffer pool
+ */
+typedef struct {
+    /** Size of the buffers in this pool */
+    uint64_t buffer_size;
+    
+    /** Buffers held idle in the pool */
+    uint64_t pooled_buffers;
+    
+    /** Bytes held idle in the pool */
+    uint64_t pooled_bytes;
+    
+    /** Bytes of buffers of this size handed out and not yet released */
+    uint64_t bytes_in_use;
+    
+    /** Highest bytes in use and pooled at the same time */
+    uint64_t peak_bytes;
+    
+    /** Allocations served from the pool */
+    uint64_t hits;
+    
+    /** Allocations that had to allocate a new buffer */
+    uint64_t misses;
+    
+    /** hits / (hits + misses), 0 before the first allocation */
+    double hit_rate;
+} anidb_pool_stats_t;
+
+/** Number of buckets in an anidb_histogram_t */
+#define ANIDB_HISTOGRAM_BUCKETS 16
+
+/**
+ * @brief Latency histogram
+ *
+ * Bucket i counts samples of at most 4^i microseconds that did not fit
+ * bucket i - 1, so bounds run from 1 us to about 4.5 minutes; the last
+ * bucket counts everything longer. Counts are not cumulative.
+ */
+typedef struct {
+    /** Number of samples */
+    uint64_t count;
+    
+    /** Sum of all samples in microseconds */
+    uint64_t sum_us;
+    
+    /** Samples per bucket */
+    uint64_t buckets[ANIDB_HISTOGRAM_BUCKETS];
+} anidb_histogram_t;
+
+/**
+ * @brief Processing metrics of a client
+ *
+ * Counters only grow for the lifetime of the client. Stage histograms only
+ * count files the stage ran for.
+ */
+typedef struct {
+    /** Files processed successfully */
+    uint64_t files_processed;
+    
+    /** Files that failed */
+    uint64_t files_failed;
+    
+    /** Bytes read from disk */
+    uint64_t bytes_read;
+    
+    /** Cache lookups that answered every requested algorithm */
+    uint64_t cache_hits;
+    
+    /** Cache lookups that left something to hash */
+    uint64_t cache_misses;
+    
+    /** cache_hits / (cache_hits + cache_misses), 0 before the first lookup */
+    double cache_hit_ratio;
+    
+    /** Files being processed right now */
+    uint64_t files_in_flight;
+    
+    /** Files of running batches not started yet */
+    uint64_t files_queued;
+    
+    /** Events waiting for anidb_event_poll() */
+    uint64_t events_queued;
+    
+    /** Hashing slots in use, shared by every client of the process */
+    uint64_t hash_slots_busy;
+    
+    /** Hashing slots in total */
+    uint64_t hash_slots_total;
+    
+    /** AniDB requests waiting for the rate limiter */
+    uint64_t network_requests_waiting;
+    
+    /** Time AniDB requests spent waiting for the rate limiter, in total */
+    uint64_t rate_limit_wait_us;
+    
+    /** Whole files, from the start of processing to the result */
+    anidb_histogram_t file_latency;
+    
+    /** Opening files */
+    anidb_histogram_t open_latency;
+    
+    /** Waiting for the disk, per file */
+    anidb_histogram_t read_latency;
+    
+    /** Waiting for hashing slots or workers, per file */
+    anidb_histogram_t pool_wait;
+    
+    /** Hashing, per file */
+    anidb_histogram_t hash_latency;
+    
+    /** Hash cache lookups */
+    anidb_histogram_t cache_lookup_latency;
+    
+    /** AniDB lookups, rate limiting included */
+    anidb_histogram_t network_latency;
+    
+    /** Files read per I/O backend, counted after any fallback to buffered
+     *  reads; cache hits read nothing and are not counted */
+    uint64_t files_read_buffered;
+    uint64_t files_read_mmap;
+    uint64_t files_read_direct;
+    uint64_t files_read_io_uring;
+    
+    /** Bytes read per pipeline step by the file started last, hashing
+     *  worker queue depth and readers per device in use; picked by the
+     *  tuner when auto_tune is set (the highest reader limit when devices
+     *  differ), configured otherwise */
+    uint64_t chunk_size;
+    uint64_t hash_queue_depth;
+    uint64_t readers_per_device;
+    
+    /** AniDB packets sent again after a timeout or a busy server, and
+     *  responses that did not arrive within the request timeout */
+    uint64_t network_retries;
+    uint64_t network_timeouts;
+} anidb_metrics_t;
+
 /* ========================================================================== */
 /*                          Library Initialization                             */
 /* ========================================================================== */
@@ -524,6 +1078,17 @@ const char* anidb_get_version(void);
  */
 uint32_t anidb_get_abi_version(void);
 
+/**
+ * @brief Get the CPU features and hash kernels used by this process
+ * 
+ * Kernels are selected once, on first use, from the features of the CPU
+ * the process runs on.
+ * 
+ * @param features Output parameter for the features
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_get_cpu_features(anidb_cpu_features_t* features);
+
 /* ========================================================================== */
 /*                           Client Management                                 */
 /* ========================================================================== */
@@ -580,7 +1145,8 @@ anidb_result_t anidb_client_get_last_error(
 /**
  * @brief Process a single file synchronously
  * 
- * This function blocks until the file processing is complete.
+ * This function blocks until the file processing is complete. One handle
+ * may be shared by any number of threads; their calls run concurrently.
  * 
  * @param handle Client handle
  * @param file_path Path to the file (UTF-8 encoded)
@@ -598,7 +1164,10 @@ anidb_result_t anidb_process_file(
 /**
  * @brief Process a single file asynchronously
  * 
- * This function returns immediately with an operation handle.
+ * This function returns immediately with an operation handle. The file is
+ * processed on the client's internal runtime; no caller thread is blocked.
+ * Use anidb_operation_set_callback() or anidb_operation_wait() to learn
+ * when it finishes.
  * 
  * @param handle Client handle
  * @param file_path Path to the file (UTF-8 encoded)
@@ -613,6 +1182,38 @@ anidb_result_t anidb_process_file_async(
     anidb_operation_handle_t* operation
 );
 
+/**
+ * @brief Set the completion callback of an async operation
+ * 
+ * If the operation already finished, the callback is invoked immediately
+ * on the calling thread.
+ * 
+ * @param operation Operation handle
+ * @param callback Callback to invoke on completion
+ * @param user_data User data passed to the callback
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_operation_set_callback(
+    anidb_operation_handle_t operation,
+    anidb_operation_callback_t callback,
+    void* user_data
+);
+
+/**
+ * @brief Wait for an async operation to finish
+ * 
+ * @param operation Operation handle
+ * @param timeout_ms Maximum time to wait in milliseconds (0 = no limit)
+ * @param status Output parameter for the final status (may be NULL)
+ * @return ANIDB_SUCCESS once finished, ANIDB_ERROR_TIMEOUT on timeout,
+ *         error code otherwise
+ */
+anidb_result_t anidb_operation_wait(
+    anidb_operation_handle_t operation,
+    uint32_t timeout_ms,
+    anidb_status_t* status
+);
+
 /**
  * @brief Get the status of an async operation
  * 
@@ -625,12 +1226,30 @@ anidb_result_t anidb_operation_get_status(
     anidb_status_t* status
 );
 
+/**
+ * @brief Get the latest progress of an async operation
+ * 
+ * Progress is published by the hashing thread into a lock-free snapshot
+ * that newer updates overwrite. This call never blocks, allocates, or
+ * slows the operation down, so it is suitable for polling at a fixed
+ * frame rate. Counters are exact for any file size.
+ * 
+ * @param operation Operation handle
+ * @param progress Output parameter for the snapshot
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_operation_get_progress(
+    anidb_operation_handle_t operation,
+    anidb_progress_snapshot_t* progress
+);
+
 /**
  * @brief Get the result of a completed async operation
  * 
  * @param operation Operation handle
  * @param result Output parameter for the result (caller must free)
- * @return ANIDB_SUCCESS on success, error code otherwise
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_BUSY if still running,
+ *         the processing error if it failed, error code otherwise
  */
 anidb_result_t anidb_operation_get_result(
     anidb_operation_handle_t operation,
@@ -648,6 +1267,8 @@ anidb_result_t anidb_operation_cancel(anidb_operation_handle_t operation);
 /**
  * @brief Destroy an operation handle
  * 
+ * A running operation is cancelled; its completion callback still fires.
+ * 
  * @param operation Operation handle to destroy
  * @return ANIDB_SUCCESS on success, error code otherwise
  */
@@ -660,6 +1281,15 @@ anidb_result_t anidb_operation_destroy(anidb_operation_handle_t operation);
 /**
  * @brief Process multiple files in a batch
  * 
+ * Files are grouped by the storage device that holds them; each device is
+ * read by at most two files at a time while up to max_concurrent files are
+ * in flight across all devices. Results are returned in input order.
+ * 
+ * The call succeeds whenever the batch ran; inspect the per-file status to
+ * find failures. The completion callback receives the first error when
+ * continue_on_error is 0, ANIDB_ERROR_CANCELLED if cancelled, or
+ * ANIDB_SUCCESS.
+ * 
  * @param handle Client handle
  * @param file_paths Array of file paths (UTF-8 encoded)
  * @param file_count Number of files
@@ -678,6 +1308,10 @@ anidb_result_t anidb_process_batch(
 /**
  * @brief Process multiple files in a batch asynchronously
  * 
+ * The batch runs on the client's runtime. Poll it with
+ * anidb_batch_get_progress() and fetch the result with
+ * anidb_batch_get_result() once finished.
+ * 
  * @param handle Client handle
  * @param file_paths Array of file paths (UTF-8 encoded)
  * @param file_count Number of files
@@ -693,6 +1327,69 @@ anidb_result_t anidb_process_batch_async(
     anidb_batch_handle_t* batch
 );
 
+/**
+ * @brief Process multiple files in a batch, streaming per-file results
+ *
+ * Behaves like anidb_process_batch_async() but hands every result to
+ * result_callback as soon as its file finishes instead of retaining it,
+ * so memory use stays flat regardless of the number of files. Results,
+ * progress and completion callbacks are serialized; the completion
+ * callback runs after the last result has been delivered.
+ *
+ * anidb_batch_get_result() on a streaming batch reports the summary
+ * counters only; its results array is NULL.
+ *
+ * @param handle Client handle
+ * @param file_paths Array of file paths (UTF-8 encoded)
+ * @param file_count Number of files
+ * @param options Batch processing options
+ * @param result_callback Receives each file result (required)
+ * @param batch Output parameter for the batch handle
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_process_batch_stream(
+    anidb_client_handle_t handle,
+    const char** file_paths,
+    size_t file_count,
+    const anidb_batch_options_t* options,
+    anidb_result_callback_t result_callback,
+    anidb_batch_handle_t* batch
+);
+
+/**
+ * @brief Scan a directory and process every matching file, streaming results
+ *
+ * Discovery runs alongside the batch readers: each file is queued on its
+ * device as soon as the walk finds it, so hashing starts with the first
+ * match and the path list never has to be built by the caller. Cached
+ * files are answered from the cache as in any other batch. Results are
+ * delivered as with anidb_process_batch_stream(), indexed in discovery
+ * order; skip_existing has no effect since the walk yields each path once.
+ * Hardlinks of one file (same st_dev and st_ino) are hashed once, and
+ * every name receives its own copy of the result.
+ *
+ * The batch total reported by anidb_batch_get_progress() and the progress
+ * callback grows while the walk is running. Unreadable directories are
+ * skipped; a missing root or an invalid pattern fails the call itself.
+ *
+ * @param handle Client handle
+ * @param root Directory (or single file) to scan (UTF-8 encoded)
+ * @param scan_options Scan options, or NULL for the defaults
+ * @param options Batch processing options
+ * @param result_callback Receives each file result (required)
+ * @param batch Output parameter for the batch handle
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_FILE_NOT_FOUND if root does
+ *         not exist, ANIDB_ERROR_INVALID_PARAMETER for invalid patterns
+ */
+anidb_result_t anidb_scan_and_process(
+    anidb_client_handle_t handle,
+    const char* root,
+    const anidb_scan_options_t* scan_options,
+    const anidb_batch_options_t* options,
+    anidb_result_callback_t result_callback,
+    anidb_batch_handle_t* batch
+);
+
 /**
  * @brief Get the progress of a batch operation
  * 
@@ -707,9 +1404,71 @@ anidb_result_t anidb_batch_get_progress(
     size_t* total
 );
 
+/**
+ * @brief Get per-device progress of a batch
+ * 
+ * Files are read by a bounded number of sequential readers per storage
+ * device. This reports one entry per device, ordered by the device's first
+ * file in the input. Pass a NULL array with zero capacity to query the
+ * count; entries beyond `capacity` are not written. Devices are known once
+ * the batch has been planned, so a batch that just started may report none.
+ * 
+ * @param batch Batch handle
+ * @param stats Array receiving up to `capacity` entries (may be NULL if 0)
+ * @param capacity Number of entries `stats` can hold
+ * @param count Output parameter for the number of devices in the batch
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_batch_get_device_stats(
+    anidb_batch_handle_t batch,
+    anidb_device_stats_t* stats,
+    size_t capacity,
+    size_t* count
+);
+
+/**
+ * @brief Get the distinct files of a batch that share their size
+ * 
+ * Before reading anything a batch stats every path. Paths resolving to the
+ * same file (repeated paths, symlinks, hardlinks, bind mounts) are hashed
+ * once and the result is copied to each of them. Distinct files of equal
+ * size are reported here, sorted by size so that consecutive entries of
+ * the same size form one group; callers can use the groups to decide which
+ * files to compare. Query the count and fill the array as with
+ * anidb_batch_get_device_stats(). Directory scans report no collisions.
+ * 
+ * @param batch Batch handle
+ * @param collisions Array receiving up to `capacity` entries (may be NULL if 0)
+ * @param capacity Number of entries `collisions` can hold
+ * @param count Output parameter for the number of entries in the batch
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_batch_get_size_collisions(
+    anidb_batch_handle_t batch,
+    anidb_size_collision_t* collisions,
+    size_t capacity,
+    size_t* count
+);
+
+/**
+ * @brief Get the result of a finished batch operation
+ * 
+ * @param batch Batch handle
+ * @param result Output parameter for the result (caller must free)
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_BUSY if still running,
+ *         error code otherwise
+ */
+anidb_result_t anidb_batch_get_result(
+    anidb_batch_handle_t batch,
+    anidb_batch_result_t** result
+);
+
 /**
  * @brief Cancel a batch operation
  * 
+ * Pending files are not started and files in flight are aborted; both are
+ * reported with ANIDB_STATUS_CANCELLED.
+ * 
  * @param batch Batch handle
  * @return ANIDB_SUCCESS on success, error code otherwise
  */
@@ -718,6 +1477,8 @@ anidb_result_t anidb_batch_cancel(anidb_batch_handle_t batch);
 /**
  * @brief Destroy a batch handle
  * 
+ * A batch that is still running is cancelled.
+ * 
  * @param batch Batch handle to destroy
  * @return ANIDB_SUCCESS on success, error code otherwise
  */
@@ -731,7 +1492,8 @@ anidb_result_t anidb_batch_destroy(anidb_batch_handle_t batch);
  * @brief Calculate hash for a file
  * 
  * This is a convenience function for calculating a single hash without
- * full file processing.
+ * full file processing. The file is streamed on the calling thread, so
+ * callers with an event loop should invoke it from a worker thread.
  * 
  * @param file_path Path to the file (UTF-8 encoded)
  * @param algorithm Hash algorithm to use
@@ -749,7 +1511,7 @@ anidb_result_t anidb_calculate_hash(
 /**
  * @brief Calculate hash for memory buffer
  * 
- * @param data Data buffer
+ * @param data Data buffer (may be NULL when data_size is 0)
  * @param data_size Size of the data
  * @param algorithm Hash algorithm to use
  * @param hash_buffer Buffer to store the hash (must be large enough)
@@ -764,10 +1526,119 @@ anidb_result_t anidb_calculate_hash_buffer(
     size_t buffer_size
 );
 
+/**
+ * @brief Calculate several hashes of a memory buffer in one pass
+ * 
+ * The data is read in place and never copied; every algorithm consumes
+ * each slice before the next one is read. The buffer must stay valid and
+ * unmodified until the call returns. It is safe to call from any thread.
+ * 
+ * @param data Data buffer (may be NULL when data_size is 0)
+ * @param data_size Size of the data
+ * @param algorithms Array of hash algorithms to calculate
+ * @param algorithm_count Number of algorithms
+ * @param hash_buffers Output buffer per algorithm, in the same order
+ * @param buffer_sizes Size of each output buffer; each must be at least
+ *                     anidb_hash_buffer_size() for its algorithm
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_calculate_hashes_buffer(
+    const uint8_t* data,
+    size_t data_size,
+    const anidb_hash_algorithm_t* algorithms,
+    size_t algorithm_count,
+    char* const* hash_buffers,
+    const size_t* buffer_sizes
+);
+
+/**
+ * @brief Create an incremental hasher
+ * 
+ * Data can then be supplied in pieces of any size, for example as an
+ * upload arrives, without writing it to a temporary file first. All
+ * algorithms are computed in a single pass over the data.
+ * 
+ * @param algorithms Array of hash algorithms to calculate
+ * @param algorithm_count Number of algorithms
+ * @param hasher Output parameter for the hasher handle
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_hasher_create(
+    const anidb_hash_algorithm_t* algorithms,
+    size_t algorithm_count,
+    anidb_hasher_handle_t* hasher
+);
+
+/**
+ * @brief Feed the next piece of data to a hasher
+ * 
+ * Pieces must be supplied in order. The data is not retained after the
+ * call returns. Calls on the same hasher are serialized internally.
+ * 
+ * @param hasher Hasher handle
+ * @param data Data buffer (may be NULL when data_size is 0)
+ * @param data_size Size of the data
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_PROCESSING if the hasher
+ *         was already finalized, error code otherwise
+ */
+anidb_result_t anidb_hasher_update(
+    anidb_hasher_handle_t hasher,
+    const uint8_t* data,
+    size_t data_size
+);
+
+/**
+ * @brief Get the number of bytes fed to a hasher so far
+ * 
+ * @param hasher Hasher handle
+ * @param bytes_processed Output parameter for the byte count
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_hasher_get_bytes_processed(
+    anidb_hasher_handle_t hasher,
+    uint64_t* bytes_processed
+);
+
+/**
+ * @brief Finalize a hasher and write its hashes
+ * 
+ * Hashes are written in the order the algorithms were given to
+ * anidb_hasher_create(). Buffers are validated before the hasher is
+ * consumed; once finalized, the hasher accepts no more data.
+ * 
+ * @param hasher Hasher handle
+ * @param hash_buffers Output buffer per algorithm
+ * @param buffer_sizes Size of each output buffer; each must be at least
+ *                     anidb_hash_buffer_size() for its algorithm
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_PROCESSING if the hasher
+ *         was already finalized, error code otherwise
+ */
+anidb_result_t anidb_hasher_finalize(
+    anidb_hasher_handle_t hasher,
+    char* const* hash_buffers,
+    const size_t* buffer_sizes
+);
+
+/**
+ * @brief Destroy a hasher handle
+ * 
+ * @param hasher Hasher handle to destroy (finalized or not)
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_hasher_destroy(anidb_hasher_handle_t hasher);
+
 /* ========================================================================== */
 /*                           Cache Management                                  */
 /* ========================================================================== */
 
+/*
+ * Every client keeps a hash cache keyed on each file's device, inode, size
+ * and modification time. File processing stats a file first and returns
+ * cached hashes without reading it when its identity is unchanged. With a
+ * cache_dir in the client configuration the cache is saved there and shared
+ * by later clients; otherwise it lives as long as the client.
+ */
+
 /**
  * @brief Clear the hash cache
  * 
@@ -793,6 +1664,9 @@ anidb_result_t anidb_cache_get_stats(
 /**
  * @brief Check if a file hash is in cache
  * 
+ * Costs one stat() of the file; its contents are never read. A missing
+ * file is reported as not cached.
+ * 
  * @param handle Client handle
  * @param file_path Path to the file (UTF-8 encoded)
  * @param algorithm Hash algorithm
@@ -806,6 +1680,51 @@ anidb_result_t anidb_cache_check_file(
     int* is_cached
 );
 
+/**
+ * @brief Check many files against the cache in one call
+ * 
+ * Writes 1 or 0 to is_cached[i] for each path. All paths are validated
+ * before any file is stat'ed, so an invalid path fails the call without
+ * writing results.
+ * 
+ * @param handle Client handle
+ * @param file_paths Array of file paths (UTF-8 encoded)
+ * @param count Number of paths
+ * @param algorithm Hash algorithm
+ * @param is_cached Output array of count entries
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_cache_check_files(
+    anidb_client_handle_t handle,
+    const char* const* file_paths,
+    size_t count,
+    anidb_hash_algorithm_t algorithm,
+    int* is_cached
+);
+
+/**
+ * @brief Decide which files need a full hash
+ * 
+ * Files whose identity is cached cost one stat(). Every other file is
+ * fingerprinted from its size and a few sampled 64 KiB blocks, at most
+ * 512 KiB per file, and looked up by that fingerprint. A fingerprint is a
+ * heuristic: files reported as ANIDB_PREFILTER_KNOWN_CONTENT should still
+ * be hashed when an exact answer matters. Files that cannot be read are
+ * reported as unknown. All paths are validated before any file is read.
+ * 
+ * @param handle Client handle
+ * @param file_paths Array of file paths (UTF-8 encoded)
+ * @param count Number of paths
+ * @param results Output array of count entries
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_cache_prefilter_files(
+    anidb_client_handle_t handle,
+    const char* const* file_paths,
+    size_t count,
+    anidb_prefilter_result_t* results
+);
+
 /* ========================================================================== */
 /*                         Anime Identification                                */
 /* ========================================================================== */
@@ -813,11 +1732,20 @@ anidb_result_t anidb_cache_check_file(
 /**
  * @brief Identify an anime file by hash and size
  * 
+ * Files identified before are answered from the client's identification
+ * cache. Otherwise the client logs in to AniDB with the username and
+ * password from its configuration, on first use, and queries the file.
+ * Blocks until the answer arrives; requests are spaced out to respect the
+ * AniDB rate limits.
+ * 
  * @param handle Client handle
- * @param ed2k_hash ED2K hash of the file
+ * @param ed2k_hash ED2K hash of the file (32 hex characters)
  * @param file_size File size in bytes
- * @param info Output parameter for anime info (caller must free)
- * @return ANIDB_SUCCESS on success, error code otherwise
+ * @param info Output parameter for anime info (caller must free with
+ *             anidb_free_anime_info())
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_FILE_NOT_FOUND if AniDB
+ *         does not know the file, ANIDB_ERROR_INVALID_PARAMETER if no
+ *         credentials are configured, error code otherwise
  */
 anidb_result_t anidb_identify_file(
     anidb_client_handle_t handle,
@@ -826,6 +1754,71 @@ anidb_result_t anidb_identify_file(
     anidb_anime_info_t** info
 );
 
+/**
+ * @brief Identify many files by hash and size
+ * 
+ * Duplicate (hash, size) pairs are looked up once, cached files are
+ * answered immediately and the rest are queried one after another at the
+ * rate AniDB allows. Each result is passed to @p callback as soon as it is
+ * known. Blocks until every file is reported or the callback stops the
+ * batch.
+ * 
+ * @param handle Client handle
+ * @param ed2k_hashes Array of ED2K hashes (32 hex characters each)
+ * @param file_sizes Array of file sizes, parallel to @p ed2k_hashes
+ * @param count Number of files (may be 0)
+ * @param callback Called once per file
+ * @param user_data User data passed to the callback
+ * @return ANIDB_SUCCESS once the batch has run, even if some files failed;
+ *         ANIDB_ERROR_INVALID_PARAMETER if any hash is malformed, in which
+ *         case no file is looked up
+ */
+anidb_result_t anidb_identify_batch(
+    anidb_client_handle_t handle,
+    const char* const* ed2k_hashes,
+    const uint64_t* file_sizes,
+    size_t count,
+    anidb_identify_callback_t callback,
+    void* user_data
+);
+
+/**
+ * @brief Load an identification index exported by another client
+ * 
+ * The index is memory-mapped, so loading takes the same time for any
+ * index size. Afterwards, files in the index are identified without
+ * contacting AniDB. Replaces any index loaded before.
+ * 
+ * @param handle Client handle
+ * @param index_path Path of the index file
+ * @param entry_count Output for the number of files in the index (may be NULL)
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_FILE_NOT_FOUND if the file
+ *         does not exist, ANIDB_ERROR_CACHE if it is not a valid index
+ */
+anidb_result_t anidb_identify_index_load(
+    anidb_client_handle_t handle,
+    const char* index_path,
+    size_t* entry_count
+);
+
+/**
+ * @brief Export an identification index
+ * 
+ * Writes the entries of the loaded index, if any, and every file this
+ * client has identified. The file is replaced atomically, so clients that
+ * have the old index loaded are not affected.
+ * 
+ * @param handle Client handle
+ * @param index_path Path of the index file to write
+ * @param entry_count Output for the number of files written (may be NULL)
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_identify_index_export(
+    anidb_client_handle_t handle,
+    const char* index_path,
+    size_t* entry_count
+);
+
 /* ========================================================================== */
 /*                           Memory Management                                 */
 /* ========================================================================== */
@@ -840,6 +1833,10 @@ void anidb_free_string(char* str);
 /**
  * @brief Free a file result structure
  * 
+ * Releases the result, its hashes and its strings. Only results returned
+ * by the library may be passed. Do not free file results inside a batch
+ * result; free the batch result instead.
+ * 
  * @param result Result structure to free
  */
 void anidb_free_file_result(anidb_file_result_t* result);
@@ -847,6 +1844,9 @@ void anidb_free_file_result(anidb_file_result_t* result);
 /**
  * @brief Free a batch result structure
  * 
+ * Releases the batch result together with every file result in it, which
+ * share its allocation. Only results returned by the library may be passed.
+ * 
  * @param result Result structure to free
  */
 void anidb_free_batch_result(anidb_batch_result_t* result);
@@ -858,6 +1858,103 @@ void anidb_free_batch_result(anidb_batch_result_t* result);
  */
 void anidb_free_anime_info(anidb_anime_info_t* info);
 
+/**
+ * @brief Get current memory statistics
+ * 
+ * @param stats Output parameter for the statistics
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_get_memory_stats(anidb_memory_stats_t* stats);
+
+/**
+ * @brief Get a snapshot of a client's processing metrics
+ *
+ * Metrics are kept in atomics updated without locks, so this is cheap
+ * enough to call every second, for example from a Prometheus scrape.
+ * Values recorded while the snapshot is taken may be missing from some
+ * fields.
+ *
+ * @param handle Client handle
+ * @param metrics Output parameter for the metrics
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_get_metrics(anidb_client_handle_t handle, anidb_metrics_t* metrics);
+
+/**
+ * @brief Get statistics of every buffer pool
+ * 
+ * Pools are reported smallest buffers first; there are
+ * ANIDB_MEMORY_POOL_COUNT of them.
+ * 
+ * @param pools Array receiving the statistics (may be NULL if max_pools is 0)
+ * @param max_pools Size of the array
+ * @param pool_count Output parameter for the number of pools written
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_memory_get_pool_stats(
+    anidb_pool_stats_t* pools,
+    size_t max_pools,
+    size_t* pool_count
+);
+
+/**
+ * @brief Change the memory limit
+ * 
+ * Replaces the max_memory_usage of every client, clamped to 10MB - 2GB as
+ * in anidb_client_create_with_config(). Pooled buffers are freed until
+ * usage fits the new limit; allocations fail while buffers in use still
+ * exceed it.
+ * 
+ * @param max_memory_usage Memory limit in bytes (must not be 0)
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_memory_set_limit(uint64_t max_memory_usage);
+
+/**
+ * @brief Free pooled buffers until memory use is at most target_bytes
+ * 
+ * Largest buffers are freed first. Buffers in use are never touched, so
+ * usage may stay above the target.
+ * 
+ * @param target_bytes Memory use to shrink to
+ * @param freed_bytes Optional output parameter for the bytes freed
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_memory_shrink(uint64_t target_bytes, uint64_t* freed_bytes);
+
+/**
+ * @brief Free pooled buffers left unused for longer than max_idle_ms
+ * 
+ * @param max_idle_ms Idle time in milliseconds (0 frees every pooled buffer)
+ * @param freed_bytes Optional output parameter for the bytes freed
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_memory_evict_stale(uint64_t max_idle_ms, uint64_t* freed_bytes);
+
+/**
+ * @brief Free unused pooled buffers
+ * 
+ * Evicts buffers idle for more than a minute, then shrinks the pools
+ * toward half of the current memory use.
+ * 
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_memory_gc(void);
+
+/**
+ * @brief Check for memory returned to the caller and never freed
+ * 
+ * Only debug builds track allocations; release builds report 0.
+ * 
+ * @param leak_count Output parameter for the number of live allocations
+ * @param total_leaked_bytes Output parameter for their total size
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_check_memory_leaks(
+    uint64_t* leak_count,
+    uint64_t* total_leaked_bytes
+);
+
 /* ========================================================================== */
 /*                          Callback Management                                */
 /* ========================================================================== */
@@ -866,7 +1963,8 @@ void anidb_free_anime_info(anidb_anime_info_t* info);
  * @brief Register a callback with the client
  * 
  * Callbacks are executed on a dedicated thread to ensure thread safety.
- * Multiple callbacks of the same type can be registered.
+ * Multiple callbacks of the same type can be registered. Callbacks may
+ * register and unregister callbacks; changes apply from the next event.
  * 
  * @param handle Client handle
  * @param type Type of callback to register
@@ -922,7 +2020,10 @@ anidb_result_t anidb_event_disconnect(anidb_client_handle_t handle);
  * @brief Poll for events without callback
  * 
  * This function retrieves queued events for manual processing.
- * Events are removed from the queue after retrieval.
+ * Events are removed from the queue after retrieval. Their string
+ * pointers stay valid until the next call to anidb_event_poll. Events are
+ * queued once the queue is first polled or its mask set, and while an
+ * event callback is connected.
  * 
  * @param handle Client handle
  * @param events Array to store events
@@ -937,6 +2038,129 @@ anidb_result_t anidb_event_poll(
     size_t* event_count
 );
 
+/** Bit selecting one event type in an event type mask */
+#define ANIDB_EVENT_MASK(type) (1u << (type))
+
+/** Event type mask selecting every event */
+#define ANIDB_EVENT_MASK_ALL 0xFFFFFFFFu
+
+/**
+ * @brief Select the event types delivered to the queue of anidb_event_poll
+ * 
+ * Events of other types are not built for the queue at all. The default
+ * is ANIDB_EVENT_MASK_ALL; 0 turns the queue off, which callers that only
+ * use a ring or the callback should do so it does not fill up unread.
+ * Setting the mask starts queueing events even before the first poll.
+ * 
+ * @param handle Client handle
+ * @param type_mask ANIDB_EVENT_MASK() bits of the wanted types
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_event_set_mask(
+    anidb_client_handle_t handle,
+    uint32_t type_mask
+);
+
+/**
+ * @brief Select the event types delivered to the connected event callback
+ * 
+ * The default is ANIDB_EVENT_MASK_ALL; 0 turns the callback off. Events
+ * are built for the callback only while one is connected.
+ * 
+ * @param handle Client handle
+ * @param type_mask ANIDB_EVENT_MASK() bits of the wanted types
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_event_set_callback_mask(
+    anidb_client_handle_t handle,
+    uint32_t type_mask
+);
+
+/**
+ * @brief Get the memory size of an event ring
+ * 
+ * @param capacity Number of events the ring holds, a power of two of at
+ *                 least 2
+ * @return Bytes to pass to anidb_event_ring_attach, or 0 if the
+ *         capacity is not a power of two of at least 2
+ */
+size_t anidb_event_ring_size(size_t capacity);
+
+/**
+ * @brief Publish events into a ring in caller-owned memory
+ * 
+ * Lays a lock-free ring out in the given memory, which may be allocated
+ * or mapped by the caller and must stay valid until the ring is detached
+ * or the client is destroyed. The ring holds the largest power of two
+ * events that fit. Events and their strings are stored in the ring
+ * itself; paths longer than about 700 bytes are truncated.
+ * 
+ * Attaching replaces any previously attached ring. The queue and
+ * callback keep their own masks (see anidb_event_set_mask and
+ * anidb_event_set_callback_mask).
+ * 
+ * @param handle Client handle
+ * @param memory Ring memory, 8-byte aligned
+ * @param memory_size Size of the memory in bytes
+ * @param type_mask ANIDB_EVENT_MASK() bits of the types to publish
+ * @param capacity Output for the number of events the ring holds (may be NULL)
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_INVALID_PARAMETER if the
+ *         memory is misaligned or too small for two events
+ */
+anidb_result_t anidb_event_ring_attach(
+    anidb_client_handle_t handle,
+    void* memory,
+    size_t memory_size,
+    uint32_t type_mask,
+    size_t* capacity
+);
+
+/**
+ * @brief Stop publishing events into the attached ring
+ * 
+ * Returns once no library thread writes to the ring memory anymore.
+ * Events already in the ring can still be polled.
+ * 
+ * @param handle Client handle
+ * @return ANIDB_SUCCESS on success, error code otherwise
+ */
+anidb_result_t anidb_event_ring_detach(anidb_client_handle_t handle);
+
+/**
+ * @brief Take events from an event ring
+ * 
+ * Takes no lock and allocates nothing. String pointers in the returned
+ * events point into the ring and stay valid until the next call on the
+ * same ring, which hands their slots back to the library. Only one thread
+ * may poll a ring at a time.
+ * 
+ * @param ring Memory passed to anidb_event_ring_attach
+ * @param events Array to store events (may be NULL if max_events is 0)
+ * @param max_events Maximum number of events to retrieve
+ * @param event_count Output parameter for actual events retrieved
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_INVALID_PARAMETER if the
+ *         memory holds no ring
+ */
+anidb_result_t anidb_event_ring_poll(
+    void* ring,
+    anidb_event_t* events,
+    size_t max_events,
+    size_t* event_count
+);
+
+/**
+ * @brief Get the number of events dropped because a ring was full
+ * 
+ * @param ring Memory passed to anidb_event_ring_attach
+ * @param dropped Output for the number of dropped events
+ * @return ANIDB_SUCCESS on success, ANIDB_ERROR_INVALID_PARAMETER if the
+ *         memory holds no ring
+ */
+anidb_result_t anidb_event_ring_dropped(
+    const void* ring,
+    uint64_t* dropped
+);
+
 /* ========================================================================== */
 /*                           Utility Functions                                 */
 /* ========================================================================== */
@@ -0,0 +1,1188 @@
+/**
+ * @file anidb.hpp
+ * @brief C++ wrapper for the AniDB Client Core Library
+ *
+ * Header-only layer over anidb.h. Handles are move-only RAII owners with
+ * the size of the raw handle, results are views borrowing from the
+ * native result instead of copies, and algorithm sets given as template
+ * arguments (Hasher<ED2K, CRC32>) are checked and sized at compile time.
+ *
+ * Nothing here throws: fallible calls return anidb_result_t or a
+ * Result<T> holding either a value or the error code, so the header works
+ * with exceptions disabled. Only PathList and ClientRef::last_error()
+ * allocate.
+ *
+ * Requires C++17. With C++20, ByteSpan also accepts std::span.
+ *
+ * @copyright Copyright (c) 2024 AniDB Client Contributors
+ * @license MIT
+ */
+
+#ifndef ANIDB_CLIENT_HPP
+#define ANIDB_CLIENT_HPP
+
+#include "anidb.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#define ANIDB_HPP_HAS_SPAN 1
+#else
+#define ANIDB_HPP_HAS_SPAN 0
+#endif
+
+namespace anidb {
+
+/* ========================================================================== */
+/*                             Algorithms                                      */
+/* ========================================================================== */
+
+inline constexpr anidb_hash_algorithm_t ED2K = ANIDB_HASH_ED2K;
+inline constexpr anidb_hash_algorithm_t CRC32 = ANIDB_HASH_CRC32;
+inline constexpr anidb_hash_algorithm_t MD5 = ANIDB_HASH_MD5;
+inline constexpr anidb_hash_algorithm_t SHA1 = ANIDB_HASH_SHA1;
+inline constexpr anidb_hash_algorithm_t TTH = ANIDB_HASH_TTH;
+
+/** Number of supported hash algorithms */
+inline constexpr size_t kAlgorithmCount = 5;
+
+/** Largest output buffer any algorithm needs (SHA1) */
+inline constexpr size_t kMaxHashBufferSize = 41;
+
+/**
+ * @brief Output buffer size of an algorithm, terminator included
+ *
+ * Same values as anidb_hash_buffer_size(), but usable in constant
+ * expressions. 0 for an unknown algorithm.
+ */
+constexpr size_t hash_buffer_size(anidb_hash_algorithm_t algorithm) noexcept {
+    switch (algorithm) {
+        case ANIDB_HASH_ED2K: return 33;
+        case ANIDB_HASH_CRC32: return 9;
+        case ANIDB_HASH_MD5: return 33;
+        case ANIDB_HASH_SHA1: return 41;
+        case ANIDB_HASH_TTH: return 40;
+    }
+    return 0;
+}
+
+/** Whether a value names a supported algorithm */
+constexpr bool is_valid(anidb_hash_algorithm_t algorithm) noexcept {
+    return hash_buffer_size(algorithm) != 0;
+}
+
+/**
+ * @brief Set of distinct algorithms, stored inline
+ *
+ * Holds at most kAlgorithmCount entries in insertion order, which is the
+ * order the library reports hashes in. Filling one never allocates.
+ */
+class AlgorithmSet {
+public:
+    constexpr AlgorithmSet() noexcept = default;
+
+    constexpr AlgorithmSet(std::initializer_list<anidb_hash_algorithm_t> algorithms) noexcept {
+        for (anidb_hash_algorithm_t algorithm : algorithms) {
+            add(algorithm);
+        }
+    }
+
+    /** Add an algorithm; false if it is invalid or already present */
+    constexpr bool add(anidb_hash_algorithm_t algorithm) noexcept {
+        if (!is_valid(algorithm) || contains(algorithm)) {
+            return false;
+        }
+        items_[size_++] = algorithm;
+        return true;
+    }
+
+    constexpr bool contains(anidb_hash_algorithm_t algorithm) const noexcept {
+        for (size_t i = 0; i < size_; i++) {
+            if (items_[i] == algorithm) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    constexpr const anidb_hash_algorithm_t* data() const noexcept { return items_.data(); }
+    constexpr size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr anidb_hash_algorithm_t operator[](size_t index) const noexcept { return items_[index]; }
+    constexpr const anidb_hash_algorithm_t* begin() const noexcept { return items_.data(); }
+    constexpr const anidb_hash_algorithm_t* end() const noexcept { return items_.data() + size_; }
+
+private:
+    std::array<anidb_hash_algorithm_t, kAlgorithmCount> items_{};
+    size_t size_ = 0;
+};
+
+namespace detail {
+
+template <anidb_hash_algorithm_t... Algorithms>
+constexpr bool distinct() noexcept {
+    constexpr anidb_hash_algorithm_t list[] = {Algorithms...};
+    for (size_t i = 0; i < sizeof...(Algorithms); i++) {
+        for (size_t j = i + 1; j < sizeof...(Algorithms); j++) {
+            if (list[i] == list[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <anidb_hash_algorithm_t... Algorithms>
+constexpr void check_algorithms() noexcept {
+    static_assert(sizeof...(Algorithms) > 0, "at least one algorithm is required");
+    static_assert((is_valid(Algorithms) && ...), "unknown hash algorithm");
+    static_assert(distinct<Algorithms...>(), "algorithms must be distinct");
+}
+
+} // namespace detail
+
+/** Algorithm set built and checked at compile time */
+template <anidb_hash_algorithm_t... Algorithms>
+constexpr AlgorithmSet algorithms() noexcept {
+    detail::check_algorithms<Algorithms...>();
+    return AlgorithmSet{Algorithms...};
+}
+
+/* ========================================================================== */
+/*                          Vocabulary Types                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Value or error code of a fallible call
+ *
+ * Construct from a value on success or from an error code otherwise;
+ * value() is only meaningful when ok().
+ */
+template <typename T>
+class Result {
+public:
+    Result(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : value_(std::move(value)), code_(ANIDB_SUCCESS) {}
+
+    Result(anidb_result_t code) noexcept : value_(), code_(code) {}
+
+    bool ok() const noexcept { return code_ == ANIDB_SUCCESS; }
+    explicit operator bool() const noexcept { return ok(); }
+    anidb_result_t code() const noexcept { return code_; }
+
+    T& value() & noexcept { return value_; }
+    const T& value() const& noexcept { return value_; }
+    T&& value() && noexcept { return std::move(value_); }
+
+    T& operator*() & noexcept { return value_; }
+    const T& operator*() const& noexcept { return value_; }
+    T* operator->() noexcept { return &value_; }
+    const T* operator->() const noexcept { return &value_; }
+
+private:
+    T value_;
+    anidb_result_t code_;
+};
+
+/** Description of an error code */
+inline const char* error_string(anidb_result_t result) noexcept {
+    return anidb_error_string(result);
+}
+
+/**
+ * @brief Borrowed NUL-terminated string
+ *
+ * The C ABI takes NUL-terminated strings, which std::string_view does not
+ * guarantee. This view only binds to strings that are, so passing one on
+ * never copies.
+ */
+class zstring_view {
+public:
+    constexpr zstring_view(const char* str) noexcept
+        : data_(str), size_(std::char_traits<char>::length(str)) {}
+
+    zstring_view(const std::string& str) noexcept : data_(str.c_str()), size_(str.size()) {}
+
+    constexpr const char* c_str() const noexcept { return data_; }
+    constexpr size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr operator std::string_view() const noexcept { return {data_, size_}; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+/**
+ * @brief Borrowed read-only bytes
+ *
+ * Converts from pointer and length, contiguous byte containers and, with
+ * C++20, std::span<const std::byte>. The library reads the memory in
+ * place; it must stay valid for the duration of the call.
+ */
+class ByteSpan {
+public:
+    constexpr ByteSpan() noexcept = default;
+
+    ByteSpan(const void* data, size_t size) noexcept
+        : data_(static_cast<const uint8_t*>(data)), size_(size) {}
+
+    template <typename Container,
+              typename = std::enable_if_t<
+                  sizeof(*std::data(std::declval<const Container&>())) == 1 &&
+                  !std::is_same_v<std::decay_t<Container>, ByteSpan>>>
+    ByteSpan(const Container& container) noexcept
+        : ByteSpan(std::data(container), std::size(container)) {}
+
+#if ANIDB_HPP_HAS_SPAN
+    template <size_t Extent>
+    ByteSpan(std::span<const std::byte, Extent> bytes) noexcept
+        : ByteSpan(bytes.data(), bytes.size()) {}
+
+    std::span<const std::byte> span() const noexcept {
+        return {reinterpret_cast<const std::byte*>(data_), size_};
+    }
+#endif
+
+    constexpr const uint8_t* data() const noexcept { return data_; }
+    constexpr size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Paths for a batch, packed into one buffer
+ *
+ * A batch call needs an array of NUL-terminated strings. Instead of one
+ * std::string per path plus a pointer array, every path is appended to a
+ * single buffer and the pointer array is built once, when the batch is
+ * started.
+ */
+class PathList {
+public:
+    void reserve(size_t paths, size_t bytes) {
+        offsets_.reserve(paths);
+        storage_.reserve(bytes + paths);
+    }
+
+    /** Append a copy of a path */
+    void add(std::string_view path) {
+        std::memcpy(emplace(path.size()), path.data(), path.size());
+    }
+
+    /**
+     * @brief Append a path of `length` bytes and return where to write it
+     *
+     * The terminator is already in place. The pointer is valid until the
+     * next call that adds a path.
+     */
+    char* emplace(size_t length) {
+        size_t offset = storage_.size();
+        storage_.resize(offset + length + 1);
+        offsets_.push_back(offset);
+        pointers_.clear();
+        return storage_.data() + offset;
+    }
+
+    size_t size() const noexcept { return offsets_.size(); }
+    bool empty() const noexcept { return offsets_.empty(); }
+
+    std::string_view operator[](size_t index) const noexcept {
+        size_t end = index + 1 < offsets_.size() ? offsets_[index + 1] : storage_.size();
+        return {storage_.data() + offsets_[index], end - offsets_[index] - 1};
+    }
+
+    /** Array of the paths for the C ABI, valid until a path is added */
+    const char** data() const {
+        if (pointers_.size() != offsets_.size()) {
+            pointers_.clear();
+            pointers_.reserve(offsets_.size());
+            for (size_t offset : offsets_) {
+                pointers_.push_back(storage_.data() + offset);
+            }
+        }
+        return pointers_.data();
+    }
+
+private:
+    std::vector<char> storage_;
+    std::vector<size_t> offsets_;
+    mutable std::vector<const char*> pointers_;
+};
+
+/* ========================================================================== */
+/*                              Ownership                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Move-only owner of a library handle
+ *
+ * Destroys the handle with `Destroy` and is exactly as large as the
+ * handle itself.
+ */
+template <typename Handle, anidb_result_t (*Destroy)(Handle)>
+class UniqueHandle {
+public:
+    constexpr UniqueHandle() noexcept = default;
+    explicit constexpr UniqueHandle(Handle handle) noexcept : handle_(handle) {}
+
+    UniqueHandle(const UniqueHandle&) = delete;
+    UniqueHandle& operator=(const UniqueHandle&) = delete;
+
+    UniqueHandle(UniqueHandle&& other) noexcept : handle_(other.release()) {}
+
+    UniqueHandle& operator=(UniqueHandle&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    ~UniqueHandle() { reset(); }
+
+    Handle get() const noexcept { return handle_; }
+    explicit operator bool() const noexcept { return handle_ != nullptr; }
+
+    /** Give up ownership without destroying the handle */
+    Handle release() noexcept { return std::exchange(handle_, nullptr); }
+
+    /** Destroy the current handle and take ownership of another one */
+    void reset(Handle handle = nullptr) noexcept {
+        Handle old = std::exchange(handle_, handle);
+        if (old) {
+            Destroy(old);
+        }
+    }
+
+private:
+    Handle handle_ = nullptr;
+};
+
+/**
+ * @brief Move-only owner of a result allocated by the library
+ */
+template <typename T, void (*Free)(T*)>
+class UniqueResult {
+public:
+    constexpr UniqueResult() noexcept = default;
+    explicit constexpr UniqueResult(T* result) noexcept : result_(result) {}
+
+    UniqueResult(const UniqueResult&) = delete;
+    UniqueResult& operator=(const UniqueResult&) = delete;
+
+    UniqueResult(UniqueResult&& other) noexcept : result_(other.release()) {}
+
+    UniqueResult& operator=(UniqueResult&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    ~UniqueResult() { reset(); }
+
+    const T* get() const noexcept { return result_; }
+    explicit operator bool() const noexcept { return result_ != nullptr; }
+
+    T* release() noexcept { return std::exchange(result_, nullptr); }
+
+    void reset(T* result = nullptr) noexcept {
+        T* old = std::exchange(result_, result);
+        if (old) {
+            Free(old);
+        }
+    }
+
+private:
+    T* result_ = nullptr;
+};
+
+/* ========================================================================== */
+/*                               Results                                       */
+/* ========================================================================== */
+
+/** One hash of a file result */
+class HashView {
+public:
+    explicit constexpr HashView(const anidb_hash_result_t* hash) noexcept : hash_(hash) {}
+
+    anidb_hash_algorithm_t algorithm() const noexcept { return hash_->algorithm; }
+    std::string_view value() const noexcept { return {hash_->hash_value, hash_->hash_length}; }
+
+    /** Time this algorithm spent hashing in microseconds, 0 if cached */
+    uint64_t time_us() const noexcept { return hash_->hash_time_us; }
+
+private:
+    const anidb_hash_result_t* hash_;
+};
+
+/** Contiguous native structures iterated as views */
+template <typename Native, typename View>
+class ViewRange {
+public:
+    class iterator {
+    public:
+        explicit constexpr iterator(const Native* item) noexcept : item_(item) {}
+        View operator*() const noexcept { return View(item_); }
+        iterator& operator++() noexcept { ++item_; return *this; }
+        bool operator==(const iterator& other) const noexcept { return item_ == other.item_; }
+        bool operator!=(const iterator& other) const noexcept { return item_ != other.item_; }
+
+    private:
+        const Native* item_;
+    };
+
+    constexpr ViewRange(const Native* items, size_t size) noexcept
+        : items_(size ? items : nullptr), size_(items ? size : 0) {}
+
+    iterator begin() const noexcept { return iterator(items_); }
+    iterator end() const noexcept { return iterator(items_ + size_); }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    View operator[](size_t index) const noexcept { return View(items_ + index); }
+
+private:
+    const Native* items_;
+    size_t size_;
+};
+
+/**
+ * @brief File result borrowed from the library
+ *
+ * Every accessor reads the native result in place; strings are views into
+ * its single allocation and stay valid as long as the result does.
+ */
+class FileResultView {
+public:
+    constexpr FileResultView(const anidb_file_result_t* result) noexcept : result_(result) {}
+
+    std::string_view path() const noexcept { return result_->file_path; }
+    uint64_t size() const noexcept { return result_->file_size; }
+    anidb_status_t status() const noexcept { return result_->status; }
+    uint64_t processing_time_ms() const noexcept { return result_->processing_time_ms; }
+    const anidb_stage_timings_t& timings() const noexcept { return result_->timings; }
+
+    bool has_error() const noexcept { return result_->error_message != nullptr; }
+    std::string_view error() const noexcept {
+        return result_->error_message ? std::string_view(result_->error_message) : std::string_view();
+    }
+
+    ViewRange<anidb_hash_result_t, HashView> hashes() const noexcept {
+        return {result_->hashes, result_->hash_count};
+    }
+
+    /** Hash for an algorithm, empty if it was not computed */
+    std::string_view hash(anidb_hash_algorithm_t algorithm) const noexcept {
+        for (HashView hash : hashes()) {
+            if (hash.algorithm() == algorithm) {
+                return hash.value();
+            }
+        }
+        return {};
+    }
+
+    const anidb_file_result_t* get() const noexcept { return result_; }
+
+private:
+    const anidb_file_result_t* result_;
+};
+
+/** Owned file result */
+class FileResult : public UniqueResult<anidb_file_result_t, anidb_free_file_result> {
+public:
+    using UniqueResult::UniqueResult;
+    FileResultView view() const noexcept { return get(); }
+};
+
+/** Owned batch result */
+class BatchResult : public UniqueResult<anidb_batch_result_t, anidb_free_batch_result> {
+public:
+    using UniqueResult::UniqueResult;
+
+    size_t total_files() const noexcept { return get()->total_files; }
+    size_t successful_files() const noexcept { return get()->successful_files; }
+    size_t failed_files() const noexcept { return get()->failed_files; }
+    uint64_t total_time_ms() const noexcept { return get()->total_time_ms; }
+
+    /** File results in input order; empty for a streaming batch */
+    ViewRange<anidb_file_result_t, FileResultView> results() const noexcept {
+        return {get()->results, get()->results ? get()->total_files : 0};
+    }
+
+    /** Distinct files of equal size, grouped by consecutive equal sizes */
+    const anidb_size_collision_t* size_collisions() const noexcept { return get()->size_collisions; }
+    size_t size_collision_count() const noexcept { return get()->size_collision_count; }
+};
+
+/** Owned identification */
+using AnimeInfo = UniqueResult<anidb_anime_info_t, anidb_free_anime_info>;
+
+/**
+ * @brief Hashes of a compile-time algorithm set
+ *
+ * Each algorithm has an inline buffer of exactly the size it needs, so
+ * filling one allocates nothing and needs no size lookups.
+ */
+template <anidb_hash_algorithm_t... Algorithms>
+class Hashes {
+public:
+    static constexpr size_t count = sizeof...(Algorithms);
+    static constexpr std::array<anidb_hash_algorithm_t, count> algorithms{{Algorithms...}};
+    static constexpr std::array<size_t, count> sizes{{hash_buffer_size(Algorithms)...}};
+
+    /** Hash of the i-th algorithm */
+    std::string_view operator[](size_t index) const noexcept { return storage_ + offset(index); }
+
+    /** Hash of an algorithm of the set, checked at compile time */
+    template <anidb_hash_algorithm_t Algorithm>
+    std::string_view get() const noexcept {
+        constexpr size_t index = index_of(Algorithm);
+        static_assert(index < count, "algorithm is not part of this set");
+        return (*this)[index];
+    }
+
+    /** Output buffers and sizes in the layout the C ABI expects */
+    std::array<char*, count> buffers() noexcept {
+        std::array<char*, count> buffers{};
+        for (size_t i = 0; i < count; i++) {
+            buffers[i] = storage_ + offset(i);
+        }
+        return buffers;
+    }
+
+private:
+    static constexpr size_t offset(size_t index) noexcept {
+        size_t offset = 0;
+        for (size_t i = 0; i < index; i++) {
+            offset += sizes[i];
+        }
+        return offset;
+    }
+
+    static constexpr size_t index_of(anidb_hash_algorithm_t algorithm) noexcept {
+        for (size_t i = 0; i < count; i++) {
+            if (algorithms[i] == algorithm) {
+                return i;
+            }
+        }
+        return count;
+    }
+
+    char storage_[(hash_buffer_size(Algorithms) + ...)] = {};
+};
+
+/**
+ * @brief Hashes of an algorithm set chosen at run time
+ *
+ * Same layout idea as Hashes, with room for every algorithm.
+ */
+class HashValues {
+public:
+    HashValues() noexcept = default;
+    explicit HashValues(const AlgorithmSet& algorithms) noexcept : algorithms_(algorithms) {
+        for (size_t i = 0; i < algorithms_.size(); i++) {
+            sizes_[i] = hash_buffer_size(algorithms_[i]);
+            buffers_[i] = storage_[i];
+        }
+    }
+
+    HashValues(const HashValues& other) noexcept { *this = other; }
+
+    HashValues& operator=(const HashValues& other) noexcept {
+        algorithms_ = other.algorithms_;
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        sizes_ = other.sizes_;
+        for (size_t i = 0; i < algorithms_.size(); i++) {
+            buffers_[i] = storage_[i];
+        }
+        return *this;
+    }
+
+    const AlgorithmSet& algorithms() const noexcept { return algorithms_; }
+    size_t size() const noexcept { return algorithms_.size(); }
+
+    /** Hash of the i-th algorithm */
+    std::string_view operator[](size_t index) const noexcept { return storage_[index]; }
+
+    /** Hash of an algorithm, empty if it is not part of the set */
+    std::string_view get(anidb_hash_algorithm_t algorithm) const noexcept {
+        for (size_t i = 0; i < algorithms_.size(); i++) {
+            if (algorithms_[i] == algorithm) {
+                return storage_[i];
+            }
+        }
+        return {};
+    }
+
+    char* const* buffers() noexcept { return buffers_.data(); }
+    const size_t* sizes() const noexcept { return sizes_.data(); }
+
+private:
+    AlgorithmSet algorithms_;
+    char storage_[kAlgorithmCount][kMaxHashBufferSize] = {};
+    std::array<char*, kAlgorithmCount> buffers_{};
+    std::array<size_t, kAlgorithmCount> sizes_{};
+};
+
+/* ========================================================================== */
+/*                               Options                                       */
+/* ========================================================================== */
+
+/**
+ * @brief Options of a single file
+ *
+ * Keeps its algorithms inline, so it can be copied freely; native()
+ * returns options pointing at this object's own algorithm set.
+ */
+class ProcessOptions {
+public:
+    explicit ProcessOptions(AlgorithmSet algorithms = AlgorithmSet{ED2K}) noexcept
+        : algorithms_(algorithms) {}
+
+    ProcessOptions& enable_progress(bool enable = true) noexcept {
+        options_.enable_progress = enable ? 1 : 0;
+        return *this;
+    }
+
+    ProcessOptions& verify_existing(bool verify = true) noexcept {
+        options_.verify_existing = verify ? 1 : 0;
+        return *this;
+    }
+
+    ProcessOptions& partial_rehash(bool partial = true) noexcept {
+        options_.partial_rehash = partial ? 1 : 0;
+        return *this;
+    }
+
+    ProcessOptions& priority(anidb_priority_t priority) noexcept {
+        options_.priority = priority;
+        return *this;
+    }
+
+    ProcessOptions& progress_callback(anidb_progress_callback_t callback, void* user_data) noexcept {
+        options_.enable_progress = callback ? 1 : options_.enable_progress;
+        options_.progress_callback = callback;
+        options_.user_data = user_data;
+        return *this;
+    }
+
+    const AlgorithmSet& algorithms() const noexcept { return algorithms_; }
+
+    const anidb_process_options_t* native() const noexcept {
+        options_.algorithms = algorithms_.data();
+        options_.algorithm_count = algorithms_.size();
+        return &options_;
+    }
+
+private:
+    AlgorithmSet algorithms_;
+    mutable anidb_process_options_t options_{};
+};
+
+/** Options of a batch, see ProcessOptions */
+class BatchOptions {
+public:
+    explicit BatchOptions(AlgorithmSet algorithms = AlgorithmSet{ED2K}) noexcept
+        : algorithms_(algorithms) {}
+
+    /** Files in flight at once; 0 uses the client's max_concurrent_files */
+    BatchOptions& max_concurrent(size_t files) noexcept {
+        options_.max_concurrent = files;
+        return *this;
+    }
+
+    BatchOptions& continue_on_error(bool enable = true) noexcept {
+        options_.continue_on_error = enable ? 1 : 0;
+        return *this;
+    }
+
+    BatchOptions& skip_existing(bool enable = true) noexcept {
+        options_.skip_existing = enable ? 1 : 0;
+        return *this;
+    }
+
+    BatchOptions& priority(anidb_priority_t priority) noexcept {
+        options_.priority = priority;
+        return *this;
+    }
+
+    BatchOptions& progress_callback(anidb_progress_callback_t callback) noexcept {
+        options_.progress_callback = callback;
+        return *this;
+    }
+
+    BatchOptions& completion_callback(anidb_completion_callback_t callback) noexcept {
+        options_.completion_callback = callback;
+        return *this;
+    }
+
+    BatchOptions& user_data(void* user_data) noexcept {
+        options_.user_data = user_data;
+        return *this;
+    }
+
+    const AlgorithmSet& algorithms() const noexcept { return algorithms_; }
+
+    const anidb_batch_options_t* native() const noexcept {
+        options_.algorithms = algorithms_.data();
+        options_.algorithm_count = algorithms_.size();
+        return &options_;
+    }
+
+private:
+    AlgorithmSet algorithms_;
+    mutable anidb_batch_options_t options_{};
+};
+
+/** Directory scan options builder, see anidb_scan_and_process() */
+class ScanOptions {
+public:
+    ScanOptions() noexcept {
+        options_.use_defaults = 1;
+        options_.recursive = 1;
+    }
+
+    /** Glob pattern a file must match; replaces the default media extensions */
+    ScanOptions& include(std::string_view pattern) {
+        include_.add(pattern);
+        return *this;
+    }
+
+    /** Glob pattern that excludes a file even if it is included */
+    ScanOptions& exclude(std::string_view pattern) {
+        exclude_.add(pattern);
+        return *this;
+    }
+
+    ScanOptions& use_defaults(bool enable = true) noexcept {
+        options_.use_defaults = enable ? 1 : 0;
+        return *this;
+    }
+
+    ScanOptions& recursive(bool enable = true) noexcept {
+        options_.recursive = enable ? 1 : 0;
+        return *this;
+    }
+
+    ScanOptions& follow_links(bool enable = true) noexcept {
+        options_.follow_links = enable ? 1 : 0;
+        return *this;
+    }
+
+    /** Levels below the root to descend; 0 is unlimited */
+    ScanOptions& max_depth(size_t depth) noexcept {
+        options_.max_depth = depth;
+        return *this;
+    }
+
+    const anidb_scan_options_t* native() const {
+        options_.include_patterns = include_.data();
+        options_.include_count = include_.size();
+        options_.exclude_patterns = exclude_.data();
+        options_.exclude_count = exclude_.size();
+        return &options_;
+    }
+
+private:
+    PathList include_;
+    PathList exclude_;
+    mutable anidb_scan_options_t options_{};
+};
+
+/* ========================================================================== */
+/*                              Operations                                     */
+/* ========================================================================== */
+
+/** Async file operation, see anidb_process_file_async() */
+class Operation {
+public:
+    Operation() noexcept = default;
+    explicit Operation(anidb_operation_handle_t operation) noexcept : handle_(operation) {}
+
+    anidb_operation_handle_t get() const noexcept { return handle_.get(); }
+    anidb_operation_handle_t release() noexcept { return handle_.release(); }
+    explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+    anidb_result_t set_callback(anidb_operation_callback_t callback, void* user_data) const noexcept {
+        return anidb_operation_set_callback(get(), callback, user_data);
+    }
+
+    /** Wait up to `timeout_ms` (0 = no limit) for the operation to finish */
+    Result<anidb_status_t> wait(uint32_t timeout_ms = 0) const noexcept {
+        anidb_status_t status = ANIDB_STATUS_PENDING;
+        anidb_result_t result = anidb_operation_wait(get(), timeout_ms, &status);
+        return result == ANIDB_SUCCESS ? Result<anidb_status_t>(status) : Result<anidb_status_t>(result);
+    }
+
+    Result<anidb_status_t> status() const noexcept {
+        anidb_status_t status = ANIDB_STATUS_PENDING;
+        anidb_result_t result = anidb_operation_get_status(get(), &status);
+        return result == ANIDB_SUCCESS ? Result<anidb_status_t>(status) : Result<anidb_status_t>(result);
+    }
+
+    /** Latest progress; never blocks */
+    anidb_result_t progress(anidb_progress_snapshot_t* snapshot) const noexcept {
+        return anidb_operation_get_progress(get(), snapshot);
+    }
+
+    Result<FileResult> result() const noexcept {
+        anidb_file_result_t* result = nullptr;
+        anidb_result_t code = anidb_operation_get_result(get(), &result);
+        return code == ANIDB_SUCCESS ? Result<FileResult>(FileResult(result)) : Result<FileResult>(code);
+    }
+
+    anidb_result_t cancel() const noexcept { return anidb_operation_cancel(get()); }
+
+    /** Destroy the operation now, cancelling it if it still runs */
+    void reset() noexcept { handle_.reset(); }
+
+private:
+    UniqueHandle<anidb_operation_handle_t, anidb_operation_destroy> handle_;
+};
+
+/** Async batch, see anidb_process_batch_async() */
+class Batch {
+public:
+    Batch() noexcept = default;
+    explicit Batch(anidb_batch_handle_t batch) noexcept : handle_(batch) {}
+
+    anidb_batch_handle_t get() const noexcept { return handle_.get(); }
+    anidb_batch_handle_t release() noexcept { return handle_.release(); }
+    explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+    anidb_result_t progress(size_t* completed, size_t* total) const noexcept {
+        return anidb_batch_get_progress(get(), completed, total);
+    }
+
+    anidb_result_t device_stats(anidb_device_stats_t* stats, size_t capacity, size_t* count) const noexcept {
+        return anidb_batch_get_device_stats(get(), stats, capacity, count);
+    }
+
+    anidb_result_t size_collisions(anidb_size_collision_t* collisions, size_t capacity,
+                                   size_t* count) const noexcept {
+        return anidb_batch_get_size_collisions(get(), collisions, capacity, count);
+    }
+
+    Result<BatchResult> result() const noexcept {
+        anidb_batch_result_t* result = nullptr;
+        anidb_result_t code = anidb_batch_get_result(get(), &result);
+        return code == ANIDB_SUCCESS ? Result<BatchResult>(BatchResult(result)) : Result<BatchResult>(code);
+    }
+
+    anidb_result_t cancel() const noexcept { return anidb_batch_cancel(get()); }
+
+    /** Destroy the batch now, cancelling it if it still runs */
+    void reset() noexcept { handle_.reset(); }
+
+private:
+    UniqueHandle<anidb_batch_handle_t, anidb_batch_destroy> handle_;
+};
+
+/* ========================================================================== */
+/*                                Hashing                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Incremental hasher for a compile-time algorithm set
+ *
+ * Hasher<ED2K, CRC32> checks its algorithms when it is compiled and
+ * finalizes into Hashes<ED2K, CRC32> without allocating.
+ */
+template <anidb_hash_algorithm_t... Algorithms>
+class Hasher {
+public:
+    using Output = Hashes<Algorithms...>;
+
+    Hasher() noexcept = default;
+
+    static Result<Hasher> create() noexcept {
+        detail::check_algorithms<Algorithms...>();
+        anidb_hasher_handle_t hasher = nullptr;
+        anidb_result_t result = anidb_hasher_create(Output::algorithms.data(), Output::count, &hasher);
+        return result == ANIDB_SUCCESS ? Result<Hasher>(Hasher(hasher)) : Result<Hasher>(result);
+    }
+
+    anidb_hasher_handle_t get() const noexcept { return handle_.get(); }
+    explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+    anidb_result_t update(ByteSpan data) const noexcept {
+        return anidb_hasher_update(get(), data.data(), data.size());
+    }
+
+    Result<uint64_t> bytes_processed() const noexcept {
+        uint64_t bytes = 0;
+        anidb_result_t result = anidb_hasher_get_bytes_processed(get(), &bytes);
+        return result == ANIDB_SUCCESS ? Result<uint64_t>(bytes) : Result<uint64_t>(result);
+    }
+
+    Result<Output> finalize() const noexcept {
+        Output hashes;
+        auto buffers = hashes.buffers();
+        anidb_result_t result = anidb_hasher_finalize(get(), buffers.data(), Output::sizes.data());
+        return result == ANIDB_SUCCESS ? Result<Output>(hashes) : Result<Output>(result);
+    }
+
+    void reset() noexcept { handle_.reset(); }
+
+private:
+    explicit Hasher(anidb_hasher_handle_t hasher) noexcept : handle_(hasher) {}
+
+    UniqueHandle<anidb_hasher_handle_t, anidb_hasher_destroy> handle_;
+};
+
+/** Incremental hasher for an algorithm set chosen at run time */
+class DynamicHasher {
+public:
+    DynamicHasher() noexcept = default;
+
+    static Result<DynamicHasher> create(const AlgorithmSet& algorithms) noexcept {
+        anidb_hasher_handle_t hasher = nullptr;
+        anidb_result_t result = anidb_hasher_create(algorithms.data(), algorithms.size(), &hasher);
+        return result == ANIDB_SUCCESS ? Result<DynamicHasher>(DynamicHasher(hasher, algorithms))
+                                       : Result<DynamicHasher>(result);
+    }
+
+    anidb_hasher_handle_t get() const noexcept { return handle_.get(); }
+    explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+    const AlgorithmSet& algorithms() const noexcept { return algorithms_; }
+
+    anidb_result_t update(ByteSpan data) const noexcept {
+        return anidb_hasher_update(get(), data.data(), data.size());
+    }
+
+    Result<uint64_t> bytes_processed() const noexcept {
+        uint64_t bytes = 0;
+        anidb_result_t result = anidb_hasher_get_bytes_processed(get(), &bytes);
+        return result == ANIDB_SUCCESS ? Result<uint64_t>(bytes) : Result<uint64_t>(result);
+    }
+
+    Result<HashValues> finalize() const noexcept {
+        HashValues hashes(algorithms_);
+        anidb_result_t result = anidb_hasher_finalize(get(), hashes.buffers(), hashes.sizes());
+        return result == ANIDB_SUCCESS ? Result<HashValues>(hashes) : Result<HashValues>(result);
+    }
+
+    void reset() noexcept { handle_.reset(); }
+
+private:
+    DynamicHasher(anidb_hasher_handle_t hasher, const AlgorithmSet& algorithms) noexcept
+        : handle_(hasher), algorithms_(algorithms) {}
+
+    UniqueHandle<anidb_hasher_handle_t, anidb_hasher_destroy> handle_;
+    AlgorithmSet algorithms_;
+};
+
+/** Hash memory in place with a compile-time algorithm set */
+template <anidb_hash_algorithm_t... Algorithms>
+Result<Hashes<Algorithms...>> hash_buffer(ByteSpan data) noexcept {
+    using Output = Hashes<Algorithms...>;
+    detail::check_algorithms<Algorithms...>();
+    Output hashes;
+    auto buffers = hashes.buffers();
+    anidb_result_t result = anidb_calculate_hashes_buffer(data.data(), data.size(),
+        Output::algorithms.data(), Output::count, buffers.data(), Output::sizes.data());
+    return result == ANIDB_SUCCESS ? Result<Output>(hashes) : Result<Output>(result);
+}
+
+/** Hash memory in place with an algorithm set chosen at run time */
+inline Result<HashValues> hash_buffer(ByteSpan data, const AlgorithmSet& algorithms) noexcept {
+    HashValues hashes(algorithms);
+    anidb_result_t result = anidb_calculate_hashes_buffer(data.data(), data.size(),
+        algorithms.data(), algorithms.size(), hashes.buffers(), hashes.sizes());
+    return result == ANIDB_SUCCESS ? Result<HashValues>(hashes) : Result<HashValues>(result);
+}
+
+/** Hash a file on the calling thread, see anidb_calculate_hash() */
+inline Result<HashValues> hash_file(zstring_view path, anidb_hash_algorithm_t algorithm) noexcept {
+    HashValues hashes(AlgorithmSet{algorithm});
+    if (hashes.size() == 0) {
+        return ANIDB_ERROR_INVALID_PARAMETER;
+    }
+    anidb_result_t result = anidb_calculate_hash(path.c_str(), algorithm,
+        hashes.buffers()[0], hashes.sizes()[0]);
+    return result == ANIDB_SUCCESS ? Result<HashValues>(hashes) : Result<HashValues>(result);
+}
+
+/* ========================================================================== */
+/*                                Client                                       */
+/* ========================================================================== */
+
+/**
+ * @brief Non-owning view of a client handle
+ *
+ * What workers and callbacks hold while the owning Client lives
+ * elsewhere. Calls need no synchronization: one client may be used from
+ * any number of threads at once, as with the C handle.
+ */
+class ClientRef {
+public:
+    constexpr ClientRef(anidb_client_handle_t handle = nullptr) noexcept : handle_(handle) {}
+
+    anidb_client_handle_t get() const noexcept { return handle_; }
+    explicit operator bool() const noexcept { return handle_ != nullptr; }
+
+    Result<FileResult> process_file(zstring_view path, const ProcessOptions& options) const noexcept {
+        anidb_file_result_t* result = nullptr;
+        anidb_result_t code = anidb_process_file(get(), path.c_str(), options.native(), &result);
+        return code == ANIDB_SUCCESS ? Result<FileResult>(FileResult(result)) : Result<FileResult>(code);
+    }
+
+    Result<Operation> process_file_async(zstring_view path, const ProcessOptions& options) const noexcept {
+        anidb_operation_handle_t operation = nullptr;
+        anidb_result_t code = anidb_process_file_async(get(), path.c_str(), options.native(), &operation);
+        return code == ANIDB_SUCCESS ? Result<Operation>(Operation(operation)) : Result<Operation>(code);
+    }
+
+    Result<BatchResult> process_batch(const PathList& paths, const BatchOptions& options) const noexcept {
+        anidb_batch_result_t* result = nullptr;
+        anidb_result_t code = anidb_process_batch(get(), paths.data(), paths.size(), options.native(), &result);
+        return code == ANIDB_SUCCESS ? Result<BatchResult>(BatchResult(result)) : Result<BatchResult>(code);
+    }
+
+    Result<Batch> process_batch_async(const PathList& paths, const BatchOptions& options) const noexcept {
+        anidb_batch_handle_t batch = nullptr;
+        anidb_result_t code = anidb_process_batch_async(get(), paths.data(), paths.size(), options.native(), &batch);
+        return code == ANIDB_SUCCESS ? Result<Batch>(Batch(batch)) : Result<Batch>(code);
+    }
+
+    /** Batch handing each result to `on_result` as its file finishes */
+    Result<Batch> process_batch_stream(const PathList& paths, const BatchOptions& options,
+                                       anidb_result_callback_t on_result) const noexcept {
+        anidb_batch_handle_t batch = nullptr;
+        anidb_result_t code = anidb_process_batch_stream(get(), paths.data(), paths.size(),
+            options.native(), on_result, &batch);
+        return code == ANIDB_SUCCESS ? Result<Batch>(Batch(batch)) : Result<Batch>(code);
+    }
+
+    /** Walk `root` and stream a result for every matching file as it is hashed */
+    Result<Batch> scan_and_process(zstring_view root, const ScanOptions& scan, const BatchOptions& options,
+                                   anidb_result_callback_t on_result) const {
+        anidb_batch_handle_t batch = nullptr;
+        anidb_result_t code = anidb_scan_and_process(get(), root.c_str(), scan.native(), options.native(),
+            on_result, &batch);
+        return code == ANIDB_SUCCESS ? Result<Batch>(Batch(batch)) : Result<Batch>(code);
+    }
+
+    Result<AnimeInfo> identify_file(zstring_view ed2k_hash, uint64_t file_size) const noexcept {
+        anidb_anime_info_t* info = nullptr;
+        anidb_result_t code = anidb_identify_file(get(), ed2k_hash.c_str(), file_size, &info);
+        return code == ANIDB_SUCCESS ? Result<AnimeInfo>(AnimeInfo(info)) : Result<AnimeInfo>(code);
+    }
+
+    anidb_result_t cache_clear() const noexcept { return anidb_cache_clear(get()); }
+
+    Result<bool> cache_check_file(zstring_view path, anidb_hash_algorithm_t algorithm) const noexcept {
+        int cached = 0;
+        anidb_result_t code = anidb_cache_check_file(get(), path.c_str(), algorithm, &cached);
+        return code == ANIDB_SUCCESS ? Result<bool>(cached != 0) : Result<bool>(code);
+    }
+
+    /** Check every path with one call; `cached` needs room for paths.size() flags */
+    anidb_result_t cache_check_files(const PathList& paths, anidb_hash_algorithm_t algorithm,
+                                     int* cached) const noexcept {
+        return anidb_cache_check_files(get(), paths.data(), paths.size(), algorithm, cached);
+    }
+
+    /** Prefilter every path with one call; `results` needs room for paths.size() entries */
+    anidb_result_t cache_prefilter_files(const PathList& paths,
+                                         anidb_prefilter_result_t* results) const noexcept {
+        return anidb_cache_prefilter_files(get(), paths.data(), paths.size(), results);
+    }
+
+    Result<anidb_metrics_t> metrics() const noexcept {
+        anidb_metrics_t metrics{};
+        anidb_result_t code = anidb_get_metrics(get(), &metrics);
+        return code == ANIDB_SUCCESS ? Result<anidb_metrics_t>(metrics) : Result<anidb_metrics_t>(code);
+    }
+
+    /** Last error message of this client, empty if there is none */
+    std::string last_error() const {
+        char buffer[1024];
+        if (anidb_client_get_last_error(get(), buffer, sizeof(buffer)) != ANIDB_SUCCESS) {
+            return {};
+        }
+        return buffer;
+    }
+
+protected:
+    anidb_client_handle_t handle_;
+};
+
+/**
+ * @brief Client owning an anidb_client_handle_t
+ *
+ * Converts to ClientRef, which is what should be handed to code that
+ * does not own the client.
+ */
+class Client : public ClientRef {
+public:
+    Client() noexcept = default;
+
+    /** Take ownership of an existing handle */
+    explicit Client(anidb_client_handle_t handle) noexcept : ClientRef(handle) {}
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    Client(Client&& other) noexcept : ClientRef(other.release()) {}
+
+    Client& operator=(Client&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    ~Client() { reset(); }
+
+    static Result<Client> create() noexcept {
+        anidb_client_handle_t handle = nullptr;
+        anidb_result_t result = anidb_client_create(&handle);
+        return result == ANIDB_SUCCESS ? Result<Client>(Client(handle)) : Result<Client>(result);
+    }
+
+    static Result<Client> create(const anidb_config_t& config) noexcept {
+        anidb_client_handle_t handle = nullptr;
+        anidb_result_t result = anidb_client_create_with_config(&config, &handle);
+        return result == ANIDB_SUCCESS ? Result<Client>(Client(handle)) : Result<Client>(result);
+    }
+
+    /** Give up ownership without destroying the client */
+    anidb_client_handle_t release() noexcept { return std::exchange(handle_, nullptr); }
+
+    /** Destroy the current client and take ownership of another one */
+    void reset(anidb_client_handle_t handle = nullptr) noexcept {
+        anidb_client_handle_t old = std::exchange(handle_, handle);
+        if (old) {
+            anidb_client_destroy(old);
+        }
+    }
+};
+
+static_assert(sizeof(Client) == sizeof(anidb_client_handle_t), "Client must be as small as its handle");
+static_assert(sizeof(Operation) == sizeof(anidb_operation_handle_t), "Operation must be as small as its handle");
+static_assert(sizeof(Batch) == sizeof(anidb_batch_handle_t), "Batch must be as small as its handle");
+static_assert(sizeof(FileResult) == sizeof(anidb_file_result_t*), "FileResult must be as small as a pointer");
+
+/** Initialize the library for the ABI this header was built against */
+inline anidb_result_t init() noexcept { return anidb_init(ANIDB_ABI_VERSION); }
+
+/** Library version string */
+inline std::string_view version() noexcept { return anidb_get_version(); }
+
+} // namespace anidb
+
+#endif /* ANIDB_CLIENT_HPP */
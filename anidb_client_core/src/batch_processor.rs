@@ -12,6 +12,7 @@ use crate::{
     error::{InternalError, IoError},
     file_io::{FileProcessingResult, ProcessingStatus},
     memory::{MEMORY_WARNING_THRESHOLD, MemoryManager},
+    metrics::StageTimings,
     pipeline::{
         HashingStage, PipelineConfig, StreamingPipeline, StreamingPipelineBuilder, ValidationStage,
     },
@@ -188,6 +189,7 @@ impl PipelinePool {
                 chunk_size: preferred_chunk,
                 parallel_stages: false,
                 max_memory: self.config.max_memory_usage,
+                io_mode: self.config.io_mode,
             };
 
             // Create validation stage
@@ -223,6 +225,7 @@ impl PipelinePool {
                 chunk_size: preferred_chunk,
                 parallel_stages: false,
                 max_memory: self.config.max_memory_usage,
+                io_mode: self.config.io_mode,
             };
 
             // Create validation stage
@@ -655,6 +658,13 @@ impl BatchProcessor {
                     hashes,
                     status: ProcessingStatus::Completed,
                     processing_time: start_time.elapsed(),
+                    timings: StageTimings {
+                        open: stats.open_duration,
+                        read: stats.read_duration,
+                        pool_wait: stats.wait_duration,
+                        hash: stats.stage_duration,
+                        ..Default::default()
+                    },
                 })
             }
             Err(_e) => Ok(FileProcessingResult {
@@ -663,6 +673,7 @@ impl BatchProcessor {
                 hashes: std::collections::HashMap::new(),
                 status: ProcessingStatus::Failed,
                 processing_time: start_time.elapsed(),
+                timings: StageTimings::default(),
             }),
         }
     }
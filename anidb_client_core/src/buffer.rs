@@ -202,6 +202,7 @@ pub fn reset_memory_tracking() {
 /// This is called by anidb_init and anidb_cleanup to ensure clean state between tests
 pub(crate) fn reset_memory_state_for_tests() {
     GLOBAL_MEMORY_LIMIT.store(DEFAULT_MEMORY_LIMIT, Ordering::Relaxed);
+    crate::memory::set_memory_limit(crate::memory::DEFAULT_MEMORY_LIMIT);
     GLOBAL_MEMORY_USED.store(0, Ordering::Relaxed);
 }
 
@@ -0,0 +1,1005 @@
+//! Persistent hash cache keyed on file identity
+//!
+//! Rescanning a library whose files have not changed should cost one
+//! `stat()` per file rather than a full read. Entries are keyed on the
+//! device, inode, size and modification time of a file, so a moved or
+//! renamed file keeps its entry and any write invalidates it without the
+//! cache ever touching file contents.
+//!
+//! The cache is held in memory and, when opened on a directory, saved to a
+//! compact binary file there. Writes are batched and flushed in the
+//! background once enough accumulate, and when the cache is dropped.
+//!
+//! An entry may also carry the per-chunk ED2K digests and CRC32s of the
+//! file. When a file changes, its stale entry is found through the device
+//! and inode and those digests let the next hash re-read only the chunks
+//! that changed.
+//!
+//! Entries also keep a [`QuickFingerprint`] of the contents they were
+//! hashed from. [`HashCache::prefilter`] uses it to tell whether a file
+//! whose identity is not cached, such as a copy, holds contents that were
+//! seen before, reading a few sampled blocks instead of the whole file.
+
+use crate::hashing::{ChunkDigests, ED2K_CHUNK_SIZE, QuickFingerprint};
+use crate::platform::device_id;
+use crate::{HashAlgorithm, Result};
+use std::collections::HashMap;
+use std::fs::Metadata;
+use std::io::{BufReader, BufWriter, Read, Write};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, RwLock};
+#[cfg(not(unix))]
+use std::time::UNIX_EPOCH;
+
+/// Name of the cache file inside the cache directory
+pub const CACHE_FILE_NAME: &str = "hash_cache.bin";
+
+/// File format magic and version
+const MAGIC: &[u8; 4] = b"ADHC";
+const FORMAT_VERSION: u32 = 4;
+
+/// Number of unsaved changes after which the cache is flushed
+const FLUSH_THRESHOLD: usize = 1024;
+
+/// Identity of a file's contents as seen by `stat()`
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct FileIdentity {
+    pub device: u64,
+    pub inode: u64,
+    pub size: u64,
+    /// Modification time in nanoseconds since the Unix epoch
+    pub mtime_ns: i64,
+}
+
+impl FileIdentity {
+    /// Build the identity of `path` from its metadata
+    ///
+    /// Platforms without inode numbers use a hash of the absolute path,
+    /// which keeps entries valid but loses them when a file is renamed.
+    pub fn from_metadata(path: &Path, metadata: &Metadata) -> Self {
+        #[cfg(unix)]
+        let (inode, mtime_ns) = {
+            use std::os::unix::fs::MetadataExt;
+            let _ = path;
+            (
+                metadata.ino(),
+                metadata.mtime() * 1_000_000_000 + metadata.mtime_nsec(),
+            )
+        };
+
+        #[cfg(not(unix))]
+        let (inode, mtime_ns) = {
+            use std::collections::hash_map::DefaultHasher;
+            use std::hash::{Hash, Hasher};
+
+            let absolute = std::path::absolute(path).unwrap_or_else(|_| path.to_path_buf());
+            let mut hasher = DefaultHasher::new();
+            absolute.hash(&mut hasher);
+            let mtime_ns = metadata
+                .modified()
+                .ok()
+                .and_then(|t| t.duration_since(UNIX_EPOCH).ok())
+                .map_or(0, |d| d.as_nanos() as i64);
+            (hasher.finish(), mtime_ns)
+        };
+
+        Self {
+            device: device_id(metadata, path),
+            inode,
+            size: metadata.len(),
+            mtime_ns,
+        }
+    }
+
+    /// Stat `path` and build its identity
+    pub fn from_path(path: &Path) -> std::io::Result<Self> {
+        let metadata = std::fs::metadata(path)?;
+        Ok(Self::from_metadata(path, &metadata))
+    }
+}
+
+/// How file processing uses the cache
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CacheOptions {
+    /// Hash files even when their identity is cached, refreshing the entry
+    pub verify_existing: bool,
+    /// Keep per-chunk ED2K digests and CRC32s and, when a file has
+    /// changed, re-read only the chunks whose contents look different
+    pub partial_rehash: bool,
+}
+
+/// How a file compares to the cache before it is read in full
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PrefilterStatus {
+    /// Nothing cached matches; the file needs a full hash
+    Unknown,
+    /// The file's identity is cached, so its hashes are known
+    KnownIdentity,
+    /// A cached file has the same fingerprint, so the contents were most
+    /// likely hashed before under another identity
+    KnownContent,
+}
+
+/// Outcome of [`HashCache::prefilter`] for one file
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Prefilter {
+    pub status: PrefilterStatus,
+    /// Zero for a file that could not be stat'ed
+    pub file_size: u64,
+    /// Computed for files whose identity is not cached
+    pub fingerprint: Option<QuickFingerprint>,
+    /// Bytes read to compute the fingerprint
+    pub bytes_read: u64,
+}
+
+impl Prefilter {
+    fn unknown(file_size: u64) -> Self {
+        Self {
+            status: PrefilterStatus::Unknown,
+            file_size,
+            fingerprint: None,
+            bytes_read: 0,
+        }
+    }
+}
+
+/// Cache statistics
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CacheStats {
+    pub entries: usize,
+    /// Approximate size of the cached data in bytes
+    pub size_bytes: u64,
+    pub hits: u64,
+    pub misses: u64,
+}
+
+/// Cached data of one file version
+#[derive(Debug, Clone, Default)]
+struct Entry {
+    hashes: HashMap<HashAlgorithm, String>,
+    chunks: Option<Arc<ChunkDigests>>,
+    /// [`QuickFingerprint::hash`]; the size is the identity's
+    fingerprint: Option<u64>,
+}
+
+#[derive(Default)]
+struct CacheState {
+    entries: HashMap<FileIdentity, Entry>,
+    /// Current identity of each `(device, inode)`, so a changed file can
+    /// find and replace its stale entry
+    by_inode: HashMap<(u64, u64), FileIdentity>,
+    /// Latest identity recorded with each fingerprint
+    by_fingerprint: HashMap<QuickFingerprint, FileIdentity>,
+    /// Changes made since the last flush
+    dirty: usize,
+}
+
+impl CacheState {
+    fn with_entries(entries: HashMap<FileIdentity, Entry>) -> Self {
+        let by_inode = entries
+            .keys()
+            .map(|identity| ((identity.device, identity.inode), *identity))
+            .collect();
+        let by_fingerprint = entries
+            .iter()
+            .filter_map(|(identity, entry)| Some((fingerprint_of(identity, entry)?, *identity)))
+            .collect();
+        Self {
+            entries,
+            by_inode,
+            by_fingerprint,
+            dirty: 0,
+        }
+    }
+
+    /// Remove an entry and the index entries pointing at it
+    fn remove(&mut self, identity: &FileIdentity) {
+        let Some(entry) = self.entries.remove(identity) else {
+            return;
+        };
+        if let Some(fingerprint) = fingerprint_of(identity, &entry)
+            && self.by_fingerprint.get(&fingerprint) == Some(identity)
+        {
+            self.by_fingerprint.remove(&fingerprint);
+        }
+    }
+}
+
+fn fingerprint_of(identity: &FileIdentity, entry: &Entry) -> Option<QuickFingerprint> {
+    entry.fingerprint.map(|hash| QuickFingerprint {
+        size: identity.size,
+        hash,
+    })
+}
+
+/// Hash cache keyed on [`FileIdentity`]
+pub struct HashCache {
+    /// Backing file, or `None` for a cache that lives in memory only
+    path: Option<PathBuf>,
+    shared: Arc<Shared>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+}
+
+/// Cache state that background flushes write out
+#[derive(Default)]
+struct Shared {
+    state: RwLock<CacheState>,
+    /// Held while the backing file is written, so saves land in order
+    save_lock: Mutex<()>,
+    /// Set while a background flush is queued or running
+    flush_queued: AtomicBool,
+}
+
+impl Shared {
+    fn new(state: CacheState) -> Self {
+        Self {
+            state: RwLock::new(state),
+            ..Self::default()
+        }
+    }
+
+    /// Write unsaved changes to `path`, see [`HashCache::flush`]
+    fn save(&self, path: &Path) -> Result<()> {
+        let _save = self.save_lock.lock().unwrap_or_else(|e| e.into_inner());
+        let (entries, changes) = {
+            let mut state = self.state.write().unwrap_or_else(|e| e.into_inner());
+            if state.dirty == 0 {
+                return Ok(());
+            }
+            (state.entries.clone(), std::mem::take(&mut state.dirty))
+        };
+
+        let result = write_cache_file(path, &entries);
+        if result.is_err() {
+            // Keep the changes unsaved so the next flush tries again
+            let mut state = self.state.write().unwrap_or_else(|e| e.into_inner());
+            state.dirty += changes;
+        }
+        result
+    }
+}
+
+impl std::fmt::Debug for HashCache {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("HashCache")
+            .field("path", &self.path)
+            .field("stats", &self.stats())
+            .finish()
+    }
+}
+
+impl HashCache {
+    /// Create a cache that is never saved
+    pub fn in_memory() -> Self {
+        Self {
+            path: None,
+            shared: Arc::default(),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        }
+    }
+
+    /// Open the cache stored in `cache_dir`, creating the directory if needed
+    ///
+    /// A missing cache file starts an empty cache. A file that cannot be
+    /// parsed (truncated, or written by another format version) is
+    /// discarded, since every entry can be recomputed.
+    pub fn open(cache_dir: &Path) -> Result<Self> {
+        std::fs::create_dir_all(cache_dir)?;
+        let path = cache_dir.join(CACHE_FILE_NAME);
+
+        let entries = match std::fs::File::open(&path) {
+            Ok(file) => read_entries(BufReader::new(file)).unwrap_or_else(|e| {
+                log::warn!("Discarding unreadable hash cache {}: {e}", path.display());
+                HashMap::new()
+            }),
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => HashMap::new(),
+            Err(e) => return Err(e.into()),
+        };
+
+        Ok(Self {
+            path: Some(path),
+            shared: Arc::new(Shared::new(CacheState::with_entries(entries))),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        })
+    }
+
+    /// Backing file of a persistent cache
+    pub fn path(&self) -> Option<&Path> {
+        self.path.as_deref()
+    }
+
+    /// Cached hashes for a file identity
+    pub fn get(&self, identity: &FileIdentity) -> Option<HashMap<HashAlgorithm, String>> {
+        let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+        let hashes = state
+            .entries
+            .get(identity)
+            .map(|entry| entry.hashes.clone());
+        let counter = if hashes.is_some() {
+            &self.hits
+        } else {
+            &self.misses
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+        hashes
+    }
+
+    /// Whether `algorithm` is cached for a file identity
+    pub fn contains(&self, identity: &FileIdentity, algorithm: HashAlgorithm) -> bool {
+        let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+        state
+            .entries
+            .get(identity)
+            .is_some_and(|entry| entry.hashes.contains_key(&algorithm))
+    }
+
+    /// Chunk digests recorded for the file at `identity`'s device and inode
+    ///
+    /// The entry found may belong to an older version of the file, which is
+    /// what a partial rehash starts from.
+    pub fn previous_chunks(&self, identity: &FileIdentity) -> Option<Arc<ChunkDigests>> {
+        let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+        state
+            .by_inode
+            .get(&(identity.device, identity.inode))
+            .and_then(|current| state.entries.get(current))
+            .and_then(|entry| entry.chunks.clone())
+    }
+
+    /// Check many paths at once
+    ///
+    /// Each path costs one `stat()`; missing or unreadable files are
+    /// reported as not cached. The lock is taken once for the whole list.
+    pub fn check_files<P: AsRef<Path>>(&self, paths: &[P], algorithm: HashAlgorithm) -> Vec<bool> {
+        let identities: Vec<Option<FileIdentity>> = paths
+            .iter()
+            .map(|path| FileIdentity::from_path(path.as_ref()).ok())
+            .collect();
+
+        let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+        identities
+            .iter()
+            .map(|identity| {
+                identity
+                    .and_then(|id| state.entries.get(&id))
+                    .is_some_and(|entry| entry.hashes.contains_key(&algorithm))
+            })
+            .collect()
+    }
+
+    /// Record hashes for a file identity, merging with any already cached
+    ///
+    /// An entry left by an earlier version of the same file is replaced.
+    pub fn insert(&self, identity: FileIdentity, hashes: &HashMap<HashAlgorithm, String>) {
+        self.insert_with_chunks(identity, hashes, None);
+    }
+
+    /// Record hashes and, if given, the chunk digests they were built from
+    pub fn insert_with_chunks(
+        &self,
+        identity: FileIdentity,
+        hashes: &HashMap<HashAlgorithm, String>,
+        chunks: Option<ChunkDigests>,
+    ) {
+        if hashes.is_empty() {
+            return;
+        }
+
+        let should_flush = {
+            let mut state = self.shared.state.write().unwrap_or_else(|e| e.into_inner());
+            let inode = (identity.device, identity.inode);
+            if let Some(stale) = state.by_inode.insert(inode, identity)
+                && stale != identity
+            {
+                state.remove(&stale);
+            }
+
+            let entry = state.entries.entry(identity).or_default();
+            for (algorithm, hash) in hashes {
+                entry.hashes.insert(*algorithm, hash.clone());
+            }
+            if let Some(chunks) = chunks {
+                entry.chunks = Some(Arc::new(chunks));
+            }
+            state.dirty += 1;
+            state.dirty >= FLUSH_THRESHOLD
+        };
+
+        if should_flush {
+            self.flush_in_background();
+        }
+    }
+
+    /// Fingerprint recorded for a file identity
+    pub fn fingerprint(&self, identity: &FileIdentity) -> Option<QuickFingerprint> {
+        let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+        state
+            .entries
+            .get(identity)
+            .and_then(|entry| fingerprint_of(identity, entry))
+    }
+
+    /// Attach the fingerprint of its contents to a cached identity
+    ///
+    /// Ignored when nothing is cached for `identity` or the fingerprint was
+    /// taken from a file of another size.
+    pub fn record_fingerprint(&self, identity: FileIdentity, fingerprint: QuickFingerprint) {
+        if fingerprint.size != identity.size {
+            return;
+        }
+
+        let should_flush = {
+            let mut state = self.shared.state.write().unwrap_or_else(|e| e.into_inner());
+            let Some(entry) = state.entries.get_mut(&identity) else {
+                return;
+            };
+            if entry.fingerprint == Some(fingerprint.hash) {
+                return;
+            }
+            entry.fingerprint = Some(fingerprint.hash);
+            state.by_fingerprint.insert(fingerprint, identity);
+            state.dirty += 1;
+            state.dirty >= FLUSH_THRESHOLD
+        };
+
+        if should_flush {
+            self.flush_in_background();
+        }
+    }
+
+    /// Cached hashes of a file whose contents have `fingerprint`
+    pub fn find_by_fingerprint(
+        &self,
+        fingerprint: &QuickFingerprint,
+    ) -> Option<HashMap<HashAlgorithm, String>> {
+        let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+        state
+            .by_fingerprint
+            .get(fingerprint)
+            .and_then(|identity| state.entries.get(identity))
+            .map(|entry| entry.hashes.clone())
+    }
+
+    /// Decide whether a file needs a full hash
+    ///
+    /// A file whose identity is cached costs one `stat()`. Any other file is
+    /// fingerprinted, reading a few sampled blocks, and looked up by that
+    /// fingerprint. Files that cannot be read are reported as unknown so that
+    /// full processing reports their error.
+    pub fn prefilter(&self, path: &Path) -> Prefilter {
+        let Ok(identity) = FileIdentity::from_path(path) else {
+            return Prefilter::unknown(0);
+        };
+        let cached = {
+            let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+            state.entries.contains_key(&identity)
+        };
+        if cached {
+            return Prefilter {
+                status: PrefilterStatus::KnownIdentity,
+                ..Prefilter::unknown(identity.size)
+            };
+        }
+
+        let Ok((fingerprint, bytes_read)) = QuickFingerprint::from_path(path) else {
+            return Prefilter::unknown(identity.size);
+        };
+        let status = if self.find_by_fingerprint(&fingerprint).is_some() {
+            PrefilterStatus::KnownContent
+        } else {
+            PrefilterStatus::Unknown
+        };
+        Prefilter {
+            status,
+            file_size: identity.size,
+            fingerprint: Some(fingerprint),
+            bytes_read,
+        }
+    }
+
+    /// Remove every entry
+    pub fn clear(&self) -> Result<()> {
+        {
+            let mut state = self.shared.state.write().unwrap_or_else(|e| e.into_inner());
+            state.entries.clear();
+            state.by_inode.clear();
+            state.by_fingerprint.clear();
+            state.dirty += 1;
+        }
+        self.hits.store(0, Ordering::Relaxed);
+        self.misses.store(0, Ordering::Relaxed);
+        self.flush()
+    }
+
+    /// Current statistics
+    pub fn stats(&self) -> CacheStats {
+        let state = self.shared.state.read().unwrap_or_else(|e| e.into_inner());
+        let size_bytes = state
+            .entries
+            .values()
+            .map(|entry| {
+                let hashes: u64 = entry.hashes.values().map(|h| 2 + h.len() as u64).sum();
+                let chunks = entry.chunks.as_ref().map_or(0, |c| {
+                    CHUNK_RECORD_SIZE * c.digests.len() as u64 + 4 * c.crc32s.len() as u64
+                });
+                let fingerprint = entry.fingerprint.map_or(0, |_| 8);
+                ENTRY_HEADER_SIZE + hashes + chunks + fingerprint
+            })
+            .sum();
+
+        CacheStats {
+            entries: state.entries.len(),
+            size_bytes,
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+        }
+    }
+
+    /// Save unsaved changes to the backing file
+    ///
+    /// The entries are copied under the state lock and written without it,
+    /// so lookups and inserts carry on while the file is written. The copy
+    /// goes to a temporary file renamed over the old one, so a crash
+    /// mid-write never leaves a truncated cache behind.
+    pub fn flush(&self) -> Result<()> {
+        match &self.path {
+            Some(path) => self.shared.save(path),
+            None => Ok(()),
+        }
+    }
+
+    /// Flush off the calling thread, which is usually a runtime worker
+    ///
+    /// Runs on the blocking pool inside a runtime and on a new thread
+    /// otherwise. At most one background flush is queued at a time.
+    fn flush_in_background(&self) {
+        let Some(path) = self.path.clone() else {
+            return;
+        };
+        if self.shared.flush_queued.swap(true, Ordering::AcqRel) {
+            return;
+        }
+
+        let shared = self.shared.clone();
+        let job = move || {
+            shared.flush_queued.store(false, Ordering::Release);
+            if let Err(e) = shared.save(&path) {
+                log::warn!("Failed to save hash cache: {e}");
+            }
+        };
+        match tokio::runtime::Handle::try_current() {
+            Ok(runtime) => drop(runtime.spawn_blocking(job)),
+            Err(_) => drop(std::thread::spawn(job)),
+        }
+    }
+}
+
+impl Drop for HashCache {
+    fn drop(&mut self) {
+        if let Err(e) = self.flush() {
+            log::warn!("Failed to save hash cache: {e}");
+        }
+    }
+}
+
+/// Serialized size of an entry without its hashes, chunks and fingerprint
+const ENTRY_HEADER_SIZE: u64 = 8 * 4 + 1 + 4 + 1;
+
+/// Serialized size of one chunk digest and its sample
+const CHUNK_RECORD_SIZE: u64 = 16 + 4;
+
+/// Chunk count written for an entry without chunk digests
+const NO_CHUNKS: u32 = u32::MAX;
+
+/// Stable on-disk tag for an algorithm, matching the FFI identifiers
+fn algorithm_tag(algorithm: HashAlgorithm) -> u8 {
+    match algorithm {
+        HashAlgorithm::ED2K => 1,
+        HashAlgorithm::CRC32 => 2,
+        HashAlgorithm::MD5 => 3,
+        HashAlgorithm::SHA1 => 4,
+        HashAlgorithm::TTH => 5,
+    }
+}
+
+fn algorithm_from_tag(tag: u8) -> Option<HashAlgorithm> {
+    match tag {
+        1 => Some(HashAlgorithm::ED2K),
+        2 => Some(HashAlgorithm::CRC32),
+        3 => Some(HashAlgorithm::MD5),
+        4 => Some(HashAlgorithm::SHA1),
+        5 => Some(HashAlgorithm::TTH),
+        _ => None,
+    }
+}
+
+/// Replace the cache file at `path` with `entries`
+fn write_cache_file(path: &Path, entries: &HashMap<FileIdentity, Entry>) -> Result<()> {
+    let tmp_path = path.with_extension("tmp");
+    let mut writer = BufWriter::new(std::fs::File::create(&tmp_path)?);
+    write_entries(&mut writer, entries)?;
+    writer
+        .into_inner()
+        .map_err(|e| e.into_error())?
+        .sync_all()?;
+    std::fs::rename(&tmp_path, path)?;
+    Ok(())
+}
+
+/// Write the cache file
+///
+/// Layout, little-endian: magic, version, entry count, then per entry the
+/// four identity fields, a hash count and `(tag, len, bytes)` per hash,
+/// followed by a chunk count ([`NO_CHUNKS`] for none) and, with chunks, a
+/// CRC32 flag and `(digest, sample)` per chunk, plus the chunk's CRC32 if
+/// the flag is set, then a fingerprint flag and, if set, the fingerprint
+/// hash.
+fn write_entries<W: Write>(
+    writer: &mut W,
+    entries: &HashMap<FileIdentity, Entry>,
+) -> std::io::Result<()> {
+    writer.write_all(MAGIC)?;
+    writer.write_all(&FORMAT_VERSION.to_le_bytes())?;
+    writer.write_all(&(entries.len() as u64).to_le_bytes())?;
+
+    for (identity, entry) in entries {
+        writer.write_all(&identity.device.to_le_bytes())?;
+        writer.write_all(&identity.inode.to_le_bytes())?;
+        writer.write_all(&identity.size.to_le_bytes())?;
+        writer.write_all(&identity.mtime_ns.to_le_bytes())?;
+        writer.write_all(&[entry.hashes.len() as u8])?;
+        for (algorithm, hash) in &entry.hashes {
+            writer.write_all(&[algorithm_tag(*algorithm), hash.len() as u8])?;
+            writer.write_all(hash.as_bytes())?;
+        }
+
+        match &entry.chunks {
+            Some(chunks) => {
+                writer.write_all(&(chunks.digests.len() as u32).to_le_bytes())?;
+                let has_crc32s = chunks.has_crc32s();
+                writer.write_all(&[u8::from(has_crc32s)])?;
+                for (index, (digest, sample)) in
+                    chunks.digests.iter().zip(&chunks.samples).enumerate()
+                {
+                    writer.write_all(digest)?;
+                    writer.write_all(&sample.to_le_bytes())?;
+                    if has_crc32s {
+                        writer.write_all(&chunks.crc32s[index].to_le_bytes())?;
+                    }
+                }
+            }
+            None => writer.write_all(&NO_CHUNKS.to_le_bytes())?,
+        }
+
+        match entry.fingerprint {
+            Some(hash) => {
+                writer.write_all(&[1])?;
+                writer.write_all(&hash.to_le_bytes())?;
+            }
+            None => writer.write_all(&[0])?,
+        }
+    }
+
+    Ok(())
+}
+
+/// Read a cache file written by [`write_entries`]
+///
+/// Files of versions 1 (no chunk digests), 2 (no fingerprints) and 3 (no
+/// chunk CRC32s) are still accepted.
+fn read_entries<R: Read>(mut reader: R) -> std::io::Result<HashMap<FileIdentity, Entry>> {
+    fn invalid(message: &str) -> std::io::Error {
+        std::io::Error::new(std::io::ErrorKind::InvalidData, message)
+    }
+
+    fn read_u64<R: Read>(reader: &mut R) -> std::io::Result<u64> {
+        let mut bytes = [0u8; 8];
+        reader.read_exact(&mut bytes)?;
+        Ok(u64::from_le_bytes(bytes))
+    }
+
+    fn read_u32<R: Read>(reader: &mut R) -> std::io::Result<u32> {
+        let mut bytes = [0u8; 4];
+        reader.read_exact(&mut bytes)?;
+        Ok(u32::from_le_bytes(bytes))
+    }
+
+    fn read_u8<R: Read>(reader: &mut R) -> std::io::Result<u8> {
+        let mut byte = [0u8; 1];
+        reader.read_exact(&mut byte)?;
+        Ok(byte[0])
+    }
+
+    let mut header = [0u8; 8];
+    reader.read_exact(&mut header)?;
+    if &header[..4] != MAGIC {
+        return Err(invalid("not a hash cache file"));
+    }
+    let version = u32::from_le_bytes([header[4], header[5], header[6], header[7]]);
+    if !(1..=FORMAT_VERSION).contains(&version) {
+        return Err(invalid("unsupported hash cache version"));
+    }
+
+    let count = read_u64(&mut reader)?;
+    // The count comes from disk; let the map grow instead of trusting it
+    let mut entries = HashMap::with_capacity(count.min(1 << 20) as usize);
+    for _ in 0..count {
+        let identity = FileIdentity {
+            device: read_u64(&mut reader)?,
+            inode: read_u64(&mut reader)?,
+            size: read_u64(&mut reader)?,
+            mtime_ns: read_u64(&mut reader)? as i64,
+        };
+
+        let hash_count = read_u8(&mut reader)?;
+        let mut hashes = HashMap::with_capacity(hash_count as usize);
+        for _ in 0..hash_count {
+            let tag = read_u8(&mut reader)?;
+            let len = read_u8(&mut reader)?;
+            let mut hash = vec![0u8; len as usize];
+            reader.read_exact(&mut hash)?;
+
+            let algorithm = algorithm_from_tag(tag).ok_or_else(|| invalid("unknown algorithm"))?;
+            let hash = String::from_utf8(hash).map_err(|_| invalid("hash is not UTF-8"))?;
+            hashes.insert(algorithm, hash);
+        }
+
+        let chunk_count = if version == 1 {
+            NO_CHUNKS
+        } else {
+            read_u32(&mut reader)?
+        };
+        let chunks = if chunk_count == NO_CHUNKS {
+            None
+        } else {
+            if u64::from(chunk_count) != identity.size.div_ceil(ED2K_CHUNK_SIZE) {
+                return Err(invalid("chunk count does not match file size"));
+            }
+            let has_crc32s = version >= 4 && read_u8(&mut reader)? != 0;
+            let mut chunks = ChunkDigests {
+                file_size: identity.size,
+                digests: Vec::with_capacity(chunk_count as usize),
+                samples: Vec::with_capacity(chunk_count as usize),
+                crc32s: Vec::new(),
+            };
+            for _ in 0..chunk_count {
+                let mut digest = [0u8; 16];
+                reader.read_exact(&mut digest)?;
+                chunks.digests.push(digest);
+                chunks.samples.push(read_u32(&mut reader)?);
+                if has_crc32s {
+                    chunks.crc32s.push(read_u32(&mut reader)?);
+                }
+            }
+            Some(Arc::new(chunks))
+        };
+
+        let fingerprint = if version >= 3 && read_u8(&mut reader)? != 0 {
+            Some(read_u64(&mut reader)?)
+        } else {
+            None
+        };
+
+        entries.insert(
+            identity,
+            Entry {
+                hashes,
+                chunks,
+                fingerprint,
+            },
+        );
+    }
+
+    Ok(entries)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn write_file(dir: &Path, name: &str, contents: &[u8]) -> PathBuf {
+        let path = dir.join(name);
+        std::fs::write(&path, contents).unwrap();
+        path
+    }
+
+    fn hashes(ed2k: &str) -> HashMap<HashAlgorithm, String> {
+        HashMap::from([(HashAlgorithm::ED2K, ed2k.to_string())])
+    }
+
+    #[test]
+    fn test_insert_and_check() {
+        let temp_dir = TempDir::new().unwrap();
+        let cached = write_file(temp_dir.path(), "a.mkv", b"aaaa");
+        let uncached = write_file(temp_dir.path(), "b.mkv", b"bbbb");
+        let missing = temp_dir.path().join("missing.mkv");
+
+        let cache = HashCache::in_memory();
+        let identity = FileIdentity::from_path(&cached).unwrap();
+        cache.insert(identity, &hashes("abc"));
+
+        assert!(cache.contains(&identity, HashAlgorithm::ED2K));
+        assert!(!cache.contains(&identity, HashAlgorithm::CRC32));
+        assert_eq!(
+            cache.check_files(&[&cached, &uncached, &missing], HashAlgorithm::ED2K),
+            vec![true, false, false]
+        );
+        assert_eq!(cache.get(&identity).unwrap()[&HashAlgorithm::ED2K], "abc");
+        assert_eq!(cache.stats().entries, 1);
+        assert_eq!(cache.stats().hits, 1);
+
+        // Rewriting the file changes its identity
+        std::fs::write(&cached, b"aaaaa").unwrap();
+        assert_eq!(
+            cache.check_files(&[&cached], HashAlgorithm::ED2K),
+            vec![false]
+        );
+    }
+
+    #[test]
+    fn test_persistence() {
+        let temp_dir = TempDir::new().unwrap();
+        let file = write_file(temp_dir.path(), "a.mkv", b"aaaa");
+        let identity = FileIdentity::from_path(&file).unwrap();
+        let cache_dir = temp_dir.path().join("cache");
+
+        {
+            let cache = HashCache::open(&cache_dir).unwrap();
+            let mut both = hashes("abc");
+            both.insert(HashAlgorithm::CRC32, "12345678".to_string());
+            cache.insert(identity, &both);
+        }
+
+        let cache = HashCache::open(&cache_dir).unwrap();
+        let cached = cache.get(&identity).unwrap();
+        assert_eq!(cached[&HashAlgorithm::ED2K], "abc");
+        assert_eq!(cached[&HashAlgorithm::CRC32], "12345678");
+
+        cache.clear().unwrap();
+        drop(cache);
+        assert_eq!(HashCache::open(&cache_dir).unwrap().stats().entries, 0);
+
+        // A corrupt file is discarded rather than failing the open
+        std::fs::write(cache_dir.join(CACHE_FILE_NAME), b"ADHC\x01\0\0\0\xff").unwrap();
+        assert_eq!(HashCache::open(&cache_dir).unwrap().stats().entries, 0);
+    }
+
+    #[test]
+    fn test_failed_flush_keeps_changes() {
+        let temp_dir = TempDir::new().unwrap();
+        let file = write_file(temp_dir.path(), "a.mkv", b"aaaa");
+        let identity = FileIdentity::from_path(&file).unwrap();
+        let cache_dir = temp_dir.path().join("cache");
+
+        let cache = HashCache::open(&cache_dir).unwrap();
+        cache.insert(identity, &hashes("abc"));
+        std::fs::remove_dir(&cache_dir).unwrap();
+        assert!(cache.flush().is_err());
+
+        // The entry is still unsaved, so the next flush writes it
+        std::fs::create_dir(&cache_dir).unwrap();
+        cache.flush().unwrap();
+        let reopened = HashCache::open(&cache_dir).unwrap();
+        assert!(reopened.contains(&identity, HashAlgorithm::ED2K));
+    }
+
+    #[tokio::test]
+    async fn test_threshold_flushes_in_background() {
+        let temp_dir = TempDir::new().unwrap();
+        let cache_dir = temp_dir.path().join("cache");
+        let cache = HashCache::open(&cache_dir).unwrap();
+        let identity = |inode| FileIdentity {
+            device: 1,
+            inode,
+            size: 4,
+            mtime_ns: 0,
+        };
+
+        for inode in 1..FLUSH_THRESHOLD as u64 {
+            cache.insert(identity(inode), &hashes("abc"));
+        }
+        let saved = cache_dir.join(CACHE_FILE_NAME);
+        assert!(!saved.exists());
+
+        // Fingerprints count towards the threshold too
+        let fingerprint = QuickFingerprint { size: 4, hash: 9 };
+        cache.record_fingerprint(identity(1), fingerprint);
+        for _ in 0..500 {
+            if saved.exists() {
+                break;
+            }
+            tokio::time::sleep(std::time::Duration::from_millis(10)).await;
+        }
+        let reopened = HashCache::open(&cache_dir).unwrap();
+        assert_eq!(reopened.stats().entries, FLUSH_THRESHOLD - 1);
+        assert!(reopened.find_by_fingerprint(&fingerprint).is_some());
+    }
+
+    #[test]
+    fn test_changed_file_replaces_entry_and_keeps_chunks() {
+        let temp_dir = TempDir::new().unwrap();
+        let file = write_file(temp_dir.path(), "a.mkv", b"aaaa");
+        let old = FileIdentity::from_path(&file).unwrap();
+        let cache_dir = temp_dir.path().join("cache");
+        let chunks = ChunkDigests {
+            file_size: old.size,
+            digests: vec![[7; 16]],
+            samples: vec![42],
+            crc32s: vec![0x1234_5678],
+        };
+
+        let cache = HashCache::open(&cache_dir).unwrap();
+        cache.insert_with_chunks(old, &hashes("abc"), Some(chunks.clone()));
+
+        // The changed file finds the digests of its previous version
+        std::fs::write(&file, b"aaaaa").unwrap();
+        let new = FileIdentity::from_path(&file).unwrap();
+        assert_eq!(cache.previous_chunks(&new).as_deref(), Some(&chunks));
+
+        cache.insert(new, &hashes("def"));
+        assert_eq!(cache.stats().entries, 1);
+        assert!(!cache.contains(&old, HashAlgorithm::ED2K));
+        assert!(cache.previous_chunks(&new).is_none());
+
+        // Chunk digests survive a reload
+        let chunks = ChunkDigests {
+            file_size: new.size,
+            ..chunks
+        };
+        cache.insert_with_chunks(new, &hashes("def"), Some(chunks.clone()));
+        drop(cache);
+        let cache = HashCache::open(&cache_dir).unwrap();
+        assert_eq!(cache.previous_chunks(&new).as_deref(), Some(&chunks));
+    }
+
+    #[test]
+    fn test_prefilter_finds_copies_by_fingerprint() {
+        let temp_dir = TempDir::new().unwrap();
+        let contents: Vec<u8> = (0..2_000_000u32).map(|i| (i % 251) as u8).collect();
+        let original = write_file(temp_dir.path(), "a.mkv", &contents);
+        let copy = write_file(temp_dir.path(), "copy.mkv", &contents);
+        let other = write_file(temp_dir.path(), "other.mkv", &contents[1..]);
+        let cache_dir = temp_dir.path().join("cache");
+
+        let identity = FileIdentity::from_path(&original).unwrap();
+        {
+            let cache = HashCache::open(&cache_dir).unwrap();
+            cache.insert(identity, &hashes("abc"));
+            let (fingerprint, _) = QuickFingerprint::from_path(&original).unwrap();
+            cache.record_fingerprint(identity, fingerprint);
+        }
+
+        // The fingerprint index survives a reload
+        let cache = HashCache::open(&cache_dir).unwrap();
+        let known = cache.prefilter(&original);
+        assert_eq!(known.status, PrefilterStatus::KnownIdentity);
+        assert_eq!(known.bytes_read, 0);
+
+        let copied = cache.prefilter(&copy);
+        assert_eq!(copied.status, PrefilterStatus::KnownContent);
+        assert!(copied.bytes_read < contents.len() as u64 / 2);
+        assert_eq!(
+            cache
+                .find_by_fingerprint(&copied.fingerprint.unwrap())
+                .unwrap()[&HashAlgorithm::ED2K],
+            "abc"
+        );
+
+        assert_eq!(cache.prefilter(&other).status, PrefilterStatus::Unknown);
+        let missing = cache.prefilter(&temp_dir.path().join("missing.mkv"));
+        assert_eq!(missing, Prefilter::unknown(0));
+        // Prefiltering is not a lookup for the hit ratio
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses), (0, 0));
+
+        // Rewriting the original drops its fingerprint with its entry
+        std::fs::write(&original, b"changed").unwrap();
+        cache.insert(FileIdentity::from_path(&original).unwrap(), &hashes("def"));
+        assert_eq!(cache.prefilter(&copy).status, PrefilterStatus::Unknown);
+    }
+}
@@ -0,0 +1,566 @@
+//! Asynchronous file operations for FFI
+//!
+//! `anidb_process_file_async` runs the file on the client's own tokio
+//! runtime and returns an operation handle immediately. Completion is
+//! signalled through an optional per-operation callback, invoked from a
+//! runtime thread, or by blocking on `anidb_operation_wait`. Neither path
+//! requires the caller to dedicate a thread to the operation.
+
+use crate::ffi::events::EventSink;
+use crate::ffi::handles::{CallbackTable, FileOutcome, OPERATIONS, OperationState, client_context};
+use crate::ffi::helpers::*;
+use crate::ffi::progress::{ProgressCell, create_progress_provider};
+use crate::ffi::results::{FileEntry, file_result_to_ffi};
+use crate::ffi::types::*;
+use crate::ffi_catch_panic;
+use crate::progress::ProgressProvider;
+use crate::{CacheOptions, FileProcessor, HashAlgorithm};
+use std::ffi::{CString, c_char, c_void};
+use std::path::PathBuf;
+use std::sync::{Arc, Condvar, Mutex};
+use std::time::Duration;
+use tokio::sync::watch;
+
+impl OperationState {
+    fn new(file_path: String) -> Self {
+        let (cancel_tx, _) = watch::channel(false);
+        Self {
+            file_path,
+            status: Mutex::new(AniDBStatus::Pending),
+            finished: Condvar::new(),
+            outcome: Mutex::new(None),
+            completion: Mutex::new(None),
+            cancel_tx,
+            progress: Arc::new(ProgressCell::default()),
+        }
+    }
+
+    fn status(&self) -> AniDBStatus {
+        self.status
+            .lock()
+            .map(|s| *s)
+            .unwrap_or(AniDBStatus::Failed)
+    }
+
+    fn set_processing(&self) {
+        if let Ok(mut status) = self.status.lock()
+            && *status == AniDBStatus::Pending
+        {
+            *status = AniDBStatus::Processing;
+        }
+    }
+
+    fn is_finished(&self) -> bool {
+        is_terminal(self.status())
+    }
+
+    /// Publish the outcome, wake waiters and fire the completion callback
+    ///
+    /// Only the first call has any effect.
+    fn finish(&self, operation_id: usize, outcome: FileOutcome) {
+        let (status, code) = match &outcome {
+            FileOutcome::Completed(_) => (AniDBStatus::Completed, AniDBResult::Success),
+            FileOutcome::Failed { code, .. } => (AniDBStatus::Failed, *code),
+            FileOutcome::Cancelled => (AniDBStatus::Cancelled, AniDBResult::ErrorCancelled),
+        };
+
+        {
+            let Ok(mut current) = self.status.lock() else {
+                return;
+            };
+            if is_terminal(*current) {
+                return;
+            }
+            if let Ok(mut stored) = self.outcome.lock() {
+                *stored = Some(outcome);
+            }
+            *current = status;
+            self.finished.notify_all();
+        }
+
+        let completion = self.completion.lock().ok().and_then(|mut c| c.take());
+        if let Some((callback, user_data)) = completion {
+            callback(operation_id as *mut c_void, code, user_data as *mut c_void);
+        }
+    }
+}
+
+fn is_terminal(status: AniDBStatus) -> bool {
+    matches!(
+        status,
+        AniDBStatus::Completed | AniDBStatus::Failed | AniDBStatus::Cancelled
+    )
+}
+
+/// Resolves an operation as cancelled if its task is dropped unfinished
+///
+/// This happens when the owning client (and its runtime) is destroyed while
+/// the operation is still running.
+struct FinishGuard {
+    state: Arc<OperationState>,
+    operation_id: usize,
+}
+
+impl Drop for FinishGuard {
+    fn drop(&mut self) {
+        self.state.finish(self.operation_id, FileOutcome::Cancelled);
+    }
+}
+
+/// Everything the operation task needs, owned
+struct OperationTask {
+    state: Arc<OperationState>,
+    operation_id: usize,
+    algorithms: Vec<HashAlgorithm>,
+    cache_options: CacheOptions,
+    progress_provider: Arc<dyn ProgressProvider>,
+    file_processor: Arc<FileProcessor>,
+    events: EventSink,
+    callbacks: Arc<CallbackTable>,
+}
+
+/// Run an operation to completion on the client's runtime
+async fn run_operation(task: OperationTask) {
+    let guard = FinishGuard {
+        state: task.state.clone(),
+        operation_id: task.operation_id,
+    };
+    let state = &task.state;
+    state.set_processing();
+
+    let path = PathBuf::from(&state.file_path);
+    let file_size = std::fs::metadata(&path).map(|m| m.len()).unwrap_or(0);
+    task.events
+        .file_event(AniDBEventType::FileStart, &state.file_path, file_size, None);
+
+    let mut cancel_rx = state.cancel_tx.subscribe();
+    let processing = task.file_processor.process_file_with_options(
+        &path,
+        &task.algorithms,
+        task.progress_provider.clone(),
+        task.cache_options,
+    );
+    let outcome = tokio::select! {
+        result = processing => {
+            match result {
+                Ok(proc_result) => FileOutcome::Completed(proc_result),
+                Err(e) => FileOutcome::Failed {
+                    code: error_to_result(&e),
+                    message: e.to_string(),
+                },
+            }
+        }
+        _ = wait_cancelled(&mut cancel_rx) => FileOutcome::Cancelled,
+    };
+
+    notify_client(&task, &outcome);
+    state.finish(task.operation_id, outcome);
+    drop(guard);
+}
+
+/// Emit events and registered callbacks the same way `anidb_process_file` does
+fn notify_client(task: &OperationTask, outcome: &FileOutcome) {
+    let file_path = &task.state.file_path;
+
+    let completion_code = match outcome {
+        FileOutcome::Completed(proc_result) => {
+            task.events.file_event(
+                AniDBEventType::FileComplete,
+                file_path,
+                proc_result.file_size,
+                Some(format_args!(
+                    "Processed in {}ms",
+                    proc_result.processing_time.as_millis()
+                )),
+            );
+            AniDBResult::Success
+        }
+        FileOutcome::Failed { code, message } => {
+            let error_msg_cstr = CString::new(message.clone()).unwrap_or_default();
+            let file_path_cstr = CString::new(file_path.clone()).unwrap_or_default();
+
+            invoke_callbacks(&task.callbacks, AniDBCallbackType::Error, |reg| {
+                let callback_fn = unsafe {
+                    std::mem::transmute::<*mut c_void, AniDBErrorCallback>(reg.callback_ptr)
+                };
+                callback_fn(
+                    *code,
+                    error_msg_cstr.as_ptr(),
+                    file_path_cstr.as_ptr(),
+                    reg.user_data,
+                );
+            });
+            *code
+        }
+        FileOutcome::Cancelled => AniDBResult::ErrorCancelled,
+    };
+
+    invoke_callbacks(&task.callbacks, AniDBCallbackType::Completion, |reg| {
+        let callback_fn = unsafe {
+            std::mem::transmute::<*mut c_void, AniDBCompletionCallback>(reg.callback_ptr)
+        };
+        callback_fn(completion_code, reg.user_data);
+    });
+}
+
+/// Look up an operation by handle
+fn get_operation(operation: *mut c_void) -> Result<(usize, Arc<OperationState>), AniDBResult> {
+    if !validate_mut_ptr(operation) {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    let operation_id = operation as usize;
+    if operation_id == 0 || operation_id > usize::MAX / 2 {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    let operations = OPERATIONS.read().map_err(|_| AniDBResult::ErrorBusy)?;
+    operations
+        .get(&operation_id)
+        .cloned()
+        .map(|state| (operation_id, state))
+        .ok_or(AniDBResult::ErrorInvalidHandle)
+}
+
+/// Process a single file asynchronously
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_process_file_async(
+    handle: *mut c_void,
+    file_path: *const c_char,
+    options: *const AniDBProcessOptions,
+    operation: *mut *mut c_void,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        // Comprehensive parameter validation
+        if !validate_mut_ptr(handle)
+            || !validate_c_str(file_path)
+            || !validate_ptr(options)
+            || !validate_mut_ptr(operation)
+        {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let file_path_str = match c_str_to_string(file_path) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        let opts = unsafe { &*options };
+        let algorithms = match parse_algorithms(opts.algorithms, opts.algorithm_count) {
+            Ok(a) => a,
+            Err(e) => return e,
+        };
+
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        let state = Arc::new(OperationState::new(file_path_str));
+        let progress_provider =
+            create_progress_provider(opts, &context.callbacks, Some(state.progress.clone()));
+        let operation_id = generate_handle_id();
+
+        match OPERATIONS.write() {
+            Ok(mut operations) => {
+                operations.insert(operation_id, state.clone());
+            }
+            Err(_) => return AniDBResult::ErrorBusy,
+        }
+
+        let task = OperationTask {
+            state,
+            operation_id,
+            algorithms,
+            cache_options: parse_cache_options(opts),
+            progress_provider,
+            file_processor: context.file_processor,
+            events: context.events,
+            callbacks: context.callbacks,
+        };
+        let priority = convert_priority(opts.priority);
+        context.runtime.spawn(priority.scope(run_operation(task)));
+
+        unsafe {
+            *operation = operation_id as *mut c_void;
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Set the completion callback of an operation
+///
+/// If the operation has already finished the callback runs immediately on
+/// the calling thread; otherwise it runs once, on a runtime thread.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_operation_set_callback(
+    operation: *mut c_void,
+    callback: Option<AniDBOperationCallback>,
+    user_data: *mut c_void,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        let Some(callback) = callback else {
+            return AniDBResult::ErrorInvalidParameter;
+        };
+
+        let (operation_id, state) = match get_operation(operation) {
+            Ok(o) => o,
+            Err(e) => return e,
+        };
+
+        let mut completion = match state.completion.lock() {
+            Ok(c) => c,
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        // Checked under the completion lock; finish() publishes the status
+        // before taking the callback, so exactly one side invokes it
+        let status = state.status();
+        if !is_terminal(status) {
+            *completion = Some((callback, user_data as usize));
+            return AniDBResult::Success;
+        }
+        drop(completion);
+
+        let code = match status {
+            AniDBStatus::Completed => AniDBResult::Success,
+            AniDBStatus::Cancelled => AniDBResult::ErrorCancelled,
+            _ => match state.outcome.lock().ok().as_deref() {
+                Some(Some(FileOutcome::Failed { code, .. })) => *code,
+                _ => AniDBResult::ErrorProcessing,
+            },
+        };
+        callback(operation_id as *mut c_void, code, user_data);
+
+        AniDBResult::Success
+    })
+}
+
+/// Get the status of an async operation
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_operation_get_status(
+    operation: *mut c_void,
+    status: *mut AniDBStatus,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(status) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let (_, state) = match get_operation(operation) {
+            Ok(o) => o,
+            Err(e) => return e,
+        };
+
+        unsafe {
+            *status = state.status();
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Get the latest progress of an async operation
+///
+/// Never blocks; callers poll at their own rate and compare `updates` to
+/// skip frames without new progress.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_operation_get_progress(
+    operation: *mut c_void,
+    progress: *mut AniDBProgressSnapshot,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(progress) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let (_, state) = match get_operation(operation) {
+            Ok(o) => o,
+            Err(e) => return e,
+        };
+
+        unsafe {
+            *progress = state.progress.snapshot();
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Block until an async operation finishes
+///
+/// A `timeout_ms` of 0 waits indefinitely.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_operation_wait(
+    operation: *mut c_void,
+    timeout_ms: u32,
+    status: *mut AniDBStatus,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        let (_, state) = match get_operation(operation) {
+            Ok(o) => o,
+            Err(e) => return e,
+        };
+
+        let guard = match state.status.lock() {
+            Ok(g) => g,
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        let guard = if timeout_ms == 0 {
+            match state.finished.wait_while(guard, |s| !is_terminal(*s)) {
+                Ok(g) => g,
+                Err(_) => return AniDBResult::ErrorBusy,
+            }
+        } else {
+            let timeout = Duration::from_millis(timeout_ms as u64);
+            match state
+                .finished
+                .wait_timeout_while(guard, timeout, |s| !is_terminal(*s))
+            {
+                Ok((g, _)) => g,
+                Err(_) => return AniDBResult::ErrorBusy,
+            }
+        };
+
+        let current = *guard;
+        drop(guard);
+
+        if validate_mut_ptr(status) {
+            unsafe {
+                *status = current;
+            }
+        }
+
+        if is_terminal(current) {
+            AniDBResult::Success
+        } else {
+            AniDBResult::ErrorTimeout
+        }
+    })
+}
+
+/// Get the result of a completed async operation
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_operation_get_result(
+    operation: *mut c_void,
+    result: *mut *mut AniDBFileResult,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(result) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let (_, state) = match get_operation(operation) {
+            Ok(o) => o,
+            Err(e) => return e,
+        };
+
+        if !state.is_finished() {
+            return AniDBResult::ErrorBusy;
+        }
+
+        let outcome = match state.outcome.lock() {
+            Ok(o) => o,
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        match outcome.as_ref() {
+            Some(FileOutcome::Completed(proc_result)) => {
+                match file_result_to_ffi(&FileEntry::completed(proc_result)) {
+                    Ok(file_result) => {
+                        unsafe {
+                            *result = file_result;
+                        }
+                        AniDBResult::Success
+                    }
+                    Err(e) => e,
+                }
+            }
+            Some(FileOutcome::Failed { code, .. }) => *code,
+            Some(FileOutcome::Cancelled) | None => AniDBResult::ErrorCancelled,
+        }
+    })
+}
+
+/// Cancel an async operation
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_operation_cancel(operation: *mut c_void) -> AniDBResult {
+    ffi_catch_panic!({
+        let (_, state) = match get_operation(operation) {
+            Ok(o) => o,
+            Err(e) => return e,
+        };
+
+        state.cancel_tx.send_replace(true);
+        AniDBResult::Success
+    })
+}
+
+/// Destroy an operation handle, cancelling it if still running
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_operation_destroy(operation: *mut c_void) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(operation) {
+            return AniDBResult::ErrorInvalidHandle;
+        }
+
+        let operation_id = operation as usize;
+        if operation_id == 0 || operation_id > usize::MAX / 2 {
+            return AniDBResult::ErrorInvalidHandle;
+        }
+
+        let state = match OPERATIONS.write() {
+            Ok(mut operations) => match operations.remove(&operation_id) {
+                Some(s) => s,
+                None => return AniDBResult::ErrorInvalidHandle,
+            },
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        // The task still owns the state; a pending callback will still fire
+        state.cancel_tx.send_replace(true);
+        AniDBResult::Success
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    static CALLS: AtomicUsize = AtomicUsize::new(0);
+
+    extern "C" fn count_completion(_op: *mut c_void, _result: AniDBResult, _data: *mut c_void) {
+        CALLS.fetch_add(1, Ordering::SeqCst);
+    }
+
+    #[test]
+    fn test_finish_fires_callback_once() {
+        let state = OperationState::new("file.bin".into());
+        *state.completion.lock().unwrap() = Some((count_completion, 0));
+
+        let before = CALLS.load(Ordering::SeqCst);
+        state.finish(1, FileOutcome::Cancelled);
+        state.finish(1, FileOutcome::Cancelled);
+
+        assert_eq!(CALLS.load(Ordering::SeqCst), before + 1);
+        assert_eq!(state.status(), AniDBStatus::Cancelled);
+    }
+
+    #[test]
+    fn test_first_outcome_wins() {
+        let state = OperationState::new("file.bin".into());
+        state.finish(
+            1,
+            FileOutcome::Failed {
+                code: AniDBResult::ErrorIo,
+                message: "read failed".into(),
+            },
+        );
+        state.finish(1, FileOutcome::Cancelled);
+
+        assert_eq!(state.status(), AniDBStatus::Failed);
+    }
+}
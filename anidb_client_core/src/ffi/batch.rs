@@ -0,0 +1,1405 @@
+//! Batch processing for FFI
+//!
+//! This module implements the scheduler behind `anidb_process_batch` and
+//! `anidb_process_batch_async`. Input files are grouped by the device that
+//! stores them and each device is served by a small number of sequential
+//! readers (see [`crate::scheduler`]), fixed unless the client tunes them
+//! per device (see [`crate::tuning`]), so a batch spanning several disks
+//! keeps all of them busy without thrashing any single one. A
+//! batch-wide semaphore caps the total number of files in flight at
+//! `max_concurrent`, and per-device throughput is available through
+//! `anidb_batch_get_device_stats`.
+//!
+//! Streaming batches (`anidb_process_batch_stream`) hand each file result to
+//! the caller as soon as it is ready and keep only the summary counters.
+//! Directory scans (`anidb_scan_and_process`) stream the same way, but take
+//! their files from a walker running alongside the readers, so hashing
+//! starts with the first match instead of after the whole tree is listed.
+
+use crate::cache::FileIdentity;
+use crate::ffi::events::EventSink;
+use crate::ffi::handles::{BATCHES, BatchState, FileOutcome, SizeCollision, client_context};
+use crate::ffi::helpers::*;
+use crate::ffi::results::{FileEntry, batch_result_to_ffi, file_result_to_ffi};
+use crate::ffi::types::*;
+use crate::ffi_catch_panic;
+use crate::file_discovery::{DiscoveryError, FileDiscovery, FileDiscoveryOptions};
+use crate::platform::device_id_for_path;
+use crate::progress::NullProvider;
+use crate::scheduler::{
+    DeviceQueue, DeviceStats, MAX_READERS_PER_DEVICE, Priority, ReaderGate, group_by_device,
+    run_device_queues,
+};
+use crate::{FileProcessor, HashAlgorithm};
+use std::collections::HashMap;
+use std::ffi::{c_char, c_void};
+use std::path::{Path, PathBuf};
+use std::ptr;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::Instant;
+use tokio::sync::{Semaphore, mpsc, watch};
+
+/// Files a scan may have discovered but not yet finished
+///
+/// Bounds how far the walk runs ahead of the readers.
+const SCAN_QUEUE_DEPTH: usize = 256;
+
+/// Batch options copied out of the caller's `anidb_batch_options_t`
+struct BatchRequest {
+    algorithms: Vec<HashAlgorithm>,
+    max_concurrent: usize,
+    continue_on_error: bool,
+    /// Scheduling priority of every job, set again in each reader task
+    priority: Priority,
+    progress_callback: Option<AniDBProgressCallback>,
+    completion_callback: Option<AniDBCompletionCallback>,
+    /// Receives ownership of each file result in streaming mode
+    result_callback: Option<AniDBResultCallback>,
+    user_data: usize,
+    /// Serializes caller callbacks; readers finish on different threads
+    callback_lock: Mutex<()>,
+}
+
+/// A unit of work for a device reader
+struct BatchJob {
+    /// Index of the path in the caller's array
+    index: usize,
+    path: PathBuf,
+    /// Duplicate paths that receive a copy of this job's result
+    aliases: Vec<Alias>,
+    /// Hardlinks a scan finds while the job runs, see [`ScanLinks`]
+    links: Option<Arc<Mutex<ScanLinks>>>,
+}
+
+/// Another path to the file of a job
+#[derive(Debug, Clone, PartialEq, Eq)]
+struct Alias {
+    /// Index of the path in the caller's array, or in discovery order
+    index: usize,
+    path: PathBuf,
+}
+
+/// Paths of a scanned file with several hardlinks
+///
+/// A scan cannot know a file's other names before it reaches them, so the
+/// job of the first one collects those found while it runs and leaves its
+/// outcome for those found after it.
+enum ScanLinks {
+    /// The job is running; these paths get its outcome when it finishes
+    Pending(Vec<Alias>),
+    /// The job has finished with this outcome
+    Done(FileOutcome),
+}
+
+impl BatchState {
+    /// Create the state for a batch; streaming batches do not retain outcomes
+    fn new(file_paths: Vec<String>, streaming: bool) -> Self {
+        let retained = if streaming { 0 } else { file_paths.len() };
+        let (cancel_tx, _) = watch::channel(false);
+        Self {
+            total_files: AtomicUsize::new(file_paths.len()),
+            file_paths,
+            streaming,
+            completed_files: AtomicUsize::new(0),
+            successful_files: AtomicUsize::new(0),
+            failed_files: AtomicUsize::new(0),
+            outcomes: Mutex::new(vec![None; retained]),
+            status: Mutex::new(AniDBStatus::Pending),
+            first_error: Mutex::new(None),
+            cancel_requested: AtomicBool::new(false),
+            cancel_tx,
+            started_at: Instant::now(),
+            total_time_ms: AtomicU64::new(0),
+            devices: Mutex::new(Vec::new()),
+            size_collisions: Mutex::new(Vec::new()),
+        }
+    }
+
+    fn total_files(&self) -> usize {
+        self.total_files.load(Ordering::Acquire)
+    }
+
+    fn status(&self) -> AniDBStatus {
+        self.status
+            .lock()
+            .map(|s| *s)
+            .unwrap_or(AniDBStatus::Failed)
+    }
+
+    fn set_status(&self, status: AniDBStatus) {
+        if let Ok(mut s) = self.status.lock() {
+            *s = status;
+        }
+    }
+
+    fn is_finished(&self) -> bool {
+        matches!(
+            self.status(),
+            AniDBStatus::Completed | AniDBStatus::Failed | AniDBStatus::Cancelled
+        )
+    }
+
+    /// Stop scheduling new files and abort the ones in flight
+    fn cancel(&self) {
+        self.cancel_tx.send_replace(true);
+    }
+
+    /// Store the outcome of a job for its path and every alias
+    ///
+    /// Returns the number of completed paths after recording.
+    fn record(&self, job: &BatchJob, outcome: FileOutcome) -> usize {
+        let recorded = 1 + job.aliases.len();
+
+        match &outcome {
+            FileOutcome::Completed(_) => {
+                self.successful_files.fetch_add(recorded, Ordering::Relaxed);
+            }
+            FileOutcome::Failed { code, .. } => {
+                self.failed_files.fetch_add(recorded, Ordering::Relaxed);
+                if let Ok(mut first) = self.first_error.lock() {
+                    first.get_or_insert(*code);
+                }
+            }
+            FileOutcome::Cancelled => {
+                self.failed_files.fetch_add(recorded, Ordering::Relaxed);
+            }
+        }
+
+        if !self.streaming
+            && let Ok(mut outcomes) = self.outcomes.lock()
+        {
+            for alias in &job.aliases {
+                outcomes[alias.index] = Some(self.alias_outcome(&alias.path, &outcome));
+            }
+            outcomes[job.index] = Some(outcome);
+        }
+
+        self.completed_files.fetch_add(recorded, Ordering::AcqRel) + recorded
+    }
+
+    /// Copy a job's outcome for a duplicate path, reporting that path
+    fn alias_outcome(&self, path: &Path, outcome: &FileOutcome) -> FileOutcome {
+        match outcome {
+            FileOutcome::Completed(result) => {
+                let mut result = result.clone();
+                result.file_path = path.to_path_buf();
+                FileOutcome::Completed(result)
+            }
+            other => other.clone(),
+        }
+    }
+
+    /// Hand a job's results to the caller's result callback
+    ///
+    /// Every alias receives its own result so the callback fires exactly
+    /// once per input path.
+    fn stream(&self, job: &BatchJob, outcome: &FileOutcome, request: &BatchRequest) {
+        let Some(cb) = request.result_callback else {
+            return;
+        };
+
+        let deliver = |index: usize, path: &str, outcome: &FileOutcome| {
+            let entry = outcome_entry(path, Some(outcome));
+            let file_result = file_result_to_ffi(&entry).unwrap_or(ptr::null_mut());
+            cb(index, file_result, request.user_data as *mut c_void);
+        };
+
+        // Scanned files have no entry in `file_paths`, only their job
+        let _lock = request.callback_lock.lock();
+        deliver(job.index, &job.path.to_string_lossy(), outcome);
+        for alias in &job.aliases {
+            deliver(
+                alias.index,
+                &alias.path.to_string_lossy(),
+                &self.alias_outcome(&alias.path, outcome),
+            );
+        }
+    }
+}
+
+/// Marks a batch cancelled if its scheduler is dropped before finishing
+///
+/// This happens when the owning client (and its runtime) is destroyed while
+/// an async batch is still running.
+struct FinishGuard(Arc<BatchState>);
+
+impl Drop for FinishGuard {
+    fn drop(&mut self) {
+        if !self.0.is_finished() {
+            self.0.set_status(AniDBStatus::Cancelled);
+        }
+    }
+}
+
+/// Jobs of a planned batch and the files that share a size
+#[derive(Default)]
+struct BatchPlan {
+    queues: Vec<DeviceQueue<BatchJob>>,
+    size_collisions: Vec<SizeCollision>,
+}
+
+/// Group input paths into per-device job queues
+///
+/// Every path is stat'ed once up front. Paths that resolve to the same file
+/// (repeated paths, symlinks, hardlinks and bind mounts all share a device
+/// and inode) are hashed once and the result is copied to every alias, so
+/// no file is read twice in a batch. Distinct files of equal size are
+/// reported as collision groups for callers that verify duplicates.
+fn plan_jobs(file_paths: &[String]) -> BatchPlan {
+    let mut jobs: Vec<(u64, BatchJob)> = Vec::with_capacity(file_paths.len());
+    let mut seen: HashMap<(u64, u64), usize> = HashMap::new();
+    let mut by_size: HashMap<u64, Vec<usize>> = HashMap::new();
+
+    for (index, path_str) in file_paths.iter().enumerate() {
+        let path = Path::new(path_str);
+
+        let device = match std::fs::metadata(path) {
+            Ok(metadata) => {
+                let identity = FileIdentity::from_metadata(path, &metadata);
+                if let Some(&job) = seen.get(&(identity.device, identity.inode)) {
+                    jobs[job].1.aliases.push(Alias {
+                        index,
+                        path: path.to_path_buf(),
+                    });
+                    continue;
+                }
+                seen.insert((identity.device, identity.inode), jobs.len());
+                by_size.entry(identity.size).or_default().push(index);
+                identity.device
+            }
+            // Unreadable paths still get a job so the processor reports the error
+            Err(_) => device_id_for_path(path),
+        };
+
+        jobs.push((
+            device,
+            BatchJob {
+                index,
+                path: path.to_path_buf(),
+                aliases: Vec::new(),
+                links: None,
+            },
+        ));
+    }
+
+    let mut size_collisions: Vec<SizeCollision> = by_size
+        .into_iter()
+        .filter(|(_, indices)| indices.len() > 1)
+        .flat_map(|(file_size, indices)| {
+            indices.into_iter().map(move |path_index| SizeCollision {
+                file_size,
+                path_index,
+            })
+        })
+        .collect();
+    size_collisions.sort_unstable_by_key(|c| (c.file_size, c.path_index));
+
+    BatchPlan {
+        queues: group_by_device(jobs),
+        size_collisions,
+    }
+}
+
+/// Run a batch to completion
+async fn run_batch(
+    state: Arc<BatchState>,
+    request: BatchRequest,
+    file_processor: Arc<FileProcessor>,
+    events: EventSink,
+) {
+    let guard = FinishGuard(state.clone());
+    state.set_status(AniDBStatus::Processing);
+
+    let request = Arc::new(request);
+    let in_flight = Arc::new(Semaphore::new(request.max_concurrent));
+    let readers_per_device = request.max_concurrent.min(MAX_READERS_PER_DEVICE);
+
+    // Planning stats every path, keep it off the runtime's worker threads
+    let planner_state = state.clone();
+    let plan = tokio::task::spawn_blocking(move || plan_jobs(&planner_state.file_paths))
+        .await
+        .unwrap_or_default();
+
+    if let Ok(mut collisions) = state.size_collisions.lock() {
+        *collisions = plan.size_collisions;
+    }
+    let queues: Vec<_> = plan.queues.into_iter().map(Arc::new).collect();
+    file_processor
+        .metrics()
+        .add_queued(queues.iter().map(|q| q.len()).sum());
+    if let Ok(mut devices) = state.devices.lock() {
+        *devices = queues.iter().map(|q| q.stats().clone()).collect();
+    }
+
+    let reader_state = state.clone();
+    let reader_request = request.clone();
+    let reader_processor = file_processor.clone();
+    let gate_processor = file_processor.clone();
+    let gate = move |device| gate_processor.reader_gate(device, readers_per_device);
+    run_device_queues(queues, gate, move |job, stats| {
+        reader_request.priority.scope(run_job(
+            job,
+            stats,
+            reader_state.clone(),
+            reader_request.clone(),
+            reader_processor.clone(),
+            events.clone(),
+            in_flight.clone(),
+        ))
+    })
+    .await;
+
+    finish_batch(&state, &request, &file_processor).await;
+    drop(guard);
+}
+
+/// Discover files under a root and process each one as soon as it is found
+///
+/// The walk runs on a blocking thread and hands over every match through a
+/// bounded channel. Each file joins its device's readers exactly like a
+/// planned batch, so per-device limits and cache lookups apply unchanged.
+/// Hardlinks of one file are hashed once, as in a planned batch; the
+/// other names receive copies of the result through [`ScanLinks`].
+async fn run_scan(
+    state: Arc<BatchState>,
+    request: BatchRequest,
+    discovery: FileDiscovery,
+    file_processor: Arc<FileProcessor>,
+    events: EventSink,
+) {
+    let guard = FinishGuard(state.clone());
+    state.set_status(AniDBStatus::Processing);
+
+    let request = Arc::new(request);
+    let in_flight = Arc::new(Semaphore::new(request.max_concurrent));
+    let readers_per_device = request.max_concurrent.min(MAX_READERS_PER_DEVICE);
+    let metrics = file_processor.metrics().clone();
+
+    let (tx, mut rx) = mpsc::channel::<(u64, Option<(u64, u64)>, PathBuf)>(SCAN_QUEUE_DEPTH);
+    let walker_cancel = state.cancel_tx.subscribe();
+    let walker = tokio::task::spawn_blocking(move || {
+        for file in discovery {
+            if *walker_cancel.borrow() {
+                break;
+            }
+            let file = match file {
+                Ok(file) => file,
+                Err(e) => {
+                    log::warn!("Scan error: {e}");
+                    continue;
+                }
+            };
+            let (device, link_key) = scan_identity(&file.path);
+            if tx.blocking_send((device, link_key, file.path)).is_err() {
+                break;
+            }
+        }
+    });
+
+    // Every job holds a pending permit until it finishes, which bounds the
+    // spawned tasks and lets the end of the scan wait for all of them
+    let pending = Arc::new(Semaphore::new(SCAN_QUEUE_DEPTH));
+    let mut readers: HashMap<u64, (Arc<DeviceStats>, Arc<ReaderGate>)> = HashMap::new();
+    let mut seen: HashMap<(u64, u64), Arc<Mutex<ScanLinks>>> = HashMap::new();
+    let mut index = 0;
+
+    while let Some((device, link_key, path)) = rx.recv().await {
+        let mut links = None;
+        if let Some(key) = link_key {
+            if let Some(existing) = seen.get(&key) {
+                let alias = Alias { index, path };
+                index += 1;
+                state.total_files.fetch_add(1, Ordering::AcqRel);
+                let mut existing = existing.lock().unwrap_or_else(|e| e.into_inner());
+                match &mut *existing {
+                    ScanLinks::Pending(aliases) => aliases.push(alias),
+                    ScanLinks::Done(outcome) => record_late_alias(&state, &request, alias, outcome),
+                }
+                continue;
+            }
+            let slot = Arc::new(Mutex::new(ScanLinks::Pending(Vec::new())));
+            seen.insert(key, slot.clone());
+            links = Some(slot);
+        }
+
+        let Ok(pending_permit) = pending.clone().acquire_owned().await else {
+            break;
+        };
+
+        let (stats, device_readers) = readers
+            .entry(device)
+            .or_insert_with(|| {
+                let stats = Arc::new(DeviceStats::new(device, 0));
+                if let Ok(mut devices) = state.devices.lock() {
+                    devices.push(stats.clone());
+                }
+                (
+                    stats,
+                    file_processor.reader_gate(device, readers_per_device),
+                )
+            })
+            .clone();
+        stats.add_file();
+        state.total_files.fetch_add(1, Ordering::AcqRel);
+        metrics.add_queued(1);
+
+        let job = BatchJob {
+            index,
+            path,
+            aliases: Vec::new(),
+            links,
+        };
+        index += 1;
+
+        let job_state = state.clone();
+        let job_request = request.clone();
+        let job_processor = file_processor.clone();
+        let job_events = events.clone();
+        let job_in_flight = in_flight.clone();
+        let priority = job_request.priority;
+        tokio::spawn(priority.scope(async move {
+            // Become one of the device's readers, then queue for a
+            // batch-wide slot inside run_job
+            let _reader = device_readers.acquire().await;
+            run_job(
+                job,
+                stats,
+                job_state,
+                job_request,
+                job_processor,
+                job_events,
+                job_in_flight,
+            )
+            .await;
+            drop(pending_permit);
+        }));
+    }
+
+    let _ = walker.await;
+    let _ = pending.acquire_many(SCAN_QUEUE_DEPTH as u32).await;
+
+    finish_batch(&state, &request, &file_processor).await;
+    drop(guard);
+}
+
+/// Device of a scanned file and, if it has other hardlinks, the
+/// `(device, inode)` they share
+///
+/// Only files with several links are tracked, so a scan keeps no outcome
+/// for the common single-link file.
+fn scan_identity(path: &Path) -> (u64, Option<(u64, u64)>) {
+    let Ok(metadata) = std::fs::metadata(path) else {
+        return (device_id_for_path(path), None);
+    };
+    let identity = FileIdentity::from_metadata(path, &metadata);
+    #[cfg(unix)]
+    let linked = std::os::unix::fs::MetadataExt::nlink(&metadata) > 1;
+    // Elsewhere the inode is a path hash, which never matches another name
+    #[cfg(not(unix))]
+    let linked = false;
+    (
+        identity.device,
+        linked.then_some((identity.device, identity.inode)),
+    )
+}
+
+/// Give a hardlink found after its file finished a copy of the outcome
+fn record_late_alias(
+    state: &BatchState,
+    request: &BatchRequest,
+    alias: Alias,
+    outcome: &FileOutcome,
+) {
+    let outcome = state.alias_outcome(&alias.path, outcome);
+    let job = BatchJob {
+        index: alias.index,
+        path: alias.path,
+        aliases: Vec::new(),
+        links: None,
+    };
+    state.stream(&job, &outcome, request);
+    state.record(&job, outcome);
+    report_progress(state, request);
+}
+
+/// Save the cache, report completion and publish the final batch status
+async fn finish_batch(state: &BatchState, request: &BatchRequest, file_processor: &FileProcessor) {
+    // Save what the batch added so a crash before the client is destroyed
+    // does not lose the scan
+    if let Some(cache) = file_processor.cache().cloned() {
+        let flushed = tokio::task::spawn_blocking(move || cache.flush()).await;
+        if let Ok(Err(e)) = flushed {
+            log::warn!("Failed to save hash cache: {e}");
+        }
+    }
+
+    state.total_time_ms.store(
+        state.started_at.elapsed().as_millis() as u64,
+        Ordering::Relaxed,
+    );
+
+    let user_cancelled = state.cancel_requested.load(Ordering::Acquire);
+    let first_error = state.first_error.lock().ok().and_then(|e| *e);
+    let completion_result = if user_cancelled {
+        AniDBResult::ErrorCancelled
+    } else if !request.continue_on_error
+        && let Some(code) = first_error
+    {
+        code
+    } else {
+        AniDBResult::Success
+    };
+
+    // Invoke the callback before publishing the final status so callers
+    // polling for the result may release user_data once it is available
+    if let Some(cb) = request.completion_callback {
+        let _lock = request.callback_lock.lock();
+        cb(completion_result, request.user_data as *mut c_void);
+    }
+
+    state.set_status(if user_cancelled {
+        AniDBStatus::Cancelled
+    } else {
+        AniDBStatus::Completed
+    });
+}
+
+/// Process one job on behalf of its device's reader, updating its counters
+async fn run_job(
+    mut job: BatchJob,
+    stats: Arc<DeviceStats>,
+    state: Arc<BatchState>,
+    request: Arc<BatchRequest>,
+    file_processor: Arc<FileProcessor>,
+    events: EventSink,
+    in_flight: Arc<Semaphore>,
+) {
+    let mut cancel_rx = state.cancel_tx.subscribe();
+
+    let metrics = file_processor.metrics().clone();
+    let outcome = if *cancel_rx.borrow() {
+        metrics.dequeue();
+        FileOutcome::Cancelled
+    } else {
+        // Acquire the device slot first (by being this reader), then a
+        // batch-wide slot, so a busy device never holds global capacity
+        let permit = tokio::select! {
+            permit = in_flight.clone().acquire_owned() => permit.ok(),
+            _ = wait_cancelled(&mut cancel_rx) => None,
+        };
+        metrics.dequeue();
+
+        match permit {
+            Some(_permit) => {
+                stats.start();
+                process_job(&job, &request, &file_processor, &events, &mut cancel_rx).await
+            }
+            None => FileOutcome::Cancelled,
+        }
+    };
+
+    if matches!(outcome, FileOutcome::Failed { .. }) && !request.continue_on_error {
+        state.cancel();
+    }
+
+    let bytes = match &outcome {
+        FileOutcome::Completed(result) => result.file_size,
+        _ => 0,
+    };
+    stats.complete_file(bytes);
+    if let (Some(tuner), FileOutcome::Completed(result)) = (file_processor.tuner(), &outcome) {
+        tuner.record_file(stats.device(), result);
+    }
+
+    // Hardlinks the scan found meanwhile share this outcome; later ones
+    // find it in the slot
+    if let Some(links) = job.links.take() {
+        let mut links = links.lock().unwrap_or_else(|e| e.into_inner());
+        if let ScanLinks::Pending(aliases) =
+            std::mem::replace(&mut *links, ScanLinks::Done(outcome.clone()))
+        {
+            job.aliases.extend(aliases);
+        }
+    }
+
+    state.stream(&job, &outcome, &request);
+    state.record(&job, outcome);
+    report_progress(&state, &request);
+}
+
+/// Report the batch's progress to the caller's progress callback
+fn report_progress(state: &BatchState, request: &BatchRequest) {
+    if let Some(cb) = request.progress_callback {
+        // Read the counter under the lock so reported progress never
+        // goes backwards when readers finish at the same time
+        let _lock = request.callback_lock.lock();
+        let completed = state.completed_files.load(Ordering::Acquire);
+        let total = state.total_files();
+        let percentage = (completed as f32 / total as f32) * 100.0;
+        cb(
+            percentage,
+            completed as u64,
+            total as u64,
+            request.user_data as *mut c_void,
+        );
+    }
+}
+
+/// Hash a single file, aborting if the batch is cancelled
+async fn process_job(
+    job: &BatchJob,
+    request: &BatchRequest,
+    file_processor: &FileProcessor,
+    events: &EventSink,
+    cancel_rx: &mut watch::Receiver<bool>,
+) -> FileOutcome {
+    let path_str = job.path.to_string_lossy();
+    let file_size = std::fs::metadata(&job.path).map(|m| m.len()).unwrap_or(0);
+    events.file_event(AniDBEventType::FileStart, &path_str, file_size, None);
+
+    let progress: Arc<dyn crate::progress::ProgressProvider> = Arc::new(NullProvider);
+    let result = tokio::select! {
+        result = file_processor.process_file(&job.path, &request.algorithms, progress) => result,
+        _ = wait_cancelled(cancel_rx) => return FileOutcome::Cancelled,
+    };
+
+    match result {
+        Ok(proc_result) => {
+            events.file_event(
+                AniDBEventType::FileComplete,
+                &path_str,
+                proc_result.file_size,
+                Some(format_args!(
+                    "Processed in {}ms",
+                    proc_result.processing_time.as_millis()
+                )),
+            );
+            FileOutcome::Completed(proc_result)
+        }
+        Err(e) => FileOutcome::Failed {
+            code: error_to_result(&e),
+            message: e.to_string(),
+        },
+    }
+}
+
+/// Describe a recorded outcome as a C file result
+fn outcome_entry<'a>(path: &'a str, outcome: Option<&'a FileOutcome>) -> FileEntry<'a> {
+    match outcome {
+        Some(FileOutcome::Completed(proc_result)) => FileEntry::completed(proc_result),
+        Some(FileOutcome::Failed { message, .. }) => {
+            FileEntry::unprocessed(path, AniDBStatus::Failed, Some(message.as_str()))
+        }
+        Some(FileOutcome::Cancelled) | None => {
+            FileEntry::unprocessed(path, AniDBStatus::Cancelled, None)
+        }
+    }
+}
+
+/// Build the C batch result from the recorded outcomes
+///
+/// Streaming batches report their counters with a NULL results array.
+fn build_batch_result(state: &BatchState) -> Result<*mut AniDBBatchResult, AniDBResult> {
+    let summary = AniDBBatchResult {
+        total_files: state.total_files(),
+        successful_files: state.successful_files.load(Ordering::Relaxed),
+        failed_files: state.failed_files.load(Ordering::Relaxed),
+        results: ptr::null_mut(),
+        total_time_ms: state.total_time_ms.load(Ordering::Relaxed),
+        size_collisions: ptr::null_mut(),
+        size_collision_count: 0,
+    };
+    let size_collisions: Vec<AniDBSizeCollision> = state
+        .size_collisions
+        .lock()
+        .map_err(|_| AniDBResult::ErrorBusy)?
+        .iter()
+        .map(|collision| AniDBSizeCollision {
+            file_size: collision.file_size,
+            path_index: collision.path_index,
+        })
+        .collect();
+
+    if state.streaming {
+        return batch_result_to_ffi(summary, &[], &size_collisions);
+    }
+
+    let outcomes = state.outcomes.lock().map_err(|_| AniDBResult::ErrorBusy)?;
+    let entries: Vec<FileEntry> = outcomes
+        .iter()
+        .enumerate()
+        .map(|(i, outcome)| outcome_entry(&state.file_paths[i], outcome.as_ref()))
+        .collect();
+    batch_result_to_ffi(summary, &entries, &size_collisions)
+}
+
+/// Copy the caller's paths and options into owned values
+fn parse_batch_request(
+    file_paths: *const *const c_char,
+    file_count: usize,
+    options: *const AniDBBatchOptions,
+    default_concurrency: usize,
+) -> Result<(Vec<String>, BatchRequest), AniDBResult> {
+    if file_count == 0 {
+        return Err(AniDBResult::ErrorInvalidParameter);
+    }
+
+    let mut paths = Vec::with_capacity(file_count);
+    for i in 0..file_count {
+        let path_ptr = unsafe { *file_paths.add(i) };
+        if !validate_c_str(path_ptr) {
+            return Err(AniDBResult::ErrorInvalidParameter);
+        }
+        paths.push(c_str_to_string(path_ptr)?);
+    }
+
+    Ok((paths, parse_batch_options(options, default_concurrency)?))
+}
+
+/// Copy the caller's batch options into an owned request
+fn parse_batch_options(
+    options: *const AniDBBatchOptions,
+    default_concurrency: usize,
+) -> Result<BatchRequest, AniDBResult> {
+    let opts = unsafe { &*options };
+    let algorithms = parse_algorithms(opts.algorithms, opts.algorithm_count)?;
+
+    // Zero means "use the client's configured concurrency"
+    let max_concurrent = if opts.max_concurrent == 0 {
+        default_concurrency
+    } else {
+        opts.max_concurrent
+    }
+    .clamp(1, 100);
+
+    Ok(BatchRequest {
+        algorithms,
+        max_concurrent,
+        continue_on_error: opts.continue_on_error != 0,
+        priority: convert_priority(opts.priority),
+        progress_callback: opts.progress_callback,
+        completion_callback: opts.completion_callback,
+        result_callback: None,
+        user_data: opts.user_data as usize,
+        callback_lock: Mutex::new(()),
+    })
+}
+
+/// Copy an array of C strings, which may be empty
+fn parse_string_array(
+    strings: *const *const c_char,
+    count: usize,
+) -> Result<Vec<String>, AniDBResult> {
+    if count == 0 {
+        return Ok(Vec::new());
+    }
+    if !validate_ptr(strings) {
+        return Err(AniDBResult::ErrorInvalidParameter);
+    }
+
+    (0..count)
+        .map(|i| {
+            let ptr = unsafe { *strings.add(i) };
+            if !validate_c_str(ptr) {
+                return Err(AniDBResult::ErrorInvalidParameter);
+            }
+            c_str_to_string(ptr)
+        })
+        .collect()
+}
+
+/// Copy the caller's scan options; NULL selects the walker defaults
+fn parse_scan_options(
+    options: *const AniDBScanOptions,
+) -> Result<FileDiscoveryOptions, AniDBResult> {
+    if options.is_null() {
+        return Ok(FileDiscoveryOptions::default());
+    }
+
+    let opts = unsafe { &*options };
+    Ok(FileDiscoveryOptions::new()
+        .with_include_patterns(parse_string_array(
+            opts.include_patterns,
+            opts.include_count,
+        )?)
+        .with_exclude_patterns(parse_string_array(
+            opts.exclude_patterns,
+            opts.exclude_count,
+        )?)
+        .with_use_defaults(opts.use_defaults != 0)
+        .with_recursive(opts.recursive != 0)
+        .with_follow_links(opts.follow_links != 0)
+        .with_max_depth((opts.max_depth > 0).then_some(opts.max_depth)))
+}
+
+/// Look up a batch by handle
+fn get_batch(batch: *mut c_void) -> Result<Arc<BatchState>, AniDBResult> {
+    if !validate_mut_ptr(batch) {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    let batch_id = batch as usize;
+    if batch_id == 0 || batch_id > usize::MAX / 2 {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    let batches = BATCHES.read().map_err(|_| AniDBResult::ErrorBusy)?;
+    batches
+        .get(&batch_id)
+        .cloned()
+        .ok_or(AniDBResult::ErrorInvalidHandle)
+}
+
+/// Process multiple files synchronously
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_process_batch(
+    handle: *mut c_void,
+    file_paths: *const *const c_char,
+    file_count: usize,
+    options: *const AniDBBatchOptions,
+    result: *mut *mut AniDBBatchResult,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        // Comprehensive parameter validation
+        if !validate_mut_ptr(handle)
+            || !validate_ptr(file_paths)
+            || !validate_ptr(options)
+            || !validate_mut_ptr(result)
+        {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        let (paths, request) =
+            match parse_batch_request(file_paths, file_count, options, context.default_concurrency)
+            {
+                Ok(r) => r,
+                Err(e) => return e,
+            };
+
+        let state = Arc::new(BatchState::new(paths, false));
+        context.runtime.block_on(run_batch(
+            state.clone(),
+            request,
+            context.file_processor,
+            context.events,
+        ));
+
+        match build_batch_result(&state) {
+            Ok(batch_result) => {
+                unsafe {
+                    *result = batch_result;
+                }
+                AniDBResult::Success
+            }
+            Err(e) => e,
+        }
+    })
+}
+
+/// Register a batch handle and start the batch on the client's runtime
+fn start_batch(
+    handle: *mut c_void,
+    file_paths: *const *const c_char,
+    file_count: usize,
+    options: *const AniDBBatchOptions,
+    result_callback: Option<AniDBResultCallback>,
+    batch: *mut *mut c_void,
+) -> AniDBResult {
+    let context = match client_context(handle) {
+        Ok(c) => c,
+        Err(e) => return e,
+    };
+
+    let (paths, mut request) =
+        match parse_batch_request(file_paths, file_count, options, context.default_concurrency) {
+            Ok(r) => r,
+            Err(e) => return e,
+        };
+    request.result_callback = result_callback;
+
+    let state = Arc::new(BatchState::new(paths, result_callback.is_some()));
+    let batch_id = generate_handle_id();
+
+    match BATCHES.write() {
+        Ok(mut batches) => {
+            batches.insert(batch_id, state.clone());
+        }
+        Err(_) => return AniDBResult::ErrorBusy,
+    }
+
+    context.runtime.spawn(run_batch(
+        state,
+        request,
+        context.file_processor,
+        context.events,
+    ));
+
+    unsafe {
+        *batch = batch_id as *mut c_void;
+    }
+
+    AniDBResult::Success
+}
+
+/// Process multiple files asynchronously
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_process_batch_async(
+    handle: *mut c_void,
+    file_paths: *const *const c_char,
+    file_count: usize,
+    options: *const AniDBBatchOptions,
+    batch: *mut *mut c_void,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        // Comprehensive parameter validation
+        if !validate_mut_ptr(handle)
+            || !validate_ptr(file_paths)
+            || !validate_ptr(options)
+            || !validate_mut_ptr(batch)
+        {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        start_batch(handle, file_paths, file_count, options, None, batch)
+    })
+}
+
+/// Process multiple files asynchronously, streaming each file result
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_process_batch_stream(
+    handle: *mut c_void,
+    file_paths: *const *const c_char,
+    file_count: usize,
+    options: *const AniDBBatchOptions,
+    result_callback: Option<AniDBResultCallback>,
+    batch: *mut *mut c_void,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        // Comprehensive parameter validation
+        if !validate_mut_ptr(handle)
+            || !validate_ptr(file_paths)
+            || !validate_ptr(options)
+            || !validate_mut_ptr(batch)
+            || result_callback.is_none()
+        {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        start_batch(
+            handle,
+            file_paths,
+            file_count,
+            options,
+            result_callback,
+            batch,
+        )
+    })
+}
+
+/// Scan a directory and process every matching file, streaming each result
+///
+/// Files are hashed while the walk continues; the batch total grows as
+/// files are discovered and is final once the batch finishes.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_scan_and_process(
+    handle: *mut c_void,
+    root: *const c_char,
+    scan_options: *const AniDBScanOptions,
+    options: *const AniDBBatchOptions,
+    result_callback: Option<AniDBResultCallback>,
+    batch: *mut *mut c_void,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        // Comprehensive parameter validation; scan options are optional
+        if !validate_mut_ptr(handle)
+            || !validate_c_str(root)
+            || !validate_ptr(options)
+            || !validate_mut_ptr(batch)
+            || result_callback.is_none()
+        {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        let root = match c_str_to_string(root) {
+            Ok(r) => r,
+            Err(e) => return e,
+        };
+        let mut request = match parse_batch_options(options, context.default_concurrency) {
+            Ok(r) => r,
+            Err(e) => return e,
+        };
+        request.result_callback = result_callback;
+
+        // Bad patterns and missing roots fail here rather than in the walk
+        let discovery = match parse_scan_options(scan_options)
+            .and_then(|opts| FileDiscovery::new(Path::new(&root), opts).map_err(discovery_error))
+        {
+            Ok(d) => d,
+            Err(e) => return e,
+        };
+
+        let state = Arc::new(BatchState::new(Vec::new(), true));
+        let batch_id = generate_handle_id();
+
+        match BATCHES.write() {
+            Ok(mut batches) => {
+                batches.insert(batch_id, state.clone());
+            }
+            Err(_) => return AniDBResult::ErrorBusy,
+        }
+
+        context.runtime.spawn(run_scan(
+            state,
+            request,
+            discovery,
+            context.file_processor,
+            context.events,
+        ));
+
+        unsafe {
+            *batch = batch_id as *mut c_void;
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Map a walker setup error to an FFI result code
+fn discovery_error(error: DiscoveryError) -> AniDBResult {
+    match error {
+        DiscoveryError::PathNotFound(_) => AniDBResult::ErrorFileNotFound,
+        DiscoveryError::InvalidPattern(_) => AniDBResult::ErrorInvalidParameter,
+        DiscoveryError::Io(e) => match e.kind() {
+            std::io::ErrorKind::NotFound => AniDBResult::ErrorFileNotFound,
+            std::io::ErrorKind::PermissionDenied => AniDBResult::ErrorPermissionDenied,
+            _ => AniDBResult::ErrorIo,
+        },
+    }
+}
+
+/// Get the progress of a batch
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_batch_get_progress(
+    batch: *mut c_void,
+    completed: *mut usize,
+    total: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(completed) || !validate_mut_ptr(total) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let state = match get_batch(batch) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        unsafe {
+            *completed = state.completed_files.load(Ordering::Acquire);
+            *total = state.total_files();
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Get per-device progress of a batch
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_batch_get_device_stats(
+    batch: *mut c_void,
+    stats: *mut AniDBDeviceStats,
+    capacity: usize,
+    count: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(count) || (capacity > 0 && !validate_mut_ptr(stats)) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let state = match get_batch(batch) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        let devices = match state.devices.lock() {
+            Ok(d) => d,
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        for (i, device) in devices.iter().take(capacity).enumerate() {
+            let snapshot = device.snapshot();
+            unsafe {
+                stats.add(i).write(AniDBDeviceStats {
+                    device_id: snapshot.device,
+                    files_total: snapshot.files_total,
+                    files_completed: snapshot.files_completed,
+                    bytes_processed: snapshot.bytes_processed,
+                    throughput_mbps: snapshot.throughput_mbps,
+                });
+            }
+        }
+
+        unsafe {
+            *count = devices.len();
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Get the distinct files of a batch that share their size
+///
+/// Entries are sorted by size, so consecutive entries of equal size form
+/// one group. Paths collapsed into one job because they resolve to the same
+/// file are not collisions and appear once, under their first index.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_batch_get_size_collisions(
+    batch: *mut c_void,
+    collisions: *mut AniDBSizeCollision,
+    capacity: usize,
+    count: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(count) || (capacity > 0 && !validate_mut_ptr(collisions)) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let state = match get_batch(batch) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        let planned = match state.size_collisions.lock() {
+            Ok(c) => c,
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        for (i, collision) in planned.iter().take(capacity).enumerate() {
+            unsafe {
+                collisions.add(i).write(AniDBSizeCollision {
+                    file_size: collision.file_size,
+                    path_index: collision.path_index,
+                });
+            }
+        }
+
+        unsafe {
+            *count = planned.len();
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Get the result of a finished asynchronous batch
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_batch_get_result(
+    batch: *mut c_void,
+    result: *mut *mut AniDBBatchResult,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(result) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let state = match get_batch(batch) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        if !state.is_finished() {
+            return AniDBResult::ErrorBusy;
+        }
+
+        match build_batch_result(&state) {
+            Ok(batch_result) => {
+                unsafe {
+                    *result = batch_result;
+                }
+                AniDBResult::Success
+            }
+            Err(e) => e,
+        }
+    })
+}
+
+/// Cancel a batch
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_batch_cancel(batch: *mut c_void) -> AniDBResult {
+    ffi_catch_panic!({
+        let state = match get_batch(batch) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        if !state.is_finished() {
+            state.cancel_requested.store(true, Ordering::Release);
+            state.cancel();
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Destroy a batch handle, cancelling it if still running
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_batch_destroy(batch: *mut c_void) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(batch) {
+            return AniDBResult::ErrorInvalidHandle;
+        }
+
+        let batch_id = batch as usize;
+        if batch_id == 0 || batch_id > usize::MAX / 2 {
+            return AniDBResult::ErrorInvalidHandle;
+        }
+
+        let state = match BATCHES.write() {
+            Ok(mut batches) => match batches.remove(&batch_id) {
+                Some(s) => s,
+                None => return AniDBResult::ErrorInvalidHandle,
+            },
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        if !state.is_finished() {
+            state.cancel_requested.store(true, Ordering::Release);
+            state.cancel();
+        }
+
+        AniDBResult::Success
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::fs;
+    use tempfile::TempDir;
+
+    #[test]
+    fn test_plan_jobs_keeps_input_order_per_device() {
+        let temp_dir = TempDir::new().unwrap();
+        let paths: Vec<String> = (0..4)
+            .map(|i| {
+                let path = temp_dir.path().join(format!("file{i}.bin"));
+                fs::write(&path, b"data").unwrap();
+                path.to_string_lossy().into_owned()
+            })
+            .collect();
+
+        let queues = plan_jobs(&paths).queues;
+        assert_eq!(queues.len(), 1);
+        let indices: Vec<usize> =
+            queues[0].with_jobs(|jobs| jobs.iter().map(|j| j.index).collect());
+        assert_eq!(indices, vec![0, 1, 2, 3]);
+    }
+
+    #[test]
+    fn test_plan_jobs_collapses_paths_to_the_same_file() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("file.bin");
+        fs::write(&path, b"data").unwrap();
+        let link = temp_dir.path().join("link.bin");
+        fs::hard_link(&path, &link).unwrap();
+        let path_str = path.to_string_lossy().into_owned();
+        let paths = vec![
+            path_str.clone(),
+            link.to_string_lossy().into_owned(),
+            path_str,
+        ];
+
+        let plan = plan_jobs(&paths);
+        assert_eq!(plan.queues.iter().map(|q| q.len()).sum::<usize>(), 1);
+        let aliases = plan.queues[0]
+            .with_jobs(|jobs| jobs[0].aliases.iter().map(|a| a.index).collect::<Vec<_>>());
+        assert_eq!(aliases, vec![1, 2]);
+        // Aliases of one file are not size collisions
+        assert!(plan.size_collisions.is_empty());
+    }
+
+    #[test]
+    fn test_plan_jobs_reports_size_collisions() {
+        let temp_dir = TempDir::new().unwrap();
+        let sizes = [10usize, 20, 10, 30, 20, 10];
+        let mut paths: Vec<String> = sizes
+            .iter()
+            .enumerate()
+            .map(|(i, &size)| {
+                let path = temp_dir.path().join(format!("file{i}.bin"));
+                fs::write(&path, vec![i as u8; size]).unwrap();
+                path.to_string_lossy().into_owned()
+            })
+            .collect();
+        paths.push(
+            temp_dir
+                .path()
+                .join("missing.bin")
+                .to_string_lossy()
+                .into_owned(),
+        );
+
+        let collisions: Vec<(u64, usize)> = plan_jobs(&paths)
+            .size_collisions
+            .iter()
+            .map(|c| (c.file_size, c.path_index))
+            .collect();
+        assert_eq!(
+            collisions,
+            vec![(10, 0), (10, 2), (10, 5), (20, 1), (20, 4)]
+        );
+    }
+
+    #[test]
+    fn test_record_copies_outcome_to_aliases() {
+        let state = BatchState::new(vec!["a".into(), "b".into()], false);
+        let job = BatchJob {
+            index: 0,
+            path: PathBuf::from("a"),
+            aliases: vec![Alias {
+                index: 1,
+                path: PathBuf::from("b"),
+            }],
+            links: None,
+        };
+
+        let completed = state.record(&job, FileOutcome::Cancelled);
+        assert_eq!(completed, 2);
+        assert_eq!(state.failed_files.load(Ordering::Relaxed), 2);
+        let outcomes = state.outcomes.lock().unwrap();
+        assert!(outcomes.iter().all(|o| o.is_some()));
+    }
+
+    #[test]
+    fn test_streaming_batch_keeps_only_counters() {
+        let state = BatchState::new(vec!["a".into(), "b".into()], true);
+        let job = BatchJob {
+            index: 1,
+            path: PathBuf::from("b"),
+            aliases: Vec::new(),
+            links: None,
+        };
+
+        assert_eq!(state.record(&job, FileOutcome::Cancelled), 1);
+        assert!(state.outcomes.lock().unwrap().is_empty());
+
+        let summary = build_batch_result(&state).unwrap();
+        unsafe {
+            assert_eq!((*summary).total_files, 2);
+            assert_eq!((*summary).failed_files, 1);
+            assert!((*summary).results.is_null());
+        }
+        crate::ffi::anidb_free_batch_result(summary);
+    }
+}
@@ -0,0 +1,225 @@
+//! Hash cache management for FFI
+//!
+//! A client created with a cache directory or `enable_hash_cache` owns a
+//! [`HashCache`] that file processing consults before reading a file.
+//! These functions expose it so callers can see what a rescan will have to
+//! hash, in bulk for large libraries, and which new files are most likely
+//! copies of content hashed before. Without a cache they fail with
+//! `ErrorCache`.
+
+use crate::HashCache;
+use crate::cache::{FileIdentity, PrefilterStatus};
+use crate::ffi::handles::lookup_client;
+use crate::ffi::helpers::*;
+use crate::ffi::types::*;
+use crate::ffi_catch_panic;
+use std::ffi::{c_char, c_int, c_void};
+use std::sync::Arc;
+
+/// Look up the cache of a client handle
+fn get_cache(handle: *mut c_void) -> Result<Arc<HashCache>, AniDBResult> {
+    if !validate_mut_ptr(handle) {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    let client = lookup_client(handle)?;
+    client
+        .file_processor
+        .cache()
+        .cloned()
+        .ok_or(AniDBResult::ErrorCache)
+}
+
+/// Clear the hash cache
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_cache_clear(handle: *mut c_void) -> AniDBResult {
+    ffi_catch_panic!({
+        let cache = match get_cache(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        match cache.clear() {
+            Ok(()) => AniDBResult::Success,
+            Err(_) => AniDBResult::ErrorCache,
+        }
+    })
+}
+
+/// Get cache statistics
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_cache_get_stats(
+    handle: *mut c_void,
+    total_entries: *mut usize,
+    cache_size_bytes: *mut u64,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(total_entries) || !validate_mut_ptr(cache_size_bytes) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let cache = match get_cache(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        let stats = cache.stats();
+        unsafe {
+            *total_entries = stats.entries;
+            *cache_size_bytes = stats.size_bytes;
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Check if a file hash is in cache
+///
+/// Costs one `stat()` of the file; its contents are never read. A missing
+/// file is reported as not cached.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_cache_check_file(
+    handle: *mut c_void,
+    file_path: *const c_char,
+    algorithm: AniDBHashAlgorithm,
+    is_cached: *mut c_int,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_c_str(file_path) || !validate_mut_ptr(is_cached) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let file_path_str = match c_str_to_string(file_path) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+        let algorithm = match convert_hash_algorithm(algorithm) {
+            Ok(a) => a,
+            Err(e) => return e,
+        };
+        let cache = match get_cache(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        let cached = FileIdentity::from_path(file_path_str.as_ref())
+            .is_ok_and(|identity| cache.contains(&identity, algorithm));
+        unsafe {
+            *is_cached = c_int::from(cached);
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Check many files against the cache in one call
+///
+/// Writes 1 or 0 to `is_cached[i]` for each of the `count` paths. The
+/// whole list is parsed before any file is stat'ed, so an invalid path
+/// fails the call without writing any results.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_cache_check_files(
+    handle: *mut c_void,
+    file_paths: *const *const c_char,
+    count: usize,
+    algorithm: AniDBHashAlgorithm,
+    is_cached: *mut c_int,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if count > 0 && (!validate_ptr(file_paths) || !validate_mut_ptr(is_cached)) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let algorithm = match convert_hash_algorithm(algorithm) {
+            Ok(a) => a,
+            Err(e) => return e,
+        };
+        let cache = match get_cache(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        if count == 0 {
+            return AniDBResult::Success;
+        }
+
+        let raw_paths = unsafe { std::slice::from_raw_parts(file_paths, count) };
+        let mut paths = Vec::with_capacity(count);
+        for &raw_path in raw_paths {
+            if !validate_c_str(raw_path) {
+                return AniDBResult::ErrorInvalidParameter;
+            }
+            match c_str_to_string(raw_path) {
+                Ok(s) => paths.push(s),
+                Err(e) => return e,
+            }
+        }
+
+        let results = unsafe { std::slice::from_raw_parts_mut(is_cached, count) };
+        for (slot, cached) in results.iter_mut().zip(cache.check_files(&paths, algorithm)) {
+            *slot = c_int::from(cached);
+        }
+
+        AniDBResult::Success
+    })
+}
+
+/// Decide which of many files need a full hash
+///
+/// Writes one [`AniDBPrefilterResult`] to `results[i]` for each of the
+/// `count` paths. Files whose identity is not cached are fingerprinted
+/// from a few sampled blocks. The whole list is parsed before any file is
+/// read, so an invalid path fails the call without writing any results.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_cache_prefilter_files(
+    handle: *mut c_void,
+    file_paths: *const *const c_char,
+    count: usize,
+    results: *mut AniDBPrefilterResult,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if count > 0 && (!validate_ptr(file_paths) || !validate_mut_ptr(results)) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let cache = match get_cache(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        if count == 0 {
+            return AniDBResult::Success;
+        }
+
+        let raw_paths = unsafe { std::slice::from_raw_parts(file_paths, count) };
+        let mut paths = Vec::with_capacity(count);
+        for &raw_path in raw_paths {
+            if !validate_c_str(raw_path) {
+                return AniDBResult::ErrorInvalidParameter;
+            }
+            match c_str_to_string(raw_path) {
+                Ok(s) => paths.push(s),
+                Err(e) => return e,
+            }
+        }
+
+        let results = unsafe { std::slice::from_raw_parts_mut(results, count) };
+        for (slot, path) in results.iter_mut().zip(&paths) {
+            let prefilter = cache.prefilter(path.as_ref());
+            *slot = AniDBPrefilterResult {
+                status: match prefilter.status {
+                    PrefilterStatus::Unknown => AniDBPrefilterStatus::Unknown,
+                    PrefilterStatus::KnownIdentity => AniDBPrefilterStatus::KnownIdentity,
+                    PrefilterStatus::KnownContent => AniDBPrefilterStatus::KnownContent,
+                },
+                file_size: prefilter.file_size,
+                fingerprint: prefilter
+                    .fingerprint
+                    .map_or(0, |fingerprint| fingerprint.hash),
+                bytes_read: prefilter.bytes_read,
+            };
+        }
+
+        AniDBResult::Success
+    })
+}
@@ -3,7 +3,7 @@
 //! This module handles the registration, unregistration, and management
 //! of callbacks for the FFI layer.
 
-use crate::ffi::handles::{CLIENTS, CallbackRegistration};
+use crate::ffi::handles::{CallbackRegistration, lookup_client};
 use crate::ffi::helpers::validate_mut_ptr;
 use crate::ffi::types::{AniDBCallbackType, AniDBResult};
 use crate::ffi_catch_panic;
@@ -22,24 +22,7 @@ pub extern "C" fn anidb_register_callback(
         return 0;
     }
 
-    let handle_id = handle as usize;
-    if handle_id == 0 || handle_id > usize::MAX / 2 {
-        return 0;
-    }
-
-    let clients = match CLIENTS.read() {
-        Ok(c) => c,
-        Err(_) => return 0,
-    };
-
-    let client_arc = match clients.get(&handle_id) {
-        Some(c) => c.clone(),
-        None => return 0,
-    };
-
-    drop(clients);
-
-    let client = match client_arc.lock() {
+    let client = match lookup_client(handle) {
         Ok(c) => c,
         Err(_) => return 0,
     };
@@ -52,12 +35,8 @@ pub extern "C" fn anidb_register_callback(
         user_data,
     };
 
-    if let Ok(mut callbacks) = client.callbacks.lock() {
-        callbacks.insert(callback_id, registration);
-        callback_id
-    } else {
-        0
-    }
+    client.callbacks.insert(callback_id, registration);
+    callback_id
 }
 
 /// Unregister a callback
@@ -68,36 +47,15 @@ pub extern "C" fn anidb_unregister_callback(handle: *mut c_void, callback_id: u6
             return AniDBResult::ErrorInvalidParameter;
         }
 
-        let handle_id = handle as usize;
-        if handle_id == 0 || handle_id > usize::MAX / 2 {
-            return AniDBResult::ErrorInvalidHandle;
-        }
-
-        let clients = match CLIENTS.read() {
-            Ok(c) => c,
-            Err(_) => return AniDBResult::ErrorBusy,
-        };
-
-        let client_arc = match clients.get(&handle_id) {
-            Some(c) => c.clone(),
-            None => return AniDBResult::ErrorInvalidHandle,
-        };
-
-        drop(clients);
-
-        let client = match client_arc.lock() {
+        let client = match lookup_client(handle) {
             Ok(c) => c,
-            Err(_) => return AniDBResult::ErrorBusy,
+            Err(e) => return e,
         };
 
-        if let Ok(mut callbacks) = client.callbacks.lock() {
-            if callbacks.remove(&callback_id).is_some() {
-                AniDBResult::Success
-            } else {
-                AniDBResult::ErrorInvalidParameter
-            }
+        if client.callbacks.remove(callback_id) {
+            AniDBResult::Success
         } else {
-            AniDBResult::ErrorBusy
+            AniDBResult::ErrorInvalidParameter
         }
     })
 }
@@ -0,0 +1,531 @@
+//! Lock-free event ring in caller-owned memory
+//!
+//! `anidb_event_ring_attach` lays a ring out in memory the caller allocated
+//! (or mapped) and keeps. Library threads append events to it and a single
+//! consumer drains it with `anidb_event_ring_poll`, which takes no lock and
+//! never allocates.
+//!
+//! Every slot holds the event together with its strings (file path, hash or
+//! endpoint, then the context), so the pointers of a polled event point into
+//! the ring itself. Slots returned by a poll stay untouched until the next
+//! poll hands them back to the producers.
+//!
+//! Events come from any runtime worker, so producers reserve a slot with a
+//! compare-and-swap on the write cursor and publish it through the slot's
+//! sequence number. The consumer only loads and stores. When the ring is
+//! full the new event is dropped and counted.
+
+use crate::ffi::types::{AniDBEvent, AniDBEventData, AniDBEventType};
+use std::cell::UnsafeCell;
+use std::ffi::{c_char, c_void};
+use std::fmt;
+use std::mem::{align_of, size_of};
+use std::ptr::NonNull;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// Marks memory initialized by [`EventRing::init`] ("ADER")
+const RING_MAGIC: u32 = 0x4144_4552;
+
+/// Bytes of one slot, event and strings included
+pub(crate) const RING_SLOT_SIZE: usize = 1024;
+
+/// Bytes available for the strings of one event
+const SLOT_TEXT_BYTES: usize = RING_SLOT_SIZE - size_of::<AtomicU64>() - size_of::<AniDBEvent>();
+
+/// Bytes kept for the context when an event has one
+const CONTEXT_BYTES: usize = 256;
+
+/// Ring header, one cache line per party
+#[repr(C)]
+struct RingHeader {
+    magic: u32,
+    capacity: u32,
+    dropped: AtomicU64,
+    _pad0: [u8; 48],
+    /// Next position producers reserve
+    write: AtomicU64,
+    _pad1: [u8; 56],
+    /// Next position the consumer reads
+    read: AtomicU64,
+    /// Slots before `read` the consumer still holds
+    held: AtomicU64,
+    _pad2: [u8; 48],
+}
+
+#[repr(C)]
+struct RingSlot {
+    /// Equals the slot's position when free, position + 1 when published
+    sequence: AtomicU64,
+    event: UnsafeCell<AniDBEvent>,
+    text: UnsafeCell<[u8; SLOT_TEXT_BYTES]>,
+}
+
+const _: () = assert!(size_of::<RingHeader>() == 192);
+const _: () = assert!(size_of::<RingSlot>() == RING_SLOT_SIZE);
+
+/// Bit of `event_type` in an event type mask
+pub(crate) fn event_type_bit(event_type: AniDBEventType) -> u32 {
+    1 << (event_type as u32)
+}
+
+/// Bytes needed for a ring of `capacity` slots, or `None` when the capacity
+/// is not a power of two of at least 2
+///
+/// A single slot cannot work: its published sequence equals the next
+/// producer's position, which would reserve it again before it was read.
+pub(crate) fn ring_bytes(capacity: usize) -> Option<usize> {
+    if capacity < 2 || !capacity.is_power_of_two() || capacity > u32::MAX as usize {
+        return None;
+    }
+    capacity
+        .checked_mul(RING_SLOT_SIZE)?
+        .checked_add(size_of::<RingHeader>())
+}
+
+/// Producer side of a ring attached to a client
+pub(crate) struct EventRing {
+    base: NonNull<u8>,
+    capacity: u64,
+}
+
+// Slots are only written after being reserved through the atomic cursor
+unsafe impl Send for EventRing {}
+unsafe impl Sync for EventRing {}
+
+impl EventRing {
+    /// Lay out a ring in `len` bytes at `memory`
+    ///
+    /// Uses the largest power of two slots that fit. Returns `None` when the
+    /// memory is misaligned or too small for two slots.
+    ///
+    /// # Safety
+    ///
+    /// `memory` must be valid for writes of `len` bytes for as long as the
+    /// returned ring (and any consumer) uses it.
+    pub(crate) unsafe fn init(memory: *mut u8, len: usize) -> Option<Self> {
+        let base = NonNull::new(memory)?;
+        if !(memory as usize).is_multiple_of(align_of::<RingHeader>()) {
+            return None;
+        }
+        let slots = len.checked_sub(size_of::<RingHeader>())? / RING_SLOT_SIZE;
+        if slots < 2 {
+            return None;
+        }
+        let capacity = 1u64 << (usize::BITS - 1 - slots.leading_zeros()).min(31);
+
+        // SAFETY: the caller guarantees `len` writable bytes
+        unsafe {
+            std::ptr::write_bytes(memory, 0, size_of::<RingHeader>());
+            let header = &mut *(memory as *mut RingHeader);
+            header.magic = RING_MAGIC;
+            header.capacity = capacity as u32;
+        }
+        let ring = Self { base, capacity };
+        for position in 0..capacity {
+            ring.slot(position)
+                .sequence
+                .store(position, Ordering::Relaxed);
+        }
+        std::sync::atomic::fence(Ordering::Release);
+        Some(ring)
+    }
+
+    /// Number of slots
+    pub(crate) fn capacity(&self) -> usize {
+        self.capacity as usize
+    }
+
+    fn header(&self) -> &RingHeader {
+        // SAFETY: initialized in `init`
+        unsafe { &*(self.base.as_ptr() as *const RingHeader) }
+    }
+
+    fn slot(&self, position: u64) -> &RingSlot {
+        slot_at(self.base.as_ptr(), position & (self.capacity - 1))
+    }
+
+    /// Append an event, returning `false` when the ring was full
+    ///
+    /// `text` becomes the file path, hash value or endpoint of `data`,
+    /// according to the event type. Strings that do not fit the slot are
+    /// truncated.
+    pub(crate) fn push(
+        &self,
+        event_type: AniDBEventType,
+        timestamp: u64,
+        mut data: AniDBEventData,
+        text: Option<&str>,
+        context: Option<fmt::Arguments<'_>>,
+    ) -> bool {
+        let header = self.header();
+        let mut position = header.write.load(Ordering::Relaxed);
+        let slot = loop {
+            let slot = self.slot(position);
+            let sequence = slot.sequence.load(Ordering::Acquire);
+            match sequence.cmp(&position) {
+                std::cmp::Ordering::Equal => match header.write.compare_exchange_weak(
+                    position,
+                    position + 1,
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => break slot,
+                    Err(current) => position = current,
+                },
+                // Still holds an event from the previous lap
+                std::cmp::Ordering::Less => {
+                    header.dropped.fetch_add(1, Ordering::Relaxed);
+                    return false;
+                }
+                std::cmp::Ordering::Greater => position = header.write.load(Ordering::Relaxed),
+            }
+        };
+
+        // SAFETY: the slot was reserved above and is ours until published
+        unsafe {
+            let text_buf = &mut *slot.text.get();
+            let mut writer = SlotText {
+                buf: text_buf,
+                len: 0,
+                limit: 0,
+            };
+
+            let text_ptr = text.map(|text| {
+                let limit = if context.is_some() {
+                    SLOT_TEXT_BYTES - CONTEXT_BYTES
+                } else {
+                    SLOT_TEXT_BYTES
+                };
+                writer.terminated(limit, |w| w.push(text))
+            });
+            let context_ptr = context.map(|args| {
+                writer.terminated(SLOT_TEXT_BYTES, |w| {
+                    let _ = fmt::write(w, args);
+                })
+            });
+
+            let text_ptr = text_ptr.unwrap_or(std::ptr::null());
+            match event_type {
+                AniDBEventType::FileStart | AniDBEventType::FileComplete => {
+                    data.file.file_path = text_ptr
+                }
+                AniDBEventType::HashStart | AniDBEventType::HashComplete => {
+                    data.hash.hash_value = text_ptr
+                }
+                AniDBEventType::NetworkStart | AniDBEventType::NetworkComplete => {
+                    data.network.endpoint = text_ptr
+                }
+                AniDBEventType::MemoryWarning => {}
+            }
+
+            *slot.event.get() = AniDBEvent {
+                event_type,
+                timestamp,
+                data,
+                context: context_ptr.unwrap_or(std::ptr::null()),
+            };
+        }
+        slot.sequence.store(position + 1, Ordering::Release);
+        true
+    }
+}
+
+fn slot_at<'a>(base: *mut u8, index: u64) -> &'a RingSlot {
+    // SAFETY: callers pass an index below the ring capacity
+    unsafe {
+        &*(base
+            .add(size_of::<RingHeader>())
+            .add(index as usize * RING_SLOT_SIZE) as *const RingSlot)
+    }
+}
+
+/// Copy up to `events.len()` published events out of the ring at `memory`
+///
+/// Hands the slots returned by the previous call back to the producers
+/// first. Returns `None` when `memory` does not hold a ring.
+///
+/// # Safety
+///
+/// `memory` must point to memory passed to [`EventRing::init`], and only
+/// one thread may poll a ring at a time.
+pub(crate) unsafe fn poll_ring(memory: *mut c_void, events: &mut [AniDBEvent]) -> Option<usize> {
+    let base = memory as *mut u8;
+    // SAFETY: the caller passes ring memory; the magic check rejects others
+    let header = unsafe { &*(base as *const RingHeader) };
+    if header.magic != RING_MAGIC || header.capacity < 2 || !header.capacity.is_power_of_two() {
+        return None;
+    }
+    let capacity = header.capacity as u64;
+
+    let mut read = header.read.load(Ordering::Relaxed);
+    let held = header.held.load(Ordering::Relaxed);
+    for position in read - held..read {
+        slot_at(base, position & (capacity - 1))
+            .sequence
+            .store(position + capacity, Ordering::Release);
+    }
+
+    let mut count = 0;
+    while count < events.len() {
+        let slot = slot_at(base, read & (capacity - 1));
+        if slot.sequence.load(Ordering::Acquire) != read + 1 {
+            break;
+        }
+        // SAFETY: published slots are not written until handed back
+        events[count] = unsafe { *slot.event.get() };
+        count += 1;
+        read += 1;
+    }
+
+    header.read.store(read, Ordering::Relaxed);
+    header.held.store(count as u64, Ordering::Relaxed);
+    Some(count)
+}
+
+/// Events dropped because the ring at `memory` was full
+///
+/// # Safety
+///
+/// `memory` must point to memory passed to [`EventRing::init`].
+pub(crate) unsafe fn ring_dropped(memory: *const c_void) -> Option<u64> {
+    // SAFETY: the caller passes ring memory; the magic check rejects others
+    let header = unsafe { &*(memory as *const RingHeader) };
+    (header.magic == RING_MAGIC).then(|| header.dropped.load(Ordering::Relaxed))
+}
+
+/// Appends NUL-terminated strings to a slot's text area
+struct SlotText<'a> {
+    buf: &'a mut [u8; SLOT_TEXT_BYTES],
+    len: usize,
+    limit: usize,
+}
+
+impl SlotText<'_> {
+    /// Write one string ending before `limit` and return its address
+    fn terminated(&mut self, limit: usize, write: impl FnOnce(&mut Self)) -> *const c_char {
+        let start = self.len.min(SLOT_TEXT_BYTES - 1);
+        self.len = start;
+        self.limit = limit.max(start + 1) - 1;
+        write(self);
+        self.buf[self.len] = 0;
+        self.len += 1;
+        self.buf[start..].as_ptr() as *const c_char
+    }
+
+    /// Append as much of `s` as fits, cutting at a character boundary
+    fn push(&mut self, s: &str) {
+        let room = self.limit - self.len;
+        let mut take = s.len().min(room);
+        while !s.is_char_boundary(take) {
+            take -= 1;
+        }
+        // Embedded NULs would end the C string early
+        let bytes = &s.as_bytes()[..take];
+        let bytes = match bytes.iter().position(|&b| b == 0) {
+            Some(nul) => &bytes[..nul],
+            None => bytes,
+        };
+        self.buf[self.len..self.len + bytes.len()].copy_from_slice(bytes);
+        self.len += bytes.len();
+    }
+}
+
+impl fmt::Write for SlotText<'_> {
+    fn write_str(&mut self, s: &str) -> fmt::Result {
+        self.push(s);
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ffi::types::{FileEventData, MemoryEventData};
+    use std::ffi::CStr;
+
+    fn file_data() -> AniDBEventData {
+        AniDBEventData {
+            file: FileEventData {
+                file_path: std::ptr::null(),
+                file_size: 42,
+            },
+        }
+    }
+
+    fn memory(capacity: usize) -> Vec<u64> {
+        vec![0u64; ring_bytes(capacity).unwrap() / 8]
+    }
+
+    fn string(ptr: *const c_char) -> String {
+        unsafe { CStr::from_ptr(ptr) }.to_str().unwrap().to_string()
+    }
+
+    #[test]
+    fn test_strings_live_in_the_ring() {
+        let mut memory = memory(4);
+        let base = memory.as_mut_ptr() as *mut u8;
+        let ring = unsafe { EventRing::init(base, memory.len() * 8) }.unwrap();
+        assert_eq!(ring.capacity(), 4);
+
+        assert!(ring.push(
+            AniDBEventType::FileComplete,
+            7,
+            file_data(),
+            Some("/media/show.mkv"),
+            Some(format_args!("Processed in {}ms", 12)),
+        ));
+
+        let mut events = [AniDBEvent::default(); 8];
+        assert_eq!(
+            unsafe { poll_ring(base as *mut c_void, &mut events) },
+            Some(1)
+        );
+        let event = events[0];
+        assert_eq!(event.event_type, AniDBEventType::FileComplete);
+        assert_eq!(event.timestamp, 7);
+        let path = unsafe { event.data.file.file_path };
+        assert_eq!(string(path), "/media/show.mkv");
+        assert_eq!(unsafe { event.data.file.file_size }, 42);
+        assert_eq!(string(event.context), "Processed in 12ms");
+
+        let range = base as usize..base as usize + memory.len() * 8;
+        assert!(range.contains(&(path as usize)));
+        assert!(range.contains(&(event.context as usize)));
+    }
+
+    #[test]
+    fn test_full_ring_drops_until_polled() {
+        let mut memory = memory(2);
+        let base = memory.as_mut_ptr() as *mut u8;
+        let ring = unsafe { EventRing::init(base, memory.len() * 8) }.unwrap();
+        let push = |n: u64| {
+            ring.push(
+                AniDBEventType::MemoryWarning,
+                n,
+                AniDBEventData {
+                    memory: MemoryEventData {
+                        current_usage: n,
+                        max_usage: 0,
+                    },
+                },
+                None,
+                None,
+            )
+        };
+
+        assert!(push(1) && push(2));
+        assert!(!push(3));
+        assert_eq!(unsafe { ring_dropped(base as *const c_void) }, Some(1));
+
+        // Polled slots stay held until the next poll
+        let mut events = [AniDBEvent::default(); 2];
+        assert_eq!(
+            unsafe { poll_ring(base as *mut c_void, &mut events) },
+            Some(2)
+        );
+        assert!(!push(4));
+        assert_eq!(
+            unsafe { poll_ring(base as *mut c_void, &mut events) },
+            Some(0)
+        );
+        assert!(push(5));
+        assert_eq!(
+            unsafe { poll_ring(base as *mut c_void, &mut events) },
+            Some(1)
+        );
+        assert_eq!(events[0].timestamp, 5);
+    }
+
+    #[test]
+    fn test_smallest_ring_keeps_unread_events() {
+        let mut memory = memory(2);
+        let base = memory.as_mut_ptr() as *mut u8;
+        let ring = unsafe { EventRing::init(base, memory.len() * 8) }.unwrap();
+        assert_eq!(ring.capacity(), 2);
+        let push = |n: u64| ring.push(AniDBEventType::FileStart, n, file_data(), None, None);
+
+        // The second push must not reserve the first, still unread, slot
+        let pushed = [push(1), push(2)];
+        let mut events = [AniDBEvent::default(); 2];
+        let polled = unsafe { poll_ring(base as *mut c_void, &mut events) }.unwrap();
+        let dropped = unsafe { ring_dropped(base as *const c_void) }.unwrap();
+
+        assert!(pushed[0]);
+        assert_eq!(polled as u64 + dropped, 2);
+        assert_eq!(pushed[1], dropped == 0);
+        let timestamps: Vec<u64> = events[..polled].iter().map(|e| e.timestamp).collect();
+        assert_eq!(timestamps, [1, 2][..polled]);
+    }
+
+    #[test]
+    fn test_long_strings_are_truncated() {
+        let mut memory = memory(2);
+        let base = memory.as_mut_ptr() as *mut u8;
+        let ring = unsafe { EventRing::init(base, memory.len() * 8) }.unwrap();
+        let path = "é".repeat(SLOT_TEXT_BYTES);
+        assert!(ring.push(
+            AniDBEventType::FileStart,
+            0,
+            file_data(),
+            Some(&path),
+            Some(format_args!("{}", "context")),
+        ));
+
+        let mut events = [AniDBEvent::default(); 1];
+        unsafe { poll_ring(base as *mut c_void, &mut events) };
+        let polled = string(unsafe { events[0].data.file.file_path });
+        assert!(polled.len() < SLOT_TEXT_BYTES - CONTEXT_BYTES);
+        assert!(path.starts_with(&polled));
+        assert_eq!(string(events[0].context), "context");
+    }
+
+    #[test]
+    fn test_rejects_unusable_memory() {
+        assert_eq!(ring_bytes(3), None);
+        assert_eq!(ring_bytes(1), None);
+        assert_eq!(ring_bytes(0), None);
+        let mut memory = memory(2);
+        let base = memory.as_mut_ptr() as *mut u8;
+        assert!(unsafe { EventRing::init(base, ring_bytes(2).unwrap() - 1) }.is_none());
+        assert!(unsafe { EventRing::init(base.add(1), ring_bytes(2).unwrap() - 8) }.is_none());
+        assert_eq!(unsafe { poll_ring(base as *mut c_void, &mut []) }, None);
+    }
+
+    #[test]
+    fn test_concurrent_producers() {
+        let mut memory = memory(64);
+        let base = memory.as_mut_ptr() as *mut u8;
+        let ring = unsafe { EventRing::init(base, memory.len() * 8) }.unwrap();
+        let base_addr = base as usize;
+
+        let mut seen = 0;
+        std::thread::scope(|scope| {
+            for thread in 0..4 {
+                let ring = &ring;
+                scope.spawn(move || {
+                    for i in 0..500u64 {
+                        while !ring.push(
+                            AniDBEventType::FileStart,
+                            thread * 1000 + i,
+                            file_data(),
+                            Some("path"),
+                            None,
+                        ) {
+                            std::thread::yield_now();
+                        }
+                    }
+                });
+            }
+
+            let mut events = [AniDBEvent::default(); 16];
+            while seen < 2000 {
+                let n = unsafe { poll_ring(base_addr as *mut c_void, &mut events) }.unwrap();
+                for event in &events[..n] {
+                    assert_eq!(string(unsafe { event.data.file.file_path }), "path");
+                }
+                seen += n;
+            }
+        });
+        assert_eq!(seen, 2000);
+    }
+}
@@ -2,40 +2,63 @@
 //!
 //! This module manages the event system including event creation,
 //! queueing, callbacks, and event polling functionality.
+//!
+//! Events reach three kinds of subscribers: the internal queue drained by
+//! `anidb_event_poll`, the connected callback, and an optional lock-free
+//! ring in caller memory (see [`event_ring`]). Each carries its own event
+//! type mask, and an event nobody subscribed to is never built. The
+//! callback subscribes only while connected, and the queue once the caller
+//! polls or sets its mask, or while the callback is connected.
+//!
+//! [`event_ring`]: crate::ffi::event_ring
 
-use crate::ffi::handles::{CLIENTS, ClientState, EventEntry};
-use crate::ffi::helpers::{get_timestamp_ms, validate_mut_ptr};
+use crate::ffi::event_ring::{EventRing, event_type_bit, poll_ring, ring_bytes, ring_dropped};
+use crate::ffi::handles::{ClientState, EventEntry, client_context, lookup_client};
+use crate::ffi::helpers::{get_timestamp_ms, validate_mut_ptr, validate_ptr};
 use crate::ffi::types::{
-    AniDBEvent, AniDBEventCallback, AniDBEventData, AniDBEventType, AniDBHashAlgorithm,
-    AniDBResult, FileEventData, HashEventData, MemoryEventData,
+    AniDBEvent, AniDBEventCallback, AniDBEventData, AniDBEventType, AniDBResult, FileEventData,
+    MemoryEventData,
 };
 use crate::ffi_catch_panic;
+use std::collections::VecDeque;
 use std::ffi::{CString, c_void};
+use std::fmt;
 use std::ptr;
+use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::{Arc, Mutex, RwLock};
 use tokio::sync::mpsc;
 
-/// Create a file event
-pub(crate) fn create_file_event(
+/// Event type mask selecting every event
+pub const ANIDB_EVENT_MASK_ALL: u32 = u32::MAX;
+
+/// Build a queue entry owning the strings its event points to
+fn create_event(
     event_type: AniDBEventType,
-    file_path: &str,
-    file_size: u64,
+    timestamp: u64,
+    mut data: AniDBEventData,
+    text: Option<&str>,
     context: Option<&str>,
 ) -> EventEntry {
-    let file_path_cstring = CString::new(file_path).ok();
+    let text_cstring = text.and_then(|s| CString::new(s).ok());
     let context_cstring = context.and_then(|s| CString::new(s).ok());
 
+    let text_ptr = text_cstring
+        .as_ref()
+        .map(|s| s.as_ptr())
+        .unwrap_or(ptr::null());
+    match event_type {
+        AniDBEventType::FileStart | AniDBEventType::FileComplete => data.file.file_path = text_ptr,
+        AniDBEventType::HashStart | AniDBEventType::HashComplete => data.hash.hash_value = text_ptr,
+        AniDBEventType::NetworkStart | AniDBEventType::NetworkComplete => {
+            data.network.endpoint = text_ptr
+        }
+        AniDBEventType::MemoryWarning => {}
+    }
+
     let event = AniDBEvent {
         event_type,
-        timestamp: get_timestamp_ms(),
-        data: AniDBEventData {
-            file: FileEventData {
-                file_path: file_path_cstring
-                    .as_ref()
-                    .map(|s| s.as_ptr())
-                    .unwrap_or(ptr::null()),
-                file_size,
-            },
-        },
+        timestamp,
+        data,
         context: context_cstring
             .as_ref()
             .map(|s| s.as_ptr())
@@ -44,107 +67,174 @@ pub(crate) fn create_file_event(
 
     EventEntry {
         event,
-        file_path: file_path_cstring,
-        hash_value: None,
-        endpoint: None,
+        text: text_cstring,
         context: context_cstring,
     }
 }
 
-/// Create a hash event
-#[allow(dead_code)]
-pub(crate) fn create_hash_event(
-    event_type: AniDBEventType,
-    algorithm: AniDBHashAlgorithm,
-    hash_value: Option<&str>,
-    context: Option<&str>,
-) -> EventEntry {
-    let hash_value_cstring = hash_value.and_then(|s| CString::new(s).ok());
-    let context_cstring = context.and_then(|s| CString::new(s).ok());
+/// Event type masks of a client's subscribers and its attached ring
+pub(crate) struct EventSubscriptions {
+    /// Types delivered to the queue drained by `anidb_event_poll`
+    queue_mask: AtomicU32,
+    /// Whether the caller polled the queue or set its mask
+    queue_used: AtomicBool,
+    /// Types delivered to the connected callback
+    callback_mask: AtomicU32,
+    /// Whether a callback is connected
+    callback_connected: AtomicBool,
+    /// Types written to the ring; zero while none is attached
+    ring_mask: AtomicU32,
+    ring: RwLock<Option<EventRing>>,
+}
 
-    let event = AniDBEvent {
-        event_type,
-        timestamp: get_timestamp_ms(),
-        data: AniDBEventData {
-            hash: HashEventData {
-                algorithm,
-                hash_value: hash_value_cstring
-                    .as_ref()
-                    .map(|s| s.as_ptr())
-                    .unwrap_or(ptr::null()),
-            },
-        },
-        context: context_cstring
-            .as_ref()
-            .map(|s| s.as_ptr())
-            .unwrap_or(ptr::null()),
-    };
+impl Default for EventSubscriptions {
+    fn default() -> Self {
+        Self {
+            queue_mask: AtomicU32::new(ANIDB_EVENT_MASK_ALL),
+            queue_used: AtomicBool::new(false),
+            callback_mask: AtomicU32::new(ANIDB_EVENT_MASK_ALL),
+            callback_connected: AtomicBool::new(false),
+            ring_mask: AtomicU32::new(0),
+            ring: RwLock::new(None),
+        }
+    }
+}
 
-    EventEntry {
-        event,
-        file_path: None,
-        hash_value: hash_value_cstring,
-        endpoint: None,
-        context: context_cstring,
+impl EventSubscriptions {
+    /// Replace the attached ring, waiting for producers still writing to
+    /// the previous one
+    pub(crate) fn set_ring(&self, ring: Option<EventRing>, mask: u32) {
+        self.ring_mask.store(0, Ordering::Relaxed);
+        if let Ok(mut current) = self.ring.write() {
+            let attached = ring.is_some();
+            *current = ring;
+            if attached {
+                self.ring_mask.store(mask, Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Types of events somebody reads from the queue
+    fn queue_mask(&self) -> u32 {
+        if self.queue_used.load(Ordering::Relaxed)
+            || self.callback_connected.load(Ordering::Relaxed)
+        {
+            self.queue_mask.load(Ordering::Relaxed)
+        } else {
+            0
+        }
+    }
+
+    /// Types of events delivered to a connected callback
+    fn callback_mask(&self) -> u32 {
+        if self.callback_connected.load(Ordering::Relaxed) {
+            self.callback_mask.load(Ordering::Relaxed)
+        } else {
+            0
+        }
     }
 }
 
-/// Create a memory event
-pub(crate) fn create_memory_event(
-    current_usage: u64,
-    max_usage: u64,
-    context: Option<&str>,
-) -> EventEntry {
-    let context_cstring = context.and_then(|s| CString::new(s).ok());
+/// Cloneable event emitter that does not require holding the client lock
+///
+/// Long-running work (batches, async operations) captures one of these so
+/// events can be published from runtime worker threads.
+#[derive(Clone)]
+pub(crate) struct EventSink {
+    queue: Arc<Mutex<VecDeque<EventEntry>>>,
+    sender: Arc<Mutex<Option<mpsc::UnboundedSender<EventEntry>>>>,
+    subscriptions: Arc<EventSubscriptions>,
+}
 
-    let event = AniDBEvent {
-        event_type: AniDBEventType::MemoryWarning,
-        timestamp: get_timestamp_ms(),
-        data: AniDBEventData {
+impl EventSink {
+    /// Create a sink publishing to the given client's queue and callback
+    pub(crate) fn from_client(client: &ClientState) -> Self {
+        Self {
+            queue: client.event_queue.clone(),
+            sender: client.event_sender.clone(),
+            subscriptions: client.event_subscriptions.clone(),
+        }
+    }
+
+    /// Publish a file event
+    pub(crate) fn file_event(
+        &self,
+        event_type: AniDBEventType,
+        file_path: &str,
+        file_size: u64,
+        context: Option<fmt::Arguments<'_>>,
+    ) {
+        let data = AniDBEventData {
+            file: FileEventData {
+                file_path: ptr::null(),
+                file_size,
+            },
+        };
+        self.publish(event_type, data, Some(file_path), context);
+    }
+
+    /// Publish a memory warning
+    pub(crate) fn memory_event(&self, current_usage: u64, max_usage: u64, context: &str) {
+        let data = AniDBEventData {
             memory: MemoryEventData {
                 current_usage,
                 max_usage,
             },
-        },
-        context: context_cstring
-            .as_ref()
-            .map(|s| s.as_ptr())
-            .unwrap_or(ptr::null()),
-    };
-
-    EventEntry {
-        event,
-        file_path: None,
-        hash_value: None,
-        endpoint: None,
-        context: context_cstring,
+        };
+        self.publish(
+            AniDBEventType::MemoryWarning,
+            data,
+            None,
+            Some(format_args!("{context}")),
+        );
     }
-}
 
-/// Send event to event queue and callback
-pub(crate) fn send_event(client: &ClientState, event_entry: EventEntry) {
-    // Clone for the queue
-    let queue_entry = EventEntry {
-        event: event_entry.event.clone(),
-        file_path: event_entry.file_path.clone(),
-        hash_value: event_entry.hash_value.clone(),
-        endpoint: event_entry.endpoint.clone(),
-        context: event_entry.context.clone(),
-    };
+    /// Deliver an event to every subscriber whose mask selects its type
+    fn publish(
+        &self,
+        event_type: AniDBEventType,
+        data: AniDBEventData,
+        text: Option<&str>,
+        context: Option<fmt::Arguments<'_>>,
+    ) {
+        let bit = event_type_bit(event_type);
+        let to_ring = self.subscriptions.ring_mask.load(Ordering::Relaxed) & bit != 0;
+        let to_queue = self.subscriptions.queue_mask() & bit != 0;
+        let to_callback = self.subscriptions.callback_mask() & bit != 0;
+        if !to_ring && !to_queue && !to_callback {
+            return;
+        }
+
+        let timestamp = get_timestamp_ms();
+        if to_ring
+            && let Ok(ring) = self.subscriptions.ring.read()
+            && let Some(ring) = ring.as_ref()
+        {
+            ring.push(event_type, timestamp, data, text, context);
+        }
+        if !to_queue && !to_callback {
+            return;
+        }
+
+        // Each destination owns its copy of the strings
+        let context = context.map(|args| args.to_string());
+        let entry = || create_event(event_type, timestamp, data, text, context.as_deref());
 
-    // Add to queue
-    if let Ok(mut queue) = client.event_queue.lock() {
         // Limit queue size to prevent unbounded growth
-        if queue.len() < 10000 {
-            queue.push_back(queue_entry);
+        if to_queue
+            && let Ok(mut queue) = self.queue.lock()
+            && queue.len() < 10000
+        {
+            queue.push_back(entry());
         }
-    }
 
-    // Send to event thread if connected
-    if let Ok(sender_opt) = client.event_sender.lock()
-        && let Some(sender) = sender_opt.as_ref()
-    {
-        let _ = sender.send(event_entry);
+        // Send to event thread if connected
+        if to_callback
+            && let Ok(sender_opt) = self.sender.lock()
+            && let Some(sender) = sender_opt.as_ref()
+        {
+            let _ = sender.send(entry());
+        }
     }
 }
 
@@ -160,32 +250,23 @@ pub extern "C" fn anidb_event_connect(
             return AniDBResult::ErrorInvalidParameter;
         }
 
-        let handle_id = handle as usize;
-        if handle_id == 0 || handle_id > usize::MAX / 2 {
-            return AniDBResult::ErrorInvalidHandle;
-        }
-
-        let clients = match CLIENTS.read() {
+        let client = match lookup_client(handle) {
             Ok(c) => c,
-            Err(_) => return AniDBResult::ErrorBusy,
+            Err(e) => return e,
         };
 
-        let client_arc = match clients.get(&handle_id) {
-            Some(c) => c.clone(),
-            None => return AniDBResult::ErrorInvalidHandle,
-        };
-
-        drop(clients);
-
-        let client = match client_arc.lock() {
-            Ok(c) => c,
+        // Held throughout, so concurrent connects and disconnects take turns
+        let mut thread_handle = match client.event_thread_handle.lock() {
+            Ok(h) => h,
             Err(_) => return AniDBResult::ErrorBusy,
         };
 
         // Stop existing event thread if any
-        if let Ok(mut thread_handle) = client.event_thread_handle.lock()
-            && let Some(handle) = thread_handle.take()
-        {
+        let subscriptions = &client.event_subscriptions;
+        subscriptions
+            .callback_connected
+            .store(false, Ordering::Relaxed);
+        if let Some(handle) = thread_handle.take() {
             // Signal thread to stop by dropping sender
             if let Ok(mut sender) = client.event_sender.lock() {
                 sender.take();
@@ -210,7 +291,7 @@ pub extern "C" fn anidb_event_connect(
 
         // Spawn event thread
         let event_callback_arc = client.event_callback.clone();
-        let thread_handle = std::thread::spawn(move || {
+        let event_thread = std::thread::spawn(move || {
             while let Some(event_entry) = rx.blocking_recv() {
                 if let Ok(callback_opt) = event_callback_arc.lock()
                     && let Some((callback_fn, user_data_usize)) = *callback_opt
@@ -225,9 +306,12 @@ pub extern "C" fn anidb_event_connect(
         });
 
         // Store thread handle
-        if let Ok(mut thread_handle_guard) = client.event_thread_handle.lock() {
-            *thread_handle_guard = Some(thread_handle);
-        }
+        *thread_handle = Some(event_thread);
+
+        // Events are built for the callback from now on
+        subscriptions
+            .callback_connected
+            .store(true, Ordering::Relaxed);
 
         AniDBResult::Success
     })
@@ -241,32 +325,22 @@ pub extern "C" fn anidb_event_disconnect(handle: *mut c_void) -> AniDBResult {
             return AniDBResult::ErrorInvalidParameter;
         }
 
-        let handle_id = handle as usize;
-        if handle_id == 0 || handle_id > usize::MAX / 2 {
-            return AniDBResult::ErrorInvalidHandle;
-        }
-
-        let clients = match CLIENTS.read() {
+        let client = match lookup_client(handle) {
             Ok(c) => c,
-            Err(_) => return AniDBResult::ErrorBusy,
-        };
-
-        let client_arc = match clients.get(&handle_id) {
-            Some(c) => c.clone(),
-            None => return AniDBResult::ErrorInvalidHandle,
+            Err(e) => return e,
         };
 
-        drop(clients);
-
-        let client = match client_arc.lock() {
-            Ok(c) => c,
+        let mut thread_handle = match client.event_thread_handle.lock() {
+            Ok(h) => h,
             Err(_) => return AniDBResult::ErrorBusy,
         };
 
-        // Stop event thread
-        if let Ok(mut thread_handle) = client.event_thread_handle.lock()
-            && let Some(handle) = thread_handle.take()
-        {
+        // Stop building events for the callback, then stop its thread
+        client
+            .event_subscriptions
+            .callback_connected
+            .store(false, Ordering::Relaxed);
+        if let Some(handle) = thread_handle.take() {
             // Signal thread to stop by dropping sender
             if let Ok(mut sender) = client.event_sender.lock() {
                 sender.take();
@@ -305,28 +379,26 @@ pub extern "C" fn anidb_event_poll(
             return AniDBResult::ErrorInvalidParameter;
         }
 
-        let handle_id = handle as usize;
-        if handle_id == 0 || handle_id > usize::MAX / 2 {
-            return AniDBResult::ErrorInvalidHandle;
-        }
-
-        let clients = match CLIENTS.read() {
+        let client = match lookup_client(handle) {
             Ok(c) => c,
-            Err(_) => return AniDBResult::ErrorBusy,
-        };
-
-        let client_arc = match clients.get(&handle_id) {
-            Some(c) => c.clone(),
-            None => return AniDBResult::ErrorInvalidHandle,
+            Err(e) => return e,
         };
 
-        drop(clients);
+        // Somebody reads the queue, so later events are queued
+        client
+            .event_subscriptions
+            .queue_used
+            .store(true, Ordering::Relaxed);
 
-        let client = match client_arc.lock() {
-            Ok(c) => c,
+        // Held throughout, so concurrent polls take turns
+        let mut polled = match client.event_polled.lock() {
+            Ok(p) => p,
             Err(_) => return AniDBResult::ErrorBusy,
         };
 
+        // Strings of the previous poll are released only now
+        polled.clear();
+
         let mut count = 0;
         if let Ok(mut queue) = client.event_queue.lock() {
             let events_slice = unsafe { std::slice::from_raw_parts_mut(events, max_events) };
@@ -334,6 +406,7 @@ pub extern "C" fn anidb_event_poll(
             while count < max_events && !queue.is_empty() {
                 if let Some(event_entry) = queue.pop_front() {
                     events_slice[count] = event_entry.event;
+                    polled.push(event_entry);
                     count += 1;
                 }
             }
@@ -346,3 +419,152 @@ pub extern "C" fn anidb_event_poll(
         AniDBResult::Success
     })
 }
+
+/// Store `type_mask` into one of a client's subscriber masks
+fn set_subscriber_mask(
+    handle: *mut c_void,
+    type_mask: u32,
+    mask: fn(&EventSubscriptions) -> &AtomicU32,
+) -> AniDBResult {
+    if !validate_mut_ptr(handle) {
+        return AniDBResult::ErrorInvalidParameter;
+    }
+
+    let context = match client_context(handle) {
+        Ok(c) => c,
+        Err(e) => return e,
+    };
+    mask(&context.events.subscriptions).store(type_mask, Ordering::Relaxed);
+    AniDBResult::Success
+}
+
+/// Select the event types delivered to the queue drained by `anidb_event_poll`
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_event_set_mask(handle: *mut c_void, type_mask: u32) -> AniDBResult {
+    ffi_catch_panic!(set_subscriber_mask(handle, type_mask, |s| {
+        s.queue_used.store(true, Ordering::Relaxed);
+        &s.queue_mask
+    }))
+}
+
+/// Select the event types delivered to the connected callback
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_event_set_callback_mask(
+    handle: *mut c_void,
+    type_mask: u32,
+) -> AniDBResult {
+    ffi_catch_panic!(set_subscriber_mask(handle, type_mask, |s| &s.callback_mask))
+}
+
+/// Bytes of memory needed for an event ring of `capacity` slots
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_event_ring_size(capacity: usize) -> usize {
+    ring_bytes(capacity).unwrap_or(0)
+}
+
+/// Lay out an event ring in caller memory and publish events to it
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_event_ring_attach(
+    handle: *mut c_void,
+    memory: *mut c_void,
+    memory_size: usize,
+    type_mask: u32,
+    capacity: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(handle) || !validate_mut_ptr(memory) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        // Stop writing to the old ring before the memory is reused
+        let subscriptions = &context.events.subscriptions;
+        subscriptions.set_ring(None, 0);
+
+        let ring = match unsafe { EventRing::init(memory as *mut u8, memory_size) } {
+            Some(ring) => ring,
+            None => return AniDBResult::ErrorInvalidParameter,
+        };
+        if validate_mut_ptr(capacity) {
+            unsafe {
+                *capacity = ring.capacity();
+            }
+        }
+        subscriptions.set_ring(Some(ring), type_mask);
+        AniDBResult::Success
+    })
+}
+
+/// Stop publishing events to the attached ring
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_event_ring_detach(handle: *mut c_void) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(handle) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+        context.events.subscriptions.set_ring(None, 0);
+        AniDBResult::Success
+    })
+}
+
+/// Take events from an event ring
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_event_ring_poll(
+    ring: *mut c_void,
+    events: *mut AniDBEvent,
+    max_events: usize,
+    event_count: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(ring)
+            || !validate_mut_ptr(event_count)
+            || (max_events > 0 && !validate_mut_ptr(events))
+        {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let events_slice = if max_events > 0 {
+            unsafe { std::slice::from_raw_parts_mut(events, max_events) }
+        } else {
+            &mut []
+        };
+        match unsafe { poll_ring(ring, events_slice) } {
+            Some(count) => {
+                unsafe {
+                    *event_count = count;
+                }
+                AniDBResult::Success
+            }
+            None => AniDBResult::ErrorInvalidParameter,
+        }
+    })
+}
+
+/// Number of events dropped because an event ring was full
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_event_ring_dropped(ring: *const c_void, dropped: *mut u64) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_ptr(ring) || !validate_mut_ptr(dropped) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        match unsafe { ring_dropped(ring) } {
+            Some(count) => {
+                unsafe {
+                    *dropped = count;
+                }
+                AniDBResult::Success
+            }
+            None => AniDBResult::ErrorInvalidParameter,
+        }
+    })
+}
@@ -1,22 +1,35 @@
 //! Handle registry and lifecycle management for FFI
 //!
 //! This module manages the lifecycle of FFI handles, including client,
-//! operation, and batch states with their associated registries.
+//! operation, batch and hasher states with their associated registries.
 
-use crate::ffi::helpers::{c_str_to_string, generate_handle_id, validate_mut_ptr, validate_ptr};
+use crate::ffi::events::{EventSink, EventSubscriptions};
+use crate::ffi::helpers::{
+    c_str_to_string, convert_io_mode, generate_handle_id, validate_mut_ptr, validate_ptr,
+};
+use crate::ffi::identify::Identifier;
+use crate::ffi::memory::{MAX_MEMORY_LIMIT, MIN_MEMORY_LIMIT, apply_memory_limit};
+use crate::ffi::progress::ProgressCell;
 use crate::ffi::types::{
-    AniDBCallbackType, AniDBConfig, AniDBEvent, AniDBEventCallback, AniDBResult, AniDBStatus,
+    AniDBCallbackType, AniDBConfig, AniDBEvent, AniDBEventCallback, AniDBHashAlgorithm,
+    AniDBOperationCallback, AniDBResult, AniDBStatus,
 };
 use crate::ffi_catch_panic;
-use crate::{ClientConfig, Error, FileProcessor};
+use crate::hashing::MultiHasher;
+use crate::scheduler::DeviceStats;
+use crate::{ClientConfig, FileProcessor, HashCache};
+use std::cell::RefCell;
 use std::collections::{HashMap, VecDeque};
 use std::ffi::{CString, c_void};
-use std::sync::atomic::{AtomicU64, AtomicUsize};
-use std::sync::{Arc, Mutex, RwLock};
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Condvar, Mutex, RwLock, Weak};
+use std::time::{Duration, Instant};
 use tokio::runtime::Runtime;
-use tokio::sync::mpsc;
+use tokio::sync::{mpsc, watch};
 
 /// Callback registration information
+#[derive(Clone, Copy)]
 pub(crate) struct CallbackRegistration {
     pub callback_type: AniDBCallbackType,
     pub callback_ptr: *mut c_void,
@@ -27,16 +40,68 @@ pub(crate) struct CallbackRegistration {
 unsafe impl Send for CallbackRegistration {}
 unsafe impl Sync for CallbackRegistration {}
 
+/// Callbacks registered with a client, published as immutable snapshots
+///
+/// Progress callbacks are looked up on every update while registration is
+/// rare, so writers copy the list and swap it in; readers only clone the
+/// current `Arc` and invoke callbacks without holding any lock.
+#[derive(Default)]
+pub(crate) struct CallbackTable {
+    current: RwLock<Arc<Vec<(u64, CallbackRegistration)>>>,
+    progress_count: AtomicUsize,
+}
+
+impl CallbackTable {
+    /// The callbacks registered right now
+    pub fn snapshot(&self) -> Arc<Vec<(u64, CallbackRegistration)>> {
+        self.current
+            .read()
+            .unwrap_or_else(|poisoned| poisoned.into_inner())
+            .clone()
+    }
+
+    /// Whether any progress callback is registered, without locking
+    pub fn has_progress(&self) -> bool {
+        self.progress_count.load(Ordering::Acquire) > 0
+    }
+
+    pub fn insert(&self, callback_id: u64, registration: CallbackRegistration) {
+        self.update(|entries| entries.push((callback_id, registration)));
+    }
+
+    /// Remove a registration, returning whether it existed
+    pub fn remove(&self, callback_id: u64) -> bool {
+        let mut removed = false;
+        self.update(|entries| {
+            let before = entries.len();
+            entries.retain(|(id, _)| *id != callback_id);
+            removed = entries.len() != before;
+        });
+        removed
+    }
+
+    fn update(&self, change: impl FnOnce(&mut Vec<(u64, CallbackRegistration)>)) {
+        let mut current = self
+            .current
+            .write()
+            .unwrap_or_else(|poisoned| poisoned.into_inner());
+        let mut entries = current.as_ref().clone();
+        change(&mut entries);
+        let progress = entries
+            .iter()
+            .filter(|(_, reg)| reg.callback_type == AniDBCallbackType::Progress)
+            .count();
+        *current = Arc::new(entries);
+        self.progress_count.store(progress, Ordering::Release);
+    }
+}
+
 /// Event queue entry
 pub(crate) struct EventEntry {
     pub event: AniDBEvent,
     // Store owned strings to ensure they remain valid
     #[allow(dead_code)]
-    pub file_path: Option<CString>,
-    #[allow(dead_code)]
-    pub hash_value: Option<CString>,
-    #[allow(dead_code)]
-    pub endpoint: Option<CString>,
+    pub text: Option<CString>,
     #[allow(dead_code)]
     pub context: Option<CString>,
 }
@@ -45,17 +110,23 @@ pub(crate) struct EventEntry {
 unsafe impl Send for EventEntry {}
 
 /// Internal client state
+///
+/// Shared by every thread calling into the client. Configuration and
+/// resources are fixed at creation; everything that changes afterwards has
+/// its own lock, so concurrent calls on one handle never wait on each other
+/// for the client as a whole.
 pub(crate) struct ClientState {
     #[allow(dead_code)]
     pub config: ClientConfig,
     pub file_processor: Arc<FileProcessor>,
+    pub identifier: Arc<Identifier>,
     pub runtime: Arc<Runtime>,
-    pub last_error: Option<String>,
+    pub last_error: Mutex<Option<String>>,
     #[allow(dead_code)]
     pub reference_count: AtomicUsize,
 
     // Callback management
-    pub callbacks: Arc<Mutex<HashMap<u64, CallbackRegistration>>>,
+    pub callbacks: Arc<CallbackTable>,
     pub next_callback_id: Arc<AtomicU64>,
 
     // Event system
@@ -63,30 +134,167 @@ pub(crate) struct ClientState {
     pub event_queue: Arc<Mutex<VecDeque<EventEntry>>>,
     pub event_thread_handle: Arc<Mutex<Option<std::thread::JoinHandle<()>>>>,
     pub event_sender: Arc<Mutex<Option<mpsc::UnboundedSender<EventEntry>>>>,
+    pub event_subscriptions: Arc<EventSubscriptions>,
+    /// Entries returned by the last `anidb_event_poll`, whose strings the
+    /// caller may still be reading
+    pub event_polled: Mutex<Vec<EventEntry>>,
 }
 
 /// Internal operation state
-#[allow(dead_code)]
+///
+/// Shared between the FFI caller and the task running on the client's
+/// runtime. `status` is paired with `finished` so callers can block on
+/// completion without polling.
 pub(crate) struct OperationState {
-    pub status: AniDBStatus,
-    pub result: Option<crate::FileProcessingResult>,
-    pub error: Option<Error>,
+    pub file_path: String,
+    pub status: Mutex<AniDBStatus>,
+    pub finished: Condvar,
+    pub outcome: Mutex<Option<FileOutcome>>,
+    pub completion: Mutex<Option<(AniDBOperationCallback, usize)>>, // Store user_data as usize
+    pub cancel_tx: watch::Sender<bool>,
+    pub progress: Arc<ProgressCell>,
+}
+
+/// Outcome of processing a single file in an async operation or batch
+#[derive(Debug, Clone)]
+pub(crate) enum FileOutcome {
+    Completed(crate::FileProcessingResult),
+    Failed { code: AniDBResult, message: String },
+    Cancelled,
+}
+
+/// A file of a batch that shares its size with another file of the batch
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) struct SizeCollision {
+    pub file_size: u64,
+    /// Index of the file's first path in the batch
+    pub path_index: usize,
 }
 
 /// Internal batch state
-#[allow(dead_code)]
+///
+/// Shared between the FFI caller and the scheduler task; progress counters
+/// are atomics so `anidb_batch_get_progress` never waits on a running batch.
 pub(crate) struct BatchState {
-    pub total_files: usize,
+    pub file_paths: Vec<String>,
+    /// Results go to the caller's result callback instead of `outcomes`
+    pub streaming: bool,
+    /// Files in the batch; a directory scan raises it as files are found
+    pub total_files: AtomicUsize,
     pub completed_files: AtomicUsize,
-    pub results: Mutex<Vec<Result<crate::FileProcessingResult, Error>>>,
-    pub status: AniDBStatus,
+    pub successful_files: AtomicUsize,
+    pub failed_files: AtomicUsize,
+    pub outcomes: Mutex<Vec<Option<FileOutcome>>>,
+    pub status: Mutex<AniDBStatus>,
+    pub first_error: Mutex<Option<AniDBResult>>,
+    pub cancel_requested: AtomicBool,
+    pub cancel_tx: watch::Sender<bool>,
+    pub started_at: Instant,
+    pub total_time_ms: AtomicU64,
+    /// Per-device counters, filled in once the batch has been planned
+    pub devices: Mutex<Vec<Arc<DeviceStats>>>,
+    /// Distinct files of equal size, sorted by size; filled in with `devices`
+    pub size_collisions: Mutex<Vec<SizeCollision>>,
+}
+
+/// Incremental hashing context behind a hasher handle
+///
+/// The hasher is taken out on finalize, so a finalized handle rejects
+/// further input until it is destroyed.
+pub(crate) struct HasherState {
+    pub algorithms: Vec<AniDBHashAlgorithm>,
+    pub hasher: Mutex<Option<MultiHasher>>,
+}
+
+/// Client resources captured for work that outlives an FFI call
+///
+/// Cloned out of the client state so long-running operations keep them
+/// alive after the client is destroyed.
+pub(crate) struct ClientContext {
+    pub file_processor: Arc<FileProcessor>,
+    pub identifier: Arc<Identifier>,
+    pub runtime: Arc<Runtime>,
+    pub events: EventSink,
+    pub callbacks: Arc<CallbackTable>,
+    pub default_concurrency: usize,
+}
+
+/// Bumped after a client is removed, invalidating every thread's last lookup
+static CLIENT_GENERATION: AtomicU64 = AtomicU64::new(0);
+
+thread_local! {
+    /// The client this thread resolved last, with the generation it was
+    /// resolved in
+    static LAST_CLIENT: RefCell<Option<(usize, u64, Weak<ClientState>)>> =
+        const { RefCell::new(None) };
+}
+
+/// Resolve a client handle
+///
+/// Repeated calls on one handle from the same thread are answered from a
+/// per-thread entry without touching `CLIENTS`. Handle ids are never
+/// reused, so the entry only has to be dropped when a client goes away.
+pub(crate) fn lookup_client(handle: *mut c_void) -> Result<Arc<ClientState>, AniDBResult> {
+    let handle_id = handle as usize;
+
+    // Validate handle ID
+    if handle_id == 0 || handle_id > usize::MAX / 2 {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    // Read before the registry so a removal in between forces a miss next time
+    let generation = CLIENT_GENERATION.load(Ordering::Acquire);
+    let cached = LAST_CLIENT
+        .try_with(|last| match &*last.borrow() {
+            Some((id, seen, client)) if *id == handle_id && *seen == generation => client.upgrade(),
+            _ => None,
+        })
+        .ok()
+        .flatten();
+    if let Some(client) = cached {
+        return Ok(client);
+    }
+
+    let client = CLIENTS
+        .read()
+        .map_err(|_| AniDBResult::ErrorBusy)?
+        .get(&handle_id)
+        .cloned()
+        .ok_or(AniDBResult::ErrorInvalidHandle)?;
+    let _ = LAST_CLIENT.try_with(|last| {
+        *last.borrow_mut() = Some((handle_id, generation, Arc::downgrade(&client)));
+    });
+    Ok(client)
+}
+
+/// Detach clients taken out of the registry from caller memory
+pub(crate) fn remove_clients(removed: impl IntoIterator<Item = Arc<ClientState>>) {
+    for client in removed {
+        // Work still in flight must not write to caller memory
+        client.event_subscriptions.set_ring(None, 0);
+    }
+    CLIENT_GENERATION.fetch_add(1, Ordering::AcqRel);
+}
+
+/// Look up a client and capture its shared resources
+pub(crate) fn client_context(handle: *mut c_void) -> Result<ClientContext, AniDBResult> {
+    let client = lookup_client(handle)?;
+    Ok(ClientContext {
+        file_processor: client.file_processor.clone(),
+        identifier: client.identifier.clone(),
+        runtime: client.runtime.clone(),
+        events: EventSink::from_client(&client),
+        callbacks: client.callbacks.clone(),
+        default_concurrency: client.config.max_concurrent_files,
+    })
 }
 
 // Handle registries
 lazy_static::lazy_static! {
-    pub(crate) static ref CLIENTS: RwLock<HashMap<usize, Arc<Mutex<ClientState>>>> = RwLock::new(HashMap::new());
-    pub(crate) static ref OPERATIONS: RwLock<HashMap<usize, Arc<Mutex<OperationState>>>> = RwLock::new(HashMap::new());
-    pub(crate) static ref BATCHES: RwLock<HashMap<usize, Arc<Mutex<BatchState>>>> = RwLock::new(HashMap::new());
+    pub(crate) static ref CLIENTS: RwLock<HashMap<usize, Arc<ClientState>>> = RwLock::new(HashMap::new());
+    pub(crate) static ref OPERATIONS: RwLock<HashMap<usize, Arc<OperationState>>> = RwLock::new(HashMap::new());
+    pub(crate) static ref BATCHES: RwLock<HashMap<usize, Arc<BatchState>>> = RwLock::new(HashMap::new());
+    pub(crate) static ref HASHERS: RwLock<HashMap<usize, Arc<HasherState>>> = RwLock::new(HashMap::new());
     pub(crate) static ref NEXT_HANDLE_ID: AtomicUsize = AtomicUsize::new(1);
     pub(crate) static ref INITIALIZED: AtomicUsize = AtomicUsize::new(0);
 }
@@ -100,7 +308,7 @@ pub extern "C" fn anidb_client_create(handle: *mut *mut c_void) -> AniDBResult {
         }
 
         let config = ClientConfig::default();
-        create_client_with_config(config, handle)
+        create_client_with_config(config, HashCacheMode::None, handle)
     })
 }
 
@@ -121,6 +329,16 @@ pub extern "C" fn anidb_client_create_with_config(
 
         // Parse configuration with validation
 
+        let cache_dir = if ffi_config.cache_dir.is_null() {
+            None
+        } else {
+            match c_str_to_string(ffi_config.cache_dir) {
+                Ok(s) if !s.is_empty() => Some(PathBuf::from(s)),
+                Ok(_) => None,
+                Err(e) => return e,
+            }
+        };
+
         let username = if ffi_config.username.is_null() {
             None
         } else {
@@ -157,12 +375,22 @@ pub extern "C" fn anidb_client_create_with_config(
             }
         };
 
+        let server = if ffi_config.server.is_null() {
+            None
+        } else {
+            match c_str_to_string(ffi_config.server) {
+                Ok(s) if !s.is_empty() => Some(s),
+                Ok(_) => None,
+                Err(e) => return e,
+            }
+        };
+
         // Validate numeric parameters
         let max_concurrent = ffi_config.max_concurrent_files.clamp(1, 100);
         let chunk_size = ffi_config.chunk_size.clamp(1024, 10 * 1024 * 1024);
         let max_memory = ffi_config
             .max_memory_usage
-            .clamp(10 * 1024 * 1024, 2 * 1024 * 1024 * 1024); // 10MB to 2GB
+            .clamp(MIN_MEMORY_LIMIT, MAX_MEMORY_LIMIT);
 
         let client_config = ClientConfig {
             max_concurrent_files: max_concurrent,
@@ -172,19 +400,52 @@ pub extern "C" fn anidb_client_create_with_config(
             password,
             client_name,
             client_version,
+            io_mode: convert_io_mode(ffi_config.io_mode),
+            auto_tune: ffi_config.auto_tune != 0,
+            server,
+            request_rate: (ffi_config.request_rate.is_finite() && ffi_config.request_rate > 0.0)
+                .then_some(ffi_config.request_rate),
+            request_timeout: (ffi_config.request_timeout_ms > 0)
+                .then(|| Duration::from_millis(ffi_config.request_timeout_ms.into())),
+        };
+
+        let cache = match cache_dir {
+            Some(dir) => HashCacheMode::Persistent(dir),
+            None if ffi_config.enable_hash_cache != 0 => HashCacheMode::InMemory,
+            None => HashCacheMode::None,
         };
 
-        create_client_with_config(client_config, handle)
+        create_client_with_config(client_config, cache, handle)
     })
 }
 
+/// Which hash cache a new client gets
+pub(crate) enum HashCacheMode {
+    /// No cache; every file is read and hashed
+    None,
+    /// A cache that lasts as long as the client
+    InMemory,
+    /// A cache saved to and loaded from this directory
+    Persistent(PathBuf),
+}
+
 /// Internal helper to create client with config
 pub(crate) fn create_client_with_config(
     config: ClientConfig,
+    cache: HashCacheMode,
     handle: *mut *mut c_void,
 ) -> AniDBResult {
     // Set the global memory limit based on config
-    crate::buffer::set_memory_limit(config.max_memory_usage);
+    apply_memory_limit(config.max_memory_usage);
+
+    let cache = match cache {
+        HashCacheMode::None => None,
+        HashCacheMode::InMemory => Some(HashCache::in_memory()),
+        HashCacheMode::Persistent(dir) => match HashCache::open(&dir) {
+            Ok(cache) => Some(cache),
+            Err(_) => return AniDBResult::ErrorCache,
+        },
+    };
 
     // Create runtime
     let runtime = match Runtime::new() {
@@ -193,24 +454,33 @@ pub(crate) fn create_client_with_config(
     };
 
     // Create file processor
-    let file_processor = Arc::new(FileProcessor::new(config.clone()));
+    let mut file_processor = FileProcessor::new(config.clone());
+    if let Some(cache) = cache {
+        file_processor = file_processor.with_cache(Arc::new(cache));
+    }
+    let file_processor = Arc::new(file_processor);
+
+    let identifier = Arc::new(Identifier::new(config.clone()));
 
     let state = ClientState {
         config,
         file_processor,
+        identifier,
         runtime,
-        last_error: None,
+        last_error: Mutex::new(None),
         reference_count: AtomicUsize::new(1),
-        callbacks: Arc::new(Mutex::new(HashMap::new())),
+        callbacks: Arc::new(CallbackTable::default()),
         next_callback_id: Arc::new(AtomicU64::new(1)),
         event_callback: Arc::new(Mutex::new(None)),
         event_queue: Arc::new(Mutex::new(VecDeque::new())),
         event_thread_handle: Arc::new(Mutex::new(None)),
         event_sender: Arc::new(Mutex::new(None)),
+        event_subscriptions: Arc::new(EventSubscriptions::default()),
+        event_polled: Mutex::new(Vec::new()),
     };
 
     let handle_id = generate_handle_id();
-    let client_arc = Arc::new(Mutex::new(state));
+    let client_arc = Arc::new(state);
 
     // Store in registry
     CLIENTS.write().unwrap().insert(handle_id, client_arc);
@@ -238,12 +508,16 @@ pub extern "C" fn anidb_client_destroy(handle: *mut c_void) -> AniDBResult {
         }
 
         // Remove from registry with proper error handling
-        match CLIENTS.write() {
-            Ok(mut clients) => match clients.remove(&handle_id) {
-                Some(_) => AniDBResult::Success,
-                None => AniDBResult::ErrorInvalidHandle,
-            },
-            Err(_) => AniDBResult::ErrorBusy,
+        let removed = match CLIENTS.write() {
+            Ok(mut clients) => clients.remove(&handle_id),
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+        match removed {
+            Some(client) => {
+                remove_clients([client]);
+                AniDBResult::Success
+            }
+            None => AniDBResult::ErrorInvalidHandle,
         }
     })
 }
@@ -0,0 +1,199 @@
+//! Incremental hashing contexts for FFI
+//!
+//! A hasher handle accepts data in pieces of any size, for example as an
+//! upload arrives, and produces the same hashes as hashing the whole
+//! input at once. All requested algorithms are fed from a single pass
+//! through [`MultiHasher`], so no temporary file is needed.
+
+use crate::ffi::handles::{HASHERS, HasherState};
+use crate::ffi::helpers::*;
+use crate::ffi::operations::{collect_hash_buffers, create_multi_hasher, write_hashes};
+use crate::ffi::types::*;
+use crate::ffi_catch_panic;
+use crate::hashing::MultiHasher;
+use std::ffi::{c_char, c_void};
+use std::sync::{Arc, Mutex};
+
+/// Look up a hasher handle
+fn get_hasher(hasher: *mut c_void) -> Result<Arc<HasherState>, AniDBResult> {
+    if !validate_mut_ptr(hasher) {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    let hasher_id = hasher as usize;
+    if hasher_id == 0 || hasher_id > usize::MAX / 2 {
+        return Err(AniDBResult::ErrorInvalidHandle);
+    }
+
+    let hashers = HASHERS.read().map_err(|_| AniDBResult::ErrorBusy)?;
+    hashers
+        .get(&hasher_id)
+        .cloned()
+        .ok_or(AniDBResult::ErrorInvalidHandle)
+}
+
+/// Create an incremental hasher for one or more algorithms
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_hasher_create(
+    algorithms: *const AniDBHashAlgorithm,
+    algorithm_count: usize,
+    hasher: *mut *mut c_void,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(hasher) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        // Validates the pointer, count and every identifier
+        if let Err(e) = parse_algorithms(algorithms, algorithm_count) {
+            return e;
+        }
+        let algorithms = unsafe { std::slice::from_raw_parts(algorithms, algorithm_count) };
+
+        let multi_hasher = match create_multi_hasher(algorithms) {
+            Ok(h) => h,
+            Err(e) => return e,
+        };
+
+        let state = Arc::new(HasherState {
+            algorithms: algorithms.to_vec(),
+            hasher: Mutex::new(Some(multi_hasher)),
+        });
+
+        let hasher_id = generate_handle_id();
+        match HASHERS.write() {
+            Ok(mut hashers) => {
+                hashers.insert(hasher_id, state);
+            }
+            Err(_) => return AniDBResult::ErrorBusy,
+        }
+
+        unsafe {
+            *hasher = hasher_id as *mut c_void;
+        }
+        AniDBResult::Success
+    })
+}
+
+/// Feed the next piece of data to a hasher
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_hasher_update(
+    hasher: *mut c_void,
+    data: *const u8,
+    data_size: usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        let state = match get_hasher(hasher) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        if data_size == 0 {
+            return AniDBResult::Success;
+        }
+        if !validate_ptr(data) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let mut guard = match state.hasher.lock() {
+            Ok(g) => g,
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+        let multi_hasher = match guard.as_mut() {
+            Some(h) => h,
+            None => return AniDBResult::ErrorProcessing, // Already finalized
+        };
+
+        let data = unsafe { std::slice::from_raw_parts(data, data_size) };
+        multi_hasher.update(data);
+        AniDBResult::Success
+    })
+}
+
+/// Get the number of bytes fed to a hasher so far
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_hasher_get_bytes_processed(
+    hasher: *mut c_void,
+    bytes_processed: *mut u64,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(bytes_processed) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let state = match get_hasher(hasher) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        let guard = match state.hasher.lock() {
+            Ok(g) => g,
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+        let processed = match guard.as_ref() {
+            Some(h) => h.bytes_processed(),
+            None => return AniDBResult::ErrorProcessing, // Already finalized
+        };
+
+        unsafe {
+            *bytes_processed = processed;
+        }
+        AniDBResult::Success
+    })
+}
+
+/// Finalize a hasher and write one hash per algorithm
+///
+/// Output buffers are validated before the hasher is consumed, so a
+/// too-small buffer can be corrected and the call retried.
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_hasher_finalize(
+    hasher: *mut c_void,
+    hash_buffers: *const *mut c_char,
+    buffer_sizes: *const usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        let state = match get_hasher(hasher) {
+            Ok(s) => s,
+            Err(e) => return e,
+        };
+
+        let buffers = match collect_hash_buffers(&state.algorithms, hash_buffers, buffer_sizes) {
+            Ok(b) => b,
+            Err(e) => return e,
+        };
+
+        let multi_hasher: MultiHasher = match state.hasher.lock() {
+            Ok(mut guard) => match guard.take() {
+                Some(h) => h,
+                None => return AniDBResult::ErrorProcessing, // Already finalized
+            },
+            Err(_) => return AniDBResult::ErrorBusy,
+        };
+
+        write_hashes(multi_hasher, &buffers)
+    })
+}
+
+/// Destroy a hasher handle, finalized or not
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_hasher_destroy(hasher: *mut c_void) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(hasher) {
+            return AniDBResult::ErrorInvalidHandle;
+        }
+
+        let hasher_id = hasher as usize;
+        if hasher_id == 0 || hasher_id > usize::MAX / 2 {
+            return AniDBResult::ErrorInvalidHandle;
+        }
+
+        match HASHERS.write() {
+            Ok(mut hashers) => match hashers.remove(&hasher_id) {
+                Some(_) => AniDBResult::Success,
+                None => AniDBResult::ErrorInvalidHandle,
+            },
+            Err(_) => AniDBResult::ErrorBusy,
+        }
+    })
+}
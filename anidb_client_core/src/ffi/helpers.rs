@@ -3,16 +3,20 @@
 //! This module provides helper functions for FFI operations including
 //! panic catching, validation, string conversion, and callback invocation.
 
-use crate::ffi::handles::{CallbackRegistration, NEXT_HANDLE_ID};
-use crate::ffi::types::{AniDBCallbackType, AniDBHashAlgorithm, AniDBResult};
+use crate::ffi::handles::{CallbackRegistration, CallbackTable, NEXT_HANDLE_ID};
+use crate::ffi::types::{
+    AniDBCallbackType, AniDBCrc32Kernel, AniDBHashAlgorithm, AniDBIoMode, AniDBMd4Kernel,
+    AniDBPriority, AniDBProcessOptions, AniDBResult,
+};
 use crate::ffi_memory::ffi_allocate_string;
-use crate::{Error, HashAlgorithm};
-use std::collections::HashMap;
+use crate::hashing::{Crc32Kernel, Md4Kernel};
+use crate::scheduler::Priority;
+use crate::{CacheOptions, Error, HashAlgorithm, IoMode};
 use std::ffi::{CStr, c_char};
 use std::panic::{AssertUnwindSafe, catch_unwind};
 use std::sync::atomic::Ordering;
-use std::sync::{Arc, Mutex};
 use std::time::{SystemTime, UNIX_EPOCH};
+use tokio::sync::watch;
 
 /// Macro to wrap FFI functions with panic catching
 #[macro_export]
@@ -110,6 +114,83 @@ pub(crate) fn convert_hash_algorithm(
     }
 }
 
+/// Convert FFI I/O mode to internal I/O mode
+pub(crate) fn convert_io_mode(mode: AniDBIoMode) -> IoMode {
+    match mode {
+        AniDBIoMode::Auto => IoMode::Auto,
+        AniDBIoMode::Buffered => IoMode::Buffered,
+        AniDBIoMode::MemoryMapped => IoMode::MemoryMapped,
+        AniDBIoMode::DirectIo => IoMode::DirectIo,
+        AniDBIoMode::IoUring => IoMode::IoUring,
+    }
+}
+
+/// Convert FFI priority to the scheduler's priority
+pub(crate) fn convert_priority(priority: AniDBPriority) -> Priority {
+    match priority {
+        AniDBPriority::Normal => Priority::Normal,
+        AniDBPriority::Background => Priority::Background,
+        AniDBPriority::Interactive => Priority::Interactive,
+    }
+}
+
+/// Convert internal MD4 kernel to FFI MD4 kernel
+pub(crate) fn convert_md4_kernel(kernel: Md4Kernel) -> AniDBMd4Kernel {
+    match kernel {
+        Md4Kernel::Scalar => AniDBMd4Kernel::Scalar,
+        Md4Kernel::Sse41 => AniDBMd4Kernel::Sse41,
+        Md4Kernel::Avx2 => AniDBMd4Kernel::Avx2,
+        Md4Kernel::Avx512 => AniDBMd4Kernel::Avx512,
+        Md4Kernel::Neon => AniDBMd4Kernel::Neon,
+    }
+}
+
+/// Convert internal CRC32 kernel to FFI CRC32 kernel
+pub(crate) fn convert_crc32_kernel(kernel: Crc32Kernel) -> AniDBCrc32Kernel {
+    match kernel {
+        Crc32Kernel::Table => AniDBCrc32Kernel::Table,
+        Crc32Kernel::Pclmulqdq => AniDBCrc32Kernel::Pclmulqdq,
+        Crc32Kernel::Armv8 => AniDBCrc32Kernel::Armv8,
+    }
+}
+
+/// Maximum number of algorithms accepted in a single request
+pub(crate) const MAX_ALGORITHM_COUNT: usize = 10;
+
+/// Parse a caller-provided algorithm array
+pub(crate) fn parse_algorithms(
+    algorithms: *const AniDBHashAlgorithm,
+    algorithm_count: usize,
+) -> Result<Vec<HashAlgorithm>, AniDBResult> {
+    // Validate algorithm parameters
+    if !validate_ptr(algorithms) || algorithm_count == 0 {
+        return Err(AniDBResult::ErrorInvalidParameter);
+    }
+
+    // Limit algorithm count to prevent excessive memory allocation
+    if algorithm_count > MAX_ALGORITHM_COUNT {
+        return Err(AniDBResult::ErrorInvalidParameter);
+    }
+
+    let mut parsed = Vec::with_capacity(algorithm_count);
+    for i in 0..algorithm_count {
+        let ffi_algo = unsafe {
+            // Bounds are already checked by algorithm_count validation
+            *algorithms.add(i)
+        };
+        parsed.push(convert_hash_algorithm(ffi_algo)?);
+    }
+    Ok(parsed)
+}
+
+/// Cache flags of a caller's process options
+pub(crate) fn parse_cache_options(opts: &AniDBProcessOptions) -> CacheOptions {
+    CacheOptions {
+        verify_existing: opts.verify_existing != 0,
+        partial_rehash: opts.partial_rehash != 0,
+    }
+}
+
 /// Convert internal hash algorithm to FFI type
 pub(crate) fn convert_hash_algorithm_to_ffi(algo: &HashAlgorithm) -> AniDBHashAlgorithm {
     match algo {
@@ -135,28 +216,31 @@ pub(crate) fn get_timestamp_ms() -> u64 {
 }
 
 /// Invoke callbacks of a specific type
+///
+/// Works on a snapshot, so callbacks may register or unregister callbacks.
 pub(crate) fn invoke_callbacks(
-    callbacks: &Arc<Mutex<HashMap<u64, CallbackRegistration>>>,
+    callbacks: &CallbackTable,
     callback_type: AniDBCallbackType,
     invoke_fn: impl Fn(&CallbackRegistration),
 ) {
-    if let Ok(callbacks_map) = callbacks.lock() {
-        for registration in callbacks_map.values() {
-            if registration.callback_type == callback_type {
-                invoke_fn(registration);
-            }
+    for (_, registration) in callbacks.snapshot().iter() {
+        if registration.callback_type == callback_type {
+            invoke_fn(registration);
         }
     }
 }
 
 /// Check if there are any progress callbacks registered
-pub(crate) fn has_progress_callbacks(
-    callbacks: &Arc<Mutex<HashMap<u64, CallbackRegistration>>>,
-) -> bool {
-    if let Ok(map) = callbacks.lock() {
-        map.values()
-            .any(|reg| reg.callback_type == AniDBCallbackType::Progress)
-    } else {
-        false
+pub(crate) fn has_progress_callbacks(callbacks: &CallbackTable) -> bool {
+    callbacks.has_progress()
+}
+
+/// Resolve once a cancellation channel is set
+///
+/// Used as a `select!` arm next to the work being cancelled.
+pub(crate) async fn wait_cancelled(cancel_rx: &mut watch::Receiver<bool>) {
+    if cancel_rx.wait_for(|cancelled| *cancelled).await.is_err() {
+        // The sender lives in the handle state; without it nothing can cancel
+        std::future::pending::<()>().await;
     }
 }
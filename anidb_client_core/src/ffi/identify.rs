@@ -0,0 +1,384 @@
+//! Anime identification for FFI
+//!
+//! Every client owns an [`Identifier`]: the AniDB session, created on the
+//! first lookup rather than with the client, and a cache of identified
+//! files. `anidb_identify_file` and `anidb_identify_batch` both go through
+//! [`identify_batch`], so a single lookup is a batch of one.
+//!
+//! The cache can be backed by a memory-mapped [`IdentificationIndex`]
+//! exported by another client (`anidb_identify_index_*`). Files found in the
+//! cache or index are answered without entering the client runtime.
+
+use crate::ClientConfig;
+use crate::error::{Error, Result, ValidationError};
+use crate::ffi::handles::client_context;
+use crate::ffi::helpers::*;
+use crate::ffi::types::*;
+use crate::ffi_catch_panic;
+use crate::identification::{
+    AniDBQueryManager, DataSource, FileLookup, IdentificationCache, IdentificationIndex,
+    IdentificationOptions, IdentificationResult, IdentificationSource, IdentificationStatus,
+    identify_batch,
+};
+use crate::metrics::Histogram;
+use crate::protocol::ProtocolConfig;
+use crate::protocol::client::{ProtocolClient, ProtocolStats};
+use crate::protocol::rate_limit::RateLimiter;
+use crate::scheduler::Priority;
+use async_trait::async_trait;
+use std::ffi::{CString, c_char, c_void};
+use std::path::Path;
+use std::sync::{Arc, OnceLock};
+use std::time::Instant;
+use tokio::sync::{Mutex, OnceCell};
+
+/// Length of a hex encoded ED2K hash
+const ED2K_HEX_LEN: usize = 32;
+
+/// Per-client AniDB session and identification cache
+pub(crate) struct Identifier {
+    config: ClientConfig,
+    options: IdentificationOptions,
+    manager: OnceCell<Arc<AniDBQueryManager>>,
+    /// Limiter of the session, once it exists
+    rate_limiter: OnceLock<Arc<RateLimiter>>,
+    /// Retry and timeout counters of the session, once it exists
+    protocol_stats: OnceLock<Arc<ProtocolStats>>,
+    pub cache: IdentificationCache,
+    /// Latency of lookups sent to AniDB, rate limiting included
+    pub network: Histogram,
+}
+
+impl Identifier {
+    pub fn new(config: ClientConfig) -> Self {
+        let options = IdentificationOptions::default();
+        Self {
+            config,
+            cache: IdentificationCache::new(options.cache_ttl),
+            options,
+            manager: OnceCell::new(),
+            rate_limiter: OnceLock::new(),
+            protocol_stats: OnceLock::new(),
+            network: Histogram::default(),
+        }
+    }
+
+    /// The session's rate limiter, `None` before the first lookup
+    pub fn rate_limiter(&self) -> Option<&Arc<RateLimiter>> {
+        self.rate_limiter.get()
+    }
+
+    /// Retry and timeout counters of the session, `None` before the first lookup
+    pub fn protocol_stats(&self) -> Option<&Arc<ProtocolStats>> {
+        self.protocol_stats.get()
+    }
+
+    /// The AniDB session, connecting on first use
+    async fn manager(&self) -> Result<&Arc<AniDBQueryManager>> {
+        self.manager
+            .get_or_try_init(|| async {
+                let mut protocol_config = ProtocolConfig {
+                    client_name: self.config.client_name.clone().unwrap_or_default(),
+                    client_version: self.config.client_version.clone().unwrap_or_default(),
+                    ..Default::default()
+                };
+                // Only servers other than AniDB may go past its flood limits
+                if let Some(server) = &self.config.server {
+                    protocol_config.server = server.clone();
+                    protocol_config.request_rate = self.config.request_rate;
+                }
+                if let Some(request_timeout) = self.config.request_timeout {
+                    protocol_config.request_timeout = request_timeout;
+                }
+                let client = ProtocolClient::new(protocol_config).await?;
+                let _ = self.rate_limiter.set(client.rate_limiter().clone());
+                let _ = self.protocol_stats.set(client.stats().clone());
+                let manager = AniDBQueryManager::new(Arc::new(Mutex::new(client)));
+                Ok::<_, Error>(Arc::new(manager))
+            })
+            .await
+    }
+}
+
+#[async_trait]
+impl FileLookup for Identifier {
+    async fn lookup(&self, ed2k: &str, size: u64) -> Result<IdentificationResult> {
+        let (Some(username), Some(password)) = (&self.config.username, &self.config.password)
+        else {
+            return Err(Error::Validation(ValidationError::MissingField {
+                field: "username/password".to_string(),
+            }));
+        };
+
+        let start = Instant::now();
+        let result = async {
+            let manager = self.manager().await?;
+            manager.ensure_authenticated(username, password).await?;
+            manager
+                .query_file(
+                    &IdentificationSource::HashWithSize {
+                        ed2k: ed2k.to_string(),
+                        size,
+                    },
+                    self.options.fmask.as_deref(),
+                    self.options.amask.as_deref(),
+                )
+                .await
+        }
+        .await;
+        self.network.record(start.elapsed());
+        result
+    }
+}
+
+/// Result code of one identification
+fn identification_result_code(result: &Result<IdentificationResult>) -> AniDBResult {
+    match result {
+        Ok(identified) => match identified.status {
+            IdentificationStatus::Identified => AniDBResult::Success,
+            IdentificationStatus::NotFound => AniDBResult::ErrorFileNotFound,
+            _ => AniDBResult::ErrorNetwork,
+        },
+        Err(e) => error_to_result(e),
+    }
+}
+
+/// Fill an anime info structure; `title` must outlive its use
+fn anime_info_to_ffi(result: &IdentificationResult, title: *mut c_char) -> AniDBAnimeInfo {
+    let (anime_id, episode_id) = result
+        .file
+        .as_ref()
+        .map_or((0, 0), |file| (file.aid, file.eid));
+    // Specials and credits are numbered "S1", "C2", ...; report the digits
+    let episode_number = result.episode.as_ref().map_or(0, |episode| {
+        episode
+            .episode_number
+            .trim_start_matches(|c: char| !c.is_ascii_digit())
+            .parse()
+            .unwrap_or(0)
+    });
+
+    AniDBAnimeInfo {
+        anime_id,
+        episode_id,
+        title,
+        episode_number,
+        confidence: 1.0,
+        source: match result.source {
+            DataSource::Cache { .. } => 1,
+            _ => 0,
+        },
+    }
+}
+
+fn anime_title(result: &IdentificationResult) -> &str {
+    result
+        .anime
+        .as_ref()
+        .map_or("", |anime| anime.romaji_name.as_str())
+}
+
+/// Read and validate one ED2K hash argument
+fn parse_ed2k(ed2k_hash: *const c_char) -> std::result::Result<String, AniDBResult> {
+    let ed2k = c_str_to_string(ed2k_hash)?;
+    if ed2k.len() != ED2K_HEX_LEN || !ed2k.bytes().all(|b| b.is_ascii_hexdigit()) {
+        return Err(AniDBResult::ErrorInvalidParameter);
+    }
+    Ok(ed2k)
+}
+
+/// Identify an anime file by hash and size
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_identify_file(
+    handle: *mut c_void,
+    ed2k_hash: *const c_char,
+    file_size: u64,
+    info: *mut *mut AniDBAnimeInfo,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(handle) || !validate_c_str(ed2k_hash) || !validate_mut_ptr(info) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let ed2k = match parse_ed2k(ed2k_hash) {
+            Ok(h) => h,
+            Err(e) => return e,
+        };
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        // Known files need neither the runtime nor the network
+        if let Some(known) = context.identifier.cache.get(&ed2k, file_size) {
+            let title = string_to_c_string(anime_title(&known));
+            unsafe {
+                *info = Box::into_raw(Box::new(anime_info_to_ffi(&known, title)));
+            }
+            return AniDBResult::Success;
+        }
+
+        // A single lookup has a caller waiting on it, so it goes ahead of
+        // queued batch lookups at the rate limiter
+        let items = [(ed2k, file_size)];
+        let mut code = AniDBResult::ErrorNetwork;
+        let lookup = identify_batch(
+            context.identifier.as_ref(),
+            &context.identifier.cache,
+            &items,
+            |_, result| {
+                code = identification_result_code(result);
+                if let (Ok(identified), AniDBResult::Success) = (result, code) {
+                    let title = string_to_c_string(anime_title(identified));
+                    unsafe {
+                        *info = Box::into_raw(Box::new(anime_info_to_ffi(identified, title)));
+                    }
+                }
+                true
+            },
+        );
+        context
+            .runtime
+            .block_on(Priority::Interactive.scope(lookup));
+        code
+    })
+}
+
+/// Identify many files by hash and size, reporting each as it completes
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_identify_batch(
+    handle: *mut c_void,
+    ed2k_hashes: *const *const c_char,
+    file_sizes: *const u64,
+    count: usize,
+    callback: Option<AniDBIdentifyCallback>,
+    user_data: *mut c_void,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        let Some(callback) = callback else {
+            return AniDBResult::ErrorInvalidParameter;
+        };
+        if !validate_mut_ptr(handle) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+        if count > 0 && (!validate_ptr(ed2k_hashes) || !validate_ptr(file_sizes)) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+        if count == 0 {
+            return AniDBResult::Success;
+        }
+
+        let hashes = unsafe { std::slice::from_raw_parts(ed2k_hashes, count) };
+        let sizes = unsafe { std::slice::from_raw_parts(file_sizes, count) };
+        let mut items = Vec::with_capacity(count);
+        for (&hash, &size) in hashes.iter().zip(sizes) {
+            match parse_ed2k(hash) {
+                Ok(ed2k) => items.push((ed2k, size)),
+                Err(e) => return e,
+            }
+        }
+
+        context.runtime.block_on(identify_batch(
+            context.identifier.as_ref(),
+            &context.identifier.cache,
+            &items,
+            |index, result| {
+                let code = identification_result_code(result);
+                let stop = match result {
+                    Ok(identified) if code == AniDBResult::Success => {
+                        let title = CString::new(anime_title(identified)).unwrap_or_default();
+                        let info = anime_info_to_ffi(identified, title.as_ptr() as *mut c_char);
+                        callback(index, code, &info, user_data)
+                    }
+                    _ => callback(index, code, std::ptr::null(), user_data),
+                };
+                stop == 0
+            },
+        ));
+        AniDBResult::Success
+    })
+}
+
+/// Map an identification index and consult it for files not in the cache
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_identify_index_load(
+    handle: *mut c_void,
+    index_path: *const c_char,
+    entry_count: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(handle) || !validate_c_str(index_path) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let path = match c_str_to_string(index_path) {
+            Ok(p) => p,
+            Err(e) => return e,
+        };
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        let index = match IdentificationIndex::open(Path::new(&path)) {
+            Ok(index) => index,
+            Err(e) => return index_error_to_result(&e),
+        };
+        if validate_mut_ptr(entry_count) {
+            unsafe {
+                *entry_count = index.len();
+            }
+        }
+        context.identifier.cache.set_index(Some(Arc::new(index)));
+        AniDBResult::Success
+    })
+}
+
+/// Write the loaded index and every identified file as a new index
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_identify_index_export(
+    handle: *mut c_void,
+    index_path: *const c_char,
+    entry_count: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(handle) || !validate_c_str(index_path) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let path = match c_str_to_string(index_path) {
+            Ok(p) => p,
+            Err(e) => return e,
+        };
+        let context = match client_context(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        match context.identifier.cache.export(Path::new(&path)) {
+            Ok(written) => {
+                if validate_mut_ptr(entry_count) {
+                    unsafe {
+                        *entry_count = written;
+                    }
+                }
+                AniDBResult::Success
+            }
+            Err(e) => index_error_to_result(&e),
+        }
+    })
+}
+
+/// Missing files keep their own code; anything else is a damaged index
+fn index_error_to_result(error: &Error) -> AniDBResult {
+    match error_to_result(error) {
+        AniDBResult::ErrorFileNotFound => AniDBResult::ErrorFileNotFound,
+        AniDBResult::ErrorPermissionDenied => AniDBResult::ErrorPermissionDenied,
+        _ => AniDBResult::ErrorCache,
+    }
+}
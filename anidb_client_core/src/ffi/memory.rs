@@ -2,15 +2,31 @@
 //!
 //! This module handles all memory-related FFI functions including
 //! deallocation, memory statistics, and garbage collection.
+//!
+//! The limit, shrink and eviction functions act on the process-wide buffer
+//! pools shared by every client. Pooled buffers count against the memory
+//! limit until they are freed.
 
 use crate::ffi::helpers::validate_mut_ptr;
-use crate::ffi::types::{AniDBBatchResult, AniDBFileResult, AniDBHashResult, AniDBResult};
+use crate::ffi::results::free_result_block;
+use crate::ffi::types::{AniDBAnimeInfo, AniDBBatchResult, AniDBFileResult, AniDBResult};
 use crate::ffi_catch_panic;
-use crate::ffi_memory::{
-    MemoryPressure, check_memory_pressure, ffi_free_string, ffi_release_buffer, get_memory_stats,
-};
+use crate::ffi_memory::{MemoryPressure, check_memory_pressure, ffi_free_string, get_memory_stats};
 use std::ffi::c_char;
 use std::panic::{AssertUnwindSafe, catch_unwind};
+use std::time::Duration;
+
+/// Smallest accepted memory limit (10MB)
+pub(crate) const MIN_MEMORY_LIMIT: usize = 10 * 1024 * 1024;
+
+/// Largest accepted memory limit (2GB)
+pub(crate) const MAX_MEMORY_LIMIT: usize = 2 * 1024 * 1024 * 1024;
+
+/// Apply a memory limit to buffer allocation and the buffer pools
+pub(crate) fn apply_memory_limit(limit: usize) {
+    crate::buffer::set_memory_limit(limit);
+    crate::memory::set_memory_limit(limit);
+}
 
 /// Free a string allocated by the library
 #[unsafe(no_mangle)]
@@ -25,112 +41,44 @@ pub extern "C" fn anidb_free_string(str: *mut c_char) {
 }
 
 /// Free a file result structure
+///
+/// Results are built by the library as a single block and released with
+/// one deallocation.
 #[unsafe(no_mangle)]
 pub extern "C" fn anidb_free_file_result(result: *mut AniDBFileResult) {
     let _ = catch_unwind(AssertUnwindSafe(|| {
-        if !validate_mut_ptr(result) {
+        if validate_mut_ptr(result) {
+            unsafe { free_result_block(result as *mut u8) }
+        }
+    }));
+}
+
+/// Free an anime info structure
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_free_anime_info(info: *mut AniDBAnimeInfo) {
+    let _ = catch_unwind(AssertUnwindSafe(|| {
+        if !validate_mut_ptr(info) {
             return;
         }
 
         unsafe {
-            let result_box = Box::from_raw(result);
-
-            // Free file path
-            if validate_mut_ptr(result_box.file_path) {
-                ffi_free_string(result_box.file_path);
-            }
-
-            // Free error message
-            if validate_mut_ptr(result_box.error_message) {
-                ffi_free_string(result_box.error_message);
+            let info_box = Box::from_raw(info);
+            if validate_mut_ptr(info_box.title) {
+                ffi_free_string(info_box.title);
             }
-
-            // Free hashes with bounds checking
-            if validate_mut_ptr(result_box.hashes) && result_box.hash_count > 0 {
-                // Limit hash count to prevent excessive iteration
-                let hash_count = result_box.hash_count.min(100);
-                let hash_slice = std::slice::from_raw_parts_mut(result_box.hashes, hash_count);
-
-                for hash in hash_slice {
-                    if validate_mut_ptr(hash.hash_value) {
-                        ffi_free_string(hash.hash_value);
-                    }
-                }
-
-                // Reconstruct the buffer to properly release it
-                let hash_results_size =
-                    result_box.hash_count * std::mem::size_of::<AniDBHashResult>();
-                let buffer = Vec::from_raw_parts(
-                    result_box.hashes as *mut u8,
-                    hash_results_size,
-                    hash_results_size,
-                );
-                ffi_release_buffer(buffer);
-            }
-
-            // Box automatically deallocates
         }
     }));
 }
 
 /// Free a batch result structure
+///
+/// Results are built by the library as a single block holding every file
+/// result and released with one deallocation.
 #[unsafe(no_mangle)]
 pub extern "C" fn anidb_free_batch_result(result: *mut AniDBBatchResult) {
     let _ = catch_unwind(AssertUnwindSafe(|| {
-        if !validate_mut_ptr(result) {
-            return;
-        }
-
-        unsafe {
-            let result_box = Box::from_raw(result);
-
-            // Free individual results with bounds checking
-            if validate_mut_ptr(result_box.results) && result_box.total_files > 0 {
-                // Limit file count to prevent excessive iteration
-                let file_count = result_box.total_files.min(10000);
-                let results_slice = std::slice::from_raw_parts_mut(result_box.results, file_count);
-
-                for file_result in results_slice {
-                    // Manually free each file result's contents
-                    if validate_mut_ptr(file_result.file_path) {
-                        ffi_free_string(file_result.file_path);
-                    }
-
-                    if validate_mut_ptr(file_result.error_message) {
-                        ffi_free_string(file_result.error_message);
-                    }
-
-                    if validate_mut_ptr(file_result.hashes) && file_result.hash_count > 0 {
-                        let hash_count = file_result.hash_count.min(100);
-                        let hash_slice =
-                            std::slice::from_raw_parts_mut(file_result.hashes, hash_count);
-
-                        for hash in hash_slice {
-                            if validate_mut_ptr(hash.hash_value) {
-                                ffi_free_string(hash.hash_value);
-                            }
-                        }
-
-                        // Reconstruct the buffer to properly release it
-                        let hash_results_size =
-                            file_result.hash_count * std::mem::size_of::<AniDBHashResult>();
-                        let buffer = Vec::from_raw_parts(
-                            file_result.hashes as *mut u8,
-                            hash_results_size,
-                            hash_results_size,
-                        );
-                        ffi_release_buffer(buffer);
-                    }
-                }
-
-                // Reconstruct the results buffer to properly release it
-                let results_size = result_box.total_files * std::mem::size_of::<AniDBFileResult>();
-                let buffer =
-                    Vec::from_raw_parts(result_box.results as *mut u8, results_size, results_size);
-                ffi_release_buffer(buffer);
-            }
-
-            // Box automatically deallocates
+        if validate_mut_ptr(result) {
+            unsafe { free_result_block(result as *mut u8) }
         }
     }));
 }
@@ -181,15 +129,114 @@ pub extern "C" fn anidb_get_memory_stats(stats: *mut AniDBMemoryStats) -> AniDBR
     })
 }
 
+/// Statistics of one buffer pool
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AniDBPoolStats {
+    pub buffer_size: u64,
+    pub pooled_buffers: u64,
+    pub pooled_bytes: u64,
+    pub bytes_in_use: u64,
+    pub peak_bytes: u64,
+    pub hits: u64,
+    pub misses: u64,
+    pub hit_rate: f64,
+}
+
+/// Get statistics of every buffer pool, smallest buffers first
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_memory_get_pool_stats(
+    pools: *mut AniDBPoolStats,
+    max_pools: usize,
+    pool_count: *mut usize,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(pool_count) || (max_pools > 0 && !validate_mut_ptr(pools)) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let info = crate::memory::pool_info();
+        let count = info.len().min(max_pools);
+        for (i, pool) in info.iter().take(count).enumerate() {
+            unsafe {
+                *pools.add(i) = AniDBPoolStats {
+                    buffer_size: pool.size_category.size() as u64,
+                    pooled_buffers: pool.pool_size as u64,
+                    pooled_bytes: pool.memory_used as u64,
+                    bytes_in_use: pool.bytes_in_use as u64,
+                    peak_bytes: pool.peak_bytes as u64,
+                    hits: pool.hits as u64,
+                    misses: pool.misses as u64,
+                    hit_rate: pool.hit_rate(),
+                };
+            }
+        }
+
+        unsafe {
+            *pool_count = count;
+        }
+        AniDBResult::Success
+    })
+}
+
+/// Change the memory limit of every client
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_memory_set_limit(max_memory_usage: u64) -> AniDBResult {
+    ffi_catch_panic!({
+        if max_memory_usage == 0 {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let limit = usize::try_from(max_memory_usage)
+            .unwrap_or(usize::MAX)
+            .clamp(MIN_MEMORY_LIMIT, MAX_MEMORY_LIMIT);
+        apply_memory_limit(limit);
+        AniDBResult::Success
+    })
+}
+
+/// Free pooled buffers until memory use is at most `target_bytes`
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_memory_shrink(target_bytes: u64, freed_bytes: *mut u64) -> AniDBResult {
+    ffi_catch_panic!({
+        let target = usize::try_from(target_bytes).unwrap_or(usize::MAX);
+        let freed = crate::memory::shrink_pools(target);
+
+        if validate_mut_ptr(freed_bytes) {
+            unsafe {
+                *freed_bytes = freed as u64;
+            }
+        }
+        AniDBResult::Success
+    })
+}
+
+/// Free pooled buffers left unused for longer than `max_idle_ms`
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_memory_evict_stale(max_idle_ms: u64, freed_bytes: *mut u64) -> AniDBResult {
+    ffi_catch_panic!({
+        let freed = crate::memory::evict_older_than(Duration::from_millis(max_idle_ms));
+
+        if validate_mut_ptr(freed_bytes) {
+            unsafe {
+                *freed_bytes = freed as u64;
+            }
+        }
+        AniDBResult::Success
+    })
+}
+
 /// Force garbage collection of unused buffers
 #[unsafe(no_mangle)]
 pub extern "C" fn anidb_memory_gc() -> AniDBResult {
     ffi_catch_panic!({
-        use crate::memory::shrink_pools;
+        use crate::memory::{evict_stale, shrink_pools};
 
-        // Shrink pool to 50% of current usage
+        // Drop buffers idle past the eviction timeout, then shrink pool to
+        // 50% of current usage
+        evict_stale();
         let stats = get_memory_stats();
-        shrink_pools(stats.pool_memory / 2);
+        shrink_pools(stats.total_memory_used / 2);
 
         AniDBResult::Success
     })
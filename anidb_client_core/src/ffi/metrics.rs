@@ -0,0 +1,135 @@
+//! Client metrics for FFI
+//!
+//! `anidb_get_metrics` copies a client's counters and latency histograms
+//! into a caller-provided structure. Apart from the length of the event
+//! queue, everything is read from atomics that processing updates without
+//! locking, so the snapshot is cheap enough to scrape every second.
+
+use crate::ffi::handles::lookup_client;
+use crate::ffi::helpers::*;
+use crate::ffi::types::AniDBResult;
+use crate::ffi_catch_panic;
+use crate::metrics::{HISTOGRAM_BUCKETS, HistogramSnapshot};
+use crate::scheduler::CpuPool;
+use std::ffi::c_void;
+use std::sync::atomic::Ordering;
+
+/// Latency histogram matching `anidb_histogram_t`
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AniDBHistogram {
+    pub count: u64,
+    pub sum_us: u64,
+    pub buckets: [u64; HISTOGRAM_BUCKETS],
+}
+
+impl From<HistogramSnapshot> for AniDBHistogram {
+    fn from(snapshot: HistogramSnapshot) -> Self {
+        Self {
+            count: snapshot.count,
+            sum_us: snapshot.sum_us,
+            buckets: snapshot.buckets,
+        }
+    }
+}
+
+/// Client metrics matching `anidb_metrics_t`
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AniDBMetrics {
+    pub files_processed: u64,
+    pub files_failed: u64,
+    pub bytes_read: u64,
+    pub cache_hits: u64,
+    pub cache_misses: u64,
+    pub cache_hit_ratio: f64,
+    pub files_in_flight: u64,
+    pub files_queued: u64,
+    pub events_queued: u64,
+    pub hash_slots_busy: u64,
+    pub hash_slots_total: u64,
+    pub network_requests_waiting: u64,
+    pub rate_limit_wait_us: u64,
+    pub file_latency: AniDBHistogram,
+    pub open_latency: AniDBHistogram,
+    pub read_latency: AniDBHistogram,
+    pub pool_wait: AniDBHistogram,
+    pub hash_latency: AniDBHistogram,
+    pub cache_lookup_latency: AniDBHistogram,
+    pub network_latency: AniDBHistogram,
+    pub files_read_buffered: u64,
+    pub files_read_mmap: u64,
+    pub files_read_direct: u64,
+    pub files_read_io_uring: u64,
+    pub chunk_size: u64,
+    pub hash_queue_depth: u64,
+    pub readers_per_device: u64,
+    pub network_retries: u64,
+    pub network_timeouts: u64,
+}
+
+/// Get a snapshot of a client's processing metrics
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_get_metrics(
+    handle: *mut c_void,
+    metrics: *mut AniDBMetrics,
+) -> AniDBResult {
+    ffi_catch_panic!({
+        if !validate_mut_ptr(handle) || !validate_mut_ptr(metrics) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let client = match lookup_client(handle) {
+            Ok(c) => c,
+            Err(e) => return e,
+        };
+
+        let processing = client.file_processor.metrics().snapshot();
+        let tuned = client.file_processor.tuned_values();
+        let identifier = &client.identifier;
+        let rate_limiter = identifier.rate_limiter();
+        let protocol_stats = identifier.protocol_stats();
+        let pool = CpuPool::global();
+        let events_queued = client.event_queue.lock().map(|q| q.len()).unwrap_or(0);
+
+        unsafe {
+            *metrics = AniDBMetrics {
+                files_processed: processing.files_processed,
+                files_failed: processing.files_failed,
+                bytes_read: processing.bytes_read,
+                cache_hits: processing.cache_hits,
+                cache_misses: processing.cache_misses,
+                cache_hit_ratio: processing.cache_hit_ratio(),
+                files_in_flight: processing.in_flight as u64,
+                files_queued: processing.queued as u64,
+                events_queued: events_queued as u64,
+                hash_slots_busy: pool.size().saturating_sub(pool.available()) as u64,
+                hash_slots_total: pool.size() as u64,
+                network_requests_waiting: rate_limiter.map_or(0, |r| r.waiting() as u64),
+                rate_limit_wait_us: rate_limiter.map_or(0, |r| {
+                    r.total_wait().as_micros().try_into().unwrap_or(u64::MAX)
+                }),
+                file_latency: processing.total.into(),
+                open_latency: processing.open.into(),
+                read_latency: processing.read.into(),
+                pool_wait: processing.pool_wait.into(),
+                hash_latency: processing.hash.into(),
+                cache_lookup_latency: processing.cache_lookup.into(),
+                network_latency: identifier.network.snapshot().into(),
+                files_read_buffered: processing.files_read_buffered,
+                files_read_mmap: processing.files_read_mapped,
+                files_read_direct: processing.files_read_direct,
+                files_read_io_uring: processing.files_read_io_uring,
+                chunk_size: tuned.chunk_size as u64,
+                hash_queue_depth: tuned.queue_depth as u64,
+                readers_per_device: tuned.readers_per_device as u64,
+                network_retries: protocol_stats
+                    .map_or(0, |s| s.retries.load(Ordering::Relaxed)),
+                network_timeouts: protocol_stats
+                    .map_or(0, |s| s.timeouts.load(Ordering::Relaxed)),
+            };
+        }
+
+        AniDBResult::Success
+    })
+}
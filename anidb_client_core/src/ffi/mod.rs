@@ -19,20 +19,34 @@
 #![allow(clippy::not_unsafe_ptr_arg_deref)]
 
 // Module declarations
+pub mod async_ops;
+pub mod batch;
+pub mod cache;
 pub mod callbacks;
+pub mod event_ring;
 pub mod events;
 pub mod handles;
+pub mod hasher;
 pub mod helpers;
+pub mod identify;
 pub mod memory;
+pub mod metrics;
 pub mod operations;
+pub mod progress;
 pub mod results;
 pub mod types;
 
 // Re-export all public FFI functions and types
+pub use async_ops::*;
+pub use batch::*;
+pub use cache::*;
 pub use callbacks::*;
 pub use events::*;
 pub use handles::*;
+pub use hasher::*;
+pub use identify::*;
 pub use memory::*;
+pub use metrics::*;
 pub use operations::*;
 pub use results::*;
 pub use types::*;
@@ -42,6 +56,8 @@ pub use types::*;
 // Re-export the macro at module level for internal use
 pub(crate) use crate::ffi_catch_panic;
 
+use crate::hashing::HashKernels;
+use crate::platform::CpuFeatures;
 use std::ffi::c_char;
 use std::panic::{AssertUnwindSafe, catch_unwind};
 use std::sync::atomic::Ordering;
@@ -54,7 +70,10 @@ const VERSION_MINOR: u32 = 1;
 #[allow(dead_code)]
 const VERSION_PATCH: u32 = 0;
 const VERSION_STRING: &str = "0.1.0-alpha\0";
-const ABI_VERSION: u32 = 1;
+/// ABI version checked by `anidb_init`, matching `ANIDB_ABI_VERSION`
+///
+/// Bumped whenever a `#[repr(C)]` struct crossing the boundary changes size.
+pub const ANIDB_ABI_VERSION: u32 = 2;
 
 /* ========================================================================== */
 /*                          Library Initialization                             */
@@ -64,7 +83,7 @@ const ABI_VERSION: u32 = 1;
 #[unsafe(no_mangle)]
 pub extern "C" fn anidb_init(abi_version: u32) -> AniDBResult {
     ffi_catch_panic!({
-        if abi_version != ABI_VERSION {
+        if abi_version != ANIDB_ABI_VERSION {
             return AniDBResult::ErrorVersionMismatch;
         }
 
@@ -77,7 +96,8 @@ pub extern "C" fn anidb_init(abi_version: u32) -> AniDBResult {
             .compare_exchange(0, 1, Ordering::SeqCst, Ordering::SeqCst)
             .is_ok()
         {
-            // Perform any one-time initialization here
+            // Select the hash kernels now rather than on the first hash
+            HashKernels::get();
             AniDBResult::Success
         } else {
             // Already initialized
@@ -96,7 +116,9 @@ pub extern "C" fn anidb_cleanup() {
         {
             // Clear all handles with proper error handling
             if let Ok(mut clients) = handles::CLIENTS.write() {
-                clients.clear();
+                let removed: Vec<_> = clients.drain().map(|(_, client)| client).collect();
+                drop(clients);
+                handles::remove_clients(removed);
             }
             if let Ok(mut operations) = handles::OPERATIONS.write() {
                 operations.clear();
@@ -104,6 +126,9 @@ pub extern "C" fn anidb_cleanup() {
             if let Ok(mut batches) = handles::BATCHES.write() {
                 batches.clear();
             }
+            if let Ok(mut hashers) = handles::HASHERS.write() {
+                hashers.clear();
+            }
 
             // Reset memory state on cleanup to ensure clean state
             crate::buffer::reset_memory_state_for_tests();
@@ -120,5 +145,33 @@ pub extern "C" fn anidb_get_version() -> *const c_char {
 /// Get library ABI version
 #[unsafe(no_mangle)]
 pub extern "C" fn anidb_get_abi_version() -> u32 {
-    ABI_VERSION
+    ANIDB_ABI_VERSION
+}
+
+/// Report the CPU features detected at startup and the hash kernels in use
+#[unsafe(no_mangle)]
+pub extern "C" fn anidb_get_cpu_features(features: *mut AniDBCpuFeatures) -> AniDBResult {
+    ffi_catch_panic!({
+        if !helpers::validate_mut_ptr(features) {
+            return AniDBResult::ErrorInvalidParameter;
+        }
+
+        let cpu = CpuFeatures::get();
+        let kernels = HashKernels::get();
+        unsafe {
+            *features = AniDBCpuFeatures {
+                sse2: cpu.sse2 as i32,
+                sse4_1: cpu.sse4_1 as i32,
+                avx2: cpu.avx2 as i32,
+                avx512f: cpu.avx512f as i32,
+                pclmulqdq: cpu.pclmulqdq as i32,
+                neon: cpu.neon as i32,
+                crc32: cpu.crc32 as i32,
+                md4_kernel: helpers::convert_md4_kernel(kernels.md4),
+                md4_lanes: kernels.md4.lanes() as u32,
+                crc32_kernel: helpers::convert_crc32_kernel(kernels.crc32),
+            };
+        }
+        AniDBResult::Success
+    })
 }
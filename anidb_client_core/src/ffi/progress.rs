@@ -0,0 +1,216 @@
+//! Progress delivery for FFI
+//!
+//! Progress is published on the hashing thread itself. Callers that poll
+//! (`anidb_operation_get_progress`) read a lock-free cell of exact 64-bit
+//! counters at whatever rate suits them; newer updates simply overwrite
+//! older ones, so a slow reader never backs up the producer. Callbacks, when
+//! requested, are invoked inline without any intermediate thread or queue.
+
+use crate::ffi::handles::CallbackTable;
+use crate::ffi::helpers::{has_progress_callbacks, invoke_callbacks};
+use crate::ffi::types::*;
+use crate::progress::{ProgressProvider, ProgressUpdate};
+use std::ffi::c_void;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// Latest progress of a single operation
+///
+/// Writers publish the total before the processed count and bump `updates`
+/// last with release ordering, so a reader that observes a new update count
+/// also observes the counters that produced it.
+#[derive(Debug, Default)]
+pub(crate) struct ProgressCell {
+    bytes_processed: AtomicU64,
+    total_bytes: AtomicU64,
+    updates: AtomicU64,
+}
+
+impl ProgressCell {
+    /// Publish new counters, never moving the processed count backwards
+    pub fn publish(&self, bytes_processed: u64, total_bytes: u64) {
+        self.total_bytes.store(total_bytes, Ordering::Relaxed);
+        self.bytes_processed
+            .fetch_max(bytes_processed, Ordering::Relaxed);
+        self.updates.fetch_add(1, Ordering::Release);
+    }
+
+    /// Read the latest published counters
+    pub fn snapshot(&self) -> AniDBProgressSnapshot {
+        let updates = self.updates.load(Ordering::Acquire);
+        AniDBProgressSnapshot {
+            bytes_processed: self.bytes_processed.load(Ordering::Relaxed),
+            total_bytes: self.total_bytes.load(Ordering::Relaxed),
+            updates,
+        }
+    }
+}
+
+/// Where a progress provider forwards updates
+#[derive(Clone)]
+struct ProgressSinks {
+    cell: Option<Arc<ProgressCell>>,
+    callback: Option<(AniDBProgressCallback, usize)>, // Store user_data as usize
+    client_callbacks: Option<Arc<CallbackTable>>,
+}
+
+/// FFI progress provider that publishes to a cell and invokes callbacks
+struct FfiProgressProvider {
+    sinks: ProgressSinks,
+}
+
+impl ProgressProvider for FfiProgressProvider {
+    fn report(&self, update: ProgressUpdate) {
+        let (bytes_processed, total_bytes) = match update {
+            ProgressUpdate::FileProgress {
+                bytes_processed,
+                total_bytes,
+                ..
+            }
+            | ProgressUpdate::HashProgress {
+                bytes_processed,
+                total_bytes,
+                ..
+            } => (bytes_processed, total_bytes),
+            _ => return, // Ignore other update types for FFI
+        };
+
+        if let Some(cell) = &self.sinks.cell {
+            cell.publish(bytes_processed, total_bytes);
+        }
+
+        if self.sinks.callback.is_none() && self.sinks.client_callbacks.is_none() {
+            return;
+        }
+
+        let percentage = if total_bytes > 0 {
+            (bytes_processed as f64 / total_bytes as f64 * 100.0) as f32
+        } else {
+            0.0
+        };
+
+        // Call callback if provided
+        if let Some((cb, user_data)) = self.sinks.callback {
+            cb(
+                percentage,
+                bytes_processed,
+                total_bytes,
+                user_data as *mut c_void,
+            );
+        }
+
+        // Call registered progress callbacks
+        if let Some(client_callbacks) = &self.sinks.client_callbacks {
+            invoke_callbacks(client_callbacks, AniDBCallbackType::Progress, |reg| {
+                let callback_fn = unsafe {
+                    std::mem::transmute::<*mut c_void, AniDBProgressCallback>(reg.callback_ptr)
+                };
+                callback_fn(percentage, bytes_processed, total_bytes, reg.user_data);
+            });
+        }
+    }
+
+    fn create_child(&self, _name: &str) -> Box<dyn ProgressProvider> {
+        // Children report the same file, so they share the sinks
+        Box::new(FfiProgressProvider {
+            sinks: self.sinks.clone(),
+        })
+    }
+
+    fn complete(&self) {
+        // No special handling needed for completion in FFI
+    }
+}
+
+/// Create the progress provider for a file processing request
+///
+/// Updates are always published to `cell` when one is given. With
+/// `enable_progress` they are also forwarded to the per-call callback and to
+/// registered progress callbacks, on the thread that reports them.
+pub(crate) fn create_progress_provider(
+    opts: &AniDBProcessOptions,
+    client_callbacks: &Arc<CallbackTable>,
+    cell: Option<Arc<ProgressCell>>,
+) -> Arc<dyn ProgressProvider> {
+    let enabled = opts.enable_progress != 0;
+    let callback = opts
+        .progress_callback
+        .filter(|_| enabled)
+        .map(|cb| (cb, opts.user_data as usize));
+    let client_callbacks = if enabled && has_progress_callbacks(client_callbacks) {
+        Some(client_callbacks.clone())
+    } else {
+        None
+    };
+
+    if cell.is_none() && callback.is_none() && client_callbacks.is_none() {
+        return Arc::new(crate::progress::NullProvider);
+    }
+
+    Arc::new(FfiProgressProvider {
+        sinks: ProgressSinks {
+            cell,
+            callback,
+            client_callbacks,
+        },
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::path::PathBuf;
+
+    fn file_progress(bytes_processed: u64, total_bytes: u64) -> ProgressUpdate {
+        ProgressUpdate::FileProgress {
+            path: PathBuf::from("file.mkv"),
+            bytes_processed,
+            total_bytes,
+            operation: "Hashing".to_string(),
+            throughput_mbps: None,
+            memory_usage_bytes: None,
+            buffer_size: None,
+        }
+    }
+
+    #[test]
+    fn test_cell_keeps_exact_64_bit_counters() {
+        let cell = ProgressCell::default();
+        let total = 40 * 1024 * 1024 * 1024 + 3; // Not representable as f32
+        cell.publish(total - 1, total);
+
+        let snapshot = cell.snapshot();
+        assert_eq!(snapshot.bytes_processed, total - 1);
+        assert_eq!(snapshot.total_bytes, total);
+        assert_eq!(snapshot.updates, 1);
+    }
+
+    #[test]
+    fn test_cell_never_goes_backwards() {
+        let cell = ProgressCell::default();
+        cell.publish(200, 1000);
+        cell.publish(100, 1000);
+
+        let snapshot = cell.snapshot();
+        assert_eq!(snapshot.bytes_processed, 200);
+        assert_eq!(snapshot.updates, 2);
+    }
+
+    #[test]
+    fn test_provider_publishes_without_callbacks() {
+        let opts = AniDBProcessOptions::default();
+        let callbacks = Arc::new(CallbackTable::default());
+        let cell = Arc::new(ProgressCell::default());
+
+        let provider = create_progress_provider(&opts, &callbacks, Some(cell.clone()));
+        provider.report(file_progress(512, 1024));
+        provider
+            .create_child("ed2k")
+            .report(file_progress(1024, 1024));
+
+        let snapshot = cell.snapshot();
+        assert_eq!(snapshot.bytes_processed, 1024);
+        assert_eq!(snapshot.total_bytes, 1024);
+        assert_eq!(snapshot.updates, 2);
+    }
+}
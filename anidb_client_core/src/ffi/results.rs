@@ -1,10 +1,331 @@
 //! Result marshalling and conversion for FFI
 //!
 //! This module handles error result conversion, error strings,
-//! and hash algorithm information functions.
+//! hash algorithm information functions, and the conversion of
+//! processing results into their C representation.
+//!
+//! Each file result, and each batch result with all of its file results
+//! and size collisions, is one allocation. Hash values and strings are
+//! written once into the block behind the structures, at offsets the
+//! structure pointers refer to, so the C layout is the same as for
+//! separately allocated fields. A header in front of the structure records
+//! the size of the block for the free functions.
 
-use crate::ffi::types::{AniDBHashAlgorithm, AniDBResult};
+use crate::FileProcessingResult;
+use crate::ffi::helpers::convert_hash_algorithm_to_ffi;
+use crate::ffi::types::{
+    AniDBBatchResult, AniDBFileResult, AniDBHashAlgorithm, AniDBHashResult, AniDBResult,
+    AniDBSizeCollision, AniDBStageTimings, AniDBStatus,
+};
+use crate::ffi_memory::{ALLOCATION_TRACKER, AllocationType};
+use std::alloc::{Layout, alloc, dealloc};
+use std::borrow::Cow;
 use std::ffi::c_char;
+use std::mem::{align_of, size_of};
+use std::ptr;
+use std::time::Duration;
+
+/// Alignment of result blocks, enough for every structure they hold
+const BLOCK_ALIGN: usize = 8;
+
+/// Marks the header of a live result block
+const BLOCK_MAGIC: u64 = u64::from_le_bytes(*b"ADBRSLT1");
+
+/// Sits in front of the structure handed out for a result block
+#[repr(C)]
+struct BlockHeader {
+    magic: u64,
+    /// Size of the block after the header
+    size: usize,
+}
+
+const HEADER_SIZE: usize = size_of::<BlockHeader>();
+
+const _: () = {
+    assert!(align_of::<AniDBBatchResult>() <= BLOCK_ALIGN);
+    assert!(align_of::<AniDBFileResult>() <= BLOCK_ALIGN);
+    assert!(align_of::<AniDBHashResult>() <= BLOCK_ALIGN);
+    assert!(align_of::<AniDBSizeCollision>() <= BLOCK_ALIGN);
+    assert!(size_of::<AniDBBatchResult>().is_multiple_of(BLOCK_ALIGN));
+    assert!(size_of::<AniDBFileResult>().is_multiple_of(BLOCK_ALIGN));
+    assert!(size_of::<AniDBHashResult>().is_multiple_of(BLOCK_ALIGN));
+    assert!(size_of::<AniDBSizeCollision>().is_multiple_of(BLOCK_ALIGN));
+    assert!(align_of::<BlockHeader>() <= BLOCK_ALIGN);
+    assert!(HEADER_SIZE.is_multiple_of(BLOCK_ALIGN));
+};
+
+/// Contents of one file result, borrowed from where they were produced
+pub(crate) struct FileEntry<'a> {
+    file_path: Cow<'a, str>,
+    file_size: u64,
+    status: AniDBStatus,
+    /// Algorithm, hash and the microseconds spent computing it
+    hashes: Vec<(AniDBHashAlgorithm, &'a str, u64)>,
+    processing_time_ms: u64,
+    error_message: Option<&'a str>,
+    timings: AniDBStageTimings,
+}
+
+/// Duration in whole microseconds, saturating
+fn micros(duration: Duration) -> u64 {
+    u64::try_from(duration.as_micros()).unwrap_or(u64::MAX)
+}
+
+impl<'a> FileEntry<'a> {
+    /// A completed processing result
+    pub fn completed(proc_result: &'a FileProcessingResult) -> Self {
+        let timings = &proc_result.timings;
+        Self {
+            file_path: proc_result.file_path.to_string_lossy(),
+            file_size: proc_result.file_size,
+            status: AniDBStatus::Completed,
+            hashes: proc_result
+                .hashes
+                .iter()
+                .map(|(algo, hash)| {
+                    let time = timings.hash_by_algorithm.get(algo).copied();
+                    (
+                        convert_hash_algorithm_to_ffi(algo),
+                        hash.as_str(),
+                        micros(time.unwrap_or_default()),
+                    )
+                })
+                .collect(),
+            processing_time_ms: proc_result.processing_time.as_millis() as u64,
+            error_message: None,
+            timings: AniDBStageTimings {
+                open_us: micros(timings.open),
+                read_us: micros(timings.read),
+                pool_wait_us: micros(timings.pool_wait),
+                hash_us: micros(timings.hash),
+                cache_lookup_us: micros(timings.cache_lookup),
+            },
+        }
+    }
+
+    /// A file that produced no hashes
+    ///
+    /// Used for failed and cancelled entries of a batch.
+    pub fn unprocessed(
+        file_path: &'a str,
+        status: AniDBStatus,
+        error_message: Option<&'a str>,
+    ) -> Self {
+        Self {
+            file_path: Cow::Borrowed(file_path),
+            file_size: 0,
+            status,
+            hashes: Vec::new(),
+            processing_time_ms: 0,
+            error_message,
+            timings: AniDBStageTimings::default(),
+        }
+    }
+
+    /// Bytes taken by the strings of this entry, terminators included
+    fn string_bytes(&self) -> usize {
+        self.file_path.len()
+            + 1
+            + self.error_message.map_or(0, |m| m.len() + 1)
+            + self
+                .hashes
+                .iter()
+                .map(|(_, h, _)| h.len() + 1)
+                .sum::<usize>()
+    }
+}
+
+/// A result block being filled: structures at the front, strings after
+struct BlockWriter {
+    base: *mut u8,
+    strings: usize,
+}
+
+impl BlockWriter {
+    /// Copy a string after the previous ones
+    ///
+    /// Strings with an embedded NUL cannot be represented and are NULL,
+    /// as with separately allocated strings.
+    unsafe fn write_str(&mut self, s: &str) -> *mut c_char {
+        if s.as_bytes().contains(&0) {
+            return ptr::null_mut();
+        }
+        unsafe {
+            let dst = self.base.add(self.strings);
+            ptr::copy_nonoverlapping(s.as_ptr(), dst, s.len());
+            *dst.add(s.len()) = 0;
+            self.strings += s.len() + 1;
+            dst as *mut c_char
+        }
+    }
+
+    /// Write an entry into `slot`, its hashes into the array at `hashes`
+    unsafe fn write_entry(
+        &mut self,
+        entry: &FileEntry,
+        slot: *mut AniDBFileResult,
+        hashes: *mut AniDBHashResult,
+    ) {
+        unsafe {
+            let file_path = self.write_str(&entry.file_path);
+            let error_message = match entry.error_message {
+                Some(message) => self.write_str(message),
+                None => ptr::null_mut(),
+            };
+            for (i, (algorithm, hash, hash_time_us)) in entry.hashes.iter().enumerate() {
+                let hash_value = self.write_str(hash);
+                hashes.add(i).write(AniDBHashResult {
+                    algorithm: *algorithm,
+                    hash_value,
+                    hash_length: hash.len(),
+                    hash_time_us: *hash_time_us,
+                });
+            }
+            slot.write(AniDBFileResult {
+                file_path,
+                file_size: entry.file_size,
+                status: entry.status,
+                hashes: if entry.hashes.is_empty() {
+                    ptr::null_mut()
+                } else {
+                    hashes
+                },
+                hash_count: entry.hashes.len(),
+                processing_time_ms: entry.processing_time_ms,
+                error_message,
+                timings: entry.timings,
+            });
+        }
+    }
+}
+
+/// Layout of a block holding `size` bytes after its header
+fn block_layout(size: usize) -> Option<Layout> {
+    Layout::from_size_align(HEADER_SIZE.checked_add(size)?, BLOCK_ALIGN).ok()
+}
+
+/// Allocate a result block of `size` bytes, returning the start after the
+/// header
+fn allocate_block(size: usize, alloc_type: AllocationType) -> Result<*mut u8, AniDBResult> {
+    let layout = block_layout(size).ok_or(AniDBResult::ErrorOutOfMemory)?;
+    // SAFETY: the layout always includes the header, so it is never
+    // zero-sized
+    let header = unsafe { alloc(layout) } as *mut BlockHeader;
+    if header.is_null() {
+        return Err(AniDBResult::ErrorOutOfMemory);
+    }
+    // SAFETY: the allocation starts with room for the header
+    let base = unsafe {
+        header.write(BlockHeader {
+            magic: BLOCK_MAGIC,
+            size,
+        });
+        (header as *mut u8).add(HEADER_SIZE)
+    };
+    // Only the memory statistics read this; freeing relies on the header
+    ALLOCATION_TRACKER.track_allocation(base, size, alloc_type);
+    Ok(base)
+}
+
+/// Build a C file result as a single block
+///
+/// The result structure comes first, then its hash array, then every
+/// string, so the pointers inside the result point into the block and
+/// `anidb_free_file_result` releases it with one deallocation.
+pub(crate) fn file_result_to_ffi(entry: &FileEntry) -> Result<*mut AniDBFileResult, AniDBResult> {
+    let hashes_offset = size_of::<AniDBFileResult>();
+    let strings_offset = hashes_offset + entry.hashes.len() * size_of::<AniDBHashResult>();
+    let size = strings_offset + entry.string_bytes();
+
+    let base = allocate_block(size, AllocationType::FileResult)?;
+    let mut writer = BlockWriter {
+        base,
+        strings: strings_offset,
+    };
+    unsafe {
+        writer.write_entry(
+            entry,
+            base as *mut AniDBFileResult,
+            base.add(hashes_offset) as *mut AniDBHashResult,
+        );
+    }
+    Ok(base as *mut AniDBFileResult)
+}
+
+/// Build a C batch result and every file result in it as a single block
+///
+/// `summary` supplies the counters; its `results` pointer is replaced. The
+/// block holds the batch structure, the file results, all of their hashes
+/// and then every string. An empty `entries` gives a NULL results array.
+pub(crate) fn batch_result_to_ffi(
+    summary: AniDBBatchResult,
+    entries: &[FileEntry],
+    size_collisions: &[AniDBSizeCollision],
+) -> Result<*mut AniDBBatchResult, AniDBResult> {
+    let results_offset = size_of::<AniDBBatchResult>();
+    let hashes_offset = results_offset + entries.len() * size_of::<AniDBFileResult>();
+    let hash_count: usize = entries.iter().map(|e| e.hashes.len()).sum();
+    let collisions_offset = hashes_offset + hash_count * size_of::<AniDBHashResult>();
+    let strings_offset =
+        collisions_offset + size_collisions.len() * size_of::<AniDBSizeCollision>();
+    let size = strings_offset + entries.iter().map(FileEntry::string_bytes).sum::<usize>();
+
+    let base = allocate_block(size, AllocationType::BatchResult)?;
+    let mut writer = BlockWriter {
+        base,
+        strings: strings_offset,
+    };
+    unsafe {
+        let results = base.add(results_offset) as *mut AniDBFileResult;
+        let mut hashes = base.add(hashes_offset) as *mut AniDBHashResult;
+        for (i, entry) in entries.iter().enumerate() {
+            writer.write_entry(entry, results.add(i), hashes);
+            hashes = hashes.add(entry.hashes.len());
+        }
+
+        let collisions = base.add(collisions_offset) as *mut AniDBSizeCollision;
+        ptr::copy_nonoverlapping(size_collisions.as_ptr(), collisions, size_collisions.len());
+
+        (base as *mut AniDBBatchResult).write(AniDBBatchResult {
+            results: if entries.is_empty() {
+                ptr::null_mut()
+            } else {
+                results
+            },
+            size_collisions: if size_collisions.is_empty() {
+                ptr::null_mut()
+            } else {
+                collisions
+            },
+            size_collision_count: size_collisions.len(),
+            ..summary
+        });
+    }
+    Ok(base as *mut AniDBBatchResult)
+}
+
+/// Release a block built by this module
+///
+/// Pointers whose header does not carry the block magic are left alone.
+///
+/// # Safety
+///
+/// `ptr` must be a result this module passed to the caller.
+pub(crate) unsafe fn free_result_block(ptr: *mut u8) {
+    // SAFETY: results handed out follow their header in the same block
+    unsafe {
+        let header = ptr.sub(HEADER_SIZE) as *mut BlockHeader;
+        if (*header).magic != BLOCK_MAGIC {
+            return;
+        }
+        (*header).magic = 0;
+        let Some(layout) = block_layout((*header).size) else {
+            return;
+        };
+        ALLOCATION_TRACKER.track_deallocation(ptr);
+        dealloc(header as *mut u8, layout);
+    }
+}
 
 /// Get human-readable error description
 #[unsafe(no_mangle)]
@@ -23,6 +344,7 @@ pub extern "C" fn anidb_error_string(error: AniDBResult) -> *const c_char {
         AniDBResult::ErrorVersionMismatch => "Version mismatch\0",
         AniDBResult::ErrorTimeout => "Operation timeout\0",
         AniDBResult::ErrorPermissionDenied => "Permission denied\0",
+        AniDBResult::ErrorCache => "Cache error\0",
         AniDBResult::ErrorBusy => "Resource busy\0",
         AniDBResult::ErrorUnknown => "Unknown error\0",
     };
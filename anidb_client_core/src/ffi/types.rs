@@ -27,7 +27,8 @@ pub enum AniDBResult {
     ErrorVersionMismatch = 10,
     ErrorTimeout = 11,
     ErrorPermissionDenied = 12,
-    ErrorBusy = 13,
+    ErrorCache = 13,
+    ErrorBusy = 14,
     ErrorUnknown = 99,
 }
 
@@ -53,6 +54,27 @@ pub enum AniDBStatus {
     Cancelled = 4,
 }
 
+/// I/O modes for reading files matching the C header
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum AniDBIoMode {
+    Auto = 0,
+    Buffered = 1,
+    MemoryMapped = 2,
+    DirectIo = 3,
+    IoUring = 4,
+}
+
+/// Scheduling priorities matching the C header
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum AniDBPriority {
+    #[default]
+    Normal = 0,
+    Background = 1,
+    Interactive = 2,
+}
+
 /// Callback types that can be registered
 #[repr(C)]
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -85,6 +107,7 @@ pub enum AniDBEventType {
 /// Client configuration structure matching C header
 #[repr(C)]
 pub struct AniDBConfig {
+    pub cache_dir: *const c_char,
     pub max_concurrent_files: usize,
     pub chunk_size: usize,
     pub max_memory_usage: usize,
@@ -93,6 +116,35 @@ pub struct AniDBConfig {
     pub password: *const c_char,
     pub client_name: *const c_char,
     pub client_version: *const c_char,
+    pub io_mode: AniDBIoMode,
+    pub auto_tune: i32,
+    pub server: *const c_char,
+    pub request_rate: f64,
+    pub request_timeout_ms: u32,
+    pub enable_hash_cache: i32,
+}
+
+// A zeroed configuration selects every default, as it does from C
+impl Default for AniDBConfig {
+    fn default() -> Self {
+        Self {
+            cache_dir: ptr::null(),
+            max_concurrent_files: 0,
+            chunk_size: 0,
+            max_memory_usage: 0,
+            enable_debug_logging: 0,
+            username: ptr::null(),
+            password: ptr::null(),
+            client_name: ptr::null(),
+            client_version: ptr::null(),
+            io_mode: AniDBIoMode::Auto,
+            auto_tune: 0,
+            server: ptr::null(),
+            request_rate: 0.0,
+            request_timeout_ms: 0,
+            enable_hash_cache: 0,
+        }
+    }
 }
 
 /// File processing options matching C header
@@ -101,8 +153,28 @@ pub struct AniDBProcessOptions {
     pub algorithms: *const AniDBHashAlgorithm,
     pub algorithm_count: usize,
     pub enable_progress: i32,
+    /// Hash the file even when its hashes are cached
+    pub verify_existing: i32,
+    /// Reuse cached ED2K chunk digests and CRC32s for chunks that look unchanged
+    pub partial_rehash: i32,
     pub progress_callback: Option<extern "C" fn(f32, u64, u64, *mut std::ffi::c_void)>,
     pub user_data: *mut std::ffi::c_void,
+    pub priority: AniDBPriority,
+}
+
+impl Default for AniDBProcessOptions {
+    fn default() -> Self {
+        Self {
+            algorithms: ptr::null(),
+            algorithm_count: 0,
+            enable_progress: 0,
+            verify_existing: 0,
+            partial_rehash: 0,
+            progress_callback: None,
+            user_data: ptr::null_mut(),
+            priority: AniDBPriority::Normal,
+        }
+    }
 }
 
 /// Hash result structure
@@ -111,6 +183,18 @@ pub struct AniDBHashResult {
     pub algorithm: AniDBHashAlgorithm,
     pub hash_value: *mut c_char,
     pub hash_length: usize,
+    pub hash_time_us: u64,
+}
+
+/// Time spent in each stage of processing one file, in microseconds
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct AniDBStageTimings {
+    pub open_us: u64,
+    pub read_us: u64,
+    pub pool_wait_us: u64,
+    pub hash_us: u64,
+    pub cache_lookup_us: u64,
 }
 
 /// File processing result
@@ -123,6 +207,7 @@ pub struct AniDBFileResult {
     pub hash_count: usize,
     pub processing_time_ms: u64,
     pub error_message: *mut c_char,
+    pub timings: AniDBStageTimings,
 }
 
 /// Anime identification information
@@ -132,6 +217,7 @@ pub struct AniDBAnimeInfo {
     pub episode_id: u64,
     pub title: *mut c_char,
     pub episode_number: u32,
+    pub confidence: f64,
     pub source: i32,
 }
 
@@ -143,14 +229,40 @@ pub struct AniDBBatchOptions {
     pub max_concurrent: usize,
     pub continue_on_error: i32,
     pub skip_existing: i32,
-    pub include_patterns: *const *const c_char,
-    pub include_pattern_count: usize,
-    pub exclude_patterns: *const *const c_char,
-    pub exclude_pattern_count: usize,
-    pub use_defaults: i32,
     pub progress_callback: Option<extern "C" fn(f32, u64, u64, *mut std::ffi::c_void)>,
     pub completion_callback: Option<extern "C" fn(AniDBResult, *mut std::ffi::c_void)>,
     pub user_data: *mut std::ffi::c_void,
+    pub priority: AniDBPriority,
+}
+
+impl Default for AniDBBatchOptions {
+    fn default() -> Self {
+        Self {
+            algorithms: ptr::null(),
+            algorithm_count: 0,
+            max_concurrent: 0,
+            continue_on_error: 0,
+            skip_existing: 0,
+            progress_callback: None,
+            completion_callback: None,
+            user_data: ptr::null_mut(),
+            priority: AniDBPriority::Normal,
+        }
+    }
+}
+
+/// Directory scan options
+#[repr(C)]
+pub struct AniDBScanOptions {
+    pub include_patterns: *const *const c_char,
+    pub include_count: usize,
+    pub exclude_patterns: *const *const c_char,
+    pub exclude_count: usize,
+    pub use_defaults: i32,
+    pub recursive: i32,
+    pub follow_links: i32,
+    /// Zero means unlimited
+    pub max_depth: usize,
 }
 
 /// Batch processing result
@@ -161,6 +273,93 @@ pub struct AniDBBatchResult {
     pub failed_files: usize,
     pub results: *mut AniDBFileResult,
     pub total_time_ms: u64,
+    /// Distinct files of equal size, sorted by size
+    pub size_collisions: *mut AniDBSizeCollision,
+    pub size_collision_count: usize,
+}
+
+/// Progress snapshot of an asynchronous operation
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AniDBProgressSnapshot {
+    pub bytes_processed: u64,
+    pub total_bytes: u64,
+    pub updates: u64,
+}
+
+/// Per-device progress of a batch
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AniDBDeviceStats {
+    pub device_id: u64,
+    pub files_total: usize,
+    pub files_completed: usize,
+    pub bytes_processed: u64,
+    pub throughput_mbps: f64,
+}
+
+/// A file of a batch that shares its size with another file of the batch
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AniDBSizeCollision {
+    pub file_size: u64,
+    pub path_index: usize,
+}
+
+/// Prefilter statuses matching the C header
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum AniDBPrefilterStatus {
+    #[default]
+    Unknown = 0,
+    KnownIdentity = 1,
+    KnownContent = 2,
+}
+
+/// Prefilter outcome for one file
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct AniDBPrefilterResult {
+    pub status: AniDBPrefilterStatus,
+    pub file_size: u64,
+    pub fingerprint: u64,
+    pub bytes_read: u64,
+}
+
+/// MD4 kernels matching the C header
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum AniDBMd4Kernel {
+    Scalar = 0,
+    Sse41 = 1,
+    Avx2 = 2,
+    Avx512 = 3,
+    Neon = 4,
+}
+
+/// CRC32 kernels matching the C header
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum AniDBCrc32Kernel {
+    Table = 0,
+    Pclmulqdq = 1,
+    Armv8 = 2,
+}
+
+/// Detected CPU features and the hash kernels selected from them
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct AniDBCpuFeatures {
+    pub sse2: i32,
+    pub sse4_1: i32,
+    pub avx2: i32,
+    pub avx512f: i32,
+    pub pclmulqdq: i32,
+    pub neon: i32,
+    pub crc32: i32,
+    pub md4_kernel: AniDBMd4Kernel,
+    pub md4_lanes: u32,
+    pub crc32_kernel: AniDBCrc32Kernel,
 }
 
 /// Event data union for different event types
@@ -207,7 +406,7 @@ pub struct MemoryEventData {
 
 /// Event structure for event callbacks
 #[repr(C)]
-#[derive(Clone)]
+#[derive(Clone, Copy)]
 pub struct AniDBEvent {
     pub event_type: AniDBEventType,
     pub timestamp: u64,
@@ -240,3 +439,12 @@ pub type AniDBErrorCallback =
     extern "C" fn(AniDBResult, *const c_char, *const c_char, *mut std::ffi::c_void);
 pub type AniDBCompletionCallback = extern "C" fn(AniDBResult, *mut std::ffi::c_void);
 pub type AniDBEventCallback = extern "C" fn(*const AniDBEvent, *mut std::ffi::c_void);
+pub type AniDBOperationCallback =
+    extern "C" fn(*mut std::ffi::c_void, AniDBResult, *mut std::ffi::c_void);
+pub type AniDBResultCallback = extern "C" fn(usize, *mut AniDBFileResult, *mut std::ffi::c_void);
+pub type AniDBIdentifyCallback = extern "C" fn(
+    usize,
+    AniDBResult,
+    *const AniDBAnimeInfo,
+    *mut std::ffi::c_void,
+) -> std::ffi::c_int;
@@ -37,6 +37,7 @@ pub fn error_string_inline(error: AniDBResult) -> *const std::os::raw::c_char {
         "Version mismatch\0",
         "Operation timeout\0",
         "Permission denied\0",
+        "Cache error\0",
         "Resource busy\0",
         "Unknown error\0",
     ];
@@ -55,8 +56,9 @@ pub fn error_string_inline(error: AniDBResult) -> *const std::os::raw::c_char {
         AniDBResult::ErrorVersionMismatch => 10,
         AniDBResult::ErrorTimeout => 11,
         AniDBResult::ErrorPermissionDenied => 12,
-        AniDBResult::ErrorBusy => 13,
-        AniDBResult::ErrorUnknown => 14,
+        AniDBResult::ErrorCache => 13,
+        AniDBResult::ErrorBusy => 14,
+        AniDBResult::ErrorUnknown => 15,
     };
 
     ERROR_STRINGS[index].as_ptr() as *const std::os::raw::c_char
@@ -7,7 +7,7 @@
 use crate::buffer::get_memory_limit;
 #[cfg(test)]
 use crate::memory::clear_pools;
-use crate::memory::{allocate, diagnostics, memory_used, release};
+use crate::memory::{allocate, diagnostics, memory_used, pooled_memory, release};
 use std::collections::HashMap;
 use std::ffi::CString;
 use std::os::raw::c_char;
@@ -91,9 +91,12 @@ impl AllocationTracker {
             timestamp: Self::current_timestamp(),
         };
 
-        if let Ok(mut allocations) = self.allocations.lock() {
-            allocations.insert(addr, info);
-        }
+        // Result blocks are found through this map when freed, so a
+        // poisoned lock must not drop the entry
+        self.allocations
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .insert(addr, info);
 
         self.total_allocations.fetch_add(1, Ordering::Relaxed);
 
@@ -110,9 +113,12 @@ impl AllocationTracker {
 
         let addr = ptr as usize;
 
-        if let Ok(mut allocations) = self.allocations.lock()
-            && let Some(info) = allocations.remove(&addr)
-        {
+        let removed = self
+            .allocations
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .remove(&addr);
+        if let Some(info) = removed {
             self.total_deallocations.fetch_add(1, Ordering::Relaxed);
             self.current_allocated
                 .fetch_sub(info.size, Ordering::AcqRel);
@@ -276,7 +282,7 @@ pub fn get_memory_stats() -> MemoryStats {
         total_memory_used: memory_used(),
         ffi_allocated: allocation_stats.current_allocated,
         ffi_peak: allocation_stats.peak_allocated,
-        pool_memory: diag.memory_used,
+        pool_memory: pooled_memory(),
         pool_hits: stats.pool_hits.load(std::sync::atomic::Ordering::Relaxed),
         pool_misses: stats.pool_misses.load(std::sync::atomic::Ordering::Relaxed),
         active_allocations: allocation_stats.active_allocations,
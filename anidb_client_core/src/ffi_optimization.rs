@@ -118,6 +118,7 @@ pub fn create_hash_result_zero_copy(
         algorithm,
         hash_value: buffer.as_mut_ptr() as *mut c_char,
         hash_length: hash_bytes.len(),
+        hash_time_us: 0,
     })
 }
 
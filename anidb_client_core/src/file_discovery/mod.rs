@@ -2,14 +2,15 @@
 //!
 //! This module provides functionality to discover files in directories
 //! based on include and exclude glob patterns, with support for default
-//! media file extensions.
+//! media file extensions. The CLI uses it directly and the FFI drives it
+//! from `anidb_scan_and_process`, which hashes files while the walk is
+//! still running.
 
 mod extensions;
 mod filter;
 mod walker;
 
-#[allow(unused_imports)]
-pub use walker::{FileDiscovery, FileDiscoveryOptions};
+pub use walker::{FileDiscovery, FileDiscoveryOptions, discover_files};
 
 use std::path::PathBuf;
 
@@ -88,8 +88,9 @@ impl FileDiscoveryOptions {
 
 /// File discovery iterator for streaming file enumeration
 pub struct FileDiscovery {
-    /// Walker for directory traversal
-    walker: Box<dyn Iterator<Item = walkdir::Result<DirEntry>>>,
+    /// Walker for directory traversal, sendable so a scan can run it on
+    /// its own thread
+    walker: Box<dyn Iterator<Item = walkdir::Result<DirEntry>> + Send>,
     /// File filter for pattern matching
     filter: FileFilter,
     /// Options used for discovery
@@ -2,13 +2,28 @@
 //!
 //! This module contains file processing functionality using the streaming pipeline architecture.
 
-use crate::hashing::{HashAlgorithm, HashCalculator};
-use crate::pipeline::{HashingStage, PipelineConfig, StreamingPipelineBuilder, ValidationStage};
+use crate::cache::{CacheOptions, FileIdentity, HashCache};
+use crate::hashing::{
+    ChunkDigests, ChunkParallelStrategy, ChunkedReads, Ed2kVariant, HashAlgorithm, HashCalculator,
+    HashConfig, HashingContext, HashingStrategy, QuickFingerprint, hash_file_chunks,
+};
+use crate::metrics::{ProcessingMetrics, StageTimings};
+use crate::pipeline::{
+    DEFAULT_QUEUE_DEPTH, FingerprintStage, HashingStage, PipelineConfig, StreamingPipelineBuilder,
+    ValidationStage,
+};
+use crate::platform::device_id_for_path;
+use crate::progress::ProgressUpdate;
+use crate::scheduler::{
+    CpuPool, MAX_READERS_PER_DEVICE, ReaderGate, group_by_device, run_device_queues,
+};
+use crate::tuning::{AutoTuner, TunedValues};
 use crate::{ClientConfig, Error, ProgressProvider, Result, error::IoError};
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
 use std::path::{Path, PathBuf};
-use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex};
 use std::time::{Duration, Instant};
 
 /// Processing status for files
@@ -28,6 +43,8 @@ pub struct FileProcessingResult {
     pub hashes: HashMap<HashAlgorithm, String>,
     pub status: ProcessingStatus,
     pub processing_time: Duration,
+    /// Where the processing time went
+    pub timings: StageTimings,
 }
 
 /// File processor for handling file operations
@@ -35,6 +52,10 @@ pub struct FileProcessingResult {
 pub struct FileProcessor {
     config: ClientConfig,
     hash_calculator: HashCalculator,
+    cache: Option<Arc<HashCache>>,
+    metrics: Arc<ProcessingMetrics>,
+    /// Picks read sizes and readers when auto tuning is enabled
+    tuner: Option<Arc<AutoTuner>>,
 }
 
 impl FileProcessor {
@@ -60,43 +81,318 @@ impl FileProcessor {
 
         let selector = StrategySelector::with_hint(hint);
         let hash_calculator = HashCalculator::with_selector(selector);
+        let tuner = config.auto_tune.then(|| Arc::new(AutoTuner::new(&config)));
 
         Self {
             config,
             hash_calculator,
+            cache: None,
+            metrics: Arc::new(ProcessingMetrics::default()),
+            tuner,
         }
     }
 
-    /// Create with custom adaptive buffers (now uses simple buffers)
+    /// Look up and record hashes in `cache`
+    ///
+    /// Files whose identity is cached skip hashing entirely; only algorithms
+    /// missing from the entry are computed.
+    pub fn with_cache(mut self, cache: Arc<HashCache>) -> Self {
+        self.cache = Some(cache);
+        self
+    }
+
+    /// The hash cache consulted by this processor, if any
+    pub fn cache(&self) -> Option<&Arc<HashCache>> {
+        self.cache.as_ref()
+    }
+
+    /// Counters of every file processed through
+    /// [`process_file_with_options`](Self::process_file_with_options)
+    pub fn metrics(&self) -> &Arc<ProcessingMetrics> {
+        &self.metrics
+    }
+
+    /// Tuner adjusting read sizes and readers, when auto tuning is enabled
+    pub fn tuner(&self) -> Option<&Arc<AutoTuner>> {
+        self.tuner.as_ref()
+    }
+
+    /// Chunk size, hashing queue depth and readers per device in use
+    pub fn tuned_values(&self) -> TunedValues {
+        let mut values = match &self.tuner {
+            Some(tuner) => tuner.snapshot(),
+            None => TunedValues::from_config(&self.config),
+        };
+        // The chunk size depends on the algorithms of each file
+        if let Some(read_size) = self.metrics.last_read_size() {
+            values.chunk_size = read_size;
+        }
+        values
+    }
+
+    /// Gate bounding the readers of `device`
+    ///
+    /// Tuned per device with auto tuning, and otherwise a fixed `readers`.
+    pub fn reader_gate(&self, device: u64, readers: usize) -> Arc<ReaderGate> {
+        match &self.tuner {
+            Some(tuner) => tuner.reader_gate(device),
+            None => Arc::new(ReaderGate::fixed(readers)),
+        }
+    }
+
+    /// Create with custom adaptive buffers
+    ///
+    /// Buffers adapt through the auto tuner, which this enables whatever
+    /// `config` says.
     pub fn new_with_custom_adaptive_buffers(
         config: ClientConfig,
         _adaptive_config: Option<()>, // Reserved for future use
     ) -> Self {
-        // Just use the regular constructor
-        Self::new(config)
+        Self::new(ClientConfig {
+            auto_tune: true,
+            ..config
+        })
     }
 
     /// Process a single file with the specified algorithms using the streaming pipeline
+    ///
+    /// With a cache attached, the file is stat'ed first and hashes already
+    /// cached for its identity are returned without reading it.
     pub async fn process_file(
         &self,
         file_path: &Path,
         algorithms: &[HashAlgorithm],
         progress_provider: Arc<dyn ProgressProvider>,
     ) -> Result<FileProcessingResult> {
+        self.process_file_with_options(
+            file_path,
+            algorithms,
+            progress_provider,
+            CacheOptions::default(),
+        )
+        .await
+    }
+
+    /// Process a single file, choosing how the cache is used
+    ///
+    /// With [`CacheOptions::partial_rehash`], ED2K and CRC32 are computed
+    /// chunk by chunk and the chunk digests are cached; a file that changed
+    /// since it was last cached only has the chunks that look different
+    /// read again.
+    pub async fn process_file_with_options(
+        &self,
+        file_path: &Path,
+        algorithms: &[HashAlgorithm],
+        progress_provider: Arc<dyn ProgressProvider>,
+        options: CacheOptions,
+    ) -> Result<FileProcessingResult> {
+        let _in_flight = self.metrics.start_file();
+        let start_time = Instant::now();
+        let result = self
+            .lookup_or_hash(file_path, algorithms, progress_provider, options)
+            .await;
+        match &result {
+            Ok(processed) => self
+                .metrics
+                .record_completed(start_time.elapsed(), &processed.timings),
+            Err(_) => self.metrics.record_failed(start_time.elapsed()),
+        }
+        result
+    }
+
+    /// Answer from the cache what it holds and hash the rest
+    async fn lookup_or_hash(
+        &self,
+        file_path: &Path,
+        algorithms: &[HashAlgorithm],
+        progress_provider: Arc<dyn ProgressProvider>,
+        options: CacheOptions,
+    ) -> Result<FileProcessingResult> {
+        let Some(cache) = &self.cache else {
+            return self
+                .hash_file(file_path, algorithms, progress_provider)
+                .await;
+        };
+
+        let start_time = Instant::now();
+        let Ok(metadata) = tokio::fs::metadata(file_path).await else {
+            // Let the pipeline report the error
+            return self
+                .hash_file(file_path, algorithms, progress_provider)
+                .await;
+        };
+
+        let identity = FileIdentity::from_metadata(file_path, &metadata);
+        let mut cached = if options.verify_existing {
+            HashMap::new()
+        } else {
+            cache.get(&identity).unwrap_or_default()
+        };
+        cached.retain(|algorithm, _| algorithms.contains(algorithm));
+        let missing: Vec<HashAlgorithm> = algorithms
+            .iter()
+            .copied()
+            .filter(|algorithm| !cached.contains_key(algorithm))
+            .collect();
+        if !options.verify_existing {
+            self.metrics.record_cache_lookup(missing.is_empty());
+        }
+        let lookup_time = start_time.elapsed();
+
+        if missing.is_empty() {
+            progress_provider.complete();
+            return Ok(FileProcessingResult {
+                file_path: file_path.to_path_buf(),
+                file_size: identity.size,
+                hashes: cached,
+                status: ProcessingStatus::Completed,
+                processing_time: start_time.elapsed(),
+                timings: StageTimings {
+                    cache_lookup: lookup_time,
+                    ..Default::default()
+                },
+            });
+        }
+
+        // Fingerprint the contents for prefilter lookups, unless an earlier
+        // pass over the same identity already did
+        let needs_fingerprint = cache.fingerprint(&identity).is_none();
+        let (mut result, chunks, fingerprint) =
+            if options.partial_rehash && missing.contains(&HashAlgorithm::ED2K) {
+                // Verifying means reading everything, so nothing is reused
+                let previous = (!options.verify_existing)
+                    .then(|| cache.previous_chunks(&identity))
+                    .flatten();
+                let (mut result, chunks) = self
+                    .hash_file_chunked(file_path, &missing, previous, progress_provider)
+                    .await?;
+                // Reused chunks are never read, so sample the file instead
+                let fingerprint = if needs_fingerprint {
+                    let fingerprint_start = Instant::now();
+                    let fingerprint = self.fingerprint_file(file_path).await;
+                    result.timings.read += fingerprint_start.elapsed();
+                    fingerprint
+                } else {
+                    None
+                };
+                (result, Some(chunks), fingerprint)
+            } else {
+                let (result, fingerprint) = self
+                    .hash_file_sampled(file_path, &missing, progress_provider, needs_fingerprint)
+                    .await?;
+                (result, None, fingerprint)
+            };
+
+        // Only trust the hashes if the file did not change while it was read
+        let verify_start = Instant::now();
+        let unchanged = tokio::fs::metadata(file_path)
+            .await
+            .is_ok_and(|after| FileIdentity::from_metadata(file_path, &after) == identity);
+        if unchanged {
+            cache.insert_with_chunks(identity, &result.hashes, chunks);
+            if let Some(fingerprint) = fingerprint {
+                cache.record_fingerprint(identity, fingerprint);
+            }
+        }
+
+        result.hashes.extend(cached);
+        result.processing_time = start_time.elapsed();
+        result.timings.cache_lookup = lookup_time + verify_start.elapsed();
+        Ok(result)
+    }
+
+    /// Sample the quick fingerprint of a file on a blocking thread
+    async fn fingerprint_file(&self, file_path: &Path) -> Option<QuickFingerprint> {
+        let path = file_path.to_path_buf();
+        let (fingerprint, bytes_read) =
+            tokio::task::spawn_blocking(move || QuickFingerprint::from_path(&path))
+                .await
+                .ok()?
+                .ok()?;
+        self.metrics.add_bytes_read(bytes_read);
+        Some(fingerprint)
+    }
+
+    /// Hash a file ED2K chunk by chunk, reusing digests from `previous`
+    /// for chunks that look unchanged
+    async fn hash_file_chunked(
+        &self,
+        file_path: &Path,
+        algorithms: &[HashAlgorithm],
+        previous: Option<Arc<ChunkDigests>>,
+        progress_provider: Arc<dyn ProgressProvider>,
+    ) -> Result<(FileProcessingResult, ChunkDigests)> {
         let start_time = Instant::now();
 
         if !file_path.exists() {
             return Err(Error::Io(IoError::file_not_found(file_path)));
         }
 
-        let metadata = tokio::fs::metadata(file_path).await?;
-        let file_size = metadata.len();
+        let reads = ChunkedReads {
+            io_mode: self.config.io_mode,
+            read_ahead: self.chunked_read_ahead(),
+        };
+        let hash_start = Instant::now();
+        let chunked = hash_file_chunks(
+            file_path,
+            algorithms,
+            previous.as_deref(),
+            Ed2kVariant::Red,
+            reads,
+            progress_provider.as_ref(),
+        )
+        .await?;
+        self.metrics.add_bytes_read(chunked.bytes_read);
+
+        let result = FileProcessingResult {
+            file_path: file_path.to_path_buf(),
+            file_size: chunked.chunks.file_size,
+            hashes: chunked.hashes,
+            status: ProcessingStatus::Completed,
+            processing_time: start_time.elapsed(),
+            // Reads are not timed apart from hashing here
+            timings: StageTimings {
+                pool_wait: chunked.slot_wait,
+                hash: hash_start.elapsed().saturating_sub(chunked.slot_wait),
+                ..Default::default()
+            },
+        };
+        Ok((result, chunked.chunks))
+    }
 
-        // Determine optimal buffer size based on algorithms and memory constraints
+    /// Bytes of ED2K chunks a partial rehash reads ahead of hashing
+    fn chunked_read_ahead(&self) -> usize {
+        match &self.tuner {
+            Some(tuner) => tuner.read_size(true),
+            // The tuner's budget: half the memory, shared by the files in flight
+            None => self.config.max_memory_usage / 2 / self.config.max_concurrent_files.max(1),
+        }
+    }
+
+    /// Hash a file through the streaming pipeline
+    async fn hash_file(
+        &self,
+        file_path: &Path,
+        algorithms: &[HashAlgorithm],
+        progress_provider: Arc<dyn ProgressProvider>,
+    ) -> Result<FileProcessingResult> {
+        let (result, _) = self
+            .hash_file_sampled(file_path, algorithms, progress_provider, false)
+            .await?;
+        Ok(result)
+    }
+
+    /// Bytes to read per pipeline step when hashing with `algorithms`
+    fn read_size(&self, algorithms: &[HashAlgorithm]) -> usize {
         let includes_ed2k = algorithms.contains(&HashAlgorithm::ED2K);
-        let multiple_algorithms = algorithms.len() > 1;
 
-        let mut buffer_size = if self.config.max_memory_usage < 100 * 1024 * 1024 {
+        if let Some(tuner) = &self.tuner {
+            // Whole ED2K chunks when hashing ED2K, bounded by the memory budget
+            return tuner.read_size(includes_ed2k);
+        }
+
+        // Determine optimal buffer size based on algorithms and memory constraints
+        let buffer_size = if self.config.max_memory_usage < 100 * 1024 * 1024 {
             // Very constrained environments: keep small to avoid memory pressure
             16 * 1024 // 16KB
         } else if self.config.max_memory_usage < 200 * 1024 * 1024 {
@@ -107,17 +403,42 @@ impl FileProcessor {
 
         // For ED2K, prefer ED2K chunk size to minimize overhead and match semantics
         if includes_ed2k {
-            buffer_size = buffer_size.max(9_728_000);
-        } else if multiple_algorithms {
+            buffer_size.max(9_728_000)
+        } else if algorithms.len() > 1 {
             // For multiple algorithms without ED2K, use a larger chunk to reduce per-chunk overhead
-            buffer_size = buffer_size.max(1024 * 1024); // 1MB
+            buffer_size.max(1024 * 1024) // 1MB
+        } else {
+            buffer_size
+        }
+    }
+
+    /// Hash a file through the streaming pipeline, computing its quick
+    /// fingerprint from the same reads when `fingerprint` is set
+    async fn hash_file_sampled(
+        &self,
+        file_path: &Path,
+        algorithms: &[HashAlgorithm],
+        progress_provider: Arc<dyn ProgressProvider>,
+        fingerprint: bool,
+    ) -> Result<(FileProcessingResult, Option<QuickFingerprint>)> {
+        let start_time = Instant::now();
+
+        if !file_path.exists() {
+            return Err(Error::Io(IoError::file_not_found(file_path)));
         }
 
+        let metadata = tokio::fs::metadata(file_path).await?;
+        let file_size = metadata.len();
+
+        let buffer_size = self.read_size(algorithms);
+        self.metrics.record_read_size(buffer_size);
+
         // Build the streaming pipeline with stages
         let pipeline_config = PipelineConfig {
             chunk_size: buffer_size,
             parallel_stages: false, // Keep sequential for now
             max_memory: self.config.max_memory_usage,
+            io_mode: self.config.io_mode,
         };
 
         // Create pipeline stages
@@ -128,19 +449,52 @@ impl FileProcessor {
         );
 
         // Create hashing stage with progress provider
-        let hashing_stage = Box::new(HashingStage::new_with_progress(
-            algorithms,
-            progress_provider.clone(),
-        ));
+        let queue_depth = self
+            .tuner
+            .as_ref()
+            .map_or(DEFAULT_QUEUE_DEPTH, |tuner| tuner.queue_depth());
+        // Large ED2K files on fast devices spread their chunks across cores,
+        // when the chunk-parallel strategy would otherwise be picked
+        let chunk_parallel = ChunkParallelStrategy::with_defaults();
+        let ed2k_workers = if chunk_parallel.is_suitable(&HashingContext {
+            file_path: file_path.to_path_buf(),
+            file_size,
+            algorithms: algorithms.to_vec(),
+            config: HashConfig::default(),
+        }) {
+            CpuPool::global().size()
+        } else {
+            1
+        };
+        let hashing_stage = Box::new(
+            HashingStage::new_with_progress(algorithms, progress_provider.clone())
+                .with_queue_depth(queue_depth)
+                .with_ed2k_workers(ed2k_workers),
+        );
 
         // Build and execute the pipeline
-        let mut pipeline = StreamingPipelineBuilder::with_config(pipeline_config)
+        let mut builder = StreamingPipelineBuilder::with_config(pipeline_config)
             .add_stage(validation_stage)
-            .add_stage(hashing_stage)
-            .build();
+            .add_stage(hashing_stage);
+        if fingerprint {
+            builder = builder.add_stage(Box::new(FingerprintStage::new()));
+        }
+        let mut pipeline = builder.cpu_pool(CpuPool::global()).build();
 
         // Process the file through the pipeline
-        let _stats = pipeline.process_file(file_path).await?;
+        let stats = pipeline.process_file(file_path).await?;
+        self.metrics.add_bytes_read(stats.bytes_processed);
+        if let Some(strategy) = stats.io_strategy {
+            self.metrics.record_read_strategy(strategy);
+        }
+
+        let mut timings = StageTimings {
+            open: stats.open_duration,
+            read: stats.read_duration,
+            pool_wait: stats.wait_duration,
+            hash: stats.stage_duration,
+            ..Default::default()
+        };
 
         // Extract hash results from the hashing stage (now at index 1 after reordering)
         let hashes = if let Some(hashing_stage) = pipeline.stage_mut(1) {
@@ -148,6 +502,11 @@ impl FileProcessor {
                 .as_any_mut()
                 .and_then(|any| any.downcast_mut::<HashingStage>())
             {
+                // Waiting on busy workers or for a CPU slot is not hashing
+                let waited = hashing.backpressure_wait() + hashing.slot_wait();
+                timings.pool_wait += waited;
+                timings.hash = timings.hash.saturating_sub(waited);
+                timings.hash_by_algorithm = hashing.algorithm_times().clone();
                 hashing.take_results().unwrap_or_default()
             } else {
                 HashMap::new()
@@ -156,13 +515,21 @@ impl FileProcessor {
             HashMap::new()
         };
 
-        Ok(FileProcessingResult {
+        let fingerprint = pipeline
+            .stage_mut(2)
+            .and_then(|stage| stage.as_any_mut())
+            .and_then(|any| any.downcast_mut::<FingerprintStage>())
+            .and_then(|stage| stage.fingerprint());
+
+        let result = FileProcessingResult {
             file_path: file_path.to_path_buf(),
             file_size,
             hashes,
             status: ProcessingStatus::Completed,
             processing_time: start_time.elapsed(),
-        })
+            timings,
+        };
+        Ok((result, fingerprint))
     }
 
     /// Process a single file with the specified algorithms using legacy direct approach
@@ -244,40 +611,112 @@ impl FileProcessor {
             hashes,
             status: ProcessingStatus::Completed,
             processing_time: start_time.elapsed(),
+            timings: StageTimings::default(),
         })
     }
 
     /// Process multiple files concurrently
+    ///
+    /// Files are grouped by the device that stores them. Each device is read
+    /// by at most `max_concurrent_files` (capped at
+    /// [`MAX_READERS_PER_DEVICE`]) sequential readers, or as many as the
+    /// auto tuner allows, and hashing across all devices shares the global
+    /// [`CpuPool`]. Per-device throughput is reported as
+    /// [`ProgressUpdate::DeviceProgress`] after each file.
+    ///
+    /// Results are returned in input order. Processing stops scheduling new
+    /// files after the first failure, whose error is returned.
     pub async fn process_files_concurrent(
         &self,
         file_paths: Vec<PathBuf>,
         algorithms: &[HashAlgorithm],
         progress_provider: &dyn ProgressProvider,
     ) -> Result<Vec<FileProcessingResult>> {
-        use futures::stream::{FuturesUnordered, StreamExt};
-
-        let mut futures = FuturesUnordered::new();
-        let algorithms = algorithms.to_vec();
-
-        for file_path in file_paths {
-            let algorithms = algorithms.clone();
-            let child_provider =
-                progress_provider.create_child(&format!("File {}", file_path.display()));
-            let processor = FileProcessor::new(self.config.clone());
-
-            futures.push(async move {
-                processor
-                    .process_file(&file_path, &algorithms, Arc::from(child_provider))
-                    .await
-            });
+        let total = file_paths.len();
+        let jobs = file_paths.into_iter().enumerate().map(|(index, path)| {
+            let child: Arc<dyn ProgressProvider> =
+                Arc::from(progress_provider.create_child(&format!("File {}", path.display())));
+            (device_id_for_path(&path), (index, path, child))
+        });
+        let queues: Vec<_> = group_by_device(jobs).into_iter().map(Arc::new).collect();
+
+        let readers_per_device = self
+            .config
+            .max_concurrent_files
+            .clamp(1, MAX_READERS_PER_DEVICE);
+        let device_provider: Arc<dyn ProgressProvider> =
+            Arc::from(progress_provider.create_child("Devices"));
+        let mut processor = FileProcessor::new(self.config.clone());
+        processor.cache = self.cache.clone();
+        processor.metrics = self.metrics.clone();
+        processor.tuner = self.tuner.clone();
+        let processor = Arc::new(processor);
+        let gate_processor = processor.clone();
+        let algorithms: Arc<[HashAlgorithm]> = algorithms.into();
+        let results: Arc<Mutex<Vec<Option<Result<FileProcessingResult>>>>> =
+            Arc::new(Mutex::new((0..total).map(|_| None).collect()));
+        let failed = Arc::new(AtomicBool::new(false));
+
+        let slots = results.clone();
+        run_device_queues(
+            queues,
+            move |device| gate_processor.reader_gate(device, readers_per_device),
+            move |(index, path, child), stats| {
+                let processor = processor.clone();
+                let algorithms = algorithms.clone();
+                let device_provider = device_provider.clone();
+                let slots = slots.clone();
+                let failed = failed.clone();
+
+                async move {
+                    if failed.load(Ordering::Acquire) {
+                        return;
+                    }
+
+                    stats.start();
+                    let result = processor.process_file(&path, &algorithms, child).await;
+                    stats.complete_file(result.as_ref().map(|r| r.file_size).unwrap_or(0));
+                    if let (Some(tuner), Ok(processed)) = (processor.tuner(), &result) {
+                        tuner.record_file(stats.device(), processed);
+                    }
+                    if result.is_err() {
+                        failed.store(true, Ordering::Release);
+                    }
+
+                    let snapshot = stats.snapshot();
+                    device_provider.report(ProgressUpdate::DeviceProgress {
+                        device: snapshot.device,
+                        files_completed: snapshot.files_completed,
+                        files_total: snapshot.files_total,
+                        bytes_processed: snapshot.bytes_processed,
+                        throughput_mbps: snapshot.throughput_mbps,
+                    });
+
+                    if let Ok(mut slots) = slots.lock() {
+                        slots[index] = Some(result);
+                    }
+                }
+            },
+        )
+        .await;
+
+        let slots = std::mem::take(&mut *results.lock().unwrap_or_else(|e| e.into_inner()));
+        let mut processed = Vec::with_capacity(total);
+        let mut first_error = None;
+        for slot in slots {
+            match slot {
+                Some(Ok(result)) => processed.push(result),
+                Some(Err(e)) => {
+                    first_error.get_or_insert(e);
+                }
+                None => {}
+            }
         }
 
-        let mut results = Vec::new();
-        while let Some(result) = futures.next().await {
-            results.push(result?);
+        match first_error {
+            Some(e) => Err(e),
+            None => Ok(processed),
         }
-
-        Ok(results)
     }
 }
 
@@ -477,6 +916,11 @@ mod tests {
             );
             assert!(result.hashes.contains_key(&HashAlgorithm::ED2K));
         }
+
+        // The batch counts towards this processor's metrics
+        let metrics = processor.metrics().snapshot();
+        assert_eq!(metrics.files_processed, 5);
+        assert_eq!(metrics.in_flight, 0);
     }
 
     #[tokio::test]
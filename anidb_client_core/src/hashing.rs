@@ -17,19 +17,32 @@ use std::time::{Duration, Instant};
 // New trait system modules
 mod algorithms;
 mod buffer_ring;
+mod chunk_digests;
+mod fingerprint;
+mod kernels;
 mod parallel;
 mod registry;
 mod strategies;
 mod traits;
 
 // Re-export public types from trait system
+pub use chunk_digests::{
+    ChunkDigests, ChunkedHashes, ChunkedReads, ED2K_CHUNK_SIZE, hash_file_chunks,
+};
+pub use fingerprint::{
+    FINGERPRINT_BLOCK_SIZE, FINGERPRINT_BLOCKS, FingerprintSampler, QuickFingerprint,
+};
+pub use kernels::{Crc32Kernel, HashKernels, Md4Kernel};
 pub use parallel::{ChunkData, ParallelConfig};
 pub use registry::AlgorithmRegistry;
 pub use strategies::{
-    HashConfig, HashingStrategy, HybridStrategy, ParallelStrategy, StrategyHint, StrategySelector,
+    ChunkParallelStrategy, HashConfig, HashingContext, HashingStrategy, HybridStrategy,
+    MultiHasher, ParallelStrategy, StrategyHint, StrategySelector,
 };
 pub use traits::{HashAlgorithmExt, HashAlgorithmImpl, StreamingHasher};
 
+pub(crate) use algorithms::ed2k::root_hash as ed2k_root_hash;
+
 /// Hash algorithms supported by the client
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Serialize, Deserialize)]
 pub enum HashAlgorithm {
@@ -1,19 +1,19 @@
 //! CRC32 hash algorithm implementation
 
+use crate::hashing::kernels::Crc32State;
 use crate::hashing::traits::{HashAlgorithmImpl, StreamingHasher};
-use crc32fast::Hasher as Crc32Hasher;
 
 pub struct Crc32Algorithm;
 
 /// CRC32 streaming hasher
 struct Crc32StreamingHasher {
-    hasher: Crc32Hasher,
+    hasher: Crc32State,
 }
 
 impl Crc32StreamingHasher {
     fn new() -> Self {
         Self {
-            hasher: Crc32Hasher::new(),
+            hasher: Crc32State::new(),
         }
     }
 }
@@ -1,6 +1,7 @@
 //! ED2K hash algorithm implementation
 
 use crate::hashing::Ed2kVariant;
+use crate::hashing::kernels;
 use crate::hashing::traits::{HashAlgorithmImpl, StreamingHasher};
 use md4::{Digest, Md4};
 
@@ -73,6 +74,16 @@ impl StreamingHasher for Ed2kStreamingHasher {
         let mut remaining = data;
 
         while !remaining.is_empty() {
+            // Whole chunks arriving at a chunk boundary are hashed straight
+            // from the input, several at a time with the multi-buffer kernel
+            if self.accumulator_size == 0 && remaining.len() >= Self::CHUNK_SIZE {
+                let (whole, rest) = remaining.as_chunks::<{ Self::CHUNK_SIZE }>();
+                let chunks: Vec<&[u8]> = whole.iter().map(|chunk| chunk.as_slice()).collect();
+                kernels::md4_chunks(&chunks, &mut self.chunk_hashes);
+                remaining = rest;
+                continue;
+            }
+
             let space_in_accumulator = Self::CHUNK_SIZE - self.accumulator_size;
             let to_copy = remaining.len().min(space_in_accumulator);
 
@@ -91,51 +102,51 @@ impl StreamingHasher for Ed2kStreamingHasher {
     }
 
     fn finalize(mut self: Box<Self>) -> String {
-        if self.bytes_processed == 0 {
-            // Empty file
-            return format!("{:x}", Md4::new().finalize());
-        }
-
-        if self.bytes_processed < Self::CHUNK_SIZE {
-            // File smaller than one chunk (not equal)
-            let mut hasher = Md4::new();
-            hasher.update(&self.accumulator[..self.accumulator_size]);
-            return format!("{:x}", hasher.finalize());
-        }
-
-        // Process any remaining data (including exactly one chunk)
+        // Hash the final partial chunk, or the whole file if it is smaller
+        // than one chunk
         if self.accumulator_size > 0 {
             self.process_chunk();
         }
 
-        // Special case: exactly one chunk
-        if self.bytes_processed == Self::CHUNK_SIZE
-            && (self.variant == Ed2kVariant::Blue || self.chunk_hashes.len() == 16)
-        {
-            // Blue variant or only one chunk hash: return the chunk hash directly
-            let mut result = String::new();
-            for byte in &self.chunk_hashes[..16] {
-                result.push_str(&format!("{byte:02x}"));
-            }
-            return result;
-        }
-        // Red variant falls through to handle multiple chunks with empty hash
-
-        // Red variant: If file size is exact multiple of chunk size,
-        // append MD4 hash of empty data
-        if self.variant == Ed2kVariant::Red && self.bytes_processed.is_multiple_of(Self::CHUNK_SIZE)
-        {
-            let mut empty_hasher = Md4::new();
-            empty_hasher.update(b"");
-            self.chunk_hashes
-                .extend_from_slice(&empty_hasher.finalize());
-        }
+        root_hash(self.chunk_hashes, self.bytes_processed as u64, self.variant)
+    }
+}
+
+/// Combine per-chunk MD4 digests, in file order, into the ED2K hash
+///
+/// `chunk_hashes` holds one 16-byte digest per chunk, the last one covering
+/// the final partial chunk if there is one.
+pub(crate) fn root_hash(
+    mut chunk_hashes: Vec<u8>,
+    total_bytes: u64,
+    variant: Ed2kVariant,
+) -> String {
+    if total_bytes == 0 {
+        // Empty file
+        return format!("{:x}", Md4::new().finalize());
+    }
+
+    if chunk_hashes.len() == 16 {
+        // A single chunk, either smaller than or exactly one chunk size: its
+        // hash is the file hash for both variants
+        return chunk_hashes
+            .iter()
+            .map(|byte| format!("{byte:02x}"))
+            .collect();
+    }
 
-        // Hash all chunk hashes
-        let mut final_hasher = Md4::new();
-        final_hasher.update(&self.chunk_hashes);
-        format!("{:x}", final_hasher.finalize())
+    // Red variant: If file size is exact multiple of chunk size,
+    // append MD4 hash of empty data
+    if variant == Ed2kVariant::Red
+        && total_bytes.is_multiple_of(Ed2kStreamingHasher::CHUNK_SIZE as u64)
+    {
+        chunk_hashes.extend_from_slice(&Md4::new().finalize());
     }
+
+    // Hash all chunk hashes
+    let mut final_hasher = Md4::new();
+    final_hasher.update(&chunk_hashes);
+    format!("{:x}", final_hasher.finalize())
 }
 
 impl HashAlgorithmImpl for Ed2kAlgorithm {
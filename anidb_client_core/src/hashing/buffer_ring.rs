@@ -213,6 +213,25 @@ impl BufferRing {
     pub async fn write_next<R: tokio::io::AsyncRead + Unpin>(
         &self,
         reader: &mut R,
+    ) -> Result<Option<usize>> {
+        self.write_chunk(reader, false).await
+    }
+
+    /// Write the next chunk, reading until the slot is full or the file ends
+    ///
+    /// Every chunk but the last then holds exactly one slot's worth of data,
+    /// as needed by consumers that hash fixed-size blocks independently.
+    pub async fn write_next_full<R: tokio::io::AsyncRead + Unpin>(
+        &self,
+        reader: &mut R,
+    ) -> Result<Option<usize>> {
+        self.write_chunk(reader, true).await
+    }
+
+    async fn write_chunk<R: tokio::io::AsyncRead + Unpin>(
+        &self,
+        reader: &mut R,
+        fill: bool,
     ) -> Result<Option<usize>> {
         use tokio::io::AsyncReadExt;
 
@@ -220,7 +239,13 @@ impl BufferRing {
         let (slot, mut buffer) = self.get_write_slot().await?;
 
         // Read from the file
-        let n = reader.read(&mut buffer).await?;
+        let mut n = reader.read(&mut buffer).await?;
+        while fill && n > 0 && n < buffer.len() {
+            match reader.read(&mut buffer[n..]).await? {
+                0 => break,
+                read => n += read,
+            }
+        }
 
         if n == 0 {
             // End of file - we need to release the slot we acquired
@@ -516,4 +541,26 @@ mod tests {
             assert_eq!(slow_chunks[i].data()[0], i as u8);
         }
     }
+
+    #[tokio::test]
+    async fn test_write_next_full_fills_slots() {
+        use tokio::io::AsyncReadExt;
+
+        let _guard = TEST_MUTEX.lock().await;
+        crate::buffer::reset_memory_tracking();
+
+        let ring = Arc::new(BufferRing::new(1024, 1).unwrap());
+        let cursor = ring.create_cursor();
+
+        // Chained readers return short reads at every boundary
+        let data = vec![7u8; 2500];
+        let mut reader = (&data[..300]).chain(&data[300..1700]).chain(&data[1700..]);
+
+        let mut sizes = vec![];
+        while let Some(n) = ring.write_next_full(&mut reader).await.unwrap() {
+            sizes.push(n);
+            drop(cursor.read().await.unwrap());
+        }
+        assert_eq!(sizes, vec![1024, 1024, 452]);
+    }
 }
@@ -0,0 +1,659 @@
+//! Per-chunk ED2K digests for partial rehashing
+//!
+//! An ED2K hash is the MD4 of the MD4 digests of each 9.5MB chunk, so when
+//! a file has data appended or a region rewritten only the chunks whose
+//! bytes changed need to be read again. Next to each chunk digest a cheap
+//! sample (CRC32 of the first and last 4 KiB of the chunk) is kept. On a
+//! rehash, a chunk whose length and sample still match is taken as
+//! unchanged and its digest reused.
+//!
+//! Each chunk's CRC32 is kept as well. CRC32s of consecutive ranges can be
+//! combined without the data, so a file's CRC32 is rebuilt from reused and
+//! re-read chunks alike.
+//!
+//! Sampling is a heuristic: an edit that leaves both sampled windows of a
+//! chunk intact goes unnoticed. Appends and remuxes, which extend the file
+//! or rewrite whole regions, are caught.
+
+use super::algorithms::ed2k::root_hash;
+use super::kernels::md4_chunks;
+use super::{Ed2kVariant, HashAlgorithm, MultiHasher};
+use crate::platform::{ChunkReader, IoMode};
+use crate::progress::{ProgressProvider, ProgressUpdate};
+use crate::scheduler::CpuPool;
+use crate::{Error, Result, error::InternalError};
+use std::collections::HashMap;
+use std::path::Path;
+use std::time::{Duration, Instant};
+use tokio::fs::File;
+use tokio::io::{AsyncReadExt, AsyncSeekExt, SeekFrom};
+
+/// ED2K chunk size
+pub const ED2K_CHUNK_SIZE: u64 = 9_728_000;
+
+/// Bytes sampled at each end of a chunk
+const SAMPLE_SIZE: usize = 4096;
+
+/// Most whole chunks read and hashed together, so the multi-buffer MD4
+/// kernels get several lanes of work
+const CHUNKS_PER_READ: usize = 4;
+
+/// Bytes taken from the reader at a time while filling a group of chunks
+const READ_SIZE: usize = 1024 * 1024;
+
+/// How [`hash_file_chunks`] reads a file
+#[derive(Debug, Clone, Copy)]
+pub struct ChunkedReads {
+    /// How chunks are read from disk
+    pub io_mode: IoMode,
+    /// Bytes of chunks read ahead of hashing, rounded down to whole chunks
+    /// but never below one
+    pub read_ahead: usize,
+}
+
+impl Default for ChunkedReads {
+    fn default() -> Self {
+        Self {
+            io_mode: IoMode::default(),
+            read_ahead: CHUNKS_PER_READ * ED2K_CHUNK_SIZE as usize,
+        }
+    }
+}
+
+/// ED2K chunk digests and samples of one version of a file
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct ChunkDigests {
+    /// Size of the file the digests were taken from
+    pub file_size: u64,
+    /// MD4 digest of each chunk, in file order
+    pub digests: Vec<[u8; 16]>,
+    /// Sample of each chunk, in file order
+    pub samples: Vec<u32>,
+    /// CRC32 of each chunk, in file order, or empty if not recorded
+    pub crc32s: Vec<u32>,
+}
+
+impl ChunkDigests {
+    /// The ED2K hash these digests combine into
+    pub fn ed2k(&self, variant: Ed2kVariant) -> String {
+        root_hash(self.digests.concat(), self.file_size, variant)
+    }
+
+    /// Whether the CRC32 of every chunk is known
+    pub fn has_crc32s(&self) -> bool {
+        self.crc32s.len() == self.digests.len()
+    }
+
+    /// The CRC32 of the whole file, combined from the chunk CRC32s
+    pub fn crc32(&self) -> Option<String> {
+        if !self.has_crc32s() {
+            return None;
+        }
+        let mut hasher = crc32fast::Hasher::new();
+        for (index, &crc) in self.crc32s.iter().enumerate() {
+            let len = chunk_len(self.file_size, index);
+            hasher.combine(&crc32fast::Hasher::new_with_initial_len(crc, len));
+        }
+        Some(format!("{:08x}", hasher.finalize()))
+    }
+}
+
+/// Result of [`hash_file_chunks`]
+#[derive(Debug, Clone)]
+pub struct ChunkedHashes {
+    pub hashes: HashMap<HashAlgorithm, String>,
+    pub chunks: ChunkDigests,
+    /// Bytes read from the file, samples included
+    pub bytes_read: u64,
+    /// Chunks whose digest was taken from the previous version
+    pub chunks_reused: usize,
+    /// Time spent waiting for CPU slots
+    pub slot_wait: Duration,
+}
+
+/// Hash a file chunk by chunk, reusing digests of chunks unchanged since
+/// `previous`
+///
+/// `algorithms` must include ED2K. CRC32 is combined from the chunk CRC32s,
+/// so it is reused like ED2K when `previous` recorded them. MD5, SHA1 and
+/// TTH need every byte of the file, so with any of them `previous` is
+/// ignored and the file is read once in full.
+///
+/// Chunks are read through a [`ChunkReader`] and hashed in groups, each
+/// under a slot of the global [`CpuPool`] taken once the group is read.
+pub async fn hash_file_chunks(
+    path: &Path,
+    algorithms: &[HashAlgorithm],
+    previous: Option<&ChunkDigests>,
+    variant: Ed2kVariant,
+    reads: ChunkedReads,
+    progress_provider: &dyn ProgressProvider,
+) -> Result<ChunkedHashes> {
+    let file_size = tokio::fs::metadata(path).await?.len();
+    let chunk_count = file_size.div_ceil(ED2K_CHUNK_SIZE) as usize;
+
+    let mut others: Vec<HashAlgorithm> = Vec::new();
+    for &algorithm in algorithms {
+        if algorithm != HashAlgorithm::ED2K && !others.contains(&algorithm) {
+            others.push(algorithm);
+        }
+    }
+    let wants_crc32 = others.contains(&HashAlgorithm::CRC32);
+    others.retain(|&algorithm| algorithm != HashAlgorithm::CRC32);
+    let previous =
+        previous.filter(|previous| others.is_empty() && (!wants_crc32 || previous.has_crc32s()));
+    let mut other_hashers = (!others.is_empty()).then(|| MultiHasher::new(&others));
+
+    let mut bytes_read = 0u64;
+
+    // Chunks whose length and sample still match the previous version
+    let mut unchanged = vec![false; chunk_count];
+    if let Some(previous) = previous {
+        let mut file = File::open(path).await?;
+        for (index, unchanged) in unchanged.iter_mut().enumerate() {
+            let len = chunk_len(file_size, index);
+            if index < previous.digests.len() && chunk_len(previous.file_size, index) == len {
+                let start = index as u64 * ED2K_CHUNK_SIZE;
+                let (sample, sampled) = sample_file_chunk(&mut file, start, len).await?;
+                bytes_read += sampled;
+                *unchanged = sample == previous.samples[index];
+            }
+        }
+    }
+
+    let mut chunks = ChunkDigests {
+        file_size,
+        digests: Vec::with_capacity(chunk_count),
+        samples: Vec::with_capacity(chunk_count),
+        crc32s: Vec::with_capacity(chunk_count),
+    };
+    let group_size = (reads.read_ahead / ED2K_CHUNK_SIZE as usize).clamp(1, CHUNKS_PER_READ);
+    let mut buffer = Vec::new();
+    let mut chunks_reused = 0;
+    let mut slot_wait = Duration::ZERO;
+
+    let mut index = 0;
+    while index < chunk_count {
+        if let Some(previous) = previous
+            && unchanged[index]
+        {
+            chunks.digests.push(previous.digests[index]);
+            chunks.samples.push(previous.samples[index]);
+            // An entry written before CRC32s were recorded leaves the new
+            // ones incomplete; they are dropped below
+            if let Some(&crc) = previous.crc32s.get(index) {
+                chunks.crc32s.push(crc);
+            }
+            chunks_reused += 1;
+            index += 1;
+            report(progress_provider, chunk_end(file_size, index), file_size);
+            continue;
+        }
+
+        // Read the changed chunks up to the next unchanged one in one go
+        let run_end = (index..chunk_count)
+            .find(|&i| unchanged[i])
+            .unwrap_or(chunk_count);
+        let range = index as u64 * ED2K_CHUNK_SIZE..chunk_end(file_size, run_end);
+        let mut reader = ChunkReader::open_range(path, reads.io_mode, READ_SIZE, range).await?;
+        // Bytes read past the end of the previous group
+        let mut carry = Vec::new();
+
+        while index < run_end {
+            let start = index as u64 * ED2K_CHUNK_SIZE;
+            let end = chunk_end(file_size, (index + group_size).min(run_end));
+            let len = (end - start) as usize;
+            buffer.clear();
+            buffer.reserve(len);
+            buffer.append(&mut carry);
+            while buffer.len() < len {
+                let Some(data) = reader.next_chunk().await? else {
+                    return Err(std::io::Error::new(
+                        std::io::ErrorKind::UnexpectedEof,
+                        "file shrank while it was hashed",
+                    )
+                    .into());
+                };
+                buffer.extend_from_slice(data);
+            }
+            carry.extend_from_slice(&buffer[len..]);
+            buffer.truncate(len);
+            bytes_read += len as u64;
+
+            // Reads are done; only hashing the group takes a CPU slot
+            let wait_start = Instant::now();
+            let permit = CpuPool::global().acquire().await;
+            slot_wait += wait_start.elapsed();
+            let hashed = tokio::task::spawn_blocking(move || {
+                let _permit = permit;
+                let group = hash_group(&buffer, end == file_size, other_hashers.as_mut());
+                (buffer, other_hashers, group)
+            })
+            .await
+            .map_err(|e| {
+                Error::Internal(InternalError::hash_calculation(
+                    "partial_rehash",
+                    &format!("Hashing task failed: {e}"),
+                ))
+            })?;
+            let (returned, hashers, group) = hashed;
+            buffer = returned;
+            other_hashers = hashers;
+
+            for (digest, sample, crc) in group {
+                chunks.digests.push(digest);
+                chunks.samples.push(sample);
+                chunks.crc32s.push(crc);
+            }
+            index = (index + group_size).min(run_end);
+            report(progress_provider, end, file_size);
+        }
+    }
+
+    if !chunks.has_crc32s() {
+        chunks.crc32s.clear();
+    }
+
+    let mut hashes = HashMap::new();
+    hashes.insert(HashAlgorithm::ED2K, chunks.ed2k(variant));
+    if wants_crc32 {
+        let crc32 = chunks.crc32().expect("CRC32 of every chunk");
+        hashes.insert(HashAlgorithm::CRC32, crc32);
+    }
+    if let Some(hashers) = other_hashers {
+        hashes.extend(hashers.finalize());
+    }
+
+    Ok(ChunkedHashes {
+        hashes,
+        chunks,
+        bytes_read,
+        chunks_reused,
+        slot_wait,
+    })
+}
+
+/// MD4 digest, sample and CRC32 of each chunk in `buffer`, which starts at
+/// a chunk boundary and ends at one or at the end of the file
+fn hash_group(
+    buffer: &[u8],
+    at_file_end: bool,
+    other_hashers: Option<&mut MultiHasher>,
+) -> Vec<([u8; 16], u32, u32)> {
+    if let Some(hashers) = other_hashers {
+        hashers.update(buffer);
+    }
+
+    // Equal-length chunks go through the multi-buffer kernels together; a
+    // short final chunk is hashed on its own
+    let slices: Vec<&[u8]> = buffer.chunks(ED2K_CHUNK_SIZE as usize).collect();
+    let full = if at_file_end && !buffer.len().is_multiple_of(ED2K_CHUNK_SIZE as usize) {
+        slices.len() - 1
+    } else {
+        slices.len()
+    };
+    let mut digests = Vec::with_capacity(slices.len() * 16);
+    md4_chunks(&slices[..full], &mut digests);
+    if full < slices.len() {
+        md4_chunks(&slices[full..], &mut digests);
+    }
+
+    slices
+        .iter()
+        .zip(digests.chunks_exact(16))
+        .map(|(slice, digest)| {
+            (
+                digest.try_into().expect("16-byte digest"),
+                sample_chunk(slice),
+                crc32fast::hash(slice),
+            )
+        })
+        .collect()
+}
+
+/// Length of chunk `index` of a file of `file_size` bytes
+fn chunk_len(file_size: u64, index: usize) -> u64 {
+    file_size
+        .saturating_sub(index as u64 * ED2K_CHUNK_SIZE)
+        .min(ED2K_CHUNK_SIZE)
+}
+
+/// Offset just past the first `count` chunks
+fn chunk_end(file_size: u64, count: usize) -> u64 {
+    (count as u64 * ED2K_CHUNK_SIZE).min(file_size)
+}
+
+/// Sample of a chunk held in memory
+fn sample_chunk(chunk: &[u8]) -> u32 {
+    let n = chunk.len().min(SAMPLE_SIZE);
+    sample(&chunk[..n], &chunk[chunk.len() - n..])
+}
+
+/// Sample of a chunk read from its two ends on disk
+///
+/// Returns the sample and the number of bytes read.
+async fn sample_file_chunk(file: &mut File, start: u64, len: u64) -> Result<(u32, u64)> {
+    let n = len.min(SAMPLE_SIZE as u64);
+    let mut head = vec![0u8; n as usize];
+    let mut tail = vec![0u8; n as usize];
+
+    file.seek(SeekFrom::Start(start)).await?;
+    file.read_exact(&mut head).await?;
+    file.seek(SeekFrom::Start(start + len - n)).await?;
+    file.read_exact(&mut tail).await?;
+
+    Ok((sample(&head, &tail), 2 * n))
+}
+
+fn sample(head: &[u8], tail: &[u8]) -> u32 {
+    let mut hasher = crc32fast::Hasher::new();
+    hasher.update(head);
+    hasher.update(tail);
+    hasher.finalize()
+}
+
+fn report(progress_provider: &dyn ProgressProvider, bytes_processed: u64, total_bytes: u64) {
+    progress_provider.report(ProgressUpdate::HashProgress {
+        algorithm: "ED2K".to_string(),
+        bytes_processed,
+        total_bytes,
+    });
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::hashing::HashAlgorithmExt;
+    use crate::progress::NullProvider;
+    use std::io::Write;
+    use tempfile::TempDir;
+
+    const CHUNK: usize = ED2K_CHUNK_SIZE as usize;
+
+    fn data(len: usize, seed: u8) -> Vec<u8> {
+        (0..len)
+            .map(|i| (i % 251) as u8 ^ seed.wrapping_mul((i / CHUNK) as u8 + 1))
+            .collect()
+    }
+
+    fn expected(data: &[u8], algorithm: HashAlgorithm) -> String {
+        algorithm.to_impl().hash_bytes(data)
+    }
+
+    #[tokio::test]
+    async fn test_full_pass_matches_streaming_hashes() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("file.bin");
+        let algorithms = [HashAlgorithm::ED2K, HashAlgorithm::CRC32];
+
+        // Empty, short, an exact multiple of the chunk size (the Red
+        // variant's trailing empty chunk) and more chunks than one read
+        for len in [0, 1000, 2 * CHUNK, 5 * CHUNK + 123] {
+            let contents = data(len, 1);
+            std::fs::write(&path, &contents).unwrap();
+
+            let result = hash_file_chunks(
+                &path,
+                &algorithms,
+                None,
+                Ed2kVariant::Red,
+                ChunkedReads::default(),
+                &NullProvider,
+            )
+            .await
+            .unwrap();
+            for algorithm in algorithms {
+                assert_eq!(
+                    result.hashes[&algorithm],
+                    expected(&contents, algorithm),
+                    "{algorithm:?} for {len} bytes"
+                );
+            }
+            assert_eq!(result.chunks.digests.len(), len.div_ceil(CHUNK));
+            assert_eq!(result.bytes_read, len as u64);
+            assert_eq!(result.chunks_reused, 0);
+        }
+    }
+
+    #[tokio::test]
+    async fn test_reads_follow_io_mode_and_read_ahead() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("file.bin");
+        let mut contents = data(3 * CHUNK + 4321, 7);
+        std::fs::write(&path, &contents).unwrap();
+        let both = [HashAlgorithm::ED2K, HashAlgorithm::CRC32];
+
+        for io_mode in [IoMode::Buffered, IoMode::MemoryMapped, IoMode::DirectIo] {
+            // Less than a chunk of read ahead still reads one at a time
+            for read_ahead in [CHUNK / 2, 2 * CHUNK] {
+                let reads = ChunkedReads {
+                    io_mode,
+                    read_ahead,
+                };
+                let first =
+                    hash_file_chunks(&path, &both, None, Ed2kVariant::Red, reads, &NullProvider)
+                        .await
+                        .unwrap();
+                for algorithm in both {
+                    assert_eq!(
+                        first.hashes[&algorithm],
+                        expected(&contents, algorithm),
+                        "{io_mode:?} {read_ahead} {algorithm:?}"
+                    );
+                }
+
+                // A changed run next to unchanged chunks
+                contents[10] ^= 0xff;
+                contents[CHUNK + 10] ^= 0xff;
+                std::fs::write(&path, &contents).unwrap();
+                let second = hash_file_chunks(
+                    &path,
+                    &both,
+                    Some(&first.chunks),
+                    Ed2kVariant::Red,
+                    reads,
+                    &NullProvider,
+                )
+                .await
+                .unwrap();
+                assert_eq!(second.chunks_reused, 2);
+                for algorithm in both {
+                    assert_eq!(
+                        second.hashes[&algorithm],
+                        expected(&contents, algorithm),
+                        "{io_mode:?} {read_ahead} {algorithm:?}"
+                    );
+                }
+            }
+        }
+    }
+
+    #[tokio::test]
+    async fn test_append_reuses_whole_chunks() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("file.bin");
+        let mut contents = data(3 * CHUNK + 500, 2);
+        std::fs::write(&path, &contents).unwrap();
+
+        let ed2k = [HashAlgorithm::ED2K];
+        let first = hash_file_chunks(
+            &path,
+            &ed2k,
+            None,
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+
+        let tail = data(CHUNK, 3);
+        std::fs::File::options()
+            .append(true)
+            .open(&path)
+            .unwrap()
+            .write_all(&tail)
+            .unwrap();
+        contents.extend_from_slice(&tail);
+
+        let second = hash_file_chunks(
+            &path,
+            &ed2k,
+            Some(&first.chunks),
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+        assert_eq!(
+            second.hashes[&HashAlgorithm::ED2K],
+            expected(&contents, HashAlgorithm::ED2K)
+        );
+        assert_eq!(second.chunks_reused, 3);
+        // Only the old partial chunk and the new data are read in full
+        assert!(second.bytes_read < 2 * ED2K_CHUNK_SIZE);
+    }
+
+    #[tokio::test]
+    async fn test_crc32_combines_reused_chunks() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("file.bin");
+        let mut contents = data(2 * CHUNK + 700, 5);
+        std::fs::write(&path, &contents).unwrap();
+
+        let both = [HashAlgorithm::ED2K, HashAlgorithm::CRC32];
+        let first = hash_file_chunks(
+            &path,
+            &both,
+            None,
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+        assert_eq!(first.chunks.crc32s.len(), 3);
+
+        let tail = data(CHUNK / 2, 6);
+        std::fs::File::options()
+            .append(true)
+            .open(&path)
+            .unwrap()
+            .write_all(&tail)
+            .unwrap();
+        contents.extend_from_slice(&tail);
+
+        let second = hash_file_chunks(
+            &path,
+            &both,
+            Some(&first.chunks),
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+        assert_eq!(second.chunks_reused, 2);
+        for algorithm in both {
+            assert_eq!(
+                second.hashes[&algorithm],
+                expected(&contents, algorithm),
+                "{algorithm:?}"
+            );
+        }
+
+        // Digests recorded without CRC32s cannot give the file's CRC32
+        let without_crc32s = ChunkDigests {
+            crc32s: Vec::new(),
+            ..second.chunks.clone()
+        };
+        let third = hash_file_chunks(
+            &path,
+            &both,
+            Some(&without_crc32s),
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+        assert_eq!(third.chunks_reused, 0);
+        assert_eq!(
+            third.hashes[&HashAlgorithm::CRC32],
+            expected(&contents, HashAlgorithm::CRC32)
+        );
+
+        // ED2K alone still reuses them, and the result records none
+        let fourth = hash_file_chunks(
+            &path,
+            &[HashAlgorithm::ED2K],
+            Some(&without_crc32s),
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+        assert_eq!(fourth.chunks_reused, 3);
+        assert!(fourth.chunks.crc32s.is_empty());
+    }
+
+    #[tokio::test]
+    async fn test_modified_chunk_is_rehashed() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("file.bin");
+        let mut contents = data(3 * CHUNK, 4);
+        std::fs::write(&path, &contents).unwrap();
+
+        let ed2k = [HashAlgorithm::ED2K];
+        let first = hash_file_chunks(
+            &path,
+            &ed2k,
+            None,
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+
+        // Rewrite the start of the middle chunk in place
+        contents[CHUNK + 10] ^= 0xff;
+        std::fs::write(&path, &contents).unwrap();
+
+        let second = hash_file_chunks(
+            &path,
+            &ed2k,
+            Some(&first.chunks),
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+        assert_eq!(
+            second.hashes[&HashAlgorithm::ED2K],
+            expected(&contents, HashAlgorithm::ED2K)
+        );
+        assert_eq!(second.chunks_reused, 2);
+
+        // Other algorithms need the whole file, so nothing is reused
+        let both = [HashAlgorithm::ED2K, HashAlgorithm::MD5];
+        let third = hash_file_chunks(
+            &path,
+            &both,
+            Some(&second.chunks),
+            Ed2kVariant::Red,
+            ChunkedReads::default(),
+            &NullProvider,
+        )
+        .await
+        .unwrap();
+        assert_eq!(third.chunks_reused, 0);
+        assert_eq!(
+            third.hashes[&HashAlgorithm::MD5],
+            expected(&contents, HashAlgorithm::MD5)
+        );
+    }
+}
@@ -0,0 +1,253 @@
+//! Quick content fingerprints
+//!
+//! Telling whether a file's contents were seen before should not need a
+//! full ED2K read. A fingerprint hashes the file size together with a few
+//! sampled blocks: the head, the tail and evenly spaced blocks in between.
+//! Reading at most [`FINGERPRINT_BLOCKS`] blocks of [`FINGERPRINT_BLOCK_SIZE`]
+//! bytes costs half a megabyte however large the file is.
+//!
+//! Like the chunk samples of a partial rehash, a fingerprint is a heuristic:
+//! two files that differ only outside the sampled blocks share one. It is
+//! only meant to decide which files need a full hash.
+
+use std::fs::File;
+use std::io::{Read, Seek, SeekFrom};
+use std::path::Path;
+use xxhash_rust::xxh3::Xxh3;
+
+/// Bytes read for each sampled block
+pub const FINGERPRINT_BLOCK_SIZE: u64 = 64 * 1024;
+
+/// Blocks sampled per file: head, tail and the interior blocks between them
+pub const FINGERPRINT_BLOCKS: u64 = 8;
+
+/// Interior blocks start on this boundary so reads stay page aligned
+const BLOCK_ALIGNMENT: u64 = 4096;
+
+/// Size and sampled-content hash of a file
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct QuickFingerprint {
+    pub size: u64,
+    /// XXH3 of the size and the sampled blocks
+    pub hash: u64,
+}
+
+impl QuickFingerprint {
+    /// Fingerprint in-memory contents
+    pub fn from_bytes(data: &[u8]) -> Self {
+        let mut sampler = FingerprintSampler::new(data.len() as u64);
+        sampler.update(data);
+        sampler.finish()
+    }
+
+    /// Fingerprint the file at `path`
+    ///
+    /// Returns the fingerprint and the number of bytes read.
+    pub fn from_path(path: &Path) -> std::io::Result<(Self, u64)> {
+        let mut file = File::open(path)?;
+        let size = file.metadata()?.len();
+        let mut hasher = start(size);
+        let mut block = vec![0u8; FINGERPRINT_BLOCK_SIZE.min(size) as usize];
+        let mut bytes_read = 0;
+
+        for (offset, len) in sample_ranges(size) {
+            let mut remaining = len;
+            file.seek(SeekFrom::Start(offset))?;
+            while remaining > 0 {
+                let n = remaining.min(block.len() as u64) as usize;
+                file.read_exact(&mut block[..n])?;
+                hasher.update(&block[..n]);
+                remaining -= n as u64;
+            }
+            bytes_read += len;
+        }
+
+        Ok((
+            Self {
+                size,
+                hash: hasher.digest(),
+            },
+            bytes_read,
+        ))
+    }
+}
+
+/// Fingerprint built from the contents as they stream past
+///
+/// Lets a full hash produce the fingerprint without reading the sampled
+/// blocks a second time. Chunks must be fed in file order.
+#[derive(Clone)]
+pub struct FingerprintSampler {
+    size: u64,
+    hasher: Xxh3,
+    ranges: Vec<(u64, u64)>,
+    next_range: usize,
+    position: u64,
+}
+
+impl FingerprintSampler {
+    /// Sampler for a file of `size` bytes
+    pub fn new(size: u64) -> Self {
+        Self {
+            size,
+            hasher: start(size),
+            ranges: sample_ranges(size),
+            next_range: 0,
+            position: 0,
+        }
+    }
+
+    /// Feed the next chunk of the file
+    pub fn update(&mut self, chunk: &[u8]) {
+        let chunk_start = self.position;
+        let chunk_end = chunk_start + chunk.len() as u64;
+        self.position = chunk_end;
+
+        while let Some(&(offset, len)) = self.ranges.get(self.next_range) {
+            let range_end = offset + len;
+            if offset >= chunk_end {
+                break;
+            }
+            let from = offset.max(chunk_start);
+            let to = range_end.min(chunk_end);
+            if from < to {
+                self.hasher
+                    .update(&chunk[(from - chunk_start) as usize..(to - chunk_start) as usize]);
+            }
+            if range_end > chunk_end {
+                break;
+            }
+            self.next_range += 1;
+        }
+    }
+
+    /// Fingerprint of everything fed so far
+    pub fn finish(&self) -> QuickFingerprint {
+        QuickFingerprint {
+            size: self.size,
+            hash: self.hasher.digest(),
+        }
+    }
+}
+
+impl std::fmt::Debug for FingerprintSampler {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("FingerprintSampler")
+            .field("size", &self.size)
+            .field("position", &self.position)
+            .finish()
+    }
+}
+
+fn start(size: u64) -> Xxh3 {
+    let mut hasher = Xxh3::new();
+    hasher.update(&size.to_le_bytes());
+    hasher
+}
+
+/// Sorted, non-overlapping `(offset, len)` ranges sampled from a file
+///
+/// Files no larger than all the blocks together are read whole.
+fn sample_ranges(size: u64) -> Vec<(u64, u64)> {
+    if size <= FINGERPRINT_BLOCKS * FINGERPRINT_BLOCK_SIZE {
+        return vec![(0, size)];
+    }
+
+    let last = size - FINGERPRINT_BLOCK_SIZE;
+    let gaps = FINGERPRINT_BLOCKS - 1;
+    let mut ranges: Vec<(u64, u64)> = Vec::with_capacity(FINGERPRINT_BLOCKS as usize);
+    for i in 0..FINGERPRINT_BLOCKS {
+        let offset = if i == gaps {
+            last
+        } else {
+            let aligned = (last / gaps * i) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+            // Rounding down may reach back into the previous block
+            ranges
+                .last()
+                .map_or(aligned, |&(prev, len)| aligned.max(prev + len))
+        };
+        ranges.push((offset, FINGERPRINT_BLOCK_SIZE));
+    }
+    ranges
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn data(len: usize) -> Vec<u8> {
+        (0..len)
+            .map(|i| (i % 251) as u8 ^ (i >> 16) as u8)
+            .collect()
+    }
+
+    #[test]
+    fn test_sample_ranges_cover_head_and_tail() {
+        assert_eq!(sample_ranges(0), vec![(0, 0)]);
+        assert_eq!(sample_ranges(1000), vec![(0, 1000)]);
+
+        let size = 1 << 30;
+        let ranges = sample_ranges(size);
+        assert_eq!(ranges.len() as u64, FINGERPRINT_BLOCKS);
+        assert_eq!(ranges[0].0, 0);
+        assert_eq!(
+            ranges.last().unwrap().0 + FINGERPRINT_BLOCK_SIZE,
+            size,
+            "tail block ends at the end of the file"
+        );
+        for pair in ranges.windows(2) {
+            assert!(pair[0].0 + pair[0].1 <= pair[1].0, "{ranges:?}");
+        }
+    }
+
+    #[test]
+    fn test_file_matches_bytes_and_reads_little() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("file.bin");
+
+        for len in [0, 4096, 600 * 1024, 3 * 1024 * 1024 + 17] {
+            let contents = data(len);
+            std::fs::write(&path, &contents).unwrap();
+
+            let (fingerprint, bytes_read) = QuickFingerprint::from_path(&path).unwrap();
+            assert_eq!(fingerprint, QuickFingerprint::from_bytes(&contents));
+            assert_eq!(fingerprint.size, len as u64);
+            assert!(bytes_read <= FINGERPRINT_BLOCKS * FINGERPRINT_BLOCK_SIZE);
+        }
+    }
+
+    #[test]
+    fn test_sampled_and_size_changes_are_detected() {
+        let contents = data(4 * 1024 * 1024);
+        let original = QuickFingerprint::from_bytes(&contents);
+
+        let mut head = contents.clone();
+        head[10] ^= 1;
+        assert_ne!(QuickFingerprint::from_bytes(&head), original);
+
+        let mut tail = contents.clone();
+        *tail.last_mut().unwrap() ^= 1;
+        assert_ne!(QuickFingerprint::from_bytes(&tail), original);
+
+        let mut longer = contents.clone();
+        longer.push(0);
+        assert_ne!(QuickFingerprint::from_bytes(&longer), original);
+    }
+
+    #[test]
+    fn test_sampler_matches_whatever_the_chunking() {
+        for len in [0, 600 * 1024, 3 * 1024 * 1024 + 17] {
+            let contents = data(len);
+            let expected = QuickFingerprint::from_bytes(&contents);
+
+            for chunk_size in [1000, 4096, 64 * 1024, 1 << 20] {
+                let mut sampler = FingerprintSampler::new(len as u64);
+                for chunk in contents.chunks(chunk_size) {
+                    sampler.update(chunk);
+                }
+                assert_eq!(sampler.finish(), expected, "len {len}, chunk {chunk_size}");
+            }
+        }
+    }
+}
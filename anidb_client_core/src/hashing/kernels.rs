@@ -0,0 +1,446 @@
+//! Runtime-dispatched MD4 and CRC32 kernels
+//!
+//! ED2K hashes every 9,728,000 byte chunk with MD4 independently, so whenever
+//! several complete chunks are in memory they can be hashed side by side, one
+//! chunk per SIMD lane. [`md4_chunks`] does this with 16 lanes on AVX-512, 8 on
+//! AVX2 and 4 on SSE4.1 or NEON. The lane code is written once over plain
+//! arrays and compiled per instruction set, which lets the compiler emit the
+//! vector instructions without hand-written intrinsics.
+//!
+//! CRC32 uses PCLMULQDQ folding on x86 and the ARMv8 CRC32 instructions on
+//! AArch64, falling back to a table implementation elsewhere.
+//!
+//! The kernels are chosen once per process from [`CpuFeatures`].
+
+use crate::platform::CpuFeatures;
+use md4::{Digest, Md4};
+use std::sync::OnceLock;
+
+/// MD4 kernel used for ED2K chunk hashing
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Md4Kernel {
+    /// One chunk at a time
+    Scalar,
+    /// Four lanes of SSE4.1
+    Sse41,
+    /// Eight lanes of AVX2
+    Avx2,
+    /// Sixteen lanes of AVX-512
+    Avx512,
+    /// Four lanes of NEON
+    Neon,
+}
+
+impl Md4Kernel {
+    /// Widest kernel to narrowest, the order in which they are tried
+    const BY_WIDTH: [Md4Kernel; 5] = [
+        Md4Kernel::Avx512,
+        Md4Kernel::Avx2,
+        Md4Kernel::Sse41,
+        Md4Kernel::Neon,
+        Md4Kernel::Scalar,
+    ];
+
+    /// Number of chunks hashed per call
+    pub fn lanes(self) -> usize {
+        match self {
+            Md4Kernel::Scalar => 1,
+            Md4Kernel::Sse41 | Md4Kernel::Neon => 4,
+            Md4Kernel::Avx2 => 8,
+            Md4Kernel::Avx512 => 16,
+        }
+    }
+
+    /// Short name for logs and metrics
+    pub fn name(self) -> &'static str {
+        match self {
+            Md4Kernel::Scalar => "scalar",
+            Md4Kernel::Sse41 => "sse4.1",
+            Md4Kernel::Avx2 => "avx2",
+            Md4Kernel::Avx512 => "avx512",
+            Md4Kernel::Neon => "neon",
+        }
+    }
+
+    /// Whether the kernel is compiled in and the CPU can run it
+    pub fn is_supported(self, features: &CpuFeatures) -> bool {
+        match self {
+            Md4Kernel::Scalar => true,
+            Md4Kernel::Sse41 => {
+                cfg!(any(target_arch = "x86", target_arch = "x86_64")) && features.sse4_1
+            }
+            Md4Kernel::Avx2 => {
+                cfg!(any(target_arch = "x86", target_arch = "x86_64")) && features.avx2
+            }
+            Md4Kernel::Avx512 => {
+                cfg!(any(target_arch = "x86", target_arch = "x86_64")) && features.avx512f
+            }
+            Md4Kernel::Neon => cfg!(target_arch = "aarch64") && features.neon,
+        }
+    }
+}
+
+/// CRC32 kernel
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Crc32Kernel {
+    /// Slice-by-16 lookup tables
+    Table,
+    /// Carry-less multiplication folding
+    Pclmulqdq,
+    /// ARMv8 CRC32 instructions
+    Armv8,
+}
+
+impl Crc32Kernel {
+    /// Short name for logs and metrics
+    pub fn name(self) -> &'static str {
+        match self {
+            Crc32Kernel::Table => "table",
+            Crc32Kernel::Pclmulqdq => "pclmulqdq",
+            Crc32Kernel::Armv8 => "armv8",
+        }
+    }
+}
+
+/// Kernels selected for this process
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct HashKernels {
+    pub md4: Md4Kernel,
+    pub crc32: Crc32Kernel,
+}
+
+impl HashKernels {
+    /// Kernels for the current CPU, selected on first use
+    pub fn get() -> &'static HashKernels {
+        static KERNELS: OnceLock<HashKernels> = OnceLock::new();
+        KERNELS.get_or_init(|| Self::select(CpuFeatures::get()))
+    }
+
+    /// Pick the best kernels for a feature set
+    pub fn select(features: &CpuFeatures) -> Self {
+        let md4 = Md4Kernel::BY_WIDTH
+            .into_iter()
+            .find(|kernel| kernel.is_supported(features))
+            .unwrap_or(Md4Kernel::Scalar);
+
+        // crc32fast performs the same PCLMULQDQ check when it is constructed
+        let crc32 = if cfg!(target_arch = "aarch64") && features.crc32 {
+            Crc32Kernel::Armv8
+        } else if cfg!(any(target_arch = "x86", target_arch = "x86_64"))
+            && features.pclmulqdq
+            && features.sse4_1
+        {
+            Crc32Kernel::Pclmulqdq
+        } else {
+            Crc32Kernel::Table
+        };
+
+        Self { md4, crc32 }
+    }
+}
+
+/* ========================================================================== */
+/*                              Multi-buffer MD4                               */
+/* ========================================================================== */
+
+/// Hash equal-length chunks and append their MD4 digests to `out` in order
+///
+/// Chunks are taken in groups as wide as the selected kernel. A remainder
+/// falls back to the next narrower kernel the CPU supports.
+pub(crate) fn md4_chunks(chunks: &[&[u8]], out: &mut Vec<u8>) {
+    md4_chunks_with(HashKernels::get().md4, chunks, out)
+}
+
+/// [`md4_chunks`] with an explicit widest kernel
+pub(crate) fn md4_chunks_with(kernel: Md4Kernel, chunks: &[&[u8]], out: &mut Vec<u8>) {
+    debug_assert!(chunks.windows(2).all(|w| w[0].len() == w[1].len()));
+
+    let features = CpuFeatures::get();
+    let mut remaining = chunks;
+    while !remaining.is_empty() {
+        let kernel = Md4Kernel::BY_WIDTH
+            .into_iter()
+            .filter(|k| k.lanes() <= kernel.lanes() && k.is_supported(features))
+            .find(|k| k.lanes() <= remaining.len())
+            .unwrap_or(Md4Kernel::Scalar);
+
+        let (group, rest) = remaining.split_at(kernel.lanes());
+        hash_group(kernel, group, out);
+        remaining = rest;
+    }
+}
+
+fn hash_group(kernel: Md4Kernel, group: &[&[u8]], out: &mut Vec<u8>) {
+    match kernel {
+        #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+        // SAFETY: the kernel was checked against the detected CPU features
+        Md4Kernel::Avx512 => unsafe { extend(out, md4_x16_avx512(lanes(group))) },
+        #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+        // SAFETY: as above
+        Md4Kernel::Avx2 => unsafe { extend(out, md4_x8_avx2(lanes(group))) },
+        #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+        // SAFETY: as above
+        Md4Kernel::Sse41 => unsafe { extend(out, md4_x4_sse41(lanes(group))) },
+        #[cfg(target_arch = "aarch64")]
+        // NEON is part of the AArch64 baseline, so no feature gate is needed
+        Md4Kernel::Neon => extend(out, md4_lanes::<4>(lanes(group))),
+        _ => {
+            for chunk in group {
+                out.extend_from_slice(&Md4::digest(chunk));
+            }
+        }
+    }
+}
+
+#[allow(dead_code)]
+fn lanes<'a, const L: usize>(group: &[&'a [u8]]) -> [&'a [u8]; L] {
+    std::array::from_fn(|lane| group[lane])
+}
+
+#[allow(dead_code)]
+fn extend<const L: usize>(out: &mut Vec<u8>, digests: [[u8; 16]; L]) {
+    for digest in digests {
+        out.extend_from_slice(&digest);
+    }
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+#[target_feature(enable = "avx512f")]
+unsafe fn md4_x16_avx512(messages: [&[u8]; 16]) -> [[u8; 16]; 16] {
+    md4_lanes(messages)
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+#[target_feature(enable = "avx2")]
+unsafe fn md4_x8_avx2(messages: [&[u8]; 8]) -> [[u8; 16]; 8] {
+    md4_lanes(messages)
+}
+
+#[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+#[target_feature(enable = "sse4.1")]
+unsafe fn md4_x4_sse41(messages: [&[u8]; 4]) -> [[u8; 16]; 4] {
+    md4_lanes(messages)
+}
+
+const MD4_INIT: [u32; 4] = [0x6745_2301, 0xefcd_ab89, 0x98ba_dcfe, 0x1032_5476];
+
+/// MD4 of `L` equal-length messages, one per lane
+///
+/// Always inlined so that each `target_feature` wrapper gets its own copy
+/// vectorized for that instruction set.
+#[inline(always)]
+fn md4_lanes<const L: usize>(messages: [&[u8]; L]) -> [[u8; 16]; L] {
+    let len = messages[0].len();
+
+    let mut state = [[0u32; L]; 4];
+    for (word, init) in state.iter_mut().zip(MD4_INIT) {
+        *word = [init; L];
+    }
+
+    let full = len / 64;
+    for block in 0..full {
+        let words = load_words(messages.map(|m| &m[block * 64..block * 64 + 64]));
+        compress(&mut state, &words);
+    }
+
+    // Every lane has the same length, so the padded tail has the same shape
+    let rem = len % 64;
+    let tail_blocks = if rem < 56 { 1 } else { 2 };
+    let bits = (len as u64).wrapping_mul(8);
+    let mut tails = [[0u8; 128]; L];
+    for (tail, message) in tails.iter_mut().zip(messages) {
+        tail[..rem].copy_from_slice(&message[full * 64..]);
+        tail[rem] = 0x80;
+        tail[tail_blocks * 64 - 8..tail_blocks * 64].copy_from_slice(&bits.to_le_bytes());
+    }
+    for block in 0..tail_blocks {
+        let words = load_words(std::array::from_fn(|lane| {
+            &tails[lane][block * 64..block * 64 + 64]
+        }));
+        compress(&mut state, &words);
+    }
+
+    std::array::from_fn(|lane| {
+        let mut digest = [0u8; 16];
+        for (i, word) in state.iter().enumerate() {
+            digest[i * 4..i * 4 + 4].copy_from_slice(&word[lane].to_le_bytes());
+        }
+        digest
+    })
+}
+
+/// Transpose one 64-byte block per lane into word-major order
+#[inline(always)]
+fn load_words<const L: usize>(blocks: [&[u8]; L]) -> [[u32; L]; 16] {
+    let mut words = [[0u32; L]; 16];
+    for (k, word) in words.iter_mut().enumerate() {
+        for (lane, block) in blocks.iter().enumerate() {
+            let bytes = &block[k * 4..k * 4 + 4];
+            word[lane] = u32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]);
+        }
+    }
+    words
+}
+
+/// One MD4 compression of a block in every lane (RFC 1320)
+#[inline(always)]
+fn compress<const L: usize>(state: &mut [[u32; L]; 4], x: &[[u32; L]; 16]) {
+    let [mut a, mut b, mut c, mut d] = *state;
+
+    macro_rules! step {
+        ($a:ident, $b:ident, $c:ident, $d:ident, $f:expr, $k:expr, $add:expr, $s:expr) => {
+            for i in 0..L {
+                $a[i] = $a[i]
+                    .wrapping_add($f($b[i], $c[i], $d[i]))
+                    .wrapping_add(x[$k][i])
+                    .wrapping_add($add)
+                    .rotate_left($s);
+            }
+        };
+    }
+
+    let f = |x: u32, y: u32, z: u32| (x & y) | (!x & z);
+    let g = |x: u32, y: u32, z: u32| (x & y) | (x & z) | (y & z);
+    let h = |x: u32, y: u32, z: u32| x ^ y ^ z;
+
+    for k in [0, 4, 8, 12] {
+        step!(a, b, c, d, f, k, 0, 3);
+        step!(d, a, b, c, f, k + 1, 0, 7);
+        step!(c, d, a, b, f, k + 2, 0, 11);
+        step!(b, c, d, a, f, k + 3, 0, 19);
+    }
+    for k in [0, 1, 2, 3] {
+        step!(a, b, c, d, g, k, 0x5a82_7999, 3);
+        step!(d, a, b, c, g, k + 4, 0x5a82_7999, 5);
+        step!(c, d, a, b, g, k + 8, 0x5a82_7999, 9);
+        step!(b, c, d, a, g, k + 12, 0x5a82_7999, 13);
+    }
+    for k in [0, 2, 1, 3] {
+        step!(a, b, c, d, h, k, 0x6ed9_eba1, 3);
+        step!(d, a, b, c, h, k + 8, 0x6ed9_eba1, 9);
+        step!(c, d, a, b, h, k + 4, 0x6ed9_eba1, 11);
+        step!(b, c, d, a, h, k + 12, 0x6ed9_eba1, 15);
+    }
+
+    for i in 0..L {
+        state[0][i] = state[0][i].wrapping_add(a[i]);
+        state[1][i] = state[1][i].wrapping_add(b[i]);
+        state[2][i] = state[2][i].wrapping_add(c[i]);
+        state[3][i] = state[3][i].wrapping_add(d[i]);
+    }
+}
+
+/* ========================================================================== */
+/*                                   CRC32                                     */
+/* ========================================================================== */
+
+/// Incremental CRC32 using the selected kernel
+pub(crate) enum Crc32State {
+    /// crc32fast, which dispatches to PCLMULQDQ on its own
+    Fast(crc32fast::Hasher),
+    #[cfg(target_arch = "aarch64")]
+    Armv8(u32),
+}
+
+impl Crc32State {
+    pub(crate) fn new() -> Self {
+        #[cfg(target_arch = "aarch64")]
+        if HashKernels::get().crc32 == Crc32Kernel::Armv8 {
+            return Crc32State::Armv8(0);
+        }
+        Crc32State::Fast(crc32fast::Hasher::new())
+    }
+
+    pub(crate) fn update(&mut self, data: &[u8]) {
+        match self {
+            Crc32State::Fast(hasher) => hasher.update(data),
+            #[cfg(target_arch = "aarch64")]
+            // SAFETY: only selected when the CPU reports the CRC extension
+            Crc32State::Armv8(crc) => *crc = unsafe { crc32_armv8(*crc, data) },
+        }
+    }
+
+    pub(crate) fn finalize(self) -> u32 {
+        match self {
+            Crc32State::Fast(hasher) => hasher.finalize(),
+            #[cfg(target_arch = "aarch64")]
+            Crc32State::Armv8(crc) => crc,
+        }
+    }
+}
+
+/// Continue a CRC32 over `data` with the ARMv8 instructions
+///
+/// # Safety
+///
+/// The CPU must support the `crc` extension.
+#[cfg(target_arch = "aarch64")]
+#[target_feature(enable = "crc")]
+unsafe fn crc32_armv8(crc: u32, data: &[u8]) -> u32 {
+    use std::arch::aarch64::{__crc32b, __crc32d};
+
+    let mut crc = !crc;
+    let (words, rest) = data.as_chunks::<8>();
+    for word in words {
+        crc = __crc32d(crc, u64::from_le_bytes(*word));
+    }
+    for &byte in rest {
+        crc = __crc32b(crc, byte);
+    }
+    !crc
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn test_messages(count: usize, len: usize) -> Vec<Vec<u8>> {
+        (0..count)
+            .map(|lane| (0..len).map(|i| (i * 7 + lane * 13) as u8).collect())
+            .collect()
+    }
+
+    #[test]
+    fn test_every_supported_kernel_matches_md4() {
+        let features = CpuFeatures::get();
+        // Lengths around the one- and two-block padding boundary
+        for len in [0, 3, 55, 56, 63, 64, 65, 119, 120, 1000] {
+            let messages = test_messages(19, len);
+            let chunks: Vec<&[u8]> = messages.iter().map(Vec::as_slice).collect();
+            let expected: Vec<u8> = chunks.iter().flat_map(|c| Md4::digest(c)).collect();
+
+            for kernel in Md4Kernel::BY_WIDTH {
+                if !kernel.is_supported(features) {
+                    continue;
+                }
+                let mut digests = Vec::new();
+                md4_chunks_with(kernel, &chunks, &mut digests);
+                assert_eq!(digests, expected, "{} kernel, length {len}", kernel.name());
+            }
+        }
+    }
+
+    #[test]
+    fn test_selection_follows_features() {
+        let scalar = HashKernels::select(&CpuFeatures::default());
+        assert_eq!(scalar.md4, Md4Kernel::Scalar);
+        assert_eq!(scalar.crc32, Crc32Kernel::Table);
+
+        let selected = HashKernels::get();
+        assert!(selected.md4.is_supported(CpuFeatures::get()));
+    }
+
+    #[test]
+    fn test_crc32_state_matches_reference() {
+        let data: Vec<u8> = (0..10_007).map(|i| (i % 251) as u8).collect();
+        let mut state = Crc32State::new();
+        for piece in data.chunks(333) {
+            state.update(piece);
+        }
+        assert_eq!(state.finalize(), crc32fast::hash(&data));
+
+        let mut state = Crc32State::new();
+        state.update(b"123456789");
+        assert_eq!(state.finalize(), 0xcbf4_3926);
+    }
+}
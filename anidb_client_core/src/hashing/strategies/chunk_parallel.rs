@@ -0,0 +1,380 @@
+//! Chunk-parallel ED2K hash calculation strategy
+//!
+//! ED2K hashes each 9.5MB chunk with MD4 independently and only combines the
+//! chunk digests at the end, so one file can be spread across cores. The
+//! other strategies parallelize across algorithms, which leaves a single
+//! large file on a fast device bound to the one core running MD4.
+//!
+//! This strategy fills a ring buffer with whole ED2K chunks and fans them out
+//! to a pool of blocking workers, each holding a slot of the shared
+//! [`CpuPool`]. Digests are put back in file order before the root hash is
+//! computed. Any other requested algorithms stream from the same ring.
+
+use super::hybrid::spawn_ring_worker;
+use super::{
+    HashingContext, HashingStrategy, MemoryRequirements, PerformanceMetrics, StrategyResult,
+};
+use crate::hashing::algorithms::ed2k::root_hash;
+use crate::hashing::buffer_ring::{BufferRing, RingReader};
+use crate::hashing::{Ed2kVariant, HashResult};
+use crate::platform::{DeviceClass, device_class_for_path};
+use crate::progress::{ProgressProvider, ProgressUpdate};
+use crate::scheduler::CpuPool;
+use crate::{
+    Error, HashAlgorithm, Result,
+    error::{InternalError, IoError, ValidationError},
+};
+use async_trait::async_trait;
+use md4::{Digest, Md4};
+use std::collections::HashMap;
+use std::path::PathBuf;
+use std::sync::Arc;
+use std::time::Instant;
+use tokio::fs::File;
+use tokio::task::{JoinError, JoinHandle, JoinSet};
+
+/// ED2K chunk size, the unit of work handed to each worker
+const ED2K_CHUNK_SIZE: usize = 9_728_000;
+
+/// Number of ring slots, matching the ring buffer's fixed size
+const RING_SLOTS: usize = 32;
+
+/// Smallest file worth splitting across workers
+const MIN_FILE_SIZE: u64 = 100 * 1024 * 1024;
+
+/// Chunk-parallel strategy - hashes the ED2K chunks of one file concurrently
+pub struct ChunkParallelStrategy {
+    worker_count: usize,
+    /// Whether the file must live on a solid-state device to be suitable
+    require_fast_device: bool,
+}
+
+impl ChunkParallelStrategy {
+    /// Create a strategy hashing up to `worker_count` chunks at once
+    pub fn new(worker_count: usize) -> Self {
+        Self {
+            worker_count: worker_count.max(1),
+            require_fast_device: true,
+        }
+    }
+
+    /// Create with one worker per available core
+    pub fn with_defaults() -> Self {
+        Self::new(CpuPool::global().size())
+    }
+
+    /// Treat every device as fast enough, e.g. for storage the device
+    /// classification cannot see into such as RAID or network volumes
+    pub fn ignore_device_class(mut self) -> Self {
+        self.require_fast_device = false;
+        self
+    }
+}
+
+#[async_trait]
+impl HashingStrategy for ChunkParallelStrategy {
+    fn name(&self) -> &'static str {
+        "chunk_parallel"
+    }
+
+    fn memory_requirements(&self, _file_size: u64) -> MemoryRequirements {
+        let hasher_overhead = 1024;
+        MemoryRequirements {
+            minimum: self.worker_count * ED2K_CHUNK_SIZE + hasher_overhead,
+            optimal: RING_SLOTS * ED2K_CHUNK_SIZE + hasher_overhead,
+            maximum: RING_SLOTS * ED2K_CHUNK_SIZE + hasher_overhead,
+        }
+    }
+
+    async fn execute_with_progress(
+        &self,
+        context: HashingContext,
+        progress_provider: &dyn ProgressProvider,
+    ) -> Result<StrategyResult> {
+        let start_time = Instant::now();
+
+        // Validate inputs
+        if !context.algorithms.contains(&HashAlgorithm::ED2K) {
+            return Err(Error::Validation(ValidationError::invalid_configuration(
+                "Chunk-parallel hashing requires ED2K",
+            )));
+        }
+
+        if !context.file_path.exists() {
+            return Err(Error::Io(IoError::file_not_found(&context.file_path)));
+        }
+
+        // One ring reader per distinct algorithm
+        let mut others: Vec<HashAlgorithm> = Vec::new();
+        for &algorithm in &context.algorithms {
+            if algorithm != HashAlgorithm::ED2K && !others.contains(&algorithm) {
+                others.push(algorithm);
+            }
+        }
+        let ring = Arc::new(BufferRing::new(ED2K_CHUNK_SIZE, others.len() + 1)?);
+
+        // ED2K fans out from its own reader; the rest stream as usual
+        let ed2k_task = tokio::spawn(hash_ed2k_chunks(
+            ring.create_reader(),
+            self.worker_count,
+            context.config.ed2k_variant,
+        ));
+        let mut workers: Vec<JoinHandle<Result<(HashAlgorithm, String, u64)>>> = Vec::new();
+        for &algorithm in &others {
+            workers.push(spawn_ring_worker(
+                algorithm,
+                ring.create_reader(),
+                ED2K_CHUNK_SIZE,
+            ));
+        }
+
+        let child_provider = progress_provider.create_child("Reading file");
+        let filled = fill_ring(
+            context.file_path.clone(),
+            context.file_size,
+            ring.clone(),
+            child_provider.as_ref(),
+        )
+        .await;
+        // Let the readers drain and stop even if reading failed part way
+        ring.mark_complete();
+        let (bytes_processed, io_operations) = filled?;
+
+        let mut results = HashMap::new();
+        let (ed2k_hash, ed2k_bytes) = ed2k_task.await.map_err(|e| {
+            Error::Internal(InternalError::hash_calculation(
+                "chunk_parallel",
+                &format!("ED2K task failed: {e}"),
+            ))
+        })??;
+        results.insert(
+            HashAlgorithm::ED2K,
+            HashResult {
+                algorithm: HashAlgorithm::ED2K,
+                hash: ed2k_hash,
+                input_size: ed2k_bytes,
+                duration: start_time.elapsed(),
+            },
+        );
+
+        for worker in workers {
+            let (algorithm, hash, bytes_hashed) = worker.await.map_err(|e| {
+                Error::Internal(InternalError::hash_calculation(
+                    "chunk_parallel",
+                    &format!("Worker task failed: {e}"),
+                ))
+            })??;
+            results.insert(
+                algorithm,
+                HashResult {
+                    algorithm,
+                    hash,
+                    input_size: bytes_hashed,
+                    duration: start_time.elapsed(),
+                },
+            );
+        }
+
+        let duration = start_time.elapsed();
+        let throughput_mbps = if duration.as_secs_f64() > 0.0 {
+            (bytes_processed as f64 / 1_048_576.0) / duration.as_secs_f64()
+        } else {
+            0.0
+        };
+
+        Ok(StrategyResult {
+            results,
+            metrics: PerformanceMetrics {
+                duration,
+                throughput_mbps,
+                peak_memory_bytes: (RING_SLOTS * ED2K_CHUNK_SIZE) as u64,
+                io_operations,
+            },
+        })
+    }
+
+    fn is_suitable(&self, context: &HashingContext) -> bool {
+        // Splitting only pays off when there are several chunks to share out
+        // and the device delivers them faster than one core can hash
+        context.algorithms.contains(&HashAlgorithm::ED2K)
+            && context.file_size >= MIN_FILE_SIZE
+            && self.worker_count > 1
+            && (!self.require_fast_device
+                || device_class_for_path(&context.file_path) == DeviceClass::SolidState)
+    }
+
+    fn priority_score(&self, _context: &HashingContext) -> u32 {
+        // When suitable, every other strategy leaves ED2K on a single core
+        1000
+    }
+}
+
+/// Fill the ring with whole ED2K chunks
+async fn fill_ring(
+    file_path: PathBuf,
+    file_size: u64,
+    ring: Arc<BufferRing>,
+    progress_provider: &dyn ProgressProvider,
+) -> Result<(u64, u64)> {
+    let mut file = File::open(&file_path).await?;
+    let mut bytes_processed = 0u64;
+    let mut io_operations = 0u64;
+
+    while let Some(n) = ring.write_next_full(&mut file).await? {
+        bytes_processed += n as u64;
+        io_operations += 1;
+
+        progress_provider.report(ProgressUpdate::HashProgress {
+            algorithm: "ED2K".to_string(),
+            bytes_processed,
+            total_bytes: file_size,
+        });
+    }
+
+    Ok((bytes_processed, io_operations))
+}
+
+/// Hash ring chunks on up to `worker_count` blocking workers
+///
+/// Returns the ED2K hash and the number of bytes hashed.
+async fn hash_ed2k_chunks(
+    mut reader: RingReader,
+    worker_count: usize,
+    variant: Ed2kVariant,
+) -> Result<(String, u64)> {
+    let pool = CpuPool::global();
+    let mut tasks = JoinSet::new();
+    let mut digests: Vec<[u8; 16]> = Vec::new();
+    let mut total_bytes = 0u64;
+
+    while let Some(chunk) = reader.read_next().await {
+        let index = digests.len();
+        digests.push([0; 16]);
+        total_bytes += chunk.data().len() as u64;
+
+        // Bound the chunks held by workers so the ring keeps moving
+        while tasks.len() >= worker_count {
+            if let Some(joined) = tasks.join_next().await {
+                store_digest(&mut digests, joined)?;
+            }
+        }
+
+        let permit = pool.acquire().await;
+        tasks.spawn_blocking(move || {
+            let _permit = permit;
+            let digest: [u8; 16] = Md4::digest(chunk.data()).into();
+            (index, digest)
+        });
+    }
+
+    while let Some(joined) = tasks.join_next().await {
+        store_digest(&mut digests, joined)?;
+    }
+
+    Ok((
+        root_hash(digests.concat(), total_bytes, variant),
+        total_bytes,
+    ))
+}
+
+fn store_digest(
+    digests: &mut [[u8; 16]],
+    joined: std::result::Result<(usize, [u8; 16]), JoinError>,
+) -> Result<()> {
+    let (index, digest) = joined.map_err(|e| {
+        Error::Internal(InternalError::hash_calculation(
+            "chunk_parallel",
+            &format!("Chunk worker failed: {e}"),
+        ))
+    })?;
+    digests[index] = digest;
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::hashing::HashAlgorithmExt;
+    use crate::hashing::strategies::HashConfig;
+    use tempfile::TempDir;
+
+    fn context(
+        file_path: PathBuf,
+        file_size: u64,
+        algorithms: Vec<HashAlgorithm>,
+    ) -> HashingContext {
+        HashingContext {
+            file_path,
+            file_size,
+            algorithms,
+            config: HashConfig::default(),
+        }
+    }
+
+    #[test]
+    fn test_suitability() {
+        let strategy = ChunkParallelStrategy::new(4).ignore_device_class();
+        let large = 1024 * 1024 * 1024;
+
+        assert!(strategy.is_suitable(&context(
+            PathBuf::from("/tmp/test"),
+            large,
+            vec![HashAlgorithm::ED2K]
+        )));
+        assert!(!strategy.is_suitable(&context(
+            PathBuf::from("/tmp/test"),
+            large,
+            vec![HashAlgorithm::MD5]
+        )));
+        assert!(!strategy.is_suitable(&context(
+            PathBuf::from("/tmp/test"),
+            10 * 1024 * 1024,
+            vec![HashAlgorithm::ED2K]
+        )));
+
+        // A single worker cannot split anything
+        let single = ChunkParallelStrategy::new(1).ignore_device_class();
+        assert!(!single.is_suitable(&context(
+            PathBuf::from("/tmp/test"),
+            large,
+            vec![HashAlgorithm::ED2K]
+        )));
+
+        // Unclassified devices are not assumed to be fast
+        let strict = ChunkParallelStrategy::new(4);
+        assert!(!strict.is_suitable(&context(
+            PathBuf::from("/nonexistent/test"),
+            large,
+            vec![HashAlgorithm::ED2K]
+        )));
+    }
+
+    #[tokio::test]
+    async fn test_matches_streaming_hashes() {
+        let temp_dir = TempDir::new().unwrap();
+        let strategy = ChunkParallelStrategy::new(3).ignore_device_class();
+
+        // An exact multiple of the chunk size exercises the Red variant's
+        // trailing empty chunk; the other size leaves a partial last chunk
+        for size in [4 * ED2K_CHUNK_SIZE, 5 * ED2K_CHUNK_SIZE + 777] {
+            let data: Vec<u8> = (0..size).map(|i| (i % 239) as u8).collect();
+            let path = temp_dir.path().join("chunks.bin");
+            std::fs::write(&path, &data).unwrap();
+
+            let algorithms = vec![HashAlgorithm::ED2K, HashAlgorithm::CRC32];
+            let result = strategy
+                .execute(context(path, size as u64, algorithms.clone()))
+                .await
+                .unwrap();
+
+            for algorithm in algorithms {
+                assert_eq!(
+                    result.results[&algorithm].hash,
+                    algorithm.to_impl().hash_bytes(&data),
+                    "{algorithm:?} for {size} bytes"
+                );
+            }
+            assert_eq!(result.results[&HashAlgorithm::ED2K].input_size, size as u64);
+        }
+    }
+}
@@ -256,7 +256,7 @@ async fn fill_ring_buffer(
 }
 
 /// Spawn a worker that reads from the ring buffer
-fn spawn_ring_worker(
+pub(super) fn spawn_ring_worker(
     algorithm: HashAlgorithm,
     mut reader: RingReader,
     _chunk_size: usize,
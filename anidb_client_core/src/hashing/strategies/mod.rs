@@ -7,6 +7,7 @@
 //! - `MultipleStrategy`: Calculate multiple hashes in a single file pass
 //! - `ParallelStrategy`: True parallel processing with broadcast architecture
 //! - `HybridStrategy`: Ring buffer approach for balanced performance
+//! - `ChunkParallelStrategy`: ED2K chunks of one file hashed across cores
 //!
 //! The appropriate strategy is automatically selected based on file size,
 //! algorithm requirements, and system resources.
@@ -19,6 +20,7 @@ use std::path::PathBuf;
 use std::time::Duration;
 
 // Strategy implementations
+mod chunk_parallel;
 mod hybrid;
 mod multiple;
 mod parallel;
@@ -26,8 +28,9 @@ mod selector;
 mod sequential;
 
 // Re-export public types
+pub use chunk_parallel::ChunkParallelStrategy;
 pub use hybrid::HybridStrategy;
-pub use multiple::MultipleStrategy;
+pub use multiple::{MultiHasher, MultipleStrategy};
 pub use parallel::ParallelStrategy;
 pub use selector::{StrategyHint, StrategySelector};
 pub use sequential::SequentialStrategy;
@@ -7,7 +7,7 @@ use super::{
     HashingContext, HashingStrategy, MemoryRequirements, PerformanceMetrics, StrategyResult,
 };
 use crate::buffer::{allocate_buffer, release_buffer};
-use crate::hashing::{HashAlgorithmExt, HashResult, StreamingHasher};
+use crate::hashing::{HashAlgorithm, HashAlgorithmExt, HashResult, StreamingHasher};
 use crate::progress::{ProgressProvider, ProgressUpdate};
 use crate::{
     Error, Result,
@@ -19,6 +19,57 @@ use std::time::Instant;
 use tokio::fs::File;
 use tokio::io::AsyncReadExt;
 
+/// Slice size used when feeding all hashers from a single pass
+///
+/// Small enough that a slice stays cache-resident while every hasher
+/// consumes it, large enough to amortise the per-call overhead.
+const HASH_SLICE_SIZE: usize = 1024 * 1024;
+
+/// Streaming hashers for several algorithms fed from one pass over the data
+///
+/// Data may arrive in pieces of any size; each piece is split into slices
+/// and every hasher consumes a slice before the next one is touched.
+pub struct MultiHasher {
+    hashers: Vec<(HashAlgorithm, Box<dyn StreamingHasher>)>,
+    bytes_processed: u64,
+}
+
+impl MultiHasher {
+    /// Create one streaming hasher per algorithm, in the given order
+    pub fn new(algorithms: &[HashAlgorithm]) -> Self {
+        Self {
+            hashers: algorithms
+                .iter()
+                .map(|&algorithm| (algorithm, algorithm.to_impl().create_hasher()))
+                .collect(),
+            bytes_processed: 0,
+        }
+    }
+
+    /// Feed the next piece of data to every hasher
+    pub fn update(&mut self, data: &[u8]) {
+        for slice in data.chunks(HASH_SLICE_SIZE) {
+            for (_, hasher) in self.hashers.iter_mut() {
+                hasher.update(slice);
+            }
+        }
+        self.bytes_processed += data.len() as u64;
+    }
+
+    /// Total number of bytes fed so far
+    pub fn bytes_processed(&self) -> u64 {
+        self.bytes_processed
+    }
+
+    /// Finalize every hasher, preserving the creation order
+    pub fn finalize(self) -> Vec<(HashAlgorithm, String)> {
+        self.hashers
+            .into_iter()
+            .map(|(algorithm, hasher)| (algorithm, hasher.finalize()))
+            .collect()
+    }
+}
+
 /// Multiple strategy - calculate multiple algorithms in a single pass
 pub struct MultipleStrategy {
     buffer_size: usize,
@@ -75,22 +126,18 @@ impl HashingStrategy for MultipleStrategy {
 
         // Open the file
         let mut file = File::open(&context.file_path).await?;
-        let mut bytes_processed = 0u64;
         let mut io_operations = 0u64;
 
         // Allocate buffer
         let mut buffer = allocate_buffer(self.buffer_size)?;
 
         // Create streaming hashers for all requested algorithms
-        let mut hashers: HashMap<crate::HashAlgorithm, Box<dyn StreamingHasher>> = HashMap::new();
-        let mut total_hasher_memory = 0usize;
-
-        for &algorithm in &context.algorithms {
-            let algo_impl = algorithm.to_impl();
-            total_hasher_memory += algo_impl.memory_overhead();
-            let hasher: Box<dyn StreamingHasher> = algo_impl.create_hasher();
-            hashers.insert(algorithm, hasher);
-        }
+        let total_hasher_memory: usize = context
+            .algorithms
+            .iter()
+            .map(|algorithm| algorithm.to_impl().memory_overhead())
+            .sum();
+        let mut hashers = MultiHasher::new(&context.algorithms);
 
         // Calculate memory usage
         let memory_usage = self.buffer_size + total_hasher_memory;
@@ -106,12 +153,8 @@ impl HashingStrategy for MultipleStrategy {
             }
 
             // Update all hashers with the same data
-            let chunk = &buffer[..n];
-            for hasher in hashers.values_mut() {
-                hasher.update(chunk);
-            }
-
-            bytes_processed += n as u64;
+            hashers.update(&buffer[..n]);
+            let bytes_processed = hashers.bytes_processed();
 
             // Report progress
             progress_provider.report(ProgressUpdate::HashProgress {
@@ -120,6 +163,7 @@ impl HashingStrategy for MultipleStrategy {
                 total_bytes: context.file_size,
             });
         }
+        let bytes_processed = hashers.bytes_processed();
 
         // Release buffer early
         release_buffer(buffer);
@@ -128,8 +172,7 @@ impl HashingStrategy for MultipleStrategy {
         let mut results = HashMap::new();
         let duration = start_time.elapsed();
 
-        for (algorithm, hasher) in hashers {
-            let hash = hasher.finalize();
+        for (algorithm, hash) in hashers.finalize() {
             results.insert(
                 algorithm,
                 HashResult {
@@ -195,7 +238,6 @@ impl HashingStrategy for MultipleStrategy {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::hashing::HashAlgorithm;
     use std::path::PathBuf;
 
     #[test]
@@ -205,6 +247,32 @@ mod tests {
         assert_eq!(strategy.buffer_size, 8192);
     }
 
+    #[test]
+    fn test_multi_hasher_is_independent_of_piece_size() {
+        let data: Vec<u8> = (0..3 * HASH_SLICE_SIZE + 7).map(|i| i as u8).collect();
+        let algorithms = [
+            HashAlgorithm::ED2K,
+            HashAlgorithm::CRC32,
+            HashAlgorithm::MD5,
+        ];
+
+        let mut whole = MultiHasher::new(&algorithms);
+        whole.update(&data);
+
+        let mut pieces = MultiHasher::new(&algorithms);
+        for piece in data.chunks(4093) {
+            pieces.update(piece);
+        }
+        assert_eq!(pieces.bytes_processed(), data.len() as u64);
+
+        let expected: Vec<(HashAlgorithm, String)> = algorithms
+            .iter()
+            .map(|a| (*a, a.to_impl().hash_bytes(&data)))
+            .collect();
+        assert_eq!(whole.finalize(), expected);
+        assert_eq!(pieces.finalize(), expected);
+    }
+
     #[test]
     fn test_memory_requirements() {
         let strategy = MultipleStrategy::new(64 * 1024);
@@ -4,8 +4,8 @@
 //! algorithm requirements to choose the best strategy for each scenario.
 
 use super::{
-    HashingContext, HashingStrategy, HybridStrategy, MultipleStrategy, ParallelStrategy,
-    SequentialStrategy,
+    ChunkParallelStrategy, HashingContext, HashingStrategy, HybridStrategy, MultipleStrategy,
+    ParallelStrategy, SequentialStrategy,
 };
 use crate::HashAlgorithm;
 use std::sync::Arc;
@@ -54,6 +54,7 @@ impl StrategySelector {
             Box::new(MultipleStrategy::with_defaults()),
             Box::new(ParallelStrategy::with_defaults()),
             Box::new(HybridStrategy::with_defaults()),
+            Box::new(ChunkParallelStrategy::with_defaults()),
         ];
 
         Self { strategies, hint }
@@ -85,7 +86,7 @@ impl StrategySelector {
                 // Prefer parallel strategies for speed
                 self.strategies
                     .iter()
-                    .filter(|s| matches!(s.name(), "parallel" | "hybrid"))
+                    .filter(|s| matches!(s.name(), "parallel" | "hybrid" | "chunk_parallel"))
                     .collect()
             }
             StrategyHint::PreferSequential => {
@@ -99,7 +100,7 @@ impl StrategySelector {
                 // Only parallel strategies
                 self.strategies
                     .iter()
-                    .filter(|s| matches!(s.name(), "parallel" | "hybrid"))
+                    .filter(|s| matches!(s.name(), "parallel" | "hybrid" | "chunk_parallel"))
                     .collect()
             }
             StrategyHint::Automatic => {
@@ -157,7 +158,7 @@ impl StrategySelector {
                 }
             }
             StrategyHint::PreferSpeed => {
-                if matches!(strategy.name(), "parallel" | "hybrid") {
+                if matches!(strategy.name(), "parallel" | "hybrid" | "chunk_parallel") {
                     score += 150; // Bonus for parallel strategies
                 }
             }
@@ -247,6 +248,7 @@ impl StrategySelector {
             "multiple" => Arc::new(MultipleStrategy::with_defaults()),
             "parallel" => Arc::new(ParallelStrategy::with_defaults()),
             "hybrid" => Arc::new(HybridStrategy::with_defaults()),
+            "chunk_parallel" => Arc::new(ChunkParallelStrategy::with_defaults()),
             _ => Arc::new(SequentialStrategy::default()), // Fallback
         }
     }
@@ -269,7 +271,7 @@ mod tests {
     fn test_selector_creation() {
         let selector = StrategySelector::new();
         assert_eq!(selector.hint, StrategyHint::Automatic);
-        assert_eq!(selector.strategies.len(), 4);
+        assert_eq!(selector.strategies.len(), 5);
     }
 
     #[test]
@@ -311,7 +313,8 @@ mod tests {
     fn test_selection_ed2k_combo() {
         let selector = StrategySelector::new();
         let context = HashingContext {
-            file_path: PathBuf::from("/tmp/test"),
+            // An unclassified device, where chunk-parallel hashing is not chosen
+            file_path: PathBuf::from("/nonexistent/test"),
             file_size: 1024 * 1024 * 1024, // 1GB
             algorithms: vec![HashAlgorithm::ED2K, HashAlgorithm::MD5, HashAlgorithm::SHA1],
             config: HashConfig {
@@ -363,6 +366,38 @@ mod tests {
         assert!(matches!(strategy.name(), "parallel" | "hybrid"));
     }
 
+    #[test]
+    fn test_selection_chunk_parallel_for_large_ed2k() {
+        let selector = StrategySelector::with_strategies(vec![
+            Box::new(SequentialStrategy::default()),
+            Box::new(HybridStrategy::with_defaults()),
+            Box::new(ChunkParallelStrategy::new(4).ignore_device_class()),
+        ]);
+
+        // Large ED2K files go chunk-parallel, alone or with other algorithms
+        for algorithms in [
+            vec![HashAlgorithm::ED2K],
+            vec![HashAlgorithm::ED2K, HashAlgorithm::CRC32],
+        ] {
+            let context = HashingContext {
+                file_path: PathBuf::from("/tmp/test"),
+                file_size: 1024 * 1024 * 1024,
+                algorithms,
+                config: Default::default(),
+            };
+            assert_eq!(selector.select(&context).name(), "chunk_parallel");
+        }
+
+        // Small files are not worth splitting
+        let context = HashingContext {
+            file_path: PathBuf::from("/tmp/test"),
+            file_size: 10 * 1024 * 1024,
+            algorithms: vec![HashAlgorithm::ED2K],
+            config: Default::default(),
+        };
+        assert_eq!(selector.select(&context).name(), "sequential");
+    }
+
     #[test]
     fn test_fallback_selection() {
         let selector = StrategySelector::new();
@@ -0,0 +1,257 @@
+//! Batched identification by ED2K hash and size
+//!
+//! A library scan produces many (ED2K, size) pairs at once, often with
+//! duplicates (the same release in two folders). A batch is answered in
+//! three steps:
+//!
+//! 1. Duplicate pairs are collapsed so each file is looked up once.
+//! 2. Pairs already in the identification cache are answered immediately.
+//! 3. The rest are looked up one after another. AniDB UDP replies carry no
+//!    request tag, so the protocol client has a single command in flight;
+//!    the rate limiter decides when each packet goes out.
+//!
+//! Results are reported as they become available, for every input index.
+
+use crate::error::Result;
+use crate::identification::cache::{IdentificationCache, IdentificationKey, identification_key};
+use crate::identification::types::IdentificationResult;
+use async_trait::async_trait;
+use log::debug;
+use std::collections::HashMap;
+
+/// Something that can identify a single file by hash and size
+#[async_trait]
+pub trait FileLookup: Send + Sync {
+    /// Look up a file on AniDB
+    async fn lookup(&self, ed2k: &str, size: u64) -> Result<IdentificationResult>;
+}
+
+/// Counters for one batch
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct BatchStats {
+    /// Distinct (ED2K, size) pairs in the batch
+    pub unique: usize,
+    /// Distinct pairs answered from the cache
+    pub cache_hits: usize,
+    /// Distinct pairs looked up on the network
+    pub lookups: usize,
+    /// Whether the caller stopped the batch early
+    pub cancelled: bool,
+}
+
+/// Identify a batch of files
+///
+/// `on_result` is called once for every index of `items`, cache hits first
+/// and then in lookup order. Returning `false` from it stops the batch;
+/// files that were not looked up yet are not reported.
+pub async fn identify_batch<F>(
+    lookup: &dyn FileLookup,
+    cache: &IdentificationCache,
+    items: &[(String, u64)],
+    mut on_result: F,
+) -> BatchStats
+where
+    F: FnMut(usize, &Result<IdentificationResult>) -> bool,
+{
+    // Group input indices by pair, keeping first-occurrence order
+    let mut groups: Vec<(IdentificationKey, Vec<usize>)> = Vec::new();
+    let mut positions: HashMap<IdentificationKey, usize> = HashMap::new();
+    for (index, (ed2k, size)) in items.iter().enumerate() {
+        let key = identification_key(ed2k, *size);
+        match positions.get(&key) {
+            Some(&group) => groups[group].1.push(index),
+            None => {
+                positions.insert(key.clone(), groups.len());
+                groups.push((key, vec![index]));
+            }
+        }
+    }
+
+    let mut stats = BatchStats {
+        unique: groups.len(),
+        ..BatchStats::default()
+    };
+
+    let mut pending = Vec::with_capacity(groups.len());
+    for (key, indices) in groups {
+        match cache.get(&key.0, key.1) {
+            Some(result) => {
+                stats.cache_hits += 1;
+                let result = Ok(result);
+                if !report(&indices, &result, &mut on_result) {
+                    stats.cancelled = true;
+                    return stats;
+                }
+            }
+            None => pending.push((key, indices)),
+        }
+    }
+
+    debug!(
+        "Identifying batch of {} files: {} unique, {} cached",
+        items.len(),
+        stats.unique,
+        stats.cache_hits
+    );
+
+    for ((ed2k, size), indices) in pending {
+        stats.lookups += 1;
+        let result = lookup.lookup(&ed2k, size).await;
+        if let Ok(identified) = &result {
+            cache.insert(identified);
+        }
+        if !report(&indices, &result, &mut on_result) {
+            stats.cancelled = true;
+            break;
+        }
+    }
+
+    stats
+}
+
+fn report<F>(indices: &[usize], result: &Result<IdentificationResult>, on_result: &mut F) -> bool
+where
+    F: FnMut(usize, &Result<IdentificationResult>) -> bool,
+{
+    indices.iter().all(|&index| on_result(index, result))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::identification::types::{
+        FileInfo, IdentificationOptions, IdentificationRequest, IdentificationSource,
+        IdentificationStatus, Priority,
+    };
+    use std::sync::Mutex;
+    use std::time::Duration;
+
+    /// Lookup that identifies every file whose hash does not start with "0"
+    #[derive(Default)]
+    struct FakeLookup {
+        calls: Mutex<Vec<String>>,
+    }
+
+    #[async_trait]
+    impl FileLookup for FakeLookup {
+        async fn lookup(&self, ed2k: &str, size: u64) -> Result<IdentificationResult> {
+            self.calls.lock().unwrap().push(ed2k.to_string());
+            let request = IdentificationRequest {
+                source: IdentificationSource::HashWithSize {
+                    ed2k: ed2k.to_string(),
+                    size,
+                },
+                options: IdentificationOptions::default(),
+                priority: Priority::Normal,
+            };
+            if ed2k.starts_with('0') {
+                return Ok(IdentificationResult::not_found(request, Duration::ZERO));
+            }
+            let file = FileInfo {
+                fid: size,
+                aid: 1,
+                eid: 1,
+                gid: 1,
+                state: 0,
+                size,
+                ed2k: ed2k.to_string(),
+                md5: None,
+                sha1: None,
+                crc32: None,
+                quality: None,
+                source: None,
+                video_codec: None,
+                video_resolution: None,
+                audio_codec: None,
+                dub_language: None,
+                sub_language: None,
+                file_type: None,
+                anidb_filename: None,
+            };
+            Ok(IdentificationResult::success(
+                request,
+                file,
+                crate::identification::DataSource::Network {
+                    response_time: Duration::ZERO,
+                },
+                Duration::ZERO,
+            ))
+        }
+    }
+
+    fn items(pairs: &[(&str, u64)]) -> Vec<(String, u64)> {
+        pairs.iter().map(|(h, s)| (h.to_string(), *s)).collect()
+    }
+
+    #[tokio::test]
+    async fn test_duplicates_are_looked_up_once() {
+        let lookup = FakeLookup::default();
+        let cache = IdentificationCache::default();
+        let batch = items(&[("aa", 1), ("AA", 1), ("bb", 2), ("aa", 3), ("00", 4)]);
+
+        let mut reported = Vec::new();
+        let stats = identify_batch(&lookup, &cache, &batch, |index, result| {
+            reported.push((index, result.as_ref().unwrap().status));
+            true
+        })
+        .await;
+
+        assert_eq!(stats.unique, 4);
+        assert_eq!(stats.lookups, 4);
+        assert_eq!(lookup.calls.lock().unwrap().len(), 4);
+
+        reported.sort_by_key(|(index, _)| *index);
+        let indices: Vec<usize> = reported.iter().map(|(i, _)| *i).collect();
+        assert_eq!(indices, [0, 1, 2, 3, 4]);
+        assert_eq!(reported[4].1, IdentificationStatus::NotFound);
+
+        // Only identified files are cached
+        assert_eq!(cache.len(), 3);
+    }
+
+    #[tokio::test]
+    async fn test_cache_hits_come_first() {
+        let lookup = FakeLookup::default();
+        let cache = IdentificationCache::default();
+        identify_batch(&lookup, &cache, &items(&[("bb", 2)]), |_, _| true).await;
+
+        let mut order = Vec::new();
+        let stats = identify_batch(
+            &lookup,
+            &cache,
+            &items(&[("aa", 1), ("BB", 2)]),
+            |index, result| {
+                order.push((index, result.as_ref().unwrap().source.clone()));
+                true
+            },
+        )
+        .await;
+
+        assert_eq!(stats.cache_hits, 1);
+        assert_eq!(stats.lookups, 1);
+        assert_eq!(order[0].0, 1);
+        assert!(matches!(
+            order[0].1,
+            crate::identification::DataSource::Cache { .. }
+        ));
+        assert_eq!(order[1].0, 0);
+    }
+
+    #[tokio::test]
+    async fn test_stop_early() {
+        let lookup = FakeLookup::default();
+        let cache = IdentificationCache::default();
+        let batch = items(&[("aa", 1), ("bb", 2), ("cc", 3)]);
+
+        let mut seen = 0;
+        let stats = identify_batch(&lookup, &cache, &batch, |_, _| {
+            seen += 1;
+            false
+        })
+        .await;
+
+        assert!(stats.cancelled);
+        assert_eq!(seen, 1);
+        assert_eq!(lookup.calls.lock().unwrap().len(), 1);
+    }
+}
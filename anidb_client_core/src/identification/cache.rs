@@ -0,0 +1,244 @@
+//! In-memory cache of identification results
+//!
+//! Keyed on the ED2K hash and size a file is looked up by, so a file that
+//! has been identified once is answered again without a network query.
+//! Only identified files are kept: a file AniDB does not know yet may be
+//! added at any time.
+//!
+//! A cache may be backed by an [`IdentificationIndex`] snapshot, consulted
+//! for files the cache itself has not seen or holds only an expired result
+//! for, and exported as a new snapshot holding both. The TTL applies to a
+//! snapshot as a whole, measured from when it was written.
+
+use crate::Result;
+use crate::identification::index::{IdentificationIndex, IndexEntry};
+use crate::identification::types::{
+    DataSource, IdentificationResult, IdentificationSource, IdentificationStatus,
+};
+use std::collections::HashMap;
+use std::path::Path;
+use std::sync::{Arc, RwLock};
+use std::time::{Duration, SystemTime};
+
+/// Cache key: lowercase ED2K hash and file size
+pub type IdentificationKey = (String, u64);
+
+/// Build the cache key of a file
+pub fn identification_key(ed2k: &str, size: u64) -> IdentificationKey {
+    (ed2k.to_ascii_lowercase(), size)
+}
+
+/// Identification results by ED2K hash and size
+pub struct IdentificationCache {
+    ttl: Duration,
+    entries: RwLock<HashMap<IdentificationKey, IdentificationResult>>,
+    index: RwLock<Option<Arc<IdentificationIndex>>>,
+}
+
+impl IdentificationCache {
+    /// Create a cache whose entries expire after `ttl`
+    pub fn new(ttl: Duration) -> Self {
+        Self {
+            ttl,
+            entries: RwLock::new(HashMap::new()),
+            index: RwLock::new(None),
+        }
+    }
+
+    /// Cached result for a file, marked as coming from the cache
+    pub fn get(&self, ed2k: &str, size: u64) -> Option<IdentificationResult> {
+        let entries = self.entries.read().unwrap_or_else(|e| e.into_inner());
+        if let Some(cached) = entries.get(&identification_key(ed2k, size)) {
+            let age = cached_age(cached);
+            if age <= self.ttl {
+                let mut result = cached.clone();
+                result.source = DataSource::Cache { age };
+                result.processing_time = Duration::ZERO;
+                return Some(result);
+            }
+        }
+        drop(entries);
+
+        self.get_indexed(ed2k, size)
+    }
+
+    /// Look a file up in the index snapshot, if one is loaded and current
+    fn get_indexed(&self, ed2k: &str, size: u64) -> Option<IdentificationResult> {
+        let index = self.current_index()?;
+        let entry = index.get(ed2k, size)?;
+        let age = index.created().elapsed().unwrap_or_default();
+        Some(entry.to_result(age))
+    }
+
+    /// The index snapshot, unless it is older than the TTL
+    fn current_index(&self) -> Option<Arc<IdentificationIndex>> {
+        self.index()
+            .filter(|index| index.created().elapsed().unwrap_or_default() <= self.ttl)
+    }
+
+    /// Use `index` for files not in the cache, replacing any earlier one
+    pub fn set_index(&self, index: Option<Arc<IdentificationIndex>>) {
+        *self.index.write().unwrap_or_else(|e| e.into_inner()) = index;
+    }
+
+    /// The index snapshot in use
+    pub fn index(&self) -> Option<Arc<IdentificationIndex>> {
+        self.index.read().unwrap_or_else(|e| e.into_inner()).clone()
+    }
+
+    /// Write the index entries and every cached file as a new index
+    ///
+    /// Expired results are left out, since the new index restarts their
+    /// age. Returns the number of files written.
+    pub fn export(&self, path: &Path) -> Result<usize> {
+        let mut entries: Vec<IndexEntry> = self
+            .current_index()
+            .map(|index| index.entries().collect())
+            .unwrap_or_default();
+        let cached = self.entries.read().unwrap_or_else(|e| e.into_inner());
+        entries.extend(
+            cached
+                .values()
+                .filter(|result| cached_age(result) <= self.ttl)
+                .filter_map(IndexEntry::from_result),
+        );
+        drop(cached);
+
+        IdentificationIndex::write(path, entries)
+    }
+
+    /// Record a result; anything but an identified file is ignored
+    pub fn insert(&self, result: &IdentificationResult) {
+        if result.status != IdentificationStatus::Identified {
+            return;
+        }
+        let IdentificationSource::HashWithSize { ed2k, size } = &result.request.source else {
+            return;
+        };
+
+        let mut cached = result.clone();
+        cached.cached_at = Some(SystemTime::now());
+        self.entries
+            .write()
+            .unwrap_or_else(|e| e.into_inner())
+            .insert(identification_key(ed2k, *size), cached);
+    }
+
+    /// Number of cached results, not counting the index
+    pub fn len(&self) -> usize {
+        self.entries.read().unwrap_or_else(|e| e.into_inner()).len()
+    }
+
+    /// Whether the cache is empty
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Remove every entry; a loaded index is kept
+    pub fn clear(&self) {
+        self.entries
+            .write()
+            .unwrap_or_else(|e| e.into_inner())
+            .clear();
+    }
+}
+
+/// Time since a result was cached
+fn cached_age(result: &IdentificationResult) -> Duration {
+    result
+        .cached_at
+        .and_then(|at| at.elapsed().ok())
+        .unwrap_or_default()
+}
+
+impl Default for IdentificationCache {
+    fn default() -> Self {
+        Self::new(Duration::from_secs(86400 * 30))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn indexed(ed2k: &str, size: u64, title: &str) -> IndexEntry {
+        IndexEntry {
+            ed2k: ed2k.to_string(),
+            size,
+            fid: 1,
+            aid: 2,
+            eid: 3,
+            title: title.to_string(),
+            episode: "1".to_string(),
+        }
+    }
+
+    #[test]
+    fn test_index_backs_cache_and_exports() {
+        let dir = TempDir::new().unwrap();
+        let first = dir.path().join("first.idx");
+        let hash_a = "0123456789abcdef0123456789abcdef";
+        let hash_b = "fedcba9876543210fedcba9876543210";
+        IdentificationIndex::write(&first, [indexed(hash_a, 10, "Indexed")]).unwrap();
+
+        let cache = IdentificationCache::default();
+        assert!(cache.get(hash_a, 10).is_none());
+        cache.set_index(Some(Arc::new(IdentificationIndex::open(&first).unwrap())));
+
+        let hit = cache.get(&hash_a.to_uppercase(), 10).unwrap();
+        assert_eq!(hit.anime.unwrap().romaji_name, "Indexed");
+        assert!(matches!(hit.source, DataSource::Cache { .. }));
+        assert!(cache.get(hash_a, 11).is_none());
+        assert!(cache.is_empty());
+
+        // Identified files join the index entries in an export
+        cache.insert(&indexed(hash_b, 20, "Cached").to_result(Duration::ZERO));
+        let second = dir.path().join("second.idx");
+        assert_eq!(cache.export(&second).unwrap(), 2);
+
+        let fresh = IdentificationCache::default();
+        fresh.set_index(Some(Arc::new(IdentificationIndex::open(&second).unwrap())));
+        assert!(fresh.get(hash_a, 10).is_some());
+        assert_eq!(fresh.get(hash_b, 20).unwrap().file.unwrap().fid, 1);
+    }
+
+    #[test]
+    fn test_ttl_applies_to_cache_and_index() {
+        let dir = TempDir::new().unwrap();
+        let path = dir.path().join("files.idx");
+        let hash = "0123456789abcdef0123456789abcdef";
+        IdentificationIndex::write(&path, [indexed(hash, 10, "Indexed")]).unwrap();
+
+        let cache = IdentificationCache::new(Duration::from_secs(3600));
+        cache.set_index(Some(Arc::new(IdentificationIndex::open(&path).unwrap())));
+
+        // An expired cached result falls through to the index
+        cache.insert(&indexed(hash, 10, "Cached").to_result(Duration::ZERO));
+        assert_eq!(
+            cache.get(hash, 10).unwrap().anime.unwrap().romaji_name,
+            "Cached"
+        );
+        for cached in cache.entries.write().unwrap().values_mut() {
+            cached.cached_at = Some(SystemTime::now() - Duration::from_secs(7200));
+        }
+        assert_eq!(
+            cache.get(hash, 10).unwrap().anime.unwrap().romaji_name,
+            "Indexed"
+        );
+
+        // A snapshot written longer ago than the TTL is not consulted
+        let mut bytes = std::fs::read(&path).unwrap();
+        let created = SystemTime::now() - Duration::from_secs(7200);
+        let secs = created
+            .duration_since(SystemTime::UNIX_EPOCH)
+            .unwrap()
+            .as_secs();
+        bytes[16..24].copy_from_slice(&secs.to_le_bytes());
+        let stale = dir.path().join("stale.idx");
+        std::fs::write(&stale, bytes).unwrap();
+        cache.set_index(Some(Arc::new(IdentificationIndex::open(&stale).unwrap())));
+        assert!(cache.get(hash, 10).is_none());
+        assert_eq!(cache.export(&dir.path().join("export.idx")).unwrap(), 0);
+    }
+}
@@ -0,0 +1,434 @@
+//! Memory-mapped identification index
+//!
+//! An exportable snapshot of identified files, so a node can answer files
+//! another node has already identified without asking AniDB. The file is
+//! mapped rather than parsed: loading checks the header and is O(1) for
+//! any index size, and a lookup is a binary search over fixed-size records.
+//!
+//! Layout (all integers little-endian):
+//!
+//! ```text
+//! header   magic "ADIX", version u32, record count u64, created u64 (unix s)
+//! records  count x 64 bytes, sorted by (ed2k, size):
+//!          ed2k [u8; 16], size u64, fid u64, aid u64, eid u64,
+//!          title (offset u32, len u32), episode (offset u32, len u32)
+//! strings  UTF-8 blob; each distinct title and episode number stored once
+//! ```
+
+use crate::Result;
+use crate::identification::types::{
+    AnimeInfo, DataSource, EpisodeInfo, FileInfo, IdentificationOptions, IdentificationRequest,
+    IdentificationResult, IdentificationSource, IdentificationStatus, Priority,
+};
+use crate::platform::MappedFile;
+use std::cmp::Ordering;
+use std::collections::HashMap;
+use std::io::{BufWriter, Write};
+use std::path::Path;
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+/// File format magic and version
+const MAGIC: &[u8; 4] = b"ADIX";
+const FORMAT_VERSION: u32 = 1;
+
+const HEADER_SIZE: usize = 24;
+const RECORD_SIZE: usize = 64;
+
+/// One identified file, as stored in the index
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct IndexEntry {
+    /// Lowercase hex ED2K hash
+    pub ed2k: String,
+    pub size: u64,
+    pub fid: u64,
+    pub aid: u64,
+    pub eid: u64,
+    /// Anime title
+    pub title: String,
+    /// Episode number as AniDB writes it ("1", "S2", ...)
+    pub episode: String,
+}
+
+impl IndexEntry {
+    /// Entry for an identified file, if the result has the file details
+    pub fn from_result(result: &IdentificationResult) -> Option<Self> {
+        if result.status != IdentificationStatus::Identified {
+            return None;
+        }
+        let file = result.file.as_ref()?;
+        parse_ed2k(&file.ed2k)?;
+        Some(Self {
+            ed2k: file.ed2k.to_ascii_lowercase(),
+            size: file.size,
+            fid: file.fid,
+            aid: file.aid,
+            eid: file.eid,
+            title: result
+                .anime
+                .as_ref()
+                .map(|anime| anime.romaji_name.clone())
+                .unwrap_or_default(),
+            episode: result
+                .episode
+                .as_ref()
+                .map(|episode| episode.episode_number.clone())
+                .unwrap_or_default(),
+        })
+    }
+
+    /// Identification result built from the entry
+    pub fn to_result(&self, age: Duration) -> IdentificationResult {
+        let request = IdentificationRequest {
+            source: IdentificationSource::HashWithSize {
+                ed2k: self.ed2k.clone(),
+                size: self.size,
+            },
+            options: IdentificationOptions::default(),
+            priority: Priority::Normal,
+        };
+        let file = FileInfo {
+            fid: self.fid,
+            aid: self.aid,
+            eid: self.eid,
+            gid: 0,
+            state: 0,
+            size: self.size,
+            ed2k: self.ed2k.clone(),
+            md5: None,
+            sha1: None,
+            crc32: None,
+            quality: None,
+            source: None,
+            video_codec: None,
+            video_resolution: None,
+            audio_codec: None,
+            dub_language: None,
+            sub_language: None,
+            file_type: None,
+            anidb_filename: None,
+        };
+
+        let mut result =
+            IdentificationResult::success(request, file, DataSource::Cache { age }, Duration::ZERO);
+        result.anime = Some(AnimeInfo {
+            aid: self.aid,
+            romaji_name: self.title.clone(),
+            kanji_name: None,
+            english_name: None,
+            year: None,
+            type_: None,
+            episode_count: None,
+            rating: None,
+            categories: Vec::new(),
+        });
+        result.episode = Some(EpisodeInfo {
+            eid: self.eid,
+            aid: self.aid,
+            episode_number: self.episode.clone(),
+            english_name: None,
+            romaji_name: None,
+            kanji_name: None,
+            length: None,
+            aired_date: None,
+        });
+        result
+    }
+}
+
+/// A loaded identification index
+#[derive(Debug)]
+pub struct IdentificationIndex {
+    file: MappedFile,
+    count: usize,
+    created: SystemTime,
+}
+
+impl IdentificationIndex {
+    /// Map an index file
+    ///
+    /// Only the header is checked; record contents are validated as they
+    /// are read, so a damaged record fails its own lookup and nothing else.
+    pub fn open(path: &Path) -> Result<Self> {
+        let file = MappedFile::open(path)?;
+        let bytes = file.as_slice();
+
+        if bytes.len() < HEADER_SIZE || &bytes[..4] != MAGIC {
+            return Err(invalid("not an identification index").into());
+        }
+        if read_u32(bytes, 4) != FORMAT_VERSION {
+            return Err(invalid("unsupported identification index version").into());
+        }
+        let count = usize::try_from(read_u64(bytes, 8))
+            .ok()
+            .filter(|count| {
+                count
+                    .checked_mul(RECORD_SIZE)
+                    .and_then(|len| len.checked_add(HEADER_SIZE))
+                    .is_some_and(|len| len <= bytes.len())
+            })
+            .ok_or_else(|| invalid("identification index is truncated"))?;
+        let created = UNIX_EPOCH + Duration::from_secs(read_u64(bytes, 16));
+
+        Ok(Self {
+            file,
+            count,
+            created,
+        })
+    }
+
+    /// Number of files in the index
+    pub fn len(&self) -> usize {
+        self.count
+    }
+
+    /// Whether the index is empty
+    pub fn is_empty(&self) -> bool {
+        self.count == 0
+    }
+
+    /// When the index was written
+    pub fn created(&self) -> SystemTime {
+        self.created
+    }
+
+    /// Look up a file by hex ED2K hash and size
+    pub fn get(&self, ed2k: &str, size: u64) -> Option<IndexEntry> {
+        let key = parse_ed2k(ed2k)?;
+
+        let (mut low, mut high) = (0, self.count);
+        while low < high {
+            let mid = low + (high - low) / 2;
+            let record = self.record(mid);
+            match compare_key(record, &key, size) {
+                Ordering::Less => low = mid + 1,
+                Ordering::Greater => high = mid,
+                Ordering::Equal => return self.entry(record),
+            }
+        }
+        None
+    }
+
+    /// Every entry in the index, in key order
+    pub fn entries(&self) -> impl Iterator<Item = IndexEntry> + '_ {
+        (0..self.count).filter_map(|i| self.entry(self.record(i)))
+    }
+
+    fn record(&self, index: usize) -> &[u8] {
+        let start = HEADER_SIZE + index * RECORD_SIZE;
+        &self.file.as_slice()[start..start + RECORD_SIZE]
+    }
+
+    fn entry(&self, record: &[u8]) -> Option<IndexEntry> {
+        let strings = &self.file.as_slice()[HEADER_SIZE + self.count * RECORD_SIZE..];
+        Some(IndexEntry {
+            ed2k: format_ed2k(&record[..16]),
+            size: read_u64(record, 16),
+            fid: read_u64(record, 24),
+            aid: read_u64(record, 32),
+            eid: read_u64(record, 40),
+            title: read_string(strings, record, 48)?,
+            episode: read_string(strings, record, 56)?,
+        })
+    }
+
+    /// Write an index of `entries` to `path`
+    ///
+    /// Later entries replace earlier ones with the same hash and size. The
+    /// index is written to a temporary file and renamed over `path`, so an
+    /// index being read by another process is never modified in place.
+    pub fn write(path: &Path, entries: impl IntoIterator<Item = IndexEntry>) -> Result<usize> {
+        let mut by_key: HashMap<([u8; 16], u64), IndexEntry> = HashMap::new();
+        for entry in entries {
+            let Some(key) = parse_ed2k(&entry.ed2k) else {
+                continue;
+            };
+            by_key.insert((key, entry.size), entry);
+        }
+        let mut sorted: Vec<(([u8; 16], u64), IndexEntry)> = by_key.into_iter().collect();
+        sorted.sort_unstable_by(|a, b| a.0.cmp(&b.0));
+
+        let mut strings: Vec<u8> = Vec::new();
+        let mut interned: HashMap<String, (u32, u32)> = HashMap::new();
+        let mut intern = |s: &str| -> Result<(u32, u32)> {
+            if let Some(&span) = interned.get(s) {
+                return Ok(span);
+            }
+            let span = (
+                u32::try_from(strings.len()).map_err(|_| invalid("index strings too large"))?,
+                u32::try_from(s.len()).map_err(|_| invalid("index string too large"))?,
+            );
+            strings.extend_from_slice(s.as_bytes());
+            interned.insert(s.to_string(), span);
+            Ok(span)
+        };
+
+        let created = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map_or(0, |d| d.as_secs());
+        let tmp_path = path.with_extension("tmp");
+        let mut writer = BufWriter::new(std::fs::File::create(&tmp_path)?);
+        writer.write_all(MAGIC)?;
+        writer.write_all(&FORMAT_VERSION.to_le_bytes())?;
+        writer.write_all(&(sorted.len() as u64).to_le_bytes())?;
+        writer.write_all(&created.to_le_bytes())?;
+
+        for ((key, size), entry) in &sorted {
+            let title = intern(&entry.title)?;
+            let episode = intern(&entry.episode)?;
+            writer.write_all(key)?;
+            for value in [*size, entry.fid, entry.aid, entry.eid] {
+                writer.write_all(&value.to_le_bytes())?;
+            }
+            for value in [title.0, title.1, episode.0, episode.1] {
+                writer.write_all(&value.to_le_bytes())?;
+            }
+        }
+        writer.write_all(&strings)?;
+
+        writer
+            .into_inner()
+            .map_err(|e| e.into_error())?
+            .sync_all()?;
+        std::fs::rename(&tmp_path, path)?;
+        Ok(sorted.len())
+    }
+}
+
+fn invalid(message: &str) -> std::io::Error {
+    std::io::Error::new(std::io::ErrorKind::InvalidData, message)
+}
+
+fn read_u32(bytes: &[u8], offset: usize) -> u32 {
+    u32::from_le_bytes(bytes[offset..offset + 4].try_into().unwrap())
+}
+
+fn read_u64(bytes: &[u8], offset: usize) -> u64 {
+    u64::from_le_bytes(bytes[offset..offset + 8].try_into().unwrap())
+}
+
+fn read_string(strings: &[u8], record: &[u8], offset: usize) -> Option<String> {
+    let start = read_u32(record, offset) as usize;
+    let len = read_u32(record, offset + 4) as usize;
+    let bytes = strings.get(start..start.checked_add(len)?)?;
+    std::str::from_utf8(bytes).ok().map(str::to_string)
+}
+
+fn compare_key(record: &[u8], key: &[u8; 16], size: u64) -> Ordering {
+    record[..16]
+        .cmp(key)
+        .then_with(|| read_u64(record, 16).cmp(&size))
+}
+
+/// Decode a 32 character hex ED2K hash
+fn parse_ed2k(ed2k: &str) -> Option<[u8; 16]> {
+    if ed2k.len() != 32 {
+        return None;
+    }
+    let mut key = [0u8; 16];
+    for (byte, pair) in key.iter_mut().zip(ed2k.as_bytes().chunks_exact(2)) {
+        let pair = std::str::from_utf8(pair).ok()?;
+        *byte = u8::from_str_radix(pair, 16).ok()?;
+    }
+    Some(key)
+}
+
+fn format_ed2k(key: &[u8]) -> String {
+    key.iter().map(|b| format!("{b:02x}")).collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn entry(ed2k: &str, size: u64, title: &str, episode: &str) -> IndexEntry {
+        IndexEntry {
+            ed2k: ed2k.to_string(),
+            size,
+            fid: size * 10,
+            aid: 7,
+            eid: size,
+            title: title.to_string(),
+            episode: episode.to_string(),
+        }
+    }
+
+    #[test]
+    fn test_write_and_lookup() {
+        let dir = TempDir::new().unwrap();
+        let path = dir.path().join("index.bin");
+
+        let entries: Vec<IndexEntry> = (0..100u64)
+            .map(|i| {
+                entry(
+                    &format!("{:032x}", i * 7919),
+                    i + 1,
+                    "Show",
+                    &(i + 1).to_string(),
+                )
+            })
+            .collect();
+        assert_eq!(
+            IdentificationIndex::write(&path, entries.clone()).unwrap(),
+            100
+        );
+
+        let index = IdentificationIndex::open(&path).unwrap();
+        assert_eq!(index.len(), 100);
+        for expected in &entries {
+            assert_eq!(
+                index.get(&expected.ed2k, expected.size).as_ref(),
+                Some(expected)
+            );
+        }
+        // Uppercase hashes match; a different size does not
+        let upper = entries[5].ed2k.to_uppercase();
+        assert_eq!(index.get(&upper, entries[5].size), Some(entries[5].clone()));
+        assert_eq!(index.get(&entries[5].ed2k, 999), None);
+        assert_eq!(index.get("not a hash", 1), None);
+
+        // The shared title is stored once
+        let file_len = std::fs::metadata(&path).unwrap().len() as usize;
+        assert!(file_len < HEADER_SIZE + 100 * RECORD_SIZE + 4 + 100 * 3);
+        assert_eq!(index.entries().count(), 100);
+    }
+
+    #[test]
+    fn test_later_entries_replace_earlier() {
+        let dir = TempDir::new().unwrap();
+        let path = dir.path().join("index.bin");
+        let hash = "0123456789abcdef0123456789abcdef";
+
+        IdentificationIndex::write(
+            &path,
+            [entry(hash, 1, "Old", "1"), entry(hash, 1, "New", "S1")],
+        )
+        .unwrap();
+        let index = IdentificationIndex::open(&path).unwrap();
+        assert_eq!(index.len(), 1);
+        assert_eq!(index.get(hash, 1).unwrap().title, "New");
+        assert_eq!(index.get(hash, 1).unwrap().episode, "S1");
+    }
+
+    #[test]
+    fn test_rejects_bad_files() {
+        let dir = TempDir::new().unwrap();
+        let path = dir.path().join("index.bin");
+
+        std::fs::write(&path, b"").unwrap();
+        assert!(IdentificationIndex::open(&path).is_err());
+        std::fs::write(&path, b"ADHC\x01\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0").unwrap();
+        assert!(IdentificationIndex::open(&path).is_err());
+
+        // A header claiming more records than the file holds
+        let mut truncated = Vec::from(&MAGIC[..]);
+        truncated.extend_from_slice(&FORMAT_VERSION.to_le_bytes());
+        truncated.extend_from_slice(&5u64.to_le_bytes());
+        truncated.extend_from_slice(&0u64.to_le_bytes());
+        std::fs::write(&path, &truncated).unwrap();
+        assert!(IdentificationIndex::open(&path).is_err());
+
+        IdentificationIndex::write(&path, []).unwrap();
+        assert!(IdentificationIndex::open(&path).unwrap().is_empty());
+    }
+}
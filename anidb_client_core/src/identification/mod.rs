@@ -4,12 +4,20 @@
 //! - Network queries to AniDB API
 //! - Smart retry logic with exponential backoff
 //! - Progress reporting for UI integration
+//! - Batched lookups that dedupe files and answer known ones from a cache
+//! - A memory-mapped index of identified files that nodes can share
 
+pub mod batch;
+pub mod cache;
+pub mod index;
 pub mod query_manager;
 pub mod service;
 pub mod types;
 
 // Re-export main types
+pub use batch::{BatchStats, FileLookup, identify_batch};
+pub use cache::IdentificationCache;
+pub use index::{IdentificationIndex, IndexEntry};
 pub use query_manager::AniDBQueryManager;
 pub use service::{FileIdentificationService, IdentificationService, ServiceConfig};
 pub use types::{
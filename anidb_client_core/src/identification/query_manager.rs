@@ -4,20 +4,28 @@
 
 use crate::error::Result;
 use crate::identification::types::{
-    AnimeInfo, DataSource, FileInfo, IdentificationError, IdentificationResult,
+    AnimeInfo, DataSource, FileInfo, GroupInfo, IdentificationError, IdentificationResult,
     IdentificationSource, IdentificationStatus,
 };
 use crate::protocol::client::ProtocolClient;
 use crate::protocol::messages::{Command, Response};
 use log::{debug, trace, warn};
+use std::collections::HashMap;
 use std::sync::Arc;
 use std::time::Instant;
 use tokio::sync::Mutex;
 
+/// Most anime and group names remembered before the memo is reset
+const MAX_REMEMBERED_NAMES: usize = 4096;
+
 /// Manager for AniDB protocol queries
 pub struct AniDBQueryManager {
     client: Arc<Mutex<ProtocolClient>>,
     authenticated: Arc<Mutex<bool>>,
+    /// Anime and group details already fetched. The files of a season
+    /// pack share both, so each is queried once rather than once per file.
+    anime: std::sync::Mutex<HashMap<u64, AnimeInfo>>,
+    groups: std::sync::Mutex<HashMap<u64, GroupInfo>>,
 }
 
 impl AniDBQueryManager {
@@ -26,6 +34,8 @@ impl AniDBQueryManager {
         Self {
             client,
             authenticated: Arc::new(Mutex::new(false)),
+            anime: std::sync::Mutex::new(HashMap::new()),
+            groups: std::sync::Mutex::new(HashMap::new()),
         }
     }
 
@@ -169,7 +179,7 @@ impl AniDBQueryManager {
 
                     // Query anime information
                     if file_info.aid > 0 {
-                        match self.query_anime(file_info.aid).await {
+                        match self.anime_info(file_info.aid).await {
                             Ok(Some(anime_info)) => {
                                 debug!(
                                     "Successfully fetched anime info: {}",
@@ -249,7 +259,7 @@ impl AniDBQueryManager {
 
                     // Query group information
                     if file_info.gid > 0 {
-                        match self.query_group(file_info.gid).await {
+                        match self.group_info(file_info.gid).await {
                             Ok(Some(group_info)) => {
                                 debug!("Successfully fetched group info: {}", group_info.name);
                                 result.group = Some(group_info);
@@ -367,6 +377,32 @@ impl AniDBQueryManager {
         *self.authenticated.lock().await
     }
 
+    /// Anime information, queried only if not fetched before
+    async fn anime_info(&self, aid: u64) -> Result<Option<AnimeInfo>> {
+        if let Some(anime) = remembered(&self.anime, aid) {
+            trace!("Anime {aid} already fetched");
+            return Ok(Some(anime));
+        }
+        let anime = self.query_anime(aid).await?;
+        if let Some(anime) = &anime {
+            remember(&self.anime, aid, anime.clone());
+        }
+        Ok(anime)
+    }
+
+    /// Group information, queried only if not fetched before
+    async fn group_info(&self, gid: u64) -> Result<Option<GroupInfo>> {
+        if let Some(group) = remembered(&self.groups, gid) {
+            trace!("Group {gid} already fetched");
+            return Ok(Some(group));
+        }
+        let group = self.query_group(gid).await?;
+        if let Some(group) = &group {
+            remember(&self.groups, gid, group.clone());
+        }
+        Ok(group)
+    }
+
     /// Query anime information from AniDB
     pub async fn query_anime(&self, aid: u64) -> Result<Option<AnimeInfo>> {
         debug!("Querying anime with AID: {aid}");
@@ -556,3 +592,18 @@ impl AniDBQueryManager {
         }
     }
 }
+
+fn remembered<T: Clone>(memo: &std::sync::Mutex<HashMap<u64, T>>, id: u64) -> Option<T> {
+    memo.lock()
+        .unwrap_or_else(|e| e.into_inner())
+        .get(&id)
+        .cloned()
+}
+
+fn remember<T>(memo: &std::sync::Mutex<HashMap<u64, T>>, id: u64, value: T) {
+    let mut memo = memo.lock().unwrap_or_else(|e| e.into_inner());
+    if memo.len() >= MAX_REMEMBERED_NAMES {
+        memo.clear();
+    }
+    memo.insert(id, value);
+}
@@ -15,6 +15,7 @@ use crate::identification::types::{
 use crate::progress::{NullProvider, ProgressProvider, ProgressUpdate, SharedProvider};
 use crate::protocol::ProtocolConfig;
 use crate::protocol::client::ProtocolClient;
+use crate::scheduler;
 use crate::security::credential_store::CredentialStore;
 use crate::security::fallback::EncryptedFileStore;
 use std::path::Path;
@@ -426,10 +427,10 @@ impl IdentificationService for FileIdentificationService {
             let sem = semaphore.clone();
             let service = self.clone(); // Assuming we implement Clone
 
-            let handle = tokio::spawn(async move {
+            let handle = tokio::spawn(scheduler::Priority::current().scope(async move {
                 let _permit = sem.acquire().await.unwrap();
                 service.process_request(request).await
-            });
+            }));
 
             handles.push(handle);
         }
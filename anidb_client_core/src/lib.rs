@@ -6,6 +6,7 @@
 pub mod api;
 pub mod batch_processor;
 pub mod buffer;
+pub mod cache;
 #[cfg(feature = "database")]
 pub mod database;
 pub mod error;
@@ -13,16 +14,20 @@ pub mod ffi;
 pub mod ffi_inline;
 pub mod ffi_memory;
 pub mod ffi_optimization;
+pub mod file_discovery;
 pub mod file_io;
 pub mod file_processing;
 pub mod hashing;
 pub mod identification;
 pub mod memory;
+pub mod metrics;
 pub mod pipeline;
 pub mod platform;
 pub mod progress;
 pub mod protocol;
+pub mod scheduler;
 pub mod security;
+pub mod tuning;
 
 // Test utilities module (available for tests)
 #[cfg(any(test, feature = "test-utils"))]
@@ -39,11 +44,14 @@ pub use buffer::{
     DEFAULT_BUFFER_SIZE, DEFAULT_MEMORY_LIMIT, allocate_buffer, get_memory_limit, memory_used,
     release_buffer, set_memory_limit,
 };
+pub use cache::{CacheOptions, CacheStats, FileIdentity, HashCache};
 #[cfg(feature = "database")]
 pub use database::{Database, DatabaseStats};
 pub use error::{Error, Result};
 pub use file_io::{FileProcessingResult, FileProcessor, ProcessingStatus};
 pub use hashing::{Ed2kVariant, HashAlgorithm, HashCalculator, HashResult, ParallelConfig};
+pub use metrics::{ProcessingMetrics, ProcessingMetricsSnapshot, StageTimings};
+pub use platform::IoMode;
 pub use progress::{
     ChannelAdapter, NullProvider, ProgressProvider, ProgressUpdate, SharedProvider,
 };
@@ -71,6 +79,26 @@ pub struct ClientConfig {
     pub password: Option<String>,
     pub client_name: Option<String>,
     pub client_version: Option<String>,
+    /// How file data is read from disk
+    #[serde(default)]
+    pub io_mode: IoMode,
+    /// Tune chunk size, hashing queue depth and readers per device from the
+    /// observed throughput instead of using the values above as they are,
+    /// see [`tuning`]
+    #[serde(default)]
+    pub auto_tune: bool,
+    /// AniDB UDP API server as `host:port`, `None` for AniDB itself. For
+    /// test servers such as the mock in `anidb-test-utils`.
+    #[serde(default)]
+    pub server: Option<String>,
+    /// Packets per second sent to `server`, replacing AniDB's flood limits.
+    /// Ignored unless `server` is set.
+    #[serde(default)]
+    pub request_rate: Option<f64>,
+    /// How long to wait for each AniDB response, `None` for the protocol
+    /// default
+    #[serde(default)]
+    pub request_timeout: Option<std::time::Duration>,
 }
 
 impl Default for ClientConfig {
@@ -83,6 +111,11 @@ impl Default for ClientConfig {
             password: None,
             client_name: None,
             client_version: None,
+            io_mode: IoMode::Auto,
+            auto_tune: false,
+            server: None,
+            request_rate: None,
+            request_timeout: None,
         }
     }
 }
@@ -98,6 +131,11 @@ impl ClientConfig {
             password: Some("testpass".to_string()),
             client_name: Some("testclient".to_string()),
             client_version: Some("1".to_string()),
+            io_mode: IoMode::Auto,
+            auto_tune: false,
+            server: None,
+            request_rate: None,
+            request_timeout: None,
         }
     }
 }
@@ -16,7 +16,7 @@ mod pool;
 mod stats;
 mod tracker;
 
-pub use pool::{BufferPool, PooledBuffer};
+pub use pool::{BufferPool, PoolInfo, PooledBuffer};
 pub use stats::{MemoryDiagnostics, MemoryStats};
 pub use tracker::MemoryTracker;
 
@@ -156,13 +156,16 @@ impl MemoryManager {
         let category = BufferSize::for_size(size);
         let actual_size = category.size().max(size);
 
+        let pools = self.pools.read().ok();
+        let pool = pools.as_ref().and_then(|pools| pools.get(&category));
+
         // Try to get from pool first
-        if let Ok(pools) = self.pools.read()
-            && let Some(pool) = pools.get(&category)
+        if let Some(pool) = pool
             && let Some(mut buffer) = pool.try_acquire()
         {
             // Reused from pool
             self.stats.record_pool_hit();
+            pool.record_checkout(buffer.capacity(), true);
             buffer.resize(size, 0);
             return Ok(buffer);
         }
@@ -179,6 +182,9 @@ impl MemoryManager {
 
         // Update statistics
         self.stats.record_allocation(actual_size);
+        if let Some(pool) = pool {
+            pool.record_checkout(buffer.capacity(), false);
+        }
 
         Ok(buffer)
     }
@@ -191,12 +197,13 @@ impl MemoryManager {
         // Try to return to pool
         let returned_to_pool = if let Ok(pools) = self.pools.read() {
             if let Some(pool) = pools.get(&category) {
+                pool.record_checkin(capacity);
+
                 // Check if we should pool this buffer
                 if pool.should_pool() {
                     buffer.clear();
                     buffer.resize(category.size().min(capacity), 0);
-                    pool.release(buffer);
-                    true
+                    pool.release(buffer)
                 } else {
                     false
                 }
@@ -229,7 +236,18 @@ impl MemoryManager {
 
     /// Get memory limit
     pub fn memory_limit(&self) -> usize {
-        self.config.max_memory
+        self.tracker.limit()
+    }
+
+    /// Change the memory limit, shrinking the pools to fit under it
+    pub fn set_memory_limit(&self, limit: usize) {
+        self.tracker.set_limit(limit);
+        self.shrink_pools(limit);
+    }
+
+    /// Get the highest memory usage seen
+    pub fn memory_peak(&self) -> usize {
+        self.tracker.peak()
     }
 
     /// Get memory usage as a percentage
@@ -274,20 +292,43 @@ impl MemoryManager {
         }
     }
 
-    /// Clear all buffer pools
-    pub fn clear_pools(&self) {
+    /// Information about every pool, smallest buffers first
+    pub fn pool_info(&self) -> Vec<PoolInfo> {
+        if let Ok(pools) = self.pools.read() {
+            BufferSize::all()
+                .iter()
+                .filter_map(|size| pools.get(size).map(BufferPool::info))
+                .collect()
+        } else {
+            Vec::new()
+        }
+    }
+
+    /// Bytes held idle in the pools
+    pub fn pooled_memory(&self) -> usize {
+        self.pool_info().iter().map(|info| info.memory_used).sum()
+    }
+
+    /// Clear all buffer pools, returning the bytes freed
+    pub fn clear_pools(&self) -> usize {
+        let mut freed = 0;
         if let Ok(pools) = self.pools.read() {
             for pool in pools.values() {
-                pool.clear();
+                freed += pool.clear();
             }
         }
+        self.tracker.deallocate(freed);
+        freed
     }
 
-    /// Shrink pools to reclaim memory
-    pub fn shrink_pools(&self, target_memory: usize) {
+    /// Shrink pools to reclaim memory, returning the bytes freed
+    ///
+    /// Only pooled buffers are freed, so usage may stay above the target
+    /// while buffers are handed out.
+    pub fn shrink_pools(&self, target_memory: usize) -> usize {
         let current = self.memory_used();
         if current <= target_memory {
-            return;
+            return 0;
         }
 
         let to_free = current - target_memory;
@@ -305,15 +346,26 @@ impl MemoryManager {
                 }
             }
         }
+
+        self.tracker.deallocate(freed);
+        freed
+    }
+
+    /// Evict stale buffers from all pools, returning the bytes freed
+    pub fn evict_stale(&self) -> usize {
+        self.evict_older_than(self.config.eviction_timeout)
     }
 
-    /// Evict stale buffers from all pools
-    pub fn evict_stale(&self) {
+    /// Evict pooled buffers idle for longer than `max_age`, returning the bytes freed
+    pub fn evict_older_than(&self, max_age: Duration) -> usize {
+        let mut freed = 0;
         if let Ok(pools) = self.pools.read() {
             for pool in pools.values() {
-                pool.evict_stale(self.config.eviction_timeout);
+                freed += pool.evict_stale(max_age);
             }
         }
+        self.tracker.deallocate(freed);
+        freed
     }
 
     /// Run diagnostics if enabled and enough time has passed
@@ -385,6 +437,26 @@ pub fn memory_limit() -> usize {
     GLOBAL_MEMORY_MANAGER.memory_limit()
 }
 
+/// Change the global memory limit, shrinking the pools to fit under it
+pub fn set_memory_limit(limit: usize) {
+    GLOBAL_MEMORY_MANAGER.set_memory_limit(limit)
+}
+
+/// Get the highest global memory usage seen
+pub fn memory_peak() -> usize {
+    GLOBAL_MEMORY_MANAGER.memory_peak()
+}
+
+/// Get information about every global pool, smallest buffers first
+pub fn pool_info() -> Vec<PoolInfo> {
+    GLOBAL_MEMORY_MANAGER.pool_info()
+}
+
+/// Get the bytes held idle in the global pools
+pub fn pooled_memory() -> usize {
+    GLOBAL_MEMORY_MANAGER.pooled_memory()
+}
+
 /// Get global memory statistics
 pub fn stats() -> MemoryStats {
     GLOBAL_MEMORY_MANAGER.stats()
@@ -395,21 +467,26 @@ pub fn diagnostics() -> MemoryDiagnostics {
     GLOBAL_MEMORY_MANAGER.diagnostics()
 }
 
-/// Clear all global buffer pools
-pub fn clear_pools() {
+/// Clear all global buffer pools, returning the bytes freed
+pub fn clear_pools() -> usize {
     GLOBAL_MEMORY_MANAGER.clear_pools()
 }
 
-/// Shrink global pools to target memory
-pub fn shrink_pools(target_memory: usize) {
+/// Shrink global pools to target memory, returning the bytes freed
+pub fn shrink_pools(target_memory: usize) -> usize {
     GLOBAL_MEMORY_MANAGER.shrink_pools(target_memory)
 }
 
-/// Evict stale buffers from global pools
-pub fn evict_stale() {
+/// Evict stale buffers from global pools, returning the bytes freed
+pub fn evict_stale() -> usize {
     GLOBAL_MEMORY_MANAGER.evict_stale()
 }
 
+/// Evict global pooled buffers idle for longer than `max_age`
+pub fn evict_older_than(max_age: Duration) -> usize {
+    GLOBAL_MEMORY_MANAGER.evict_older_than(max_age)
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -541,4 +618,47 @@ mod tests {
             "Memory should not increase after shrinking"
         );
     }
+
+    #[test]
+    fn test_reclaimed_memory_is_untracked() {
+        let manager = MemoryManager::new();
+
+        let buffers: Vec<_> = (0..3)
+            .map(|_| manager.allocate(64 * 1024).unwrap())
+            .collect();
+        let medium = &manager.pool_info()[1];
+        assert_eq!(medium.size_category, BufferSize::Medium);
+        assert_eq!((medium.misses, medium.bytes_in_use), (3, 3 * 64 * 1024));
+
+        for buffer in buffers {
+            manager.release(buffer);
+        }
+        assert_eq!(manager.pooled_memory(), 3 * 64 * 1024);
+        assert_eq!(manager.memory_used(), 3 * 64 * 1024);
+
+        // Freed pool buffers no longer count against the limit
+        assert_eq!(manager.shrink_pools(64 * 1024), 2 * 64 * 1024);
+        assert_eq!(manager.memory_used(), 64 * 1024);
+        assert_eq!(manager.evict_older_than(Duration::ZERO), 64 * 1024);
+        assert_eq!(manager.memory_used(), 0);
+        assert_eq!(manager.memory_peak(), 3 * 64 * 1024);
+
+        let medium = &manager.pool_info()[1];
+        assert_eq!(medium.bytes_in_use, 0);
+        assert_eq!(medium.peak_bytes, 3 * 64 * 1024);
+    }
+
+    #[test]
+    fn test_lowered_limit_shrinks_pools() {
+        let manager = MemoryManager::new();
+
+        let buffer = manager.allocate(1024 * 1024).unwrap();
+        manager.release(buffer);
+        assert_eq!(manager.memory_used(), 1024 * 1024);
+
+        manager.set_memory_limit(512 * 1024);
+        assert_eq!(manager.memory_limit(), 512 * 1024);
+        assert_eq!(manager.memory_used(), 0);
+        assert!(manager.allocate(1024 * 1024).is_err());
+    }
 }
@@ -3,6 +3,7 @@
 use super::BufferSize;
 use std::collections::VecDeque;
 use std::sync::Mutex;
+use std::sync::atomic::{AtomicUsize, Ordering};
 use std::time::{Duration, Instant};
 
 /// A buffer with tracking metadata
@@ -26,6 +27,26 @@ pub struct PoolInfo {
     pub memory_used: usize,
     /// Number of times buffers were reused
     pub total_reuses: usize,
+    /// Allocations served from this pool
+    pub hits: usize,
+    /// Allocations of this size that had to allocate a new buffer
+    pub misses: usize,
+    /// Bytes of this size handed out and not yet released
+    pub bytes_in_use: usize,
+    /// Highest bytes in use and pooled at the same time
+    pub peak_bytes: usize,
+}
+
+impl PoolInfo {
+    /// Fraction of allocations served from the pool
+    pub fn hit_rate(&self) -> f64 {
+        let total = self.hits + self.misses;
+        if total == 0 {
+            0.0
+        } else {
+            self.hits as f64 / total as f64
+        }
+    }
 }
 
 /// A pool of buffers for a specific size category
@@ -38,6 +59,16 @@ pub struct BufferPool {
     buffers: Mutex<VecDeque<PooledBuffer>>,
     /// Total number of reuses
     total_reuses: Mutex<usize>,
+    /// Allocations served from the pool
+    hits: AtomicUsize,
+    /// Allocations that found the pool empty
+    misses: AtomicUsize,
+    /// Bytes handed out and not yet released
+    in_use: AtomicUsize,
+    /// Bytes held in the pool
+    pooled: AtomicUsize,
+    /// Highest `in_use + pooled` seen
+    peak: AtomicUsize,
 }
 
 impl BufferPool {
@@ -48,13 +79,48 @@ impl BufferPool {
             max_size,
             buffers: Mutex::new(VecDeque::with_capacity(max_size)),
             total_reuses: Mutex::new(0),
+            hits: AtomicUsize::new(0),
+            misses: AtomicUsize::new(0),
+            in_use: AtomicUsize::new(0),
+            pooled: AtomicUsize::new(0),
+            peak: AtomicUsize::new(0),
         }
     }
 
+    /// Record a buffer of `bytes` handed out, reused or newly allocated
+    pub fn record_checkout(&self, bytes: usize, reused: bool) {
+        let counter = if reused { &self.hits } else { &self.misses };
+        counter.fetch_add(1, Ordering::Relaxed);
+        self.in_use.fetch_add(bytes, Ordering::Relaxed);
+        self.update_peak();
+    }
+
+    fn update_peak(&self) {
+        let total = self.in_use.load(Ordering::Relaxed) + self.pooled.load(Ordering::Relaxed);
+        self.peak.fetch_max(total, Ordering::Relaxed);
+    }
+
+    /// Record a buffer of `bytes` coming back, pooled or freed
+    pub fn record_checkin(&self, bytes: usize) {
+        self.in_use
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |current| {
+                Some(current.saturating_sub(bytes))
+            })
+            .ok();
+    }
+
+    /// Remove the front buffer, keeping the pooled byte count in step
+    fn pop_front(&self, buffers: &mut VecDeque<PooledBuffer>) -> Option<PooledBuffer> {
+        let pooled = buffers.pop_front()?;
+        self.pooled
+            .fetch_sub(pooled.data.capacity(), Ordering::Relaxed);
+        Some(pooled)
+    }
+
     /// Try to acquire a buffer from the pool
     pub fn try_acquire(&self) -> Option<Vec<u8>> {
         if let Ok(mut buffers) = self.buffers.try_lock()
-            && let Some(mut pooled) = buffers.pop_front()
+            && let Some(mut pooled) = self.pop_front(&mut buffers)
         {
             pooled.last_used = Instant::now();
             pooled.reuse_count += 1;
@@ -70,19 +136,25 @@ impl BufferPool {
     }
 
     /// Release a buffer back to the pool
-    pub fn release(&self, buffer: Vec<u8>) {
+    ///
+    /// Returns whether the buffer was kept; otherwise it is dropped.
+    pub fn release(&self, buffer: Vec<u8>) -> bool {
         if let Ok(mut buffers) = self.buffers.try_lock() {
             // Only add to pool if we haven't reached max size
             if buffers.len() < self.max_size {
+                self.pooled.fetch_add(buffer.capacity(), Ordering::Relaxed);
                 let pooled = PooledBuffer {
                     data: buffer,
                     last_used: Instant::now(),
                     reuse_count: 0,
                 };
                 buffers.push_back(pooled);
+                // Buffers not handed out by this pool can raise the total
+                self.update_peak();
+                return true;
             }
-            // Otherwise, let the buffer be dropped
         }
+        false
     }
 
     /// Check if we should pool a buffer
@@ -94,11 +166,9 @@ impl BufferPool {
         }
     }
 
-    /// Clear all buffers from the pool
-    pub fn clear(&self) {
-        if let Ok(mut buffers) = self.buffers.try_lock() {
-            buffers.clear();
-        }
+    /// Clear all buffers from the pool, returning the bytes freed
+    pub fn clear(&self) -> usize {
+        self.shrink(usize::MAX)
     }
 
     /// Shrink the pool by removing buffers to free memory
@@ -106,10 +176,10 @@ impl BufferPool {
         if let Ok(mut buffers) = self.buffers.try_lock() {
             let mut freed = 0;
 
-            while !buffers.is_empty() && freed < bytes_to_free {
-                if let Some(pooled) = buffers.pop_front() {
-                    freed += pooled.data.capacity();
-                }
+            while freed < bytes_to_free
+                && let Some(pooled) = self.pop_front(&mut buffers)
+            {
+                freed += pooled.data.capacity();
             }
 
             return freed;
@@ -117,21 +187,25 @@ impl BufferPool {
         0
     }
 
-    /// Evict buffers that haven't been used recently
-    pub fn evict_stale(&self, max_age: Duration) {
+    /// Evict buffers that haven't been used recently, returning the bytes freed
+    pub fn evict_stale(&self, max_age: Duration) -> usize {
+        let mut freed = 0;
         if let Ok(mut buffers) = self.buffers.try_lock() {
             let now = Instant::now();
 
             // Remove stale buffers from the front (oldest)
             while let Some(front) = buffers.front() {
                 if now.duration_since(front.last_used) > max_age {
-                    buffers.pop_front();
+                    if let Some(pooled) = self.pop_front(&mut buffers) {
+                        freed += pooled.data.capacity();
+                    }
                 } else {
                     // Buffers are ordered by last_used, so we can stop here
                     break;
                 }
             }
         }
+        freed
     }
 
     /// Get information about this pool
@@ -151,6 +225,10 @@ impl BufferPool {
             pool_size,
             memory_used,
             total_reuses,
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            bytes_in_use: self.in_use.load(Ordering::Relaxed),
+            peak_bytes: self.peak.load(Ordering::Relaxed),
         }
     }
 }
@@ -210,7 +288,7 @@ mod tests {
         thread::sleep(Duration::from_millis(100));
 
         // Evict buffers older than 50ms
-        pool.evict_stale(Duration::from_millis(50));
+        assert_eq!(pool.evict_stale(Duration::from_millis(50)), 3 * 1024);
 
         // Pool should be empty
         let info = pool.info();
@@ -235,5 +313,24 @@ mod tests {
         // Pool should have fewer buffers
         let info = pool.info();
         assert!(info.pool_size <= 2);
+        assert_eq!(info.memory_used, 4096 - freed);
+    }
+
+    #[test]
+    fn test_pool_usage_counters() {
+        let pool = BufferPool::new(BufferSize::Small, 10);
+
+        pool.record_checkout(4096, false);
+        pool.record_checkout(4096, false);
+        pool.record_checkin(4096);
+        assert!(pool.release(vec![0u8; 4096]));
+        assert!(pool.try_acquire().is_some());
+        pool.record_checkout(4096, true);
+
+        let info = pool.info();
+        assert_eq!((info.hits, info.misses), (1, 2));
+        assert_eq!(info.bytes_in_use, 8192);
+        assert_eq!(info.peak_bytes, 8192);
+        assert!((info.hit_rate() - 1.0 / 3.0).abs() < 1e-9);
     }
 }
@@ -289,6 +289,10 @@ mod tests {
                     pool_size: 5,
                     memory_used: 20 * 1024,
                     total_reuses: 10,
+                    hits: 10,
+                    misses: 5,
+                    bytes_in_use: 8 * 1024,
+                    peak_bytes: 28 * 1024,
                 },
             )],
         };
@@ -8,7 +8,9 @@ pub struct MemoryTracker {
     /// Current memory usage in bytes
     used: AtomicUsize,
     /// Maximum memory limit in bytes
-    limit: usize,
+    limit: AtomicUsize,
+    /// Highest usage seen
+    peak: AtomicUsize,
 }
 
 impl MemoryTracker {
@@ -16,7 +18,8 @@ impl MemoryTracker {
     pub fn new(limit: usize) -> Self {
         Self {
             used: AtomicUsize::new(0),
-            limit,
+            limit: AtomicUsize::new(limit),
+            peak: AtomicUsize::new(0),
         }
     }
 
@@ -27,21 +30,35 @@ impl MemoryTracker {
 
     /// Get memory limit
     pub fn limit(&self) -> usize {
-        self.limit
+        self.limit.load(Ordering::Acquire)
+    }
+
+    /// Change the memory limit
+    ///
+    /// Memory already allocated is kept; allocations fail until usage drops
+    /// below a lowered limit.
+    pub fn set_limit(&self, limit: usize) {
+        self.limit.store(limit, Ordering::Release);
+    }
+
+    /// Get the highest memory usage seen
+    pub fn peak(&self) -> usize {
+        self.peak.load(Ordering::Relaxed)
     }
 
     /// Try to allocate memory, returning error if it would exceed limit
     pub fn try_allocate(&self, size: usize) -> Result<()> {
         // Use a CAS loop for atomic check and update
         let mut current = self.used.load(Ordering::Acquire);
+        let limit = self.limit();
 
         loop {
             let new_used = current + size;
 
             // Check if allocation would exceed limit
-            if new_used > self.limit {
+            if new_used > limit {
                 return Err(Error::Internal(InternalError::memory_limit_exceeded(
-                    self.limit, new_used,
+                    limit, new_used,
                 )));
             }
 
@@ -52,7 +69,10 @@ impl MemoryTracker {
                 Ordering::AcqRel,
                 Ordering::Acquire,
             ) {
-                Ok(_) => return Ok(()),
+                Ok(_) => {
+                    self.peak.fetch_max(new_used, Ordering::Relaxed);
+                    return Ok(());
+                }
                 Err(actual) => {
                     // Someone else modified it, retry with new value
                     current = actual;
@@ -79,7 +99,7 @@ impl MemoryTracker {
 
     /// Get memory usage as a percentage of the limit
     pub fn usage_percent(&self) -> f64 {
-        (self.used() as f64 / self.limit as f64) * 100.0
+        (self.used() as f64 / self.limit() as f64) * 100.0
     }
 
     /// Check if memory usage is above a threshold percentage
@@ -174,6 +194,24 @@ mod tests {
         assert!(tracker.is_above_threshold(40.0));
     }
 
+    #[test]
+    fn test_limit_change_and_peak() {
+        let tracker = MemoryTracker::new(1000);
+
+        tracker.try_allocate(800).unwrap();
+        tracker.deallocate(500);
+        assert_eq!(tracker.peak(), 800);
+
+        // A lowered limit below current usage blocks new allocations only
+        tracker.set_limit(200);
+        assert!(tracker.try_allocate(1).is_err());
+        assert_eq!(tracker.used(), 300);
+
+        tracker.set_limit(2000);
+        tracker.try_allocate(1500).unwrap();
+        assert_eq!(tracker.peak(), 1800);
+    }
+
     #[test]
     fn test_saturating_deallocation() {
         let tracker = MemoryTracker::new(1000);
@@ -0,0 +1,362 @@
+//! Processing metrics
+//!
+//! Every file result carries [`StageTimings`] saying where its time went:
+//! opening, waiting on the disk, waiting for a hashing slot, hashing, or
+//! looking the file up in the cache. A [`FileProcessor`](crate::FileProcessor)
+//! also folds each result into client-wide [`ProcessingMetrics`], counters
+//! and latency histograms made of plain atomics, so recording never takes a
+//! lock and a snapshot can be scraped as often as monitoring wants.
+
+use crate::hashing::HashAlgorithm;
+use crate::platform::IoStrategy;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::time::Duration;
+
+/// Time spent in each stage of processing one file
+///
+/// Stages that did not run are zero: a file answered from the cache has
+/// only a cache lookup, and a partial rehash reports its reads as hashing.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct StageTimings {
+    /// Opening the file for reading
+    pub open: Duration,
+    /// Waiting for data from the disk
+    pub read: Duration,
+    /// Waiting for a slot in the shared CPU pool or for hashing workers to
+    /// take the previous chunk
+    pub pool_wait: Duration,
+    /// Hashing, wall clock for all algorithms together
+    pub hash: Duration,
+    /// Time each algorithm spent hashing; algorithms hashed in parallel
+    /// overlap, so these may add up to more than `hash`
+    pub hash_by_algorithm: HashMap<HashAlgorithm, Duration>,
+    /// Stat'ing the file and looking it up in the hash cache
+    pub cache_lookup: Duration,
+}
+
+/// Number of buckets in a [`Histogram`]
+pub const HISTOGRAM_BUCKETS: usize = 16;
+
+/// Upper bound of histogram bucket `index` in microseconds
+///
+/// Bounds grow by a factor of four from 1 µs, so the buckets span a
+/// microsecond to about four and a half minutes; the last bucket takes
+/// everything longer and has no bound.
+pub const fn histogram_bucket_bound_us(index: usize) -> Option<u64> {
+    if index + 1 >= HISTOGRAM_BUCKETS {
+        None
+    } else {
+        Some(1 << (2 * index))
+    }
+}
+
+/// Lock-free latency histogram with power-of-four buckets
+#[derive(Debug)]
+pub struct Histogram {
+    buckets: [AtomicU64; HISTOGRAM_BUCKETS],
+    count: AtomicU64,
+    sum_us: AtomicU64,
+}
+
+impl Default for Histogram {
+    fn default() -> Self {
+        Self {
+            buckets: std::array::from_fn(|_| AtomicU64::new(0)),
+            count: AtomicU64::new(0),
+            sum_us: AtomicU64::new(0),
+        }
+    }
+}
+
+impl Histogram {
+    /// Count one sample
+    pub fn record(&self, duration: Duration) {
+        let us = u64::try_from(duration.as_micros()).unwrap_or(u64::MAX);
+        self.buckets[Self::bucket(us)].fetch_add(1, Ordering::Relaxed);
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.sum_us.fetch_add(us, Ordering::Relaxed);
+    }
+
+    /// Index of the first bucket whose bound is at least `us`
+    fn bucket(us: u64) -> usize {
+        if us <= 1 {
+            return 0;
+        }
+        // ceil(log4(us)) from the bit length of us - 1
+        let bits = (u64::BITS - (us - 1).leading_zeros()) as usize;
+        bits.div_ceil(2).min(HISTOGRAM_BUCKETS - 1)
+    }
+
+    /// Current counts
+    ///
+    /// Samples recorded while the snapshot is taken may be counted in some
+    /// fields and not yet in others.
+    pub fn snapshot(&self) -> HistogramSnapshot {
+        HistogramSnapshot {
+            count: self.count.load(Ordering::Relaxed),
+            sum_us: self.sum_us.load(Ordering::Relaxed),
+            buckets: std::array::from_fn(|i| self.buckets[i].load(Ordering::Relaxed)),
+        }
+    }
+}
+
+/// Counts of a [`Histogram`] at one point in time
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct HistogramSnapshot {
+    /// Number of samples
+    pub count: u64,
+    /// Sum of all samples in microseconds
+    pub sum_us: u64,
+    /// Samples per bucket, not cumulative
+    pub buckets: [u64; HISTOGRAM_BUCKETS],
+}
+
+/// Client-wide counters of file processing
+#[derive(Debug, Default)]
+pub struct ProcessingMetrics {
+    files_processed: AtomicU64,
+    files_failed: AtomicU64,
+    bytes_read: AtomicU64,
+    cache_hits: AtomicU64,
+    cache_misses: AtomicU64,
+    in_flight: AtomicUsize,
+    queued: AtomicUsize,
+    read_buffered: AtomicU64,
+    read_mapped: AtomicU64,
+    read_direct: AtomicU64,
+    read_io_uring: AtomicU64,
+    /// Bytes per read step of the file started last, zero before any
+    read_size: AtomicUsize,
+    /// Whole file, from the start of processing to its result
+    pub total: Histogram,
+    pub open: Histogram,
+    pub read: Histogram,
+    pub pool_wait: Histogram,
+    pub hash: Histogram,
+    pub cache_lookup: Histogram,
+}
+
+impl ProcessingMetrics {
+    /// Count a file as being processed until the guard is dropped
+    pub fn start_file(&self) -> InFlightGuard<'_> {
+        self.in_flight.fetch_add(1, Ordering::Relaxed);
+        InFlightGuard(self)
+    }
+
+    /// Record the bytes read per pipeline step by a file being hashed
+    pub fn record_read_size(&self, bytes: usize) {
+        self.read_size.store(bytes, Ordering::Relaxed);
+    }
+
+    /// Bytes read per pipeline step by the file started last, if any
+    pub fn last_read_size(&self) -> Option<usize> {
+        match self.read_size.load(Ordering::Relaxed) {
+            0 => None,
+            bytes => Some(bytes),
+        }
+    }
+
+    /// Record a processed file
+    ///
+    /// Stages that did not run are left out of their histograms, so files
+    /// answered from the cache do not drag down read and hash latencies.
+    pub fn record_completed(&self, total: Duration, timings: &StageTimings) {
+        self.files_processed.fetch_add(1, Ordering::Relaxed);
+        self.total.record(total);
+        for (histogram, time) in [
+            (&self.open, timings.open),
+            (&self.read, timings.read),
+            (&self.pool_wait, timings.pool_wait),
+            (&self.hash, timings.hash),
+            (&self.cache_lookup, timings.cache_lookup),
+        ] {
+            if !time.is_zero() {
+                histogram.record(time);
+            }
+        }
+    }
+
+    /// Record a file that could not be processed
+    pub fn record_failed(&self, total: Duration) {
+        self.files_failed.fetch_add(1, Ordering::Relaxed);
+        self.total.record(total);
+    }
+
+    /// Count bytes read from disk
+    pub fn add_bytes_read(&self, bytes: u64) {
+        self.bytes_read.fetch_add(bytes, Ordering::Relaxed);
+    }
+
+    /// Count a file read from disk with `strategy`, after any fallback
+    pub fn record_read_strategy(&self, strategy: IoStrategy) {
+        let counter = match strategy {
+            IoStrategy::AsyncBuffered | IoStrategy::Overlapped => &self.read_buffered,
+            IoStrategy::MemoryMapped => &self.read_mapped,
+            IoStrategy::DirectIo => &self.read_direct,
+            IoStrategy::IoUring => &self.read_io_uring,
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Count a cache lookup; only lookups that answered every requested
+    /// algorithm are hits
+    pub fn record_cache_lookup(&self, hit: bool) {
+        let counter = if hit {
+            &self.cache_hits
+        } else {
+            &self.cache_misses
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Count files waiting in a batch queue
+    pub fn add_queued(&self, files: usize) {
+        self.queued.fetch_add(files, Ordering::Relaxed);
+    }
+
+    /// Take a file off a batch queue
+    pub fn dequeue(&self) {
+        // Never wraps, even if a caller dequeues more than it queued
+        let _ = self
+            .queued
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |n| n.checked_sub(1));
+    }
+
+    /// Current values
+    pub fn snapshot(&self) -> ProcessingMetricsSnapshot {
+        ProcessingMetricsSnapshot {
+            files_processed: self.files_processed.load(Ordering::Relaxed),
+            files_failed: self.files_failed.load(Ordering::Relaxed),
+            bytes_read: self.bytes_read.load(Ordering::Relaxed),
+            cache_hits: self.cache_hits.load(Ordering::Relaxed),
+            cache_misses: self.cache_misses.load(Ordering::Relaxed),
+            in_flight: self.in_flight.load(Ordering::Relaxed),
+            queued: self.queued.load(Ordering::Relaxed),
+            files_read_buffered: self.read_buffered.load(Ordering::Relaxed),
+            files_read_mapped: self.read_mapped.load(Ordering::Relaxed),
+            files_read_direct: self.read_direct.load(Ordering::Relaxed),
+            files_read_io_uring: self.read_io_uring.load(Ordering::Relaxed),
+            total: self.total.snapshot(),
+            open: self.open.snapshot(),
+            read: self.read.snapshot(),
+            pool_wait: self.pool_wait.snapshot(),
+            hash: self.hash.snapshot(),
+            cache_lookup: self.cache_lookup.snapshot(),
+        }
+    }
+}
+
+/// Keeps a file counted as in flight, see [`ProcessingMetrics::start_file`]
+pub struct InFlightGuard<'a>(&'a ProcessingMetrics);
+
+impl Drop for InFlightGuard<'_> {
+    fn drop(&mut self) {
+        self.0.in_flight.fetch_sub(1, Ordering::Relaxed);
+    }
+}
+
+/// [`ProcessingMetrics`] at one point in time
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct ProcessingMetricsSnapshot {
+    pub files_processed: u64,
+    pub files_failed: u64,
+    pub bytes_read: u64,
+    pub cache_hits: u64,
+    pub cache_misses: u64,
+    /// Files being processed right now
+    pub in_flight: usize,
+    /// Files of running batches not started yet
+    pub queued: usize,
+    /// Files read per I/O backend, after any fallback
+    pub files_read_buffered: u64,
+    pub files_read_mapped: u64,
+    pub files_read_direct: u64,
+    pub files_read_io_uring: u64,
+    pub total: HistogramSnapshot,
+    pub open: HistogramSnapshot,
+    pub read: HistogramSnapshot,
+    pub pool_wait: HistogramSnapshot,
+    pub hash: HistogramSnapshot,
+    pub cache_lookup: HistogramSnapshot,
+}
+
+impl ProcessingMetricsSnapshot {
+    /// Share of cache lookups that answered every algorithm, 0 without any
+    pub fn cache_hit_ratio(&self) -> f64 {
+        let lookups = self.cache_hits + self.cache_misses;
+        if lookups == 0 {
+            0.0
+        } else {
+            self.cache_hits as f64 / lookups as f64
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_histogram_buckets() {
+        let histogram = Histogram::default();
+        for us in [0, 1, 2, 4, 5, 16, 1_000, u64::MAX / 1_000] {
+            histogram.record(Duration::from_micros(us));
+        }
+        let snapshot = histogram.snapshot();
+
+        assert_eq!(snapshot.count, 8);
+        // 0 and 1 µs, then 2 and 4 µs share the bound 4
+        assert_eq!(snapshot.buckets[0], 2);
+        assert_eq!(snapshot.buckets[1], 2);
+        // 5 and 16 µs
+        assert_eq!(snapshot.buckets[2], 2);
+        // 1 ms lands under 1024 µs
+        assert_eq!(snapshot.buckets[5], 1);
+        assert_eq!(snapshot.buckets[HISTOGRAM_BUCKETS - 1], 1);
+
+        assert_eq!(histogram_bucket_bound_us(5), Some(1024));
+        assert_eq!(histogram_bucket_bound_us(HISTOGRAM_BUCKETS - 1), None);
+    }
+
+    #[test]
+    fn test_processing_metrics() {
+        let metrics = ProcessingMetrics::default();
+        {
+            let _guard = metrics.start_file();
+            assert_eq!(metrics.snapshot().in_flight, 1);
+        }
+
+        let timings = StageTimings {
+            read: Duration::from_millis(3),
+            hash: Duration::from_millis(5),
+            ..Default::default()
+        };
+        metrics.record_completed(Duration::from_millis(10), &timings);
+        metrics.record_failed(Duration::from_millis(1));
+        metrics.record_cache_lookup(true);
+        metrics.record_cache_lookup(false);
+        metrics.record_cache_lookup(false);
+        metrics.add_bytes_read(4096);
+        metrics.record_read_strategy(IoStrategy::IoUring);
+        metrics.record_read_strategy(IoStrategy::AsyncBuffered);
+        metrics.add_queued(2);
+        metrics.dequeue();
+        metrics.dequeue();
+        metrics.dequeue();
+
+        let snapshot = metrics.snapshot();
+        assert_eq!(snapshot.in_flight, 0);
+        assert_eq!(snapshot.queued, 0);
+        assert_eq!(snapshot.files_processed, 1);
+        assert_eq!(snapshot.files_failed, 1);
+        assert_eq!(snapshot.bytes_read, 4096);
+        assert_eq!(snapshot.files_read_io_uring, 1);
+        assert_eq!(snapshot.files_read_buffered, 1);
+        assert_eq!(snapshot.files_read_direct, 0);
+        assert_eq!(snapshot.total.count, 2);
+        assert_eq!(snapshot.hash.count, 1);
+        assert_eq!(snapshot.hash.sum_us, 5_000);
+        assert!((snapshot.cache_hit_ratio() - 1.0 / 3.0).abs() < 1e-9);
+    }
+}
@@ -5,8 +5,10 @@
 
 use super::ProcessingStage;
 use crate::Result;
+use crate::scheduler::CpuPool;
 use async_trait::async_trait;
 use std::fmt::Debug;
+use std::sync::Arc;
 
 /// A stage that conditionally applies another stage based on a predicate
 pub struct ConditionalStage<P>
@@ -68,6 +70,10 @@ where
     fn name(&self) -> &str {
         &self.name
     }
+
+    fn set_cpu_pool(&mut self, pool: Arc<CpuPool>) {
+        self.inner.set_cpu_pool(pool);
+    }
 }
 
 /// A stage that applies multiple stages in parallel
@@ -114,6 +120,12 @@ impl ProcessingStage for ParallelStage {
     fn name(&self) -> &str {
         &self.name
     }
+
+    fn set_cpu_pool(&mut self, pool: Arc<CpuPool>) {
+        for stage in &mut self.stages {
+            stage.set_cpu_pool(pool.clone());
+        }
+    }
 }
 
 /// A stage that transforms data before passing it to another stage
@@ -173,6 +185,10 @@ where
     fn name(&self) -> &str {
         &self.name
     }
+
+    fn set_cpu_pool(&mut self, pool: Arc<CpuPool>) {
+        self.inner.set_cpu_pool(pool);
+    }
 }
 
 /// A stage that buffers chunks until a certain size is reached
@@ -229,6 +245,10 @@ impl ProcessingStage for BufferingStage {
     fn name(&self) -> &str {
         &self.name
     }
+
+    fn set_cpu_pool(&mut self, pool: Arc<CpuPool>) {
+        self.inner.set_cpu_pool(pool);
+    }
 }
 
 /// A stage that rate-limits processing
@@ -284,6 +304,10 @@ impl ProcessingStage for RateLimitedStage {
     fn name(&self) -> &str {
         &self.name
     }
+
+    fn set_cpu_pool(&mut self, pool: Arc<CpuPool>) {
+        self.inner.set_cpu_pool(pool);
+    }
 }
 
 /// Extension trait for composing stages
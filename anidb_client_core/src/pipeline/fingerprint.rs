@@ -0,0 +1,80 @@
+//! Fingerprint stage for the streaming pipeline
+//!
+//! This stage builds the quick fingerprint of a file while it is fully
+//! hashed, so the cache can index it without sampling the file again.
+
+use super::ProcessingStage;
+use crate::Result;
+use crate::hashing::{FingerprintSampler, QuickFingerprint};
+use async_trait::async_trait;
+
+/// Stage that computes the quick fingerprint of the streamed data
+#[derive(Debug, Default)]
+pub struct FingerprintStage {
+    sampler: Option<FingerprintSampler>,
+    result: Option<QuickFingerprint>,
+}
+
+impl FingerprintStage {
+    /// Create a new fingerprint stage
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Get the fingerprint, available after finalization
+    pub fn fingerprint(&self) -> Option<QuickFingerprint> {
+        self.result
+    }
+}
+
+#[async_trait]
+impl ProcessingStage for FingerprintStage {
+    async fn process(&mut self, chunk: &[u8]) -> Result<()> {
+        if let Some(sampler) = &mut self.sampler {
+            sampler.update(chunk);
+        }
+        Ok(())
+    }
+
+    async fn initialize(&mut self, total_size: u64) -> Result<()> {
+        self.sampler = Some(FingerprintSampler::new(total_size));
+        self.result = None;
+        Ok(())
+    }
+
+    async fn finalize(&mut self) -> Result<()> {
+        self.result = self.sampler.take().map(|sampler| sampler.finish());
+        Ok(())
+    }
+
+    fn name(&self) -> &str {
+        "FingerprintStage"
+    }
+
+    fn as_any_mut(&mut self) -> Option<&mut dyn std::any::Any> {
+        Some(self)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[tokio::test]
+    async fn test_fingerprint_stage_matches_direct_fingerprint() {
+        let data: Vec<u8> = (0..2_000_000u32).map(|i| (i % 253) as u8).collect();
+        let mut stage = FingerprintStage::new();
+
+        stage.initialize(data.len() as u64).await.unwrap();
+        for chunk in data.chunks(64 * 1024) {
+            stage.process(chunk).await.unwrap();
+        }
+        assert!(stage.fingerprint().is_none());
+        stage.finalize().await.unwrap();
+
+        assert_eq!(
+            stage.fingerprint(),
+            Some(QuickFingerprint::from_bytes(&data))
+        );
+    }
+}
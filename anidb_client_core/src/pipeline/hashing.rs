@@ -1,16 +1,31 @@
 //! Hashing stage for the streaming pipeline
 //!
 //! This stage calculates hashes for data chunks as they flow through the pipeline.
+//!
+//! ED2K hashes every 9.5MB chunk on its own, so for large files the stage
+//! can hand whole chunks to blocking tasks and hash several at once, as
+//! [`ChunkParallelStrategy`] does outside the pipeline.
+//!
+//! [`ChunkParallelStrategy`]: crate::hashing::ChunkParallelStrategy
 
 use super::ProcessingStage;
-use crate::Result;
-use crate::hashing::{HashAlgorithm, HashAlgorithmExt, StreamingHasher};
+use crate::hashing::{
+    ED2K_CHUNK_SIZE, Ed2kVariant, HashAlgorithm, HashAlgorithmExt, StreamingHasher, ed2k_root_hash,
+};
 use crate::progress::{ProgressProvider, ProgressUpdate};
+use crate::scheduler::{CpuPool, Priority};
+use crate::{Error, Result, error::InternalError};
 use async_trait::async_trait;
+use md4::{Digest, Md4};
 use std::collections::HashMap;
 use std::fmt;
 use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
 use tokio::sync::mpsc;
+use tokio::task::{JoinError, JoinSet};
+
+/// Chunks queued for each parallel hashing worker unless configured
+pub const DEFAULT_QUEUE_DEPTH: usize = 2;
 
 /// Wrapper for StreamingHasher to make it Sync
 struct HasherWrapper {
@@ -25,7 +40,11 @@ impl std::fmt::Debug for HasherWrapper {
 
 /// Stage that calculates hashes for streaming data
 pub struct HashingStage {
+    /// Algorithms requested, in order
+    algorithms: Vec<HashAlgorithm>,
     /// Map of algorithm to its streaming hasher (wrapped for thread-safety)
+    ///
+    /// Leaves out ED2K while its chunks are fanned out.
     hashers: Arc<HashMap<HashAlgorithm, HasherWrapper>>,
     /// Hash results after finalization
     results: Arc<Mutex<Option<HashMap<HashAlgorithm, String>>>>,
@@ -37,6 +56,21 @@ pub struct HashingStage {
     bytes_processed: u64,
     /// Optional parallel workers for multi-algorithm acceleration
     parallel: Option<ParallelState>,
+    /// Time each algorithm spent hashing the current file
+    algorithm_times: HashMap<HashAlgorithm, Duration>,
+    /// Time spent waiting for parallel workers to take a chunk
+    backpressure: Duration,
+    /// Time spent waiting for a CPU slot to hash sequentially
+    slot_wait: Duration,
+    /// Chunks each parallel worker may have queued
+    queue_depth: usize,
+    /// Pool every chunk update takes a slot from, if any
+    cpu_pool: Option<Arc<CpuPool>>,
+    /// ED2K chunks hashed at once for files of several chunks; one keeps
+    /// ED2K with the other hashers
+    ed2k_workers: usize,
+    /// ED2K chunks of the current file on their way through the workers
+    ed2k_fan_out: Option<Ed2kFanOut>,
 }
 
 impl HashingStage {
@@ -55,13 +89,28 @@ impl HashingStage {
             );
         }
 
+        let mut unique = Vec::new();
+        for &algorithm in algorithms {
+            if !unique.contains(&algorithm) {
+                unique.push(algorithm);
+            }
+        }
+
         Self {
+            algorithms: unique,
             hashers: Arc::new(hashers),
             results: Arc::new(Mutex::new(None)),
             progress: None,
             total_size: 0,
             bytes_processed: 0,
             parallel: None,
+            algorithm_times: HashMap::new(),
+            backpressure: Duration::ZERO,
+            slot_wait: Duration::ZERO,
+            queue_depth: DEFAULT_QUEUE_DEPTH,
+            cpu_pool: None,
+            ed2k_workers: 1,
+            ed2k_fan_out: None,
         }
     }
 
@@ -75,6 +124,30 @@ impl HashingStage {
         stage
     }
 
+    /// Let each parallel worker queue up to `depth` chunks
+    ///
+    /// Deeper queues let the reader run ahead of slower algorithms at the
+    /// cost of one shared chunk buffer per queued chunk.
+    pub fn with_queue_depth(mut self, depth: usize) -> Self {
+        self.queue_depth = depth.max(1);
+        self
+    }
+
+    /// Take a slot from `pool` for every chunk hashed by every algorithm
+    pub fn with_cpu_pool(mut self, pool: Arc<CpuPool>) -> Self {
+        self.cpu_pool = Some(pool);
+        self
+    }
+
+    /// Hash up to `workers` ED2K chunks of a file at once
+    ///
+    /// Applies to files of more than one ED2K chunk. Each chunk is copied
+    /// out of the pipeline's buffer, so up to `workers` chunks are held.
+    pub fn with_ed2k_workers(mut self, workers: usize) -> Self {
+        self.ed2k_workers = workers.max(1);
+        self
+    }
+
     /// Set a progress provider for this stage
     pub fn set_progress_provider(&mut self, provider: Option<Arc<dyn ProgressProvider>>) {
         self.progress = provider;
@@ -89,15 +162,14 @@ impl HashingStage {
     fn emit_progress(&self) {
         if let Some(provider) = &self.progress {
             provider.report(ProgressUpdate::HashProgress {
-                algorithm: if self.hashers.len() == 1 {
+                algorithm: if self.algorithms.len() == 1 {
                     // Single algorithm name for clarity
-                    self.hashers
-                        .keys()
-                        .next()
+                    self.algorithms
+                        .first()
                         .map(|a| format!("{a:?}"))
                         .unwrap_or_else(|| "Hash".to_string())
                 } else {
-                    format!("Multiple ({} algorithms)", self.hashers.len())
+                    format!("Multiple ({} algorithms)", self.algorithms.len())
                 },
                 bytes_processed: self.bytes_processed,
                 total_bytes: self.total_size,
@@ -114,11 +186,14 @@ impl HashingStage {
 
         let mut txs = HashMap::new();
         let mut handles = Vec::new();
+        // Workers are not tasks and do not see the file's priority
+        let priority = Priority::current();
 
         for (&algorithm, _) in self.hashers.iter() {
             // Bounded queue to enforce backpressure and keep progress accurate
-            let (tx, mut rx) = mpsc::channel::<ChunkMsg>(2);
+            let (tx, mut rx) = mpsc::channel::<ChunkMsg>(self.queue_depth);
             txs.insert(algorithm, tx);
+            let pool = self.cpu_pool.clone();
 
             // Spawn OS thread worker similar to parallel strategy
             let handle = std::thread::spawn(move || {
@@ -130,18 +205,27 @@ impl HashingStage {
                     .build()
                     .unwrap();
 
+                let mut busy = Duration::ZERO;
                 loop {
                     let msg = _rt.block_on(rx.recv());
                     match msg {
                         Some(ChunkMsg::Data(buf)) => {
+                            // Each worker holds a slot only while it hashes
+                            let _permit = pool
+                                .as_ref()
+                                .map(|pool| _rt.block_on(pool.acquire_at(priority)));
+                            let start = Instant::now();
                             hasher.update(&buf);
+                            busy += start.elapsed();
                         }
                         Some(ChunkMsg::End) => break,
                         None => break,
                     }
                 }
 
-                (algorithm, hasher.finalize())
+                let start = Instant::now();
+                let hash = hasher.finalize();
+                (algorithm, hash, busy + start.elapsed())
             });
 
             handles.push(handle);
@@ -172,13 +256,30 @@ impl HashingStage {
     pub fn take_results(&mut self) -> Option<HashMap<HashAlgorithm, String>> {
         self.results.lock().unwrap().take()
     }
+
+    /// Time each algorithm spent hashing the last file
+    pub fn algorithm_times(&self) -> &HashMap<HashAlgorithm, Duration> {
+        &self.algorithm_times
+    }
+
+    /// Time the last file spent waiting for parallel workers to free a slot
+    /// in their queues
+    pub fn backpressure_wait(&self) -> Duration {
+        self.backpressure
+    }
+
+    /// Time the last file spent waiting for a CPU slot outside the workers,
+    /// whose waits show up as backpressure
+    pub fn slot_wait(&self) -> Duration {
+        self.slot_wait
+    }
 }
 
 impl fmt::Debug for HashingStage {
     fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
         let has_results = self.results.lock().map(|r| r.is_some()).unwrap_or(false);
         f.debug_struct("HashingStage")
-            .field("algorithms", &self.hashers.keys().collect::<Vec<_>>())
+            .field("algorithms", &self.algorithms)
             .field("has_results", &has_results)
             .field("has_progress", &self.progress.is_some())
             .field("total_size", &self.total_size)
@@ -195,28 +296,159 @@ enum ChunkMsg {
 
 struct ParallelState {
     txs: HashMap<HashAlgorithm, mpsc::Sender<ChunkMsg>>,
-    handles: Vec<std::thread::JoinHandle<(HashAlgorithm, String)>>,
+    handles: Vec<std::thread::JoinHandle<(HashAlgorithm, String, Duration)>>,
+}
+
+/// ED2K chunks of one file hashed on blocking tasks
+struct Ed2kFanOut {
+    /// The chunk being filled from the pipeline's reads
+    filling: Vec<u8>,
+    /// MD4 of every chunk, in file order
+    digests: Vec<[u8; 16]>,
+    tasks: JoinSet<(usize, [u8; 16], Duration)>,
+    workers: usize,
+    bytes: u64,
+    /// Time the tasks spent hashing
+    busy: Duration,
+}
+
+impl Ed2kFanOut {
+    fn new(workers: usize) -> Self {
+        Self {
+            filling: Vec::with_capacity(ED2K_CHUNK_SIZE as usize),
+            digests: Vec::new(),
+            tasks: JoinSet::new(),
+            workers,
+            bytes: 0,
+            busy: Duration::ZERO,
+        }
+    }
+
+    /// Cut `data` into ED2K chunks, hashing each one as it completes
+    ///
+    /// Returns the time spent waiting for a task to finish and for a slot.
+    async fn push(
+        &mut self,
+        mut data: &[u8],
+        pool: Option<&Arc<CpuPool>>,
+    ) -> Result<(Duration, Duration)> {
+        let mut waits = (Duration::ZERO, Duration::ZERO);
+        self.bytes += data.len() as u64;
+        while !data.is_empty() {
+            let take = (ED2K_CHUNK_SIZE as usize - self.filling.len()).min(data.len());
+            self.filling.extend_from_slice(&data[..take]);
+            data = &data[take..];
+            if self.filling.len() == ED2K_CHUNK_SIZE as usize {
+                let (tasks, slot) = self.spawn(pool).await?;
+                waits.0 += tasks;
+                waits.1 += slot;
+            }
+        }
+        Ok(waits)
+    }
+
+    /// Hash the filled chunk once a task and a slot are free
+    async fn spawn(&mut self, pool: Option<&Arc<CpuPool>>) -> Result<(Duration, Duration)> {
+        let chunk = std::mem::replace(
+            &mut self.filling,
+            Vec::with_capacity(ED2K_CHUNK_SIZE as usize),
+        );
+        let index = self.digests.len();
+        self.digests.push([0; 16]);
+
+        let start = Instant::now();
+        while self.tasks.len() >= self.workers {
+            if let Some(joined) = self.tasks.join_next().await {
+                self.store(joined)?;
+            }
+        }
+        let tasks_wait = start.elapsed();
+
+        let start = Instant::now();
+        let permit = match pool {
+            Some(pool) => Some(pool.acquire().await),
+            None => None,
+        };
+        let slot_wait = start.elapsed();
+
+        self.tasks.spawn_blocking(move || {
+            let _permit = permit;
+            let start = Instant::now();
+            let digest: [u8; 16] = Md4::digest(&chunk).into();
+            (index, digest, start.elapsed())
+        });
+        Ok((tasks_wait, slot_wait))
+    }
+
+    fn store(
+        &mut self,
+        joined: std::result::Result<(usize, [u8; 16], Duration), JoinError>,
+    ) -> Result<()> {
+        let (index, digest, busy) = joined.map_err(|e| {
+            Error::Internal(InternalError::hash_calculation(
+                "HashingStage",
+                &format!("ED2K chunk task failed: {e}"),
+            ))
+        })?;
+        self.digests[index] = digest;
+        self.busy += busy;
+        Ok(())
+    }
+
+    /// Hash the last partial chunk and combine every digest
+    ///
+    /// Returns the ED2K hash and the time spent hashing.
+    async fn finish(mut self, pool: Option<&Arc<CpuPool>>) -> Result<(String, Duration)> {
+        if !self.filling.is_empty() {
+            self.spawn(pool).await?;
+        }
+        while let Some(joined) = self.tasks.join_next().await {
+            self.store(joined)?;
+        }
+
+        // Same variant as the streaming ED2K hasher
+        let start = Instant::now();
+        let hash = ed2k_root_hash(self.digests.concat(), self.bytes, Ed2kVariant::Red);
+        Ok((hash, self.busy + start.elapsed()))
+    }
 }
 
 #[async_trait]
 impl ProcessingStage for HashingStage {
     async fn process(&mut self, chunk: &[u8]) -> Result<()> {
-        if let Some(p) = &mut self.parallel {
+        if self.hashers.is_empty() {
+            // Only fanned out ED2K chunks to hash
+        } else if let Some(p) = &mut self.parallel {
             // Broadcast chunk to workers using shared buffer
             let shared = Arc::new(chunk.to_vec());
             for tx in p.txs.values_mut() {
                 // Try non-blocking; on full queue, await to apply backpressure
                 if tx.try_send(ChunkMsg::Data(shared.clone())).is_err() {
+                    let start = Instant::now();
                     let _ = tx.send(ChunkMsg::Data(shared.clone())).await;
+                    self.backpressure += start.elapsed();
                 }
             }
         } else {
-            // Sequential update of all hashers
-            for wrapper in self.hashers.values() {
+            // Sequential update of all hashers under one slot
+            let wait_start = Instant::now();
+            let _permit = match &self.cpu_pool {
+                Some(pool) => Some(pool.acquire().await),
+                None => None,
+            };
+            self.slot_wait += wait_start.elapsed();
+            for (&algorithm, wrapper) in self.hashers.iter() {
+                let start = Instant::now();
                 let mut hasher = wrapper.hasher.lock().unwrap();
                 hasher.update(chunk);
+                *self.algorithm_times.entry(algorithm).or_default() += start.elapsed();
             }
         }
+        if let Some(fan_out) = &mut self.ed2k_fan_out {
+            let (tasks_wait, slot_wait) = fan_out.push(chunk, self.cpu_pool.as_ref()).await?;
+            self.backpressure += tasks_wait;
+            self.slot_wait += slot_wait;
+        }
         // Update and emit progress
         self.bytes_processed += chunk.len() as u64;
         self.emit_progress();
@@ -224,9 +456,18 @@ impl ProcessingStage for HashingStage {
     }
 
     async fn initialize(&mut self, _total_size: u64) -> Result<()> {
+        // Files of several ED2K chunks fan them out when workers are allowed
+        let fan_out = self.ed2k_workers > 1
+            && self.algorithms.contains(&HashAlgorithm::ED2K)
+            && _total_size > ED2K_CHUNK_SIZE;
+        self.ed2k_fan_out = fan_out.then(|| Ed2kFanOut::new(self.ed2k_workers));
+
         // Reset all hashers by recreating them
         let mut new_hashers = HashMap::new();
-        for (&algorithm, _) in self.hashers.iter() {
+        for &algorithm in &self.algorithms {
+            if fan_out && algorithm == HashAlgorithm::ED2K {
+                continue;
+            }
             let impl_arc = algorithm.to_impl();
             let hasher = impl_arc.create_hasher();
             new_hashers.insert(
@@ -238,6 +479,9 @@ impl ProcessingStage for HashingStage {
         }
         self.hashers = Arc::new(new_hashers);
         *self.results.lock().unwrap() = None;
+        self.algorithm_times.clear();
+        self.backpressure = Duration::ZERO;
+        self.slot_wait = Duration::ZERO;
         // Capture total size and emit initial progress
         self.total_size = _total_size;
         self.bytes_processed = 0;
@@ -250,6 +494,12 @@ impl ProcessingStage for HashingStage {
     async fn finalize(&mut self) -> Result<()> {
         let mut results = HashMap::new();
 
+        if let Some(fan_out) = self.ed2k_fan_out.take() {
+            let (hash, busy) = fan_out.finish(self.cpu_pool.as_ref()).await?;
+            results.insert(HashAlgorithm::ED2K, hash);
+            self.algorithm_times.insert(HashAlgorithm::ED2K, busy);
+        }
+
         if let Some(mut p) = self.parallel.take() {
             // Signal end to all workers
             for tx in p.txs.values_mut() {
@@ -257,8 +507,9 @@ impl ProcessingStage for HashingStage {
             }
             // Join workers and collect results
             for handle in p.handles.drain(..) {
-                if let Ok((algo, hash)) = handle.join() {
+                if let Ok((algo, hash, busy)) = handle.join() {
                     results.insert(algo, hash);
+                    self.algorithm_times.insert(algo, busy);
                 }
             }
         } else {
@@ -276,7 +527,9 @@ impl ProcessingStage for HashingStage {
                 };
 
                 // Finalize the old hasher
+                let start = Instant::now();
                 let hash = hasher.finalize();
+                *self.algorithm_times.entry(algorithm).or_default() += start.elapsed();
                 results.insert(algorithm, hash);
 
                 // Create a fresh hasher for future use
@@ -302,6 +555,10 @@ impl ProcessingStage for HashingStage {
         "HashingStage"
     }
 
+    fn set_cpu_pool(&mut self, pool: Arc<CpuPool>) {
+        self.cpu_pool = Some(pool);
+    }
+
     fn as_any_mut(&mut self) -> Option<&mut dyn std::any::Any> {
         Some(self)
     }
@@ -389,6 +646,73 @@ mod tests {
         assert_eq!(results.len(), 2);
         assert!(results.contains_key(&HashAlgorithm::CRC32));
         assert!(results.contains_key(&HashAlgorithm::MD5));
+
+        // Every algorithm reports its own hashing time
+        assert_eq!(stage.algorithm_times().len(), 2);
+    }
+
+    // Finalizing joins the workers, blocking one runtime thread
+    #[tokio::test(flavor = "multi_thread", worker_threads = 2)]
+    async fn test_parallel_workers_take_cpu_slots() {
+        let pool = Arc::new(CpuPool::new(1));
+        let held = pool.acquire().await;
+        let mut stage = HashingStage::new(&[HashAlgorithm::CRC32, HashAlgorithm::MD5])
+            .with_cpu_pool(pool.clone());
+
+        stage.initialize(5).await.unwrap();
+        stage.process(b"Hello").await.unwrap();
+        let finish = tokio::spawn(async move {
+            stage.finalize().await.unwrap();
+            stage
+        });
+
+        // No worker may hash while the only slot is taken
+        tokio::time::sleep(Duration::from_millis(50)).await;
+        assert!(!finish.is_finished());
+        drop(held);
+
+        let stage = finish.await.unwrap();
+        assert_eq!(stage.results().unwrap().len(), 2);
+        assert_eq!(pool.available(), 1);
+    }
+
+    #[tokio::test]
+    async fn test_ed2k_fan_out_matches_streaming_hashes() {
+        let chunk = ED2K_CHUNK_SIZE as usize;
+        let pool = Arc::new(CpuPool::new(2));
+
+        // An exact multiple of the chunk size exercises the Red variant's
+        // trailing empty chunk; the other size leaves a partial last chunk
+        for size in [3 * chunk, 2 * chunk + 777] {
+            let data: Vec<u8> = (0..size).map(|i| (i % 239) as u8).collect();
+            for algorithms in [
+                vec![HashAlgorithm::ED2K],
+                vec![HashAlgorithm::ED2K, HashAlgorithm::CRC32],
+            ] {
+                let mut stage = HashingStage::new(&algorithms)
+                    .with_ed2k_workers(2)
+                    .with_cpu_pool(pool.clone());
+                stage.initialize(size as u64).await.unwrap();
+                assert!(stage.ed2k_fan_out.is_some());
+
+                // Reads not aligned to ED2K chunks
+                for piece in data.chunks(1024 * 1024 + 333) {
+                    stage.process(piece).await.unwrap();
+                }
+                stage.finalize().await.unwrap();
+
+                let results = stage.results().unwrap();
+                for algorithm in algorithms {
+                    assert_eq!(
+                        results[&algorithm],
+                        algorithm.to_impl().hash_bytes(&data),
+                        "{algorithm:?} for {size} bytes"
+                    );
+                }
+                assert!(stage.algorithm_times().contains_key(&HashAlgorithm::ED2K));
+                assert_eq!(pool.available(), 2);
+            }
+        }
     }
 
     #[test]
@@ -4,10 +4,14 @@
 //! with clear separation between I/O and processing concerns.
 
 use crate::Result;
+use crate::platform::{IoMode, IoStrategy};
+use crate::scheduler::CpuPool;
 use async_trait::async_trait;
 use std::fmt::Debug;
+use std::sync::Arc;
 
 mod combinators;
+mod fingerprint;
 mod hashing;
 mod progress;
 mod streaming;
@@ -16,7 +20,8 @@ mod validation;
 pub use combinators::{
     BufferingStage, ConditionalStage, ParallelStage, RateLimitedStage, StageExt, TransformStage,
 };
-pub use hashing::HashingStage;
+pub use fingerprint::FingerprintStage;
+pub use hashing::{DEFAULT_QUEUE_DEPTH, HashingStage};
 pub use progress::ProgressStage;
 pub use streaming::{StreamingPipeline, StreamingPipelineBuilder};
 pub use validation::ValidationStage;
@@ -62,6 +67,14 @@ pub trait ProcessingStage: Send + Sync + Debug {
     /// Get the name of this stage for debugging
     fn name(&self) -> &str;
 
+    /// Bound the stage's CPU heavy work by `pool`
+    ///
+    /// Such stages hold a slot only while they compute, never while they
+    /// wait. Stages doing little work per chunk ignore the pool.
+    fn set_cpu_pool(&mut self, pool: Arc<CpuPool>) {
+        let _ = pool;
+    }
+
     /// Allow downcasting to concrete types
     fn as_any_mut(&mut self) -> Option<&mut dyn std::any::Any> {
         None
@@ -77,6 +90,8 @@ pub struct PipelineConfig {
     pub parallel_stages: bool,
     /// Maximum memory usage allowed
     pub max_memory: usize,
+    /// How file data is read from disk
+    pub io_mode: IoMode,
 }
 
 impl Default for PipelineConfig {
@@ -85,12 +100,13 @@ impl Default for PipelineConfig {
             chunk_size: 64 * 1024, // 64KB default
             parallel_stages: false,
             max_memory: 500 * 1024 * 1024, // 500MB
+            io_mode: IoMode::Auto,
         }
     }
 }
 
 /// Statistics from pipeline execution
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Default)]
 pub struct PipelineStats {
     /// Total bytes processed
     pub bytes_processed: u64,
@@ -100,4 +116,14 @@ pub struct PipelineStats {
     pub total_duration: std::time::Duration,
     /// Throughput in MB/s
     pub throughput_mbps: f64,
+    /// Time spent opening the file
+    pub open_duration: std::time::Duration,
+    /// Time spent waiting for chunks to be read
+    pub read_duration: std::time::Duration,
+    /// Time spent yielding to interactive work between chunks
+    pub wait_duration: std::time::Duration,
+    /// Time spent in the stages, initialization and finalization included
+    pub stage_duration: std::time::Duration,
+    /// How the file was read after any fallback, `None` for in-memory data
+    pub io_strategy: Option<IoStrategy>,
 }
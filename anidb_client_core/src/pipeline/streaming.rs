@@ -4,12 +4,12 @@
 
 use super::{PipelineConfig, PipelineStats, ProcessingStage};
 use crate::buffer::MemoryTracker;
-use crate::memory::{allocate as mem_allocate, release as mem_release};
-use crate::{Error, Result};
+use crate::platform::ChunkReader;
+use crate::scheduler::{CpuPool, InteractiveGuard, yield_to_interactive};
+use crate::{Error, Result, error::IoError};
 use std::path::Path;
+use std::sync::Arc;
 use std::time::Instant;
-use tokio::fs::File;
-use tokio::io::{AsyncReadExt, BufReader};
 
 /// Main streaming pipeline that composes processing stages
 #[derive(Debug)]
@@ -23,6 +23,8 @@ pub struct StreamingPipeline {
     memory_tracker: MemoryTracker,
     /// Statistics
     stats: PipelineStats,
+    /// Pool bounding CPU heavy stages across pipelines
+    cpu_pool: Option<Arc<CpuPool>>,
 }
 
 impl StreamingPipeline {
@@ -34,17 +36,16 @@ impl StreamingPipeline {
             stages: Vec::new(),
             config,
             memory_tracker,
-            stats: PipelineStats {
-                bytes_processed: 0,
-                chunks_processed: 0,
-                total_duration: std::time::Duration::ZERO,
-                throughput_mbps: 0.0,
-            },
+            stats: PipelineStats::default(),
+            cpu_pool: None,
         }
     }
 
     /// Add a processing stage to the pipeline
-    pub fn add_stage(mut self, stage: Box<dyn ProcessingStage>) -> Self {
+    pub fn add_stage(mut self, mut stage: Box<dyn ProcessingStage>) -> Self {
+        if let Some(pool) = &self.cpu_pool {
+            stage.set_cpu_pool(pool.clone());
+        }
         self.stages.push(stage);
         self
     }
@@ -52,41 +53,49 @@ impl StreamingPipeline {
     /// Process a file through the pipeline
     pub async fn process_file(&mut self, path: &Path) -> Result<PipelineStats> {
         let start_time = Instant::now();
+        // Background pipelines hold back at chunk boundaries while this is alive
+        let _interactive = InteractiveGuard::enter();
 
         // Get file metadata
         let metadata = tokio::fs::metadata(path).await?;
         let file_size = metadata.len();
 
+        // Reset stats
+        self.stats = PipelineStats::default();
+
         // Initialize all stages
+        let stage_start = Instant::now();
         for stage in &mut self.stages {
             stage.initialize(file_size).await?;
         }
+        self.stats.stage_duration += stage_start.elapsed();
 
-        // Open file for streaming
-        let file = File::open(path).await?;
-        let mut reader = BufReader::with_capacity(self.config.chunk_size, file);
+        // Open file for streaming with the configured I/O mode
+        let open_start = Instant::now();
+        let mut reader =
+            ChunkReader::open(path, self.config.io_mode, self.config.chunk_size).await?;
+        self.stats.open_duration = open_start.elapsed();
+        self.stats.io_strategy = Some(reader.strategy());
 
-        // Reset stats
-        self.stats = PipelineStats {
-            bytes_processed: 0,
-            chunks_processed: 0,
-            total_duration: std::time::Duration::ZERO,
-            throughput_mbps: 0.0,
-        };
-
-        // Process file in chunks
+        // Process file in chunks; the reader owns and reuses its buffer
         loop {
-            let mut buffer = mem_allocate(self.config.chunk_size)?;
-            let bytes_read = reader.read(&mut buffer).await?;
-
-            if bytes_read == 0 {
-                mem_release(buffer); // Release unused buffer
-                break; // EOF
-            }
-
-            let chunk = &buffer[..bytes_read];
+            let read_start = Instant::now();
+            let Some(chunk) = reader.next_chunk().await? else {
+                self.stats.read_duration += read_start.elapsed();
+                break;
+            };
+            let bytes_read = chunk.len();
+
+            // Background work first lets running interactive work go ahead.
+            // CPU slots are taken by the stages that hash, only while they
+            // hash.
+            let wait_start = Instant::now();
+            self.stats.read_duration += wait_start - read_start;
+            yield_to_interactive().await;
 
             // Process chunk through all stages
+            let stage_start = Instant::now();
+            self.stats.wait_duration += stage_start - wait_start;
             for stage in &mut self.stages {
                 stage.process(chunk).await.map_err(|e| {
                     Error::Internal(crate::error::InternalError::Assertion {
@@ -94,18 +103,32 @@ impl StreamingPipeline {
                     })
                 })?
             }
+            self.stats.stage_duration += stage_start.elapsed();
 
             self.stats.bytes_processed += bytes_read as u64;
             self.stats.chunks_processed += 1;
+        }
 
-            // Return buffer to memory manager
-            mem_release(buffer);
+        // A file that changed size while it was read would hash wrong
+        if self.stats.bytes_processed != file_size {
+            return Err(Error::Io(
+                IoError::from_std(std::io::Error::new(
+                    std::io::ErrorKind::UnexpectedEof,
+                    format!(
+                        "read {} of {} bytes; the file changed while it was read",
+                        self.stats.bytes_processed, file_size
+                    ),
+                ))
+                .with_path(path),
+            ));
         }
 
         // Finalize all stages
+        let stage_start = Instant::now();
         for stage in &mut self.stages {
             stage.finalize().await?;
         }
+        self.stats.stage_duration += stage_start.elapsed();
 
         // Calculate final stats
         self.stats.total_duration = start_time.elapsed();
@@ -130,12 +153,7 @@ impl StreamingPipeline {
         }
 
         // Reset stats
-        self.stats = PipelineStats {
-            bytes_processed: 0,
-            chunks_processed: 0,
-            total_duration: std::time::Duration::ZERO,
-            throughput_mbps: 0.0,
-        };
+        self.stats = PipelineStats::default();
 
         // Process data in chunks
         let mut offset = 0;
@@ -199,6 +217,7 @@ impl StreamingPipeline {
 pub struct StreamingPipelineBuilder {
     stages: Vec<Box<dyn ProcessingStage>>,
     config: PipelineConfig,
+    cpu_pool: Option<Arc<CpuPool>>,
 }
 
 #[allow(dead_code)]
@@ -208,6 +227,7 @@ impl StreamingPipelineBuilder {
         Self {
             stages: Vec::new(),
             config: PipelineConfig::default(),
+            cpu_pool: None,
         }
     }
 
@@ -216,6 +236,7 @@ impl StreamingPipelineBuilder {
         Self {
             stages: Vec::new(),
             config,
+            cpu_pool: None,
         }
     }
 
@@ -243,20 +264,30 @@ impl StreamingPipelineBuilder {
         self
     }
 
+    /// Share a CPU pool with other pipelines processing concurrently
+    ///
+    /// Every stage is handed the pool, see
+    /// [`ProcessingStage::set_cpu_pool`].
+    pub fn cpu_pool(mut self, pool: Arc<CpuPool>) -> Self {
+        self.cpu_pool = Some(pool);
+        self
+    }
+
     /// Build the pipeline
-    pub fn build(self) -> StreamingPipeline {
+    pub fn build(mut self) -> StreamingPipeline {
         let memory_tracker = MemoryTracker::new(self.config.max_memory);
+        if let Some(pool) = &self.cpu_pool {
+            for stage in &mut self.stages {
+                stage.set_cpu_pool(pool.clone());
+            }
+        }
 
         StreamingPipeline {
             stages: self.stages,
             config: self.config,
             memory_tracker,
-            stats: PipelineStats {
-                bytes_processed: 0,
-                chunks_processed: 0,
-                total_duration: std::time::Duration::ZERO,
-                throughput_mbps: 0.0,
-            },
+            stats: PipelineStats::default(),
+            cpu_pool: self.cpu_pool,
         }
     }
 }
@@ -337,6 +368,42 @@ mod tests {
         assert_eq!(stats.chunks_processed, 0);
     }
 
+    /// Truncates the file being read after the first chunk
+    #[derive(Debug)]
+    struct TruncatingStage(std::path::PathBuf);
+
+    #[async_trait::async_trait]
+    impl ProcessingStage for TruncatingStage {
+        async fn process(&mut self, _chunk: &[u8]) -> Result<()> {
+            std::fs::OpenOptions::new()
+                .write(true)
+                .open(&self.0)
+                .unwrap()
+                .set_len(10)
+                .unwrap();
+            Ok(())
+        }
+
+        fn name(&self) -> &str {
+            "truncating"
+        }
+    }
+
+    #[tokio::test]
+    async fn test_file_shrinking_while_read_fails() {
+        let temp_dir = TempDir::new().unwrap();
+        let test_file = temp_dir.path().join("shrinking.dat");
+        std::fs::write(&test_file, vec![7u8; 64 * 1024]).unwrap();
+
+        let mut pipeline = StreamingPipelineBuilder::new()
+            .add_stage(Box::new(TruncatingStage(test_file.clone())))
+            .chunk_size(4096)
+            .build();
+
+        let result = pipeline.process_file(&test_file).await;
+        assert!(matches!(result, Err(Error::Io(_))), "{result:?}");
+    }
+
     #[test]
     fn test_builder_configuration() {
         let pipeline = StreamingPipelineBuilder::new()
@@ -5,14 +5,26 @@
 //! core business logic. No platform-specific code should leak into core modules.
 
 pub mod build_config;
+pub mod chunk_reader;
+pub mod cpu_features;
+pub mod device;
 pub mod io_optimization;
+#[cfg(target_os = "linux")]
+pub mod io_uring;
+pub mod mapped_file;
 pub mod path_handling;
 
 // Re-export main types for convenience
 pub use build_config::{BuildConfig, PlatformFeatures, TargetPlatform};
+pub use chunk_reader::{ChunkReader, DIRECT_IO_ALIGNMENT};
+pub use cpu_features::CpuFeatures;
+pub use device::{
+    DeviceClass, UNKNOWN_DEVICE, device_class, device_class_for_path, device_id, device_id_for_path,
+};
 pub use io_optimization::{
-    IoOptimizer, IoStrategy, MemoryPreference, OptimizationHint, ReadPattern,
+    IoMode, IoOptimizer, IoStrategy, MemoryPreference, OptimizationHint, ReadPattern,
 };
+pub use mapped_file::MappedFile;
 pub use path_handling::{PathInfo, PathValidation, PlatformPathHandler};
 
 /// Platform-aware streaming trait that extends the base streaming functionality
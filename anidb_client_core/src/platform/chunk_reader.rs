@@ -0,0 +1,728 @@
+//! Chunked file reading with selectable I/O modes
+//!
+//! The streaming pipeline consumes files as a sequence of chunks. How those
+//! chunks are produced depends on the configured [`IoMode`]:
+//!
+//! - **Buffered**: regular reads into one reused buffer, with the kernel told
+//!   the access is sequential so readahead stays ahead of the hashers.
+//! - **Memory mapped**: the file is mapped read-only with `MADV_SEQUENTIAL`
+//!   and chunks are slices of the mapping, avoiding the copy into user space.
+//! - **Direct**: reads bypass the page cache (`O_DIRECT` on Linux,
+//!   `F_NOCACHE` on macOS) into page-aligned buffers drawn from a small pool.
+//!   Hashing a library once should not evict everything else from memory.
+//! - **io_uring** (Linux): reads are queued on a ring shared by every file
+//!   and land in registered buffers, several chunks ahead of the hashers.
+//!   See [`io_uring`](super::io_uring).
+//!
+//! Modes that are not available for a file or platform fall back to buffered
+//! reads, so callers never need to handle an "unsupported" error.
+
+use super::io_optimization::{IoMode, IoOptimizer, IoStrategy};
+use crate::Result;
+use crate::memory::{allocate as mem_allocate, release as mem_release};
+use std::ops::Range;
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use tokio::fs::File;
+use tokio::io::{AsyncReadExt, AsyncSeekExt};
+
+/// Alignment required for direct I/O buffers, offsets and lengths
+pub const DIRECT_IO_ALIGNMENT: usize = 4096;
+
+/// Maximum number of idle aligned buffers kept for reuse
+const ALIGNED_POOL_CAPACITY: usize = 4;
+
+/// Reads a file as a sequence of chunks using the configured I/O mode
+#[derive(Debug)]
+pub struct ChunkReader {
+    source: ChunkSource,
+    chunk_size: usize,
+    strategy: IoStrategy,
+}
+
+#[derive(Debug)]
+enum ChunkSource {
+    Buffered(BufferedSource),
+    #[cfg(unix)]
+    Mapped(MappedSource),
+    Direct(DirectSource),
+    #[cfg(target_os = "linux")]
+    Uring(super::io_uring::UringFile),
+}
+
+impl ChunkReader {
+    /// Open `path` for chunked reading
+    ///
+    /// `chunk_size` is the maximum length of each chunk returned by
+    /// [`next_chunk`](Self::next_chunk). Direct reads round it up to
+    /// [`DIRECT_IO_ALIGNMENT`], io_uring reads cap it at
+    /// [`URING_CHUNK_SIZE`](super::io_uring::URING_CHUNK_SIZE).
+    pub async fn open(path: &Path, mode: IoMode, chunk_size: usize) -> Result<Self> {
+        Self::open_at(path, mode, chunk_size, 0..u64::MAX).await
+    }
+
+    /// Open `path` for chunked reading of the bytes in `range`
+    ///
+    /// Reading stops at the end of the range or of the file, whichever
+    /// comes first. Direct reads need a start aligned to
+    /// [`DIRECT_IO_ALIGNMENT`] and read buffered otherwise.
+    pub async fn open_range(
+        path: &Path,
+        mode: IoMode,
+        chunk_size: usize,
+        range: Range<u64>,
+    ) -> Result<Self> {
+        Self::open_at(path, mode, chunk_size, range).await
+    }
+
+    async fn open_at(
+        path: &Path,
+        mode: IoMode,
+        chunk_size: usize,
+        range: Range<u64>,
+    ) -> Result<Self> {
+        let chunk_size = chunk_size.max(1);
+        let file_size = tokio::fs::metadata(path).await?.len();
+        let strategy = IoOptimizer::new().strategy_for_mode(mode);
+        // Mappings and the ring read up to the size the file has now
+        let sized = range.start..range.end.min(file_size);
+        let aligned = range.start.is_multiple_of(DIRECT_IO_ALIGNMENT as u64);
+
+        let source = match strategy {
+            #[cfg(unix)]
+            IoStrategy::MemoryMapped if file_size > 0 => {
+                match MappedSource::open(path, file_size, sized) {
+                    Ok(mapped) => ChunkSource::Mapped(mapped),
+                    Err(_) => {
+                        ChunkSource::Buffered(BufferedSource::open(path, chunk_size, range).await?)
+                    }
+                }
+            }
+            IoStrategy::DirectIo if aligned => {
+                match DirectSource::open(path, chunk_size, range.clone()).await {
+                    Ok(direct) => ChunkSource::Direct(direct),
+                    // Filesystems such as tmpfs reject O_DIRECT; keep the cache
+                    // footprint low by dropping pages as they are consumed
+                    Err(_) => {
+                        let mut buffered = BufferedSource::open(path, chunk_size, range).await?;
+                        buffered.drop_consumed = true;
+                        ChunkSource::Buffered(buffered)
+                    }
+                }
+            }
+            IoStrategy::DirectIo => {
+                let mut buffered = BufferedSource::open(path, chunk_size, range).await?;
+                buffered.drop_consumed = true;
+                ChunkSource::Buffered(buffered)
+            }
+            // The ring may be unavailable or have every buffer leased
+            #[cfg(target_os = "linux")]
+            IoStrategy::IoUring if file_size > 0 => {
+                match super::io_uring::UringFile::open_range(path, sized, chunk_size) {
+                    Ok(uring) => ChunkSource::Uring(uring),
+                    Err(_) => {
+                        ChunkSource::Buffered(BufferedSource::open(path, chunk_size, range).await?)
+                    }
+                }
+            }
+            _ => ChunkSource::Buffered(BufferedSource::open(path, chunk_size, range).await?),
+        };
+
+        let strategy = match &source {
+            ChunkSource::Buffered(_) => IoStrategy::AsyncBuffered,
+            #[cfg(unix)]
+            ChunkSource::Mapped(_) => IoStrategy::MemoryMapped,
+            ChunkSource::Direct(_) => IoStrategy::DirectIo,
+            #[cfg(target_os = "linux")]
+            ChunkSource::Uring(_) => IoStrategy::IoUring,
+        };
+
+        Ok(Self {
+            source,
+            chunk_size,
+            strategy,
+        })
+    }
+
+    /// Strategy actually in use after any fallback
+    pub fn strategy(&self) -> IoStrategy {
+        self.strategy
+    }
+
+    /// Read the next chunk, returning `None` at end of file
+    pub async fn next_chunk(&mut self) -> Result<Option<&[u8]>> {
+        match &mut self.source {
+            ChunkSource::Buffered(source) => source.next_chunk().await,
+            #[cfg(unix)]
+            ChunkSource::Mapped(source) => Ok(source.next_chunk(self.chunk_size)),
+            ChunkSource::Direct(source) => source.next_chunk().await,
+            #[cfg(target_os = "linux")]
+            ChunkSource::Uring(source) => Ok(source.next_chunk().await?),
+        }
+    }
+}
+
+/// Regular reads into a single buffer from the memory manager
+#[derive(Debug)]
+struct BufferedSource {
+    file: File,
+    buffer: Option<Vec<u8>>,
+    filled: usize,
+    offset: u64,
+    /// Offset reading stops at
+    end: u64,
+    drop_consumed: bool,
+}
+
+impl BufferedSource {
+    async fn open(path: &Path, chunk_size: usize, range: Range<u64>) -> Result<Self> {
+        let mut file = File::open(path).await?;
+        advise_sequential(&file);
+        if range.start > 0 {
+            file.seek(std::io::SeekFrom::Start(range.start)).await?;
+        }
+        let buffer = mem_allocate(chunk_size)?;
+
+        Ok(Self {
+            file,
+            buffer: Some(buffer),
+            filled: 0,
+            offset: range.start,
+            end: range.end,
+            drop_consumed: false,
+        })
+    }
+
+    async fn next_chunk(&mut self) -> Result<Option<&[u8]>> {
+        if self.drop_consumed && self.filled > 0 {
+            advise_dont_need(&self.file, self.offset, self.filled);
+        }
+        self.offset += self.filled as u64;
+        self.filled = 0;
+
+        let buffer = self.buffer.as_mut().expect("buffer is held until drop");
+        let want = buffer
+            .len()
+            .min(self.end.saturating_sub(self.offset) as usize);
+        if want == 0 {
+            return Ok(None);
+        }
+        let bytes_read = self.file.read(&mut buffer[..want]).await?;
+        if bytes_read == 0 {
+            return Ok(None);
+        }
+
+        self.filled = bytes_read;
+        Ok(Some(&buffer[..bytes_read]))
+    }
+}
+
+impl Drop for BufferedSource {
+    fn drop(&mut self) {
+        if let Some(buffer) = self.buffer.take() {
+            mem_release(buffer);
+        }
+    }
+}
+
+/// Read-only private mapping of a whole file
+#[cfg(unix)]
+#[derive(Debug)]
+struct MappedSource {
+    ptr: *mut libc::c_void,
+    len: usize,
+    offset: usize,
+    /// Offset reading stops at
+    end: usize,
+}
+
+// The mapping is read-only and owned exclusively by this source
+#[cfg(unix)]
+unsafe impl Send for MappedSource {}
+
+#[cfg(unix)]
+impl MappedSource {
+    fn open(path: &Path, file_size: u64, range: Range<u64>) -> Result<Self> {
+        use std::os::unix::io::AsRawFd;
+
+        let len = usize::try_from(file_size).map_err(|_| {
+            crate::Error::Internal(crate::error::InternalError::unsupported_io_strategy(
+                "MemoryMapped",
+                "File is larger than the address space",
+            ))
+        })?;
+        let file = std::fs::File::open(path)?;
+
+        // SAFETY: mapping a file descriptor we own; the mapping outlives the
+        // descriptor, which POSIX permits.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(std::io::Error::last_os_error().into());
+        }
+
+        // SAFETY: `ptr` and `len` describe the mapping created above
+        unsafe {
+            libc::madvise(ptr, len, libc::MADV_SEQUENTIAL);
+        }
+
+        // Both within the file, which fits the address space
+        Ok(Self {
+            ptr,
+            len,
+            offset: range.start.min(file_size) as usize,
+            end: range.end as usize,
+        })
+    }
+
+    fn next_chunk(&mut self, chunk_size: usize) -> Option<&[u8]> {
+        if self.offset >= self.end {
+            return None;
+        }
+
+        let end = (self.offset + chunk_size).min(self.end);
+        // SAFETY: `offset..end` lies within the live mapping
+        let chunk = unsafe {
+            std::slice::from_raw_parts((self.ptr as *const u8).add(self.offset), end - self.offset)
+        };
+        self.offset = end;
+        Some(chunk)
+    }
+}
+
+#[cfg(unix)]
+impl Drop for MappedSource {
+    fn drop(&mut self) {
+        // SAFETY: unmapping the region created in `open`
+        unsafe {
+            libc::munmap(self.ptr, self.len);
+        }
+    }
+}
+
+/// Page-aligned heap buffer suitable for direct I/O
+struct AlignedBuffer {
+    ptr: std::ptr::NonNull<u8>,
+    len: usize,
+}
+
+// The buffer is uniquely owned heap memory
+unsafe impl Send for AlignedBuffer {}
+
+impl AlignedBuffer {
+    fn layout(len: usize) -> std::alloc::Layout {
+        std::alloc::Layout::from_size_align(len, DIRECT_IO_ALIGNMENT)
+            .expect("aligned buffer size overflows")
+    }
+
+    /// Take a buffer of exactly `len` bytes from the pool or allocate one
+    fn acquire(len: usize) -> Self {
+        let mut pool = ALIGNED_POOL.lock().unwrap_or_else(|e| e.into_inner());
+        if let Some(index) = pool.iter().position(|b| b.len == len) {
+            return pool.swap_remove(index);
+        }
+        drop(pool);
+
+        // SAFETY: layout has a non-zero size (len is at least one alignment)
+        let ptr = unsafe { std::alloc::alloc(Self::layout(len)) };
+        let ptr = std::ptr::NonNull::new(ptr)
+            .unwrap_or_else(|| std::alloc::handle_alloc_error(Self::layout(len)));
+        Self { ptr, len }
+    }
+
+    /// Return the buffer to the pool, freeing it when the pool is full
+    fn recycle(self) {
+        let mut pool = ALIGNED_POOL.lock().unwrap_or_else(|e| e.into_inner());
+        if pool.len() < ALIGNED_POOL_CAPACITY {
+            pool.push(self);
+        }
+    }
+
+    fn as_slice(&self, len: usize) -> &[u8] {
+        // SAFETY: len never exceeds the allocation and the bytes were
+        // initialized by a read
+        unsafe { std::slice::from_raw_parts(self.ptr.as_ptr(), len.min(self.len)) }
+    }
+
+    fn as_mut_slice(&mut self) -> &mut [u8] {
+        // SAFETY: the allocation is `len` bytes and uniquely borrowed; u8 has
+        // no invalid bit patterns
+        unsafe { std::slice::from_raw_parts_mut(self.ptr.as_ptr(), self.len) }
+    }
+}
+
+impl Drop for AlignedBuffer {
+    fn drop(&mut self) {
+        // SAFETY: allocated in `acquire` with the same layout
+        unsafe { std::alloc::dealloc(self.ptr.as_ptr(), Self::layout(self.len)) }
+    }
+}
+
+impl std::fmt::Debug for AlignedBuffer {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("AlignedBuffer")
+            .field("len", &self.len)
+            .finish()
+    }
+}
+
+lazy_static::lazy_static! {
+    static ref ALIGNED_POOL: Mutex<Vec<AlignedBuffer>> = Mutex::new(Vec::new());
+}
+
+/// Uncached reads into pooled aligned buffers
+#[derive(Debug)]
+struct DirectSource {
+    file: Option<std::fs::File>,
+    buffer: Option<AlignedBuffer>,
+    filled: usize,
+    /// Bytes left before the end of the range
+    remaining: u64,
+    eof: bool,
+    path: PathBuf,
+    /// File offset of the next read
+    offset: u64,
+    file_size: u64,
+    /// Set once a short read mid-file moved reads to a cached descriptor
+    cached: bool,
+}
+
+impl DirectSource {
+    /// Open for reading `range`, whose start must be aligned
+    async fn open(path: &Path, chunk_size: usize, range: Range<u64>) -> Result<Self> {
+        let path = path.to_path_buf();
+        let start = range.start;
+        let (file, path) = tokio::task::spawn_blocking(move || {
+            use std::io::{Seek, SeekFrom};
+
+            let mut file = open_uncached(&path)?;
+            file.seek(SeekFrom::Start(start))?;
+            Ok::<_, std::io::Error>((file, path))
+        })
+        .await
+        .map_err(|e| std::io::Error::other(e.to_string()))??;
+        let file_size = file.metadata()?.len();
+
+        let len = chunk_size.div_ceil(DIRECT_IO_ALIGNMENT) * DIRECT_IO_ALIGNMENT;
+        Ok(Self {
+            file: Some(file),
+            buffer: Some(AlignedBuffer::acquire(len)),
+            filled: 0,
+            remaining: range.end.saturating_sub(range.start),
+            eof: false,
+            path,
+            offset: start,
+            file_size,
+            cached: false,
+        })
+    }
+
+    async fn next_chunk(&mut self) -> Result<Option<&[u8]>> {
+        if self.eof {
+            return Ok(None);
+        }
+
+        let mut file = self.file.take().expect("file is held until drop");
+        let mut buffer = self.buffer.take().expect("buffer is held until drop");
+        let path = self.path.clone();
+        let (offset, file_size, mut cached) = (self.offset, self.file_size, self.cached);
+
+        let (file, buffer, cached, result) = tokio::task::spawn_blocking(move || {
+            let result = fill_direct(
+                &mut file,
+                &path,
+                offset,
+                file_size,
+                buffer.as_mut_slice(),
+                &mut cached,
+            );
+            (file, buffer, cached, result)
+        })
+        .await
+        .map_err(|e| std::io::Error::other(e.to_string()))?;
+
+        self.file = Some(file);
+        self.cached = cached;
+        let buffer = self.buffer.insert(buffer);
+        let filled = result?;
+        self.offset += filled as u64;
+
+        // Reads only come back short at the end of the file now
+        if filled < buffer.len {
+            self.eof = true;
+        }
+        // Reads stay aligned, so the last one of a range may run past it
+        let filled = filled.min(self.remaining.min(usize::MAX as u64) as usize);
+        self.remaining -= filled as u64;
+        if self.remaining == 0 {
+            self.eof = true;
+        }
+        self.filled = filled;
+
+        if filled == 0 {
+            return Ok(None);
+        }
+        Ok(Some(buffer.as_slice(self.filled)))
+    }
+}
+
+impl Drop for DirectSource {
+    fn drop(&mut self) {
+        if let Some(buffer) = self.buffer.take() {
+            buffer.recycle();
+        }
+    }
+}
+
+/// Fill `buffer` from `offset` until it is full or the file ends
+///
+/// Network and FUSE filesystems may return short unaligned reads before
+/// the end of the file. O_DIRECT rejects the unaligned offset that follows,
+/// so `file` is replaced by a cached descriptor and `cached` is set.
+fn fill_direct(
+    file: &mut std::fs::File,
+    path: &Path,
+    offset: u64,
+    file_size: u64,
+    buffer: &mut [u8],
+    cached: &mut bool,
+) -> std::io::Result<usize> {
+    use std::io::{Read, Seek, SeekFrom};
+
+    let mut filled = 0;
+    while filled < buffer.len() {
+        match file.read(&mut buffer[filled..]) {
+            Ok(0) => break,
+            Ok(n) => {
+                filled += n;
+                if !*cached && filled % DIRECT_IO_ALIGNMENT != 0 {
+                    let position = offset + filled as u64;
+                    if position >= file_size {
+                        break;
+                    }
+                    let mut reopened = std::fs::File::open(path)?;
+                    reopened.seek(SeekFrom::Start(position))?;
+                    *file = reopened;
+                    *cached = true;
+                }
+            }
+            Err(e) if e.kind() == std::io::ErrorKind::Interrupted => continue,
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(filled)
+}
+
+/// Open a file for reads that bypass the page cache
+#[cfg(target_os = "linux")]
+fn open_uncached(path: &Path) -> std::io::Result<std::fs::File> {
+    use std::os::unix::fs::OpenOptionsExt;
+
+    std::fs::OpenOptions::new()
+        .read(true)
+        .custom_flags(libc::O_DIRECT)
+        .open(path)
+}
+
+/// Open a file for reads that bypass the page cache
+#[cfg(target_os = "macos")]
+fn open_uncached(path: &Path) -> std::io::Result<std::fs::File> {
+    use std::os::unix::io::AsRawFd;
+
+    let file = std::fs::File::open(path)?;
+    // SAFETY: fcntl on a descriptor we own
+    if unsafe { libc::fcntl(file.as_raw_fd(), libc::F_NOCACHE, 1) } == -1 {
+        return Err(std::io::Error::last_os_error());
+    }
+    Ok(file)
+}
+
+/// Open a file for reads that bypass the page cache
+#[cfg(not(any(target_os = "linux", target_os = "macos")))]
+fn open_uncached(_path: &Path) -> std::io::Result<std::fs::File> {
+    Err(std::io::Error::new(
+        std::io::ErrorKind::Unsupported,
+        "direct I/O is not supported on this platform",
+    ))
+}
+
+/// Tell the kernel the file will be read sequentially
+fn advise_sequential(file: &File) {
+    #[cfg(any(target_os = "linux", target_os = "android"))]
+    {
+        use std::os::unix::io::AsRawFd;
+        // SAFETY: advisory call on a descriptor we own; failure is harmless
+        unsafe {
+            libc::posix_fadvise(file.as_raw_fd(), 0, 0, libc::POSIX_FADV_SEQUENTIAL);
+        }
+    }
+
+    #[cfg(not(any(target_os = "linux", target_os = "android")))]
+    let _ = file;
+}
+
+/// Drop an already consumed range from the page cache
+fn advise_dont_need(file: &File, offset: u64, len: usize) {
+    #[cfg(any(target_os = "linux", target_os = "android"))]
+    {
+        use std::os::unix::io::AsRawFd;
+        // SAFETY: advisory call on a descriptor we own; failure is harmless
+        unsafe {
+            libc::posix_fadvise(
+                file.as_raw_fd(),
+                offset as libc::off_t,
+                len as libc::off_t,
+                libc::POSIX_FADV_DONTNEED,
+            );
+        }
+    }
+
+    #[cfg(not(any(target_os = "linux", target_os = "android")))]
+    let _ = (file, offset, len);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    async fn read_all(path: &Path, mode: IoMode, chunk_size: usize) -> Vec<u8> {
+        let mut reader = ChunkReader::open(path, mode, chunk_size).await.unwrap();
+        let mut data = Vec::new();
+        while let Some(chunk) = reader.next_chunk().await.unwrap() {
+            assert!(chunk.len() <= chunk_size.div_ceil(DIRECT_IO_ALIGNMENT) * DIRECT_IO_ALIGNMENT);
+            data.extend_from_slice(chunk);
+        }
+        data
+    }
+
+    #[tokio::test]
+    async fn test_all_modes_read_identical_bytes() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("data.bin");
+        // Deliberately not a multiple of the alignment
+        let expected: Vec<u8> = (0..3 * 65_536 + 123).map(|i| (i % 251) as u8).collect();
+        std::fs::write(&path, &expected).unwrap();
+
+        for mode in [
+            IoMode::Auto,
+            IoMode::Buffered,
+            IoMode::MemoryMapped,
+            IoMode::DirectIo,
+            IoMode::IoUring,
+        ] {
+            assert_eq!(read_all(&path, mode, 65_536).await, expected, "{mode:?}");
+        }
+    }
+
+    #[tokio::test]
+    async fn test_ranges_read_only_their_bytes() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("range.bin");
+        let contents: Vec<u8> = (0..5 * 65_536 + 77).map(|i| (i % 253) as u8).collect();
+        std::fs::write(&path, &contents).unwrap();
+
+        // An aligned and an unaligned start, and an end past the file
+        let len = contents.len() as u64;
+        for range in [2 * 65_536..4 * 65_536 + 5, 1000..2000, 3 * 65_536..len + 10] {
+            for mode in [
+                IoMode::Buffered,
+                IoMode::MemoryMapped,
+                IoMode::DirectIo,
+                IoMode::IoUring,
+            ] {
+                let mut reader = ChunkReader::open_range(&path, mode, 65_536, range.clone())
+                    .await
+                    .unwrap();
+                let mut data = Vec::new();
+                while let Some(chunk) = reader.next_chunk().await.unwrap() {
+                    data.extend_from_slice(chunk);
+                }
+                let expected = &contents[range.start as usize..len.min(range.end) as usize];
+                assert_eq!(data, expected, "{mode:?} {range:?}");
+            }
+        }
+    }
+
+    #[test]
+    fn test_short_reads_mid_file_switch_to_cached_reads() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("short.bin");
+        let data: Vec<u8> = (0..10_000u32).map(|i| (i % 251) as u8).collect();
+        std::fs::write(&path, &data[..5_000]).unwrap();
+
+        // The recorded size is past the unaligned read, as on a share that
+        // returns part of a request
+        let mut file = std::fs::File::open(&path).unwrap();
+        let mut buffer = vec![0u8; 8192];
+        let mut cached = false;
+        let filled = fill_direct(&mut file, &path, 0, 10_000, &mut buffer, &mut cached).unwrap();
+        assert_eq!(filled, 5_000);
+        assert!(cached);
+
+        // At the real end of the file the short read is final
+        let mut file = std::fs::File::open(&path).unwrap();
+        let mut cached = false;
+        let filled = fill_direct(&mut file, &path, 0, 5_000, &mut buffer, &mut cached).unwrap();
+        assert_eq!(filled, 5_000);
+        assert!(!cached);
+        assert_eq!(&buffer[..filled], &data[..5_000]);
+    }
+
+    #[tokio::test]
+    async fn test_empty_file_yields_no_chunks() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("empty.bin");
+        std::fs::write(&path, b"").unwrap();
+
+        for mode in [
+            IoMode::Buffered,
+            IoMode::MemoryMapped,
+            IoMode::DirectIo,
+            IoMode::IoUring,
+        ] {
+            let mut reader = ChunkReader::open(&path, mode, 4096).await.unwrap();
+            assert!(reader.next_chunk().await.unwrap().is_none());
+        }
+    }
+
+    #[tokio::test]
+    async fn test_auto_mode_uses_buffered_reads() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("auto.bin");
+        std::fs::write(&path, [1u8; 100]).unwrap();
+
+        let reader = ChunkReader::open(&path, IoMode::Auto, 64).await.unwrap();
+        assert_eq!(reader.strategy(), IoStrategy::AsyncBuffered);
+    }
+
+    #[cfg(target_os = "linux")]
+    #[tokio::test]
+    async fn test_io_uring_mode_reports_backend() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("uring.bin");
+        std::fs::write(&path, [3u8; 10_000]).unwrap();
+
+        let mut reader = ChunkReader::open(&path, IoMode::IoUring, 4096)
+            .await
+            .unwrap();
+        // Falls back when the kernel has no io_uring or every buffer is leased
+        assert!(matches!(
+            reader.strategy(),
+            IoStrategy::IoUring | IoStrategy::AsyncBuffered
+        ));
+        let mut total = 0;
+        while let Some(chunk) = reader.next_chunk().await.unwrap() {
+            total += chunk.len();
+        }
+        assert_eq!(total, 10_000);
+    }
+}
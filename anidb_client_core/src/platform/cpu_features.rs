@@ -0,0 +1,73 @@
+//! Runtime CPU feature detection
+//!
+//! Hash kernels are compiled for several instruction sets and the widest one
+//! the host supports is picked at runtime, so a single binary runs on every
+//! machine in a fleet. Detection happens once per process.
+
+use std::sync::OnceLock;
+
+/// Instruction set extensions relevant to the hash kernels
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CpuFeatures {
+    pub sse2: bool,
+    pub sse4_1: bool,
+    pub avx2: bool,
+    pub avx512f: bool,
+    pub pclmulqdq: bool,
+    pub neon: bool,
+    /// ARMv8 CRC32 instructions
+    pub crc32: bool,
+}
+
+impl CpuFeatures {
+    /// Features of the current CPU, detected on first use
+    pub fn get() -> &'static CpuFeatures {
+        static FEATURES: OnceLock<CpuFeatures> = OnceLock::new();
+        FEATURES.get_or_init(Self::detect)
+    }
+
+    /// Query the CPU for its features
+    pub fn detect() -> Self {
+        #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+        {
+            Self {
+                sse2: is_x86_feature_detected!("sse2"),
+                sse4_1: is_x86_feature_detected!("sse4.1"),
+                avx2: is_x86_feature_detected!("avx2"),
+                avx512f: is_x86_feature_detected!("avx512f"),
+                pclmulqdq: is_x86_feature_detected!("pclmulqdq"),
+                ..Self::default()
+            }
+        }
+
+        #[cfg(target_arch = "aarch64")]
+        {
+            Self {
+                neon: std::arch::is_aarch64_feature_detected!("neon"),
+                crc32: std::arch::is_aarch64_feature_detected!("crc"),
+                ..Self::default()
+            }
+        }
+
+        #[cfg(not(any(target_arch = "x86", target_arch = "x86_64", target_arch = "aarch64")))]
+        {
+            Self::default()
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_detection_is_cached() {
+        assert_eq!(*CpuFeatures::get(), CpuFeatures::detect());
+
+        #[cfg(target_arch = "x86_64")]
+        assert!(CpuFeatures::get().sse2);
+
+        #[cfg(target_arch = "aarch64")]
+        assert!(CpuFeatures::get().neon);
+    }
+}
@@ -0,0 +1,164 @@
+//! Storage device identification
+//!
+//! Provides a stable identifier for the device that backs a file so that
+//! schedulers can group work per physical disk and avoid interleaving
+//! concurrent sequential readers on the same spindle, and a coarse device
+//! class so hashing can spend more cores on devices that keep up with them.
+
+use std::collections::HashMap;
+use std::fs::Metadata;
+use std::path::Path;
+use std::sync::{LazyLock, Mutex};
+
+/// Device identifier used when the backing device cannot be determined
+pub const UNKNOWN_DEVICE: u64 = 0;
+
+/// Get an identifier for the device that stores `path`
+///
+/// On Unix this is `st_dev`. Other platforms fall back to a hash of the
+/// path prefix (drive letter or UNC share), which groups files per volume.
+pub fn device_id(metadata: &Metadata, path: &Path) -> u64 {
+    #[cfg(unix)]
+    {
+        use std::os::unix::fs::MetadataExt;
+        let _ = path;
+        metadata.dev()
+    }
+
+    #[cfg(not(unix))]
+    {
+        use std::collections::hash_map::DefaultHasher;
+        use std::hash::{Hash, Hasher};
+
+        let _ = metadata;
+        let absolute = std::path::absolute(path).unwrap_or_else(|_| path.to_path_buf());
+        match absolute.components().next() {
+            Some(prefix) => {
+                let mut hasher = DefaultHasher::new();
+                prefix.hash(&mut hasher);
+                // Never collide with the unknown-device sentinel
+                hasher.finish().max(1)
+            }
+            None => UNKNOWN_DEVICE,
+        }
+    }
+}
+
+/// Get the device identifier for a path, querying its metadata
+///
+/// Paths that cannot be inspected (missing or unreadable files) are
+/// attributed to their parent directory's device when it exists.
+pub fn device_id_for_path(path: &Path) -> u64 {
+    if let Ok(metadata) = std::fs::metadata(path) {
+        return device_id(&metadata, path);
+    }
+
+    if let Some(parent) = path.parent().filter(|p| !p.as_os_str().is_empty())
+        && let Ok(metadata) = std::fs::metadata(parent)
+    {
+        return device_id(&metadata, parent);
+    }
+
+    UNKNOWN_DEVICE
+}
+
+/// Broad speed class of a storage device
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum DeviceClass {
+    /// Spinning disk, where throughput depends on sequential access
+    Rotational,
+    /// SSD or NVMe, fast enough that hashing becomes the bottleneck
+    SolidState,
+    /// Network, virtual or otherwise unidentified storage
+    Unknown,
+}
+
+/// Classify a device, caching the answer per device identifier
+pub fn device_class(device: u64) -> DeviceClass {
+    static CLASSES: LazyLock<Mutex<HashMap<u64, DeviceClass>>> =
+        LazyLock::new(|| Mutex::new(HashMap::new()));
+
+    if device == UNKNOWN_DEVICE {
+        return DeviceClass::Unknown;
+    }
+
+    let mut classes = CLASSES.lock().unwrap_or_else(|e| e.into_inner());
+    *classes
+        .entry(device)
+        .or_insert_with(|| query_device_class(device))
+}
+
+/// Classify the device that stores `path`
+pub fn device_class_for_path(path: &Path) -> DeviceClass {
+    device_class(device_id_for_path(path))
+}
+
+#[cfg(target_os = "linux")]
+fn query_device_class(device: u64) -> DeviceClass {
+    let dev = device as libc::dev_t;
+    let block = format!("/sys/dev/block/{}:{}", libc::major(dev), libc::minor(dev));
+
+    // Partitions have no queue of their own; it belongs to the parent disk
+    for queue in ["queue/rotational", "../queue/rotational"] {
+        if let Ok(value) = std::fs::read_to_string(Path::new(&block).join(queue)) {
+            return match value.trim() {
+                "0" => DeviceClass::SolidState,
+                "1" => DeviceClass::Rotational,
+                _ => DeviceClass::Unknown,
+            };
+        }
+    }
+
+    DeviceClass::Unknown
+}
+
+#[cfg(not(target_os = "linux"))]
+fn query_device_class(_device: u64) -> DeviceClass {
+    DeviceClass::Unknown
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::fs;
+    use tempfile::TempDir;
+
+    #[test]
+    fn test_same_directory_same_device() {
+        let temp_dir = TempDir::new().unwrap();
+        let first = temp_dir.path().join("a.bin");
+        let second = temp_dir.path().join("b.bin");
+        fs::write(&first, b"a").unwrap();
+        fs::write(&second, b"b").unwrap();
+
+        assert_eq!(device_id_for_path(&first), device_id_for_path(&second));
+    }
+
+    #[test]
+    fn test_missing_file_uses_parent_device() {
+        let temp_dir = TempDir::new().unwrap();
+        let existing = temp_dir.path().join("a.bin");
+        let missing = temp_dir.path().join("missing.bin");
+        fs::write(&existing, b"a").unwrap();
+
+        assert_eq!(device_id_for_path(&missing), device_id_for_path(&existing));
+    }
+
+    #[test]
+    fn test_missing_directory_is_unknown_device() {
+        let temp_dir = TempDir::new().unwrap();
+        let missing = temp_dir.path().join("no_such_dir").join("missing.bin");
+
+        assert_eq!(device_id_for_path(&missing), UNKNOWN_DEVICE);
+    }
+
+    #[test]
+    fn test_device_class() {
+        assert_eq!(device_class(UNKNOWN_DEVICE), DeviceClass::Unknown);
+
+        // Any answer is valid for the test machine, but it must be stable
+        let temp_dir = TempDir::new().unwrap();
+        let class = device_class_for_path(temp_dir.path());
+        assert_eq!(device_class_for_path(temp_dir.path()), class);
+    }
+}
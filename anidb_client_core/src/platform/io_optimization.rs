@@ -4,6 +4,7 @@
 //! platform capabilities, file size, and access patterns.
 
 use crate::{Error, Result, error::InternalError};
+use serde::{Deserialize, Serialize};
 use std::path::Path;
 use tokio::io::AsyncRead;
 
@@ -30,6 +31,24 @@ pub enum IoStrategy {
     AsyncBuffered, // Use async I/O with buffering
     DirectIo,      // Use direct I/O (bypass OS cache)
     Overlapped,    // Use Windows overlapped I/O
+    IoUring,       // Queue reads on a shared io_uring (Linux)
+}
+
+/// User-selectable read mode for file hashing
+///
+/// `Auto` lets the optimizer decide and currently resolves to buffered reads:
+/// memory mapping is opt-in because a file truncated while mapped raises
+/// `SIGBUS` instead of returning an I/O error, and io_uring because its
+/// buffers stay pinned for the life of the process once used.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default, Serialize, Deserialize)]
+#[serde(rename_all = "snake_case")]
+pub enum IoMode {
+    #[default]
+    Auto,
+    Buffered,     // Page-cached reads with sequential readahead
+    MemoryMapped, // Map the file read-only with MADV_SEQUENTIAL
+    DirectIo,     // Bypass the page cache with aligned reads
+    IoUring,      // Read ahead through io_uring into registered buffers
 }
 
 /// Optimization hint for choosing I/O strategy
@@ -83,6 +102,22 @@ impl IoOptimizer {
         IoStrategy::AsyncBuffered
     }
 
+    /// Resolve a user-selected I/O mode to the strategy used for reading
+    ///
+    /// Explicit modes are honoured where the platform supports them and fall
+    /// back to async buffered reads otherwise.
+    pub fn strategy_for_mode(&self, mode: IoMode) -> IoStrategy {
+        match mode {
+            IoMode::Auto | IoMode::Buffered => IoStrategy::AsyncBuffered,
+            IoMode::MemoryMapped if cfg!(unix) => IoStrategy::MemoryMapped,
+            IoMode::DirectIo if cfg!(any(target_os = "linux", target_os = "macos")) => {
+                IoStrategy::DirectIo
+            }
+            IoMode::IoUring if cfg!(target_os = "linux") => IoStrategy::IoUring,
+            _ => IoStrategy::AsyncBuffered,
+        }
+    }
+
     /// Create an optimized reader for the given file and strategy
     pub async fn create_optimized_reader<P: AsRef<Path>>(
         &self,
@@ -104,6 +139,10 @@ impl IoOptimizer {
                 // For now, fall back to async buffered
                 self.create_async_buffered_reader(file_path).await
             }
+            IoStrategy::IoUring => {
+                // Ring reads yield chunks, see ChunkReader
+                self.create_async_buffered_reader(file_path).await
+            }
         }
     }
 
@@ -0,0 +1,854 @@
+//! io_uring reads for the file hashing path (Linux)
+//!
+//! Every file read with [`IoMode::IoUring`](super::IoMode::IoUring) goes
+//! through one ring shared by the whole process. The ring's buffers are
+//! taken from the memory manager once and registered with the kernel, so
+//! reads into them skip pinning pages per request. An open file leases a
+//! few of those buffers and keeps a read in flight in each of them: the
+//! device sees a queue spanning all files of a batch while the hashers
+//! consume completed chunks in order, and one completion thread reaps the
+//! ring for everyone.
+//!
+//! The ring is driven with raw system calls. When the kernel refuses to set
+//! one up (too old, `kernel.io_uring_disabled`, seccomp) or every buffer is
+//! leased, [`UringFile::open`] fails and the chunk reader falls back to
+//! buffered reads.
+
+use crate::memory::{allocate as mem_allocate, release as mem_release};
+use std::collections::VecDeque;
+use std::ffi::c_void;
+use std::io;
+use std::ops::Range;
+use std::os::fd::{AsRawFd, FromRawFd, OwnedFd, RawFd};
+use std::path::Path;
+use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::{Mutex, OnceLock};
+use std::task::{Context, Poll, Waker};
+
+/// Size of each registered buffer, and so the longest chunk a file yields
+pub const URING_CHUNK_SIZE: usize = 1024 * 1024;
+
+/// Registered buffers, which is also the deepest the queue can get
+const BUFFER_COUNT: usize = 32;
+
+/// Reads one file keeps in flight
+const READS_PER_FILE: usize = 4;
+
+const IORING_OFF_SQ_RING: libc::off_t = 0;
+const IORING_OFF_CQ_RING: libc::off_t = 0x800_0000;
+const IORING_OFF_SQES: libc::off_t = 0x1000_0000;
+const IORING_OP_READ_FIXED: u8 = 4;
+const IORING_OP_READ: u8 = 22;
+const IORING_ENTER_GETEVENTS: u32 = 1;
+const IORING_REGISTER_BUFFERS: u32 = 0;
+const IORING_FEAT_RW_CUR_POS: u32 = 1 << 3;
+
+/// `struct io_sqring_offsets`
+#[repr(C)]
+#[derive(Debug, Default)]
+struct SqRingOffsets {
+    head: u32,
+    tail: u32,
+    ring_mask: u32,
+    ring_entries: u32,
+    flags: u32,
+    dropped: u32,
+    array: u32,
+    resv1: u32,
+    user_addr: u64,
+}
+
+/// `struct io_cqring_offsets`
+#[repr(C)]
+#[derive(Debug, Default)]
+struct CqRingOffsets {
+    head: u32,
+    tail: u32,
+    ring_mask: u32,
+    ring_entries: u32,
+    overflow: u32,
+    cqes: u32,
+    flags: u32,
+    resv1: u32,
+    user_addr: u64,
+}
+
+/// `struct io_uring_params`
+#[repr(C)]
+#[derive(Debug, Default)]
+struct Params {
+    sq_entries: u32,
+    cq_entries: u32,
+    flags: u32,
+    sq_thread_cpu: u32,
+    sq_thread_idle: u32,
+    features: u32,
+    wq_fd: u32,
+    resv: [u32; 3],
+    sq_off: SqRingOffsets,
+    cq_off: CqRingOffsets,
+}
+
+/// `struct io_uring_sqe`, reduced to the fields reads use
+#[repr(C)]
+#[derive(Debug, Default)]
+struct Sqe {
+    opcode: u8,
+    flags: u8,
+    ioprio: u16,
+    fd: i32,
+    off: u64,
+    addr: u64,
+    len: u32,
+    rw_flags: u32,
+    user_data: u64,
+    buf_index: u16,
+    personality: u16,
+    splice_fd_in: i32,
+    addr3: u64,
+    pad: u64,
+}
+
+/// `struct io_uring_cqe`
+#[repr(C)]
+#[derive(Debug)]
+struct Cqe {
+    user_data: u64,
+    res: i32,
+    flags: u32,
+}
+
+/// Shared mapping of part of a ring
+#[derive(Debug)]
+struct RingMap {
+    ptr: *mut c_void,
+    len: usize,
+}
+
+impl RingMap {
+    fn new(fd: RawFd, len: usize, offset: libc::off_t) -> io::Result<Self> {
+        // SAFETY: mapping a region the kernel sized for this ring descriptor
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED | libc::MAP_POPULATE,
+                fd,
+                offset,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error());
+        }
+        Ok(Self { ptr, len })
+    }
+
+    /// Pointer `offset` bytes into the mapping
+    fn at<T>(&self, offset: u32) -> *mut T {
+        // SAFETY: offsets come from the kernel and lie within the mapping
+        unsafe { self.ptr.cast::<u8>().add(offset as usize).cast() }
+    }
+}
+
+impl Drop for RingMap {
+    fn drop(&mut self) {
+        // SAFETY: unmapping the region created in `new`
+        unsafe {
+            libc::munmap(self.ptr, self.len);
+        }
+    }
+}
+
+/// Submission and completion queues of one io_uring instance
+///
+/// Only one thread at a time may push submissions, and only the completion
+/// thread consumes completions; [`UringDriver`] upholds both.
+#[derive(Debug)]
+struct Ring {
+    sq_head: *const AtomicU32,
+    sq_tail: *const AtomicU32,
+    sq_mask: u32,
+    sq_entries: u32,
+    sq_array: *mut u32,
+    sqes: *mut Sqe,
+    cq_head: *const AtomicU32,
+    cq_tail: *const AtomicU32,
+    cq_mask: u32,
+    cqes: *const Cqe,
+    features: u32,
+    _sq_map: RingMap,
+    _cq_map: RingMap,
+    _sqe_map: RingMap,
+    fd: OwnedFd,
+}
+
+// The queues live in shared mappings accessed through atomics, with access
+// serialized as described on `Ring`
+unsafe impl Send for Ring {}
+unsafe impl Sync for Ring {}
+
+impl Ring {
+    fn new(entries: u32) -> io::Result<Self> {
+        let mut params = Params::default();
+        // SAFETY: io_uring_setup only writes to `params`
+        let fd = unsafe {
+            libc::syscall(
+                libc::SYS_io_uring_setup,
+                entries,
+                &mut params as *mut Params,
+            )
+        };
+        if fd < 0 {
+            return Err(io::Error::last_os_error());
+        }
+        // SAFETY: the descriptor was just created and is owned by nobody else
+        let fd = unsafe { OwnedFd::from_raw_fd(fd as RawFd) };
+        let raw = fd.as_raw_fd();
+
+        let sq_len =
+            params.sq_off.array as usize + params.sq_entries as usize * std::mem::size_of::<u32>();
+        let cq_len =
+            params.cq_off.cqes as usize + params.cq_entries as usize * std::mem::size_of::<Cqe>();
+        let sqe_len = params.sq_entries as usize * std::mem::size_of::<Sqe>();
+        let sq_map = RingMap::new(raw, sq_len, IORING_OFF_SQ_RING)?;
+        let cq_map = RingMap::new(raw, cq_len, IORING_OFF_CQ_RING)?;
+        let sqe_map = RingMap::new(raw, sqe_len, IORING_OFF_SQES)?;
+
+        // SAFETY: the masks are plain values the kernel wrote into the rings
+        let (sq_mask, cq_mask) = unsafe {
+            (
+                *sq_map.at::<u32>(params.sq_off.ring_mask),
+                *cq_map.at::<u32>(params.cq_off.ring_mask),
+            )
+        };
+
+        Ok(Self {
+            sq_head: sq_map.at(params.sq_off.head),
+            sq_tail: sq_map.at(params.sq_off.tail),
+            sq_mask,
+            sq_entries: params.sq_entries,
+            sq_array: sq_map.at(params.sq_off.array),
+            sqes: sqe_map.at(0),
+            cq_head: cq_map.at(params.cq_off.head),
+            cq_tail: cq_map.at(params.cq_off.tail),
+            cq_mask,
+            cqes: cq_map.at(params.cq_off.cqes),
+            features: params.features,
+            _sq_map: sq_map,
+            _cq_map: cq_map,
+            _sqe_map: sqe_map,
+            fd,
+        })
+    }
+
+    fn register_buffers(&self, iovecs: &[libc::iovec]) -> io::Result<()> {
+        // SAFETY: the kernel reads `iovecs.len()` entries and pins the
+        // memory they describe
+        let result = unsafe {
+            libc::syscall(
+                libc::SYS_io_uring_register,
+                self.fd.as_raw_fd(),
+                IORING_REGISTER_BUFFERS,
+                iovecs.as_ptr(),
+                iovecs.len() as u32,
+            )
+        };
+        if result < 0 {
+            return Err(io::Error::last_os_error());
+        }
+        Ok(())
+    }
+
+    fn enter(&self, to_submit: u32, min_complete: u32, flags: u32) -> io::Result<u32> {
+        // SAFETY: no signal mask is passed
+        let result = unsafe {
+            libc::syscall(
+                libc::SYS_io_uring_enter,
+                self.fd.as_raw_fd(),
+                to_submit,
+                min_complete,
+                flags,
+                std::ptr::null::<c_void>(),
+                0usize,
+            )
+        };
+        if result < 0 {
+            return Err(io::Error::last_os_error());
+        }
+        Ok(result as u32)
+    }
+
+    /// Queue an entry, returning false when the submission queue is full
+    ///
+    /// # Safety
+    ///
+    /// The caller must be the only thread pushing submissions.
+    unsafe fn push(&self, sqe: Sqe) -> bool {
+        // SAFETY: head and tail point into the live submission ring
+        let (head, tail) = unsafe {
+            (
+                (*self.sq_head).load(Ordering::Acquire),
+                (*self.sq_tail).load(Ordering::Relaxed),
+            )
+        };
+        if tail.wrapping_sub(head) >= self.sq_entries {
+            return false;
+        }
+
+        let index = tail & self.sq_mask;
+        // SAFETY: `index` is masked into both arrays, and the kernel does not
+        // read the slot until the tail moves past it
+        unsafe {
+            self.sqes.add(index as usize).write(sqe);
+            self.sq_array.add(index as usize).write(index);
+            (*self.sq_tail).store(tail.wrapping_add(1), Ordering::Release);
+        }
+        true
+    }
+
+    /// Entries queued but not yet consumed by the kernel
+    fn unsubmitted(&self) -> u32 {
+        // SAFETY: head and tail point into the live submission ring
+        unsafe {
+            (*self.sq_tail)
+                .load(Ordering::Relaxed)
+                .wrapping_sub((*self.sq_head).load(Ordering::Acquire))
+        }
+    }
+
+    /// Hand every available completion to `complete`
+    ///
+    /// # Safety
+    ///
+    /// The caller must be the only thread consuming completions.
+    unsafe fn drain(&self, mut complete: impl FnMut(u64, i32)) {
+        // SAFETY: head and tail point into the live completion ring; entries
+        // between them were published by the kernel
+        unsafe {
+            let mut head = (*self.cq_head).load(Ordering::Relaxed);
+            let tail = (*self.cq_tail).load(Ordering::Acquire);
+            while head != tail {
+                let cqe = &*self.cqes.add((head & self.cq_mask) as usize);
+                complete(cqe.user_data, cqe.res);
+                head = head.wrapping_add(1);
+            }
+            (*self.cq_head).store(head, Ordering::Release);
+        }
+    }
+}
+
+/// Progress of the read into one buffer
+#[derive(Debug)]
+enum SlotState {
+    Idle,
+    Pending(Option<Waker>),
+    Done(i32),
+    /// The file went away with the read in flight; the buffer returns to the
+    /// free list once the read completes
+    Abandoned,
+}
+
+#[derive(Debug)]
+struct Slot {
+    ptr: *mut u8,
+    state: Mutex<SlotState>,
+}
+
+/// Process-wide ring with its registered buffers
+#[derive(Debug)]
+struct UringDriver {
+    ring: Ring,
+    /// Serializes submissions
+    submit: Mutex<()>,
+    /// Set once the completion thread has stopped
+    broken: AtomicBool,
+    slots: Vec<Slot>,
+    free: Mutex<Vec<usize>>,
+    /// Whether `buffers` are registered, allowing fixed reads
+    fixed: bool,
+    /// Owns the memory `slots` point into; never touched after setup
+    _buffers: Vec<Vec<u8>>,
+}
+
+// Slot buffers are only accessed by whoever leased them, see `UringFile`
+unsafe impl Send for UringDriver {}
+unsafe impl Sync for UringDriver {}
+
+/// A read to submit, by buffer index
+#[derive(Debug, Clone, Copy, Default)]
+struct Read {
+    slot: usize,
+    offset: u64,
+    len: usize,
+}
+
+impl UringDriver {
+    fn new() -> io::Result<Self> {
+        let ring = Ring::new(BUFFER_COUNT as u32)?;
+
+        let mut buffers = Vec::with_capacity(BUFFER_COUNT);
+        for _ in 0..BUFFER_COUNT {
+            match mem_allocate(URING_CHUNK_SIZE) {
+                Ok(buffer) => buffers.push(buffer),
+                Err(e) => {
+                    buffers.into_iter().for_each(mem_release);
+                    return Err(io::Error::other(e));
+                }
+            }
+        }
+        let iovecs: Vec<libc::iovec> = buffers
+            .iter_mut()
+            .map(|buffer| libc::iovec {
+                iov_base: buffer.as_mut_ptr().cast(),
+                iov_len: URING_CHUNK_SIZE,
+            })
+            .collect();
+
+        // Registration can exceed RLIMIT_MEMLOCK on older kernels; plain
+        // reads into the same buffers still batch and overlap
+        let fixed = match ring.register_buffers(&iovecs) {
+            Ok(()) => true,
+            Err(e) if ring.features & IORING_FEAT_RW_CUR_POS != 0 => {
+                log::debug!("io_uring buffer registration failed, using plain reads: {e}");
+                false
+            }
+            // Too old for IORING_OP_READ as well
+            Err(e) => {
+                buffers.into_iter().for_each(mem_release);
+                return Err(e);
+            }
+        };
+
+        let slots = iovecs
+            .iter()
+            .map(|iovec| Slot {
+                ptr: iovec.iov_base.cast(),
+                state: Mutex::new(SlotState::Idle),
+            })
+            .collect();
+
+        Ok(Self {
+            ring,
+            submit: Mutex::new(()),
+            broken: AtomicBool::new(false),
+            slots,
+            free: Mutex::new((0..BUFFER_COUNT).rev().collect()),
+            fixed,
+            _buffers: buffers,
+        })
+    }
+
+    /// Lease up to `max` buffers
+    fn lease(&self, max: usize) -> Vec<usize> {
+        let mut free = self.free.lock().unwrap_or_else(|e| e.into_inner());
+        let keep = free.len().saturating_sub(max);
+        free.split_off(keep)
+    }
+
+    /// Return leased buffers that have no read in flight
+    fn release(&self, slots: impl IntoIterator<Item = usize>) {
+        self.free
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .extend(slots);
+    }
+
+    /// Return a leased buffer whose read may still be in flight
+    fn abandon(&self, slot: usize) {
+        let mut state = self.state(slot);
+        if matches!(*state, SlotState::Pending(_)) {
+            *state = SlotState::Abandoned;
+        } else {
+            *state = SlotState::Idle;
+            drop(state);
+            self.release([slot]);
+        }
+    }
+
+    fn state(&self, slot: usize) -> std::sync::MutexGuard<'_, SlotState> {
+        self.slots[slot]
+            .state
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// Queue reads of `fd` into leased buffers and submit them with one
+    /// system call
+    fn submit(&self, fd: RawFd, reads: &[Read]) -> io::Result<()> {
+        let _guard = self.submit.lock().unwrap_or_else(|e| e.into_inner());
+        if self.broken.load(Ordering::Acquire) {
+            return Err(io::Error::other("io_uring completion thread has stopped"));
+        }
+
+        for read in reads {
+            *self.state(read.slot) = SlotState::Pending(None);
+            let sqe = Sqe {
+                opcode: if self.fixed {
+                    IORING_OP_READ_FIXED
+                } else {
+                    IORING_OP_READ
+                },
+                fd,
+                off: read.offset,
+                addr: self.slots[read.slot].ptr as u64,
+                len: read.len as u32,
+                user_data: read.slot as u64,
+                buf_index: if self.fixed { read.slot as u16 } else { 0 },
+                ..Default::default()
+            };
+            // SAFETY: pushes are serialized by the submit lock. Every buffer
+            // has at most one read queued, so the queue cannot fill up.
+            if !unsafe { self.ring.push(sqe) } {
+                *self.state(read.slot) = SlotState::Idle;
+                return Err(io::Error::other("io_uring submission queue is full"));
+            }
+        }
+
+        // Entries left over from a failed submission go out with these
+        while self.ring.unsubmitted() > 0 {
+            match self.ring.enter(self.ring.unsubmitted(), 0, 0) {
+                Ok(0) => return Err(io::Error::other("io_uring accepted no submissions")),
+                Ok(_) => {}
+                Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+                Err(e) => return Err(e),
+            }
+        }
+        Ok(())
+    }
+
+    /// Poll the read into `slot`, yielding the number of bytes read
+    fn poll_read(&self, slot: usize, cx: &mut Context<'_>) -> Poll<io::Result<usize>> {
+        let mut state = self.state(slot);
+        match &mut *state {
+            SlotState::Done(res) => {
+                let res = *res;
+                *state = SlotState::Idle;
+                if res < 0 {
+                    Poll::Ready(Err(io::Error::from_raw_os_error(-res)))
+                } else {
+                    Poll::Ready(Ok(res as usize))
+                }
+            }
+            SlotState::Pending(waker) => {
+                *waker = Some(cx.waker().clone());
+                Poll::Pending
+            }
+            // Nothing was submitted into the buffer
+            SlotState::Idle | SlotState::Abandoned => Poll::Ready(Err(io::Error::other(
+                "no io_uring read is queued for this buffer",
+            ))),
+        }
+    }
+
+    /// Bytes the last read into `slot` produced
+    ///
+    /// # Safety
+    ///
+    /// The caller must hold the lease on `slot`, its read must have
+    /// completed with at least `len` bytes, and the slice must not be used
+    /// once another read into the slot is submitted.
+    unsafe fn buffer(&self, slot: usize, len: usize) -> &[u8] {
+        // SAFETY: see above; buffers are URING_CHUNK_SIZE long
+        unsafe { std::slice::from_raw_parts(self.slots[slot].ptr, len.min(URING_CHUNK_SIZE)) }
+    }
+
+    fn complete(&self, slot: usize, res: i32) {
+        let Some(slot_state) = self.slots.get(slot) else {
+            return;
+        };
+        let mut state = slot_state.state.lock().unwrap_or_else(|e| e.into_inner());
+        match std::mem::replace(&mut *state, SlotState::Done(res)) {
+            SlotState::Pending(waker) => {
+                drop(state);
+                if let Some(waker) = waker {
+                    waker.wake();
+                }
+            }
+            SlotState::Abandoned => {
+                *state = SlotState::Idle;
+                drop(state);
+                self.release([slot]);
+            }
+            previous => *state = previous,
+        }
+    }
+
+    /// Completion thread: wait for completions and wake their readers
+    fn reap(&self) {
+        loop {
+            match self.ring.enter(0, 1, IORING_ENTER_GETEVENTS) {
+                Ok(_) => {}
+                Err(e)
+                    if matches!(
+                        e.raw_os_error(),
+                        Some(libc::EINTR | libc::EAGAIN | libc::EBUSY)
+                    ) => {}
+                Err(e) => {
+                    log::error!("io_uring completion thread stopped: {e}");
+                    self.shut_down();
+                    return;
+                }
+            }
+            // SAFETY: this thread is the only consumer of completions
+            unsafe {
+                self.ring
+                    .drain(|user_data, res| self.complete(user_data as usize, res))
+            };
+        }
+    }
+
+    /// Fail every read still in flight and refuse new files
+    fn shut_down(&self) {
+        let guard = self.submit.lock().unwrap_or_else(|e| e.into_inner());
+        self.broken.store(true, Ordering::Release);
+        drop(guard);
+
+        for slot in 0..self.slots.len() {
+            self.complete(slot, -libc::EIO);
+        }
+    }
+}
+
+/// The shared driver, set up on first use
+fn driver() -> Option<&'static UringDriver> {
+    static DRIVER: OnceLock<Option<&'static UringDriver>> = OnceLock::new();
+
+    let driver = *DRIVER.get_or_init(|| {
+        let driver: &'static UringDriver = match UringDriver::new() {
+            Ok(driver) => Box::leak(Box::new(driver)),
+            Err(e) => {
+                log::debug!("io_uring is not available: {e}");
+                return None;
+            }
+        };
+        if let Err(e) = std::thread::Builder::new()
+            .name("anidb-io-uring".into())
+            .spawn(move || driver.reap())
+        {
+            log::debug!("io_uring completion thread failed to start: {e}");
+            return None;
+        }
+        Some(driver)
+    });
+    driver.filter(|driver| !driver.broken.load(Ordering::Acquire))
+}
+
+/// Whether this process can read files through io_uring
+pub fn available() -> bool {
+    driver().is_some()
+}
+
+/// A file read ahead through the shared ring
+///
+/// Chunks are slices of registered buffers, so they are at most
+/// [`URING_CHUNK_SIZE`] long. The file is read up to the size it had when
+/// opened, like a memory mapping; a file that shrinks ends early.
+#[derive(Debug)]
+pub struct UringFile {
+    driver: &'static UringDriver,
+    file: std::fs::File,
+    /// Offset reading stops at, the file size unless reading a range
+    file_size: u64,
+    chunk_size: usize,
+    next_offset: u64,
+    /// Leased buffers with no read in flight
+    idle: Vec<usize>,
+    /// Reads in flight, in file order
+    in_flight: VecDeque<Read>,
+    /// Buffer holding the chunk returned last
+    current: Option<usize>,
+}
+
+impl UringFile {
+    /// Open `path` and lease buffers for reading it
+    pub fn open(path: &Path, file_size: u64, chunk_size: usize) -> io::Result<Self> {
+        Self::open_range(path, 0..file_size, chunk_size)
+    }
+
+    /// Open `path` and lease buffers for reading the bytes in `range`
+    pub fn open_range(path: &Path, range: Range<u64>, chunk_size: usize) -> io::Result<Self> {
+        let driver = driver().ok_or_else(|| {
+            io::Error::new(io::ErrorKind::Unsupported, "io_uring is not available")
+        })?;
+        let file = std::fs::File::open(path)?;
+        // SAFETY: advisory call on a descriptor we own; failure is harmless
+        unsafe {
+            libc::posix_fadvise(file.as_raw_fd(), 0, 0, libc::POSIX_FADV_SEQUENTIAL);
+        }
+
+        let idle = driver.lease(READS_PER_FILE);
+        if idle.is_empty() {
+            return Err(io::Error::new(
+                io::ErrorKind::WouldBlock,
+                "every io_uring buffer is in use",
+            ));
+        }
+
+        Ok(Self {
+            driver,
+            file,
+            file_size: range.end,
+            chunk_size: chunk_size.clamp(1, URING_CHUNK_SIZE),
+            next_offset: range.start,
+            idle,
+            in_flight: VecDeque::with_capacity(READS_PER_FILE),
+            current: None,
+        })
+    }
+
+    /// Read the next chunk, returning `None` at end of file
+    pub async fn next_chunk(&mut self) -> io::Result<Option<&[u8]>> {
+        // The previous chunk has been consumed; read ahead into its buffer
+        if let Some(slot) = self.current.take() {
+            self.idle.push(slot);
+        }
+        self.fill()?;
+
+        let driver = self.driver;
+        let Some(&read) = self.in_flight.front() else {
+            return Ok(None);
+        };
+        let result = std::future::poll_fn(|cx| driver.poll_read(read.slot, cx)).await;
+        self.in_flight.pop_front();
+        self.current = Some(read.slot);
+        let bytes_read = result?;
+
+        if bytes_read < read.len {
+            // The file shrank: the reads ahead start at the wrong offset
+            self.drain().await;
+            self.next_offset = read.offset + bytes_read as u64;
+            if bytes_read == 0 {
+                self.file_size = read.offset;
+                return Ok(None);
+            }
+        }
+
+        // SAFETY: the read completed with `bytes_read` bytes and the buffer
+        // is not reused before the next call, which needs `&mut self`
+        Ok(Some(unsafe { driver.buffer(read.slot, bytes_read) }))
+    }
+
+    /// Submit a read into every idle buffer, up to the end of the file
+    fn fill(&mut self) -> io::Result<()> {
+        let mut reads = [Read::default(); READS_PER_FILE];
+        let mut count = 0;
+        while self.next_offset < self.file_size
+            && let Some(slot) = self.idle.pop()
+        {
+            let len = (self.file_size - self.next_offset).min(self.chunk_size as u64) as usize;
+            reads[count] = Read {
+                slot,
+                offset: self.next_offset,
+                len,
+            };
+            count += 1;
+            self.next_offset += len as u64;
+        }
+        if count == 0 {
+            return Ok(());
+        }
+
+        self.in_flight.extend(&reads[..count]);
+        self.driver.submit(self.file.as_raw_fd(), &reads[..count])
+    }
+
+    /// Wait for the reads ahead and discard them
+    async fn drain(&mut self) {
+        let driver = self.driver;
+        while let Some(&read) = self.in_flight.front() {
+            let _ = std::future::poll_fn(|cx| driver.poll_read(read.slot, cx)).await;
+            self.in_flight.pop_front();
+            self.idle.push(read.slot);
+        }
+    }
+}
+
+impl Drop for UringFile {
+    fn drop(&mut self) {
+        self.driver
+            .release(self.idle.drain(..).chain(self.current.take()));
+        for read in self.in_flight.drain(..) {
+            self.driver.abandon(read.slot);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    async fn read_all(path: &Path, chunk_size: usize) -> Option<Vec<u8>> {
+        let size = std::fs::metadata(path).unwrap().len();
+        let mut file = UringFile::open(path, size, chunk_size).ok()?;
+        let mut data = Vec::new();
+        while let Some(chunk) = file.next_chunk().await.unwrap() {
+            assert!(chunk.len() <= chunk_size.min(URING_CHUNK_SIZE));
+            data.extend_from_slice(chunk);
+        }
+        Some(data)
+    }
+
+    #[test]
+    fn test_struct_layouts_match_the_kernel() {
+        assert_eq!(std::mem::size_of::<Params>(), 120);
+        assert_eq!(std::mem::size_of::<Sqe>(), 64);
+        assert_eq!(std::mem::size_of::<Cqe>(), 16);
+    }
+
+    #[tokio::test]
+    async fn test_concurrent_files_read_identical_bytes() {
+        if !available() {
+            return;
+        }
+        let temp_dir = TempDir::new().unwrap();
+        let mut files = Vec::new();
+        for i in 0..6usize {
+            let path = temp_dir.path().join(format!("{i}.bin"));
+            let size = URING_CHUNK_SIZE * (i + 1) + 4_321 * i;
+            let contents: Vec<u8> = (0..size).map(|b| ((b + i) % 253) as u8).collect();
+            std::fs::write(&path, &contents).unwrap();
+            files.push((path, contents));
+        }
+
+        let mut tasks = Vec::new();
+        for (path, expected) in files {
+            tasks.push(tokio::spawn(async move {
+                // Leases may run out while other tests read as well
+                if let Some(data) = read_all(&path, 256 * 1024).await {
+                    assert_eq!(data, expected);
+                }
+            }));
+        }
+        for task in tasks {
+            task.await.unwrap();
+        }
+    }
+
+    #[tokio::test]
+    async fn test_dropping_a_file_mid_read_returns_its_buffers() {
+        if !available() {
+            return;
+        }
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("partial.bin");
+        std::fs::write(&path, vec![7u8; 4 * URING_CHUNK_SIZE]).unwrap();
+
+        // More files than there are buffers, each dropped with reads ahead
+        for _ in 0..2 * BUFFER_COUNT {
+            let Ok(mut file) = UringFile::open(&path, 4 * URING_CHUNK_SIZE as u64, 4096) else {
+                continue;
+            };
+            assert_eq!(file.next_chunk().await.unwrap().unwrap(), &[7u8; 4096][..]);
+        }
+        let size = 4 * URING_CHUNK_SIZE as u64;
+        for _ in 0..100 {
+            if UringFile::open(&path, size, 4096).is_ok() {
+                return;
+            }
+            tokio::time::sleep(std::time::Duration::from_millis(10)).await;
+        }
+        panic!("abandoned buffers were never returned");
+    }
+}
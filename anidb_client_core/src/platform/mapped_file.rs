@@ -0,0 +1,118 @@
+//! Read-only view of a whole file
+//!
+//! Used for data files that are looked up at random rather than streamed.
+//! On Unix the file is mapped, so opening costs the same for any file size
+//! and pages are read only when touched. Other platforms read the file into
+//! memory.
+
+use crate::Result;
+use std::path::Path;
+
+/// The contents of a file, mapped read-only where supported
+#[derive(Debug)]
+pub struct MappedFile {
+    inner: MappedInner,
+}
+
+#[derive(Debug)]
+enum MappedInner {
+    #[cfg(unix)]
+    Mapped {
+        ptr: *mut libc::c_void,
+        len: usize,
+    },
+    Owned(Vec<u8>),
+}
+
+// The mapping is read-only and never handed out mutably
+unsafe impl Send for MappedFile {}
+unsafe impl Sync for MappedFile {}
+
+impl MappedFile {
+    /// Open and map `path`
+    pub fn open(path: &Path) -> Result<Self> {
+        #[cfg(unix)]
+        {
+            use std::os::unix::io::AsRawFd;
+
+            let file = std::fs::File::open(path)?;
+            let len = usize::try_from(file.metadata()?.len()).map_err(|_| {
+                std::io::Error::new(
+                    std::io::ErrorKind::InvalidData,
+                    "file is larger than the address space",
+                )
+            })?;
+            // mmap() rejects empty mappings
+            if len == 0 {
+                return Ok(Self {
+                    inner: MappedInner::Owned(Vec::new()),
+                });
+            }
+
+            // SAFETY: mapping a file descriptor we own; the mapping outlives
+            // the descriptor, which POSIX permits.
+            let ptr = unsafe {
+                libc::mmap(
+                    std::ptr::null_mut(),
+                    len,
+                    libc::PROT_READ,
+                    libc::MAP_PRIVATE,
+                    file.as_raw_fd(),
+                    0,
+                )
+            };
+            if ptr == libc::MAP_FAILED {
+                return Err(std::io::Error::last_os_error().into());
+            }
+
+            // SAFETY: `ptr` and `len` describe the mapping created above
+            unsafe {
+                libc::madvise(ptr, len, libc::MADV_RANDOM);
+            }
+
+            Ok(Self {
+                inner: MappedInner::Mapped { ptr, len },
+            })
+        }
+
+        #[cfg(not(unix))]
+        {
+            Ok(Self {
+                inner: MappedInner::Owned(std::fs::read(path)?),
+            })
+        }
+    }
+
+    /// The file contents
+    pub fn as_slice(&self) -> &[u8] {
+        match &self.inner {
+            #[cfg(unix)]
+            // SAFETY: the mapping stays valid until drop
+            MappedInner::Mapped { ptr, len } => unsafe {
+                std::slice::from_raw_parts(*ptr as *const u8, *len)
+            },
+            MappedInner::Owned(bytes) => bytes,
+        }
+    }
+
+    /// Whether the contents are mapped rather than copied
+    pub fn is_mapped(&self) -> bool {
+        #[cfg(unix)]
+        if let MappedInner::Mapped { .. } = self.inner {
+            return true;
+        }
+        false
+    }
+}
+
+impl Drop for MappedFile {
+    fn drop(&mut self) {
+        #[cfg(unix)]
+        if let MappedInner::Mapped { ptr, len } = self.inner {
+            // SAFETY: unmapping the region created in `open`
+            unsafe {
+                libc::munmap(ptr, len);
+            }
+        }
+    }
+}
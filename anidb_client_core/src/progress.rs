@@ -47,6 +47,15 @@ pub enum ProgressUpdate {
         current_file: Option<String>,
     },
 
+    /// Progress of the files stored on one device during a batch
+    DeviceProgress {
+        device: u64,
+        files_completed: usize,
+        files_total: usize,
+        bytes_processed: u64,
+        throughput_mbps: f64,
+    },
+
     /// Hash calculation progress
     HashProgress {
         algorithm: String,
@@ -5,9 +5,11 @@
 use crate::protocol::codec::{Codec, FragmentAssembler};
 use crate::protocol::error::{ProtocolError, Result};
 use crate::protocol::messages::{Command, Response, ResponseParser};
+use crate::protocol::rate_limit::RateLimiter;
 use crate::protocol::transport::{Connection, ConnectionState, TransportConfig};
 use log::{debug, trace, warn};
 use std::sync::Arc;
+use std::sync::atomic::{AtomicU64, Ordering};
 use std::time::{Duration, Instant};
 use tokio::net::lookup_host;
 use tokio::sync::{Mutex, RwLock};
@@ -36,6 +38,9 @@ pub struct ProtocolConfig {
     pub compression: bool,
     /// MTU size
     pub mtu: Option<u16>,
+    /// Packets per second, replacing AniDB's flood limits. Only for test
+    /// servers; AniDB bans clients that send faster than its limits.
+    pub request_rate: Option<f64>,
 }
 
 impl Default for ProtocolConfig {
@@ -55,57 +60,18 @@ impl Default for ProtocolConfig {
             nat: false,
             compression: false,
             mtu: None,
+            request_rate: None,
         }
     }
 }
 
-/// Rate limiter for enforcing API rate limits
-struct RateLimiter {
-    /// Last request timestamp
-    last_request: Mutex<Option<Instant>>,
-    /// Minimum delay between requests
-    min_delay: Duration,
-}
-
-impl RateLimiter {
-    fn new() -> Self {
-        // Respect AniDB guidance: at least 2.0s between requests.
-        // We use 0.4 requests per second = 2.5 seconds between requests (safer margin).
-        let min_delay =
-            Duration::from_secs_f64(1.0 / crate::protocol::RATE_LIMIT_REQUESTS_PER_SECOND);
-
-        Self {
-            last_request: Mutex::new(None),
-            min_delay,
-        }
-    }
-
-    async fn wait_if_needed(&self) {
-        trace!("Rate limiter: acquiring last_request lock...");
-        let mut last = self.last_request.lock().await;
-        trace!("Rate limiter: last_request lock acquired");
-
-        if let Some(last_time) = *last {
-            let elapsed = last_time.elapsed();
-            trace!(
-                "Rate limiter: last request was {elapsed:?} ago, min_delay: {:?}",
-                self.min_delay
-            );
-            if elapsed < self.min_delay {
-                let wait_time = self.min_delay - elapsed;
-                debug!("Rate limiter: waiting {wait_time:?} to respect rate limit");
-                sleep(wait_time).await;
-                debug!("Rate limiter: wait completed");
-            } else {
-                trace!("Rate limiter: no wait needed, sufficient time has passed");
-            }
-        } else {
-            trace!("Rate limiter: no previous request, proceeding immediately");
-        }
-
-        *last = Some(Instant::now());
-        trace!("Rate limiter: updated last request time");
-    }
+/// Traffic counters of a [`ProtocolClient`]
+#[derive(Debug, Default)]
+pub struct ProtocolStats {
+    /// Packets sent again after a timeout or a transient server error
+    pub retries: AtomicU64,
+    /// Responses not received within the request timeout
+    pub timeouts: AtomicU64,
 }
 
 /// High-level protocol client
@@ -120,6 +86,8 @@ pub struct ProtocolClient {
     assembler: Arc<Mutex<FragmentAssembler>>,
     /// Rate limiter
     rate_limiter: Arc<RateLimiter>,
+    /// Retry and timeout counters
+    stats: Arc<ProtocolStats>,
     /// Current session info
     session: Arc<RwLock<Option<SessionInfo>>>,
 }
@@ -177,16 +145,32 @@ impl ProtocolClient {
         let connection = Connection::new(transport_config).await?;
         debug!("Protocol client created successfully");
 
+        let rate_limiter = match config.request_rate {
+            Some(rate) => RateLimiter::with_limits(rate, rate, 1.0),
+            None => RateLimiter::new(),
+        };
+
         Ok(Self {
             config,
             connection: Arc::new(connection),
             codec: Arc::new(Mutex::new(Codec::new())),
             assembler: Arc::new(Mutex::new(FragmentAssembler::new())),
-            rate_limiter: Arc::new(RateLimiter::new()),
+            rate_limiter: Arc::new(rate_limiter),
+            stats: Arc::new(ProtocolStats::default()),
             session: Arc::new(RwLock::new(None)),
         })
     }
 
+    /// The limiter spacing out this client's packets
+    pub fn rate_limiter(&self) -> &Arc<RateLimiter> {
+        &self.rate_limiter
+    }
+
+    /// Retry and timeout counters of this client
+    pub fn stats(&self) -> &Arc<ProtocolStats> {
+        &self.stats
+    }
+
     /// Connect to the AniDB server
     pub async fn connect(&self) -> Result<()> {
         debug!("Connecting to AniDB server...");
@@ -395,20 +379,29 @@ impl ProtocolClient {
         for attempt in 0..=self.config.max_retries {
             if attempt > 0 {
                 sleep(self.config.retry_delay * attempt).await;
+                self.stats.retries.fetch_add(1, Ordering::Relaxed);
             }
 
             match self.send_once(&encoded, &command_name).await {
                 Ok(response) => {
-                    // Check if response indicates we need to re-authenticate
-                    if response.is_error()
-                        && let Some(err) = response.to_error()
-                        && err.requires_reauth()
-                    {
-                        return Err(err);
+                    if let Some(err) = response.to_error() {
+                        // Check if response indicates we need to re-authenticate
+                        if err.requires_reauth() {
+                            return Err(err);
+                        }
+                        // A busy server asks for the packet to be sent again later
+                        if err.is_transient() && attempt < self.config.max_retries {
+                            debug!("Transient server error, retrying: {err}");
+                            last_error = Some(err);
+                            continue;
+                        }
                     }
                     return Ok(response);
                 }
                 Err(e) => {
+                    if matches!(e, ProtocolError::Timeout(_)) {
+                        self.stats.timeouts.fetch_add(1, Ordering::Relaxed);
+                    }
                     if !e.is_transient() || attempt == self.config.max_retries {
                         return Err(e);
                     }
@@ -607,6 +600,10 @@ mod tests {
 
         // Should wait approximately 2 seconds (rate limit)
         assert!(second_elapsed >= Duration::from_secs(1));
+
+        // The wait is accounted for once nothing is queued any more
+        assert!(limiter.total_wait() >= Duration::from_secs(1));
+        assert_eq!(limiter.waiting(), 0);
     }
 
     #[test]
@@ -5,17 +5,20 @@
 //! - `codec`: Message encoding/decoding with packet fragmentation support
 //! - `messages`: Type-safe message definitions and builders
 //! - `client`: High-level protocol client with rate limiting and retry logic
+//! - `rate_limit`: Token buckets for AniDB's short and long term flood limits
 
 pub mod client;
 pub mod codec;
 pub mod error;
 pub mod messages;
+pub mod rate_limit;
 pub mod transport;
 
 // Re-export main types
 pub use client::{ProtocolClient, ProtocolConfig};
 pub use error::{ProtocolError, Result};
 pub use messages::{Command, Response};
+pub use rate_limit::{RateLimiter, TokenBucket};
 pub use transport::{ConnectionState, Transport};
 
 /// Protocol version supported by this implementation
@@ -33,7 +36,7 @@ pub const DEFAULT_PORT: u16 = 9000;
 /// Session timeout in seconds (30 minutes)
 pub const SESSION_TIMEOUT_SECS: u64 = 1800;
 
-/// Rate limit: maximum requests per second (0.4 req/sec = 1 req per 2.5 seconds)
+/// Short term rate limit: maximum requests per second (0.4 req/sec = 1 req per 2.5 seconds)
 pub const RATE_LIMIT_REQUESTS_PER_SECOND: f64 = 0.4;
 
 #[cfg(test)]
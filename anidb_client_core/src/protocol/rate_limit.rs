@@ -0,0 +1,269 @@
+//! Client-side flood protection for the AniDB UDP API
+//!
+//! AniDB bans clients that send too fast, with two separate limits: a short
+//! term one (one packet every couple of seconds) and a stricter long term
+//! one that applies once a client has been sending for a while. Each limit
+//! is a token bucket; a packet may only go out once both have a token.
+//!
+//! The short term bucket holds a single token, so packets are never sent
+//! in a burst. The long term bucket starts full and refills at the long term
+//! rate, so a client sends at the short term rate for the first few minutes
+//! of sustained traffic and settles at the long term rate after that.
+//!
+//! Packets queue for their turn by [`Priority`], so an identification a
+//! user is waiting on goes out before queued background lookups.
+
+use crate::scheduler::{Priority, PrioritySemaphore};
+use log::{debug, trace};
+use std::sync::Arc;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::time::{Duration, Instant};
+use tokio::sync::Mutex;
+use tokio::time::sleep;
+
+/// Long term rate limit: one packet every four seconds
+pub const LONG_TERM_REQUESTS_PER_SECOND: f64 = 0.25;
+
+/// Packets the long term bucket lets through at the short term rate
+///
+/// At 0.4 packets per second against a 0.25 refill the bucket drains by
+/// 0.15 tokens per second, so it empties after about five minutes.
+pub const LONG_TERM_BURST: f64 = 45.0;
+
+/// A token bucket
+#[derive(Debug, Clone)]
+pub struct TokenBucket {
+    capacity: f64,
+    tokens: f64,
+    refill_per_sec: f64,
+    updated_at: Instant,
+}
+
+impl TokenBucket {
+    /// Create a full bucket
+    pub fn new(capacity: f64, refill_per_sec: f64, now: Instant) -> Self {
+        Self {
+            capacity,
+            tokens: capacity,
+            refill_per_sec,
+            updated_at: now,
+        }
+    }
+
+    fn refill(&mut self, now: Instant) {
+        let elapsed = now.saturating_duration_since(self.updated_at).as_secs_f64();
+        self.tokens = (self.tokens + elapsed * self.refill_per_sec).min(self.capacity);
+        self.updated_at = now;
+    }
+
+    /// How long until a token is available
+    pub fn wait_time(&mut self, now: Instant) -> Duration {
+        self.refill(now);
+        if self.tokens >= 1.0 {
+            Duration::ZERO
+        } else {
+            Duration::from_secs_f64((1.0 - self.tokens) / self.refill_per_sec)
+        }
+    }
+
+    /// Take a token, which must be available
+    pub fn take(&mut self, now: Instant) {
+        self.refill(now);
+        // Sleeps may end a hair early; never owe more than one token
+        self.tokens = (self.tokens - 1.0).max(-1.0);
+    }
+}
+
+/// Rate limiter enforcing both AniDB limits
+pub struct RateLimiter {
+    /// Turn to send next, granted by priority
+    turn: Arc<PrioritySemaphore>,
+    /// Short and long term buckets, locked together
+    buckets: Mutex<[TokenBucket; 2]>,
+    /// Packets waiting for their turn
+    waiting: AtomicUsize,
+    /// Microseconds packets have spent waiting, in total
+    waited_us: AtomicU64,
+}
+
+impl RateLimiter {
+    /// Create a limiter with the AniDB limits
+    pub fn new() -> Self {
+        Self::with_limits(
+            crate::protocol::RATE_LIMIT_REQUESTS_PER_SECOND,
+            LONG_TERM_REQUESTS_PER_SECOND,
+            LONG_TERM_BURST,
+        )
+    }
+
+    /// Create a limiter with custom rates
+    pub fn with_limits(short_term_rate: f64, long_term_rate: f64, long_term_burst: f64) -> Self {
+        let now = Instant::now();
+        Self {
+            turn: Arc::new(PrioritySemaphore::new(1)),
+            buckets: Mutex::new([
+                TokenBucket::new(1.0, short_term_rate, now),
+                TokenBucket::new(long_term_burst, long_term_rate, now),
+            ]),
+            waiting: AtomicUsize::new(0),
+            waited_us: AtomicU64::new(0),
+        }
+    }
+
+    /// Number of packets currently waiting to be sent
+    pub fn waiting(&self) -> usize {
+        self.waiting.load(Ordering::Relaxed)
+    }
+
+    /// Time packets have spent waiting for the limiter, in total
+    pub fn total_wait(&self) -> Duration {
+        Duration::from_micros(self.waited_us.load(Ordering::Relaxed))
+    }
+
+    /// Wait until a packet may be sent and account for it
+    ///
+    /// Packets wait in order of the current task's [`Priority`].
+    pub async fn wait_if_needed(&self) {
+        let start = Instant::now();
+        // Also counts down when the caller gives up on the packet
+        let _waiting = Waiting::enter(&self.waiting);
+        let _turn = self.turn.acquire(Priority::current()).await;
+        let mut buckets = self.buckets.lock().await;
+
+        let now = Instant::now();
+        let wait = buckets
+            .iter_mut()
+            .map(|bucket| bucket.wait_time(now))
+            .max()
+            .unwrap_or_default();
+        if wait > Duration::ZERO {
+            debug!("Rate limiter: waiting {wait:?} to respect rate limit");
+            sleep(wait).await;
+        } else {
+            trace!("Rate limiter: no wait needed");
+        }
+
+        let now = Instant::now();
+        for bucket in buckets.iter_mut() {
+            bucket.take(now);
+        }
+        self.waited_us.fetch_add(
+            (now - start).as_micros().try_into().unwrap_or(u64::MAX),
+            Ordering::Relaxed,
+        );
+    }
+}
+
+/// Counts a packet as waiting until dropped
+struct Waiting<'a>(&'a AtomicUsize);
+
+impl<'a> Waiting<'a> {
+    fn enter(counter: &'a AtomicUsize) -> Self {
+        counter.fetch_add(1, Ordering::Relaxed);
+        Self(counter)
+    }
+}
+
+impl Drop for Waiting<'_> {
+    fn drop(&mut self) {
+        self.0.fetch_sub(1, Ordering::Relaxed);
+    }
+}
+
+impl Default for RateLimiter {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_token_bucket() {
+        let start = Instant::now();
+        let mut bucket = TokenBucket::new(2.0, 0.5, start);
+
+        assert_eq!(bucket.wait_time(start), Duration::ZERO);
+        bucket.take(start);
+        bucket.take(start);
+
+        // Empty: the next token arrives after 1 / 0.5 seconds
+        assert_eq!(bucket.wait_time(start), Duration::from_secs(2));
+        let later = start + Duration::from_secs(1);
+        assert_eq!(bucket.wait_time(later), Duration::from_secs(1));
+
+        // Refill never exceeds capacity
+        let much_later = start + Duration::from_secs(60);
+        bucket.take(much_later);
+        bucket.take(much_later);
+        assert!(bucket.wait_time(much_later) > Duration::ZERO);
+    }
+
+    #[test]
+    fn test_long_term_limit_takes_over() {
+        let start = Instant::now();
+        let mut short = TokenBucket::new(1.0, 0.5, start);
+        let mut long = TokenBucket::new(3.0, 0.25, start);
+
+        // Send as fast as both buckets allow and record the gaps
+        let mut now = start;
+        let mut gaps = Vec::new();
+        for _ in 0..8 {
+            let wait = short.wait_time(now).max(long.wait_time(now));
+            gaps.push(wait);
+            now += wait;
+            short.take(now);
+            long.take(now);
+        }
+
+        assert_eq!(gaps[0], Duration::ZERO);
+        assert_eq!(gaps[1], Duration::from_secs(2));
+        // Once the long term burst is spent packets go out every 4 seconds
+        let last = gaps.last().unwrap().as_secs_f64();
+        assert!((last - 4.0).abs() < 1e-6, "{gaps:?}");
+        assert!(
+            gaps.iter()
+                .skip(1)
+                .all(|gap| *gap >= Duration::from_secs(2))
+        );
+    }
+
+    #[tokio::test]
+    async fn test_interactive_packets_go_first() {
+        let limiter = Arc::new(RateLimiter::with_limits(100.0, 100.0, 10.0));
+        // Spend the short term token so everything below has to queue
+        limiter.wait_if_needed().await;
+
+        let order = Arc::new(std::sync::Mutex::new(Vec::new()));
+        let mut senders = Vec::new();
+        for priority in [
+            Priority::Background,
+            Priority::Background,
+            Priority::Interactive,
+        ] {
+            let limiter = limiter.clone();
+            let order = order.clone();
+            senders.push(tokio::spawn(priority.scope(async move {
+                limiter.wait_if_needed().await;
+                order.lock().unwrap().push(priority);
+            })));
+            tokio::task::yield_now().await;
+        }
+        for sender in senders {
+            sender.await.unwrap();
+        }
+
+        // The first background packet already holds the turn
+        assert_eq!(
+            *order.lock().unwrap(),
+            vec![
+                Priority::Background,
+                Priority::Interactive,
+                Priority::Background
+            ]
+        );
+        assert_eq!(limiter.waiting(), 0);
+    }
+}
@@ -0,0 +1,787 @@
+//! Device-aware scheduling of file work
+//!
+//! Libraries often span several disks. Reading many files at once from one
+//! rotational disk makes it seek between them, while reading one file at a
+//! time leaves the other disks idle. The scheduler therefore groups work by
+//! the device that stores each file and serves every device with a small
+//! number of sequential readers. The number is bounded by a [`ReaderGate`]
+//! per device, which [`crate::tuning`] adjusts while a batch runs when auto
+//! tuning is enabled.
+//!
+//! Hashing behind those readers is bounded separately by a [`CpuPool`]
+//! shared by every pipeline in the process. A reader only holds a CPU slot
+//! while its chunk is being hashed, never while it waits on the disk, so
+//! adding disks adds read parallelism without oversubscribing the cores.
+//!
+//! Work also carries a [`Priority`]. Hashing slots and other contended
+//! resources built on [`PrioritySemaphore`] are granted to the highest
+//! priority waiter first, and background pipelines step aside at chunk
+//! boundaries while interactive work is running, so a file a user is
+//! waiting on is not stuck behind a library scan.
+
+use std::collections::{HashMap, VecDeque};
+use std::future::Future;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex, OnceLock, PoisonError};
+use std::time::{Duration, Instant};
+use tokio::sync::{Notify, oneshot};
+use tokio::task::JoinSet;
+use tokio::task::futures::TaskLocalFuture;
+
+/// Maximum number of files read concurrently from a single device
+///
+/// Sequential throughput on rotational disks collapses when more than a
+/// couple of streams compete for the head, and SSDs gain little beyond it
+/// since hashing is CPU bound at that point.
+pub const MAX_READERS_PER_DEVICE: usize = 2;
+
+/// Longest a background pipeline waits for interactive work per chunk
+///
+/// Bounded so that background work still trickles along, and keeps its
+/// files open for a sane amount of time, under sustained interactive load.
+pub const MAX_BACKGROUND_YIELD: Duration = Duration::from_millis(50);
+
+/// Scheduling class of a unit of work
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Default)]
+pub enum Priority {
+    /// Bulk work such as library scans, which yields to everything else
+    Background,
+    /// Regular work
+    #[default]
+    Normal,
+    /// Work a user is actively waiting on
+    Interactive,
+}
+
+tokio::task_local! {
+    static CURRENT_PRIORITY: Priority;
+}
+
+impl Priority {
+    const COUNT: usize = 3;
+
+    /// Priority of the current task, [`Priority::Normal`] outside a scope
+    pub fn current() -> Priority {
+        CURRENT_PRIORITY
+            .try_with(|priority| *priority)
+            .unwrap_or_default()
+    }
+
+    /// Run `future` with this priority
+    ///
+    /// The priority does not carry over to tasks spawned by `future`, which
+    /// need a scope of their own.
+    pub fn scope<F: Future>(self, future: F) -> TaskLocalFuture<Priority, F> {
+        CURRENT_PRIORITY.scope(self, future)
+    }
+
+    fn index(self) -> usize {
+        self as usize
+    }
+}
+
+/// Semaphore granting permits to the highest priority waiter first
+///
+/// Waiters of the same priority are served in arrival order. Priorities are
+/// strict: lower priority waiters only get a permit once no higher priority
+/// one is queued.
+#[derive(Debug)]
+pub struct PrioritySemaphore {
+    state: Mutex<SemaphoreState>,
+}
+
+#[derive(Debug)]
+struct SemaphoreState {
+    available: usize,
+    waiters: [VecDeque<oneshot::Sender<()>>; Priority::COUNT],
+}
+
+impl PrioritySemaphore {
+    /// Create a semaphore with `permits` permits
+    pub fn new(permits: usize) -> Self {
+        Self {
+            state: Mutex::new(SemaphoreState {
+                available: permits,
+                waiters: Default::default(),
+            }),
+        }
+    }
+
+    /// Number of permits not currently held
+    pub fn available(&self) -> usize {
+        self.lock().available
+    }
+
+    /// Wait for a permit, released when the returned guard is dropped
+    pub async fn acquire(self: &Arc<Self>, priority: Priority) -> PriorityPermit {
+        let receiver = {
+            let mut state = self.lock();
+            if state.available > 0 {
+                state.available -= 1;
+                return PriorityPermit {
+                    semaphore: self.clone(),
+                };
+            }
+            let (sender, receiver) = oneshot::channel();
+            state.waiters[priority.index()].push_back(sender);
+            receiver
+        };
+
+        let mut pending = PendingGrant {
+            semaphore: self,
+            receiver,
+            granted: false,
+        };
+        (&mut pending.receiver)
+            .await
+            .expect("waiters are only dropped after a grant or a close");
+        pending.granted = true;
+        PriorityPermit {
+            semaphore: self.clone(),
+        }
+    }
+
+    /// Hand a returned permit to the next live waiter
+    fn release(&self) {
+        let mut state = self.lock();
+        for queue in state.waiters.iter_mut().rev() {
+            while let Some(waiter) = queue.pop_front() {
+                if waiter.send(()).is_ok() {
+                    return;
+                }
+            }
+        }
+        state.available += 1;
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, SemaphoreState> {
+        self.state.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+}
+
+/// Permit of a [`PrioritySemaphore`]
+#[derive(Debug)]
+pub struct PriorityPermit {
+    semaphore: Arc<PrioritySemaphore>,
+}
+
+impl Drop for PriorityPermit {
+    fn drop(&mut self) {
+        self.semaphore.release();
+    }
+}
+
+/// Returns a permit granted to a waiter that gave up before seeing it
+struct PendingGrant<'a> {
+    semaphore: &'a PrioritySemaphore,
+    receiver: oneshot::Receiver<()>,
+    granted: bool,
+}
+
+impl Drop for PendingGrant<'_> {
+    fn drop(&mut self) {
+        if self.granted {
+            return;
+        }
+        self.receiver.close();
+        if self.receiver.try_recv().is_ok() {
+            self.semaphore.release();
+        }
+    }
+}
+
+static INTERACTIVE_ACTIVE: AtomicUsize = AtomicUsize::new(0);
+
+fn interactive_idle() -> &'static Notify {
+    static IDLE: OnceLock<Notify> = OnceLock::new();
+    IDLE.get_or_init(Notify::new)
+}
+
+/// Marks interactive work as running until dropped
+#[derive(Debug)]
+pub struct InteractiveGuard(());
+
+impl InteractiveGuard {
+    /// Enter when the current task is [`Priority::Interactive`]
+    pub fn enter() -> Option<Self> {
+        (Priority::current() == Priority::Interactive).then(|| {
+            INTERACTIVE_ACTIVE.fetch_add(1, Ordering::AcqRel);
+            Self(())
+        })
+    }
+}
+
+impl Drop for InteractiveGuard {
+    fn drop(&mut self) {
+        if INTERACTIVE_ACTIVE.fetch_sub(1, Ordering::AcqRel) == 1 {
+            interactive_idle().notify_waiters();
+        }
+    }
+}
+
+/// Let interactive work run before a background task's next chunk
+///
+/// Returns at once for other priorities or when nothing interactive is
+/// running, and otherwise waits for it to finish, for at most
+/// [`MAX_BACKGROUND_YIELD`].
+pub async fn yield_to_interactive() {
+    if Priority::current() != Priority::Background
+        || INTERACTIVE_ACTIVE.load(Ordering::Acquire) == 0
+    {
+        return;
+    }
+
+    let idle = async {
+        loop {
+            let notified = interactive_idle().notified();
+            tokio::pin!(notified);
+            notified.as_mut().enable();
+            if INTERACTIVE_ACTIVE.load(Ordering::Acquire) == 0 {
+                return;
+            }
+            notified.await;
+        }
+    };
+    let _ = tokio::time::timeout(MAX_BACKGROUND_YIELD, idle).await;
+}
+
+/// Process-wide pool bounding how many chunks are hashed at once
+///
+/// Slots go to the highest [`Priority`] waiting for one.
+#[derive(Debug)]
+pub struct CpuPool {
+    permits: Arc<PrioritySemaphore>,
+    size: usize,
+}
+
+impl CpuPool {
+    /// Create a pool with `size` concurrent hashing slots
+    pub fn new(size: usize) -> Self {
+        let size = size.max(1);
+        Self {
+            permits: Arc::new(PrioritySemaphore::new(size)),
+            size,
+        }
+    }
+
+    /// Shared pool sized to the available parallelism
+    pub fn global() -> Arc<CpuPool> {
+        static GLOBAL: OnceLock<Arc<CpuPool>> = OnceLock::new();
+        GLOBAL
+            .get_or_init(|| {
+                let cores = std::thread::available_parallelism()
+                    .map(|n| n.get())
+                    .unwrap_or(1);
+                Arc::new(CpuPool::new(cores))
+            })
+            .clone()
+    }
+
+    /// Number of concurrent hashing slots
+    pub fn size(&self) -> usize {
+        self.size
+    }
+
+    /// Number of slots not currently in use
+    pub fn available(&self) -> usize {
+        self.permits.available()
+    }
+
+    /// Wait for a hashing slot at the current task's priority, released
+    /// when the permit is dropped
+    pub async fn acquire(&self) -> PriorityPermit {
+        self.acquire_at(Priority::current()).await
+    }
+
+    /// Wait for a hashing slot at `priority`
+    ///
+    /// For threads working on behalf of a task, which do not see the
+    /// task's priority themselves.
+    pub async fn acquire_at(&self, priority: Priority) -> PriorityPermit {
+        self.permits.acquire(priority).await
+    }
+}
+
+/// Live counters for the files scheduled on one device
+#[derive(Debug)]
+pub struct DeviceStats {
+    device: u64,
+    /// Grows while a directory scan is still discovering files
+    files_total: AtomicUsize,
+    files_completed: AtomicUsize,
+    bytes_processed: AtomicU64,
+    started_at: OnceLock<Instant>,
+    /// Nanoseconds from the first start to the latest completion
+    active_nanos: AtomicU64,
+}
+
+impl DeviceStats {
+    /// Create counters for `files_total` files on `device`
+    pub fn new(device: u64, files_total: usize) -> Self {
+        Self {
+            device,
+            files_total: AtomicUsize::new(files_total),
+            files_completed: AtomicUsize::new(0),
+            bytes_processed: AtomicU64::new(0),
+            started_at: OnceLock::new(),
+            active_nanos: AtomicU64::new(0),
+        }
+    }
+
+    /// Device identifier, see [`crate::platform::device_id`]
+    pub fn device(&self) -> u64 {
+        self.device
+    }
+
+    /// Count a file scheduled after the device's counters were created
+    pub fn add_file(&self) {
+        self.files_total.fetch_add(1, Ordering::Release);
+    }
+
+    /// Mark the start of work on this device; later calls are ignored
+    pub fn start(&self) {
+        self.started_at.get_or_init(Instant::now);
+    }
+
+    /// Record a finished file and the bytes read for it
+    pub fn complete_file(&self, bytes: u64) {
+        self.bytes_processed.fetch_add(bytes, Ordering::Relaxed);
+        if let Some(started) = self.started_at.get() {
+            let nanos = started.elapsed().as_nanos().min(u64::MAX as u128) as u64;
+            self.active_nanos.fetch_max(nanos, Ordering::Relaxed);
+        }
+        self.files_completed.fetch_add(1, Ordering::Release);
+    }
+
+    /// Read the current counters
+    ///
+    /// Throughput covers the time from the first file starting until now,
+    /// or until the last file finished once the device is done.
+    pub fn snapshot(&self) -> DeviceStatsSnapshot {
+        let files_total = self.files_total.load(Ordering::Acquire);
+        let files_completed = self.files_completed.load(Ordering::Acquire);
+        let bytes_processed = self.bytes_processed.load(Ordering::Relaxed);
+
+        let seconds = match self.started_at.get() {
+            Some(_) if files_completed >= files_total => {
+                self.active_nanos.load(Ordering::Relaxed) as f64 / 1e9
+            }
+            Some(started) => started.elapsed().as_secs_f64(),
+            None => 0.0,
+        };
+        let throughput_mbps = if seconds > 0.0 {
+            bytes_processed as f64 / seconds / (1024.0 * 1024.0)
+        } else {
+            0.0
+        };
+
+        DeviceStatsSnapshot {
+            device: self.device,
+            files_total,
+            files_completed,
+            bytes_processed,
+            throughput_mbps,
+        }
+    }
+}
+
+/// Point-in-time view of a device's progress
+#[derive(Debug, Clone, PartialEq)]
+pub struct DeviceStatsSnapshot {
+    pub device: u64,
+    pub files_total: usize,
+    pub files_completed: usize,
+    pub bytes_processed: u64,
+    pub throughput_mbps: f64,
+}
+
+/// Jobs waiting for one device's readers
+#[derive(Debug)]
+pub struct DeviceQueue<J> {
+    stats: Arc<DeviceStats>,
+    jobs: Mutex<VecDeque<J>>,
+}
+
+impl<J> DeviceQueue<J> {
+    /// Counters for this device
+    pub fn stats(&self) -> &Arc<DeviceStats> {
+        &self.stats
+    }
+
+    /// Number of jobs not yet taken by a reader
+    pub fn len(&self) -> usize {
+        self.jobs.lock().map(|q| q.len()).unwrap_or(0)
+    }
+
+    /// Whether every job has been taken
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Iterate over the queued jobs in order
+    pub fn with_jobs<R>(&self, f: impl FnOnce(&VecDeque<J>) -> R) -> R {
+        let jobs = self.jobs.lock().unwrap_or_else(|e| e.into_inner());
+        f(&jobs)
+    }
+
+    fn pop(&self) -> Option<J> {
+        self.jobs.lock().ok()?.pop_front()
+    }
+}
+
+/// Group jobs into per-device queues
+///
+/// Devices are ordered by their first job and jobs keep their input order
+/// within each device.
+pub fn group_by_device<J>(jobs: impl IntoIterator<Item = (u64, J)>) -> Vec<DeviceQueue<J>> {
+    let mut order: Vec<u64> = Vec::new();
+    let mut queues: HashMap<u64, VecDeque<J>> = HashMap::new();
+    for (device, job) in jobs {
+        queues
+            .entry(device)
+            .or_insert_with(|| {
+                order.push(device);
+                VecDeque::new()
+            })
+            .push_back(job);
+    }
+
+    order
+        .into_iter()
+        .filter_map(|device| {
+            let jobs = queues.remove(&device)?;
+            Some(DeviceQueue {
+                stats: Arc::new(DeviceStats::new(device, jobs.len())),
+                jobs: Mutex::new(jobs),
+            })
+        })
+        .collect()
+}
+
+/// Bound on a device's active readers that may change while they run
+///
+/// Readers take a permit before each job. Lowering the limit lets the
+/// readers above it finish their current job and then wait; raising it
+/// wakes them again, up to the `max` readers spawned for the device.
+#[derive(Debug)]
+pub struct ReaderGate {
+    max: usize,
+    state: Mutex<GateState>,
+    released: Notify,
+}
+
+#[derive(Debug)]
+struct GateState {
+    limit: usize,
+    active: usize,
+}
+
+impl ReaderGate {
+    /// Gate admitting `limit` readers, adjustable up to `max`
+    pub fn new(limit: usize, max: usize) -> Self {
+        let max = max.max(1);
+        Self {
+            max,
+            state: Mutex::new(GateState {
+                limit: limit.clamp(1, max),
+                active: 0,
+            }),
+            released: Notify::new(),
+        }
+    }
+
+    /// Gate that always admits `limit` readers
+    pub fn fixed(limit: usize) -> Self {
+        Self::new(limit, limit)
+    }
+
+    /// Most readers the limit may ever allow
+    pub fn max(&self) -> usize {
+        self.max
+    }
+
+    /// Readers currently allowed at once
+    pub fn limit(&self) -> usize {
+        self.lock().limit
+    }
+
+    /// Change the number of readers allowed, clamped to `1..=max`
+    pub fn set_limit(&self, limit: usize) {
+        self.lock().limit = limit.clamp(1, self.max);
+        self.released.notify_waiters();
+    }
+
+    /// Wait until fewer than `limit` readers hold a permit
+    pub async fn acquire(self: &Arc<Self>) -> ReaderPermit {
+        loop {
+            let released = self.released.notified();
+            tokio::pin!(released);
+            released.as_mut().enable();
+            {
+                let mut state = self.lock();
+                if state.active < state.limit {
+                    state.active += 1;
+                    return ReaderPermit(self.clone());
+                }
+            }
+            released.await;
+        }
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, GateState> {
+        self.state.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+}
+
+/// Permit of a [`ReaderGate`]
+#[derive(Debug)]
+pub struct ReaderPermit(Arc<ReaderGate>);
+
+impl Drop for ReaderPermit {
+    fn drop(&mut self) {
+        self.0.lock().active -= 1;
+        self.0.released.notify_waiters();
+    }
+}
+
+/// Run every queue with the readers its device's gate allows
+///
+/// `gate` is asked once per device. Up to the gate's `max` readers are
+/// spawned; each takes a permit, then one job from its device's queue, and
+/// awaits `worker` for it, so a device never has more files open than the
+/// gate's current limit. Returns once all queues are drained.
+pub async fn run_device_queues<J, G, F, Fut>(queues: Vec<Arc<DeviceQueue<J>>>, gate: G, worker: F)
+where
+    J: Send + 'static,
+    G: Fn(u64) -> Arc<ReaderGate>,
+    F: Fn(J, Arc<DeviceStats>) -> Fut + Clone + Send + 'static,
+    Fut: Future<Output = ()> + Send + 'static,
+{
+    let mut readers = JoinSet::new();
+
+    for queue in queues {
+        let gate = gate(queue.stats.device());
+        let reader_count = gate.max().min(queue.len());
+        for _ in 0..reader_count {
+            let queue = queue.clone();
+            let gate = gate.clone();
+            let worker = worker.clone();
+            readers.spawn(async move {
+                loop {
+                    let _permit = gate.acquire().await;
+                    let Some(job) = queue.pop() else {
+                        break;
+                    };
+                    worker(job, queue.stats.clone()).await;
+                }
+            });
+        }
+    }
+
+    while readers.join_next().await.is_some() {}
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::AtomicBool;
+
+    #[test]
+    fn test_group_by_device_keeps_order() {
+        let queues = group_by_device([(7, 'a'), (3, 'b'), (7, 'c'), (3, 'd'), (9, 'e')]);
+
+        let devices: Vec<u64> = queues.iter().map(|q| q.stats().device()).collect();
+        assert_eq!(devices, vec![7, 3, 9]);
+        let first: Vec<char> = queues[0].with_jobs(|jobs| jobs.iter().copied().collect());
+        assert_eq!(first, vec!['a', 'c']);
+        assert_eq!(queues[0].stats().snapshot().files_total, 2);
+    }
+
+    #[tokio::test(flavor = "multi_thread", worker_threads = 4)]
+    async fn test_readers_per_device_are_bounded() {
+        let queues: Vec<_> = group_by_device((0..12u64).map(|i| (i % 3, i)))
+            .into_iter()
+            .map(Arc::new)
+            .collect();
+        let stats: Vec<_> = queues.iter().map(|q| q.stats().clone()).collect();
+
+        // Active readers per device, and whether any device exceeded the bound
+        let active: Arc<Vec<AtomicUsize>> = Arc::new((0..3).map(|_| AtomicUsize::new(0)).collect());
+        let exceeded = Arc::new(AtomicBool::new(false));
+
+        let worker_active = active.clone();
+        let worker_exceeded = exceeded.clone();
+        run_device_queues(
+            queues,
+            |_| Arc::new(ReaderGate::fixed(2)),
+            move |_job, stats| {
+                let active = worker_active.clone();
+                let exceeded = worker_exceeded.clone();
+                async move {
+                    stats.start();
+                    let slot = &active[stats.device() as usize];
+                    if slot.fetch_add(1, Ordering::SeqCst) >= 2 {
+                        exceeded.store(true, Ordering::SeqCst);
+                    }
+                    tokio::time::sleep(Duration::from_millis(5)).await;
+                    slot.fetch_sub(1, Ordering::SeqCst);
+                    stats.complete_file(1024);
+                }
+            },
+        )
+        .await;
+
+        assert!(!exceeded.load(Ordering::SeqCst));
+        for stats in stats {
+            let snapshot = stats.snapshot();
+            assert_eq!(snapshot.files_completed, 4);
+            assert_eq!(snapshot.bytes_processed, 4096);
+            assert!(snapshot.throughput_mbps > 0.0);
+        }
+    }
+
+    #[tokio::test(flavor = "multi_thread", worker_threads = 4)]
+    async fn test_reader_gate_limit_changes_while_running() {
+        let queues: Vec<_> = group_by_device((0..12u64).map(|i| (0, i)))
+            .into_iter()
+            .map(Arc::new)
+            .collect();
+        let gate = Arc::new(ReaderGate::new(1, 3));
+
+        let active = Arc::new(AtomicUsize::new(0));
+        let peak = Arc::new(AtomicUsize::new(0));
+        let exceeded = Arc::new(AtomicBool::new(false));
+
+        let queue_gate = gate.clone();
+        let worker_gate = gate.clone();
+        let worker_peak = peak.clone();
+        let worker_exceeded = exceeded.clone();
+        run_device_queues(
+            queues,
+            move |_| queue_gate.clone(),
+            move |job, _stats| {
+                let gate = worker_gate.clone();
+                let active = active.clone();
+                let peak = worker_peak.clone();
+                let exceeded = worker_exceeded.clone();
+                async move {
+                    let now = active.fetch_add(1, Ordering::SeqCst) + 1;
+                    peak.fetch_max(now, Ordering::SeqCst);
+                    if now > gate.limit() {
+                        exceeded.store(true, Ordering::SeqCst);
+                    }
+                    if job == 2 {
+                        gate.set_limit(3);
+                    }
+                    tokio::time::sleep(Duration::from_millis(10)).await;
+                    active.fetch_sub(1, Ordering::SeqCst);
+                }
+            },
+        )
+        .await;
+
+        assert!(!exceeded.load(Ordering::SeqCst));
+        assert_eq!(peak.load(Ordering::SeqCst), 3);
+        assert_eq!(gate.limit(), 3);
+        gate.set_limit(10);
+        assert_eq!(gate.limit(), 3, "clamped to the readers spawned");
+    }
+
+    #[tokio::test]
+    async fn test_cpu_pool_limits_slots() {
+        let pool = CpuPool::new(2);
+        let first = pool.acquire().await;
+        let _second = pool.acquire().await;
+        assert_eq!(pool.available(), 0);
+
+        drop(first);
+        assert_eq!(pool.available(), 1);
+        assert!(CpuPool::global().size() >= 1);
+    }
+
+    #[tokio::test]
+    async fn test_priority_semaphore_serves_higher_priority_first() {
+        let semaphore = Arc::new(PrioritySemaphore::new(1));
+        let held = semaphore.acquire(Priority::Normal).await;
+        let order = Arc::new(Mutex::new(Vec::new()));
+
+        // Queue background first, then normal, then interactive
+        let mut waiters = Vec::new();
+        for priority in [
+            Priority::Background,
+            Priority::Normal,
+            Priority::Interactive,
+        ] {
+            let semaphore = semaphore.clone();
+            let order = order.clone();
+            waiters.push(tokio::spawn(async move {
+                let _permit = semaphore.acquire(priority).await;
+                order.lock().unwrap().push(priority);
+            }));
+            tokio::task::yield_now().await;
+        }
+
+        drop(held);
+        for waiter in waiters {
+            waiter.await.unwrap();
+        }
+        assert_eq!(
+            *order.lock().unwrap(),
+            vec![
+                Priority::Interactive,
+                Priority::Normal,
+                Priority::Background
+            ]
+        );
+        assert_eq!(semaphore.available(), 1);
+    }
+
+    #[tokio::test]
+    async fn test_priority_semaphore_abandoned_waiter_returns_permit() {
+        let semaphore = Arc::new(PrioritySemaphore::new(1));
+        let held = semaphore.acquire(Priority::Normal).await;
+
+        let abandoned = tokio::time::timeout(
+            Duration::from_millis(10),
+            semaphore.acquire(Priority::Interactive),
+        )
+        .await;
+        assert!(abandoned.is_err());
+
+        drop(held);
+        assert_eq!(semaphore.available(), 1);
+        let _permit = semaphore.acquire(Priority::Background).await;
+        assert_eq!(semaphore.available(), 0);
+    }
+
+    #[tokio::test]
+    async fn test_priority_scope_and_background_yield() {
+        assert_eq!(Priority::current(), Priority::Normal);
+        assert!(InteractiveGuard::enter().is_none());
+
+        let guard = Priority::Interactive
+            .scope(async { InteractiveGuard::enter() })
+            .await;
+        assert!(guard.is_some());
+
+        // A background task waits for the interactive work to finish
+        let background = tokio::spawn(Priority::Background.scope(async {
+            assert_eq!(Priority::current(), Priority::Background);
+            let start = Instant::now();
+            yield_to_interactive().await;
+            start.elapsed()
+        }));
+        tokio::time::sleep(Duration::from_millis(5)).await;
+        drop(guard);
+        let waited = background.await.unwrap();
+        assert!(waited <= MAX_BACKGROUND_YIELD + Duration::from_millis(20));
+
+        // Other priorities never wait
+        let _guard = Priority::Interactive
+            .scope(async { InteractiveGuard::enter() })
+            .await;
+        let start = Instant::now();
+        yield_to_interactive().await;
+        assert!(start.elapsed() < MAX_BACKGROUND_YIELD);
+    }
+}
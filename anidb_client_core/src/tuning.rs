@@ -0,0 +1,734 @@
+//! Feedback-driven tuning of read sizes and concurrency
+//!
+//! The best chunk size and number of readers per device depend on the
+//! storage: an NVMe drive wants several large reads in flight, a rotational
+//! disk wants one sequential stream, and a network share wants big requests
+//! to hide its latency. With [`ClientConfig::auto_tune`] set, an
+//! [`AutoTuner`] picks these values from what it observes instead of taking
+//! them from the configuration as they are.
+//!
+//! Completed files are grouped into windows. At the end of each window the
+//! tuner compares the window's throughput with the one before and keeps or
+//! reverts its last change, hill climbing one setting at a time:
+//!
+//! - the chunk size read per pipeline step, doubled or halved, probed while
+//!   reads take a meaningful share of the time spent on each file. Files
+//!   hashed with ED2K read whole ED2K chunks, one more or less per step,
+//!   which their hasher consumes without copying;
+//! - the depth of the queues feeding the parallel hashing workers, probed
+//!   while files hashed with several algorithms wait on those workers;
+//! - the number of readers of each device, tuned from that device's own
+//!   throughput.
+//!
+//! A change that does not gain [`MIN_GAIN`] is reverted and the setting
+//! rests for [`REST_WINDOWS`] windows before it is probed again, so the
+//! values follow a workload that drifts without oscillating on a steady one.
+//! Read sizes and queue depth are bounded so the buffers of every file in
+//! flight stay within half of `max_memory_usage`. ED2K files fall back to
+//! the plain chunk size when a single ED2K chunk does not fit.
+
+use crate::ClientConfig;
+use crate::file_io::FileProcessingResult;
+use crate::hashing::{ED2K_CHUNK_SIZE, HashAlgorithm};
+use crate::pipeline::DEFAULT_QUEUE_DEPTH;
+use crate::scheduler::{MAX_READERS_PER_DEVICE, ReaderGate};
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex, PoisonError};
+use std::time::{Duration, Instant};
+
+/// Smallest chunk size the tuner picks
+pub const MIN_TUNED_CHUNK_SIZE: usize = 64 * 1024;
+
+/// Largest chunk size the tuner picks
+pub const MAX_TUNED_CHUNK_SIZE: usize = 16 * 1024 * 1024;
+
+/// Most ED2K chunks the tuner reads per pipeline step
+pub const MAX_TUNED_ED2K_CHUNKS: usize = 4;
+
+/// Deepest hashing worker queue the tuner picks
+pub const MAX_TUNED_QUEUE_DEPTH: usize = 8;
+
+/// Most readers per device the tuner allows
+///
+/// Also bounded by `max_concurrent_files`.
+pub const MAX_TUNED_READERS: usize = 8;
+
+/// Relative throughput gain a change must bring to be kept
+pub const MIN_GAIN: f64 = 0.05;
+
+/// Windows a setting rests after a reverted change
+pub const REST_WINDOWS: u32 = 4;
+
+/// Files completed per tuning window
+const WINDOW_FILES: usize = 8;
+
+/// Files completed per device window
+const DEVICE_WINDOW_FILES: usize = 4;
+
+/// Bytes that close a window early, so large files are not judged over
+/// many gigabytes
+const WINDOW_BYTES: u64 = 512 * 1024 * 1024;
+
+/// Fewest files a window is judged on
+const MIN_WINDOW_FILES: usize = 2;
+
+/// A file starting this long after the previous completion follows an idle
+/// spell, which would read as low throughput, so the open window is dropped
+const IDLE_RESET: Duration = Duration::from_secs(1);
+
+/// Share of the time spent reading above which larger chunks are probed
+const READ_BOUND_SHARE: f64 = 0.25;
+
+/// Share of the time multi-algorithm files wait on hashing workers above
+/// which deeper queues are probed
+const BACKPRESSURE_SHARE: f64 = 0.05;
+
+/// Values in use for file processing
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct TunedValues {
+    /// Bytes read per pipeline step, by the file started last once any has
+    pub chunk_size: usize,
+    /// Chunks queued for each parallel hashing worker
+    pub queue_depth: usize,
+    /// Readers per device; the highest limit when devices differ
+    pub readers_per_device: usize,
+}
+
+impl TunedValues {
+    /// Values used as configured, without tuning
+    pub fn from_config(config: &ClientConfig) -> Self {
+        Self {
+            chunk_size: config.chunk_size,
+            queue_depth: DEFAULT_QUEUE_DEPTH,
+            readers_per_device: config.max_concurrent_files.clamp(1, MAX_READERS_PER_DEVICE),
+        }
+    }
+}
+
+/// Picks chunk size, queue depth and readers per device from throughput
+#[derive(Debug)]
+pub struct AutoTuner {
+    /// Bytes the buffers of all files in flight may take
+    memory_budget: usize,
+    /// Files in flight at once
+    max_files: usize,
+    initial_readers: usize,
+    max_readers: usize,
+    chunk_size: AtomicUsize,
+    ed2k_chunks: AtomicUsize,
+    queue_depth: AtomicUsize,
+    /// Whether files have read plain chunks and whole ED2K chunks, to
+    /// budget for the larger of the two
+    plain_reads: AtomicBool,
+    ed2k_reads: AtomicBool,
+    state: Mutex<TunerState>,
+}
+
+#[derive(Debug)]
+struct TunerState {
+    window: Window,
+    last_completion: Option<Instant>,
+    chunk: Climber,
+    /// ED2K chunks per read for files hashed with ED2K
+    ed2k: Climber,
+    depth: Climber,
+    /// Setting the last window was judged for
+    active: Knob,
+    devices: HashMap<u64, DeviceTuning>,
+}
+
+#[derive(Debug)]
+struct DeviceTuning {
+    gate: Arc<ReaderGate>,
+    readers: Climber,
+    window: Window,
+    last_completion: Option<Instant>,
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Knob {
+    Chunk,
+    Ed2kChunks,
+    Depth,
+}
+
+impl AutoTuner {
+    /// Start from the configured values, shrunk to fit the memory budget
+    pub fn new(config: &ClientConfig) -> Self {
+        let initial = TunedValues::from_config(config);
+        let memory_budget = config.max_memory_usage / 2;
+        let max_files = config.max_concurrent_files.max(1);
+
+        let mut chunk = Climber::new(
+            initial.chunk_size,
+            MIN_TUNED_CHUNK_SIZE,
+            MAX_TUNED_CHUNK_SIZE,
+            Step::Double,
+        );
+        let ed2k = Climber::new(1, 1, MAX_TUNED_ED2K_CHUNKS, Step::Add);
+        let depth = Climber::new(initial.queue_depth, 1, MAX_TUNED_QUEUE_DEPTH, Step::Add);
+        while chunk.value > chunk.min
+            && footprint(chunk.value, depth.value, max_files) > memory_budget
+        {
+            chunk.value /= 2;
+        }
+
+        Self {
+            memory_budget,
+            max_files,
+            initial_readers: initial.readers_per_device,
+            max_readers: config.max_concurrent_files.clamp(1, MAX_TUNED_READERS),
+            chunk_size: AtomicUsize::new(chunk.value),
+            ed2k_chunks: AtomicUsize::new(ed2k.value),
+            queue_depth: AtomicUsize::new(depth.value),
+            plain_reads: AtomicBool::new(false),
+            ed2k_reads: AtomicBool::new(false),
+            state: Mutex::new(TunerState {
+                window: Window::default(),
+                last_completion: None,
+                chunk,
+                ed2k,
+                depth,
+                active: Knob::Depth,
+                devices: HashMap::new(),
+            }),
+        }
+    }
+
+    /// Bytes to read per pipeline step for files hashed without ED2K
+    pub fn chunk_size(&self) -> usize {
+        self.chunk_size.load(Ordering::Relaxed)
+    }
+
+    /// Bytes to read per pipeline step for a file about to be hashed
+    ///
+    /// Files hashed with ED2K read whole ED2K chunks while one fits the
+    /// memory budget, and the plain chunk size otherwise.
+    pub fn read_size(&self, ed2k: bool) -> usize {
+        if ed2k {
+            let size = ed2k_read_size(self.ed2k_chunks.load(Ordering::Relaxed));
+            if footprint(size, self.queue_depth(), self.max_files) <= self.memory_budget {
+                self.ed2k_reads.store(true, Ordering::Relaxed);
+                return size;
+            }
+        }
+        self.plain_reads.store(true, Ordering::Relaxed);
+        self.chunk_size()
+    }
+
+    /// Chunks to queue for each parallel hashing worker
+    pub fn queue_depth(&self) -> usize {
+        self.queue_depth.load(Ordering::Relaxed)
+    }
+
+    /// Gate bounding the readers of `device`, adjusted as its files complete
+    pub fn reader_gate(&self, device: u64) -> Arc<ReaderGate> {
+        let mut state = self.lock();
+        self.device(&mut state, device).gate.clone()
+    }
+
+    /// Current values
+    pub fn snapshot(&self) -> TunedValues {
+        let readers_per_device = self
+            .lock()
+            .devices
+            .values()
+            .map(|device| device.gate.limit())
+            .max()
+            .unwrap_or(self.initial_readers);
+        TunedValues {
+            chunk_size: self.chunk_size(),
+            queue_depth: self.queue_depth(),
+            readers_per_device,
+        }
+    }
+
+    /// Feed a file read from `device`
+    ///
+    /// Files answered from the cache read nothing and are ignored.
+    pub fn record_file(&self, device: u64, result: &FileProcessingResult) {
+        let timings = &result.timings;
+        if timings.read.is_zero() && timings.hash.is_zero() {
+            return;
+        }
+        let now = Instant::now();
+        self.record(
+            now,
+            device,
+            Sample {
+                started: now.checked_sub(result.processing_time).unwrap_or(now),
+                bytes: result.file_size,
+                read: timings.read,
+                busy: timings.read + timings.hash + timings.pool_wait,
+                parallel_wait: (timings.hash_by_algorithm.len() > 1).then_some(timings.pool_wait),
+                ed2k: result.hashes.contains_key(&HashAlgorithm::ED2K),
+            },
+        );
+    }
+
+    fn record(&self, now: Instant, device: u64, sample: Sample) {
+        let mut state = self.lock();
+        let state = &mut *state;
+
+        let tuning = self.device(state, device);
+        if tuning.window.add(&sample, tuning.last_completion) {
+            tuning.last_completion = Some(now);
+            if tuning.window.is_full(DEVICE_WINDOW_FILES) {
+                let throughput = tuning.window.throughput(now);
+                tuning.window = Window::default();
+                tuning.readers.observe(throughput, |_| true);
+                tuning.gate.set_limit(tuning.readers.value);
+            }
+        }
+        // Readers are tuned per device, the other settings from the
+        // throughput of every device together
+
+        if !state.window.add(&sample, state.last_completion) {
+            return;
+        }
+        state.last_completion = Some(now);
+        if !state.window.is_full(WINDOW_FILES) {
+            return;
+        }
+        let window = std::mem::take(&mut state.window);
+        let throughput = window.throughput(now);
+
+        // Reads are tuned for the kind of file that dominated the window
+        let read_knob =
+            if window.ed2k_files * 2 > window.files && self.ed2k_reads.load(Ordering::Relaxed) {
+                Knob::Ed2kChunks
+            } else {
+                Knob::Chunk
+            };
+
+        // A change on trial is judged whatever the window looked like;
+        // otherwise take turns between the settings worth probing
+        let knob = if state.climber(state.active).trial.is_some() {
+            Some(state.active)
+        } else {
+            let others = match state.active {
+                Knob::Depth => [read_knob, Knob::Depth],
+                _ => [Knob::Depth, read_knob],
+            };
+            others.into_iter().find(|&knob| match knob {
+                Knob::Chunk | Knob::Ed2kChunks => window.read_share() >= READ_BOUND_SHARE,
+                Knob::Depth => window.backpressure_share() >= BACKPRESSURE_SHARE,
+            })
+        };
+        let Some(knob) = knob else {
+            return;
+        };
+
+        state.active = knob;
+        let (chunk, ed2k, depth) = (state.chunk.value, state.ed2k.value, state.depth.value);
+        let fits = |chunk, ed2k, depth| self.fits(chunk, ed2k, depth);
+        match knob {
+            Knob::Chunk => state
+                .chunk
+                .observe(throughput, |chunk| fits(chunk, ed2k, depth)),
+            Knob::Ed2kChunks => state
+                .ed2k
+                .observe(throughput, |ed2k| fits(chunk, ed2k, depth)),
+            Knob::Depth => state
+                .depth
+                .observe(throughput, |depth| fits(chunk, ed2k, depth)),
+        }
+        self.chunk_size.store(state.chunk.value, Ordering::Relaxed);
+        self.ed2k_chunks.store(state.ed2k.value, Ordering::Relaxed);
+        self.queue_depth.store(state.depth.value, Ordering::Relaxed);
+    }
+
+    /// Whether the buffers of every file in flight fit the memory budget,
+    /// counting only the kinds of reads files have made
+    fn fits(&self, chunk: usize, ed2k_chunks: usize, depth: usize) -> bool {
+        let plain = if self.plain_reads.load(Ordering::Relaxed) {
+            chunk
+        } else {
+            0
+        };
+        let ed2k = if self.ed2k_reads.load(Ordering::Relaxed) {
+            ed2k_read_size(ed2k_chunks)
+        } else {
+            0
+        };
+        footprint(plain.max(ed2k), depth, self.max_files) <= self.memory_budget
+    }
+
+    fn device<'a>(&self, state: &'a mut TunerState, device: u64) -> &'a mut DeviceTuning {
+        state.devices.entry(device).or_insert_with(|| DeviceTuning {
+            gate: Arc::new(ReaderGate::new(self.initial_readers, self.max_readers)),
+            readers: Climber::new(self.initial_readers, 1, self.max_readers, Step::Add),
+            window: Window::default(),
+            last_completion: None,
+        })
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, TunerState> {
+        self.state.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+}
+
+impl TunerState {
+    fn climber(&self, knob: Knob) -> &Climber {
+        match knob {
+            Knob::Chunk => &self.chunk,
+            Knob::Ed2kChunks => &self.ed2k,
+            Knob::Depth => &self.depth,
+        }
+    }
+}
+
+/// Bytes read per pipeline step when reading `chunks` ED2K chunks
+fn ed2k_read_size(chunks: usize) -> usize {
+    chunks.saturating_mul(ED2K_CHUNK_SIZE as usize)
+}
+
+/// Bytes of chunk buffers `files` files may hold at once
+///
+/// Each file has the chunk being read plus up to `depth` chunks queued
+/// for its hashing workers.
+fn footprint(chunk_size: usize, depth: usize, files: usize) -> usize {
+    chunk_size.saturating_mul(depth + 1).saturating_mul(files)
+}
+
+/// What one file contributes to a window
+#[derive(Debug, Clone, Copy)]
+struct Sample {
+    started: Instant,
+    bytes: u64,
+    read: Duration,
+    /// Reading, hashing and waiting for hashing together
+    busy: Duration,
+    /// Waiting for hashing, for files hashed by parallel workers
+    parallel_wait: Option<Duration>,
+    /// Whether the file was hashed with ED2K
+    ed2k: bool,
+}
+
+/// Files completed since a window opened
+#[derive(Debug, Default)]
+struct Window {
+    started: Option<Instant>,
+    files: usize,
+    ed2k_files: usize,
+    bytes: u64,
+    read: Duration,
+    busy: Duration,
+    parallel_busy: Duration,
+    parallel_wait: Duration,
+}
+
+impl Window {
+    /// Add a file, dropping what came before an idle spell
+    ///
+    /// Returns false for a file that saw no time at all.
+    fn add(&mut self, sample: &Sample, last_completion: Option<Instant>) -> bool {
+        if sample.busy.is_zero() {
+            return false;
+        }
+        if last_completion.is_some_and(|last| sample.started > last + IDLE_RESET) {
+            *self = Window::default();
+        }
+        self.started = Some(
+            self.started
+                .map_or(sample.started, |started| started.min(sample.started)),
+        );
+        self.files += 1;
+        self.ed2k_files += usize::from(sample.ed2k);
+        self.bytes += sample.bytes;
+        self.read += sample.read;
+        self.busy += sample.busy;
+        if let Some(wait) = sample.parallel_wait {
+            self.parallel_busy += sample.busy;
+            self.parallel_wait += wait;
+        }
+        true
+    }
+
+    fn is_full(&self, files: usize) -> bool {
+        self.files >= files || (self.files >= MIN_WINDOW_FILES && self.bytes >= WINDOW_BYTES)
+    }
+
+    /// Bytes per second from the first file starting until `now`
+    fn throughput(&self, now: Instant) -> f64 {
+        let seconds = self
+            .started
+            .map_or(0.0, |started| (now - started).as_secs_f64());
+        if seconds > 0.0 {
+            self.bytes as f64 / seconds
+        } else {
+            0.0
+        }
+    }
+
+    fn read_share(&self) -> f64 {
+        share(self.read, self.busy)
+    }
+
+    fn backpressure_share(&self) -> f64 {
+        share(self.parallel_wait, self.parallel_busy)
+    }
+}
+
+fn share(part: Duration, whole: Duration) -> f64 {
+    if whole.is_zero() {
+        0.0
+    } else {
+        part.as_secs_f64() / whole.as_secs_f64()
+    }
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Step {
+    Double,
+    Add,
+}
+
+/// Hill climbing over one setting
+#[derive(Debug)]
+struct Climber {
+    value: usize,
+    min: usize,
+    max: usize,
+    step: Step,
+    upward: bool,
+    /// Throughput measured before the change on trial
+    baseline: f64,
+    /// Value to return to if the change on trial does not pay off
+    trial: Option<usize>,
+    rest: u32,
+}
+
+impl Climber {
+    fn new(value: usize, min: usize, max: usize, step: Step) -> Self {
+        Self {
+            value: value.clamp(min, max),
+            min,
+            max,
+            step,
+            upward: true,
+            baseline: 0.0,
+            trial: None,
+            rest: 0,
+        }
+    }
+
+    /// Judge a window measured at the current value and pick the next one
+    ///
+    /// `fits` rejects values the memory budget cannot hold.
+    fn observe(&mut self, throughput: f64, fits: impl Fn(usize) -> bool) {
+        if let Some(previous) = self.trial.take() {
+            if throughput < self.baseline * (1.0 + MIN_GAIN) {
+                self.value = previous;
+                self.upward = !self.upward;
+                self.rest = REST_WINDOWS;
+                return;
+            }
+        } else if self.rest > 0 {
+            self.rest -= 1;
+            return;
+        }
+
+        self.baseline = throughput;
+        for upward in [self.upward, !self.upward] {
+            if let Some(next) = self.neighbour(upward).filter(|&next| fits(next)) {
+                self.upward = upward;
+                self.trial = Some(self.value);
+                self.value = next;
+                return;
+            }
+        }
+    }
+
+    fn neighbour(&self, upward: bool) -> Option<usize> {
+        let next = match (self.step, upward) {
+            (Step::Double, true) => self.value.checked_mul(2)?,
+            (Step::Double, false) => self.value / 2,
+            (Step::Add, true) => self.value + 1,
+            (Step::Add, false) => self.value.checked_sub(1)?,
+        };
+        (next != self.value && (self.min..=self.max).contains(&next)).then_some(next)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const MIB: usize = 1024 * 1024;
+
+    fn config(max_concurrent_files: usize, max_memory_usage: usize) -> ClientConfig {
+        ClientConfig {
+            max_concurrent_files,
+            chunk_size: 64 * 1024,
+            max_memory_usage,
+            auto_tune: true,
+            ..ClientConfig::default()
+        }
+    }
+
+    /// Feed `files` sequential files, hashed with ED2K when `ed2k` is set,
+    /// whose throughput in MiB/s `model` derives from the values in use
+    ///
+    /// Returns the largest chunk size used.
+    fn run(
+        tuner: &AutoTuner,
+        clock: &mut Instant,
+        files: usize,
+        read_share: f64,
+        ed2k: bool,
+        model: impl Fn(TunedValues) -> f64,
+    ) -> usize {
+        let mut largest_chunk = 0;
+        for _ in 0..files {
+            let bytes = 64 * MIB as u64;
+            let values = TunedValues {
+                chunk_size: tuner.read_size(ed2k),
+                ..tuner.snapshot()
+            };
+            largest_chunk = largest_chunk.max(values.chunk_size);
+            let mbps = model(values);
+            let elapsed = Duration::from_secs_f64(bytes as f64 / MIB as f64 / mbps);
+            let started = *clock;
+            *clock += elapsed;
+            tuner.record(
+                *clock,
+                0,
+                Sample {
+                    started,
+                    bytes,
+                    read: elapsed.mul_f64(read_share),
+                    busy: elapsed,
+                    parallel_wait: None,
+                    ed2k,
+                },
+            );
+        }
+        largest_chunk
+    }
+
+    #[test]
+    fn test_climber_settles_on_the_peak() {
+        let mut climber = Climber::new(1, 1, 8, Step::Add);
+        let model = |readers: usize| 100.0 - (readers as f64 - 5.0).powi(2) * 10.0;
+        for _ in 0..40 {
+            climber.observe(model(climber.value), |_| true);
+        }
+        // Periodic probes step off the peak for one window at most
+        assert!((4..=6).contains(&climber.value), "{climber:?}");
+        assert!(climber.trial.is_some() || climber.value == 5);
+    }
+
+    #[test]
+    fn test_chunks_grow_while_reads_dominate() {
+        let tuner = AutoTuner::new(&config(2, 500 * MIB));
+        let mut clock = Instant::now();
+
+        // Larger reads pay off up to 4 MiB
+        let model = |values: TunedValues| 50.0 * values.chunk_size.min(4 * MIB) as f64 / MIB as f64;
+        let largest = run(&tuner, &mut clock, 160, 0.8, false, model);
+
+        assert_eq!(largest, 8 * MIB, "probed one step past the gain");
+        let chunk_size = tuner.chunk_size();
+        assert!((2 * MIB..=8 * MIB).contains(&chunk_size), "{chunk_size}");
+        assert_eq!(tuner.queue_depth(), DEFAULT_QUEUE_DEPTH);
+    }
+
+    #[test]
+    fn test_cpu_bound_files_keep_the_chunk_size() {
+        let tuner = AutoTuner::new(&config(2, 500 * MIB));
+        let mut clock = Instant::now();
+
+        let largest = run(&tuner, &mut clock, 80, 0.1, false, |_| 100.0);
+        assert_eq!(largest, 64 * 1024);
+    }
+
+    #[test]
+    fn test_memory_budget_bounds_the_chunk_size() {
+        // Half of 48 MiB over 4 files with a chunk read and 2 queued each
+        let tuner = AutoTuner::new(&config(4, 48 * MIB));
+        let mut clock = Instant::now();
+
+        let largest = run(&tuner, &mut clock, 200, 0.9, false, |values| {
+            values.chunk_size as f64 / 1024.0
+        });
+        assert_eq!(largest, 2 * MIB);
+        assert!(footprint(largest, tuner.queue_depth(), 4) <= 24 * MIB);
+
+        // A configured chunk size beyond the budget starts smaller
+        let tuner = AutoTuner::new(&ClientConfig {
+            chunk_size: 8 * MIB,
+            ..config(4, 48 * MIB)
+        });
+        assert_eq!(tuner.chunk_size(), 2 * MIB);
+    }
+
+    #[test]
+    fn test_ed2k_files_read_whole_ed2k_chunks() {
+        let tuner = AutoTuner::new(&config(2, 500 * MIB));
+        let mut clock = Instant::now();
+        let ed2k_chunk = ED2K_CHUNK_SIZE as usize;
+
+        // Larger reads pay off up to two ED2K chunks
+        let model = |values: TunedValues| {
+            assert_eq!(values.chunk_size % ed2k_chunk, 0, "{}", values.chunk_size);
+            50.0 * values.chunk_size.min(2 * ed2k_chunk) as f64 / MIB as f64
+        };
+        let largest = run(&tuner, &mut clock, 160, 0.8, true, model);
+
+        assert_eq!(largest, 3 * ed2k_chunk, "probed one step past the gain");
+        let read_size = tuner.read_size(true);
+        assert!(
+            (ed2k_chunk..=3 * ed2k_chunk).contains(&read_size),
+            "{read_size}"
+        );
+        assert_eq!(tuner.chunk_size(), 64 * 1024, "plain reads left alone");
+    }
+
+    #[test]
+    fn test_ed2k_files_fall_back_within_small_budgets() {
+        // One ED2K chunk read and 2 queued for 4 files is over half of 48 MiB
+        let tuner = AutoTuner::new(&config(4, 48 * MIB));
+        let mut clock = Instant::now();
+
+        let largest = run(&tuner, &mut clock, 200, 0.9, true, |values| {
+            values.chunk_size as f64 / 1024.0
+        });
+        assert_eq!(largest, 2 * MIB);
+        assert_eq!(tuner.read_size(true), tuner.chunk_size());
+    }
+
+    #[test]
+    fn test_device_readers_follow_throughput() {
+        let tuner = AutoTuner::new(&config(8, 500 * MIB));
+        let gate = tuner.reader_gate(0);
+        assert_eq!(gate.limit(), MAX_READERS_PER_DEVICE);
+        assert_eq!(gate.max(), 8);
+
+        // The device scales up to 4 readers and degrades past them
+        let mut clock = Instant::now();
+        let model = |values: TunedValues| {
+            let readers = values.readers_per_device as f64;
+            100.0 * readers.min(4.0) - 20.0 * (readers - 4.0).max(0.0)
+        };
+        run(&tuner, &mut clock, 200, 0.1, false, model);
+
+        assert!((3..=5).contains(&gate.limit()), "{}", gate.limit());
+        assert_eq!(tuner.snapshot().readers_per_device, gate.limit());
+    }
+
+    #[test]
+    fn test_idle_spells_are_not_measured() {
+        let tuner = AutoTuner::new(&config(2, 500 * MIB));
+        let mut clock = Instant::now();
+
+        run(&tuner, &mut clock, 5, 0.8, false, |_| 100.0);
+        clock += Duration::from_secs(60);
+        run(&tuner, &mut clock, 3, 0.8, false, |_| 100.0);
+
+        let state = tuner.lock();
+        assert_eq!(state.window.files, 3, "window restarted after the gap");
+        assert_eq!(state.chunk.trial, None);
+    }
+}
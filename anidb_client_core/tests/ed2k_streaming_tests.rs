@@ -65,3 +65,29 @@ async fn test_ed2k_streaming_vs_bytes() {
         println!("\n✓ Hashes match - implementations are consistent");
     }
 }
+
+/// Buffers spanning many chunks take the multi-buffer MD4 path, which must
+/// agree with chunk-at-a-time streaming from a file
+#[tokio::test]
+async fn test_ed2k_multi_chunk_bytes_vs_streaming() {
+    let temp_dir = TempDir::new().unwrap();
+    let calculator = HashCalculator::new();
+    let chunk_size = 9_728_000;
+
+    // An exact multiple of the chunk size and one with a tail
+    for size in [8 * chunk_size, 9 * chunk_size + 1234] {
+        let data: Vec<u8> = (0..size).map(|i| (i % 251) as u8).collect();
+        let bytes_result = calculator
+            .calculate_bytes(HashAlgorithm::ED2K, &data)
+            .unwrap();
+
+        let file_path = temp_dir.path().join("multi_chunk.bin");
+        tokio::fs::write(&file_path, &data).await.unwrap();
+        let file_result = calculator
+            .calculate_file(&file_path, HashAlgorithm::ED2K)
+            .await
+            .unwrap();
+
+        assert_eq!(bytes_result.hash, file_result.hash, "size {size}");
+    }
+}
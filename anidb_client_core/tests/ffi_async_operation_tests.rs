@@ -0,0 +1,268 @@
+//! Async Operation Tests for FFI
+//!
+//! Tests `anidb_process_file_async` and the operation handle API: completion
+//! callbacks, blocking waits, result retrieval and cancellation.
+
+use anidb_client_core::ffi::{
+    ANIDB_ABI_VERSION, AniDBFileResult, AniDBHashAlgorithm, AniDBProcessOptions,
+    AniDBProgressSnapshot, AniDBResult, AniDBStatus, anidb_cleanup, anidb_client_create,
+    anidb_client_destroy, anidb_free_file_result, anidb_init, anidb_operation_cancel,
+    anidb_operation_destroy, anidb_operation_get_progress, anidb_operation_get_result,
+    anidb_operation_get_status, anidb_operation_set_callback, anidb_operation_wait,
+    anidb_process_file_async,
+};
+use std::ffi::{CStr, CString, c_void};
+use std::fs;
+use std::ptr;
+use std::sync::mpsc;
+use std::time::Duration;
+use tempfile::TempDir;
+
+fn create_client() -> *mut c_void {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
+    handle
+}
+
+fn start_operation(
+    client: *mut c_void,
+    path: &CString,
+    algorithms: &[AniDBHashAlgorithm],
+) -> *mut c_void {
+    let options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        ..Default::default()
+    };
+
+    let mut operation: *mut c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_process_file_async(client, path.as_ptr(), &options, &mut operation),
+        AniDBResult::Success
+    );
+    assert!(!operation.is_null());
+    operation
+}
+
+/// Test that the completion callback fires and the result can be fetched
+#[test]
+#[serial_test::serial]
+fn test_async_operation_completion_callback() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = temp_dir.path().join("async.mkv");
+    fs::write(&path, vec![0xCD; 512 * 1024]).unwrap();
+    let c_path = CString::new(path.to_str().unwrap()).unwrap();
+
+    let client = create_client();
+    let operation = start_operation(client, &c_path, &[AniDBHashAlgorithm::ED2K]);
+
+    extern "C" fn on_complete(op: *mut c_void, result: AniDBResult, user_data: *mut c_void) {
+        let tx = unsafe { &*(user_data as *const mpsc::Sender<(usize, AniDBResult)>) };
+        let _ = tx.send((op as usize, result));
+    }
+
+    let (tx, rx) = mpsc::channel::<(usize, AniDBResult)>();
+    assert_eq!(
+        anidb_operation_set_callback(operation, Some(on_complete), &tx as *const _ as *mut c_void),
+        AniDBResult::Success
+    );
+
+    let (completed_op, result) = rx.recv_timeout(Duration::from_secs(30)).unwrap();
+    assert_eq!(completed_op, operation as usize);
+    assert_eq!(result, AniDBResult::Success);
+
+    let mut status = AniDBStatus::Pending;
+    assert_eq!(
+        anidb_operation_get_status(operation, &mut status),
+        AniDBResult::Success
+    );
+    assert_eq!(status, AniDBStatus::Completed);
+
+    let mut file_result: *mut AniDBFileResult = ptr::null_mut();
+    assert_eq!(
+        anidb_operation_get_result(operation, &mut file_result),
+        AniDBResult::Success
+    );
+    let file_result_ref = unsafe { &*file_result };
+    assert_eq!(file_result_ref.file_size, 512 * 1024);
+    assert_eq!(file_result_ref.hash_count, 1);
+    let path_str = unsafe { CStr::from_ptr(file_result_ref.file_path) };
+    assert_eq!(path_str, c_path.as_c_str());
+
+    anidb_free_file_result(file_result);
+    assert_eq!(anidb_operation_destroy(operation), AniDBResult::Success);
+    assert_eq!(
+        anidb_operation_destroy(operation),
+        AniDBResult::ErrorInvalidHandle
+    );
+
+    anidb_client_destroy(client);
+    anidb_cleanup();
+}
+
+/// Test that a callback registered after completion fires immediately
+#[test]
+#[serial_test::serial]
+fn test_async_operation_late_callback() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = temp_dir.path().join("late.mkv");
+    fs::write(&path, vec![0x01; 4096]).unwrap();
+    let c_path = CString::new(path.to_str().unwrap()).unwrap();
+
+    let client = create_client();
+    let operation = start_operation(client, &c_path, &[AniDBHashAlgorithm::CRC32]);
+
+    let mut status = AniDBStatus::Pending;
+    assert_eq!(
+        anidb_operation_wait(operation, 0, &mut status),
+        AniDBResult::Success
+    );
+    assert_eq!(status, AniDBStatus::Completed);
+
+    extern "C" fn on_complete(_op: *mut c_void, result: AniDBResult, user_data: *mut c_void) {
+        let slot = unsafe { &mut *(user_data as *mut Option<AniDBResult>) };
+        *slot = Some(result);
+    }
+
+    // Invoked synchronously on this thread because the operation is done
+    let mut observed: Option<AniDBResult> = None;
+    assert_eq!(
+        anidb_operation_set_callback(
+            operation,
+            Some(on_complete),
+            &mut observed as *mut _ as *mut c_void
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(observed, Some(AniDBResult::Success));
+
+    anidb_operation_destroy(operation);
+    anidb_client_destroy(client);
+    anidb_cleanup();
+}
+
+/// Test polling progress while an operation runs
+#[test]
+#[serial_test::serial]
+fn test_async_operation_progress_snapshot() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = temp_dir.path().join("progress.mkv");
+    let file_size = 20 * 1024 * 1024;
+    fs::write(&path, vec![0x5A; file_size]).unwrap();
+    let c_path = CString::new(path.to_str().unwrap()).unwrap();
+
+    let client = create_client();
+    let operation = start_operation(client, &c_path, &[AniDBHashAlgorithm::ED2K]);
+
+    // Poll like a UI frame loop; progress never goes backwards
+    let mut last = AniDBProgressSnapshot::default();
+    let mut status = AniDBStatus::Pending;
+    loop {
+        let mut snapshot = AniDBProgressSnapshot::default();
+        assert_eq!(
+            anidb_operation_get_progress(operation, &mut snapshot),
+            AniDBResult::Success
+        );
+        assert!(snapshot.updates >= last.updates);
+        assert!(snapshot.bytes_processed >= last.bytes_processed);
+        last = snapshot;
+
+        if anidb_operation_wait(operation, 16, &mut status) == AniDBResult::Success {
+            break;
+        }
+    }
+    assert_eq!(status, AniDBStatus::Completed);
+
+    // Counters are exact once the file is done
+    let mut snapshot = AniDBProgressSnapshot::default();
+    assert_eq!(
+        anidb_operation_get_progress(operation, &mut snapshot),
+        AniDBResult::Success
+    );
+    assert_eq!(snapshot.bytes_processed, file_size as u64);
+    assert_eq!(snapshot.total_bytes, file_size as u64);
+    assert!(snapshot.updates > 0);
+
+    anidb_operation_destroy(operation);
+    assert_eq!(
+        anidb_operation_get_progress(operation, &mut snapshot),
+        AniDBResult::ErrorInvalidHandle
+    );
+
+    anidb_client_destroy(client);
+    anidb_cleanup();
+}
+
+/// Test that processing errors are reported through the operation
+#[test]
+#[serial_test::serial]
+fn test_async_operation_missing_file() {
+    let temp_dir = TempDir::new().unwrap();
+    let c_path = CString::new(temp_dir.path().join("missing.mkv").to_str().unwrap()).unwrap();
+
+    let client = create_client();
+    let operation = start_operation(client, &c_path, &[AniDBHashAlgorithm::ED2K]);
+
+    let mut status = AniDBStatus::Pending;
+    assert_eq!(
+        anidb_operation_wait(operation, 10_000, &mut status),
+        AniDBResult::Success
+    );
+    assert_eq!(status, AniDBStatus::Failed);
+
+    let mut file_result: *mut AniDBFileResult = ptr::null_mut();
+    assert_eq!(
+        anidb_operation_get_result(operation, &mut file_result),
+        AniDBResult::ErrorFileNotFound
+    );
+    assert!(file_result.is_null());
+
+    anidb_operation_destroy(operation);
+    anidb_client_destroy(client);
+    anidb_cleanup();
+}
+
+/// Test cancelling an operation before it finishes
+#[test]
+#[serial_test::serial]
+fn test_async_operation_cancel() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = temp_dir.path().join("large.mkv");
+    fs::write(&path, vec![0x77; 32 * 1024 * 1024]).unwrap();
+    let c_path = CString::new(path.to_str().unwrap()).unwrap();
+
+    let client = create_client();
+    let operation = start_operation(
+        client,
+        &c_path,
+        &[
+            AniDBHashAlgorithm::ED2K,
+            AniDBHashAlgorithm::MD5,
+            AniDBHashAlgorithm::SHA1,
+        ],
+    );
+    assert_eq!(anidb_operation_cancel(operation), AniDBResult::Success);
+
+    let mut status = AniDBStatus::Pending;
+    assert_eq!(
+        anidb_operation_wait(operation, 10_000, &mut status),
+        AniDBResult::Success
+    );
+
+    // Cancellation races with completion; both are terminal
+    let mut file_result: *mut AniDBFileResult = ptr::null_mut();
+    let result = anidb_operation_get_result(operation, &mut file_result);
+    match status {
+        AniDBStatus::Cancelled => assert_eq!(result, AniDBResult::ErrorCancelled),
+        AniDBStatus::Completed => {
+            assert_eq!(result, AniDBResult::Success);
+            anidb_free_file_result(file_result);
+        }
+        other => panic!("unexpected status {other:?}"),
+    }
+
+    anidb_operation_destroy(operation);
+    anidb_client_destroy(client);
+    anidb_cleanup();
+}
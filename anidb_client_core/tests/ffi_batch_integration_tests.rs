@@ -3,11 +3,17 @@
 //! Tests batch file processing capabilities through the FFI interface
 
 use anidb_client_core::ffi::{
-    AniDBBatchOptions, AniDBBatchResult, AniDBConfig, AniDBHashAlgorithm, AniDBResult,
-    anidb_cleanup, anidb_client_create, anidb_client_create_with_config, anidb_client_destroy,
-    anidb_init,
+    ANIDB_ABI_VERSION, AniDBBatchOptions, AniDBBatchResult, AniDBConfig, AniDBDeviceStats,
+    AniDBFileResult, AniDBHashAlgorithm, AniDBMetrics, AniDBPriority, AniDBProcessOptions,
+    AniDBResult, AniDBScanOptions, AniDBSizeCollision, AniDBStatus, anidb_batch_cancel,
+    anidb_batch_destroy, anidb_batch_get_device_stats, anidb_batch_get_progress,
+    anidb_batch_get_result, anidb_batch_get_size_collisions, anidb_cleanup, anidb_client_create,
+    anidb_client_create_with_config, anidb_client_destroy, anidb_free_batch_result,
+    anidb_free_file_result, anidb_get_metrics, anidb_init, anidb_process_batch,
+    anidb_process_batch_async, anidb_process_batch_stream, anidb_process_file,
+    anidb_scan_and_process,
 };
-use std::ffi::CString;
+use std::ffi::{CStr, CString, c_char};
 use std::fs;
 use std::path::PathBuf;
 use std::ptr;
@@ -20,7 +26,7 @@ use tempfile::TempDir;
 #[test]
 #[serial_test::serial]
 fn test_ffi_batch_processing_basic() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
 
@@ -40,11 +46,7 @@ fn test_ffi_batch_processing_basic() {
         max_concurrent_files: 4,
         chunk_size: 64 * 1024,
         max_memory_usage: 500 * 1024 * 1024,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -60,12 +62,16 @@ fn test_ffi_batch_processing_basic() {
         AniDBHashAlgorithm::MD5,
     ];
 
-    // Progress tracking
-    let progress_updates = Arc::new(Mutex::new(Vec::<(f32, u64, u64)>::new()));
-    let completion_called = Arc::new(AtomicUsize::new(0));
+    // Progress tracking shared by both callbacks through user_data
+    struct BatchTracker {
+        progress: Mutex<Vec<(f32, u64, u64)>>,
+        completions: AtomicUsize,
+    }
 
-    let progress_clone = Arc::clone(&progress_updates);
-    let completion_clone = Arc::clone(&completion_called);
+    let tracker = BatchTracker {
+        progress: Mutex::new(Vec::new()),
+        completions: AtomicUsize::new(0),
+    };
 
     extern "C" fn batch_progress_callback(
         percentage: f32,
@@ -73,36 +79,29 @@ fn test_ffi_batch_processing_basic() {
         total_files: u64,
         user_data: *mut std::ffi::c_void,
     ) {
-        let data = unsafe { &*(user_data as *const Arc<Mutex<Vec<(f32, u64, u64)>>>) };
-        data.lock()
+        let tracker = unsafe { &*(user_data as *const BatchTracker) };
+        tracker
+            .progress
+            .lock()
             .unwrap()
             .push((percentage, current_file, total_files));
     }
 
     extern "C" fn batch_completion_callback(result: AniDBResult, user_data: *mut std::ffi::c_void) {
-        let count = unsafe { &*(user_data as *const Arc<AtomicUsize>) };
-        count.fetch_add(1, Ordering::Relaxed);
+        let tracker = unsafe { &*(user_data as *const BatchTracker) };
+        tracker.completions.fetch_add(1, Ordering::Relaxed);
         assert_eq!(result, AniDBResult::Success);
     }
 
-    let progress_ptr =
-        &progress_clone as *const Arc<Mutex<Vec<(f32, u64, u64)>>> as *mut std::ffi::c_void;
-    let completion_ptr = &completion_clone as *const Arc<AtomicUsize> as *mut std::ffi::c_void;
-
-    let _batch_options = AniDBBatchOptions {
+    let batch_options = AniDBBatchOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
         max_concurrent: 4,
         continue_on_error: 1,
-        skip_existing: 0,
-        include_patterns: ptr::null(),
-        include_pattern_count: 0,
-        exclude_patterns: ptr::null(),
-        exclude_pattern_count: 0,
-        use_defaults: 1,
         progress_callback: Some(batch_progress_callback),
         completion_callback: Some(batch_completion_callback),
-        user_data: progress_ptr,
+        user_data: &tracker as *const BatchTracker as *mut std::ffi::c_void,
+        ..Default::default()
     };
 
     // Convert file paths to C strings
@@ -110,77 +109,974 @@ fn test_ffi_batch_processing_basic() {
         .iter()
         .map(|p| CString::new(p.to_str().unwrap()).unwrap())
         .collect();
-    let _c_path_ptrs: Vec<*const i8> = c_paths.iter().map(|s| s.as_ptr()).collect();
+    let c_path_ptrs: Vec<*const c_char> = c_paths.iter().map(|s| s.as_ptr()).collect();
 
     // Execute batch processing
     let start = Instant::now();
-    let _batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    let result = anidb_process_batch(
+        client_handle,
+        c_path_ptrs.as_ptr(),
+        c_path_ptrs.len(),
+        &batch_options,
+        &mut batch_result,
+    );
+    let duration = start.elapsed();
 
-    // Note: The actual batch processing function needs to be implemented in the FFI
-    // For now, we'll test the individual components
+    assert_eq!(result, AniDBResult::Success);
+    assert!(!batch_result.is_null());
 
-    // Process files sequentially as a batch simulation
-    let mut successful = 0;
-    let mut failed = 0;
-    let mut file_results = Vec::new();
+    // Verify results
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.total_files, file_count);
+    assert_eq!(batch.successful_files, file_count);
+    assert_eq!(batch.failed_files, 0);
+    assert_eq!(tracker.completions.load(Ordering::Relaxed), 1);
+
+    // Results are reported in input order with every requested hash
+    let results = unsafe { std::slice::from_raw_parts(batch.results, batch.total_files) };
+    for (file_result, c_path) in results.iter().zip(&c_paths) {
+        assert_eq!(file_result.status, AniDBStatus::Completed);
+        assert_eq!(file_result.hash_count, algorithms.len());
+        let path = unsafe { CStr::from_ptr(file_result.file_path) };
+        assert_eq!(path, c_path.as_c_str());
+    }
 
-    for (i, c_path) in c_paths.iter().enumerate() {
-        let options = anidb_client_core::ffi::AniDBProcessOptions {
-            algorithms: algorithms.as_ptr(),
-            algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
-        };
+    // Check progress updates
+    let progress = tracker.progress.lock().unwrap();
+    assert_eq!(progress.len(), file_count);
+    assert_eq!(progress.last().unwrap().1, file_count as u64);
+    assert!(progress.windows(2).all(|w| w[0].1 <= w[1].1));
 
-        let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
-        let result = anidb_client_core::ffi::anidb_process_file(
+    println!(
+        "Batch processing completed: {} files in {:.2}s",
+        batch.successful_files,
+        duration.as_secs_f64()
+    );
+
+    anidb_free_batch_result(batch_result);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test asynchronous batch processing through the batch handle
+#[test]
+#[serial_test::serial]
+fn test_ffi_batch_async_progress_and_result() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let file_count = 6;
+    let c_paths: Vec<CString> = (0..file_count)
+        .map(|i| {
+            let path = temp_dir.path().join(format!("async_batch_{i}.mkv"));
+            fs::write(&path, vec![i as u8; 256 * 1024]).unwrap();
+            CString::new(path.to_str().unwrap()).unwrap()
+        })
+        .collect();
+    let c_path_ptrs: Vec<*const c_char> = c_paths.iter().map(|s| s.as_ptr()).collect();
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    let algorithms = [AniDBHashAlgorithm::ED2K];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        // Use client default
+        continue_on_error: 1,
+        ..Default::default()
+    };
+
+    let mut batch_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch_async(
             client_handle,
-            c_path.as_ptr(),
-            &options,
-            &mut result_ptr,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            &mut batch_handle,
+        ),
+        AniDBResult::Success
+    );
+    assert!(!batch_handle.is_null());
+
+    // Poll until finished, checking that progress never goes backwards
+    let deadline = Instant::now() + Duration::from_secs(30);
+    let mut last_completed = 0;
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    loop {
+        let mut completed = 0;
+        let mut total = 0;
+        assert_eq!(
+            anidb_batch_get_progress(batch_handle, &mut completed, &mut total),
+            AniDBResult::Success
         );
-
-        if result == AniDBResult::Success {
-            successful += 1;
-            if !result_ptr.is_null() {
-                file_results.push(result_ptr);
+        assert_eq!(total, file_count);
+        assert!(completed >= last_completed);
+        last_completed = completed;
+
+        match anidb_batch_get_result(batch_handle, &mut batch_result) {
+            AniDBResult::Success => break,
+            AniDBResult::ErrorBusy => {
+                assert!(Instant::now() < deadline, "batch did not finish in time");
+                std::thread::sleep(Duration::from_millis(10));
             }
+            other => panic!("unexpected result: {other:?}"),
+        }
+    }
+
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.total_files, file_count);
+    assert_eq!(batch.successful_files, file_count);
+
+    // All files live in one temp directory, so on one device
+    let mut device_count = 0;
+    assert_eq!(
+        anidb_batch_get_device_stats(batch_handle, ptr::null_mut(), 0, &mut device_count),
+        AniDBResult::Success
+    );
+    assert_eq!(device_count, 1);
+    let mut devices = [AniDBDeviceStats::default(); 2];
+    assert_eq!(
+        anidb_batch_get_device_stats(
+            batch_handle,
+            devices.as_mut_ptr(),
+            devices.len(),
+            &mut device_count
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(devices[0].files_total, file_count);
+    assert_eq!(devices[0].files_completed, file_count);
+    assert_eq!(devices[0].bytes_processed, (file_count * 256 * 1024) as u64);
+
+    anidb_free_batch_result(batch_result);
+    assert_eq!(anidb_batch_destroy(batch_handle), AniDBResult::Success);
+    assert_eq!(
+        anidb_batch_destroy(batch_handle),
+        AniDBResult::ErrorInvalidHandle
+    );
+
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test that a streaming batch delivers every result before completing
+#[test]
+#[serial_test::serial]
+fn test_ffi_batch_stream_results() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let mut c_paths: Vec<CString> = (0..4)
+        .map(|i| {
+            let path = temp_dir.path().join(format!("stream_{i}.mkv"));
+            fs::write(&path, vec![i as u8; 64 * 1024]).unwrap();
+            CString::new(path.to_str().unwrap()).unwrap()
+        })
+        .collect();
+    // A duplicate and a missing file are streamed like any other entry
+    c_paths.push(c_paths[0].clone());
+    c_paths.push(CString::new(temp_dir.path().join("missing.mkv").to_str().unwrap()).unwrap());
+    let c_path_ptrs: Vec<*const c_char> = c_paths.iter().map(|s| s.as_ptr()).collect();
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    struct StreamTracker {
+        results: Mutex<Vec<(usize, AniDBStatus, String)>>,
+        delivered_at_completion: Mutex<Option<usize>>,
+    }
+
+    let tracker = StreamTracker {
+        results: Mutex::new(Vec::new()),
+        delivered_at_completion: Mutex::new(None),
+    };
+
+    extern "C" fn on_result(
+        index: usize,
+        result: *mut AniDBFileResult,
+        user_data: *mut std::ffi::c_void,
+    ) {
+        let tracker = unsafe { &*(user_data as *const StreamTracker) };
+        let file_result = unsafe { &*result };
+        let path = unsafe { CStr::from_ptr(file_result.file_path) }
+            .to_string_lossy()
+            .into_owned();
+        tracker
+            .results
+            .lock()
+            .unwrap()
+            .push((index, file_result.status, path));
+        anidb_free_file_result(result);
+    }
+
+    extern "C" fn on_complete(_result: AniDBResult, user_data: *mut std::ffi::c_void) {
+        let tracker = unsafe { &*(user_data as *const StreamTracker) };
+        let delivered = tracker.results.lock().unwrap().len();
+        *tracker.delivered_at_completion.lock().unwrap() = Some(delivered);
+    }
+
+    let algorithms = [AniDBHashAlgorithm::CRC32];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 2,
+        continue_on_error: 1,
+        skip_existing: 1,
+        completion_callback: Some(on_complete),
+        user_data: &tracker as *const StreamTracker as *mut std::ffi::c_void,
+        ..Default::default()
+    };
+
+    // The result callback is mandatory
+    let mut batch_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch_stream(
+            client_handle,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            None,
+            &mut batch_handle,
+        ),
+        AniDBResult::ErrorInvalidParameter
+    );
+
+    assert_eq!(
+        anidb_process_batch_stream(
+            client_handle,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            Some(on_result),
+            &mut batch_handle,
+        ),
+        AniDBResult::Success
+    );
+
+    let deadline = Instant::now() + Duration::from_secs(30);
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    while anidb_batch_get_result(batch_handle, &mut batch_result) == AniDBResult::ErrorBusy {
+        assert!(Instant::now() < deadline, "batch did not finish in time");
+        std::thread::sleep(Duration::from_millis(10));
+    }
+
+    assert_eq!(
+        *tracker.delivered_at_completion.lock().unwrap(),
+        Some(c_paths.len())
+    );
+
+    // Each input path is reported exactly once under its own path
+    let mut results = tracker.results.lock().unwrap().clone();
+    results.sort_by_key(|(index, _, _)| *index);
+    let indices: Vec<usize> = results.iter().map(|(index, _, _)| *index).collect();
+    assert_eq!(indices, (0..c_paths.len()).collect::<Vec<_>>());
+    for (index, status, path) in &results {
+        assert_eq!(path.as_str(), c_paths[*index].to_str().unwrap());
+        let expected = if *index == c_paths.len() - 1 {
+            AniDBStatus::Failed
         } else {
-            failed += 1;
+            AniDBStatus::Completed
+        };
+        assert_eq!(*status, expected);
+    }
+
+    // The summary carries counters but no retained results
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.total_files, c_paths.len());
+    assert_eq!(batch.successful_files, c_paths.len() - 1);
+    assert_eq!(batch.failed_files, 1);
+    assert!(batch.results.is_null());
+
+    anidb_free_batch_result(batch_result);
+    anidb_batch_destroy(batch_handle);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test that a directory scan hashes every matching file it walks
+#[test]
+#[serial_test::serial]
+fn test_ffi_scan_and_process() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let nested = temp_dir.path().join("season 1");
+    fs::create_dir(&nested).unwrap();
+    let mut expected: Vec<String> = Vec::new();
+    for (dir, name) in [
+        (temp_dir.path(), "movie.mkv"),
+        (nested.as_path(), "episode_01.mkv"),
+        (nested.as_path(), "episode_02.mp4"),
+    ] {
+        let path = dir.join(name);
+        fs::write(&path, vec![0x42; 32 * 1024]).unwrap();
+        expected.push(path.to_string_lossy().into_owned());
+    }
+    // Not a media file, and excluded by pattern, respectively
+    fs::write(temp_dir.path().join("notes.txt"), b"notes").unwrap();
+    fs::write(nested.join("sample.mkv"), b"sample").unwrap();
+    expected.sort();
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    extern "C" fn on_result(
+        index: usize,
+        result: *mut AniDBFileResult,
+        user_data: *mut std::ffi::c_void,
+    ) {
+        let results = unsafe { &*(user_data as *const Mutex<Vec<(usize, String, AniDBStatus)>>) };
+        let file_result = unsafe { &*result };
+        let path = unsafe { CStr::from_ptr(file_result.file_path) }
+            .to_string_lossy()
+            .into_owned();
+        results
+            .lock()
+            .unwrap()
+            .push((index, path, file_result.status));
+        anidb_free_file_result(result);
+    }
+
+    let results: Mutex<Vec<(usize, String, AniDBStatus)>> = Mutex::new(Vec::new());
+    let algorithms = [AniDBHashAlgorithm::ED2K];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 2,
+        continue_on_error: 1,
+        user_data: &results as *const _ as *mut std::ffi::c_void,
+        ..Default::default()
+    };
+    let exclude = CString::new("**/sample.*").unwrap();
+    let exclude_ptrs = [exclude.as_ptr()];
+    let scan_options = AniDBScanOptions {
+        include_patterns: ptr::null(),
+        include_count: 0,
+        exclude_patterns: exclude_ptrs.as_ptr(),
+        exclude_count: exclude_ptrs.len(),
+        use_defaults: 1,
+        recursive: 1,
+        follow_links: 0,
+        max_depth: 0,
+    };
+    let root = CString::new(temp_dir.path().to_str().unwrap()).unwrap();
+
+    // A missing root and a bad pattern fail before anything is scheduled
+    let mut batch_handle: *mut std::ffi::c_void = ptr::null_mut();
+    let missing = CString::new(temp_dir.path().join("missing").to_str().unwrap()).unwrap();
+    assert_eq!(
+        anidb_scan_and_process(
+            client_handle,
+            missing.as_ptr(),
+            &scan_options,
+            &batch_options,
+            Some(on_result),
+            &mut batch_handle,
+        ),
+        AniDBResult::ErrorFileNotFound
+    );
+    let bad_pattern = CString::new("[").unwrap();
+    let bad_ptrs = [bad_pattern.as_ptr()];
+    let bad_options = AniDBScanOptions {
+        include_patterns: bad_ptrs.as_ptr(),
+        include_count: bad_ptrs.len(),
+        ..scan_options
+    };
+    assert_eq!(
+        anidb_scan_and_process(
+            client_handle,
+            root.as_ptr(),
+            &bad_options,
+            &batch_options,
+            Some(on_result),
+            &mut batch_handle,
+        ),
+        AniDBResult::ErrorInvalidParameter
+    );
+
+    assert_eq!(
+        anidb_scan_and_process(
+            client_handle,
+            root.as_ptr(),
+            &scan_options,
+            &batch_options,
+            Some(on_result),
+            &mut batch_handle,
+        ),
+        AniDBResult::Success
+    );
+
+    let deadline = Instant::now() + Duration::from_secs(30);
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    while anidb_batch_get_result(batch_handle, &mut batch_result) == AniDBResult::ErrorBusy {
+        assert!(Instant::now() < deadline, "scan did not finish in time");
+        std::thread::sleep(Duration::from_millis(10));
+    }
+
+    // Indices follow discovery order and cover every matching file once
+    let mut delivered = results.lock().unwrap().clone();
+    delivered.sort_by_key(|(index, _, _)| *index);
+    let indices: Vec<usize> = delivered.iter().map(|(index, _, _)| *index).collect();
+    assert_eq!(indices, (0..expected.len()).collect::<Vec<_>>());
+    assert!(
+        delivered
+            .iter()
+            .all(|(_, _, status)| *status == AniDBStatus::Completed)
+    );
+    let mut paths: Vec<String> = delivered.into_iter().map(|(_, path, _)| path).collect();
+    paths.sort();
+    assert_eq!(paths, expected);
+
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.total_files, expected.len());
+    assert_eq!(batch.successful_files, expected.len());
+    assert!(batch.results.is_null());
+
+    let (mut completed, mut total) = (0, 0);
+    assert_eq!(
+        anidb_batch_get_progress(batch_handle, &mut completed, &mut total),
+        AniDBResult::Success
+    );
+    assert_eq!((completed, total), (expected.len(), expected.len()));
+
+    anidb_free_batch_result(batch_result);
+    anidb_batch_destroy(batch_handle);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test that skip_existing hashes duplicate paths once
+#[test]
+#[serial_test::serial]
+fn test_ffi_batch_skip_existing_duplicates() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let path = temp_dir.path().join("duplicate.mkv");
+    fs::write(&path, vec![0x42; 128 * 1024]).unwrap();
+    let c_path = CString::new(path.to_str().unwrap()).unwrap();
+    let c_path_ptrs = vec![c_path.as_ptr(); 3];
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    let algorithms = [AniDBHashAlgorithm::CRC32];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 2,
+        continue_on_error: 1,
+        skip_existing: 1,
+        ..Default::default()
+    };
+
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch(
+            client_handle,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            &mut batch_result,
+        ),
+        AniDBResult::Success
+    );
+
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.total_files, 3);
+    assert_eq!(batch.successful_files, 3);
+
+    // Every duplicate carries the same hash
+    let results = unsafe { std::slice::from_raw_parts(batch.results, batch.total_files) };
+    let hashes: Vec<String> = results
+        .iter()
+        .map(|r| {
+            assert_eq!(r.hash_count, 1);
+            let hash = unsafe { &*r.hashes };
+            unsafe { CStr::from_ptr(hash.hash_value) }
+                .to_string_lossy()
+                .into_owned()
+        })
+        .collect();
+    assert!(hashes.iter().all(|h| h == &hashes[0]));
+
+    anidb_free_batch_result(batch_result);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test that hardlinked paths are read once and equal sizes are reported
+#[test]
+#[serial_test::serial]
+fn test_ffi_batch_hardlinks_and_size_collisions() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let original = temp_dir.path().join("seeded.mkv");
+    fs::write(&original, vec![0x42; 128 * 1024]).unwrap();
+    let link = temp_dir.path().join("library.mkv");
+    fs::hard_link(&original, &link).unwrap();
+    let same_size = temp_dir.path().join("other.mkv");
+    fs::write(&same_size, vec![0x43; 128 * 1024]).unwrap();
+    let unique = temp_dir.path().join("unique.mkv");
+    fs::write(&unique, vec![0x44; 64 * 1024]).unwrap();
+
+    let c_paths: Vec<CString> = [&original, &link, &same_size, &unique]
+        .iter()
+        .map(|p| CString::new(p.to_str().unwrap()).unwrap())
+        .collect();
+    let c_path_ptrs: Vec<*const c_char> = c_paths.iter().map(|p| p.as_ptr()).collect();
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    // Both paths to the hardlinked file are hashed once even without
+    // skip_existing
+    let algorithms = [AniDBHashAlgorithm::CRC32];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 4,
+        continue_on_error: 1,
+        ..Default::default()
+    };
+
+    let mut batch_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch_async(
+            client_handle,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            &mut batch_handle,
+        ),
+        AniDBResult::Success
+    );
+
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    let deadline = Instant::now() + Duration::from_secs(30);
+    while anidb_batch_get_result(batch_handle, &mut batch_result) == AniDBResult::ErrorBusy {
+        assert!(Instant::now() < deadline, "batch did not finish in time");
+        std::thread::sleep(Duration::from_millis(10));
+    }
+
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.successful_files, 4);
+    let results = unsafe { std::slice::from_raw_parts(batch.results, batch.total_files) };
+    let path_of = |r: &AniDBFileResult| unsafe { CStr::from_ptr(r.file_path) }.to_owned();
+    assert_eq!(path_of(&results[1]), c_paths[1].clone());
+    let hash_of =
+        |r: &AniDBFileResult| unsafe { CStr::from_ptr((*r.hashes).hash_value) }.to_owned();
+    assert_eq!(hash_of(&results[0]), hash_of(&results[1]));
+
+    // The hardlinked file and the other file of its size form one group
+    let collisions =
+        unsafe { std::slice::from_raw_parts(batch.size_collisions, batch.size_collision_count) };
+    let groups: Vec<(u64, usize)> = collisions
+        .iter()
+        .map(|c| (c.file_size, c.path_index))
+        .collect();
+    assert_eq!(groups, vec![(128 * 1024, 0), (128 * 1024, 2)]);
+
+    // The batch handle reports the same groups
+    let mut count = 0usize;
+    let mut from_handle = [AniDBSizeCollision::default(); 4];
+    assert_eq!(
+        anidb_batch_get_size_collisions(
+            batch_handle,
+            from_handle.as_mut_ptr(),
+            from_handle.len(),
+            &mut count,
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(count, 2);
+    assert_eq!(from_handle[1].path_index, 2);
+
+    let mut metrics = AniDBMetrics::default();
+    assert_eq!(
+        anidb_get_metrics(client_handle, &mut metrics),
+        AniDBResult::Success
+    );
+    assert_eq!(metrics.bytes_read, (128 + 128 + 64) * 1024);
+
+    anidb_free_batch_result(batch_result);
+    anidb_batch_destroy(batch_handle);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test that a scan reads hardlinked files once and reports every name
+#[test]
+#[serial_test::serial]
+fn test_ffi_scan_hardlinks() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let extras = temp_dir.path().join("extras");
+    fs::create_dir(&extras).unwrap();
+    let original = temp_dir.path().join("seeded.mkv");
+    fs::write(&original, vec![0x42; 128 * 1024]).unwrap();
+    let mut names = vec![original.clone()];
+    for link in [temp_dir.path().join("library.mkv"), extras.join("copy.mkv")] {
+        fs::hard_link(&original, &link).unwrap();
+        names.push(link);
+    }
+    let unique = temp_dir.path().join("unique.mkv");
+    fs::write(&unique, vec![0x44; 64 * 1024]).unwrap();
+    names.push(unique);
+    let mut expected: Vec<String> = names
+        .iter()
+        .map(|p| p.to_string_lossy().into_owned())
+        .collect();
+    expected.sort();
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    extern "C" fn on_result(
+        index: usize,
+        result: *mut AniDBFileResult,
+        user_data: *mut std::ffi::c_void,
+    ) {
+        let results = unsafe { &*(user_data as *const Mutex<Vec<(usize, String, String)>>) };
+        let file_result = unsafe { &*result };
+        assert_eq!(file_result.status, AniDBStatus::Completed);
+        let path = unsafe { CStr::from_ptr(file_result.file_path) }
+            .to_string_lossy()
+            .into_owned();
+        let hash = unsafe { CStr::from_ptr((*file_result.hashes).hash_value) }
+            .to_string_lossy()
+            .into_owned();
+        results.lock().unwrap().push((index, path, hash));
+        anidb_free_file_result(result);
+    }
+
+    let results: Mutex<Vec<(usize, String, String)>> = Mutex::new(Vec::new());
+    let algorithms = [AniDBHashAlgorithm::CRC32];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 4,
+        continue_on_error: 1,
+        user_data: &results as *const _ as *mut std::ffi::c_void,
+        ..Default::default()
+    };
+    let scan_options = AniDBScanOptions {
+        include_patterns: ptr::null(),
+        include_count: 0,
+        exclude_patterns: ptr::null(),
+        exclude_count: 0,
+        use_defaults: 1,
+        recursive: 1,
+        follow_links: 0,
+        max_depth: 0,
+    };
+    let root = CString::new(temp_dir.path().to_str().unwrap()).unwrap();
+
+    let mut batch_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_scan_and_process(
+            client_handle,
+            root.as_ptr(),
+            &scan_options,
+            &batch_options,
+            Some(on_result),
+            &mut batch_handle,
+        ),
+        AniDBResult::Success
+    );
+
+    let deadline = Instant::now() + Duration::from_secs(30);
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    while anidb_batch_get_result(batch_handle, &mut batch_result) == AniDBResult::ErrorBusy {
+        assert!(Instant::now() < deadline, "scan did not finish in time");
+        std::thread::sleep(Duration::from_millis(10));
+    }
+
+    // Every name is reported once, the links with the original's hash
+    let mut delivered = results.lock().unwrap().clone();
+    delivered.sort_by_key(|(index, _, _)| *index);
+    let indices: Vec<usize> = delivered.iter().map(|(index, _, _)| *index).collect();
+    assert_eq!(indices, (0..expected.len()).collect::<Vec<_>>());
+    let hash_of = |path: &PathBuf| {
+        let path = path.to_string_lossy();
+        delivered
+            .iter()
+            .find(|(_, p, _)| *p == path)
+            .map(|(_, _, hash)| hash.clone())
+            .unwrap()
+    };
+    assert!(
+        names[..3]
+            .iter()
+            .all(|name| hash_of(name) == hash_of(&names[0]))
+    );
+    assert_ne!(hash_of(&names[3]), hash_of(&names[0]));
+    let mut paths: Vec<String> = delivered.into_iter().map(|(_, path, _)| path).collect();
+    paths.sort();
+    assert_eq!(paths, expected);
+
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.total_files, expected.len());
+    assert_eq!(batch.successful_files, expected.len());
+
+    // The hardlinked contents were read once
+    let mut metrics = AniDBMetrics::default();
+    assert_eq!(
+        anidb_get_metrics(client_handle, &mut metrics),
+        AniDBResult::Success
+    );
+    assert_eq!(metrics.files_processed, 2);
+    assert_eq!(metrics.bytes_read, (128 + 64) * 1024);
+
+    anidb_free_batch_result(batch_result);
+    anidb_batch_destroy(batch_handle);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test that an interactive file completes alongside a background batch
+#[test]
+#[serial_test::serial]
+fn test_ffi_background_batch_with_interactive_file() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let file_count = 8;
+    let c_paths: Vec<CString> = (0..file_count)
+        .map(|i| {
+            let path = temp_dir.path().join(format!("background_{i}.mkv"));
+            fs::write(&path, vec![i as u8; 1024 * 1024]).unwrap();
+            CString::new(path.to_str().unwrap()).unwrap()
+        })
+        .collect();
+    let c_path_ptrs: Vec<*const c_char> = c_paths.iter().map(|s| s.as_ptr()).collect();
+    let interactive_path = temp_dir.path().join("interactive.mkv");
+    fs::write(&interactive_path, vec![0x5A; 512 * 1024]).unwrap();
+    let c_interactive = CString::new(interactive_path.to_str().unwrap()).unwrap();
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    let algorithms = [AniDBHashAlgorithm::ED2K];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 2,
+        continue_on_error: 1,
+        priority: AniDBPriority::Background,
+        ..Default::default()
+    };
+    let mut batch_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch_async(
+            client_handle,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            &mut batch_handle,
+        ),
+        AniDBResult::Success
+    );
+
+    let process_options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        priority: AniDBPriority::Interactive,
+        ..Default::default()
+    };
+    let mut file_result: *mut AniDBFileResult = ptr::null_mut();
+    assert_eq!(
+        anidb_process_file(
+            client_handle,
+            c_interactive.as_ptr(),
+            &process_options,
+            &mut file_result,
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(unsafe { (*file_result).status }, AniDBStatus::Completed);
+    anidb_free_file_result(file_result);
+
+    // The background batch still finishes every file
+    let deadline = Instant::now() + Duration::from_secs(30);
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    loop {
+        match anidb_batch_get_result(batch_handle, &mut batch_result) {
+            AniDBResult::Success => break,
+            AniDBResult::ErrorBusy => {
+                assert!(Instant::now() < deadline, "batch did not finish in time");
+                std::thread::sleep(Duration::from_millis(10));
+            }
+            other => panic!("unexpected result: {other:?}"),
         }
+    }
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.successful_files, file_count);
 
-        // Simulate batch progress
-        let progress = ((i + 1) as f32 / file_count as f32) * 100.0;
-        batch_progress_callback(progress, (i + 1) as u64, file_count as u64, progress_ptr);
+    anidb_free_batch_result(batch_result);
+    assert_eq!(anidb_batch_destroy(batch_handle), AniDBResult::Success);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test that a batch stops after the first failure without continue_on_error
+#[test]
+#[serial_test::serial]
+fn test_ffi_batch_stop_on_error() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let missing = temp_dir.path().join("missing.mkv");
+    let mut c_paths = vec![CString::new(missing.to_str().unwrap()).unwrap()];
+    for i in 0..4 {
+        let path = temp_dir.path().join(format!("after_error_{i}.mkv"));
+        fs::write(&path, vec![0x11; 64 * 1024]).unwrap();
+        c_paths.push(CString::new(path.to_str().unwrap()).unwrap());
     }
+    let c_path_ptrs: Vec<*const c_char> = c_paths.iter().map(|s| s.as_ptr()).collect();
 
-    let duration = start.elapsed();
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
 
-    // Simulate completion callback
-    batch_completion_callback(AniDBResult::Success, completion_ptr);
+    static COMPLETION_RESULT: Mutex<Option<AniDBResult>> = Mutex::new(None);
 
-    // Verify results
-    assert_eq!(successful, file_count);
-    assert_eq!(failed, 0);
-    assert_eq!(completion_called.load(Ordering::Relaxed), 1);
+    extern "C" fn completion_callback(result: AniDBResult, _user_data: *mut std::ffi::c_void) {
+        *COMPLETION_RESULT.lock().unwrap() = Some(result);
+    }
 
-    // Check progress updates
-    let progress = progress_updates.lock().unwrap();
-    assert!(!progress.is_empty());
-    assert_eq!(progress.last().unwrap().1, file_count as u64);
+    let algorithms = [AniDBHashAlgorithm::CRC32];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        // A single slot makes the failing first file finish before any other starts
+        max_concurrent: 1,
+        completion_callback: Some(completion_callback),
+        ..Default::default()
+    };
 
-    println!(
-        "Batch processing completed: {} files in {:.2}s",
-        successful,
-        duration.as_secs_f64()
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch(
+            client_handle,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            &mut batch_result,
+        ),
+        AniDBResult::Success
+    );
+
+    let batch = unsafe { &*batch_result };
+    let results = unsafe { std::slice::from_raw_parts(batch.results, batch.total_files) };
+    assert_eq!(results[0].status, AniDBStatus::Failed);
+    assert!(!results[0].error_message.is_null());
+    assert_eq!(batch.successful_files, 0);
+    assert_eq!(batch.failed_files, c_paths.len());
+    assert!(
+        results[1..]
+            .iter()
+            .all(|r| r.status == AniDBStatus::Cancelled)
+    );
+    assert_eq!(
+        *COMPLETION_RESULT.lock().unwrap(),
+        Some(AniDBResult::ErrorFileNotFound)
     );
 
-    // Clean up file results
-    for result_ptr in file_results {
-        anidb_client_core::ffi::anidb_free_file_result(result_ptr);
+    anidb_free_batch_result(batch_result);
+    anidb_client_destroy(client_handle);
+    anidb_cleanup();
+}
+
+/// Test cancelling a running asynchronous batch
+#[test]
+#[serial_test::serial]
+fn test_ffi_batch_cancel() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let file_count = 20;
+    let c_paths: Vec<CString> = (0..file_count)
+        .map(|i| {
+            let path = temp_dir.path().join(format!("cancel_batch_{i}.mkv"));
+            fs::write(&path, vec![0x5A; 2 * 1024 * 1024]).unwrap();
+            CString::new(path.to_str().unwrap()).unwrap()
+        })
+        .collect();
+    let c_path_ptrs: Vec<*const c_char> = c_paths.iter().map(|s| s.as_ptr()).collect();
+
+    let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create(&mut client_handle),
+        AniDBResult::Success
+    );
+
+    let algorithms = [AniDBHashAlgorithm::MD5, AniDBHashAlgorithm::SHA1];
+    let batch_options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 1,
+        continue_on_error: 1,
+        ..Default::default()
+    };
+
+    let mut batch_handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch_async(
+            client_handle,
+            c_path_ptrs.as_ptr(),
+            c_path_ptrs.len(),
+            &batch_options,
+            &mut batch_handle,
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(anidb_batch_cancel(batch_handle), AniDBResult::Success);
+
+    let deadline = Instant::now() + Duration::from_secs(30);
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    while anidb_batch_get_result(batch_handle, &mut batch_result) == AniDBResult::ErrorBusy {
+        assert!(Instant::now() < deadline, "cancelled batch did not finish");
+        std::thread::sleep(Duration::from_millis(10));
     }
 
+    // Every file is accounted for and at least some never ran
+    let batch = unsafe { &*batch_result };
+    assert_eq!(batch.total_files, file_count);
+    assert_eq!(batch.successful_files + batch.failed_files, file_count);
+    let results = unsafe { std::slice::from_raw_parts(batch.results, batch.total_files) };
+    assert!(results.iter().any(|r| r.status == AniDBStatus::Cancelled));
+
+    anidb_free_batch_result(batch_result);
+    anidb_batch_destroy(batch_handle);
     anidb_client_destroy(client_handle);
     anidb_cleanup();
 }
@@ -189,7 +1085,7 @@ fn test_ffi_batch_processing_basic() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_batch_error_handling() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
 
@@ -227,9 +1123,7 @@ fn test_ffi_batch_error_handling() {
         let options = anidb_client_core::ffi::AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
@@ -271,7 +1165,7 @@ fn test_ffi_batch_error_handling() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_concurrent_batch_processing() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
     let num_batches = 4;
@@ -308,9 +1202,7 @@ fn test_ffi_concurrent_batch_processing() {
                 let options = anidb_client_core::ffi::AniDBProcessOptions {
                     algorithms: algorithms.as_ptr(),
                     algorithm_count: algorithms.len(),
-                    enable_progress: 0,
-                    progress_callback: None,
-                    user_data: ptr::null_mut(),
+                    ..Default::default()
                 };
 
                 let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
@@ -357,7 +1249,7 @@ fn test_ffi_concurrent_batch_processing() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_batch_memory_constraints() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
 
@@ -374,14 +1266,11 @@ fn test_ffi_batch_memory_constraints() {
 
     // Create client with strict memory limit
     let config = AniDBConfig {
-        max_concurrent_files: 2, // Limit concurrent processing
+        max_concurrent_files: 2,
+        // Limit concurrent processing
         chunk_size: 64 * 1024,
-        max_memory_usage: 100 * 1024 * 1024, // 100MB limit (tight for 20x10MB files)
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        max_memory_usage: 100 * 1024 * 1024,
+        ..Default::default()
     };
 
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -427,9 +1316,7 @@ fn test_ffi_batch_memory_constraints() {
         let options = anidb_client_core::ffi::AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
@@ -467,7 +1354,7 @@ fn test_ffi_batch_memory_constraints() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_batch_repeat_processing_without_cache() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
 
@@ -487,11 +1374,7 @@ fn test_ffi_batch_repeat_processing_without_cache() {
         max_concurrent_files: 4,
         chunk_size: 64 * 1024,
         max_memory_usage: 500 * 1024 * 1024,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -509,9 +1392,7 @@ fn test_ffi_batch_repeat_processing_without_cache() {
         let options = anidb_client_core::ffi::AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let start = Instant::now();
@@ -538,9 +1419,7 @@ fn test_ffi_batch_repeat_processing_without_cache() {
         let options = anidb_client_core::ffi::AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let start = Instant::now();
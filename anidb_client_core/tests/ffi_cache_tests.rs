@@ -0,0 +1,367 @@
+//! Hash Cache Tests for FFI
+//!
+//! Tests the `anidb_cache_*` API: processed files are recorded against
+//! their stat identity, unchanged files are answered without being read,
+//! a client created with a cache directory sees the entries of an earlier
+//! client, a partial rehash of a grown file matches a full one, and the
+//! prefilter recognises copies of hashed content by their fingerprint.
+//! Clients get a cache only when they ask for one.
+
+use anidb_client_core::ffi::{
+    AniDBConfig, AniDBFileResult, AniDBHashAlgorithm, AniDBPrefilterResult, AniDBPrefilterStatus,
+    AniDBProcessOptions, AniDBResult, anidb_cache_check_file, anidb_cache_check_files,
+    anidb_cache_clear, anidb_cache_get_stats, anidb_cache_prefilter_files, anidb_client_create,
+    anidb_client_create_with_config, anidb_client_destroy, anidb_free_file_result,
+    anidb_process_file,
+};
+use std::ffi::{CStr, CString, c_char, c_int, c_void};
+use std::path::{Path, PathBuf};
+use std::ptr;
+use tempfile::TempDir;
+
+fn write_file(dir: &Path, name: &str, contents: &[u8]) -> PathBuf {
+    let path = dir.join(name);
+    std::fs::write(&path, contents).unwrap();
+    path
+}
+
+fn c_path(path: &Path) -> CString {
+    CString::new(path.to_str().unwrap()).unwrap()
+}
+
+fn create_client(cache_dir: Option<&CString>) -> *mut c_void {
+    let config = AniDBConfig {
+        cache_dir: cache_dir.map_or(ptr::null(), |d| d.as_ptr()),
+        max_concurrent_files: 4,
+        chunk_size: 64 * 1024,
+        max_memory_usage: 500 * 1024 * 1024,
+        enable_hash_cache: 1,
+        ..Default::default()
+    };
+
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create_with_config(&config, &mut handle),
+        AniDBResult::Success
+    );
+    handle
+}
+
+/// Process a file and return its ED2K hash
+fn process_ed2k(handle: *mut c_void, path: &Path) -> String {
+    process_ed2k_with(handle, path, false)
+}
+
+fn process_ed2k_with(handle: *mut c_void, path: &Path, partial_rehash: bool) -> String {
+    let algorithms = [AniDBHashAlgorithm::ED2K];
+    let options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        partial_rehash: i32::from(partial_rehash),
+        ..Default::default()
+    };
+
+    let path = c_path(path);
+    let mut result: *mut AniDBFileResult = ptr::null_mut();
+    assert_eq!(
+        anidb_process_file(handle, path.as_ptr(), &options, &mut result),
+        AniDBResult::Success
+    );
+
+    let hash = unsafe {
+        let file_result = &*result;
+        assert_eq!(file_result.hash_count, 1);
+        CStr::from_ptr((*file_result.hashes).hash_value)
+            .to_string_lossy()
+            .into_owned()
+    };
+    anidb_free_file_result(result);
+    hash
+}
+
+fn is_cached(handle: *mut c_void, path: &Path, algorithm: AniDBHashAlgorithm) -> bool {
+    let path = c_path(path);
+    let mut cached: c_int = -1;
+    assert_eq!(
+        anidb_cache_check_file(handle, path.as_ptr(), algorithm, &mut cached),
+        AniDBResult::Success
+    );
+    cached == 1
+}
+
+fn entry_count(handle: *mut c_void) -> usize {
+    let mut entries = 0usize;
+    let mut size_bytes = 0u64;
+    assert_eq!(
+        anidb_cache_get_stats(handle, &mut entries, &mut size_bytes),
+        AniDBResult::Success
+    );
+    entries
+}
+
+#[test]
+fn test_processed_files_are_cached() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = write_file(temp_dir.path(), "episode.mkv", &[7u8; 4096]);
+
+    let handle = create_client(None);
+
+    assert!(!is_cached(handle, &path, AniDBHashAlgorithm::ED2K));
+    assert_eq!(entry_count(handle), 0);
+
+    let hash = process_ed2k(handle, &path);
+    assert!(is_cached(handle, &path, AniDBHashAlgorithm::ED2K));
+    assert!(!is_cached(handle, &path, AniDBHashAlgorithm::CRC32));
+    assert_eq!(entry_count(handle), 1);
+
+    // Same-size contents with the old timestamp restored look unchanged to
+    // stat(), so the cached hash comes back without the file being read
+    let mtime = std::fs::metadata(&path).unwrap().modified().unwrap();
+    std::fs::write(&path, [8u8; 4096]).unwrap();
+    let file = std::fs::File::options().write(true).open(&path).unwrap();
+    file.set_modified(mtime).unwrap();
+    drop(file);
+    assert_eq!(process_ed2k(handle, &path), hash);
+
+    // A real change gives the file a new identity
+    std::fs::write(&path, [8u8; 4097]).unwrap();
+    assert!(!is_cached(handle, &path, AniDBHashAlgorithm::ED2K));
+
+    assert_eq!(anidb_cache_clear(handle), AniDBResult::Success);
+    assert_eq!(entry_count(handle), 0);
+
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_check_files_bulk() {
+    let temp_dir = TempDir::new().unwrap();
+    let first = write_file(temp_dir.path(), "01.mkv", b"first");
+    let second = write_file(temp_dir.path(), "02.mkv", b"second");
+    let missing = temp_dir.path().join("03.mkv");
+
+    let handle = create_client(None);
+    process_ed2k(handle, &second);
+
+    let paths = [c_path(&first), c_path(&second), c_path(&missing)];
+    let pointers: Vec<*const c_char> = paths.iter().map(|p| p.as_ptr()).collect();
+    let mut results: [c_int; 3] = [-1; 3];
+    assert_eq!(
+        anidb_cache_check_files(
+            handle,
+            pointers.as_ptr(),
+            pointers.len(),
+            AniDBHashAlgorithm::ED2K,
+            results.as_mut_ptr(),
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(results, [0, 1, 0]);
+
+    // An empty list needs no buffers
+    assert_eq!(
+        anidb_cache_check_files(
+            handle,
+            ptr::null(),
+            0,
+            AniDBHashAlgorithm::ED2K,
+            ptr::null_mut()
+        ),
+        AniDBResult::Success
+    );
+
+    // A null entry fails the call before any result is written
+    let with_null = [pointers[0], ptr::null()];
+    let mut untouched: [c_int; 2] = [-1; 2];
+    assert_eq!(
+        anidb_cache_check_files(
+            handle,
+            with_null.as_ptr(),
+            with_null.len(),
+            AniDBHashAlgorithm::ED2K,
+            untouched.as_mut_ptr(),
+        ),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(untouched, [-1, -1]);
+
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_prefilter_files() {
+    let temp_dir = TempDir::new().unwrap();
+    let contents: Vec<u8> = (0..3_000_000u32).map(|i| (i % 251) as u8).collect();
+    let original = write_file(temp_dir.path(), "01.mkv", &contents);
+    let copy = write_file(temp_dir.path(), "01 (copy).mkv", &contents);
+    let other = write_file(temp_dir.path(), "02.mkv", &contents[1..]);
+    let missing = temp_dir.path().join("03.mkv");
+
+    let handle = create_client(None);
+    // Hashing the original fingerprints it too
+    process_ed2k(handle, &original);
+
+    let paths = [
+        c_path(&original),
+        c_path(&copy),
+        c_path(&other),
+        c_path(&missing),
+    ];
+    let pointers: Vec<*const c_char> = paths.iter().map(|p| p.as_ptr()).collect();
+    let mut results = [AniDBPrefilterResult::default(); 4];
+    assert_eq!(
+        anidb_cache_prefilter_files(
+            handle,
+            pointers.as_ptr(),
+            pointers.len(),
+            results.as_mut_ptr(),
+        ),
+        AniDBResult::Success
+    );
+
+    let statuses: Vec<AniDBPrefilterStatus> = results.iter().map(|r| r.status).collect();
+    assert_eq!(
+        statuses,
+        [
+            AniDBPrefilterStatus::KnownIdentity,
+            AniDBPrefilterStatus::KnownContent,
+            AniDBPrefilterStatus::Unknown,
+            AniDBPrefilterStatus::Unknown,
+        ]
+    );
+    // A cached identity is answered without reading the file
+    assert_eq!(results[0].bytes_read, 0);
+    assert_eq!(results[1].file_size, contents.len() as u64);
+    assert_ne!(results[1].fingerprint, 0);
+    assert!(results[1].bytes_read < contents.len() as u64 / 2);
+    assert_ne!(results[2].fingerprint, results[1].fingerprint);
+    assert_eq!(results[3].file_size, 0);
+
+    // A null entry fails the call before any result is written
+    let with_null = [pointers[1], ptr::null()];
+    let mut untouched = [AniDBPrefilterResult::default(); 2];
+    untouched[0].file_size = u64::MAX;
+    assert_eq!(
+        anidb_cache_prefilter_files(
+            handle,
+            with_null.as_ptr(),
+            with_null.len(),
+            untouched.as_mut_ptr(),
+        ),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(untouched[0].file_size, u64::MAX);
+
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_cache_persists_across_clients() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = write_file(temp_dir.path(), "episode.mkv", &[3u8; 10_000]);
+    let cache_dir = c_path(&temp_dir.path().join("cache"));
+
+    let handle = create_client(Some(&cache_dir));
+    let hash = process_ed2k(handle, &path);
+    assert_eq!(anidb_client_destroy(handle), AniDBResult::Success);
+
+    let handle = create_client(Some(&cache_dir));
+    assert!(is_cached(handle, &path, AniDBHashAlgorithm::ED2K));
+    assert_eq!(process_ed2k(handle, &path), hash);
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_clients_without_cache() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = write_file(temp_dir.path(), "episode.mkv", &[5u8; 4096]);
+    let mut entries = 0usize;
+    let mut size_bytes = 0u64;
+
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
+    let hash = process_ed2k(handle, &path);
+    assert_eq!(
+        anidb_cache_get_stats(handle, &mut entries, &mut size_bytes),
+        AniDBResult::ErrorCache
+    );
+    assert_eq!(anidb_cache_clear(handle), AniDBResult::ErrorCache);
+    anidb_client_destroy(handle);
+
+    // A zeroed configuration asks for no cache either
+    let config = AniDBConfig::default();
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create_with_config(&config, &mut handle),
+        AniDBResult::Success
+    );
+    assert_eq!(process_ed2k(handle, &path), hash);
+    assert_eq!(
+        anidb_cache_get_stats(handle, &mut entries, &mut size_bytes),
+        AniDBResult::ErrorCache
+    );
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_partial_rehash_after_append() {
+    const CHUNK: usize = 9_728_000;
+    let temp_dir = TempDir::new().unwrap();
+    let contents: Vec<u8> = (0..2 * CHUNK + 100).map(|i| (i % 251) as u8).collect();
+    let path = write_file(temp_dir.path(), "growing.ts", &contents);
+
+    let handle = create_client(None);
+    process_ed2k_with(handle, &path, true);
+
+    // Appending gives the file a new identity but keeps its inode, so the
+    // stored chunk digests are reused for the untouched chunks
+    let mut file = std::fs::File::options().append(true).open(&path).unwrap();
+    std::io::Write::write_all(&mut file, &[9u8; CHUNK]).unwrap();
+    drop(file);
+    let partial = process_ed2k_with(handle, &path, true);
+    assert_eq!(entry_count(handle), 1);
+    anidb_client_destroy(handle);
+
+    let fresh = create_client(None);
+    assert_eq!(process_ed2k(fresh, &path), partial);
+    anidb_client_destroy(fresh);
+}
+
+#[test]
+fn test_invalid_parameters() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = c_path(&write_file(temp_dir.path(), "a.mkv", b"a"));
+    let mut cached: c_int = 0;
+    let mut entries = 0usize;
+    let mut size_bytes = 0u64;
+
+    assert_eq!(
+        anidb_cache_clear(ptr::null_mut()),
+        AniDBResult::ErrorInvalidHandle
+    );
+    assert_eq!(
+        anidb_cache_check_file(
+            999_999 as *mut c_void,
+            path.as_ptr(),
+            AniDBHashAlgorithm::ED2K,
+            &mut cached
+        ),
+        AniDBResult::ErrorInvalidHandle
+    );
+
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
+    assert_eq!(
+        anidb_cache_get_stats(handle, ptr::null_mut(), &mut size_bytes),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(
+        anidb_cache_get_stats(handle, &mut entries, ptr::null_mut()),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(
+        anidb_cache_check_file(handle, ptr::null(), AniDBHashAlgorithm::ED2K, &mut cached),
+        AniDBResult::ErrorInvalidParameter
+    );
+    anidb_client_destroy(handle);
+}
@@ -5,11 +5,13 @@
 //! Tests the comprehensive callback system for progress, errors, completion, and events.
 
 use anidb_client_core::ffi::{
-    AniDBCallbackType, AniDBConfig, AniDBEvent, AniDBFileResult, AniDBHashAlgorithm,
-    AniDBProcessOptions, AniDBResult, anidb_cleanup, anidb_client_create_with_config,
-    anidb_client_destroy, anidb_event_connect, anidb_event_disconnect, anidb_event_poll,
-    anidb_free_file_result, anidb_init, anidb_process_file, anidb_register_callback,
-    anidb_unregister_callback,
+    ANIDB_ABI_VERSION, ANIDB_EVENT_MASK_ALL, AniDBCallbackType, AniDBConfig, AniDBEvent,
+    AniDBEventType, AniDBFileResult, AniDBHashAlgorithm, AniDBProcessOptions, AniDBResult,
+    anidb_cleanup, anidb_client_create_with_config, anidb_client_destroy, anidb_event_connect,
+    anidb_event_disconnect, anidb_event_poll, anidb_event_ring_attach, anidb_event_ring_detach,
+    anidb_event_ring_dropped, anidb_event_ring_poll, anidb_event_ring_size,
+    anidb_event_set_callback_mask, anidb_event_set_mask, anidb_free_file_result, anidb_init,
+    anidb_process_file, anidb_register_callback, anidb_unregister_callback,
 };
 use std::ffi::{CStr, CString};
 use std::ptr;
@@ -102,18 +104,13 @@ extern "C" fn event_callback(event: *const AniDBEvent, user_data: *mut std::ffi:
 #[test]
 #[serial_test::serial]
 fn test_callback_registration() {
-    anidb_init(1);
+    anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let config = AniDBConfig {
         max_concurrent_files: 1,
         chunk_size: 65536,
-        max_memory_usage: 0,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     assert_eq!(
@@ -153,7 +150,7 @@ fn test_callback_registration() {
 #[test]
 #[serial_test::serial]
 fn test_progress_callbacks() {
-    anidb_init(1);
+    anidb_init(ANIDB_ABI_VERSION);
 
     let temp_dir = TempDir::new().unwrap();
     let test_file = temp_dir.path().join("test.bin");
@@ -163,12 +160,7 @@ fn test_progress_callbacks() {
     let config = AniDBConfig {
         max_concurrent_files: 1,
         chunk_size: 65536,
-        max_memory_usage: 0,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     assert_eq!(
@@ -195,8 +187,7 @@ fn test_progress_callbacks() {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
         enable_progress: 1,
-        progress_callback: None, // Using registered callback instead
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result: *mut AniDBFileResult = ptr::null_mut();
@@ -222,18 +213,13 @@ fn test_progress_callbacks() {
 #[test]
 #[serial_test::serial]
 fn test_error_callbacks() {
-    anidb_init(1);
+    anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let config = AniDBConfig {
         max_concurrent_files: 1,
         chunk_size: 65536,
-        max_memory_usage: 0,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     assert_eq!(
@@ -259,9 +245,7 @@ fn test_error_callbacks() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result: *mut AniDBFileResult = ptr::null_mut();
@@ -282,18 +266,13 @@ fn test_error_callbacks() {
 #[test]
 #[serial_test::serial]
 fn test_event_system() {
-    anidb_init(1);
+    anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let config = AniDBConfig {
         max_concurrent_files: 1,
         chunk_size: 65536,
-        max_memory_usage: 0,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     assert_eq!(
@@ -321,8 +300,7 @@ fn test_event_system() {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
         enable_progress: 1,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result: *mut AniDBFileResult = ptr::null_mut();
@@ -355,22 +333,296 @@ fn test_event_system() {
     anidb_cleanup();
 }
 
+/// Test that the queue and the callback filter events independently
+#[test]
+#[serial_test::serial]
+fn test_queue_and_callback_masks() {
+    anidb_init(ANIDB_ABI_VERSION);
+
+    let mut handle: *mut std::ffi::c_void = ptr::null_mut();
+    let config = AniDBConfig {
+        max_concurrent_files: 1,
+        chunk_size: 65536,
+        ..Default::default()
+    };
+
+    assert_eq!(
+        anidb_client_create_with_config(&config, &mut handle),
+        AniDBResult::Success
+    );
+
+    let context = CallbackTestContext::new();
+    let context_ptr = Arc::as_ptr(&context) as *mut std::ffi::c_void;
+    assert_eq!(
+        anidb_event_connect(handle, event_callback, context_ptr),
+        AniDBResult::Success
+    );
+
+    // Nothing for the queue, only completions for the callback
+    assert_eq!(anidb_event_set_mask(handle, 0), AniDBResult::Success);
+    assert_eq!(
+        anidb_event_set_callback_mask(handle, 1 << AniDBEventType::FileComplete as u32),
+        AniDBResult::Success
+    );
+
+    let temp_dir = TempDir::new().unwrap();
+    let test_file = temp_dir.path().join("masks.bin");
+    std::fs::write(&test_file, vec![0u8; 1024]).unwrap();
+
+    let file_path_cstr = CString::new(test_file.to_str().unwrap()).unwrap();
+    let algorithms = [AniDBHashAlgorithm::ED2K];
+    let options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        ..Default::default()
+    };
+
+    let mut result: *mut AniDBFileResult = ptr::null_mut();
+    assert_eq!(
+        anidb_process_file(handle, file_path_cstr.as_ptr(), &options, &mut result),
+        AniDBResult::Success
+    );
+    anidb_free_file_result(result);
+
+    let mut events = [AniDBEvent::default(); 16];
+    let mut event_count = usize::MAX;
+    assert_eq!(
+        anidb_event_poll(handle, events.as_mut_ptr(), events.len(), &mut event_count),
+        AniDBResult::Success
+    );
+    assert_eq!(event_count, 0);
+
+    // Disconnecting delivers what the event thread still holds
+    assert_eq!(anidb_event_disconnect(handle), AniDBResult::Success);
+    let received = context.events.lock().unwrap();
+    assert_eq!(received.len(), 1);
+    assert_eq!(received[0].event_type, AniDBEventType::FileComplete);
+    drop(received);
+
+    assert_eq!(anidb_client_destroy(handle), AniDBResult::Success);
+    anidb_cleanup();
+}
+
+/// Test that events are not queued before anybody reads them
+#[test]
+#[serial_test::serial]
+fn test_events_wait_for_a_subscriber() {
+    anidb_init(ANIDB_ABI_VERSION);
+
+    let mut handle: *mut std::ffi::c_void = ptr::null_mut();
+    let config = AniDBConfig {
+        max_concurrent_files: 1,
+        chunk_size: 65536,
+        ..Default::default()
+    };
+
+    assert_eq!(
+        anidb_client_create_with_config(&config, &mut handle),
+        AniDBResult::Success
+    );
+
+    let temp_dir = TempDir::new().unwrap();
+    let test_file = temp_dir.path().join("unread.bin");
+    std::fs::write(&test_file, vec![0u8; 1024]).unwrap();
+
+    let file_path_cstr = CString::new(test_file.to_str().unwrap()).unwrap();
+    let algorithms = [AniDBHashAlgorithm::CRC32];
+    let options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        ..Default::default()
+    };
+    let process = || {
+        let mut result: *mut AniDBFileResult = ptr::null_mut();
+        assert_eq!(
+            anidb_process_file(handle, file_path_cstr.as_ptr(), &options, &mut result),
+            AniDBResult::Success
+        );
+        anidb_free_file_result(result);
+    };
+    let mut events = [AniDBEvent::default(); 16];
+    let mut poll = || {
+        let mut event_count = usize::MAX;
+        assert_eq!(
+            anidb_event_poll(handle, events.as_mut_ptr(), events.len(), &mut event_count),
+            AniDBResult::Success
+        );
+        event_count
+    };
+
+    // Nobody polled or connected yet
+    process();
+    assert_eq!(poll(), 0);
+
+    // Polling once subscribes the queue
+    process();
+    assert_eq!(poll(), 2);
+
+    // A disconnected callback gets nothing
+    let context = CallbackTestContext::new();
+    let context_ptr = Arc::as_ptr(&context) as *mut std::ffi::c_void;
+    assert_eq!(
+        anidb_event_connect(handle, event_callback, context_ptr),
+        AniDBResult::Success
+    );
+    assert_eq!(anidb_event_disconnect(handle), AniDBResult::Success);
+    process();
+    assert!(context.events.lock().unwrap().is_empty());
+
+    assert_eq!(anidb_client_destroy(handle), AniDBResult::Success);
+    anidb_cleanup();
+}
+
+/// Test filtered events delivered through a caller-owned ring
+#[test]
+#[serial_test::serial]
+fn test_event_ring() {
+    anidb_init(ANIDB_ABI_VERSION);
+
+    let mut handle: *mut std::ffi::c_void = ptr::null_mut();
+    let config = AniDBConfig {
+        max_concurrent_files: 1,
+        chunk_size: 65536,
+        ..Default::default()
+    };
+
+    assert_eq!(
+        anidb_client_create_with_config(&config, &mut handle),
+        AniDBResult::Success
+    );
+
+    // u64 storage keeps the ring 8-byte aligned
+    assert_eq!(anidb_event_ring_size(3), 0);
+    assert_eq!(anidb_event_ring_size(1), 0);
+    let ring_size = anidb_event_ring_size(8);
+    let mut ring = vec![0u64; ring_size / 8];
+    let ring_ptr = ring.as_mut_ptr() as *mut std::ffi::c_void;
+    let mut capacity = 0usize;
+    assert_eq!(
+        anidb_event_ring_attach(
+            handle,
+            ring_ptr,
+            ring_size,
+            1 << AniDBEventType::FileComplete as u32,
+            &mut capacity,
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(capacity, 8);
+
+    // Nothing goes to the queue
+    assert_eq!(anidb_event_set_mask(handle, 0), AniDBResult::Success);
+
+    let temp_dir = TempDir::new().unwrap();
+    let test_file = temp_dir.path().join("ring.bin");
+    std::fs::write(&test_file, vec![0u8; 1024]).unwrap();
+
+    let file_path_cstr = CString::new(test_file.to_str().unwrap()).unwrap();
+    let algorithms = [AniDBHashAlgorithm::ED2K];
+    let options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        ..Default::default()
+    };
+
+    let mut result: *mut AniDBFileResult = ptr::null_mut();
+    for _ in 0..2 {
+        assert_eq!(
+            anidb_process_file(handle, file_path_cstr.as_ptr(), &options, &mut result),
+            AniDBResult::Success
+        );
+        anidb_free_file_result(result);
+    }
+
+    let mut events = [AniDBEvent::default(); 16];
+    let mut event_count = 0usize;
+    assert_eq!(
+        anidb_event_ring_poll(
+            ring_ptr,
+            events.as_mut_ptr(),
+            events.len(),
+            &mut event_count
+        ),
+        AniDBResult::Success
+    );
+
+    // Only the completions, with their strings stored in the ring
+    assert_eq!(event_count, 2);
+    for event in &events[..event_count] {
+        assert_eq!(event.event_type, AniDBEventType::FileComplete);
+        let path = unsafe { CStr::from_ptr(event.data.file.file_path) };
+        assert_eq!(path.to_str().unwrap(), test_file.to_str().unwrap());
+        let context = unsafe { CStr::from_ptr(event.context) };
+        assert!(context.to_str().unwrap().starts_with("Processed in"));
+        assert!(
+            (ring_ptr as usize..ring_ptr as usize + ring_size).contains(&(event.context as usize))
+        );
+    }
+
+    let mut dropped = u64::MAX;
+    assert_eq!(
+        anidb_event_ring_dropped(ring_ptr, &mut dropped),
+        AniDBResult::Success
+    );
+    assert_eq!(dropped, 0);
+
+    assert_eq!(
+        anidb_event_poll(handle, events.as_mut_ptr(), events.len(), &mut event_count),
+        AniDBResult::Success
+    );
+    assert_eq!(event_count, 0);
+
+    // Detached rings and reset masks go back to the queue
+    assert_eq!(anidb_event_ring_detach(handle), AniDBResult::Success);
+    assert_eq!(
+        anidb_event_set_mask(handle, ANIDB_EVENT_MASK_ALL),
+        AniDBResult::Success
+    );
+    anidb_process_file(handle, file_path_cstr.as_ptr(), &options, &mut result);
+    anidb_free_file_result(result);
+    assert_eq!(
+        anidb_event_ring_poll(
+            ring_ptr,
+            events.as_mut_ptr(),
+            events.len(),
+            &mut event_count
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(event_count, 0);
+    assert_eq!(
+        anidb_event_poll(handle, events.as_mut_ptr(), events.len(), &mut event_count),
+        AniDBResult::Success
+    );
+    assert_eq!(event_count, 2);
+
+    // Memory that holds no ring is rejected
+    let mut other = vec![0u64; ring_size / 8];
+    assert_eq!(
+        anidb_event_ring_poll(
+            other.as_mut_ptr() as *mut std::ffi::c_void,
+            events.as_mut_ptr(),
+            events.len(),
+            &mut event_count,
+        ),
+        AniDBResult::ErrorInvalidParameter
+    );
+
+    assert_eq!(anidb_client_destroy(handle), AniDBResult::Success);
+    anidb_cleanup();
+}
+
 /// Test callback with context data
 #[test]
 #[serial_test::serial]
 fn test_callback_context() {
-    anidb_init(1);
+    anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let config = AniDBConfig {
         max_concurrent_files: 1,
         chunk_size: 65536,
-        max_memory_usage: 0,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     assert_eq!(
@@ -428,8 +680,7 @@ fn test_callback_context() {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
         enable_progress: 1,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result: *mut AniDBFileResult = ptr::null_mut();
@@ -450,18 +701,13 @@ fn test_callback_context() {
 #[test]
 #[serial_test::serial]
 fn test_callback_thread_safety() {
-    anidb_init(1);
+    anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let config = AniDBConfig {
         max_concurrent_files: 4,
         chunk_size: 65536,
-        max_memory_usage: 0,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     assert_eq!(
@@ -502,8 +748,7 @@ fn test_callback_thread_safety() {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
             enable_progress: 1,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result: *mut AniDBFileResult = ptr::null_mut();
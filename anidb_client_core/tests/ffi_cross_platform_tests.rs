@@ -4,8 +4,8 @@
 //! Windows, Linux, and macOS
 
 use anidb_client_core::ffi::{
-    AniDBConfig, AniDBHashAlgorithm, AniDBProcessOptions, AniDBResult, anidb_cleanup,
-    anidb_client_create, anidb_client_create_with_config, anidb_client_destroy,
+    ANIDB_ABI_VERSION, AniDBConfig, AniDBHashAlgorithm, AniDBProcessOptions, AniDBResult,
+    anidb_cleanup, anidb_client_create, anidb_client_create_with_config, anidb_client_destroy,
     anidb_free_file_result, anidb_init, anidb_process_file,
 };
 use std::ffi::CString;
@@ -17,7 +17,7 @@ use tempfile::TempDir;
 #[test]
 #[serial_test::serial]
 fn test_ffi_platform_path_handling() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -73,9 +73,7 @@ fn test_ffi_platform_path_handling() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
@@ -100,7 +98,7 @@ fn test_ffi_platform_path_handling() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_long_path_support() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -134,9 +132,7 @@ fn test_ffi_long_path_support() {
             let options = AniDBProcessOptions {
                 algorithms: algorithms.as_ptr(),
                 algorithm_count: algorithms.len(),
-                enable_progress: 0,
-                progress_callback: None,
-                user_data: ptr::null_mut(),
+                ..Default::default()
             };
 
             let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
@@ -168,7 +164,7 @@ fn test_ffi_long_path_support() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_platform_permissions() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -193,9 +189,7 @@ fn test_ffi_platform_permissions() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
@@ -245,9 +239,7 @@ fn test_ffi_platform_permissions() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut anidb_client_core::ffi::AniDBFileResult = ptr::null_mut();
@@ -272,7 +264,7 @@ fn test_ffi_platform_permissions() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_platform_performance() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let temp_dir = TempDir::new().unwrap();
 
@@ -291,11 +283,7 @@ fn test_ffi_platform_performance() {
         max_concurrent_files: 4,
         chunk_size,
         max_memory_usage: 500 * 1024 * 1024,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -339,9 +327,7 @@ fn test_ffi_platform_performance() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let start = std::time::Instant::now();
@@ -0,0 +1,166 @@
+//! Incremental Hasher Tests for FFI
+//!
+//! Tests the `anidb_hasher_*` API: piecewise updates must produce the same
+//! hashes as hashing the whole buffer, and the handle lifecycle must reject
+//! use after finalize or destroy.
+
+use anidb_client_core::ffi::{
+    AniDBHashAlgorithm, AniDBResult, anidb_calculate_hashes_buffer, anidb_hash_buffer_size,
+    anidb_hasher_create, anidb_hasher_destroy, anidb_hasher_finalize,
+    anidb_hasher_get_bytes_processed, anidb_hasher_update,
+};
+use std::ffi::{CStr, c_char, c_void};
+use std::ptr;
+
+/// Output buffers sized for each algorithm
+struct HashOutputs {
+    buffers: Vec<Vec<c_char>>,
+    pointers: Vec<*mut c_char>,
+    sizes: Vec<usize>,
+}
+
+impl HashOutputs {
+    fn new(algorithms: &[AniDBHashAlgorithm]) -> Self {
+        let mut buffers: Vec<Vec<c_char>> = algorithms
+            .iter()
+            .map(|a| vec![0 as c_char; anidb_hash_buffer_size(*a)])
+            .collect();
+        let pointers = buffers.iter_mut().map(|b| b.as_mut_ptr()).collect();
+        let sizes = buffers.iter().map(|b| b.len()).collect();
+        Self {
+            buffers,
+            pointers,
+            sizes,
+        }
+    }
+
+    fn hashes(&self) -> Vec<String> {
+        self.buffers
+            .iter()
+            .map(|b| {
+                unsafe { CStr::from_ptr(b.as_ptr()) }
+                    .to_string_lossy()
+                    .into_owned()
+            })
+            .collect()
+    }
+}
+
+fn create_hasher(algorithms: &[AniDBHashAlgorithm]) -> *mut c_void {
+    let mut hasher: *mut c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_hasher_create(algorithms.as_ptr(), algorithms.len(), &mut hasher),
+        AniDBResult::Success
+    );
+    assert!(!hasher.is_null());
+    hasher
+}
+
+/// Test that uneven pieces across ED2K chunk boundaries match one-shot hashing
+#[test]
+fn test_hasher_matches_buffer_hashing() {
+    let algorithms = [
+        AniDBHashAlgorithm::ED2K,
+        AniDBHashAlgorithm::CRC32,
+        AniDBHashAlgorithm::SHA1,
+    ];
+    // Just over two ED2K chunks
+    let data: Vec<u8> = (0..2 * 9_728_000 + 4321).map(|i| (i % 253) as u8).collect();
+
+    let hasher = create_hasher(&algorithms);
+    for piece in data.chunks(65_537) {
+        assert_eq!(
+            anidb_hasher_update(hasher, piece.as_ptr(), piece.len()),
+            AniDBResult::Success
+        );
+    }
+
+    let mut processed = 0u64;
+    assert_eq!(
+        anidb_hasher_get_bytes_processed(hasher, &mut processed),
+        AniDBResult::Success
+    );
+    assert_eq!(processed, data.len() as u64);
+
+    let streamed = HashOutputs::new(&algorithms);
+    assert_eq!(
+        anidb_hasher_finalize(hasher, streamed.pointers.as_ptr(), streamed.sizes.as_ptr()),
+        AniDBResult::Success
+    );
+
+    let whole = HashOutputs::new(&algorithms);
+    assert_eq!(
+        anidb_calculate_hashes_buffer(
+            data.as_ptr(),
+            data.len(),
+            algorithms.as_ptr(),
+            algorithms.len(),
+            whole.pointers.as_ptr(),
+            whole.sizes.as_ptr(),
+        ),
+        AniDBResult::Success
+    );
+    assert_eq!(streamed.hashes(), whole.hashes());
+
+    assert_eq!(anidb_hasher_destroy(hasher), AniDBResult::Success);
+}
+
+/// Test the hasher lifecycle and error reporting
+#[test]
+fn test_hasher_lifecycle() {
+    let algorithms = [AniDBHashAlgorithm::MD5];
+    let hasher = create_hasher(&algorithms);
+
+    // Empty updates are accepted without data
+    assert_eq!(
+        anidb_hasher_update(hasher, ptr::null(), 0),
+        AniDBResult::Success
+    );
+    assert_eq!(
+        anidb_hasher_update(hasher, b"abc".as_ptr(), 3),
+        AniDBResult::Success
+    );
+
+    // A short buffer is rejected without consuming the hasher
+    let mut short = vec![0 as c_char; 4];
+    let short_ptrs = [short.as_mut_ptr()];
+    let short_sizes = [short.len()];
+    assert_eq!(
+        anidb_hasher_finalize(hasher, short_ptrs.as_ptr(), short_sizes.as_ptr()),
+        AniDBResult::ErrorInvalidParameter
+    );
+
+    let outputs = HashOutputs::new(&algorithms);
+    assert_eq!(
+        anidb_hasher_finalize(hasher, outputs.pointers.as_ptr(), outputs.sizes.as_ptr()),
+        AniDBResult::Success
+    );
+    assert_eq!(outputs.hashes(), ["900150983cd24fb0d6963f7d28e17f72"]);
+
+    // Finalized hashers take no more input
+    assert_eq!(
+        anidb_hasher_update(hasher, b"abc".as_ptr(), 3),
+        AniDBResult::ErrorProcessing
+    );
+    assert_eq!(
+        anidb_hasher_finalize(hasher, outputs.pointers.as_ptr(), outputs.sizes.as_ptr()),
+        AniDBResult::ErrorProcessing
+    );
+
+    assert_eq!(anidb_hasher_destroy(hasher), AniDBResult::Success);
+    assert_eq!(
+        anidb_hasher_destroy(hasher),
+        AniDBResult::ErrorInvalidHandle
+    );
+    assert_eq!(
+        anidb_hasher_update(hasher, b"abc".as_ptr(), 3),
+        AniDBResult::ErrorInvalidHandle
+    );
+
+    // No algorithms is a parameter error
+    let mut invalid: *mut c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_hasher_create(algorithms.as_ptr(), 0, &mut invalid),
+        AniDBResult::ErrorInvalidParameter
+    );
+}
@@ -0,0 +1,301 @@
+//! Identification Tests for FFI
+//!
+//! Tests `anidb_identify_file` and `anidb_identify_batch` without touching
+//! the network: argument validation, empty batches, the error reported for
+//! every file when the client has no AniDB credentials, and files answered
+//! from a loaded identification index.
+
+use anidb_client_core::ffi::{
+    AniDBAnimeInfo, AniDBResult, anidb_client_create, anidb_client_destroy, anidb_free_anime_info,
+    anidb_identify_batch, anidb_identify_file, anidb_identify_index_export,
+    anidb_identify_index_load,
+};
+use anidb_client_core::identification::{IdentificationIndex, IndexEntry};
+use std::ffi::{CStr, CString, c_char, c_int, c_void};
+use std::path::Path;
+use std::ptr;
+use tempfile::TempDir;
+
+const HASH_A: &str = "0123456789abcdef0123456789abcdef";
+const HASH_B: &str = "FEDCBA9876543210FEDCBA9876543210";
+
+/// Records every (index, result, had info) the batch reports
+extern "C" fn record(
+    index: usize,
+    result: AniDBResult,
+    info: *const AniDBAnimeInfo,
+    user_data: *mut c_void,
+) -> c_int {
+    let seen = unsafe { &mut *(user_data as *mut Vec<(usize, AniDBResult, bool)>) };
+    seen.push((index, result, !info.is_null()));
+    0
+}
+
+/// Stops the batch after the first report
+extern "C" fn stop_after_first(
+    index: usize,
+    result: AniDBResult,
+    info: *const AniDBAnimeInfo,
+    user_data: *mut c_void,
+) -> c_int {
+    record(index, result, info, user_data);
+    1
+}
+
+fn create_client() -> *mut c_void {
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
+    handle
+}
+
+fn run_batch(
+    handle: *mut c_void,
+    hashes: &[&str],
+    sizes: &[u64],
+    callback: Option<anidb_client_core::ffi::AniDBIdentifyCallback>,
+) -> (AniDBResult, Vec<(usize, AniDBResult, bool)>) {
+    let hashes: Vec<CString> = hashes.iter().map(|h| CString::new(*h).unwrap()).collect();
+    let pointers: Vec<*const c_char> = hashes.iter().map(|h| h.as_ptr()).collect();
+    let mut seen: Vec<(usize, AniDBResult, bool)> = Vec::new();
+    let result = anidb_identify_batch(
+        handle,
+        pointers.as_ptr(),
+        sizes.as_ptr(),
+        pointers.len(),
+        callback,
+        &mut seen as *mut _ as *mut c_void,
+    );
+    (result, seen)
+}
+
+#[test]
+fn test_identify_file_invalid_parameters() {
+    let handle = create_client();
+    let hash = CString::new(HASH_A).unwrap();
+    let mut info: *mut AniDBAnimeInfo = ptr::null_mut();
+
+    assert_eq!(
+        anidb_identify_file(ptr::null_mut(), hash.as_ptr(), 1, &mut info),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(
+        anidb_identify_file(handle, ptr::null(), 1, &mut info),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(
+        anidb_identify_file(handle, hash.as_ptr(), 1, ptr::null_mut()),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(
+        anidb_identify_file(999_999 as *mut c_void, hash.as_ptr(), 1, &mut info),
+        AniDBResult::ErrorInvalidHandle
+    );
+
+    // Hashes must be 32 hex characters
+    for bad in ["", "abc", "0123456789abcdef0123456789abcdeg"] {
+        let bad = CString::new(bad).unwrap();
+        assert_eq!(
+            anidb_identify_file(handle, bad.as_ptr(), 1, &mut info),
+            AniDBResult::ErrorInvalidParameter
+        );
+    }
+    assert!(info.is_null());
+
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_identify_without_credentials() {
+    let handle = create_client();
+    let hash = CString::new(HASH_A).unwrap();
+    let mut info: *mut AniDBAnimeInfo = ptr::null_mut();
+
+    assert_eq!(
+        anidb_identify_file(handle, hash.as_ptr(), 1024, &mut info),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert!(info.is_null());
+
+    // Every index is reported, duplicates included, without an info
+    let (result, mut seen) = run_batch(
+        handle,
+        &[HASH_A, HASH_B, &HASH_A.to_uppercase()],
+        &[1024, 2048, 1024],
+        Some(record),
+    );
+    assert_eq!(result, AniDBResult::Success);
+    seen.sort_by_key(|(index, _, _)| *index);
+    assert_eq!(
+        seen,
+        [
+            (0, AniDBResult::ErrorInvalidParameter, false),
+            (1, AniDBResult::ErrorInvalidParameter, false),
+            (2, AniDBResult::ErrorInvalidParameter, false),
+        ]
+    );
+
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_identify_batch_stops_when_asked() {
+    let handle = create_client();
+
+    let (result, seen) = run_batch(
+        handle,
+        &[HASH_A, HASH_B],
+        &[1024, 2048],
+        Some(stop_after_first),
+    );
+    assert_eq!(result, AniDBResult::Success);
+    assert_eq!(seen.len(), 1);
+
+    anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_identify_batch_invalid_parameters() {
+    let handle = create_client();
+
+    // An empty batch needs no arrays
+    let mut seen: Vec<(usize, AniDBResult, bool)> = Vec::new();
+    assert_eq!(
+        anidb_identify_batch(
+            handle,
+            ptr::null(),
+            ptr::null(),
+            0,
+            Some(record),
+            &mut seen as *mut _ as *mut c_void,
+        ),
+        AniDBResult::Success
+    );
+    assert!(seen.is_empty());
+
+    assert_eq!(
+        run_batch(handle, &[HASH_A], &[1], None).0,
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(
+        anidb_identify_batch(
+            handle,
+            ptr::null(),
+            ptr::null(),
+            1,
+            Some(record),
+            ptr::null_mut()
+        ),
+        AniDBResult::ErrorInvalidParameter
+    );
+
+    // A malformed hash fails the call before anything is reported
+    let (result, seen) = run_batch(handle, &[HASH_A, "not a hash"], &[1, 2], Some(record));
+    assert_eq!(result, AniDBResult::ErrorInvalidParameter);
+    assert!(seen.is_empty());
+
+    anidb_client_destroy(handle);
+}
+
+fn load_index(handle: *mut c_void, path: &Path) -> (AniDBResult, usize) {
+    let path = CString::new(path.to_str().unwrap()).unwrap();
+    let mut entries = 0usize;
+    let result = anidb_identify_index_load(handle, path.as_ptr(), &mut entries);
+    (result, entries)
+}
+
+#[test]
+fn test_identify_from_index() {
+    let temp_dir = TempDir::new().unwrap();
+    let index_path = temp_dir.path().join("ident.idx");
+    IdentificationIndex::write(
+        &index_path,
+        [IndexEntry {
+            ed2k: HASH_A.to_string(),
+            size: 1024,
+            fid: 11,
+            aid: 22,
+            eid: 33,
+            title: "Indexed Show".to_string(),
+            episode: "S4".to_string(),
+        }],
+    )
+    .unwrap();
+
+    let handle = create_client();
+    assert_eq!(load_index(handle, &index_path), (AniDBResult::Success, 1));
+
+    // Indexed files are identified without credentials or network
+    let hash = CString::new(HASH_A.to_uppercase()).unwrap();
+    let mut info: *mut AniDBAnimeInfo = ptr::null_mut();
+    assert_eq!(
+        anidb_identify_file(handle, hash.as_ptr(), 1024, &mut info),
+        AniDBResult::Success
+    );
+    unsafe {
+        let anime = &*info;
+        assert_eq!(anime.anime_id, 22);
+        assert_eq!(anime.episode_id, 33);
+        assert_eq!(anime.episode_number, 4);
+        assert_eq!(anime.source, 1);
+        assert_eq!(
+            CStr::from_ptr(anime.title).to_str().unwrap(),
+            "Indexed Show"
+        );
+    }
+    anidb_free_anime_info(info);
+
+    let (result, mut seen) = run_batch(handle, &[HASH_B, HASH_A], &[1024, 1024], Some(record));
+    assert_eq!(result, AniDBResult::Success);
+    seen.sort_by_key(|(index, _, _)| *index);
+    assert_eq!(
+        seen,
+        [
+            (0, AniDBResult::ErrorInvalidParameter, false),
+            (1, AniDBResult::Success, true),
+        ]
+    );
+
+    // An export carries the index over to another client
+    let exported = CString::new(temp_dir.path().join("export.idx").to_str().unwrap()).unwrap();
+    let mut written = 0usize;
+    assert_eq!(
+        anidb_identify_index_export(handle, exported.as_ptr(), &mut written),
+        AniDBResult::Success
+    );
+    assert_eq!(written, 1);
+    anidb_client_destroy(handle);
+
+    let other = create_client();
+    assert_eq!(
+        load_index(other, &temp_dir.path().join("export.idx")),
+        (AniDBResult::Success, 1)
+    );
+    let mut info: *mut AniDBAnimeInfo = ptr::null_mut();
+    assert_eq!(
+        anidb_identify_file(other, hash.as_ptr(), 1024, &mut info),
+        AniDBResult::Success
+    );
+    anidb_free_anime_info(info);
+    anidb_client_destroy(other);
+}
+
+#[test]
+fn test_index_load_errors() {
+    let temp_dir = TempDir::new().unwrap();
+    let handle = create_client();
+
+    assert_eq!(
+        load_index(handle, &temp_dir.path().join("missing.idx")).0,
+        AniDBResult::ErrorFileNotFound
+    );
+
+    let garbage = temp_dir.path().join("garbage.idx");
+    std::fs::write(&garbage, b"definitely not an index file").unwrap();
+    assert_eq!(load_index(handle, &garbage).0, AniDBResult::ErrorCache);
+
+    assert_eq!(
+        anidb_identify_index_load(handle, ptr::null(), ptr::null_mut()),
+        AniDBResult::ErrorInvalidParameter
+    );
+    anidb_client_destroy(handle);
+}
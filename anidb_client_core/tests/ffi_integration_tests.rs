@@ -8,7 +8,7 @@
 //! - Platform-specific behavior
 
 use anidb_client_core::ffi::{
-    AniDBCallbackType, AniDBConfig, AniDBEvent, AniDBEventType, AniDBFileResult,
+    ANIDB_ABI_VERSION, AniDBCallbackType, AniDBConfig, AniDBEvent, AniDBEventType, AniDBFileResult,
     AniDBHashAlgorithm, AniDBMemoryStats, AniDBProcessOptions, AniDBResult, AniDBStatus,
     anidb_check_memory_leaks, anidb_cleanup, anidb_client_create, anidb_client_create_with_config,
     anidb_client_destroy, anidb_event_connect, anidb_event_disconnect, anidb_free_file_result,
@@ -100,7 +100,7 @@ impl TestFileManager {
 #[serial_test::serial]
 fn test_ffi_multi_threaded_access() {
     // Initialize library
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
     let metrics = Arc::new(TestMetrics::default());
@@ -144,9 +144,7 @@ fn test_ffi_multi_threaded_access() {
                 let options = AniDBProcessOptions {
                     algorithms: algorithms.as_ptr(),
                     algorithm_count: algorithms.len(),
-                    enable_progress: 0,
-                    progress_callback: None,
-                    user_data: ptr::null_mut(),
+                    ..Default::default()
                 };
 
                 let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -208,7 +206,7 @@ fn test_ffi_multi_threaded_access() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_thread_safety_shared_client() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
     let test_file = file_manager.create_file("shared_test.mkv", 10 * 1024 * 1024);
@@ -242,9 +240,7 @@ fn test_ffi_thread_safety_shared_client() {
             let options = AniDBProcessOptions {
                 algorithms: algorithms.as_ptr(),
                 algorithm_count: algorithms.len(),
-                enable_progress: 0,
-                progress_callback: None,
-                user_data: ptr::null_mut(),
+                ..Default::default()
             };
 
             let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -283,7 +279,7 @@ fn test_ffi_thread_safety_shared_client() {
 #[serial_test::serial]
 #[ignore] // Ignored by default due to disk space requirements
 fn test_ffi_large_file_processing() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
     let large_file = file_manager.create_large_file("large_test.mkv", 1.5); // 1.5GB
@@ -291,13 +287,10 @@ fn test_ffi_large_file_processing() {
     // Create client with appropriate config
     let config = AniDBConfig {
         max_concurrent_files: 1,
-        chunk_size: 64 * 1024,               // 64KB chunks
-        max_memory_usage: 500 * 1024 * 1024, // 500MB limit
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        chunk_size: 64 * 1024,
+        // 64KB chunks
+        max_memory_usage: 500 * 1024 * 1024,
+        ..Default::default()
     };
 
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -358,6 +351,7 @@ fn test_ffi_large_file_processing() {
         enable_progress: 1,
         progress_callback: Some(progress_callback),
         user_data: user_data_ptr,
+        ..Default::default()
     };
 
     let start = Instant::now();
@@ -412,7 +406,7 @@ fn test_ffi_large_file_processing() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_error_conditions() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
 
@@ -428,9 +422,7 @@ fn test_ffi_error_conditions() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -466,11 +458,8 @@ fn test_ffi_error_conditions() {
 
     // Null algorithms
     let bad_options = AniDBProcessOptions {
-        algorithms: ptr::null(),
         algorithm_count: 1,
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
     let result = anidb_process_file(
         client_handle,
@@ -483,10 +472,7 @@ fn test_ffi_error_conditions() {
     // Zero algorithm count
     let bad_options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
-        algorithm_count: 0,
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
     let result = anidb_process_file(
         client_handle,
@@ -521,7 +507,7 @@ fn test_ffi_error_conditions() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_memory_stress() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
     let test_files: Vec<_> = (0..50)
@@ -566,9 +552,7 @@ fn test_ffi_memory_stress() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -630,7 +614,7 @@ fn test_ffi_memory_stress() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_platform_specific() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
 
@@ -653,9 +637,7 @@ fn test_ffi_platform_specific() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -678,9 +660,7 @@ fn test_ffi_platform_specific() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -700,9 +680,7 @@ fn test_ffi_platform_specific() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let start = Instant::now();
@@ -732,7 +710,7 @@ fn test_ffi_platform_specific() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_event_system() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
     let test_file = file_manager.create_file("event_test.mkv", 5 * 1024 * 1024);
@@ -770,8 +748,7 @@ fn test_ffi_event_system() {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
         enable_progress: 1,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -807,7 +784,7 @@ fn test_ffi_event_system() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_callback_management() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     // Create client
     let mut client_handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -884,8 +861,7 @@ fn test_ffi_callback_management() {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
         enable_progress: 1,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -933,7 +909,7 @@ fn test_ffi_callback_management() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_race_condition_detection() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
     let test_file = file_manager.create_file("race_test.mkv", 1024 * 1024);
@@ -977,9 +953,7 @@ fn test_ffi_race_condition_detection() {
             let options = AniDBProcessOptions {
                 algorithms: algorithms.as_ptr(),
                 algorithm_count: algorithms.len(),
-                enable_progress: 0,
-                progress_callback: None,
-                user_data: ptr::null_mut(),
+                ..Default::default()
             };
 
             let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -1015,7 +989,7 @@ fn test_ffi_race_condition_detection() {
 #[test]
 #[serial_test::serial]
 fn test_ffi_buffer_pool_effectiveness() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let file_manager = TestFileManager::new();
     let test_files: Vec<_> = (0..20)
@@ -1051,9 +1025,7 @@ fn test_ffi_buffer_pool_effectiveness() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
 
         let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -32,7 +32,7 @@ unsafe fn from_c_string(s: *const c_char) -> String {
 #[serial_test::serial]
 fn test_string_allocation_deallocation() {
     // Initialize library
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     // Test multiple string allocations and deallocations
     for i in 0..100 {
@@ -55,7 +55,7 @@ fn test_string_allocation_deallocation() {
 #[test]
 #[serial_test::serial]
 fn test_utf8_string_handling() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     // Test various UTF-8 strings
     let test_cases = vec![
@@ -86,7 +86,7 @@ fn test_utf8_string_handling() {
 #[test]
 #[serial_test::serial]
 fn test_file_result_memory_management() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
@@ -103,9 +103,7 @@ fn test_file_result_memory_management() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result: *mut AniDBFileResult = ptr::null_mut();
@@ -142,81 +140,65 @@ fn test_file_result_memory_management() {
 #[test]
 #[serial_test::serial]
 fn test_batch_result_memory_management() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
-
-    // Simulate a batch result
-    let mut file_results = Vec::new();
-
-    for i in 0..5 {
-        let file_path = to_c_string(&format!("/test/file{i}.txt"));
-        let error_msg = if i % 2 == 0 {
-            ptr::null_mut()
-        } else {
-            to_c_string(&format!("Error processing file {i}")).into_raw()
-        };
-
-        // Create hash results
-        let mut hash_results = Vec::new();
-        for j in 0..2 {
-            let hash_value = to_c_string(&format!("hash_{i}_{j}"));
-            hash_results.push(AniDBHashResult {
-                algorithm: if j == 0 {
-                    AniDBHashAlgorithm::MD5
-                } else {
-                    AniDBHashAlgorithm::SHA1
-                },
-                hash_value: hash_value.into_raw(),
-                hash_length: 32,
-            });
-        }
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
-        let hashes_ptr = if hash_results.is_empty() {
-            ptr::null_mut()
-        } else {
-            let ptr = unsafe {
-                libc::malloc(hash_results.len() * std::mem::size_of::<AniDBHashResult>())
-                    as *mut AniDBHashResult
-            };
-            unsafe {
-                ptr::copy_nonoverlapping(hash_results.as_ptr(), ptr, hash_results.len());
-            }
-            ptr
-        };
-
-        file_results.push(AniDBFileResult {
-            file_path: file_path.into_raw(),
-            file_size: 1024 * (i + 1) as u64,
-            status: if i % 2 == 0 {
-                AniDBStatus::Completed
-            } else {
-                AniDBStatus::Failed
-            },
-            hashes: hashes_ptr,
-            hash_count: 2,
-            processing_time_ms: 100 * (i + 1) as u64,
-            error_message: error_msg,
-        });
-    }
+    let mut handle: *mut std::ffi::c_void = ptr::null_mut();
+    assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
 
-    let results_ptr = unsafe {
-        libc::malloc(file_results.len() * std::mem::size_of::<AniDBFileResult>())
-            as *mut AniDBFileResult
+    // Odd files are missing, so their results carry error messages
+    let temp_dir = tempfile::TempDir::new().unwrap();
+    let paths: Vec<CString> = (0..5)
+        .map(|i| {
+            let path = temp_dir.path().join(format!("file{i}.txt"));
+            if i % 2 == 0 {
+                std::fs::write(&path, format!("content {i}")).unwrap();
+            }
+            to_c_string(path.to_str().unwrap())
+        })
+        .collect();
+    let path_ptrs: Vec<*const c_char> = paths.iter().map(|p| p.as_ptr()).collect();
+    let algorithms = [AniDBHashAlgorithm::MD5, AniDBHashAlgorithm::SHA1];
+    let options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        continue_on_error: 1,
+        ..Default::default()
     };
+
+    let mut batch_result: *mut AniDBBatchResult = ptr::null_mut();
+    let status = anidb_process_batch(
+        handle,
+        path_ptrs.as_ptr(),
+        path_ptrs.len(),
+        &options,
+        &mut batch_result,
+    );
+    assert_eq!(status, AniDBResult::Success);
+    assert!(!batch_result.is_null());
+
     unsafe {
-        ptr::copy_nonoverlapping(file_results.as_ptr(), results_ptr, file_results.len());
+        let batch = &*batch_result;
+        assert_eq!(batch.total_files, 5);
+        assert_eq!(batch.successful_files, 3);
+        assert_eq!(batch.failed_files, 2);
+
+        let results = std::slice::from_raw_parts(batch.results, batch.total_files);
+        for result in results {
+            assert!(!from_c_string(result.file_path).is_empty());
+            if result.status == AniDBStatus::Completed {
+                assert_eq!(result.hash_count, 2);
+                let hashes = std::slice::from_raw_parts(result.hashes, result.hash_count);
+                assert!(hashes.iter().all(|h| !h.hash_value.is_null()));
+            } else {
+                assert!(!result.error_message.is_null());
+            }
+        }
     }
 
-    let batch_result = Box::new(AniDBBatchResult {
-        total_files: 5,
-        successful_files: 3,
-        failed_files: 2,
-        results: results_ptr,
-        total_time_ms: 1500,
-    });
-
-    // Free the batch result
-    anidb_free_batch_result(Box::into_raw(batch_result));
+    // The whole batch is released at once
+    anidb_free_batch_result(batch_result);
 
+    assert_eq!(anidb_client_destroy(handle), AniDBResult::Success);
     anidb_cleanup();
 }
 
@@ -224,7 +206,7 @@ fn test_batch_result_memory_management() {
 #[test]
 #[serial_test::serial]
 fn test_error_path_cleanup() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     // Test invalid handle
     let invalid_handle = 0xDEADBEEF as *mut std::ffi::c_void;
@@ -234,9 +216,7 @@ fn test_error_path_cleanup() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result: *mut AniDBFileResult = ptr::null_mut();
@@ -263,7 +243,7 @@ fn test_error_path_cleanup() {
 fn test_concurrent_string_operations() {
     use std::thread;
 
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let mut handles = vec![];
 
@@ -296,7 +276,7 @@ fn test_concurrent_string_operations() {
 fn test_memory_tracking() {
     use anidb_client_core::buffer::memory_used;
 
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     // Reset memory tracking for test
     #[cfg(feature = "test-internals")]
@@ -323,7 +303,7 @@ fn test_memory_tracking() {
 #[test]
 #[serial_test::serial]
 fn test_buffer_overflow_prevention() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
@@ -347,7 +327,7 @@ fn test_buffer_overflow_prevention() {
 #[test]
 #[serial_test::serial]
 fn test_null_pointer_validation() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     // Test various functions with null pointers
     assert_eq!(
@@ -372,7 +352,7 @@ fn test_null_pointer_validation() {
 #[test]
 #[serial_test::serial]
 fn test_callback_memory_management() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
@@ -414,7 +394,7 @@ fn test_callback_memory_management() {
 #[test]
 #[serial_test::serial]
 fn test_event_system_memory() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
@@ -454,7 +434,7 @@ fn test_event_system_memory() {
 #[test]
 #[serial_test::serial]
 fn test_memory_stress() {
-    assert_eq!(anidb_init(1), AniDBResult::Success);
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
 
     // Create multiple clients
     let mut handles = Vec::new();
@@ -500,3 +480,76 @@ fn test_memory_stress() {
 
     anidb_cleanup();
 }
+
+/// Test pool statistics, runtime limits and reclaiming pooled buffers
+#[test]
+#[serial_test::serial]
+fn test_memory_pool_controls() {
+    assert_eq!(anidb_init(ANIDB_ABI_VERSION), AniDBResult::Success);
+
+    let mut pools = [AniDBPoolStats::default(); 8];
+    let mut count = 0usize;
+    assert_eq!(
+        anidb_memory_get_pool_stats(pools.as_mut_ptr(), pools.len(), &mut count),
+        AniDBResult::Success
+    );
+    assert_eq!(count, 4);
+    assert!(
+        pools[..count]
+            .windows(2)
+            .all(|w| w[0].buffer_size < w[1].buffer_size)
+    );
+    for pool in &pools[..count] {
+        assert!((0.0..=1.0).contains(&pool.hit_rate));
+        assert!(pool.peak_bytes >= pool.pooled_bytes + pool.bytes_in_use);
+    }
+
+    // Only as many pools as fit are written
+    assert_eq!(
+        anidb_memory_get_pool_stats(pools.as_mut_ptr(), 1, &mut count),
+        AniDBResult::Success
+    );
+    assert_eq!(count, 1);
+    assert_eq!(
+        anidb_memory_get_pool_stats(ptr::null_mut(), 4, &mut count),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(
+        anidb_memory_get_pool_stats(ptr::null_mut(), 0, ptr::null_mut()),
+        AniDBResult::ErrorInvalidParameter
+    );
+
+    // Limits are clamped to the range accepted by client configuration
+    let mut stats: AniDBMemoryStats = unsafe { std::mem::zeroed() };
+    assert_eq!(
+        anidb_memory_set_limit(0),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(anidb_memory_set_limit(1024), AniDBResult::Success);
+    assert_eq!(anidb_get_memory_stats(&mut stats), AniDBResult::Success);
+    assert_eq!(stats.memory_limit, 10 * 1024 * 1024);
+    assert_eq!(
+        anidb_memory_set_limit(64 * 1024 * 1024),
+        AniDBResult::Success
+    );
+    assert_eq!(anidb_get_memory_stats(&mut stats), AniDBResult::Success);
+    assert_eq!(stats.memory_limit, 64 * 1024 * 1024);
+
+    // Evicting everything empties the pools and releases their memory
+    let mut freed = 0u64;
+    assert_eq!(
+        anidb_memory_evict_stale(0, &mut freed),
+        AniDBResult::Success
+    );
+    assert_eq!(anidb_get_memory_stats(&mut stats), AniDBResult::Success);
+    assert_eq!(stats.pool_memory, 0);
+    assert_eq!(anidb_memory_shrink(0, &mut freed), AniDBResult::Success);
+    assert_eq!(freed, 0);
+    assert_eq!(
+        anidb_memory_shrink(0, ptr::null_mut()),
+        AniDBResult::Success
+    );
+    assert_eq!(anidb_memory_gc(), AniDBResult::Success);
+
+    anidb_cleanup();
+}
@@ -0,0 +1,259 @@
+//! Metrics Tests for FFI
+//!
+//! Tests the stage timings carried by file results and the client-wide
+//! snapshot returned by `anidb_get_metrics`.
+
+use anidb_client_core::ffi::{
+    AniDBBatchOptions, AniDBBatchResult, AniDBConfig, AniDBFileResult, AniDBHashAlgorithm,
+    AniDBMetrics, AniDBProcessOptions, AniDBResult, anidb_client_create_with_config,
+    anidb_client_destroy, anidb_free_batch_result, anidb_free_file_result, anidb_get_metrics,
+    anidb_process_batch, anidb_process_file,
+};
+use std::ffi::{CString, c_char, c_void};
+use std::path::Path;
+use std::ptr;
+use tempfile::TempDir;
+
+const FILE_SIZE: usize = 4 * 1024 * 1024;
+
+/// Create a client with the default settings and an in-memory hash cache
+fn create_client() -> *mut c_void {
+    let config = AniDBConfig {
+        max_concurrent_files: 4,
+        chunk_size: 64 * 1024,
+        max_memory_usage: 500 * 1024 * 1024,
+        enable_hash_cache: 1,
+        ..Default::default()
+    };
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create_with_config(&config, &mut handle),
+        AniDBResult::Success
+    );
+    handle
+}
+
+/// Process a file with ED2K and CRC32 and pass the result to `check`
+fn process(handle: *mut c_void, path: &Path, check: impl FnOnce(&AniDBFileResult)) {
+    let algorithms = [AniDBHashAlgorithm::ED2K, AniDBHashAlgorithm::CRC32];
+    let options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        ..Default::default()
+    };
+    let file_path = CString::new(path.to_str().unwrap()).unwrap();
+
+    let mut result: *mut AniDBFileResult = ptr::null_mut();
+    assert_eq!(
+        anidb_process_file(handle, file_path.as_ptr(), &options, &mut result),
+        AniDBResult::Success
+    );
+    unsafe {
+        check(&*result);
+        anidb_free_file_result(result);
+    }
+}
+
+fn hash_times(result: &AniDBFileResult) -> Vec<u64> {
+    unsafe { std::slice::from_raw_parts(result.hashes, result.hash_count) }
+        .iter()
+        .map(|hash| hash.hash_time_us)
+        .collect()
+}
+
+fn get_metrics(handle: *mut c_void) -> AniDBMetrics {
+    let mut metrics = AniDBMetrics::default();
+    assert_eq!(
+        anidb_get_metrics(handle, &mut metrics),
+        AniDBResult::Success
+    );
+    metrics
+}
+
+#[test]
+fn test_results_carry_stage_timings() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = temp_dir.path().join("episode.mkv");
+    let contents: Vec<u8> = (0..FILE_SIZE).map(|i| (i * 7) as u8).collect();
+    std::fs::write(&path, contents).unwrap();
+
+    let handle = create_client();
+
+    process(handle, &path, |result| {
+        let timings = result.timings;
+        assert!(timings.hash_us > 0, "{timings:?}");
+        assert!(timings.hash_us / 1000 <= result.processing_time_ms);
+        // Every algorithm reports its own share
+        assert_eq!(hash_times(result).len(), 2);
+        assert!(hash_times(result).iter().all(|&us| us > 0));
+    });
+
+    // The second time every hash comes from the cache
+    process(handle, &path, |result| {
+        let timings = result.timings;
+        assert_eq!(timings.read_us, 0);
+        assert_eq!(timings.hash_us, 0);
+        assert!(hash_times(result).iter().all(|&us| us == 0));
+    });
+
+    let _ = anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_metrics_snapshot() {
+    let temp_dir = TempDir::new().unwrap();
+    let path = temp_dir.path().join("episode.mkv");
+    std::fs::write(&path, vec![0x5au8; FILE_SIZE]).unwrap();
+
+    let handle = create_client();
+    let before = get_metrics(handle);
+    assert_eq!(before.files_processed, 0);
+    assert_eq!(before.cache_hit_ratio, 0.0);
+
+    process(handle, &path, |_| {});
+    process(handle, &path, |_| {});
+
+    let metrics = get_metrics(handle);
+    assert_eq!(metrics.files_processed, 2);
+    assert_eq!(metrics.files_failed, 0);
+    assert_eq!(metrics.bytes_read, FILE_SIZE as u64);
+    assert_eq!(metrics.cache_misses, 1);
+    assert_eq!(metrics.cache_hits, 1);
+    assert!((metrics.cache_hit_ratio - 0.5).abs() < 1e-9);
+    assert_eq!(metrics.files_in_flight, 0);
+    assert_eq!(metrics.files_queued, 0);
+    assert!(metrics.hash_slots_total >= 1);
+    // Auto mode reads buffered; the cache hit read nothing
+    assert_eq!(metrics.files_read_buffered, 1);
+    assert_eq!(metrics.files_read_io_uring, 0);
+    // Without auto tuning the configured values are reported, but for
+    // the chunk size files hashed with ED2K read
+    assert_eq!(before.chunk_size, 64 * 1024);
+    assert_eq!(metrics.chunk_size, 9_728_000);
+    assert_eq!(metrics.hash_queue_depth, 2);
+    assert_eq!(metrics.readers_per_device, 2);
+
+    // Both files took time, only the first one was hashed
+    assert_eq!(metrics.file_latency.count, 2);
+    assert_eq!(metrics.hash_latency.count, 1);
+    assert_eq!(metrics.network_latency.count, 0);
+    for histogram in [metrics.file_latency, metrics.hash_latency] {
+        assert_eq!(histogram.buckets.iter().sum::<u64>(), histogram.count);
+    }
+
+    // Metrics are per client
+    let other = create_client();
+    assert_eq!(get_metrics(other).files_processed, 0);
+
+    let _ = anidb_client_destroy(other);
+    let _ = anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_auto_tuned_batch() {
+    let temp_dir = TempDir::new().unwrap();
+    let paths: Vec<CString> = (0..12)
+        .map(|i| {
+            let path = temp_dir.path().join(format!("episode{i:02}.mkv"));
+            std::fs::write(&path, vec![i as u8; 256 * 1024 + i]).unwrap();
+            CString::new(path.to_str().unwrap()).unwrap()
+        })
+        .collect();
+    let path_ptrs: Vec<*const c_char> = paths.iter().map(|p| p.as_ptr()).collect();
+
+    let config = AniDBConfig {
+        max_concurrent_files: 4,
+        chunk_size: 1024,
+        max_memory_usage: 256 * 1024 * 1024,
+        auto_tune: 1,
+        ..Default::default()
+    };
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(
+        anidb_client_create_with_config(&config, &mut handle),
+        AniDBResult::Success
+    );
+
+    // Tuning starts from the configured values, raised to its minimum
+    let before = get_metrics(handle);
+    assert_eq!(before.chunk_size, 64 * 1024);
+    assert_eq!(before.hash_queue_depth, 2);
+    assert_eq!(before.readers_per_device, 2);
+
+    let algorithms = [AniDBHashAlgorithm::CRC32, AniDBHashAlgorithm::MD5];
+    let options = AniDBBatchOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        max_concurrent: 4,
+        ..Default::default()
+    };
+    let mut result: *mut AniDBBatchResult = ptr::null_mut();
+    assert_eq!(
+        anidb_process_batch(
+            handle,
+            path_ptrs.as_ptr(),
+            path_ptrs.len(),
+            &options,
+            &mut result
+        ),
+        AniDBResult::Success
+    );
+    unsafe {
+        assert_eq!((*result).successful_files, paths.len());
+        anidb_free_batch_result(result);
+    }
+
+    // Whatever the tuner chose stays within its bounds and the budget
+    let metrics = get_metrics(handle);
+    assert_eq!(metrics.files_processed, paths.len() as u64);
+    assert!((64 * 1024..=16 * 1024 * 1024).contains(&metrics.chunk_size));
+    assert!((1..=8).contains(&metrics.hash_queue_depth));
+    assert!((1..=4).contains(&metrics.readers_per_device));
+    assert!(metrics.chunk_size * (metrics.hash_queue_depth + 1) * 4 <= 128 * 1024 * 1024);
+
+    let _ = anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_failed_files_are_counted() {
+    let handle = create_client();
+    let algorithms = [AniDBHashAlgorithm::ED2K];
+    let options = AniDBProcessOptions {
+        algorithms: algorithms.as_ptr(),
+        algorithm_count: algorithms.len(),
+        ..Default::default()
+    };
+    let missing = CString::new("/nonexistent/metrics/episode.mkv").unwrap();
+    let mut result: *mut AniDBFileResult = ptr::null_mut();
+    assert_ne!(
+        anidb_process_file(handle, missing.as_ptr(), &options, &mut result),
+        AniDBResult::Success
+    );
+
+    let metrics = get_metrics(handle);
+    assert_eq!(metrics.files_failed, 1);
+    assert_eq!(metrics.files_processed, 0);
+    assert_eq!(metrics.file_latency.count, 1);
+
+    let _ = anidb_client_destroy(handle);
+}
+
+#[test]
+fn test_metrics_invalid_parameters() {
+    let mut metrics = AniDBMetrics::default();
+    assert_eq!(
+        anidb_get_metrics(ptr::null_mut(), &mut metrics),
+        AniDBResult::ErrorInvalidParameter
+    );
+
+    let handle = create_client();
+    assert_eq!(
+        anidb_get_metrics(handle, ptr::null_mut()),
+        AniDBResult::ErrorInvalidParameter
+    );
+    let _ = anidb_client_destroy(handle);
+    assert_eq!(
+        anidb_get_metrics(handle, &mut metrics),
+        AniDBResult::ErrorInvalidHandle
+    );
+}
@@ -8,22 +8,24 @@
 //! - Thread safety guarantees
 
 use anidb_client_core::ffi::{
-    AniDBConfig, AniDBFileResult, AniDBHashAlgorithm, AniDBProcessOptions, AniDBResult,
-    anidb_client_create, anidb_client_create_with_config, anidb_client_destroy,
-    anidb_client_get_last_error, anidb_free_file_result, anidb_init, anidb_process_file,
+    ANIDB_ABI_VERSION, AniDBCallbackType, AniDBConfig, AniDBFileResult, AniDBHashAlgorithm,
+    AniDBProcessOptions, AniDBResult, anidb_client_create, anidb_client_create_with_config,
+    anidb_client_destroy, anidb_client_get_last_error, anidb_free_file_result, anidb_init,
+    anidb_process_file, anidb_register_callback, anidb_unregister_callback,
 };
-use std::ffi::{CString, c_char};
+use std::ffi::{CString, c_char, c_void};
 use std::ptr;
 use std::sync::Arc;
-use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 use std::thread;
+use std::time::{Duration, Instant};
 use tempfile::TempDir;
 
 /// Test null pointer validation for all FFI entry points
 #[test]
 #[serial_test::serial]
 fn test_comprehensive_null_pointer_checks() {
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     // Test anidb_client_create_with_config with null config
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -35,11 +37,7 @@ fn test_comprehensive_null_pointer_checks() {
         max_concurrent_files: 1,
         chunk_size: 1024,
         max_memory_usage: 1024,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
     let result = anidb_client_create_with_config(&config, ptr::null_mut());
     assert_eq!(result, AniDBResult::ErrorInvalidParameter);
@@ -53,9 +51,7 @@ fn test_comprehensive_null_pointer_checks() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: 1,
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
 
@@ -106,7 +102,7 @@ fn test_comprehensive_null_pointer_checks() {
 #[test]
 #[serial_test::serial]
 fn test_buffer_overflow_prevention() {
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let _ = anidb_client_create(&mut handle);
@@ -117,9 +113,7 @@ fn test_buffer_overflow_prevention() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: 1,
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
 
@@ -154,7 +148,7 @@ fn test_buffer_overflow_prevention() {
 #[test]
 #[serial_test::serial]
 fn test_panic_catching() {
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     // Test with invalid UTF-8 in string parameters
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -165,11 +159,8 @@ fn test_panic_catching() {
         max_concurrent_files: 1,
         chunk_size: 1024,
         max_memory_usage: 1024,
-        enable_debug_logging: 0,
         username: invalid_utf8.as_ptr() as *const c_char,
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     // This should not panic, but return an error
@@ -184,10 +175,9 @@ fn test_panic_catching() {
     let algorithms = [AniDBHashAlgorithm::ED2K];
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
-        algorithm_count: 0, // Invalid: zero algorithms
+        // Invalid: zero algorithms
         enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
 
@@ -196,11 +186,8 @@ fn test_panic_catching() {
 
     // Test with null algorithms pointer but non-zero count
     let options_invalid = AniDBProcessOptions {
-        algorithms: ptr::null(),
         algorithm_count: 1,
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let result = anidb_process_file(
@@ -218,7 +205,7 @@ fn test_panic_catching() {
 #[test]
 #[serial_test::serial]
 fn test_memory_leak_prevention() {
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     // Test creating and destroying multiple clients
     for _ in 0..10 {
@@ -244,9 +231,7 @@ fn test_memory_leak_prevention() {
         let options = AniDBProcessOptions {
             algorithms: algorithms.as_ptr(),
             algorithm_count: algorithms.len(),
-            enable_progress: 0,
-            progress_callback: None,
-            user_data: ptr::null_mut(),
+            ..Default::default()
         };
         let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
 
@@ -266,7 +251,7 @@ fn test_memory_leak_prevention() {
 #[test]
 #[serial_test::serial]
 fn test_thread_safety() {
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let temp_dir = TempDir::new().unwrap();
     let test_file = temp_dir.path().join("test_thread.mkv");
@@ -312,9 +297,7 @@ fn test_thread_safety() {
             let options = AniDBProcessOptions {
                 algorithms: algorithms.as_ptr(),
                 algorithm_count: 1,
-                enable_progress: 0,
-                progress_callback: None,
-                user_data: ptr::null_mut(),
+                ..Default::default()
             };
             let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
 
@@ -344,11 +327,98 @@ fn test_thread_safety() {
     }
 }
 
+static CALLS_INSIDE: AtomicUsize = AtomicUsize::new(0);
+static PEAK_INSIDE: AtomicUsize = AtomicUsize::new(0);
+
+/// Completion callback that waits for `user_data` calls to be inside at once
+extern "C" fn rendezvous(_result: AniDBResult, user_data: *mut c_void) {
+    let expected = user_data as usize;
+    let inside = CALLS_INSIDE.fetch_add(1, Ordering::SeqCst) + 1;
+    PEAK_INSIDE.fetch_max(inside, Ordering::SeqCst);
+
+    let deadline = Instant::now() + Duration::from_secs(5);
+    while PEAK_INSIDE.load(Ordering::SeqCst) < expected && Instant::now() < deadline {
+        thread::sleep(Duration::from_millis(1));
+    }
+    CALLS_INSIDE.fetch_sub(1, Ordering::SeqCst);
+}
+
+/// Calls on one shared handle must not serialize on the client
+#[test]
+#[serial_test::serial]
+fn test_shared_client_runs_calls_concurrently() {
+    const THREADS: usize = 4;
+    let _ = anidb_init(ANIDB_ABI_VERSION);
+
+    let temp_dir = TempDir::new().unwrap();
+    let mut handle: *mut c_void = ptr::null_mut();
+    assert_eq!(anidb_client_create(&mut handle), AniDBResult::Success);
+
+    CALLS_INSIDE.store(0, Ordering::SeqCst);
+    PEAK_INSIDE.store(0, Ordering::SeqCst);
+    let callback_id = anidb_register_callback(
+        handle,
+        AniDBCallbackType::Completion,
+        rendezvous as *mut c_void,
+        THREADS as *mut c_void,
+    );
+    assert_ne!(callback_id, 0);
+
+    let handle_usize = handle as usize;
+    let threads: Vec<_> = (0..THREADS)
+        .map(|i| {
+            let file = temp_dir.path().join(format!("shared{i}.mkv"));
+            std::fs::write(&file, vec![i as u8; 64 * 1024]).unwrap();
+            thread::spawn(move || {
+                let file_path = CString::new(file.to_str().unwrap()).unwrap();
+                let algorithms = [AniDBHashAlgorithm::ED2K];
+                let options = AniDBProcessOptions {
+                    algorithms: algorithms.as_ptr(),
+                    algorithm_count: 1,
+                    ..Default::default()
+                };
+                let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
+                let result = anidb_process_file(
+                    handle_usize as *mut c_void,
+                    file_path.as_ptr(),
+                    &options,
+                    &mut result_ptr,
+                );
+                assert_eq!(result, AniDBResult::Success);
+                anidb_free_file_result(result_ptr);
+            })
+        })
+        .collect();
+    for thread in threads {
+        thread.join().unwrap();
+    }
+
+    // Callbacks of every call were running at the same time
+    assert_eq!(PEAK_INSIDE.load(Ordering::SeqCst), THREADS);
+
+    assert_eq!(
+        anidb_unregister_callback(handle, callback_id),
+        AniDBResult::Success
+    );
+    assert_eq!(
+        anidb_unregister_callback(handle, callback_id),
+        AniDBResult::ErrorInvalidParameter
+    );
+    assert_eq!(anidb_client_destroy(handle), AniDBResult::Success);
+
+    // A destroyed handle is rejected even by threads that resolved it before
+    let mut error = [0 as c_char; 16];
+    assert_eq!(
+        anidb_client_get_last_error(handle, error.as_mut_ptr(), error.len()),
+        AniDBResult::ErrorInvalidHandle
+    );
+}
+
 /// Test validation of algorithm arrays
 #[test]
 #[serial_test::serial]
 fn test_algorithm_array_validation() {
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let _ = anidb_client_create(&mut handle);
@@ -362,10 +432,8 @@ fn test_algorithm_array_validation() {
     let algorithms = [AniDBHashAlgorithm::ED2K];
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
-        algorithm_count: 10, // Way more than actual array size
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        algorithm_count: 10,
+        ..Default::default()
     };
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
 
@@ -384,7 +452,7 @@ fn test_all_functions_catch_panic() {
     // We can't easily trigger panics in well-written code, but we verify
     // that the functions handle edge cases without panicking
 
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     // Test destroying invalid handles multiple times
     let invalid_handle = 0xDEADBEEF as *mut std::ffi::c_void;
@@ -400,7 +468,7 @@ fn test_all_functions_catch_panic() {
     let mut threads = vec![];
     for _ in 0..10 {
         let thread = thread::spawn(|| {
-            let result = anidb_init(1);
+            let result = anidb_init(ANIDB_ABI_VERSION);
             assert_eq!(result, AniDBResult::Success);
         });
         threads.push(thread);
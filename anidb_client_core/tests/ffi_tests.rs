@@ -5,12 +5,18 @@
 //! Tests the Foreign Function Interface for external language bindings.
 
 use anidb_client_core::ffi::{
+    ANIDB_ABI_VERSION,
     // New API functions and types
     AniDBConfig,
+    AniDBCpuFeatures,
     AniDBFileResult,
     AniDBHashAlgorithm,
+    AniDBMd4Kernel,
     AniDBProcessOptions,
     AniDBResult,
+    anidb_calculate_hash,
+    anidb_calculate_hash_buffer,
+    anidb_calculate_hashes_buffer,
     anidb_cleanup,
     anidb_client_create,
     anidb_client_create_with_config,
@@ -20,13 +26,14 @@ use anidb_client_core::ffi::{
     anidb_free_file_result,
     anidb_free_string,
     anidb_get_abi_version,
+    anidb_get_cpu_features,
     anidb_get_version,
     anidb_hash_algorithm_name,
     anidb_hash_buffer_size,
     anidb_init,
     anidb_process_file,
 };
-use std::ffi::{CStr, CString};
+use std::ffi::{CStr, CString, c_char};
 use std::ptr;
 use tempfile::TempDir;
 
@@ -35,11 +42,11 @@ use tempfile::TempDir;
 #[serial_test::serial]
 fn test_library_lifecycle() {
     // Initialize library with correct ABI version
-    let result = anidb_init(1);
+    let result = anidb_init(ANIDB_ABI_VERSION);
     assert_eq!(result, AniDBResult::Success);
 
     // Calling init again should still succeed (idempotent)
-    let result = anidb_init(1);
+    let result = anidb_init(ANIDB_ABI_VERSION);
     assert_eq!(result, AniDBResult::Success);
 
     // Wrong ABI version should fail
@@ -65,7 +72,40 @@ fn test_version_functions() {
 
     // Get ABI version
     let abi_version = anidb_get_abi_version();
-    assert_eq!(abi_version, 1);
+    assert_eq!(abi_version, 2);
+    assert_eq!(abi_version, ANIDB_ABI_VERSION);
+}
+
+/// Test the CPU feature query and the kernels reported with it
+#[test]
+fn test_cpu_features() {
+    let mut features = std::mem::MaybeUninit::<AniDBCpuFeatures>::uninit();
+    assert_eq!(
+        anidb_get_cpu_features(features.as_mut_ptr()),
+        AniDBResult::Success
+    );
+    let features = unsafe { features.assume_init() };
+
+    #[cfg(target_arch = "x86_64")]
+    assert_eq!(features.sse2, 1);
+    #[cfg(target_arch = "aarch64")]
+    assert_eq!(features.neon, 1);
+
+    let expected_lanes = match features.md4_kernel {
+        AniDBMd4Kernel::Scalar => 1,
+        AniDBMd4Kernel::Sse41 | AniDBMd4Kernel::Neon => 4,
+        AniDBMd4Kernel::Avx2 => 8,
+        AniDBMd4Kernel::Avx512 => 16,
+    };
+    assert_eq!(features.md4_lanes, expected_lanes);
+    if features.md4_kernel == AniDBMd4Kernel::Avx2 {
+        assert_eq!(features.avx2, 1);
+    }
+
+    assert_eq!(
+        anidb_get_cpu_features(ptr::null_mut()),
+        AniDBResult::ErrorInvalidParameter
+    );
 }
 
 /// Test creating and destroying an AniDB client handle
@@ -73,7 +113,7 @@ fn test_version_functions() {
 #[serial_test::serial]
 fn test_client_handle_lifecycle() {
     // Initialize library
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     // Create client
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -98,17 +138,13 @@ fn test_client_handle_lifecycle() {
 #[serial_test::serial]
 fn test_client_creation_with_config() {
     // Initialize library
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let config = AniDBConfig {
         max_concurrent_files: 4,
         chunk_size: 64 * 1024,
         max_memory_usage: 500 * 1024 * 1024,
-        enable_debug_logging: 0,
-        username: ptr::null(),
-        password: ptr::null(),
-        client_name: ptr::null(),
-        client_version: ptr::null(),
+        ..Default::default()
     };
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
@@ -128,7 +164,7 @@ fn test_client_creation_with_config() {
 #[serial_test::serial]
 fn test_null_pointer_handling() {
     // Initialize library
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     // Create with null handle pointer should return error
     let result = anidb_client_create(ptr::null_mut());
@@ -155,7 +191,7 @@ fn test_null_pointer_handling() {
 #[serial_test::serial]
 fn test_file_processing_ffi() {
     // Initialize library
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let temp_dir = TempDir::new().unwrap();
     let test_file = temp_dir.path().join("test.mkv");
@@ -172,9 +208,7 @@ fn test_file_processing_ffi() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -204,7 +238,7 @@ fn test_file_processing_ffi() {
 #[serial_test::serial]
 fn test_error_handling() {
     // Initialize library
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let mut handle: *mut std::ffi::c_void = ptr::null_mut();
     let _ = anidb_client_create(&mut handle);
@@ -216,9 +250,7 @@ fn test_error_handling() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -268,6 +300,127 @@ fn test_utility_functions() {
     assert_eq!(buffer_size, 41); // 40 hex chars + null terminator
 }
 
+/// Test hashing memory buffers with one and several algorithms
+#[test]
+#[serial_test::serial]
+fn test_buffer_hashing() {
+    let data = b"abc";
+
+    let mut md5 = vec![0 as c_char; anidb_hash_buffer_size(AniDBHashAlgorithm::MD5)];
+    let result = anidb_calculate_hash_buffer(
+        data.as_ptr(),
+        data.len(),
+        AniDBHashAlgorithm::MD5,
+        md5.as_mut_ptr(),
+        md5.len(),
+    );
+    assert_eq!(result, AniDBResult::Success);
+    let md5 = unsafe { CStr::from_ptr(md5.as_ptr()) };
+    assert_eq!(md5.to_str().unwrap(), "900150983cd24fb0d6963f7d28e17f72");
+
+    // Several algorithms in one pass over the same data
+    let algorithms = [
+        AniDBHashAlgorithm::CRC32,
+        AniDBHashAlgorithm::MD5,
+        AniDBHashAlgorithm::SHA1,
+    ];
+    let mut buffers: Vec<Vec<c_char>> = algorithms
+        .iter()
+        .map(|a| vec![0 as c_char; anidb_hash_buffer_size(*a)])
+        .collect();
+    let pointers: Vec<*mut c_char> = buffers.iter_mut().map(|b| b.as_mut_ptr()).collect();
+    let sizes: Vec<usize> = buffers.iter().map(|b| b.len()).collect();
+
+    let result = anidb_calculate_hashes_buffer(
+        data.as_ptr(),
+        data.len(),
+        algorithms.as_ptr(),
+        algorithms.len(),
+        pointers.as_ptr(),
+        sizes.as_ptr(),
+    );
+    assert_eq!(result, AniDBResult::Success);
+
+    let hashes: Vec<&str> = buffers
+        .iter()
+        .map(|b| unsafe { CStr::from_ptr(b.as_ptr()) }.to_str().unwrap())
+        .collect();
+    assert_eq!(
+        hashes,
+        [
+            "352441c2",
+            "900150983cd24fb0d6963f7d28e17f72",
+            "a9993e364706816aba3e25717850c26c9cd0d89d",
+        ]
+    );
+
+    // Output buffers too small for the algorithm are rejected up front
+    let mut short = vec![0 as c_char; 8];
+    let result = anidb_calculate_hash_buffer(
+        data.as_ptr(),
+        data.len(),
+        AniDBHashAlgorithm::SHA1,
+        short.as_mut_ptr(),
+        short.len(),
+    );
+    assert_eq!(result, AniDBResult::ErrorInvalidParameter);
+
+    // An empty buffer hashes the empty input
+    let mut empty = vec![0 as c_char; anidb_hash_buffer_size(AniDBHashAlgorithm::MD5)];
+    let result = anidb_calculate_hash_buffer(
+        ptr::null(),
+        0,
+        AniDBHashAlgorithm::MD5,
+        empty.as_mut_ptr(),
+        empty.len(),
+    );
+    assert_eq!(result, AniDBResult::Success);
+    let empty = unsafe { CStr::from_ptr(empty.as_ptr()) };
+    assert_eq!(empty.to_str().unwrap(), "d41d8cd98f00b204e9800998ecf8427e");
+}
+
+/// Test that file hashing streams to the same result as buffer hashing
+#[test]
+#[serial_test::serial]
+fn test_file_hashing_matches_buffer() {
+    let temp_dir = TempDir::new().unwrap();
+    let test_file = temp_dir.path().join("hash.mkv");
+    let data: Vec<u8> = (0..3 * 1024 * 1024 + 17).map(|i| (i % 251) as u8).collect();
+    std::fs::write(&test_file, &data).unwrap();
+    let filename = CString::new(test_file.to_str().unwrap()).unwrap();
+
+    let size = anidb_hash_buffer_size(AniDBHashAlgorithm::ED2K);
+    let mut from_file = vec![0 as c_char; size];
+    let mut from_buffer = vec![0 as c_char; size];
+
+    let result = anidb_calculate_hash(
+        filename.as_ptr(),
+        AniDBHashAlgorithm::ED2K,
+        from_file.as_mut_ptr(),
+        size,
+    );
+    assert_eq!(result, AniDBResult::Success);
+
+    let result = anidb_calculate_hash_buffer(
+        data.as_ptr(),
+        data.len(),
+        AniDBHashAlgorithm::ED2K,
+        from_buffer.as_mut_ptr(),
+        size,
+    );
+    assert_eq!(result, AniDBResult::Success);
+    assert_eq!(from_file, from_buffer);
+
+    let missing = CString::new(temp_dir.path().join("missing.mkv").to_str().unwrap()).unwrap();
+    let result = anidb_calculate_hash(
+        missing.as_ptr(),
+        AniDBHashAlgorithm::ED2K,
+        from_file.as_mut_ptr(),
+        size,
+    );
+    assert_eq!(result, AniDBResult::ErrorFileNotFound);
+}
+
 /// Test progress callback functionality
 #[test]
 #[serial_test::serial]
@@ -275,7 +428,7 @@ fn test_progress_callback() {
     use std::sync::{Arc, Mutex};
 
     // Initialize library
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let temp_dir = TempDir::new().unwrap();
     let test_file = temp_dir.path().join("test_progress.mkv");
@@ -312,6 +465,7 @@ fn test_progress_callback() {
         enable_progress: 1,
         progress_callback: Some(progress_callback),
         user_data: user_data_ptr,
+        ..Default::default()
     };
 
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
@@ -348,7 +502,7 @@ fn test_progress_callback() {
 #[serial_test::serial]
 fn test_multiple_hash_algorithms() {
     // Initialize library
-    let _ = anidb_init(1);
+    let _ = anidb_init(ANIDB_ABI_VERSION);
 
     let temp_dir = TempDir::new().unwrap();
     let test_file = temp_dir.path().join("test_multi_hash.mkv");
@@ -368,9 +522,7 @@ fn test_multiple_hash_algorithms() {
     let options = AniDBProcessOptions {
         algorithms: algorithms.as_ptr(),
         algorithm_count: algorithms.len(),
-        enable_progress: 0,
-        progress_callback: None,
-        user_data: ptr::null_mut(),
+        ..Default::default()
     };
 
     let mut result_ptr: *mut AniDBFileResult = ptr::null_mut();
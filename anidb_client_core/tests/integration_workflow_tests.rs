@@ -492,6 +492,11 @@ mod client_lifecycle_tests {
                 password: None,
                 client_name: None,
                 client_version: None,
+                io_mode: IoMode::Auto,
+                auto_tune: true,
+                server: None,
+                request_rate: None,
+                request_timeout: None,
             },
         ];
 
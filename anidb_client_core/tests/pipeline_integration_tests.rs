@@ -4,6 +4,7 @@ use anidb_client_core::hashing::HashAlgorithm;
 use anidb_client_core::pipeline::{
     HashingStage, PipelineConfig, ProcessingStage, StreamingPipelineBuilder, ValidationStage,
 };
+use anidb_client_core::platform::IoMode;
 use std::sync::Arc;
 use std::time::Instant;
 use tempfile::TempDir;
@@ -281,6 +282,7 @@ async fn test_pipeline_memory_usage() {
         chunk_size: 32 * 1024, // 32KB chunks
         parallel_stages: false,
         max_memory: 10 * 1024 * 1024, // 10MB limit
+        io_mode: IoMode::Auto,
     };
 
     let hashing = Box::new(HashingStage::new(&[HashAlgorithm::SHA1]));
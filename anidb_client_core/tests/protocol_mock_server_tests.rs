@@ -0,0 +1,112 @@
+//! Protocol client tests against the mock AniDB UDP server
+//!
+//! Covers what needs a server on the other end: identifying a file through
+//! the query manager, and the retries that lost packets and busy replies
+//! cause.
+
+use anidb_client_core::identification::query_manager::AniDBQueryManager;
+use anidb_client_core::identification::{IdentificationSource, IdentificationStatus};
+use anidb_client_core::protocol::ProtocolConfig;
+use anidb_client_core::protocol::client::ProtocolClient;
+use anidb_test_utils::mocks::{FloodResponse, MockServerConfig, MockUdpServer};
+use std::sync::Arc;
+use std::sync::atomic::Ordering;
+use std::time::Duration;
+use tokio::sync::Mutex;
+
+/// Start a mock server and a client fast enough for tests
+///
+/// `None` when UDP sockets are unavailable, as in some sandboxes.
+async fn connect(config: MockServerConfig) -> Option<(MockUdpServer, ProtocolClient)> {
+    let server = MockUdpServer::start(config).await.ok()?;
+    let client = ProtocolClient::new(ProtocolConfig {
+        server: server.addr().to_string(),
+        request_timeout: Duration::from_millis(100),
+        retry_delay: Duration::from_millis(50),
+        request_rate: Some(1000.0),
+        ..Default::default()
+    })
+    .await
+    .ok()?;
+    Some((server, client))
+}
+
+#[tokio::test]
+async fn test_identify_file_against_mock() {
+    let Some((_server, client)) = connect(MockServerConfig::default()).await else {
+        eprintln!("Skipping test_identify_file_against_mock: UDP sockets unavailable");
+        return;
+    };
+    let manager = AniDBQueryManager::new(Arc::new(Mutex::new(client)));
+    manager.ensure_authenticated("user", "pass").await.unwrap();
+
+    let ed2k = "0123456789abcdef0123456789abcdef";
+    let result = manager
+        .query_file(
+            &IdentificationSource::HashWithSize {
+                ed2k: ed2k.to_string(),
+                size: 1234,
+            },
+            Some("78C8FEF8"),
+            Some("00E03000"),
+        )
+        .await
+        .unwrap();
+
+    assert_eq!(result.status, IdentificationStatus::Identified);
+    let file = result.file.unwrap();
+    assert_eq!((file.size, file.ed2k.as_str()), (1234, ed2k));
+    let anime = result.anime.unwrap();
+    assert_eq!(anime.aid, file.aid);
+    assert_eq!(anime.romaji_name, format!("Mock Anime {}", file.aid));
+    assert_eq!(result.group.unwrap().gid, file.gid);
+}
+
+#[tokio::test]
+async fn test_lost_packets_are_retried() {
+    let config = MockServerConfig {
+        packet_loss: 0.4,
+        ..Default::default()
+    };
+    let Some((server, client)) = connect(config).await else {
+        eprintln!("Skipping test_lost_packets_are_retried: UDP sockets unavailable");
+        return;
+    };
+
+    for _ in 0..10 {
+        let _ = client.ping().await;
+    }
+
+    // Every lost packet costs one timeout, and each timeout but the last of
+    // a command is retried
+    let stats = client.stats();
+    let lost = server.stats().requests_lost + server.stats().replies_lost;
+    let timeouts = stats.timeouts.load(Ordering::Relaxed);
+    assert!(lost > 0);
+    assert_eq!(timeouts, lost);
+    assert!(stats.retries.load(Ordering::Relaxed) > 0);
+    assert!(stats.retries.load(Ordering::Relaxed) <= timeouts);
+}
+
+#[tokio::test]
+async fn test_busy_server_is_retried() {
+    let config = MockServerConfig {
+        flood_rate: Some(50.0),
+        flood_burst: 1.0,
+        flood_response: FloodResponse::Busy,
+        ..Default::default()
+    };
+    let Some((server, client)) = connect(config).await else {
+        eprintln!("Skipping test_busy_server_is_retried: UDP sockets unavailable");
+        return;
+    };
+
+    client.ping().await.unwrap();
+    // Sent straight after the first, so the server is still busy; the
+    // retry goes out once it has room again
+    client.ping().await.unwrap();
+
+    assert_eq!(server.stats().flooded, 1);
+    assert_eq!(client.stats().retries.load(Ordering::Relaxed), 1);
+    assert_eq!(client.stats().timeouts.load(Ordering::Relaxed), 0);
+}
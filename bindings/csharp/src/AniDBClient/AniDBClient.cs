@@ -15,7 +15,7 @@ namespace AniDBClient
     {
         private static readonly object _initLock = new();
         private static bool _initialized;
-        private const uint ABI_VERSION = 1;
+        private const uint ABI_VERSION = 2;
 
         private readonly SafeClientHandle _handle;
         private readonly Dictionary<ulong, RegisteredCallback> _callbacks = new();
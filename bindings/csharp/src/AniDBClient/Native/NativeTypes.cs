@@ -90,6 +90,14 @@ namespace AniDBClient.Native
         public int EnableDebugLogging;
         public IntPtr Username;
         public IntPtr Password;
+        public IntPtr ClientName;
+        public IntPtr ClientVersion;
+        public int IoMode;
+        public int AutoTune;
+        public IntPtr Server;
+        public double RequestRate;
+        public uint RequestTimeoutMs;
+        public int EnableHashCache;
     }
 
     /// <summary>
@@ -102,8 +110,10 @@ namespace AniDBClient.Native
         public UIntPtr AlgorithmCount;
         public int EnableProgress;
         public int VerifyExisting;
+        public int PartialRehash;
         public IntPtr ProgressCallback;
         public IntPtr UserData;
+        public int Priority;
     }
 
     /// <summary>
@@ -115,6 +125,20 @@ namespace AniDBClient.Native
         public AniDBHashAlgorithm Algorithm;
         public IntPtr HashValue;
         public UIntPtr HashLength;
+        public ulong HashTimeUs;
+    }
+
+    /// <summary>
+    /// Time a file spent in each processing stage
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct AniDBStageTimings
+    {
+        public ulong OpenUs;
+        public ulong ReadUs;
+        public ulong PoolWaitUs;
+        public ulong HashUs;
+        public ulong CacheLookupUs;
     }
 
     /// <summary>
@@ -130,6 +154,7 @@ namespace AniDBClient.Native
         public UIntPtr HashCount;
         public ulong ProcessingTimeMs;
         public IntPtr ErrorMessage;
+        public AniDBStageTimings Timings;
     }
 
     /// <summary>
@@ -160,6 +185,17 @@ namespace AniDBClient.Native
         public IntPtr ProgressCallback;
         public IntPtr CompletionCallback;
         public IntPtr UserData;
+        public int Priority;
+    }
+
+    /// <summary>
+    /// Batch file that shares its size with another file of the batch
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct AniDBSizeCollision
+    {
+        public ulong FileSize;
+        public UIntPtr PathIndex;
     }
 
     /// <summary>
@@ -173,6 +209,8 @@ namespace AniDBClient.Native
         public UIntPtr FailedFiles;
         public IntPtr Results;
         public ulong TotalTimeMs;
+        public IntPtr SizeCollisions;
+        public UIntPtr SizeCollisionCount;
     }
 
     /// <summary>
@@ -0,0 +1,210 @@
+/**
+ * Benchmarks of the Node addon
+ *
+ * Covers the path services use: JS -> N-API -> C ABI and back into JS
+ * values. Marshalling is measured on synthetic results from the bench
+ * addon (`npm run build:bench`), so it excludes hashing. Results use the
+ * same JSON format as the C benchmark and are checked against a baseline
+ * with scripts/bench-compare.py.
+ *
+ * Usage: node bench/benchmark.js [--quick] [--threads N] [--output FILE]
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const { AniDBClient, BatchResultView, hashBufferSize, version } = require('..');
+const { bench } = require('../build/Release/anidb_client_bench.node');
+
+const args = process.argv.slice(2);
+const quick = args.includes('--quick');
+const option = (name, fallback) => {
+  const index = args.indexOf(name);
+  return index >= 0 && index + 1 < args.length ? args[index + 1] : fallback;
+};
+
+const MiB = 1024 * 1024;
+const sizes = {
+  hashBytes: (quick ? 8 : 64) * MiB,
+  fileBytes: (quick ? 8 : 64) * MiB,
+  batchFileBytes: (quick ? 2 : 16) * MiB,
+  batchFiles: 8,
+  calls: quick ? 100000 : 1000000,
+  marshalFiles: quick ? 1000 : 10000
+};
+const maxThreads = Number(option('--threads', os.cpus().length)) || 1;
+
+const metrics = {};
+
+function record(name, value, unit, better, tolerance) {
+  metrics[name] = { value, unit, better, ...(tolerance ? { tolerance } : {}) };
+  process.stderr.write(`  ${name.padEnd(32)} ${value.toFixed(3).padStart(12)} ${unit}\n`);
+}
+
+function seconds(start) {
+  return Number(process.hrtime.bigint() - start) / 1e9;
+}
+
+/** Best time of at least three runs, or as many as fit in half a second */
+function bestOf(run) {
+  let best = Infinity;
+  const started = process.hrtime.bigint();
+  for (let i = 0; i < 3 || seconds(started) < 0.5; i++) {
+    const start = process.hrtime.bigint();
+    run();
+    best = Math.min(best, seconds(start));
+  }
+  return best;
+}
+
+function perCall(iterations, run) {
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < iterations; i++) {
+    run();
+  }
+  return (seconds(start) * 1e9) / iterations;
+}
+
+function createFile(dir, name, size, seed) {
+  const chunk = Buffer.alloc(MiB);
+  for (let i = 0; i < chunk.length; i++) {
+    chunk[i] = (i * 31 + seed) & 0xff;
+  }
+  const file = path.join(dir, name);
+  const fd = fs.openSync(file, 'w');
+  for (let written = 0; written < size; written += chunk.length) {
+    fs.writeSync(fd, chunk, 0, Math.min(chunk.length, size - written));
+  }
+  fs.closeSync(fd);
+  return file;
+}
+
+function benchHashBuffer(client) {
+  process.stderr.write(`Hash throughput (${sizes.hashBytes / MiB} MiB buffer)\n`);
+  const data = Buffer.alloc(sizes.hashBytes);
+  for (let i = 0; i < data.length; i++) {
+    data[i] = (i * 2654435761) >>> 24;
+  }
+  for (const algorithm of ['ed2k', 'crc32', 'md5', 'sha1', 'tth']) {
+    const time = bestOf(() => client.calculateHashBuffer(data, algorithm));
+    record(`hash_buffer.${algorithm}`, data.length / time / 1e9, 'GB/s', 'higher');
+  }
+}
+
+function benchCallOverhead(client) {
+  process.stderr.write('N-API call overhead\n');
+  record('napi.hash_buffer_size', perCall(sizes.calls, () => hashBufferSize(1)), 'ns/call', 'lower', 0.5);
+  const empty = Buffer.alloc(0);
+  record('napi.hash_buffer_empty', perCall(sizes.calls / 10, () => client.calculateHashBuffer(empty, 'crc32')),
+    'ns/call', 'lower', 0.5);
+}
+
+function benchMarshalling() {
+  const count = sizes.marshalFiles;
+  process.stderr.write(`Result marshalling (${count} files)\n`);
+  const batch = bench.makeBatch(count);
+
+  const single = bestOf(() => bench.convertFile(batch, count));
+  record('marshal.file_result', (single * 1e9) / count, 'ns/file', 'lower', 0.25);
+
+  const objects = bestOf(() => bench.convertBatch(batch));
+  record('marshal.batch_result', (objects * 1e9) / count, 'ns/file', 'lower', 0.25);
+
+  const binary = bestOf(() => new BatchResultView(bench.encodeBatch(batch)));
+  record('marshal.batch_binary', (binary * 1e9) / count, 'ns/file', 'lower', 0.25);
+
+  const decoded = bestOf(() => new BatchResultView(bench.encodeBatch(batch)).toBatchResult());
+  record('marshal.batch_binary_decoded', (decoded * 1e9) / count, 'ns/file', 'lower', 0.25);
+}
+
+async function benchDelivery(client, file) {
+  process.stderr.write(`Progress and event delivery (${sizes.fileBytes / MiB} MiB file)\n`);
+
+  const latencies = [];
+  const onEvent = (event) => latencies.push(Date.now() - event.timestamp);
+  client.on('event', onEvent);
+
+  let updates = 0;
+  let last = process.hrtime.bigint();
+  let maxGap = 0;
+  const start = process.hrtime.bigint();
+  await client.processFile(file, {
+    algorithms: ['ed2k'],
+    onProgress: () => {
+      const now = process.hrtime.bigint();
+      maxGap = Math.max(maxGap, Number(now - last) / 1e6);
+      last = now;
+      updates++;
+    }
+  });
+  const elapsed = seconds(start);
+  // Events of the last turn may still be queued
+  await new Promise(resolve => setImmediate(resolve));
+  client.off('event', onEvent);
+
+  record('process_file.ed2k', sizes.fileBytes / elapsed / 1e9, 'GB/s', 'higher');
+  if (updates > 0) {
+    record('progress.max_gap_ms', maxGap, 'ms', 'lower', 1.0);
+    record('progress.rate', updates / elapsed, 'updates/s', 'higher', 0.5);
+  }
+  if (latencies.length > 0) {
+    const mean = latencies.reduce((sum, value) => sum + value, 0) / latencies.length;
+    record('events.latency_mean_ms', mean, 'ms', 'lower', 1.0);
+    record('events.latency_max_ms', Math.max(...latencies), 'ms', 'lower', 1.0);
+  }
+}
+
+async function benchBatchScaling(files) {
+  process.stderr.write(`Batch scaling (${files.length} x ${sizes.batchFileBytes / MiB} MiB)\n`);
+  let single = 0;
+  for (let threads = 1; threads <= maxThreads; threads *= 2) {
+    // A fresh client each time, without a hash cache
+    const client = new AniDBClient();
+    const start = process.hrtime.bigint();
+    await client.processBatch(files, { algorithms: ['ed2k'], maxConcurrent: threads, continueOnError: true });
+    const rate = (files.length * sizes.batchFileBytes) / seconds(start) / 1e9;
+    client.destroy();
+
+    record(`batch.threads_${threads}`, rate, 'GB/s', 'higher');
+    if (threads === 1) {
+      single = rate;
+    } else {
+      record(`batch.speedup_${threads}`, rate / single, 'x', 'higher');
+    }
+  }
+}
+
+async function main() {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'anidb_bench_'));
+  const client = new AniDBClient();
+  try {
+    const file = createFile(dir, 'delivery.bin', sizes.fileBytes, 0);
+    const batchFiles = [];
+    for (let i = 0; i < sizes.batchFiles; i++) {
+      batchFiles.push(createFile(dir, `batch${i}.bin`, sizes.batchFileBytes, i + 1));
+    }
+
+    benchHashBuffer(client);
+    benchCallOverhead(client);
+    benchMarshalling();
+    await benchDelivery(client, file);
+    await benchBatchScaling(batchFiles);
+  } finally {
+    client.destroy();
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+
+  const output = JSON.stringify({ suite: 'node_addon', library_version: version, metrics }, null, 2) + '\n';
+  const target = option('--output');
+  if (target) {
+    fs.writeFileSync(target, output);
+  } else {
+    process.stdout.write(output);
+  }
+}
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
@@ -0,0 +1,181 @@
+/**
+ * Load test of identification through the Node addon
+ *
+ * Starts the mock AniDB server from anidb-test-utils (or uses --server),
+ * then identifies unique hashes with identifyFile or identifyBatch and
+ * reports queries per second, retries, timeouts and tail latency. Results
+ * use the same JSON format as benchmark.js.
+ *
+ * Usage: node bench/identify_load.js [--requests N] [--clients N]
+ *        [--mode single|batch] [--rate N] [--timeout-ms N] [--server ADDR]
+ *        [--mock PATH] [--output FILE] [-- mock server options]
+ *
+ * Options after `--` are passed to the mock server, for example
+ * `-- --latency-ms 20 --loss 0.05`.
+ */
+
+const fs = require('fs');
+const path = require('path');
+const readline = require('readline');
+const { spawn } = require('child_process');
+
+const { AniDBClient, ErrorCode, version } = require('..');
+
+const separator = process.argv.indexOf('--');
+const args = separator >= 0 ? process.argv.slice(2, separator) : process.argv.slice(2);
+const mockArgs = separator >= 0 ? process.argv.slice(separator + 1) : [];
+const option = (name, fallback) => {
+  const index = args.indexOf(name);
+  return index >= 0 && index + 1 < args.length ? args[index + 1] : fallback;
+};
+
+const requests = Number(option('--requests', 200));
+const clients = Math.max(1, Number(option('--clients', 1)));
+const mode = option('--mode', 'single');
+const rate = Number(option('--rate', 50));
+const timeoutMs = Number(option('--timeout-ms', 1000));
+const mockPath = option('--mock', path.join(__dirname, '..', '..', '..', 'target', 'release', 'mock_anidb_server'));
+
+const metrics = {};
+
+function record(name, value, unit, better, tolerance) {
+  metrics[name] = { value, unit, better, ...(tolerance ? { tolerance } : {}) };
+  process.stderr.write(`  ${name.padEnd(32)} ${value.toFixed(3).padStart(12)} ${unit}\n`);
+}
+
+function milliseconds(start) {
+  return Number(process.hrtime.bigint() - start) / 1e6;
+}
+
+function percentile(sorted, p) {
+  return sorted.length === 0 ? 0 : sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+/** Distinct hash for request `i`, so nothing is answered from the cache */
+function ed2kHash(i) {
+  return (i + 1).toString(16).padStart(32, '0');
+}
+
+/** Start the mock server and resolve with its address and process */
+function startMock() {
+  return new Promise((resolve, reject) => {
+    const child = spawn(mockPath, mockArgs, { stdio: ['ignore', 'pipe', 'inherit'] });
+    child.once('error', reject);
+    child.once('exit', (code) => reject(new Error(`mock server exited with ${code}`)));
+    readline.createInterface({ input: child.stdout }).once('line', (line) => resolve({ address: line.trim(), child }));
+  });
+}
+
+/**
+ * Identify `files` one call at a time, returning each call's latency
+ *
+ * identifyFile answers null both for unknown files and network errors, so
+ * both count as not found here.
+ */
+async function runSingle(client, files) {
+  const latencies = [];
+  let identified = 0;
+  for (const { ed2kHash, fileSize } of files) {
+    const start = process.hrtime.bigint();
+    const info = await client.identifyFile(ed2kHash, fileSize);
+    latencies.push(milliseconds(start));
+    if (info) {
+      identified++;
+    }
+  }
+  return { latencies, identified, failed: 0 };
+}
+
+/** Identify `files` as one batch, returning the time until each result */
+async function runBatch(client, files) {
+  const latencies = [];
+  let identified = 0;
+  let failed = 0;
+  const start = process.hrtime.bigint();
+  for await (const { info, error, code } of client.identifyBatch(files)) {
+    latencies.push(milliseconds(start));
+    if (info) {
+      identified++;
+    } else if (error && code !== ErrorCode.FILE_NOT_FOUND) {
+      failed++;
+    }
+  }
+  return { latencies, identified, failed };
+}
+
+async function main() {
+  let server = option('--server');
+  let mock;
+  if (!server) {
+    mock = await startMock();
+    server = mock.address;
+  }
+  process.stderr.write(`Identification load (${requests} requests, ${clients} clients, ${mode}, ${server})\n`);
+
+  const pool = [];
+  try {
+    for (let i = 0; i < clients; i++) {
+      pool.push(new AniDBClient({
+        username: 'bench',
+        password: 'bench',
+        server,
+        requestRate: rate,
+        requestTimeoutMs: timeoutMs
+      }));
+    }
+
+    // Each client takes every `clients`-th request
+    const shares = pool.map((client, c) => {
+      const files = [];
+      for (let i = c; i < requests; i += clients) {
+        files.push({ ed2kHash: ed2kHash(i), fileSize: 1024 * 1024 + i });
+      }
+      return files;
+    });
+
+    const run = mode === 'batch' ? runBatch : runSingle;
+    const start = process.hrtime.bigint();
+    const results = await Promise.all(pool.map((client, c) => run(client, shares[c])));
+    const elapsed = milliseconds(start) / 1000;
+
+    const latencies = results.flatMap(result => result.latencies).sort((a, b) => a - b);
+    const identified = results.reduce((sum, result) => sum + result.identified, 0);
+    const failed = results.reduce((sum, result) => sum + result.failed, 0);
+    const totals = pool.map(client => client.getMetrics()).reduce((sum, m) => ({
+      retries: sum.retries + m.networkRetries,
+      timeouts: sum.timeouts + m.networkTimeouts,
+      rateLimitWaitMs: sum.rateLimitWaitMs + m.rateLimitWaitMs
+    }), { retries: 0, timeouts: 0, rateLimitWaitMs: 0 });
+
+    record('identify.qps', latencies.length / elapsed, 'req/s', 'higher');
+    record('identify.identified', identified, 'count', 'higher');
+    record('identify.not_found', latencies.length - identified - failed, 'count', 'lower', 1.0);
+    record('identify.failed', failed, 'count', 'lower', 1.0);
+    record('identify.retries', totals.retries, 'count', 'lower', 1.0);
+    record('identify.timeouts', totals.timeouts, 'count', 'lower', 1.0);
+    record('identify.rate_limit_wait_ms', totals.rateLimitWaitMs, 'ms', 'lower', 1.0);
+    record('identify.latency_p50_ms', percentile(latencies, 0.5), 'ms', 'lower', 1.0);
+    record('identify.latency_p90_ms', percentile(latencies, 0.9), 'ms', 'lower', 1.0);
+    record('identify.latency_p99_ms', percentile(latencies, 0.99), 'ms', 'lower', 1.0);
+    record('identify.latency_max_ms', latencies.length ? latencies[latencies.length - 1] : 0, 'ms', 'lower', 1.0);
+  } finally {
+    pool.forEach(client => client.destroy());
+    if (mock) {
+      mock.child.removeAllListeners('exit');
+      mock.child.kill('SIGINT');
+    }
+  }
+
+  const output = JSON.stringify({ suite: 'identify_load', library_version: version, metrics }, null, 2) + '\n';
+  const target = option('--output');
+  if (target) {
+    fs.writeFileSync(target, output);
+  } else {
+    process.stdout.write(output);
+  }
+}
+
+main().catch((error) => {
+  console.error(error);
+  process.exit(1);
+});
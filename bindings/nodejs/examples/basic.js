@@ -6,8 +6,8 @@ const { AniDBClient, HashAlgorithm } = require('anidb-client');
 const path = require('path');
 
 async function main() {
-  // Create client with default configuration
-  const client = new AniDBClient();
+  // Create client with default configuration and an in-memory hash cache
+  const client = new AniDBClient({ hashCache: true });
   
   try {
     console.log('AniDB Client Version:', require('anidb-client').version);
@@ -5,31 +5,47 @@
 
 import * as path from 'path';
 import { EventEmitter } from 'events';
-import { Readable } from 'stream';
+import { Readable, Writable } from 'stream';
 import * as fs from 'fs/promises';
 
 // Import native binding
 const binding = require('node-gyp-build')(path.join(__dirname, '..'));
 
+/** Interval at which progress of running operations is sampled (~60 fps) */
+const PROGRESS_FRAME_MS = 16;
+
 // Re-export types
 export * from './types';
+export { BatchResultView } from './result_view';
 
 // Import types
 import {
   AniDBConfig,
   ProcessOptions,
   BatchOptions,
+  ScanOptions,
   FileResult,
   BatchResult,
+  CpuFeatures,
+  MemoryStats,
   AnimeInfo,
+  IdentifyRequest,
+  IdentifyResult,
   HashAlgorithm,
+  HashInput,
+  IoMode,
+  PriorityOption,
+  PrefilterResult,
   Status,
   ErrorCode,
   ProgressInfo,
   EventType,
   AniDBEvent,
+  EventStats,
+  Metrics,
   CallbackType
 } from './types';
+import { BatchResultView } from './result_view';
 
 /**
  * Main AniDB client class
@@ -48,8 +64,8 @@ export class AniDBClient extends EventEmitter {
     super();
     
     try {
-      this.native = new binding.AniDBClientNative(config);
-      this.setupEventPolling();
+      this.native = new binding.AniDBClientNative(this.normalizeConfig(config));
+      this.setupEventPolling(config?.maxPendingEvents);
     } catch (error) {
       throw this.wrapError(error);
     }
@@ -65,11 +81,48 @@ export class AniDBClient extends EventEmitter {
     this.checkDestroyed();
     
     const opts = this.normalizeProcessOptions(options);
+    const onProgress = options?.onProgress;
+    
+    let operation: any;
+    try {
+      operation = this.native.processFileAsync(filePath, opts);
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+    
+    // Sample the native progress snapshot once per frame instead of
+    // receiving a callback for every chunk read
+    let lastUpdates = 0;
+    const sampleProgress = () => {
+      const snapshot = operation.progress();
+      if (!snapshot || snapshot.updates === lastUpdates) {
+        return;
+      }
+      lastUpdates = snapshot.updates;
+      
+      const info: ProgressInfo = {
+        percentage: snapshot.totalBytes > 0 ? (snapshot.bytesProcessed / snapshot.totalBytes) * 100 : 0,
+        bytesProcessed: snapshot.bytesProcessed,
+        totalBytes: snapshot.totalBytes,
+        currentFile: filePath
+      };
+      onProgress?.(info);
+      this.emit('progress', info);
+    };
+    
+    const timer = opts.enableProgress || onProgress
+      ? setInterval(sampleProgress, PROGRESS_FRAME_MS)
+      : undefined;
     
     try {
-      return await this.native.processFileAsync(filePath, opts);
+      return await operation.promise;
     } catch (error) {
       throw this.wrapError(error);
+    } finally {
+      if (timer) {
+        clearInterval(timer);
+        sampleProgress();
+      }
     }
   }
 
@@ -109,6 +162,128 @@ export class AniDBClient extends EventEmitter {
     }
   }
 
+  /**
+   * Process multiple files in batch, returning the results in binary form
+   *
+   * The whole batch is encoded into one ArrayBuffer on the worker thread, so
+   * no per-file objects or hash strings are created until they are read from
+   * the returned view.
+   * @param filePaths Array of file paths
+   * @param options Batch processing options
+   * @returns Lazy view over the batch result
+   */
+  async processBatchBinary(filePaths: string[], options?: BatchOptions): Promise<BatchResultView> {
+    this.checkDestroyed();
+    
+    const opts = { ...this.normalizeBatchOptions(options), binary: true };
+    
+    try {
+      return new BatchResultView(await this.native.processBatchAsync(filePaths, opts));
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+  }
+
+  /**
+   * Process multiple files in batch, yielding each result as its file finishes
+   *
+   * Results arrive in completion order and are not retained natively, so
+   * memory use stays flat for very large batches. Breaking out of the loop
+   * cancels the remaining files.
+   * @param filePaths Array of file paths
+   * @param options Batch processing options
+   * @returns Async iterator of file results
+   */
+  async *processBatchStream(filePaths: string[], options?: BatchOptions): AsyncGenerator<FileResult, void, undefined> {
+    this.checkDestroyed();
+    
+    const opts = this.normalizeBatchOptions(options);
+    yield* this.streamResults((onResult, onEnd) =>
+      this.native.processBatchStream(filePaths, opts, onResult, onEnd));
+  }
+
+  /**
+   * Scan a directory and yield a result for every matching file
+   *
+   * The walk runs natively alongside hashing, so the first result arrives
+   * long before the tree has been listed and no path array is ever built in
+   * JavaScript. Results arrive in completion order; `index` is the order in
+   * which the file was discovered. Breaking out of the loop stops the walk
+   * and cancels the remaining files.
+   * @param root Directory to scan
+   * @param scanOptions Which files to include
+   * @param options Batch processing options
+   * @returns Async iterator of file results
+   */
+  async *scanAndProcess(root: string, scanOptions?: ScanOptions, options?: BatchOptions): AsyncGenerator<FileResult, void, undefined> {
+    this.checkDestroyed();
+    
+    const scan = scanOptions || {};
+    const opts = this.normalizeBatchOptions(options);
+    yield* this.streamResults((onResult, onEnd) =>
+      this.native.scanAndProcess(root, scan, opts, onResult, onEnd));
+  }
+
+  /**
+   * Drive a native result stream as an async iterator
+   * @param start Starts the stream and returns its cancel function
+   */
+  private async *streamResults(
+    start: (onResult: (result: FileResult) => void, onEnd: (error: any) => void) => () => void
+  ): AsyncGenerator<FileResult, void, undefined> {
+    const pending: FileResult[] = [];
+    let finished = false;
+    let failure: Error | undefined;
+    let wake: (() => void) | undefined;
+    
+    const notify = () => {
+      if (wake) {
+        wake();
+        wake = undefined;
+      }
+    };
+    
+    let cancel: () => void;
+    try {
+      cancel = start(
+        (result: FileResult) => {
+          pending.push(result);
+          notify();
+        },
+        (error: any) => {
+          finished = true;
+          if (error) {
+            failure = this.wrapError(error);
+          }
+          notify();
+        }
+      );
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+    
+    try {
+      while (true) {
+        const next = pending.shift();
+        if (next) {
+          yield next;
+        } else if (finished) {
+          break;
+        } else {
+          await new Promise<void>(resolve => { wake = resolve; });
+        }
+      }
+      
+      if (failure) {
+        throw failure;
+      }
+    } finally {
+      if (!finished) {
+        cancel();
+      }
+    }
+  }
+
   /**
    * Process multiple files in batch synchronously
    * @param filePaths Array of file paths
@@ -150,6 +325,9 @@ export class AniDBClient extends EventEmitter {
 
   /**
    * Calculate hash for a buffer
+   *
+   * Hashes on the calling thread; prefer {@link calculateHashes} for large
+   * buffers.
    * @param buffer Data buffer
    * @param algorithm Hash algorithm to use
    * @returns Hash string
@@ -166,6 +344,48 @@ export class AniDBClient extends EventEmitter {
     }
   }
 
+  /**
+   * Calculate several hashes of in-memory data without blocking the event loop
+   *
+   * The memory is pinned and hashed in place on a worker thread, so large
+   * buffers are neither copied nor hashed on the JS thread. All algorithms
+   * are computed in a single pass over the data.
+   * @param data Buffer, typed array, DataView, ArrayBuffer or SharedArrayBuffer
+   * @param algorithms Hash algorithms to calculate
+   * @returns Hashes keyed by algorithm name
+   */
+  async calculateHashes(
+    data: HashInput,
+    algorithms: (HashAlgorithm | string)[] = ['ed2k']
+  ): Promise<Record<string, string>> {
+    this.checkDestroyed();
+    
+    // N-API has no SharedArrayBuffer accessor; a byte view over it exposes
+    // the same memory
+    const source = data instanceof SharedArrayBuffer ? new Uint8Array(data) : data;
+    
+    try {
+      return await this.native.calculateHashes(source, this.parseHashAlgorithms(algorithms));
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+  }
+
+  /**
+   * Create a writable stream that hashes data as it arrives
+   * @param algorithms Hash algorithms to calculate in one pass
+   * @returns Writable stream; await `digest()` for the hashes
+   */
+  createHashWriter(algorithms: (HashAlgorithm | string)[] = ['ed2k']): HashWriter {
+    this.checkDestroyed();
+    
+    try {
+      return new HashWriter(this.native, this.parseHashAlgorithms(algorithms));
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+  }
+
   /**
    * Create a streaming hash calculator
    * @param algorithms Hash algorithms to calculate
@@ -189,13 +409,114 @@ export class AniDBClient extends EventEmitter {
     try {
       return await this.native.identifyFile(ed2kHash, fileSize);
     } catch (error) {
-      if (error.code === ErrorCode.NETWORK) {
+      if (error.code === ErrorCode.FILE_NOT_FOUND || error.code === ErrorCode.NETWORK) {
         return null;
       }
       throw this.wrapError(error);
     }
   }
 
+  /**
+   * Identify many files by ED2K hash and size, yielding each result as it arrives
+   *
+   * Duplicate files are looked up once and files identified before are
+   * answered from the cache first; the rest are queried at the rate AniDB
+   * allows. Breaking out of the loop stops the batch after the current
+   * lookup.
+   * @param files Files to identify
+   * @returns Async iterator of identification results
+   */
+  async *identifyBatch(files: IdentifyRequest[]): AsyncGenerator<IdentifyResult, void, undefined> {
+    this.checkDestroyed();
+    
+    const pending: IdentifyResult[] = [];
+    let finished = false;
+    let failure: Error | undefined;
+    let wake: (() => void) | undefined;
+    
+    const notify = () => {
+      if (wake) {
+        wake();
+        wake = undefined;
+      }
+    };
+    
+    let cancel: () => void;
+    try {
+      cancel = this.native.identifyBatch(
+        files.map(file => file.ed2kHash),
+        files.map(file => file.fileSize),
+        (result: IdentifyResult) => {
+          pending.push(result);
+          notify();
+        },
+        (error: any) => {
+          finished = true;
+          if (error) {
+            failure = this.wrapError(error);
+          }
+          notify();
+        }
+      );
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+    
+    try {
+      while (true) {
+        const next = pending.shift();
+        if (next) {
+          yield next;
+        } else if (finished) {
+          break;
+        } else {
+          await new Promise<void>(resolve => { wake = resolve; });
+        }
+      }
+      
+      if (failure) {
+        throw failure;
+      }
+    } finally {
+      if (!finished) {
+        cancel();
+      }
+    }
+  }
+
+  /**
+   * Load an identification index exported by another client
+   *
+   * Files in the index are identified without contacting AniDB. The index
+   * is memory-mapped, so loading is cheap for any index size.
+   * @param indexPath Path of the index file
+   * @returns Number of files in the index
+   */
+  loadIdentifyIndex(indexPath: string): number {
+    this.checkDestroyed();
+    
+    try {
+      return this.native.identifyIndexLoad(indexPath);
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+  }
+
+  /**
+   * Export the loaded index and every file this client identified
+   * @param indexPath Path of the index file to write
+   * @returns Number of files written
+   */
+  exportIdentifyIndex(indexPath: string): number {
+    this.checkDestroyed();
+    
+    try {
+      return this.native.identifyIndexExport(indexPath);
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+  }
+
   /**
    * Clear the hash cache
    */
@@ -241,6 +562,44 @@ export class AniDBClient extends EventEmitter {
     }
   }
 
+  /**
+   * Check many files against the cache in one native call
+   * @param filePaths Paths to check
+   * @param algorithm Hash algorithm
+   * @returns Whether each path is cached, in input order
+   */
+  areCached(filePaths: string[], algorithm: HashAlgorithm | string = 'ed2k'): boolean[] {
+    this.checkDestroyed();
+    
+    const algo = this.parseHashAlgorithm(algorithm);
+    
+    try {
+      return this.native.cacheCheckFiles(filePaths, algo);
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+  }
+
+  /**
+   * Decide which files need a full hash before reading them
+   *
+   * Files with a cached identity cost one stat(); the others are
+   * fingerprinted from at most 512 KiB of sampled blocks and matched
+   * against fingerprints recorded while hashing. A known-content match is
+   * a strong hint, not proof, that the file is a copy.
+   * @param filePaths Paths to check
+   * @returns Prefilter outcome of each path, in input order
+   */
+  prefilter(filePaths: string[]): PrefilterResult[] {
+    this.checkDestroyed();
+    
+    try {
+      return this.native.cachePrefilterFiles(filePaths);
+    } catch (error) {
+      throw this.wrapError(error);
+    }
+  }
+
   /**
    * Get the last error message
    * @returns Error message
@@ -257,6 +616,33 @@ export class AniDBClient extends EventEmitter {
     }
   }
 
+  /**
+   * Get event delivery counters
+   *
+   * Events are delivered in batches. When listeners fall behind, memory
+   * warnings are merged into the latest one and high-rate events (hash
+   * start, cache, network start) are dropped first.
+   * @returns Delivered, coalesced and dropped event counts
+   */
+  getEventStats(): EventStats {
+    this.checkDestroyed();
+    
+    return this.native.getEventStats();
+  }
+
+  /**
+   * Get processing metrics
+   *
+   * Reads counters the core updates without locking, so it is cheap
+   * enough to scrape every second.
+   * @returns Counters, queue depths and latency histograms of this client
+   */
+  getMetrics(): Metrics {
+    this.checkDestroyed();
+    
+    return this.native.getMetrics();
+  }
+
   /**
    * Destroy the client and release resources
    */
@@ -288,11 +674,13 @@ export class AniDBClient extends EventEmitter {
   /**
    * Setup event system
    */
-  private setupEventPolling(): void {
-    // Connect native events
-    this.native.connectEvents((event: AniDBEvent) => {
-      this.handleNativeEvent(event);
-    });
+  private setupEventPolling(maxPending?: number): void {
+    // Native events arrive in one batch per event loop turn
+    this.native.connectEvents((events: AniDBEvent[]) => {
+      for (const event of events) {
+        this.handleNativeEvent(event);
+      }
+    }, { maxPending });
   }
 
   /**
@@ -339,7 +727,9 @@ export class AniDBClient extends EventEmitter {
     return {
       algorithms: this.parseHashAlgorithms(opts.algorithms || ['ed2k']),
       enableProgress: opts.enableProgress || false,
-      verifyExisting: opts.verifyExisting || false
+      verifyExisting: opts.verifyExisting || false,
+      partialRehash: opts.partialRehash || false,
+      priority: this.parsePriority(opts.priority)
     };
   }
 
@@ -353,10 +743,59 @@ export class AniDBClient extends EventEmitter {
       algorithms: this.parseHashAlgorithms(opts.algorithms || ['ed2k']),
       maxConcurrent: opts.maxConcurrent || 4,
       continueOnError: opts.continueOnError || false,
-      skipExisting: opts.skipExisting || false
+      skipExisting: opts.skipExisting || false,
+      priority: this.parsePriority(opts.priority)
     };
   }
 
+  /**
+   * Normalize client configuration for the native binding
+   */
+  private normalizeConfig(config?: AniDBConfig): any {
+    if (!config || config.ioMode === undefined) {
+      return config;
+    }
+    
+    return { ...config, ioMode: this.parseIoMode(config.ioMode) };
+  }
+
+  /**
+   * Parse I/O mode
+   */
+  private parseIoMode(mode: IoMode | string): number {
+    if (typeof mode === 'number') {
+      return mode;
+    }
+    
+    switch (mode.toLowerCase()) {
+      case 'auto': return binding.IoMode.AUTO;
+      case 'buffered': return binding.IoMode.BUFFERED;
+      case 'mmap': return binding.IoMode.MMAP;
+      case 'direct': return binding.IoMode.DIRECT;
+      case 'io_uring': return binding.IoMode.IO_URING;
+      default: throw new TypeError(`Unknown ioMode: ${mode}`);
+    }
+  }
+
+  /**
+   * Parse scheduling priority
+   */
+  private parsePriority(priority?: PriorityOption): number {
+    if (priority === undefined) {
+      return binding.Priority.NORMAL;
+    }
+    if (typeof priority === 'number') {
+      return priority;
+    }
+    
+    switch (priority.toLowerCase()) {
+      case 'normal': return binding.Priority.NORMAL;
+      case 'background': return binding.Priority.BACKGROUND;
+      case 'interactive': return binding.Priority.INTERACTIVE;
+      default: throw new TypeError(`Unknown priority: ${priority}`);
+    }
+  }
+
   /**
    * Parse hash algorithm
    */
@@ -480,8 +919,76 @@ export class HashStream extends Readable {
   }
 }
 
+/**
+ * Writable stream that hashes everything written to it
+ *
+ * Pipe an upload or object-storage download into it instead of spooling
+ * it to a temporary file. Chunks are hashed in place on a worker thread,
+ * one at a time and in order; the hashes are available once the stream
+ * finishes.
+ */
+export class HashWriter extends Writable {
+  private hasher: any;
+  private hashed = 0;
+  private result?: Record<string, string>;
+
+  constructor(native: any, algorithms: number[]) {
+    super({ decodeStrings: true });
+    this.hasher = native.createHasher(algorithms);
+  }
+
+  /**
+   * Number of bytes hashed so far
+   */
+  get bytesHashed(): number {
+    return this.hashed;
+  }
+
+  /**
+   * Hashes keyed by algorithm name, set once the stream has finished
+   */
+  get hashes(): Record<string, string> | undefined {
+    return this.result;
+  }
+
+  /**
+   * Resolve with the hashes once everything written has been hashed
+   */
+  digest(): Promise<Record<string, string>> {
+    if (this.result) {
+      return Promise.resolve(this.result);
+    }
+    
+    return new Promise((resolve, reject) => {
+      this.once('finish', () => resolve(this.result!));
+      this.once('error', reject);
+    });
+  }
+
+  _write(chunk: Buffer, _encoding: BufferEncoding, callback: (error?: Error | null) => void): void {
+    this.hasher.update(chunk).then(() => {
+      this.hashed += chunk.length;
+      callback();
+    }, callback);
+  }
+
+  _final(callback: (error?: Error | null) => void): void {
+    try {
+      this.result = this.hasher.finalize();
+      callback();
+    } catch (error) {
+      callback(error as Error);
+    }
+  }
+
+  _destroy(error: Error | null, callback: (error?: Error | null) => void): void {
+    this.hasher.destroy();
+    callback(error);
+  }
+}
+
 // Re-export constants
-export { HashAlgorithm, Status, ErrorCode, EventType, CallbackType } from './types';
+export { HashAlgorithm, IoMode, Priority, Status, ErrorCode, EventType, CallbackType } from './types';
 
 // Export utility functions
 export const version = binding.version;
@@ -489,6 +996,22 @@ export const abiVersion = binding.abiVersion;
 export const errorString = binding.errorString;
 export const hashAlgorithmName = binding.hashAlgorithmName;
 export const hashBufferSize = binding.hashBufferSize;
+export const getCpuFeatures: () => CpuFeatures = binding.getCpuFeatures;
+
+/** Native memory usage and buffer pool statistics */
+export const getMemoryStats: () => MemoryStats = binding.getMemoryStats;
+
+/** Change the native memory limit of every client (clamped to 10MB - 2GB) */
+export const setMemoryLimit: (bytes: number) => void = binding.setMemoryLimit;
+
+/** Free pooled native buffers until usage is at most `targetBytes`; returns the bytes freed */
+export const shrinkMemory: (targetBytes: number) => number = binding.shrinkMemory;
+
+/** Free pooled native buffers idle for longer than `maxIdleMs`; returns the bytes freed */
+export const evictStaleBuffers: (maxIdleMs: number) => number = binding.evictStaleBuffers;
+
+/** Free idle pooled native buffers */
+export const memoryGc: () => void = binding.memoryGc;
 
 // Default export
 export default AniDBClient;
\ No newline at end of file
@@ -2,12 +2,14 @@
 #include "client_wrapper.h"
 #include "async_worker.h"
 #include "stream_worker.h"
+#ifdef ANIDB_BENCH
+#include "bench.h"
+#endif
 
 // Module initialization
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    // Initialize the library
-    uint32_t abi_version = 1; // ANIDB_ABI_VERSION
-    anidb_result_t init_result = anidb_init(abi_version);
+    // Initialize the library for the ABI the headers describe
+    anidb_result_t init_result = anidb::init();
     if (init_result != ANIDB_SUCCESS) {
         Napi::Error::New(env, "Failed to initialize AniDB library").ThrowAsJavaScriptException();
         return exports;
@@ -38,6 +40,22 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     status.Set("CANCELLED", Napi::Number::New(env, ANIDB_STATUS_CANCELLED));
     exports.Set("Status", status);
     
+    // Export I/O mode constants
+    Napi::Object ioModes = Napi::Object::New(env);
+    ioModes.Set("AUTO", Napi::Number::New(env, ANIDB_IO_MODE_AUTO));
+    ioModes.Set("BUFFERED", Napi::Number::New(env, ANIDB_IO_MODE_BUFFERED));
+    ioModes.Set("MMAP", Napi::Number::New(env, ANIDB_IO_MODE_MMAP));
+    ioModes.Set("DIRECT", Napi::Number::New(env, ANIDB_IO_MODE_DIRECT));
+    ioModes.Set("IO_URING", Napi::Number::New(env, ANIDB_IO_MODE_IO_URING));
+    exports.Set("IoMode", ioModes);
+    
+    // Export scheduling priority constants
+    Napi::Object priorities = Napi::Object::New(env);
+    priorities.Set("NORMAL", Napi::Number::New(env, ANIDB_PRIORITY_NORMAL));
+    priorities.Set("BACKGROUND", Napi::Number::New(env, ANIDB_PRIORITY_BACKGROUND));
+    priorities.Set("INTERACTIVE", Napi::Number::New(env, ANIDB_PRIORITY_INTERACTIVE));
+    exports.Set("Priority", priorities);
+    
     // Export error codes
     Napi::Object errors = Napi::Object::New(env);
     errors.Set("SUCCESS", Napi::Number::New(env, ANIDB_SUCCESS));
@@ -92,6 +110,129 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
         return Napi::Number::New(info.Env(), size);
     }));
     
+    exports.Set("getCpuFeatures", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        anidb_cpu_features_t features;
+        anidb_result_t result = anidb_get_cpu_features(&features);
+        if (result != ANIDB_SUCCESS) {
+            Napi::Error::New(env, anidb_error_string(result)).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        static const char* const md4_kernels[] = {"scalar", "sse4.1", "avx2", "avx512", "neon"};
+        static const char* const crc32_kernels[] = {"table", "pclmulqdq", "armv8"};
+
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("sse2", Napi::Boolean::New(env, features.sse2 != 0));
+        obj.Set("sse41", Napi::Boolean::New(env, features.sse4_1 != 0));
+        obj.Set("avx2", Napi::Boolean::New(env, features.avx2 != 0));
+        obj.Set("avx512f", Napi::Boolean::New(env, features.avx512f != 0));
+        obj.Set("pclmulqdq", Napi::Boolean::New(env, features.pclmulqdq != 0));
+        obj.Set("neon", Napi::Boolean::New(env, features.neon != 0));
+        obj.Set("crc32", Napi::Boolean::New(env, features.crc32 != 0));
+        obj.Set("md4Kernel", Napi::String::New(env, md4_kernels[features.md4_kernel]));
+        obj.Set("md4Lanes", Napi::Number::New(env, features.md4_lanes));
+        obj.Set("crc32Kernel", Napi::String::New(env, crc32_kernels[features.crc32_kernel]));
+        return static_cast<Napi::Value>(obj);
+    }));
+
+    exports.Set("getMemoryStats", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        anidb_memory_stats_t stats;
+        anidb_result_t result = anidb_get_memory_stats(&stats);
+        anidb_pool_stats_t pools[ANIDB_MEMORY_POOL_COUNT];
+        size_t pool_count = 0;
+        if (result == ANIDB_SUCCESS) {
+            result = anidb_memory_get_pool_stats(pools, ANIDB_MEMORY_POOL_COUNT, &pool_count);
+        }
+        if (result != ANIDB_SUCCESS) {
+            Napi::Error::New(env, anidb_error_string(result)).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        static const char* const pressures[] = {"low", "medium", "high", "critical"};
+
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("totalMemoryUsed", Napi::Number::New(env, static_cast<double>(stats.total_memory_used)));
+        obj.Set("ffiAllocated", Napi::Number::New(env, static_cast<double>(stats.ffi_allocated)));
+        obj.Set("ffiPeak", Napi::Number::New(env, static_cast<double>(stats.ffi_peak)));
+        obj.Set("poolMemory", Napi::Number::New(env, static_cast<double>(stats.pool_memory)));
+        obj.Set("poolHits", Napi::Number::New(env, static_cast<double>(stats.pool_hits)));
+        obj.Set("poolMisses", Napi::Number::New(env, static_cast<double>(stats.pool_misses)));
+        obj.Set("activeAllocations", Napi::Number::New(env, static_cast<double>(stats.active_allocations)));
+        obj.Set("memoryLimit", Napi::Number::New(env, static_cast<double>(stats.memory_limit)));
+        obj.Set("memoryPressure", Napi::String::New(env, pressures[stats.memory_pressure & 3]));
+
+        Napi::Array pool_array = Napi::Array::New(env, pool_count);
+        for (size_t i = 0; i < pool_count; i++) {
+            const anidb_pool_stats_t& pool = pools[i];
+            Napi::Object entry = Napi::Object::New(env);
+            entry.Set("bufferSize", Napi::Number::New(env, static_cast<double>(pool.buffer_size)));
+            entry.Set("pooledBuffers", Napi::Number::New(env, static_cast<double>(pool.pooled_buffers)));
+            entry.Set("pooledBytes", Napi::Number::New(env, static_cast<double>(pool.pooled_bytes)));
+            entry.Set("bytesInUse", Napi::Number::New(env, static_cast<double>(pool.bytes_in_use)));
+            entry.Set("peakBytes", Napi::Number::New(env, static_cast<double>(pool.peak_bytes)));
+            entry.Set("hits", Napi::Number::New(env, static_cast<double>(pool.hits)));
+            entry.Set("misses", Napi::Number::New(env, static_cast<double>(pool.misses)));
+            entry.Set("hitRate", Napi::Number::New(env, pool.hit_rate));
+            pool_array.Set(static_cast<uint32_t>(i), entry);
+        }
+        obj.Set("pools", pool_array);
+        return static_cast<Napi::Value>(obj);
+    }));
+
+    exports.Set("setMemoryLimit", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Memory limit must be a number").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+
+        double limit = info[0].As<Napi::Number>().DoubleValue();
+        anidb_result_t result = limit >= 1
+            ? anidb_memory_set_limit(static_cast<uint64_t>(limit))
+            : ANIDB_ERROR_INVALID_PARAMETER;
+        if (result != ANIDB_SUCCESS) {
+            Napi::Error::New(env, anidb_error_string(result)).ThrowAsJavaScriptException();
+        }
+        return env.Undefined();
+    }));
+
+    exports.Set("shrinkMemory", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Target must be a number").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        double target = info[0].As<Napi::Number>().DoubleValue();
+        uint64_t freed = 0;
+        anidb_memory_shrink(target > 0 ? static_cast<uint64_t>(target) : 0, &freed);
+        return static_cast<Napi::Value>(Napi::Number::New(env, static_cast<double>(freed)));
+    }));
+
+    exports.Set("evictStaleBuffers", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Idle time must be a number").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        double max_idle_ms = info[0].As<Napi::Number>().DoubleValue();
+        uint64_t freed = 0;
+        anidb_memory_evict_stale(max_idle_ms > 0 ? static_cast<uint64_t>(max_idle_ms) : 0, &freed);
+        return static_cast<Napi::Value>(Napi::Number::New(env, static_cast<double>(freed)));
+    }));
+
+    exports.Set("memoryGc", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        anidb_memory_gc();
+        return info.Env().Undefined();
+    }));
+
+#ifdef ANIDB_BENCH
+    Bench::Init(env, exports);
+#endif
+    
     // Set up cleanup on process exit
     env.SetInstanceData(nullptr, [](Napi::Env env, void* data) {
         anidb_cleanup();
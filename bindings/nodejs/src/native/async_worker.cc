@@ -1,52 +1,32 @@
 #include "async_worker.h"
 #include "client_wrapper.h"
+#include "result_codec.h"
+#include "utils.h"
+#include <cstring>
 
-// ProcessFileWorker implementation
-ProcessFileWorker::ProcessFileWorker(Napi::Env env, anidb_client_handle_t handle,
-                                   const std::string& file_path, const Napi::Object& options,
-                                   Napi::Promise::Deferred deferred)
-    : AniDBAsyncWorker(env, handle, deferred), file_path_(file_path), 
-      enable_progress_(false), verify_existing_(false), file_result_(nullptr) {
-    
-    // Parse options
-    if (options.Has("algorithms") && options.Get("algorithms").IsArray()) {
-        Napi::Array algo_array = options.Get("algorithms").As<Napi::Array>();
-        for (uint32_t i = 0; i < algo_array.Length(); i++) {
-            if (algo_array.Get(i).IsNumber()) {
-                algorithms_.push_back(static_cast<anidb_hash_algorithm_t>(
-                    algo_array.Get(i).As<Napi::Number>().Int32Value()
-                ));
-            }
-        }
-    }
-    
-    if (algorithms_.empty()) {
-        algorithms_.push_back(ANIDB_HASH_ED2K);
-    }
-    
-    enable_progress_ = options.Has("enableProgress") && 
-        options.Get("enableProgress").As<Napi::Boolean>().Value();
-    verify_existing_ = options.Has("verifyExisting") && 
-        options.Get("verifyExisting").As<Napi::Boolean>().Value();
-}
-
-ProcessFileWorker::~ProcessFileWorker() {
-    if (file_result_) {
-        anidb_free_file_result(file_result_);
-    }
+// ProcessBatchWorker implementation
+ProcessBatchWorker::ProcessBatchWorker(Napi::Env env, anidb::ClientRef client,
+                                     anidb::PathList file_paths,
+                                     const anidb::BatchOptions& options, bool binary,
+                                     Napi::Promise::Deferred deferred)
+    : AniDBAsyncWorker(env, client, deferred), file_paths_(std::move(file_paths)),
+      options_(options), binary_(binary) {
 }
 
-void ProcessFileWorker::Execute() {
-    anidb_process_options_t options = {};
-    options.algorithms = algorithms_.data();
-    options.algorithm_count = algorithms_.size();
-    options.enable_progress = enable_progress_ ? 1 : 0;
-    options.verify_existing = verify_existing_ ? 1 : 0;
+void ProcessBatchWorker::Execute() {
+    auto batch = client_.process_batch(file_paths_, options_);
+    result_ = batch.code();
     
-    result_ = anidb_process_file(handle_, file_path_.c_str(), &options, &file_result_);
+    if (result_ == ANIDB_SUCCESS && binary_) {
+        if (!ResultCodec::EncodeBatch(batch->get(), &encoded_)) {
+            result_ = ANIDB_ERROR_OUT_OF_MEMORY;
+        }
+    } else if (result_ == ANIDB_SUCCESS) {
+        batch_result_ = std::move(batch.value());
+    }
 }
 
-void ProcessFileWorker::OnOK() {
+void ProcessBatchWorker::OnOK() {
     Napi::Env env = Env();
     
     if (result_ != ANIDB_SUCCESS) {
@@ -54,137 +34,103 @@ void ProcessFileWorker::OnOK() {
         return;
     }
     
-    Napi::Object js_result = ClientWrapper::ConvertFileResult(env, file_result_);
-    deferred_.Resolve(js_result);
-}
-
-// ProcessBatchWorker implementation
-ProcessBatchWorker::ProcessBatchWorker(Napi::Env env, anidb_client_handle_t handle,
-                                     const std::vector<std::string>& file_paths,
-                                     const Napi::Object& options,
-                                     Napi::Promise::Deferred deferred)
-    : AniDBAsyncWorker(env, handle, deferred), file_paths_(file_paths),
-      max_concurrent_(4), continue_on_error_(false), skip_existing_(false),
-      batch_result_(nullptr) {
-    
-    // Parse options
-    if (options.Has("algorithms") && options.Get("algorithms").IsArray()) {
-        Napi::Array algo_array = options.Get("algorithms").As<Napi::Array>();
-        for (uint32_t i = 0; i < algo_array.Length(); i++) {
-            if (algo_array.Get(i).IsNumber()) {
-                algorithms_.push_back(static_cast<anidb_hash_algorithm_t>(
-                    algo_array.Get(i).As<Napi::Number>().Int32Value()
-                ));
-            }
-        }
-    }
-    
-    if (algorithms_.empty()) {
-        algorithms_.push_back(ANIDB_HASH_ED2K);
-    }
-    
-    if (options.Has("maxConcurrent")) {
-        max_concurrent_ = options.Get("maxConcurrent").As<Napi::Number>().Uint32Value();
+    if (binary_) {
+        Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, encoded_.size());
+        memcpy(buffer.Data(), encoded_.data(), encoded_.size());
+        deferred_.Resolve(buffer);
+        return;
     }
     
-    continue_on_error_ = options.Has("continueOnError") && 
-        options.Get("continueOnError").As<Napi::Boolean>().Value();
-    skip_existing_ = options.Has("skipExisting") && 
-        options.Get("skipExisting").As<Napi::Boolean>().Value();
+    Napi::Object js_result = ClientWrapper::ConvertBatchResult(env, batch_result_.get());
+    deferred_.Resolve(js_result);
 }
 
-ProcessBatchWorker::~ProcessBatchWorker() {
-    if (batch_result_) {
-        anidb_free_batch_result(batch_result_);
-    }
+// CalculateHashWorker implementation
+CalculateHashWorker::CalculateHashWorker(Napi::Env env, const std::string& file_path,
+                                       anidb_hash_algorithm_t algorithm,
+                                       Napi::Promise::Deferred deferred)
+    : AniDBAsyncWorker(env, nullptr, deferred), file_path_(file_path), algorithm_(algorithm) {
 }
 
-void ProcessBatchWorker::Execute() {
-    std::vector<const char*> file_path_ptrs;
-    for (const auto& path : file_paths_) {
-        file_path_ptrs.push_back(path.c_str());
-    }
-    
-    anidb_batch_options_t options = {};
-    options.algorithms = algorithms_.data();
-    options.algorithm_count = algorithms_.size();
-    options.max_concurrent = max_concurrent_;
-    options.continue_on_error = continue_on_error_ ? 1 : 0;
-    options.skip_existing = skip_existing_ ? 1 : 0;
+void CalculateHashWorker::Execute() {
+    auto hash = anidb::hash_file(file_path_, algorithm_);
+    result_ = hash.code();
     
-    result_ = anidb_process_batch(handle_, file_path_ptrs.data(),
-        file_path_ptrs.size(), &options, &batch_result_);
+    if (result_ == ANIDB_SUCCESS) {
+        hash_result_ = *hash;
+    }
 }
 
-void ProcessBatchWorker::OnOK() {
+void CalculateHashWorker::OnOK() {
     Napi::Env env = Env();
     
     if (result_ != ANIDB_SUCCESS) {
-        deferred_.Reject(Napi::Error::New(env, anidb_error_string(result_)).Value());
+        deferred_.Reject(Utils::CreateError(env, result_).Value());
         return;
     }
     
-    Napi::Object js_result = ClientWrapper::ConvertBatchResult(env, batch_result_);
-    deferred_.Resolve(js_result);
+    std::string_view hash = hash_result_[0];
+    deferred_.Resolve(Napi::String::New(env, hash.data(), hash.size()));
 }
 
-// CalculateHashWorker implementation
-CalculateHashWorker::CalculateHashWorker(Napi::Env env, const std::string& file_path,
-                                       anidb_hash_algorithm_t algorithm,
-                                       Napi::Promise::Deferred deferred)
-    : AniDBAsyncWorker(env, nullptr, deferred), file_path_(file_path), algorithm_(algorithm) {
+// HashBufferWorker implementation
+HashBufferWorker::HashBufferWorker(Napi::Env env, Napi::Object source, anidb::ByteSpan data,
+                                   const anidb::AlgorithmSet& algorithms,
+                                   Napi::Promise::Deferred deferred)
+    : AniDBAsyncWorker(env, nullptr, deferred), pinned_(Napi::Persistent(source)),
+      data_(data), algorithms_(algorithms) {
 }
 
-void CalculateHashWorker::Execute() {
-    size_t buffer_size = anidb_hash_buffer_size(algorithm_);
-    hash_result_.resize(buffer_size);
-    
-    result_ = anidb_calculate_hash(file_path_.c_str(), algorithm_,
-        &hash_result_[0], buffer_size);
+void HashBufferWorker::Execute() {
+    // Reads the pinned JS memory directly; nothing is copied
+    auto hashes = anidb::hash_buffer(data_, algorithms_);
+    result_ = hashes.code();
     
     if (result_ == ANIDB_SUCCESS) {
-        // Trim to actual string length
-        hash_result_.resize(strlen(hash_result_.c_str()));
+        hashes_ = *hashes;
     }
 }
 
-void CalculateHashWorker::OnOK() {
+void HashBufferWorker::OnOK() {
     Napi::Env env = Env();
+    pinned_.Reset();
     
     if (result_ != ANIDB_SUCCESS) {
-        deferred_.Reject(Napi::Error::New(env, anidb_error_string(result_)).Value());
+        deferred_.Reject(Utils::CreateError(env, result_).Value());
         return;
     }
     
-    deferred_.Resolve(Napi::String::New(env, hash_result_));
+    Napi::Object hashes = Napi::Object::New(env);
+    for (size_t i = 0; i < algorithms_.size(); i++) {
+        std::string_view hash = hashes_[i];
+        hashes.Set(Utils::HashAlgorithmToString(algorithms_[i]),
+            Napi::String::New(env, hash.data(), hash.size()));
+    }
+    deferred_.Resolve(hashes);
 }
 
 // IdentifyFileWorker implementation
-IdentifyFileWorker::IdentifyFileWorker(Napi::Env env, anidb_client_handle_t handle,
+IdentifyFileWorker::IdentifyFileWorker(Napi::Env env, anidb::ClientRef client,
                                      const std::string& ed2k_hash, uint64_t file_size,
                                      Napi::Promise::Deferred deferred)
-    : AniDBAsyncWorker(env, handle, deferred), ed2k_hash_(ed2k_hash),
-      file_size_(file_size), anime_info_(nullptr) {
-}
-
-IdentifyFileWorker::~IdentifyFileWorker() {
-    if (anime_info_) {
-        anidb_free_anime_info(anime_info_);
-    }
+    : AniDBAsyncWorker(env, client, deferred), ed2k_hash_(ed2k_hash),
+      file_size_(file_size) {
 }
 
 void IdentifyFileWorker::Execute() {
-    result_ = anidb_identify_file(handle_, ed2k_hash_.c_str(), file_size_, &anime_info_);
+    auto info = client_.identify_file(ed2k_hash_, file_size_);
+    result_ = info.code();
+    anime_info_ = std::move(info.value());
 }
 
 void IdentifyFileWorker::OnOK() {
     Napi::Env env = Env();
     
     if (result_ != ANIDB_SUCCESS) {
-        deferred_.Reject(Napi::Error::New(env, anidb_error_string(result_)).Value());
+        deferred_.Reject(Utils::CreateError(env, result_).Value());
         return;
     }
     
-    Napi::Object js_info = ClientWrapper::ConvertAnimeInfo(env, anime_info_);
+    Napi::Object js_info = ClientWrapper::ConvertAnimeInfo(env, anime_info_.get());
     deferred_.Resolve(js_info);
 }
\ No newline at end of file
@@ -2,20 +2,20 @@
 #define ASYNC_WORKER_H
 
 #include <napi.h>
-#include "../../../anidb_client_core/include/anidb.h"
+#include "../../../anidb_client_core/include/anidb.hpp"
 #include <string>
 #include <vector>
 
 // Base class for async operations
 class AniDBAsyncWorker : public Napi::AsyncWorker {
 protected:
-    anidb_client_handle_t handle_;
+    anidb::ClientRef client_;
     anidb_result_t result_;
     
 public:
-    AniDBAsyncWorker(Napi::Env env, anidb_client_handle_t handle,
+    AniDBAsyncWorker(Napi::Env env, anidb::ClientRef client,
                      Napi::Promise::Deferred deferred)
-        : Napi::AsyncWorker(env), handle_(handle), result_(ANIDB_SUCCESS),
+        : Napi::AsyncWorker(env), client_(client), result_(ANIDB_SUCCESS),
           deferred_(deferred) {}
     
     void OnError(const Napi::Error& error) override {
@@ -26,44 +26,24 @@ protected:
     Napi::Promise::Deferred deferred_;
 };
 
-// Async worker for processing a single file
-class ProcessFileWorker : public AniDBAsyncWorker {
-private:
-    std::string file_path_;
-    std::vector<anidb_hash_algorithm_t> algorithms_;
-    bool enable_progress_;
-    bool verify_existing_;
-    anidb_file_result_t* file_result_;
-    
-public:
-    ProcessFileWorker(Napi::Env env, anidb_client_handle_t handle,
-                      const std::string& file_path, const Napi::Object& options,
-                      Napi::Promise::Deferred deferred);
-    
-    ~ProcessFileWorker();
-    
-    void Execute() override;
-    void OnOK() override;
-};
-
 // Async worker for batch processing
+//
+// With the binary option the result is encoded on the worker thread (see
+// result_codec.h) and resolved as a single ArrayBuffer.
 class ProcessBatchWorker : public AniDBAsyncWorker {
 private:
-    std::vector<std::string> file_paths_;
-    std::vector<anidb_hash_algorithm_t> algorithms_;
-    size_t max_concurrent_;
-    bool continue_on_error_;
-    bool skip_existing_;
-    anidb_batch_result_t* batch_result_;
+    anidb::PathList file_paths_;
+    anidb::BatchOptions options_;
+    bool binary_;
+    anidb::BatchResult batch_result_;
+    std::vector<uint8_t> encoded_;
     
 public:
-    ProcessBatchWorker(Napi::Env env, anidb_client_handle_t handle,
-                       const std::vector<std::string>& file_paths,
-                       const Napi::Object& options,
+    ProcessBatchWorker(Napi::Env env, anidb::ClientRef client,
+                       anidb::PathList file_paths,
+                       const anidb::BatchOptions& options, bool binary,
                        Napi::Promise::Deferred deferred);
     
-    ~ProcessBatchWorker();
-    
     void Execute() override;
     void OnOK() override;
 };
@@ -73,7 +53,7 @@ class CalculateHashWorker : public AniDBAsyncWorker {
 private:
     std::string file_path_;
     anidb_hash_algorithm_t algorithm_;
-    std::string hash_result_;
+    anidb::HashValues hash_result_;
     
 public:
     CalculateHashWorker(Napi::Env env, const std::string& file_path,
@@ -84,20 +64,39 @@ public:
     void OnOK() override;
 };
 
+// Async worker hashing caller memory in place with several algorithms
+//
+// The JS object owning the memory (Buffer, TypedArray, DataView or
+// ArrayBuffer) is held by a persistent reference for the lifetime of the
+// worker, so the backing store cannot be collected while the core reads it.
+class HashBufferWorker : public AniDBAsyncWorker {
+private:
+    Napi::ObjectReference pinned_;
+    anidb::ByteSpan data_;
+    anidb::AlgorithmSet algorithms_;
+    anidb::HashValues hashes_;
+    
+public:
+    HashBufferWorker(Napi::Env env, Napi::Object source, anidb::ByteSpan data,
+                     const anidb::AlgorithmSet& algorithms,
+                     Napi::Promise::Deferred deferred);
+    
+    void Execute() override;
+    void OnOK() override;
+};
+
 // Async worker for anime identification
 class IdentifyFileWorker : public AniDBAsyncWorker {
 private:
     std::string ed2k_hash_;
     uint64_t file_size_;
-    anidb_anime_info_t* anime_info_;
+    anidb::AnimeInfo anime_info_;
     
 public:
-    IdentifyFileWorker(Napi::Env env, anidb_client_handle_t handle,
+    IdentifyFileWorker(Napi::Env env, anidb::ClientRef client,
                        const std::string& ed2k_hash, uint64_t file_size,
                        Napi::Promise::Deferred deferred);
     
-    ~IdentifyFileWorker();
-    
     void Execute() override;
     void OnOK() override;
 };
@@ -0,0 +1,111 @@
+#include "batch_stream.h"
+#include "client_wrapper.h"
+
+BatchStream::BatchStream(Napi::Env env, Napi::Function on_result, Napi::Function on_end)
+    : on_end_(Napi::Persistent(on_end)) {
+    // The thread-safe function keeps the event loop alive until the end
+    tsfn_ = Napi::ThreadSafeFunction::New(
+        env,
+        on_result,
+        "BatchStream",
+        0,
+        1
+    );
+}
+
+Napi::Value BatchStream::Start(Napi::Env env, anidb::ClientRef client,
+                               const anidb::PathList& file_paths,
+                               anidb::BatchOptions options,
+                               Napi::Function on_result, Napi::Function on_end) {
+    auto* stream = new BatchStream(env, on_result, on_end);
+    
+    // Paths and options are copied by the core before the call returns
+    options.completion_callback(&BatchStream::OnComplete).user_data(stream);
+    return Adopt(env, stream, client.process_batch_stream(file_paths, options, &BatchStream::OnResult));
+}
+
+Napi::Value BatchStream::StartScan(Napi::Env env, anidb::ClientRef client,
+                                   const std::string& root,
+                                   const anidb::ScanOptions& scan_options,
+                                   anidb::BatchOptions options,
+                                   Napi::Function on_result, Napi::Function on_end) {
+    auto* stream = new BatchStream(env, on_result, on_end);
+    
+    // Patterns are copied by the core; the walk starts before this returns
+    options.completion_callback(&BatchStream::OnComplete).user_data(stream);
+    return Adopt(env, stream, client.scan_and_process(root, scan_options, options,
+        &BatchStream::OnResult));
+}
+
+Napi::Value BatchStream::Adopt(Napi::Env env, BatchStream* stream, anidb::Result<anidb::Batch> batch) {
+    if (!batch) {
+        stream->tsfn_.Release();
+        delete stream;
+        Napi::Error::New(env, anidb_error_string(batch.code())).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    stream->batch_ = std::move(batch.value());
+    
+    // Cancelling a finished (destroyed) batch is a harmless invalid-handle error
+    anidb_batch_handle_t handle = stream->batch_.get();
+    return Napi::Function::New(env, [handle](const Napi::CallbackInfo& info) -> Napi::Value {
+        anidb_batch_cancel(handle);
+        return info.Env().Undefined();
+    }, "cancel");
+}
+
+void BatchStream::OnResult(size_t index, anidb_file_result_t* result, void* user_data) {
+    auto* stream = static_cast<BatchStream*>(user_data);
+    auto* data = new StreamedResult{index, result};
+    
+    napi_status status = stream->tsfn_.NonBlockingCall(data,
+        [](Napi::Env env, Napi::Function callback, StreamedResult* data) {
+            anidb::FileResult result(data->result);
+            Napi::Object js_result = ClientWrapper::ConvertFileResult(env, result.view());
+            js_result.Set("index", Napi::Number::New(env, static_cast<double>(data->index)));
+            delete data;
+            callback.Call({js_result});
+        });
+    
+    if (status != napi_ok) {
+        // Environment is shutting down; drop the result
+        anidb_free_file_result(result);
+        delete data;
+    }
+}
+
+void BatchStream::OnComplete(anidb_result_t result, void* user_data) {
+    auto* stream = static_cast<BatchStream*>(user_data);
+    auto* data = new Completion{stream, result};
+    
+    // Queued behind every result, so the end is always observed last
+    napi_status status = stream->tsfn_.NonBlockingCall(data,
+        [](Napi::Env env, Napi::Function /*callback*/, Completion* data) {
+            data->stream->Finish(env, data->result);
+            delete data;
+        });
+    
+    if (status != napi_ok) {
+        stream->tsfn_.Release();
+        delete data;
+    }
+}
+
+void BatchStream::Finish(Napi::Env env, anidb_result_t result) {
+    Napi::HandleScope scope(env);
+    
+    Napi::Value error = env.Null();
+    if (result != ANIDB_SUCCESS) {
+        Napi::Error err = Napi::Error::New(env, anidb_error_string(result));
+        err.Set("code", Napi::Number::New(env, result));
+        error = err.Value();
+    }
+    
+    batch_.reset();
+    
+    Napi::FunctionReference on_end = std::move(on_end_);
+    tsfn_.Release();
+    delete this;
+    
+    on_end.Call({error});
+}
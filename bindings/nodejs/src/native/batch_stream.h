@@ -0,0 +1,62 @@
+#ifndef BATCH_STREAM_H
+#define BATCH_STREAM_H
+
+#include <napi.h>
+#include "../../../anidb_client_core/include/anidb.hpp"
+
+// Native streaming batch
+//
+// Runs anidb_process_batch_stream() or anidb_scan_and_process() on the
+// core's runtime. Each file result
+// is forwarded to the JS thread through a thread-safe function, converted,
+// and freed immediately, so nothing accumulates on either side of the
+// boundary while a large batch runs.
+class BatchStream {
+public:
+    // Start the batch. on_result(result) is called once per file and
+    // on_end(error | null) once after the last result. Returns a function
+    // that cancels the batch.
+    static Napi::Value Start(Napi::Env env, anidb::ClientRef client,
+                             const anidb::PathList& file_paths,
+                             anidb::BatchOptions options,
+                             Napi::Function on_result, Napi::Function on_end);
+    
+    // Walk root natively and stream a result for every matching file, with
+    // the same callbacks and cancel function as Start. The path list never
+    // exists on the JS side.
+    static Napi::Value StartScan(Napi::Env env, anidb::ClientRef client,
+                                 const std::string& root,
+                                 const anidb::ScanOptions& scan_options,
+                                 anidb::BatchOptions options,
+                                 Napi::Function on_result, Napi::Function on_end);
+
+private:
+    BatchStream(Napi::Env env, Napi::Function on_result, Napi::Function on_end);
+    
+    // Take ownership of a started batch and return its cancel function,
+    // or throw and free the stream if it failed to start
+    static Napi::Value Adopt(Napi::Env env, BatchStream* stream, anidb::Result<anidb::Batch> batch);
+
+    struct StreamedResult {
+        size_t index;
+        anidb_file_result_t* result;
+    };
+
+    struct Completion {
+        BatchStream* stream;
+        anidb_result_t result;
+    };
+
+    // Called by the core from its worker threads
+    static void OnResult(size_t index, anidb_file_result_t* result, void* user_data);
+    static void OnComplete(anidb_result_t result, void* user_data);
+
+    // Report the end of the stream and release the batch (JS thread)
+    void Finish(Napi::Env env, anidb_result_t result);
+
+    Napi::ThreadSafeFunction tsfn_;
+    Napi::FunctionReference on_end_;
+    anidb::Batch batch_;
+};
+
+#endif // BATCH_STREAM_H
@@ -0,0 +1,123 @@
+#include "bench.h"
+#include "client_wrapper.h"
+#include "result_codec.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A batch result of `count` completed files with ED2K, CRC32 and MD5 hashes,
+// shaped like the ones anidb_process_batch returns
+class SyntheticBatch {
+public:
+    explicit SyntheticBatch(size_t count) : files_(count), hashes_(count * 3) {
+        for (size_t i = 0; i < count; i++) {
+            paths_.push_back("/library/Series " + std::to_string(i / 12) +
+                "/Series - " + std::to_string(i % 12 + 1) + " [1080p].mkv");
+        }
+        for (size_t i = 0; i < count; i++) {
+            anidb_hash_result_t* hashes = &hashes_[i * 3];
+            hashes[0] = {ANIDB_HASH_ED2K, const_cast<char*>(kEd2k), strlen(kEd2k), 0};
+            hashes[1] = {ANIDB_HASH_CRC32, const_cast<char*>(kCrc32), strlen(kCrc32), 0};
+            hashes[2] = {ANIDB_HASH_MD5, const_cast<char*>(kMd5), strlen(kMd5), 0};
+
+            anidb_file_result_t& file = files_[i];
+            file.file_path = const_cast<char*>(paths_[i].c_str());
+            file.file_size = 1400000000ull + i;
+            file.status = ANIDB_STATUS_COMPLETED;
+            file.hashes = hashes;
+            file.hash_count = 3;
+            file.processing_time_ms = 2300;
+            file.error_message = nullptr;
+        }
+        batch_.total_files = count;
+        batch_.successful_files = count;
+        batch_.failed_files = 0;
+        batch_.results = files_.empty() ? nullptr : files_.data();
+        batch_.total_time_ms = 2300 * count;
+    }
+
+    const anidb_batch_result_t* Get() const { return &batch_; }
+
+private:
+    static constexpr const char* kEd2k = "a1b2c3d4e5f60718293a4b5c6d7e8f90";
+    static constexpr const char* kCrc32 = "5d9eb612";
+    static constexpr const char* kMd5 = "0123456789abcdef0123456789abcdef";
+
+    std::vector<std::string> paths_;
+    std::vector<anidb_file_result_t> files_;
+    std::vector<anidb_hash_result_t> hashes_;
+    anidb_batch_result_t batch_;
+};
+
+const SyntheticBatch* GetBatch(const Napi::CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsExternal()) {
+        Napi::TypeError::New(info.Env(), "Expected a batch from makeBatch()").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    return info[0].As<Napi::External<SyntheticBatch>>().Data();
+}
+
+} // namespace
+
+namespace Bench {
+
+void Init(Napi::Env env, Napi::Object exports) {
+    Napi::Object bench = Napi::Object::New(env);
+    
+    // makeBatch(count) -> opaque batch, freed with its JS handle
+    bench.Set("makeBatch", Napi::Function::New(env, [](const Napi::CallbackInfo& info) -> Napi::Value {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a file count").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        size_t count = info[0].As<Napi::Number>().Uint32Value();
+        return Napi::External<SyntheticBatch>::New(env, new SyntheticBatch(count),
+            [](Napi::Env, SyntheticBatch* batch) { delete batch; });
+    }));
+    
+    // convertFile(batch, iterations): ConvertFileResult on the first file,
+    // each result dropped with its handle scope
+    bench.Set("convertFile", Napi::Function::New(env, [](const Napi::CallbackInfo& info) -> Napi::Value {
+        Napi::Env env = info.Env();
+        const SyntheticBatch* batch = GetBatch(info);
+        if (!batch || batch->Get()->total_files == 0) {
+            return env.Undefined();
+        }
+        uint32_t iterations = info.Length() > 1 ? info[1].As<Napi::Number>().Uint32Value() : 1;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Napi::HandleScope scope(env);
+            ClientWrapper::ConvertFileResult(env, &batch->Get()->results[0]);
+        }
+        return env.Undefined();
+    }));
+    
+    // convertBatch(batch) -> the object processBatch() would resolve
+    bench.Set("convertBatch", Napi::Function::New(env, [](const Napi::CallbackInfo& info) -> Napi::Value {
+        const SyntheticBatch* batch = GetBatch(info);
+        if (!batch) {
+            return info.Env().Undefined();
+        }
+        return ClientWrapper::ConvertBatchResult(info.Env(), batch->Get());
+    }));
+    
+    // encodeBatch(batch) -> the ArrayBuffer processBatchBinary() would resolve
+    bench.Set("encodeBatch", Napi::Function::New(env, [](const Napi::CallbackInfo& info) -> Napi::Value {
+        Napi::Env env = info.Env();
+        const SyntheticBatch* batch = GetBatch(info);
+        std::vector<uint8_t> encoded;
+        if (!batch || !ResultCodec::EncodeBatch(batch->Get(), &encoded)) {
+            return env.Undefined();
+        }
+        Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, encoded.size());
+        memcpy(buffer.Data(), encoded.data(), encoded.size());
+        return buffer;
+    }));
+    
+    exports.Set("bench", bench);
+}
+
+} // namespace Bench
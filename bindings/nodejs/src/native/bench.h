@@ -0,0 +1,15 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <napi.h>
+
+// Marshalling benchmarks, compiled only into the anidb_client_bench target
+// (binding.gyp, build_bench=1) and driven by bench/benchmark.js
+//
+// Synthetic batch results are built natively so the cost of turning them
+// into JS values can be measured without hashing anything.
+namespace Bench {
+    void Init(Napi::Env env, Napi::Object exports);
+}
+
+#endif // BENCH_H
@@ -1,5 +1,11 @@
 #include "client_wrapper.h"
 #include "async_worker.h"
+#include "batch_stream.h"
+#include "file_operation.h"
+#include "hasher.h"
+#include "identify_stream.h"
+#include "utils.h"
+#include <cstdio>
 #include <sstream>
 
 Napi::FunctionReference ClientWrapper::constructor;
@@ -11,18 +17,27 @@ Napi::Object ClientWrapper::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("processFileAsync", &ClientWrapper::ProcessFileAsync),
         InstanceMethod("processBatch", &ClientWrapper::ProcessBatch),
         InstanceMethod("processBatchAsync", &ClientWrapper::ProcessBatchAsync),
+        InstanceMethod("processBatchStream", &ClientWrapper::ProcessBatchStream),
+        InstanceMethod("scanAndProcess", &ClientWrapper::ScanAndProcess),
         
         // Hash calculation
         InstanceMethod("calculateHash", &ClientWrapper::CalculateHash),
         InstanceMethod("calculateHashBuffer", &ClientWrapper::CalculateHashBuffer),
+        InstanceMethod("calculateHashes", &ClientWrapper::CalculateHashes),
+        InstanceMethod("createHasher", &ClientWrapper::CreateHasher),
         
         // Cache management
         InstanceMethod("cacheClear", &ClientWrapper::CacheClear),
         InstanceMethod("cacheGetStats", &ClientWrapper::CacheGetStats),
         InstanceMethod("cacheCheckFile", &ClientWrapper::CacheCheckFile),
+        InstanceMethod("cacheCheckFiles", &ClientWrapper::CacheCheckFiles),
+        InstanceMethod("cachePrefilterFiles", &ClientWrapper::CachePrefilterFiles),
         
         // Anime identification
         InstanceMethod("identifyFile", &ClientWrapper::IdentifyFile),
+        InstanceMethod("identifyBatch", &ClientWrapper::IdentifyBatch),
+        InstanceMethod("identifyIndexLoad", &ClientWrapper::IdentifyIndexLoad),
+        InstanceMethod("identifyIndexExport", &ClientWrapper::IdentifyIndexExport),
         
         // Error handling
         InstanceMethod("getLastError", &ClientWrapper::GetLastError),
@@ -33,6 +48,8 @@ Napi::Object ClientWrapper::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("connectEvents", &ClientWrapper::ConnectEvents),
         InstanceMethod("disconnectEvents", &ClientWrapper::DisconnectEvents),
         InstanceMethod("pollEvents", &ClientWrapper::PollEvents),
+        InstanceMethod("getEventStats", &ClientWrapper::GetEventStats),
+        InstanceMethod("getMetrics", &ClientWrapper::GetMetrics),
     });
 
     constructor = Napi::Persistent(func);
@@ -43,22 +60,30 @@ Napi::Object ClientWrapper::Init(Napi::Env env, Napi::Object exports) {
 }
 
 ClientWrapper::ClientWrapper(const Napi::CallbackInfo& info) 
-    : Napi::ObjectWrap<ClientWrapper>(info), handle_(nullptr), event_connected_(false) {
+    : Napi::ObjectWrap<ClientWrapper>(info), event_bridge_(nullptr),
+      event_connected_(false) {
     
     Napi::Env env = info.Env();
     
     if (info.Length() == 0) {
         // Create with default config
-        anidb_result_t result = anidb_client_create(&handle_);
-        CheckResult(env, result);
+        auto client = anidb::Client::create();
+        CheckResult(env, client.code());
+        client_ = std::move(client.value());
     } else if (info.Length() == 1 && info[0].IsObject()) {
         // Create with custom config
         Napi::Object config = info[0].As<Napi::Object>();
         anidb_config_t native_config = {};
         
+        // Strings must outlive anidb_client_create_with_config
+        std::string cache_dir;
+        std::string username;
+        std::string password;
+        std::string server;
+        
         // Parse configuration
         if (config.Has("cacheDir") && config.Get("cacheDir").IsString()) {
-            std::string cache_dir = config.Get("cacheDir").As<Napi::String>().Utf8Value();
+            cache_dir = config.Get("cacheDir").As<Napi::String>().Utf8Value();
             native_config.cache_dir = cache_dir.c_str();
         }
         
@@ -83,41 +108,90 @@ ClientWrapper::ClientWrapper(const Napi::CallbackInfo& info)
         }
         
         if (config.Has("username") && config.Get("username").IsString()) {
-            std::string username = config.Get("username").As<Napi::String>().Utf8Value();
+            username = config.Get("username").As<Napi::String>().Utf8Value();
             native_config.username = username.c_str();
         }
         
         if (config.Has("password") && config.Get("password").IsString()) {
-            std::string password = config.Get("password").As<Napi::String>().Utf8Value();
+            password = config.Get("password").As<Napi::String>().Utf8Value();
             native_config.password = password.c_str();
         }
         
-        anidb_result_t result = anidb_client_create_with_config(&native_config, &handle_);
-        CheckResult(env, result);
+        if (config.Has("ioMode") && config.Get("ioMode").IsNumber()) {
+            uint32_t io_mode = config.Get("ioMode").As<Napi::Number>().Uint32Value();
+            if (io_mode > ANIDB_IO_MODE_IO_URING) {
+                Napi::RangeError::New(env, "Invalid ioMode").ThrowAsJavaScriptException();
+                return;
+            }
+            native_config.io_mode = static_cast<anidb_io_mode_t>(io_mode);
+        }
+        
+        if (config.Has("autoTune") && config.Get("autoTune").IsBoolean()) {
+            native_config.auto_tune = config.Get("autoTune").As<Napi::Boolean>().Value() ? 1 : 0;
+        }
+        
+        if (config.Has("server") && config.Get("server").IsString()) {
+            server = config.Get("server").As<Napi::String>().Utf8Value();
+            native_config.server = server.c_str();
+        }
+        
+        if (config.Has("requestRate") && config.Get("requestRate").IsNumber()) {
+            native_config.request_rate = config.Get("requestRate").As<Napi::Number>().DoubleValue();
+        }
+        
+        if (config.Has("requestTimeoutMs") && config.Get("requestTimeoutMs").IsNumber()) {
+            native_config.request_timeout_ms = config.Get("requestTimeoutMs").As<Napi::Number>().Uint32Value();
+        }
+        
+        if (config.Has("hashCache") && config.Get("hashCache").IsBoolean()) {
+            native_config.enable_hash_cache = config.Get("hashCache").As<Napi::Boolean>().Value() ? 1 : 0;
+        }
+        
+        auto client = anidb::Client::create(native_config);
+        CheckResult(env, client.code());
+        client_ = std::move(client.value());
     } else {
         Napi::TypeError::New(env, "Invalid arguments").ThrowAsJavaScriptException();
     }
+    
+    if (client_) {
+        AttachEventRing(env);
+    }
+}
+
+void ClientWrapper::AttachEventRing(Napi::Env env) {
+    // Attached before anything runs, so no event precedes the ring. The
+    // queue of anidb_event_poll is never drained here and stays off.
+    size_t ring_size = anidb_event_ring_size(kEventRingCapacity);
+    event_ring_.reset(new uint64_t[ring_size / sizeof(uint64_t)]);
+    anidb_result_t result = anidb_event_ring_attach(
+        client_.get(), event_ring_.get(), ring_size, ANIDB_EVENT_MASK_ALL, nullptr);
+    if (result == ANIDB_SUCCESS) {
+        result = anidb_event_set_mask(client_.get(), 0);
+    }
+    CheckResult(env, result);
 }
 
 ClientWrapper::~ClientWrapper() {
-    if (handle_) {
+    if (client_) {
         // Disconnect events if connected
         if (event_connected_) {
-            anidb_event_disconnect(handle_);
+            anidb_event_disconnect(client_.get());
+            event_bridge_->Close();
+            event_bridge_ = nullptr;
         }
         
         // Unregister all callbacks
         {
             std::lock_guard<std::mutex> lock(callback_mutex_);
             for (const auto& pair : callbacks_) {
-                anidb_unregister_callback(handle_, pair.first);
+                anidb_unregister_callback(client_.get(), pair.first);
             }
             callbacks_.clear();
         }
         
         // Destroy the client
-        anidb_client_destroy(handle_);
-        handle_ = nullptr;
+        client_.reset();
     }
 }
 
@@ -130,50 +204,21 @@ Napi::Value ClientWrapper::ProcessFile(const Napi::CallbackInfo& info) {
     }
     
     std::string file_path = info[0].As<Napi::String>().Utf8Value();
-    Napi::Object options = info[1].As<Napi::Object>();
     
-    // Parse options
-    anidb_process_options_t process_options = {};
-    std::vector<anidb_hash_algorithm_t> algorithms;
-    
-    if (options.Has("algorithms") && options.Get("algorithms").IsArray()) {
-        Napi::Array algo_array = options.Get("algorithms").As<Napi::Array>();
-        for (uint32_t i = 0; i < algo_array.Length(); i++) {
-            if (algo_array.Get(i).IsNumber()) {
-                algorithms.push_back(static_cast<anidb_hash_algorithm_t>(
-                    algo_array.Get(i).As<Napi::Number>().Int32Value()
-                ));
-            }
-        }
-    }
-    
-    if (algorithms.empty()) {
-        algorithms.push_back(ANIDB_HASH_ED2K); // Default to ED2K
+    anidb::ProcessOptions options;
+    if (!Utils::ParseProcessOptions(env, info[1].As<Napi::Object>(), &options)) {
+        return env.Null();
     }
     
-    process_options.algorithms = algorithms.data();
-    process_options.algorithm_count = algorithms.size();
-    process_options.enable_progress = options.Has("enableProgress") && 
-        options.Get("enableProgress").As<Napi::Boolean>().Value() ? 1 : 0;
-    process_options.verify_existing = options.Has("verifyExisting") && 
-        options.Get("verifyExisting").As<Napi::Boolean>().Value() ? 1 : 0;
-    
     // Process file synchronously
-    anidb_file_result_t* result = nullptr;
-    anidb_result_t status = anidb_process_file(handle_, file_path.c_str(), &process_options, &result);
-    
-    if (status != ANIDB_SUCCESS) {
-        CheckResult(env, status);
+    auto result = client_.process_file(file_path, options);
+    if (!result) {
+        CheckResult(env, result.code());
         return env.Null();
     }
     
-    // Convert result to JavaScript object
-    Napi::Object js_result = ConvertFileResult(env, result);
-    
-    // Free the native result
-    anidb_free_file_result(result);
-    
-    return js_result;
+    // The result is read in place and freed when it goes out of scope
+    return ConvertFileResult(env, result->view());
 }
 
 Napi::Value ClientWrapper::ProcessFileAsync(const Napi::CallbackInfo& info) {
@@ -185,16 +230,15 @@ Napi::Value ClientWrapper::ProcessFileAsync(const Napi::CallbackInfo& info) {
     }
     
     std::string file_path = info[0].As<Napi::String>().Utf8Value();
-    Napi::Object options = info[1].As<Napi::Object>();
-    
-    // Create promise
-    auto deferred = Napi::Promise::Deferred::New(env);
     
-    // Create async worker
-    auto* worker = new ProcessFileWorker(env, handle_, file_path, options, deferred);
-    worker->Queue();
+    anidb::ProcessOptions options;
+    if (!Utils::ParseProcessOptions(env, info[1].As<Napi::Object>(), &options)) {
+        return env.Null();
+    }
     
-    return deferred.Promise();
+    // Runs on the core's runtime; does not occupy a libuv threadpool thread.
+    // Returns { promise, progress(), cancel() }
+    return FileOperation::Start(env, client_, file_path, options);
 }
 
 Napi::Value ClientWrapper::ProcessBatch(const Napi::CallbackInfo& info) {
@@ -205,68 +249,22 @@ Napi::Value ClientWrapper::ProcessBatch(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    Napi::Array file_array = info[0].As<Napi::Array>();
-    Napi::Object options = info[1].As<Napi::Object>();
-    
-    // Convert file paths
-    std::vector<std::string> file_paths;
-    std::vector<const char*> file_path_ptrs;
-    
-    for (uint32_t i = 0; i < file_array.Length(); i++) {
-        if (file_array.Get(i).IsString()) {
-            file_paths.push_back(file_array.Get(i).As<Napi::String>().Utf8Value());
-        }
-    }
-    
-    for (const auto& path : file_paths) {
-        file_path_ptrs.push_back(path.c_str());
-    }
-    
-    // Parse batch options
-    anidb_batch_options_t batch_options = {};
-    std::vector<anidb_hash_algorithm_t> algorithms;
-    
-    if (options.Has("algorithms") && options.Get("algorithms").IsArray()) {
-        Napi::Array algo_array = options.Get("algorithms").As<Napi::Array>();
-        for (uint32_t i = 0; i < algo_array.Length(); i++) {
-            if (algo_array.Get(i).IsNumber()) {
-                algorithms.push_back(static_cast<anidb_hash_algorithm_t>(
-                    algo_array.Get(i).As<Napi::Number>().Int32Value()
-                ));
-            }
-        }
-    }
-    
-    if (algorithms.empty()) {
-        algorithms.push_back(ANIDB_HASH_ED2K);
+    // Paths are encoded into one buffer, options parsed into inline storage
+    anidb::PathList file_paths;
+    anidb::BatchOptions options;
+    if (!Utils::ReadPaths(env, info[0].As<Napi::Array>(), &file_paths) ||
+        !Utils::ParseBatchOptions(env, info[1].As<Napi::Object>(), &options)) {
+        return env.Null();
     }
     
-    batch_options.algorithms = algorithms.data();
-    batch_options.algorithm_count = algorithms.size();
-    batch_options.max_concurrent = options.Has("maxConcurrent") ? 
-        options.Get("maxConcurrent").As<Napi::Number>().Uint32Value() : 4;
-    batch_options.continue_on_error = options.Has("continueOnError") && 
-        options.Get("continueOnError").As<Napi::Boolean>().Value() ? 1 : 0;
-    batch_options.skip_existing = options.Has("skipExisting") && 
-        options.Get("skipExisting").As<Napi::Boolean>().Value() ? 1 : 0;
-    
     // Process batch synchronously
-    anidb_batch_result_t* result = nullptr;
-    anidb_result_t status = anidb_process_batch(handle_, file_path_ptrs.data(), 
-        file_path_ptrs.size(), &batch_options, &result);
-    
-    if (status != ANIDB_SUCCESS) {
-        CheckResult(env, status);
+    auto result = client_.process_batch(file_paths, options);
+    if (!result) {
+        CheckResult(env, result.code());
         return env.Null();
     }
     
-    // Convert result to JavaScript object
-    Napi::Object js_result = ConvertBatchResult(env, result);
-    
-    // Free the native result
-    anidb_free_batch_result(result);
-    
-    return js_result;
+    return ConvertBatchResult(env, result->get());
 }
 
 Napi::Value ClientWrapper::ProcessBatchAsync(const Napi::CallbackInfo& info) {
@@ -277,27 +275,70 @@ Napi::Value ClientWrapper::ProcessBatchAsync(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    Napi::Array file_array = info[0].As<Napi::Array>();
     Napi::Object options = info[1].As<Napi::Object>();
     
-    // Convert file paths
-    std::vector<std::string> file_paths;
-    for (uint32_t i = 0; i < file_array.Length(); i++) {
-        if (file_array.Get(i).IsString()) {
-            file_paths.push_back(file_array.Get(i).As<Napi::String>().Utf8Value());
-        }
+    anidb::PathList file_paths;
+    anidb::BatchOptions batch_options;
+    if (!Utils::ReadPaths(env, info[0].As<Napi::Array>(), &file_paths) ||
+        !Utils::ParseBatchOptions(env, options, &batch_options)) {
+        return env.Null();
     }
+    bool binary = options.Has("binary") && options.Get("binary").ToBoolean().Value();
     
     // Create promise
     auto deferred = Napi::Promise::Deferred::New(env);
     
-    // Create async worker
-    auto* worker = new ProcessBatchWorker(env, handle_, file_paths, options, deferred);
+    // The worker takes the path list; nothing is copied again
+    auto* worker = new ProcessBatchWorker(env, client_, std::move(file_paths),
+        batch_options, binary, deferred);
     worker->Queue();
     
     return deferred.Promise();
 }
 
+Napi::Value ClientWrapper::ProcessBatchStream(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 4 || !info[0].IsArray() || !info[1].IsObject() ||
+        !info[2].IsFunction() || !info[3].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (filePaths: string[], options: object, onResult: function, onEnd: function)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    // Every element must be a path so result indices match the input
+    anidb::PathList file_paths;
+    anidb::BatchOptions options;
+    if (!Utils::ReadPaths(env, info[0].As<Napi::Array>(), &file_paths) ||
+        !Utils::ParseBatchOptions(env, info[1].As<Napi::Object>(), &options)) {
+        return env.Null();
+    }
+    
+    // Results are delivered as files finish; returns a cancel function
+    return BatchStream::Start(env, client_, file_paths, options,
+        info[2].As<Napi::Function>(), info[3].As<Napi::Function>());
+}
+
+Napi::Value ClientWrapper::ScanAndProcess(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 5 || !info[0].IsString() || !info[1].IsObject() || !info[2].IsObject() ||
+        !info[3].IsFunction() || !info[4].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (root: string, scanOptions: object, options: object, onResult: function, onEnd: function)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    anidb::ScanOptions scan_options;
+    anidb::BatchOptions options;
+    if (!Utils::ParseScanOptions(env, info[1].As<Napi::Object>(), &scan_options) ||
+        !Utils::ParseBatchOptions(env, info[2].As<Napi::Object>(), &options)) {
+        return env.Null();
+    }
+    
+    // Discovery and hashing overlap in the core; returns a cancel function
+    return BatchStream::StartScan(env, client_, info[0].As<Napi::String>().Utf8Value(),
+        scan_options, options, info[3].As<Napi::Function>(), info[4].As<Napi::Function>());
+}
+
 Napi::Value ClientWrapper::CalculateHash(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
@@ -311,18 +352,12 @@ Napi::Value ClientWrapper::CalculateHash(const Napi::CallbackInfo& info) {
         info[1].As<Napi::Number>().Int32Value()
     );
     
-    size_t buffer_size = anidb_hash_buffer_size(algorithm);
-    std::vector<char> hash_buffer(buffer_size);
-    
-    anidb_result_t result = anidb_calculate_hash(file_path.c_str(), algorithm, 
-        hash_buffer.data(), buffer_size);
-    
-    if (result != ANIDB_SUCCESS) {
-        CheckResult(env, result);
-        return env.Null();
-    }
+    // Stream the file on a worker thread instead of the event loop
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    auto* worker = new CalculateHashWorker(env, file_path, algorithm, deferred);
+    worker->Queue();
     
-    return Napi::String::New(env, hash_buffer.data());
+    return deferred.Promise();
 }
 
 Napi::Value ClientWrapper::CalculateHashBuffer(const Napi::CallbackInfo& info) {
@@ -334,29 +369,70 @@ Napi::Value ClientWrapper::CalculateHashBuffer(const Napi::CallbackInfo& info) {
     }
     
     Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
-    anidb_hash_algorithm_t algorithm = static_cast<anidb_hash_algorithm_t>(
-        info[1].As<Napi::Number>().Int32Value()
-    );
+    anidb::AlgorithmSet algorithms;
+    if (!Utils::ParseHashAlgorithms(env, info[1], &algorithms)) {
+        return env.Null();
+    }
     
-    size_t hash_buffer_size = anidb_hash_buffer_size(algorithm);
-    std::vector<char> hash_buffer(hash_buffer_size);
+    // Hash output lives on the stack
+    auto hashes = anidb::hash_buffer(anidb::ByteSpan(buffer.Data(), buffer.Length()), algorithms);
+    if (!hashes) {
+        CheckResult(env, hashes.code());
+        return env.Null();
+    }
     
-    anidb_result_t result = anidb_calculate_hash_buffer(buffer.Data(), buffer.Length(),
-        algorithm, hash_buffer.data(), hash_buffer_size);
+    std::string_view hash = (*hashes)[0];
+    return Napi::String::New(env, hash.data(), hash.size());
+}
+
+Napi::Value ClientWrapper::CalculateHashes(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    if (result != ANIDB_SUCCESS) {
-        CheckResult(env, result);
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "Expected (data: ArrayBufferView | ArrayBuffer, algorithms: number[])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    anidb::ByteSpan data;
+    if (!Utils::GetByteView(env, info[0], &data)) {
+        Napi::TypeError::New(env, "data must be a Buffer, TypedArray, DataView or ArrayBuffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    anidb::AlgorithmSet algorithms;
+    if (!Utils::ParseHashAlgorithms(env, info[1], &algorithms)) {
+        return env.Null();
+    }
+    
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    auto* worker = new HashBufferWorker(env, info[0].As<Napi::Object>(),
+        data, algorithms, deferred);
+    worker->Queue();
+    
+    return deferred.Promise();
+}
+
+Napi::Value ClientWrapper::CreateHasher(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected (algorithms: number[])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    anidb::AlgorithmSet algorithms;
+    if (!Utils::ParseHashAlgorithms(env, info[0], &algorithms)) {
         return env.Null();
     }
     
-    return Napi::String::New(env, hash_buffer.data());
+    return Hasher::Create(env, algorithms);
 }
 
 Napi::Value ClientWrapper::GetLastError(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     char error_buffer[1024];
-    anidb_result_t result = anidb_client_get_last_error(handle_, error_buffer, sizeof(error_buffer));
+    anidb_result_t result = anidb_client_get_last_error(client_.get(), error_buffer, sizeof(error_buffer));
     
     if (result != ANIDB_SUCCESS) {
         return Napi::String::New(env, "Failed to get last error");
@@ -368,8 +444,7 @@ Napi::Value ClientWrapper::GetLastError(const Napi::CallbackInfo& info) {
 Napi::Value ClientWrapper::CacheClear(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    anidb_result_t result = anidb_cache_clear(handle_);
-    CheckResult(env, result);
+    CheckResult(env, client_.cache_clear());
     
     return env.Undefined();
 }
@@ -380,7 +455,7 @@ Napi::Value ClientWrapper::CacheGetStats(const Napi::CallbackInfo& info) {
     size_t total_entries = 0;
     uint64_t cache_size_bytes = 0;
     
-    anidb_result_t result = anidb_cache_get_stats(handle_, &total_entries, &cache_size_bytes);
+    anidb_result_t result = anidb_cache_get_stats(client_.get(), &total_entries, &cache_size_bytes);
     CheckResult(env, result);
     
     Napi::Object stats = Napi::Object::New(env);
@@ -403,11 +478,83 @@ Napi::Value ClientWrapper::CacheCheckFile(const Napi::CallbackInfo& info) {
         info[1].As<Napi::Number>().Int32Value()
     );
     
-    int is_cached = 0;
-    anidb_result_t result = anidb_cache_check_file(handle_, file_path.c_str(), algorithm, &is_cached);
-    CheckResult(env, result);
+    auto is_cached = client_.cache_check_file(file_path, algorithm);
+    CheckResult(env, is_cached.code());
+    
+    return Napi::Boolean::New(env, is_cached.ok() && *is_cached);
+}
+
+Napi::Value ClientWrapper::CacheCheckFiles(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (filePaths: string[], algorithm: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    anidb_hash_algorithm_t algorithm = static_cast<anidb_hash_algorithm_t>(
+        info[1].As<Napi::Number>().Int32Value()
+    );
+    
+    anidb::PathList file_paths;
+    if (!Utils::ReadPaths(env, info[0].As<Napi::Array>(), &file_paths)) {
+        return env.Null();
+    }
+    
+    // One FFI call for the whole list
+    std::vector<int> is_cached(file_paths.size(), 0);
+    CheckResult(env, client_.cache_check_files(file_paths, algorithm, is_cached.data()));
+    if (env.IsExceptionPending()) {
+        return env.Null();
+    }
+    
+    Napi::Array cached = Napi::Array::New(env, is_cached.size());
+    for (size_t i = 0; i < is_cached.size(); i++) {
+        cached.Set(static_cast<uint32_t>(i), Napi::Boolean::New(env, is_cached[i] != 0));
+    }
+    
+    return cached;
+}
+
+Napi::Value ClientWrapper::CachePrefilterFiles(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected (filePaths: string[])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    anidb::PathList file_paths;
+    if (!Utils::ReadPaths(env, info[0].As<Napi::Array>(), &file_paths)) {
+        return env.Null();
+    }
+    
+    std::vector<anidb_prefilter_result_t> results(file_paths.size());
+    CheckResult(env, client_.cache_prefilter_files(file_paths, results.data()));
+    if (env.IsExceptionPending()) {
+        return env.Null();
+    }
+    
+    Napi::Array converted = Napi::Array::New(env, results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        const anidb_prefilter_result_t& result = results[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("status", Napi::Number::New(env, result.status));
+        obj.Set("fileSize", Napi::Number::New(env, static_cast<double>(result.file_size)));
+        // 64-bit fingerprints do not fit a JS number, so they travel as hex
+        if (result.fingerprint != 0) {
+            char hex[17];
+            std::snprintf(hex, sizeof(hex), "%016llx",
+                          static_cast<unsigned long long>(result.fingerprint));
+            obj.Set("fingerprint", Napi::String::New(env, hex));
+        } else {
+            obj.Set("fingerprint", env.Null());
+        }
+        obj.Set("bytesRead", Napi::Number::New(env, static_cast<double>(result.bytes_read)));
+        converted.Set(static_cast<uint32_t>(i), obj);
+    }
     
-    return Napi::Boolean::New(env, is_cached != 0);
+    return converted;
 }
 
 Napi::Value ClientWrapper::IdentifyFile(const Napi::CallbackInfo& info) {
@@ -421,18 +568,85 @@ Napi::Value ClientWrapper::IdentifyFile(const Napi::CallbackInfo& info) {
     std::string ed2k_hash = info[0].As<Napi::String>().Utf8Value();
     uint64_t file_size = info[1].As<Napi::Number>().Int64Value();
     
-    anidb_anime_info_t* anime_info = nullptr;
-    anidb_result_t result = anidb_identify_file(handle_, ed2k_hash.c_str(), file_size, &anime_info);
+    // Unknown files go to AniDB, so wait for the answer off the event loop
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    auto* worker = new IdentifyFileWorker(env, client_, ed2k_hash, file_size, deferred);
+    worker->Queue();
+    
+    return deferred.Promise();
+}
+
+Napi::Value ClientWrapper::IdentifyBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 4 || !info[0].IsArray() || !info[1].IsArray() ||
+        !info[2].IsFunction() || !info[3].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (ed2kHashes: string[], fileSizes: number[], onResult: function, onEnd: function)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Array hash_array = info[0].As<Napi::Array>();
+    Napi::Array size_array = info[1].As<Napi::Array>();
+    if (hash_array.Length() != size_array.Length()) {
+        Napi::TypeError::New(env, "ed2kHashes and fileSizes must have the same length").ThrowAsJavaScriptException();
+        return env.Null();
+    }
     
+    std::vector<std::string> ed2k_hashes;
+    std::vector<uint64_t> file_sizes;
+    for (uint32_t i = 0; i < hash_array.Length(); i++) {
+        if (!hash_array.Get(i).IsString() || !size_array.Get(i).IsNumber()) {
+            Napi::TypeError::New(env, "Expected string hashes and numeric sizes").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        ed2k_hashes.push_back(hash_array.Get(i).As<Napi::String>().Utf8Value());
+        file_sizes.push_back(size_array.Get(i).As<Napi::Number>().Int64Value());
+    }
+    
+    // Results are delivered as AniDB answers; returns a cancel function
+    return IdentifyBatchWorker::Start(env, client_.get(), std::move(ed2k_hashes),
+        std::move(file_sizes), info[2].As<Napi::Function>(), info[3].As<Napi::Function>());
+}
+
+Napi::Value ClientWrapper::IdentifyIndexLoad(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (indexPath: string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string index_path = info[0].As<Napi::String>().Utf8Value();
+    size_t entry_count = 0;
+    
+    // The index is mapped, not read, so this is cheap for any size
+    anidb_result_t result = anidb_identify_index_load(client_.get(), index_path.c_str(), &entry_count);
     if (result != ANIDB_SUCCESS) {
-        CheckResult(env, result);
+        Utils::CreateError(env, result).ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    Napi::Object js_info = ConvertAnimeInfo(env, anime_info);
-    anidb_free_anime_info(anime_info);
+    return Napi::Number::New(env, static_cast<double>(entry_count));
+}
+
+Napi::Value ClientWrapper::IdentifyIndexExport(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    return js_info;
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected (indexPath: string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string index_path = info[0].As<Napi::String>().Utf8Value();
+    size_t entry_count = 0;
+    
+    anidb_result_t result = anidb_identify_index_export(client_.get(), index_path.c_str(), &entry_count);
+    if (result != ANIDB_SUCCESS) {
+        Utils::CreateError(env, result).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    return Napi::Number::New(env, static_cast<double>(entry_count));
 }
 
 // Utility methods implementation
@@ -443,27 +657,42 @@ void ClientWrapper::CheckResult(Napi::Env env, anidb_result_t result) {
     }
 }
 
-Napi::Object ClientWrapper::ConvertFileResult(Napi::Env env, const anidb_file_result_t* result) {
+Napi::Object ClientWrapper::ConvertFileResult(Napi::Env env, anidb::FileResultView result) {
     Napi::Object obj = Napi::Object::New(env);
     
-    obj.Set("filePath", Napi::String::New(env, result->file_path));
-    obj.Set("fileSize", Napi::Number::New(env, result->file_size));
-    obj.Set("status", Napi::Number::New(env, result->status));
-    obj.Set("processingTimeMs", Napi::Number::New(env, result->processing_time_ms));
+    // Strings sit in the result block with known lengths
+    std::string_view path = result.path();
+    obj.Set("filePath", Napi::String::New(env, path.data(), path.size()));
+    obj.Set("fileSize", Napi::Number::New(env, result.size()));
+    obj.Set("status", Napi::Number::New(env, result.status()));
+    obj.Set("processingTimeMs", Napi::Number::New(env, result.processing_time_ms()));
     
-    if (result->error_message) {
-        obj.Set("error", Napi::String::New(env, result->error_message));
+    if (result.has_error()) {
+        std::string_view error = result.error();
+        obj.Set("error", Napi::String::New(env, error.data(), error.size()));
     }
     
     // Convert hashes
     Napi::Object hashes = Napi::Object::New(env);
-    for (size_t i = 0; i < result->hash_count; i++) {
-        const anidb_hash_result_t* hash = &result->hashes[i];
-        const char* algo_name = anidb_hash_algorithm_name(hash->algorithm);
-        hashes.Set(algo_name, Napi::String::New(env, hash->hash_value));
+    Napi::Object hash_ms = Napi::Object::New(env);
+    for (anidb::HashView hash : result.hashes()) {
+        const char* algo_name = anidb_hash_algorithm_name(hash.algorithm());
+        std::string_view value = hash.value();
+        hashes.Set(algo_name, Napi::String::New(env, value.data(), value.size()));
+        hash_ms.Set(algo_name, Napi::Number::New(env, hash.time_us() / 1000.0));
     }
     obj.Set("hashes", hashes);
     
+    const anidb_stage_timings_t& stages = result.timings();
+    Napi::Object timings = Napi::Object::New(env);
+    timings.Set("openMs", Napi::Number::New(env, stages.open_us / 1000.0));
+    timings.Set("readMs", Napi::Number::New(env, stages.read_us / 1000.0));
+    timings.Set("poolWaitMs", Napi::Number::New(env, stages.pool_wait_us / 1000.0));
+    timings.Set("hashMs", Napi::Number::New(env, stages.hash_us / 1000.0));
+    timings.Set("cacheLookupMs", Napi::Number::New(env, stages.cache_lookup_us / 1000.0));
+    timings.Set("hashMsByAlgorithm", hash_ms);
+    obj.Set("timings", timings);
+    
     return obj;
 }
 
@@ -478,7 +707,7 @@ Napi::Object ClientWrapper::ConvertBatchResult(Napi::Env env, const anidb_batch_
     // Convert individual results
     Napi::Array results = Napi::Array::New(env, result->total_files);
     for (size_t i = 0; i < result->total_files; i++) {
-        results.Set(i, ConvertFileResult(env, &result->results[i]));
+        results.Set(i, ConvertFileResult(env, result->results + i));
     }
     obj.Set("results", results);
     
@@ -560,7 +789,7 @@ Napi::Value ClientWrapper::RegisterCallback(const Napi::CallbackInfo& info) {
             break;
     }
     
-    uint64_t callback_id = anidb_register_callback(handle_, type, callback_ptr, callbackData.get());
+    uint64_t callback_id = anidb_register_callback(client_.get(), type, callback_ptr, callbackData.get());
     
     if (callback_id == 0) {
         Napi::Error::New(env, "Failed to register callback").ThrowAsJavaScriptException();
@@ -587,7 +816,7 @@ Napi::Value ClientWrapper::UnregisterCallback(const Napi::CallbackInfo& info) {
     uint64_t callback_id = info[0].As<Napi::Number>().Int64Value();
     
     // Unregister from native
-    anidb_result_t result = anidb_unregister_callback(handle_, callback_id);
+    anidb_result_t result = anidb_unregister_callback(client_.get(), callback_id);
     CheckResult(env, result);
     
     // Remove from our map
@@ -613,24 +842,34 @@ Napi::Value ClientWrapper::ConnectEvents(const Napi::CallbackInfo& info) {
         return env.Null();
     }
     
-    // Disconnect existing events
+    size_t max_pending = EventBridge::kDefaultMaxPending;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("maxPending") && options.Get("maxPending").IsNumber()) {
+            max_pending = options.Get("maxPending").As<Napi::Number>().Uint32Value();
+        }
+    }
+    
+    // Disconnect existing events; the event thread is joined before the
+    // old bridge is closed
     if (event_connected_) {
-        anidb_event_disconnect(handle_);
+        anidb_event_disconnect(client_.get());
+        event_bridge_->Close();
+        event_bridge_ = nullptr;
         event_connected_ = false;
     }
     
-    // Create thread-safe function for events
-    event_callback_ = Napi::ThreadSafeFunction::New(
-        env,
-        info[0].As<Napi::Function>(),
-        "EventCallback",
-        0,
-        1
-    );
+    // Events reach JS in one array per event loop turn
+    event_bridge_ = EventBridge::Create(env, info[0].As<Napi::Function>(), max_pending);
     
     // Connect to native events
-    anidb_result_t result = anidb_event_connect(handle_, &ClientWrapper::EventCallbackHandler, this);
-    CheckResult(env, result);
+    anidb_result_t result = anidb_event_connect(client_.get(), &ClientWrapper::EventCallbackHandler, this);
+    if (result != ANIDB_SUCCESS) {
+        event_bridge_->Close();
+        event_bridge_ = nullptr;
+        CheckResult(env, result);
+        return env.Null();
+    }
     
     event_connected_ = true;
     return env.Undefined();
@@ -640,27 +879,107 @@ Napi::Value ClientWrapper::DisconnectEvents(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     if (event_connected_) {
-        anidb_result_t result = anidb_event_disconnect(handle_);
+        anidb_result_t result = anidb_event_disconnect(client_.get());
         CheckResult(env, result);
+        event_bridge_->Close();
+        event_bridge_ = nullptr;
         event_connected_ = false;
     }
     
     return env.Undefined();
 }
 
+Napi::Value ClientWrapper::GetEventStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    EventBridge::Stats stats = event_bridge_ ? event_bridge_->GetStats() : EventBridge::Stats{0, 0, 0};
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("delivered", Napi::Number::New(env, static_cast<double>(stats.delivered)));
+    obj.Set("coalesced", Napi::Number::New(env, static_cast<double>(stats.coalesced)));
+    obj.Set("dropped", Napi::Number::New(env, static_cast<double>(stats.dropped)));
+    return obj;
+}
+
+static Napi::Object ConvertHistogram(Napi::Env env, const anidb_histogram_t& histogram) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("count", Napi::Number::New(env, static_cast<double>(histogram.count)));
+    obj.Set("sumUs", Napi::Number::New(env, static_cast<double>(histogram.sum_us)));
+    Napi::Array buckets = Napi::Array::New(env, ANIDB_HISTOGRAM_BUCKETS);
+    for (uint32_t i = 0; i < ANIDB_HISTOGRAM_BUCKETS; i++) {
+        buckets.Set(i, Napi::Number::New(env, static_cast<double>(histogram.buckets[i])));
+    }
+    obj.Set("buckets", buckets);
+    return obj;
+}
+
+Napi::Value ClientWrapper::GetMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    auto snapshot = client_.metrics();
+    CheckResult(env, snapshot.code());
+    const anidb_metrics_t& metrics = *snapshot;
+    
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("filesProcessed", Napi::Number::New(env, static_cast<double>(metrics.files_processed)));
+    obj.Set("filesFailed", Napi::Number::New(env, static_cast<double>(metrics.files_failed)));
+    obj.Set("bytesRead", Napi::Number::New(env, static_cast<double>(metrics.bytes_read)));
+    obj.Set("cacheHits", Napi::Number::New(env, static_cast<double>(metrics.cache_hits)));
+    obj.Set("cacheMisses", Napi::Number::New(env, static_cast<double>(metrics.cache_misses)));
+    obj.Set("cacheHitRatio", Napi::Number::New(env, metrics.cache_hit_ratio));
+    obj.Set("filesInFlight", Napi::Number::New(env, static_cast<double>(metrics.files_in_flight)));
+    obj.Set("filesQueued", Napi::Number::New(env, static_cast<double>(metrics.files_queued)));
+    obj.Set("eventsQueued", Napi::Number::New(env, static_cast<double>(metrics.events_queued)));
+    obj.Set("hashSlotsBusy", Napi::Number::New(env, static_cast<double>(metrics.hash_slots_busy)));
+    obj.Set("hashSlotsTotal", Napi::Number::New(env, static_cast<double>(metrics.hash_slots_total)));
+    obj.Set("networkRequestsWaiting",
+        Napi::Number::New(env, static_cast<double>(metrics.network_requests_waiting)));
+    obj.Set("rateLimitWaitMs", Napi::Number::New(env, metrics.rate_limit_wait_us / 1000.0));
+    obj.Set("networkRetries", Napi::Number::New(env, static_cast<double>(metrics.network_retries)));
+    obj.Set("networkTimeouts", Napi::Number::New(env, static_cast<double>(metrics.network_timeouts)));
+    obj.Set("fileLatency", ConvertHistogram(env, metrics.file_latency));
+    obj.Set("openLatency", ConvertHistogram(env, metrics.open_latency));
+    obj.Set("readLatency", ConvertHistogram(env, metrics.read_latency));
+    obj.Set("poolWait", ConvertHistogram(env, metrics.pool_wait));
+    obj.Set("hashLatency", ConvertHistogram(env, metrics.hash_latency));
+    obj.Set("cacheLookupLatency", ConvertHistogram(env, metrics.cache_lookup_latency));
+    obj.Set("networkLatency", ConvertHistogram(env, metrics.network_latency));
+    
+    Napi::Object filesRead = Napi::Object::New(env);
+    filesRead.Set("buffered", Napi::Number::New(env, static_cast<double>(metrics.files_read_buffered)));
+    filesRead.Set("mmap", Napi::Number::New(env, static_cast<double>(metrics.files_read_mmap)));
+    filesRead.Set("direct", Napi::Number::New(env, static_cast<double>(metrics.files_read_direct)));
+    filesRead.Set("ioUring", Napi::Number::New(env, static_cast<double>(metrics.files_read_io_uring)));
+    obj.Set("filesRead", filesRead);
+    
+    Napi::Object tuning = Napi::Object::New(env);
+    tuning.Set("chunkSize", Napi::Number::New(env, static_cast<double>(metrics.chunk_size)));
+    tuning.Set("hashQueueDepth", Napi::Number::New(env, static_cast<double>(metrics.hash_queue_depth)));
+    tuning.Set("readersPerDevice", Napi::Number::New(env, static_cast<double>(metrics.readers_per_device)));
+    obj.Set("tuning", tuning);
+    return obj;
+}
+
 Napi::Value ClientWrapper::PollEvents(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    const size_t max_events = 100;
-    std::vector<anidb_event_t> events(max_events);
-    size_t event_count = 0;
+    uint32_t mask = ANIDB_EVENT_MASK_ALL;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        mask = info[0].As<Napi::Number>().Uint32Value();
+    }
     
-    anidb_result_t result = anidb_event_poll(handle_, events.data(), max_events, &event_count);
+    size_t event_count = 0;
+    anidb_result_t result = anidb_event_ring_poll(
+        event_ring_.get(), poll_events_, kPollBatchSize, &event_count);
     CheckResult(env, result);
     
-    Napi::Array js_events = Napi::Array::New(env, event_count);
+    // The ring takes every type from creation on; types outside the mask
+    // are consumed without being converted
+    Napi::Array js_events = Napi::Array::New(env);
+    uint32_t index = 0;
     for (size_t i = 0; i < event_count; i++) {
-        js_events.Set(i, ConvertEvent(env, &events[i]));
+        if (mask & ANIDB_EVENT_MASK(poll_events_[i].type)) {
+            js_events.Set(index++, ConvertEvent(env, &poll_events_[i]));
+        }
     }
     
     return js_events;
@@ -738,27 +1057,40 @@ Napi::Object ClientWrapper::ConvertEvent(Napi::Env env, const anidb_event_t* eve
 }
 
 // Static callback handlers
-void ClientWrapper::ProgressCallbackHandler(float percentage, uint64_t bytes_processed,
+void ClientWrapper::ProgressCallbackHandler(float /*percentage*/, uint64_t bytes_processed,
                                           uint64_t total_bytes, void* user_data) {
     auto* callbackData = static_cast<CallbackData*>(user_data);
     if (!callbackData || !callbackData->tsfn) return;
     
-    auto callback = [](Napi::Env env, Napi::Function jsCallback, float* data) {
+    // Publish the exact counters, then schedule a JS call only if none is
+    // pending. Ticks arriving while the event loop is busy are coalesced
+    // into that call, so the hashing thread never waits on JS and nothing
+    // is allocated per tick.
+    callbackData->bytes_processed.store(bytes_processed, std::memory_order_relaxed);
+    callbackData->total_bytes.store(total_bytes, std::memory_order_relaxed);
+    if (callbackData->progress_pending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    
+    auto callback = [](Napi::Env env, Napi::Function jsCallback, CallbackData* data) {
+        // Clear the flag first so a tick racing with this call schedules
+        // another one; the acquire makes its counters visible below
+        data->progress_pending.exchange(false, std::memory_order_acq_rel);
+        uint64_t processed = data->bytes_processed.load(std::memory_order_relaxed);
+        uint64_t total = data->total_bytes.load(std::memory_order_relaxed);
+        
         Napi::Object progress = Napi::Object::New(env);
-        progress.Set("percentage", Napi::Number::New(env, data[0]));
-        progress.Set("bytesProcessed", Napi::Number::New(env, data[1]));
-        progress.Set("totalBytes", Napi::Number::New(env, data[2]));
+        progress.Set("percentage", Napi::Number::New(env,
+            total > 0 ? static_cast<double>(processed) / static_cast<double>(total) * 100.0 : 0.0));
+        progress.Set("bytesProcessed", Napi::Number::New(env, static_cast<double>(processed)));
+        progress.Set("totalBytes", Napi::Number::New(env, static_cast<double>(total)));
         
         jsCallback.Call({progress});
-        delete[] data;
     };
     
-    float* data = new float[3];
-    data[0] = percentage;
-    data[1] = static_cast<float>(bytes_processed);
-    data[2] = static_cast<float>(total_bytes);
-    
-    callbackData->tsfn.BlockingCall(data, callback);
+    if (callbackData->tsfn.NonBlockingCall(callbackData, callback) != napi_ok) {
+        callbackData->progress_pending.store(false, std::memory_order_release);
+    }
 }
 
 void ClientWrapper::ErrorCallbackHandler(anidb_result_t error_code, const char* error_message,
@@ -808,16 +1140,8 @@ void ClientWrapper::CompletionCallbackHandler(anidb_result_t result, void* user_
 
 void ClientWrapper::EventCallbackHandler(const anidb_event_t* event, void* user_data) {
     auto* wrapper = static_cast<ClientWrapper*>(user_data);
-    if (!wrapper || !wrapper->event_callback_) return;
-    
-    // Copy event data for thread safety
-    auto* eventCopy = new anidb_event_t(*event);
-    
-    auto callback = [wrapper](Napi::Env env, Napi::Function jsCallback, anidb_event_t* data) {
-        Napi::Object jsEvent = ClientWrapper::ConvertEvent(env, data);
-        jsCallback.Call({jsEvent});
-        delete data;
-    };
+    if (!wrapper || !wrapper->event_bridge_) return;
     
-    wrapper->event_callback_.BlockingCall(eventCopy, callback);
+    // Copies the event and returns without waiting for JS
+    wrapper->event_bridge_->Push(event);
 }
\ No newline at end of file
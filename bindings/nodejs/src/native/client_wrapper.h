@@ -2,7 +2,9 @@
 #define CLIENT_WRAPPER_H
 
 #include <napi.h>
-#include "../../../anidb_client_core/include/anidb.h"
+#include "../../../anidb_client_core/include/anidb.hpp"
+#include "event_bridge.h"
+#include <atomic>
 #include <memory>
 #include <map>
 #include <mutex>
@@ -12,42 +14,68 @@ public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     ClientWrapper(const Napi::CallbackInfo& info);
     ~ClientWrapper();
+    
+    // Result conversion, shared with workers and native operations
+    static Napi::Object ConvertFileResult(Napi::Env env, anidb::FileResultView result);
+    static Napi::Object ConvertBatchResult(Napi::Env env, const anidb_batch_result_t* result);
+    static Napi::Object ConvertAnimeInfo(Napi::Env env, const anidb_anime_info_t* info);
+    static Napi::Object ConvertEvent(Napi::Env env, const anidb_event_t* event);
 
 private:
     static Napi::FunctionReference constructor;
     
-    // Native handle
-    anidb_client_handle_t handle_;
+    // Native client, destroyed after the callbacks below are unregistered
+    anidb::Client client_;
     
     // Callback management
     struct CallbackData {
         Napi::ThreadSafeFunction tsfn;
         void* user_data;
+        
+        // Latest progress, folded into a single pending JS call
+        std::atomic<uint64_t> bytes_processed{0};
+        std::atomic<uint64_t> total_bytes{0};
+        std::atomic<bool> progress_pending{false};
     };
     
     std::map<uint64_t, std::unique_ptr<CallbackData>> callbacks_;
     std::mutex callback_mutex_;
     
-    // Event callback
-    Napi::ThreadSafeFunction event_callback_;
+    // Event callback, batched through the bridge
+    EventBridge* event_bridge_;
     bool event_connected_;
     
+    // Event ring drained by pollEvents, attached when the client is created
+    static constexpr size_t kEventRingCapacity = 1024;
+    static constexpr size_t kPollBatchSize = 100;
+    std::unique_ptr<uint64_t[]> event_ring_;
+    anidb_event_t poll_events_[kPollBatchSize];
+    
     // Methods
     Napi::Value ProcessFile(const Napi::CallbackInfo& info);
     Napi::Value ProcessFileAsync(const Napi::CallbackInfo& info);
     Napi::Value ProcessBatch(const Napi::CallbackInfo& info);
     Napi::Value ProcessBatchAsync(const Napi::CallbackInfo& info);
+    Napi::Value ProcessBatchStream(const Napi::CallbackInfo& info);
+    Napi::Value ScanAndProcess(const Napi::CallbackInfo& info);
     Napi::Value CalculateHash(const Napi::CallbackInfo& info);
     Napi::Value CalculateHashBuffer(const Napi::CallbackInfo& info);
+    Napi::Value CalculateHashes(const Napi::CallbackInfo& info);
+    Napi::Value CreateHasher(const Napi::CallbackInfo& info);
     Napi::Value GetLastError(const Napi::CallbackInfo& info);
     
     // Cache methods
     Napi::Value CacheClear(const Napi::CallbackInfo& info);
     Napi::Value CacheGetStats(const Napi::CallbackInfo& info);
     Napi::Value CacheCheckFile(const Napi::CallbackInfo& info);
+    Napi::Value CacheCheckFiles(const Napi::CallbackInfo& info);
+    Napi::Value CachePrefilterFiles(const Napi::CallbackInfo& info);
     
     // Anime identification
     Napi::Value IdentifyFile(const Napi::CallbackInfo& info);
+    Napi::Value IdentifyBatch(const Napi::CallbackInfo& info);
+    Napi::Value IdentifyIndexLoad(const Napi::CallbackInfo& info);
+    Napi::Value IdentifyIndexExport(const Napi::CallbackInfo& info);
     
     // Callback management
     Napi::Value RegisterCallback(const Napi::CallbackInfo& info);
@@ -55,13 +83,12 @@ private:
     Napi::Value ConnectEvents(const Napi::CallbackInfo& info);
     Napi::Value DisconnectEvents(const Napi::CallbackInfo& info);
     Napi::Value PollEvents(const Napi::CallbackInfo& info);
+    Napi::Value GetEventStats(const Napi::CallbackInfo& info);
+    Napi::Value GetMetrics(const Napi::CallbackInfo& info);
     
     // Utility methods
     static void CheckResult(Napi::Env env, anidb_result_t result);
-    static Napi::Object ConvertFileResult(Napi::Env env, const anidb_file_result_t* result);
-    static Napi::Object ConvertBatchResult(Napi::Env env, const anidb_batch_result_t* result);
-    static Napi::Object ConvertAnimeInfo(Napi::Env env, const anidb_anime_info_t* info);
-    static Napi::Object ConvertEvent(Napi::Env env, const anidb_event_t* event);
+    void AttachEventRing(Napi::Env env);
     
     // Callback handlers
     static void ProgressCallbackHandler(float percentage, uint64_t bytes_processed, 
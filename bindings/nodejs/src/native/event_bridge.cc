@@ -0,0 +1,146 @@
+#include "event_bridge.h"
+#include "client_wrapper.h"
+
+EventBridge* EventBridge::Create(Napi::Env env, Napi::Function callback, size_t max_pending) {
+    auto* bridge = new EventBridge(max_pending > 0 ? max_pending : kDefaultMaxPending);
+    bridge->tsfn_ = Napi::ThreadSafeFunction::New(
+        env,
+        callback,
+        "EventBridge",
+        0,
+        1,
+        bridge,
+        [](Napi::Env, EventBridge* self) { delete self; }
+    );
+    return bridge;
+}
+
+EventBridge::EventBridge(size_t max_pending)
+    : max_pending_(max_pending), flush_scheduled_(false) {
+    merge_index_.fill(kNoIndex);
+}
+
+EventBridge::Policy EventBridge::PolicyFor(anidb_event_type_t type) {
+    switch (type) {
+        case ANIDB_EVENT_MEMORY_WARNING:
+            return Policy::Merge;
+        case ANIDB_EVENT_HASH_START:
+        case ANIDB_EVENT_CACHE_HIT:
+        case ANIDB_EVENT_CACHE_MISS:
+        case ANIDB_EVENT_NETWORK_START:
+            return Policy::Droppable;
+        default:
+            return Policy::Keep;
+    }
+}
+
+const char** EventBridge::TextField(anidb_event_t& event) {
+    switch (event.type) {
+        case ANIDB_EVENT_FILE_START:
+        case ANIDB_EVENT_FILE_COMPLETE:
+            return &event.data.file.file_path;
+        case ANIDB_EVENT_HASH_START:
+        case ANIDB_EVENT_HASH_COMPLETE:
+            return &event.data.hash.hash_value;
+        case ANIDB_EVENT_CACHE_HIT:
+        case ANIDB_EVENT_CACHE_MISS:
+            return &event.data.cache.file_path;
+        case ANIDB_EVENT_NETWORK_START:
+        case ANIDB_EVENT_NETWORK_COMPLETE:
+            return &event.data.network.endpoint;
+        default:
+            return nullptr;
+    }
+}
+
+void EventBridge::CopyEvent(const anidb_event_t* event, PendingEvent& pending) {
+    // The event and its strings are only valid during the native callback
+    pending.event = *event;
+    const char** text = TextField(pending.event);
+    pending.has_text = text && *text;
+    pending.text.assign(pending.has_text ? *text : "");
+    pending.has_context = event->context != nullptr;
+    pending.context.assign(pending.has_context ? event->context : "");
+}
+
+void EventBridge::Push(const anidb_event_t* event) {
+    Policy policy = PolicyFor(event->type);
+    size_t type = static_cast<size_t>(event->type);
+    bool mergeable = policy == Policy::Merge && type < merge_index_.size();
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        if (mergeable && merge_index_[type] != kNoIndex) {
+            CopyEvent(event, pending_[merge_index_[type]]);
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        
+        size_t limit = policy == Policy::Droppable ? max_pending_ / 2 : max_pending_;
+        if (pending_.size() >= limit) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        
+        pending_.emplace_back();
+        CopyEvent(event, pending_.back());
+        if (mergeable) {
+            merge_index_[type] = pending_.size() - 1;
+        }
+        
+        // One call per batch; later events join the pending list
+        if (flush_scheduled_) {
+            return;
+        }
+        flush_scheduled_ = true;
+    }
+    
+    auto flush = [](Napi::Env env, Napi::Function js_callback, EventBridge* bridge) {
+        bridge->Flush(env, js_callback);
+    };
+    if (tsfn_.NonBlockingCall(this, flush) != napi_ok) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flush_scheduled_ = false;
+    }
+}
+
+void EventBridge::Flush(Napi::Env env, Napi::Function callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        draining_.swap(pending_);
+        merge_index_.fill(kNoIndex);
+        flush_scheduled_ = false;
+    }
+    
+    if (draining_.empty()) {
+        return;
+    }
+    
+    Napi::Array events = Napi::Array::New(env, draining_.size());
+    for (size_t i = 0; i < draining_.size(); i++) {
+        PendingEvent& pending = draining_[i];
+        const char** text = TextField(pending.event);
+        if (text) {
+            *text = pending.has_text ? pending.text.c_str() : nullptr;
+        }
+        pending.event.context = pending.has_context ? pending.context.c_str() : nullptr;
+        events.Set(i, ClientWrapper::ConvertEvent(env, &pending.event));
+    }
+    delivered_.fetch_add(draining_.size(), std::memory_order_relaxed);
+    draining_.clear();
+    
+    callback.Call({events});
+}
+
+void EventBridge::Close() {
+    tsfn_.Release();
+}
+
+EventBridge::Stats EventBridge::GetStats() const {
+    return Stats{
+        delivered_.load(std::memory_order_relaxed),
+        coalesced_.load(std::memory_order_relaxed),
+        dropped_.load(std::memory_order_relaxed),
+    };
+}
@@ -0,0 +1,82 @@
+#ifndef EVENT_BRIDGE_H
+#define EVENT_BRIDGE_H
+
+#include <napi.h>
+#include "../../../anidb_client_core/include/anidb.h"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Batched delivery of native events to JS
+//
+// The library's event thread calls Push() for every event. Events are
+// copied, strings included, into a pending list that is handed to JS as one
+// array per event loop turn through a single NonBlockingCall, so the event
+// thread never waits for JS. When JS falls behind, memory warnings are
+// merged into the latest one and high-rate types are dropped before the
+// others; counters report both.
+class EventBridge {
+public:
+    struct Stats {
+        uint64_t delivered;
+        uint64_t coalesced;
+        uint64_t dropped;
+    };
+
+    static constexpr size_t kDefaultMaxPending = 4096;
+
+    // Create a bridge calling callback(events[]). It frees itself once
+    // Close() was called and the last queued call ran.
+    static EventBridge* Create(Napi::Env env, Napi::Function callback, size_t max_pending);
+
+    // Push an event from any thread
+    void Push(const anidb_event_t* event);
+
+    // Stop delivering; no Push() may follow
+    void Close();
+
+    Stats GetStats() const;
+
+private:
+    struct PendingEvent {
+        anidb_event_t event;
+        std::string text;
+        std::string context;
+        bool has_text;
+        bool has_context;
+    };
+
+    enum class Policy {
+        Keep,      // Dropped only when the pending list is full
+        Droppable, // Dropped once the list is half full
+        Merge      // Replaces the pending event of the same type
+    };
+
+    static constexpr size_t kNoIndex = static_cast<size_t>(-1);
+
+    explicit EventBridge(size_t max_pending);
+
+    static Policy PolicyFor(anidb_event_type_t type);
+    static const char** TextField(anidb_event_t& event);
+    static void CopyEvent(const anidb_event_t* event, PendingEvent& pending);
+    void Flush(Napi::Env env, Napi::Function callback);
+
+    Napi::ThreadSafeFunction tsfn_;
+    size_t max_pending_;
+
+    std::mutex mutex_;
+    std::vector<PendingEvent> pending_;
+    std::array<size_t, 16> merge_index_;
+    bool flush_scheduled_;
+
+    // Swapped with pending_ on flush so its capacity is reused
+    std::vector<PendingEvent> draining_;
+
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+#endif // EVENT_BRIDGE_H
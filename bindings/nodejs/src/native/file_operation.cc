@@ -0,0 +1,111 @@
+#include "file_operation.h"
+#include "client_wrapper.h"
+
+FileOperation::FileOperation(Napi::Env env, Napi::Promise::Deferred deferred)
+    : deferred_(deferred),
+      final_progress_(std::make_shared<anidb_progress_snapshot_t>()) {
+    // The thread-safe function keeps the event loop alive until settled
+    tsfn_ = Napi::ThreadSafeFunction::New(
+        env,
+        Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+        "FileOperation",
+        0,
+        1
+    );
+}
+
+Napi::Value FileOperation::Start(Napi::Env env, anidb::ClientRef client,
+                                 const std::string& file_path, const anidb::ProcessOptions& options) {
+    auto deferred = Napi::Promise::Deferred::New(env);
+    auto* op = new FileOperation(env, deferred);
+    
+    // Options are copied by the core before anidb_process_file_async returns
+    auto started = client.process_file_async(file_path, options);
+    anidb_result_t result = started.code();
+    
+    if (result == ANIDB_SUCCESS) {
+        op->operation_ = std::move(started.value());
+        result = op->operation_.set_callback(&FileOperation::OnComplete, op);
+        if (result != ANIDB_SUCCESS) {
+            op->operation_.reset();
+        }
+    }
+    
+    if (result != ANIDB_SUCCESS) {
+        deferred.Reject(Napi::Error::New(env, anidb_error_string(result)).Value());
+        op->tsfn_.Release();
+        delete op;
+        
+        Napi::Object failed = Napi::Object::New(env);
+        failed.Set("promise", deferred.Promise());
+        failed.Set("progress", Napi::Function::New(env, [](const Napi::CallbackInfo& info) -> Napi::Value {
+            return info.Env().Null();
+        }, "progress"));
+        failed.Set("cancel", Napi::Function::New(env, [](const Napi::CallbackInfo& info) -> Napi::Value {
+            return info.Env().Undefined();
+        }, "cancel"));
+        return failed;
+    }
+    
+    // The closures hold the handle by value; once the operation is destroyed
+    // the core rejects it as an invalid handle instead of touching freed state
+    anidb_operation_handle_t operation = op->operation_.get();
+    std::shared_ptr<anidb_progress_snapshot_t> final_progress = op->final_progress_;
+    
+    Napi::Object js_operation = Napi::Object::New(env);
+    js_operation.Set("promise", deferred.Promise());
+    js_operation.Set("progress", Napi::Function::New(env,
+        [operation, final_progress](const Napi::CallbackInfo& info) -> Napi::Value {
+            Napi::Env env = info.Env();
+            anidb_progress_snapshot_t snapshot = {};
+            if (anidb_operation_get_progress(operation, &snapshot) != ANIDB_SUCCESS) {
+                snapshot = *final_progress;
+            }
+            
+            // Doubles hold byte counts exactly up to 8 PiB
+            Napi::Object progress = Napi::Object::New(env);
+            progress.Set("bytesProcessed", Napi::Number::New(env, static_cast<double>(snapshot.bytes_processed)));
+            progress.Set("totalBytes", Napi::Number::New(env, static_cast<double>(snapshot.total_bytes)));
+            progress.Set("updates", Napi::Number::New(env, static_cast<double>(snapshot.updates)));
+            return progress;
+        }, "progress"));
+    js_operation.Set("cancel", Napi::Function::New(env,
+        [operation](const Napi::CallbackInfo& info) -> Napi::Value {
+            anidb_operation_cancel(operation);
+            return info.Env().Undefined();
+        }, "cancel"));
+    
+    return js_operation;
+}
+
+void FileOperation::OnComplete(anidb_operation_handle_t /*operation*/, anidb_result_t /*result*/,
+                               void* user_data) {
+    auto* op = static_cast<FileOperation*>(user_data);
+    
+    napi_status status = op->tsfn_.NonBlockingCall(op,
+        [](Napi::Env env, Napi::Function /*callback*/, FileOperation* data) {
+            data->Settle(env);
+            data->tsfn_.Release();
+            delete data;
+        });
+    
+    if (status != napi_ok) {
+        // Environment is shutting down; the promise can no longer be settled
+        op->tsfn_.Release();
+    }
+}
+
+void FileOperation::Settle(Napi::Env env) {
+    Napi::HandleScope scope(env);
+    
+    auto file_result = operation_.result();
+    
+    if (file_result && *file_result) {
+        deferred_.Resolve(ClientWrapper::ConvertFileResult(env, file_result->view()));
+    } else {
+        deferred_.Reject(Napi::Error::New(env, anidb_error_string(file_result.code())).Value());
+    }
+    
+    operation_.progress(final_progress_.get());
+    operation_.reset();
+}
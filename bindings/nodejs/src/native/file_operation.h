@@ -0,0 +1,43 @@
+#ifndef FILE_OPERATION_H
+#define FILE_OPERATION_H
+
+#include <napi.h>
+#include "../../../anidb_client_core/include/anidb.hpp"
+#include <memory>
+#include <string>
+
+// Promise-backed native async file operation
+//
+// The file is processed on the core's own runtime via
+// anidb_process_file_async(). Completion arrives on a core worker thread
+// and is forwarded to the JS thread through a thread-safe function, so no
+// libuv threadpool slot is held while the file is hashed.
+//
+// Progress is never pushed to JS. The hashing thread only updates the
+// core's lock-free snapshot, which JS reads at its own frame rate.
+class FileOperation {
+public:
+    // Start processing. Returns { promise, progress(), cancel() } where
+    // progress() reads the latest snapshot without blocking.
+    static Napi::Value Start(Napi::Env env, anidb::ClientRef client,
+                             const std::string& file_path, const anidb::ProcessOptions& options);
+
+private:
+    FileOperation(Napi::Env env, Napi::Promise::Deferred deferred);
+
+    // Called by the core when the operation finishes (any thread)
+    static void OnComplete(anidb_operation_handle_t operation, anidb_result_t result,
+                           void* user_data);
+
+    // Resolve or reject the promise from the JS thread
+    void Settle(Napi::Env env);
+
+    Napi::Promise::Deferred deferred_;
+    Napi::ThreadSafeFunction tsfn_;
+    anidb::Operation operation_;
+    
+    // Last snapshot, kept so progress() still answers after the handle is gone
+    std::shared_ptr<anidb_progress_snapshot_t> final_progress_;
+};
+
+#endif // FILE_OPERATION_H
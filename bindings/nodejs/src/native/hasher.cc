@@ -0,0 +1,82 @@
+#include "hasher.h"
+#include "utils.h"
+
+// HasherUpdateWorker implementation
+HasherUpdateWorker::HasherUpdateWorker(Napi::Env env, std::shared_ptr<anidb::DynamicHasher> hasher,
+                                       Napi::Object source, anidb::ByteSpan data,
+                                       Napi::Promise::Deferred deferred)
+    : Napi::AsyncWorker(env), owner_(std::move(hasher)), hasher_(owner_->get()),
+      pinned_(Napi::Persistent(source)), data_(data), result_(ANIDB_SUCCESS),
+      deferred_(deferred) {
+}
+
+void HasherUpdateWorker::Execute() {
+    result_ = anidb_hasher_update(hasher_, data_.data(), data_.size());
+}
+
+void HasherUpdateWorker::OnOK() {
+    Napi::Env env = Env();
+    
+    if (result_ != ANIDB_SUCCESS) {
+        deferred_.Reject(Utils::CreateError(env, result_).Value());
+        return;
+    }
+    
+    deferred_.Resolve(env.Undefined());
+}
+
+Napi::Value Hasher::Create(Napi::Env env, const anidb::AlgorithmSet& algorithms) {
+    auto created = anidb::DynamicHasher::create(algorithms);
+    if (!created) {
+        Utils::CreateError(env, created.code()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    // Shared by the closures below and by pending updates; the core handle
+    // is destroyed with the last of them
+    auto hasher = std::make_shared<anidb::DynamicHasher>(std::move(created.value()));
+    
+    Napi::Object js_hasher = Napi::Object::New(env);
+    
+    js_hasher.Set("update", Napi::Function::New(env, [hasher](const Napi::CallbackInfo& info) -> Napi::Value {
+        Napi::Env env = info.Env();
+        
+        anidb::ByteSpan data;
+        if (info.Length() < 1 || !Utils::GetByteView(env, info[0], &data)) {
+            Napi::TypeError::New(env, "chunk must be a Buffer, TypedArray, DataView or ArrayBuffer").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        auto* worker = new HasherUpdateWorker(env, hasher, info[0].As<Napi::Object>(),
+            data, deferred);
+        worker->Queue();
+        return deferred.Promise();
+    }, "update"));
+    
+    js_hasher.Set("finalize", Napi::Function::New(env, [hasher](const Napi::CallbackInfo& info) -> Napi::Value {
+        Napi::Env env = info.Env();
+        
+        // Output buffers are inline in HashValues; nothing is allocated
+        auto hashes = hasher->finalize();
+        if (!hashes) {
+            Utils::CreateError(env, hashes.code()).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        
+        Napi::Object js_hashes = Napi::Object::New(env);
+        for (size_t i = 0; i < hashes->size(); i++) {
+            std::string_view hash = (*hashes)[i];
+            js_hashes.Set(Utils::HashAlgorithmToString(hashes->algorithms()[i]),
+                Napi::String::New(env, hash.data(), hash.size()));
+        }
+        return js_hashes;
+    }, "finalize"));
+    
+    js_hasher.Set("destroy", Napi::Function::New(env, [hasher](const Napi::CallbackInfo& info) -> Napi::Value {
+        hasher->reset();
+        return info.Env().Undefined();
+    }, "destroy"));
+    
+    return js_hasher;
+}
@@ -0,0 +1,43 @@
+#ifndef HASHER_H
+#define HASHER_H
+
+#include <napi.h>
+#include "../../../anidb_client_core/include/anidb.hpp"
+#include <memory>
+
+// Incremental hasher backed by an anidb::DynamicHasher
+//
+// Each update() pins the chunk and feeds it to the core on a worker
+// thread, so large uploads are hashed without blocking the event loop and
+// without a temporary file. Callers must wait for one update to settle
+// before issuing the next; the HashWriter stream in index.ts does so.
+class Hasher {
+public:
+    // Create a hasher. Returns { update(chunk), finalize(), destroy() };
+    // the core handle is also released once the object and every pending
+    // update are gone.
+    static Napi::Value Create(Napi::Env env, const anidb::AlgorithmSet& algorithms);
+};
+
+// Async worker feeding one pinned chunk to a hasher
+class HasherUpdateWorker : public Napi::AsyncWorker {
+public:
+    HasherUpdateWorker(Napi::Env env, std::shared_ptr<anidb::DynamicHasher> hasher,
+                       Napi::Object source, anidb::ByteSpan data,
+                       Napi::Promise::Deferred deferred);
+    
+    void Execute() override;
+    void OnOK() override;
+    
+private:
+    // The handle is read here, on the JS thread, so a destroy() racing with
+    // this update only makes the core reject a stale handle
+    std::shared_ptr<anidb::DynamicHasher> owner_;
+    anidb_hasher_handle_t hasher_;
+    Napi::ObjectReference pinned_;
+    anidb::ByteSpan data_;
+    anidb_result_t result_;
+    Napi::Promise::Deferred deferred_;
+};
+
+#endif // HASHER_H
@@ -0,0 +1,110 @@
+#include "identify_stream.h"
+#include "client_wrapper.h"
+#include "utils.h"
+
+Napi::Value IdentifyBatchWorker::Start(Napi::Env env, anidb_client_handle_t handle,
+                                       std::vector<std::string> ed2k_hashes,
+                                       std::vector<uint64_t> file_sizes,
+                                       Napi::Function on_result, Napi::Function on_end) {
+    // Shared with the cancel function, which may outlive the worker
+    auto stop = std::make_shared<std::atomic<bool>>(false);
+    
+    auto* worker = new Worker(on_end, on_result, handle, std::move(ed2k_hashes),
+        std::move(file_sizes), stop);
+    worker->Queue();
+    
+    return Napi::Function::New(env, [stop](const Napi::CallbackInfo& info) -> Napi::Value {
+        stop->store(true);
+        return info.Env().Undefined();
+    }, "cancel");
+}
+
+IdentifyBatchWorker::Worker::Worker(Napi::Function& on_end, Napi::Function& on_result,
+                                    anidb_client_handle_t handle,
+                                    std::vector<std::string> ed2k_hashes,
+                                    std::vector<uint64_t> file_sizes,
+                                    std::shared_ptr<std::atomic<bool>> stop)
+    : Napi::AsyncProgressQueueWorker<IdentifiedFile>(on_end),
+      on_result_(Napi::Persistent(on_result)), handle_(handle),
+      ed2k_hashes_(std::move(ed2k_hashes)), file_sizes_(std::move(file_sizes)),
+      stop_(std::move(stop)), progress_(nullptr), status_(ANIDB_SUCCESS) {
+}
+
+void IdentifyBatchWorker::Worker::Execute(const ExecutionProgress& progress) {
+    std::vector<const char*> hash_ptrs;
+    for (const auto& hash : ed2k_hashes_) {
+        hash_ptrs.push_back(hash.c_str());
+    }
+    
+    progress_ = &progress;
+    status_ = anidb_identify_batch(handle_, hash_ptrs.data(), file_sizes_.data(),
+        hash_ptrs.size(), &Worker::OnIdentified, this);
+    progress_ = nullptr;
+}
+
+int IdentifyBatchWorker::Worker::OnIdentified(size_t index, anidb_result_t result,
+                                              const anidb_anime_info_t* info,
+                                              void* user_data) {
+    auto* worker = static_cast<Worker*>(user_data);
+    
+    // The info is borrowed for the duration of this call only
+    IdentifiedFile file = {};
+    file.index = index;
+    file.result = result;
+    file.has_info = info != nullptr;
+    if (info) {
+        file.anime_id = info->anime_id;
+        file.episode_id = info->episode_id;
+        file.title = info->title ? info->title : "";
+        file.episode_number = info->episode_number;
+        file.confidence = info->confidence;
+        file.source = info->source;
+    }
+    worker->progress_->Send(&file, 1);
+    
+    return worker->stop_->load() ? 1 : 0;
+}
+
+void IdentifyBatchWorker::Worker::OnProgress(const IdentifiedFile* data, size_t count) {
+    Napi::Env env = Env();
+    Napi::HandleScope scope(env);
+    
+    for (size_t i = 0; i < count; i++) {
+        const IdentifiedFile& file = data[i];
+        Napi::Object js_result = Napi::Object::New(env);
+        js_result.Set("index", Napi::Number::New(env, static_cast<double>(file.index)));
+        
+        if (file.has_info) {
+            anidb_anime_info_t info = {};
+            info.anime_id = file.anime_id;
+            info.episode_id = file.episode_id;
+            info.title = const_cast<char*>(file.title.c_str());
+            info.episode_number = file.episode_number;
+            info.confidence = file.confidence;
+            info.source = file.source;
+            js_result.Set("info", ClientWrapper::ConvertAnimeInfo(env, &info));
+        } else {
+            js_result.Set("info", env.Null());
+            js_result.Set("error", Napi::String::New(env, anidb_error_string(file.result)));
+            js_result.Set("code", Napi::Number::New(env, file.result));
+        }
+        
+        on_result_.Call({js_result});
+    }
+}
+
+void IdentifyBatchWorker::Worker::OnOK() {
+    Napi::Env env = Env();
+    Napi::HandleScope scope(env);
+    
+    if (status_ != ANIDB_SUCCESS) {
+        Callback().Call({Utils::CreateError(env, status_).Value()});
+        return;
+    }
+    Callback().Call({env.Null()});
+}
+
+void IdentifyBatchWorker::Worker::OnError(const Napi::Error& error) {
+    Napi::HandleScope scope(Env());
+    Callback().Call({error.Value()});
+}
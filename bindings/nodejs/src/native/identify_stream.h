@@ -0,0 +1,65 @@
+#ifndef IDENTIFY_STREAM_H
+#define IDENTIFY_STREAM_H
+
+#include <napi.h>
+#include "../../../anidb_client_core/include/anidb.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Streaming batch identification
+//
+// Runs the blocking anidb_identify_batch() on a worker thread. Each result
+// is copied out of the borrowed anime info and queued to the JS thread, so
+// files are reported as AniDB answers them rather than when the whole
+// batch is done.
+class IdentifyBatchWorker {
+public:
+    // Start the batch. on_result(result) is called once per file and
+    // on_end(error | null) once after the last result. Returns a function
+    // that stops the batch after the file being looked up.
+    static Napi::Value Start(Napi::Env env, anidb_client_handle_t handle,
+                             std::vector<std::string> ed2k_hashes,
+                             std::vector<uint64_t> file_sizes,
+                             Napi::Function on_result, Napi::Function on_end);
+
+private:
+    struct IdentifiedFile {
+        size_t index;
+        anidb_result_t result;
+        bool has_info;
+        uint64_t anime_id;
+        uint64_t episode_id;
+        std::string title;
+        uint32_t episode_number;
+        double confidence;
+        int source;
+    };
+
+    class Worker : public Napi::AsyncProgressQueueWorker<IdentifiedFile> {
+    public:
+        Worker(Napi::Function& on_end, Napi::Function& on_result,
+               anidb_client_handle_t handle, std::vector<std::string> ed2k_hashes,
+               std::vector<uint64_t> file_sizes, std::shared_ptr<std::atomic<bool>> stop);
+
+        void Execute(const ExecutionProgress& progress) override;
+        void OnOK() override;
+        void OnError(const Napi::Error& error) override;
+        void OnProgress(const IdentifiedFile* data, size_t count) override;
+
+    private:
+        static int OnIdentified(size_t index, anidb_result_t result,
+                                const anidb_anime_info_t* info, void* user_data);
+
+        Napi::FunctionReference on_result_;
+        anidb_client_handle_t handle_;
+        std::vector<std::string> ed2k_hashes_;
+        std::vector<uint64_t> file_sizes_;
+        std::shared_ptr<std::atomic<bool>> stop_;
+        const ExecutionProgress* progress_;
+        anidb_result_t status_;
+    };
+};
+
+#endif // IDENTIFY_STREAM_H
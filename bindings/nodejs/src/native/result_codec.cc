@@ -0,0 +1,168 @@
+#include "result_codec.h"
+#include <cstring>
+#include <string>
+
+namespace {
+
+void PutU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void PutU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+void PutU64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int Base32Value(char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= '2' && c <= '7') return c - '2' + 26;
+    return -1;
+}
+
+// Appends strings to the table, returning their offsets
+class StringTable {
+public:
+    bool Add(const char* s, size_t length, uint32_t* offset) {
+        if (bytes_.size() + length >= ResultCodec::kNoString) {
+            return false;
+        }
+        *offset = static_cast<uint32_t>(bytes_.size());
+        bytes_.append(s, length);
+        return true;
+    }
+
+    const std::string& Bytes() const { return bytes_; }
+
+private:
+    std::string bytes_;
+};
+
+} // namespace
+
+namespace ResultCodec {
+
+bool DecodeDigest(anidb_hash_algorithm_t algorithm, const char* text, size_t length,
+                  uint8_t* digest) {
+    size_t size = kDigestSize[algorithm];
+    if (algorithm == ANIDB_HASH_TTH) {
+        // Unpadded base32, 5 bits per character
+        if (length != (size * 8 + 4) / 5) {
+            return false;
+        }
+        uint32_t bits = 0;
+        int pending = 0;
+        size_t written = 0;
+        for (size_t i = 0; i < length; i++) {
+            int value = Base32Value(text[i]);
+            if (value < 0) {
+                return false;
+            }
+            bits = (bits << 5) | static_cast<uint32_t>(value);
+            pending += 5;
+            if (pending >= 8) {
+                pending -= 8;
+                digest[written++] = static_cast<uint8_t>(bits >> pending);
+            }
+        }
+        return written == size;
+    }
+
+    if (length != size * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        int high = HexValue(text[2 * i]);
+        int low = HexValue(text[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        digest[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+bool EncodeBatch(const anidb_batch_result_t* result, std::vector<uint8_t>* out) {
+    size_t count = result->results ? result->total_files : 0;
+    std::vector<uint8_t> records(count * kRecordSize, 0);
+    StringTable strings;
+
+    for (size_t i = 0; i < count; i++) {
+        const anidb_file_result_t& file = result->results[i];
+        uint8_t* record = records.data() + i * kRecordSize;
+
+        uint32_t path_offset = kNoString;
+        size_t path_length = file.file_path ? strlen(file.file_path) : 0;
+        if (file.file_path && !strings.Add(file.file_path, path_length, &path_offset)) {
+            return false;
+        }
+        uint32_t error_offset = kNoString;
+        size_t error_length = file.error_message ? strlen(file.error_message) : 0;
+        if (file.error_message && !strings.Add(file.error_message, error_length, &error_offset)) {
+            return false;
+        }
+
+        PutU32(record + 0, path_offset);
+        PutU32(record + 4, static_cast<uint32_t>(path_length));
+        PutU32(record + 8, error_offset);
+        PutU32(record + 12, static_cast<uint32_t>(error_length));
+        PutU64(record + 16, file.file_size);
+        PutU64(record + 24, file.processing_time_ms);
+        PutU32(record + 32, static_cast<uint32_t>(file.status));
+
+        uint32_t mask = 0;
+        for (size_t h = 0; h < file.hash_count; h++) {
+            const anidb_hash_result_t& hash = file.hashes[h];
+            if (hash.algorithm < ANIDB_HASH_ED2K || hash.algorithm > ANIDB_HASH_TTH ||
+                !hash.hash_value) {
+                continue;
+            }
+            if (DecodeDigest(hash.algorithm, hash.hash_value, hash.hash_length,
+                             record + kDigestOffset[hash.algorithm])) {
+                mask |= 1u << hash.algorithm;
+            }
+        }
+        PutU32(record + 36, mask);
+    }
+
+    size_t string_offset = kHeaderSize + records.size();
+    if (string_offset + strings.Bytes().size() > UINT32_MAX) {
+        return false;
+    }
+
+    out->assign(string_offset + strings.Bytes().size(), 0);
+    uint8_t* header = out->data();
+    PutU32(header + 0, kMagic);
+    PutU16(header + 4, kVersion);
+    PutU16(header + 6, static_cast<uint16_t>(kRecordSize));
+    PutU32(header + 8, static_cast<uint32_t>(count));
+    PutU32(header + 12, static_cast<uint32_t>(result->successful_files));
+    PutU32(header + 16, static_cast<uint32_t>(result->failed_files));
+    PutU32(header + 20, static_cast<uint32_t>(string_offset));
+    PutU64(header + 24, result->total_time_ms);
+
+    if (!records.empty()) {
+        memcpy(out->data() + kHeaderSize, records.data(), records.size());
+    }
+    if (!strings.Bytes().empty()) {
+        memcpy(out->data() + string_offset, strings.Bytes().data(), strings.Bytes().size());
+    }
+    return true;
+}
+
+} // namespace ResultCodec
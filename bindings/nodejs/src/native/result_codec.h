@@ -0,0 +1,54 @@
+#ifndef RESULT_CODEC_H
+#define RESULT_CODEC_H
+
+#include "../../../anidb_client_core/include/anidb.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact binary form of a batch result, decoded lazily by BatchResultView
+// in src/result_view.ts
+//
+// Converting a large batch to JS objects costs several property sets and
+// string creations per file on the main thread. Encoding happens on the
+// worker thread instead, and JS receives one ArrayBuffer. All integers are
+// little-endian.
+//
+//   header   (kHeaderSize bytes)
+//     0  u32  magic "ADBR"
+//     4  u16  format version
+//     6  u16  record size
+//     8  u32  record count
+//    12  u32  successful files
+//    16  u32  failed files
+//    20  u32  offset of the string table
+//    24  u64  total time in milliseconds
+//   records  (record count x kRecordSize bytes, in input order)
+//     0  u32  path offset      4  u32  path length
+//     8  u32  error offset    12  u32  error length (offset kNoString: none)
+//    16  u64  file size       24  u64  processing time in milliseconds
+//    32  u32  status          36  u32  digest mask (1 << algorithm)
+//    40       raw digests at kDigestOffset[algorithm], kDigestSize[algorithm]
+//   string table: UTF-8 without terminators, offsets relative to its start
+namespace ResultCodec {
+    constexpr uint32_t kMagic = 0x52424441; // "ADBR"
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 32;
+    constexpr size_t kRecordSize = 120;
+    constexpr uint32_t kNoString = 0xFFFFFFFF;
+
+    // Indexed by anidb_hash_algorithm_t
+    constexpr size_t kDigestOffset[] = {0, 40, 56, 60, 76, 96};
+    constexpr size_t kDigestSize[] = {0, 16, 4, 16, 20, 24};
+
+    // Encode a batch result. Returns false if it does not fit the format
+    // (string table over 4GB).
+    bool EncodeBatch(const anidb_batch_result_t* result, std::vector<uint8_t>* out);
+
+    // Decode a hash string into its raw digest. Returns false if the string
+    // is not a digest of the algorithm.
+    bool DecodeDigest(anidb_hash_algorithm_t algorithm, const char* text, size_t length,
+                      uint8_t* digest);
+}
+
+#endif // RESULT_CODEC_H
@@ -2,37 +2,29 @@
 #include "client_wrapper.h"
 
 StreamProcessWorker::StreamProcessWorker(Napi::Function& callback, 
-                                       anidb_client_handle_t handle,
+                                       anidb::ClientRef client,
                                        const std::string& file_path,
-                                       const std::vector<anidb_hash_algorithm_t>& algorithms)
-    : Napi::AsyncProgressWorker<float>(callback), handle_(handle), 
-      file_path_(file_path), algorithms_(algorithms), result_(nullptr),
+                                       const anidb::AlgorithmSet& algorithms)
+    : Napi::AsyncProgressWorker<float>(callback), client_(client), 
+      file_path_(file_path), algorithms_(algorithms),
       status_(ANIDB_SUCCESS), last_progress_(0.0f) {
 }
 
-StreamProcessWorker::~StreamProcessWorker() {
-    if (result_) {
-        anidb_free_file_result(result_);
-    }
-}
-
 void StreamProcessWorker::Execute(const ExecutionProgress& progress) {
-    anidb_process_options_t options = {};
-    options.algorithms = algorithms_.data();
-    options.algorithm_count = algorithms_.size();
-    options.enable_progress = 1;
-    options.verify_existing = 0;
-    options.progress_callback = &StreamProcessWorker::ProgressCallback;
-    options.user_data = const_cast<ExecutionProgress*>(&progress);
+    anidb::ProcessOptions options(algorithms_);
+    options.progress_callback(&StreamProcessWorker::ProgressCallback,
+        const_cast<ExecutionProgress*>(&progress));
     
-    status_ = anidb_process_file(handle_, file_path_.c_str(), &options, &result_);
+    auto result = client_.process_file(file_path_, options);
+    status_ = result.code();
+    result_ = std::move(result.value());
 }
 
 void StreamProcessWorker::OnOK() {
     Napi::HandleScope scope(Env());
     
     if (status_ == ANIDB_SUCCESS && result_) {
-        Napi::Object js_result = ClientWrapper::ConvertFileResult(Env(), result_);
+        Napi::Object js_result = ClientWrapper::ConvertFileResult(Env(), result_.view());
         Callback().Call({Env().Null(), js_result});
     } else {
         Callback().Call({Napi::Error::New(Env(), anidb_error_string(status_)).Value()});
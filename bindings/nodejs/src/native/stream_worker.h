@@ -2,28 +2,26 @@
 #define STREAM_WORKER_H
 
 #include <napi.h>
-#include "../../../anidb_client_core/include/anidb.h"
+#include "../../../anidb_client_core/include/anidb.hpp"
 #include <string>
 #include <memory>
 
 // Stream-based file processing worker for handling large files
 class StreamProcessWorker : public Napi::AsyncProgressWorker<float> {
 private:
-    anidb_client_handle_t handle_;
+    anidb::ClientRef client_;
     std::string file_path_;
-    std::vector<anidb_hash_algorithm_t> algorithms_;
-    anidb_file_result_t* result_;
+    anidb::AlgorithmSet algorithms_;
+    anidb::FileResult result_;
     anidb_result_t status_;
     
     // Progress tracking
     float last_progress_;
     
 public:
-    StreamProcessWorker(Napi::Function& callback, anidb_client_handle_t handle,
+    StreamProcessWorker(Napi::Function& callback, anidb::ClientRef client,
                        const std::string& file_path,
-                       const std::vector<anidb_hash_algorithm_t>& algorithms);
-    
-    ~StreamProcessWorker();
+                       const anidb::AlgorithmSet& algorithms);
     
     void Execute(const ExecutionProgress& progress) override;
     void OnOK() override;
@@ -30,41 +30,187 @@ std::string HashAlgorithmToString(anidb_hash_algorithm_t algo) {
     }
 }
 
-std::vector<anidb_hash_algorithm_t> ParseHashAlgorithms(Napi::Value value) {
-    std::vector<anidb_hash_algorithm_t> algorithms;
-    
+static bool AddHashAlgorithm(Napi::Env env, Napi::Value value, anidb::AlgorithmSet* algorithms) {
+    anidb_hash_algorithm_t algorithm;
     if (value.IsString()) {
-        // Single algorithm as string
-        std::string algo_str = value.As<Napi::String>().Utf8Value();
-        algorithms.push_back(ParseHashAlgorithm(algo_str));
+        algorithm = ParseHashAlgorithm(value.As<Napi::String>().Utf8Value());
     } else if (value.IsNumber()) {
-        // Single algorithm as number
-        algorithms.push_back(static_cast<anidb_hash_algorithm_t>(
-            value.As<Napi::Number>().Int32Value()
-        ));
-    } else if (value.IsArray()) {
-        // Multiple algorithms
+        algorithm = static_cast<anidb_hash_algorithm_t>(value.As<Napi::Number>().Int32Value());
+        if (!anidb::is_valid(algorithm)) {
+            Napi::RangeError::New(env, "Invalid hash algorithm").ThrowAsJavaScriptException();
+            return false;
+        }
+    } else {
+        return true;
+    }
+    
+    algorithms->add(algorithm);
+    return true;
+}
+
+bool ParseHashAlgorithms(Napi::Env env, Napi::Value value, anidb::AlgorithmSet* algorithms) {
+    *algorithms = anidb::AlgorithmSet();
+    
+    if (value.IsArray()) {
         Napi::Array arr = value.As<Napi::Array>();
         for (uint32_t i = 0; i < arr.Length(); i++) {
-            Napi::Value elem = arr.Get(i);
-            if (elem.IsString()) {
-                algorithms.push_back(ParseHashAlgorithm(
-                    elem.As<Napi::String>().Utf8Value()
-                ));
-            } else if (elem.IsNumber()) {
-                algorithms.push_back(static_cast<anidb_hash_algorithm_t>(
-                    elem.As<Napi::Number>().Int32Value()
-                ));
+            if (!AddHashAlgorithm(env, arr.Get(i), algorithms)) {
+                return false;
             }
         }
+    } else if (!AddHashAlgorithm(env, value, algorithms)) {
+        return false;
     }
     
     // Default to ED2K if no valid algorithms
-    if (algorithms.empty()) {
-        algorithms.push_back(ANIDB_HASH_ED2K);
+    if (algorithms->empty()) {
+        algorithms->add(ANIDB_HASH_ED2K);
+    }
+    
+    return true;
+}
+
+static bool GetFlag(const Napi::Object& options, const char* name) {
+    return options.Has(name) && options.Get(name).ToBoolean().Value();
+}
+
+// Read the optional scheduling priority, normal when absent
+static bool GetPriority(Napi::Env env, const Napi::Object& options, anidb_priority_t* out) {
+    *out = ANIDB_PRIORITY_NORMAL;
+    if (!options.Has("priority") || !options.Get("priority").IsNumber()) {
+        return true;
+    }
+    uint32_t priority = options.Get("priority").As<Napi::Number>().Uint32Value();
+    if (priority > ANIDB_PRIORITY_INTERACTIVE) {
+        Napi::RangeError::New(env, "Invalid priority").ThrowAsJavaScriptException();
+        return false;
+    }
+    *out = static_cast<anidb_priority_t>(priority);
+    return true;
+}
+
+bool ParseProcessOptions(Napi::Env env, const Napi::Object& options, anidb::ProcessOptions* out) {
+    anidb::AlgorithmSet algorithms;
+    anidb_priority_t priority;
+    if (!ParseHashAlgorithms(env, options.Get("algorithms"), &algorithms) ||
+        !GetPriority(env, options, &priority)) {
+        return false;
+    }
+    
+    *out = anidb::ProcessOptions(algorithms);
+    out->enable_progress(GetFlag(options, "enableProgress"))
+        .verify_existing(GetFlag(options, "verifyExisting"))
+        .partial_rehash(GetFlag(options, "partialRehash"))
+        .priority(priority);
+    return true;
+}
+
+bool ParseBatchOptions(Napi::Env env, const Napi::Object& options, anidb::BatchOptions* out) {
+    anidb::AlgorithmSet algorithms;
+    anidb_priority_t priority;
+    if (!ParseHashAlgorithms(env, options.Get("algorithms"), &algorithms) ||
+        !GetPriority(env, options, &priority)) {
+        return false;
+    }
+    
+    *out = anidb::BatchOptions(algorithms);
+    out->max_concurrent(options.Has("maxConcurrent") && options.Get("maxConcurrent").IsNumber() ?
+            options.Get("maxConcurrent").As<Napi::Number>().Uint32Value() : 4)
+        .continue_on_error(GetFlag(options, "continueOnError"))
+        .skip_existing(GetFlag(options, "skipExisting"))
+        .priority(priority);
+    return true;
+}
+
+// Add every pattern of an optional string array through `add`
+template <typename Add>
+static bool ReadPatterns(Napi::Env env, const Napi::Object& options, const char* name, Add add) {
+    Napi::Value value = options.Get(name);
+    if (value.IsUndefined() || value.IsNull()) {
+        return true;
+    }
+    if (!value.IsArray()) {
+        Napi::TypeError::New(env, std::string(name) + " must be an array of glob patterns").ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    Napi::Array patterns = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < patterns.Length(); i++) {
+        Napi::Value pattern = patterns.Get(i);
+        if (!pattern.IsString()) {
+            Napi::TypeError::New(env, std::string(name) + " must be an array of glob patterns").ThrowAsJavaScriptException();
+            return false;
+        }
+        add(pattern.As<Napi::String>().Utf8Value());
+    }
+    return true;
+}
+
+bool ParseScanOptions(Napi::Env env, const Napi::Object& options, anidb::ScanOptions* out) {
+    *out = anidb::ScanOptions();
+    
+    // Unlike the batch flags these default to on, so only an explicit
+    // value changes them
+    auto flag = [&](const char* name, bool fallback) {
+        Napi::Value value = options.Get(name);
+        return value.IsUndefined() ? fallback : value.ToBoolean().Value();
+    };
+    out->use_defaults(flag("useDefaults", true))
+        .recursive(flag("recursive", true))
+        .follow_links(flag("followLinks", false));
+    
+    Napi::Value max_depth = options.Get("maxDepth");
+    if (max_depth.IsNumber()) {
+        out->max_depth(max_depth.As<Napi::Number>().Uint32Value());
+    }
+    
+    return ReadPatterns(env, options, "include", [out](const std::string& p) { out->include(p); }) &&
+           ReadPatterns(env, options, "exclude", [out](const std::string& p) { out->exclude(p); });
+}
+
+bool ReadPaths(Napi::Env env, const Napi::Array& array, anidb::PathList* paths) {
+    uint32_t count = array.Length();
+    paths->reserve(count, 0);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        Napi::Value value = array.Get(i);
+        if (!value.IsString()) {
+            Napi::TypeError::New(env, "File paths must be strings").ThrowAsJavaScriptException();
+            return false;
+        }
+        
+        // Measure, then encode into the list; no std::string in between
+        size_t length = 0;
+        napi_get_value_string_utf8(env, value, nullptr, 0, &length);
+        char* path = paths->emplace(length);
+        napi_get_value_string_utf8(env, value, path, length + 1, &length);
+    }
+    
+    return true;
+}
+
+bool GetByteView(Napi::Env env, Napi::Value value, anidb::ByteSpan* bytes) {
+    // Typed arrays are queried through napi_get_typedarray_info so views
+    // over a SharedArrayBuffer work as well
+    void* raw = nullptr;
+    size_t byte_length = 0;
+    napi_status status = napi_invalid_arg;
+    
+    if (value.IsTypedArray()) {
+        byte_length = value.As<Napi::TypedArray>().ByteLength();
+        status = napi_get_typedarray_info(env, value, nullptr, nullptr, &raw, nullptr, nullptr);
+    } else if (value.IsDataView()) {
+        status = napi_get_dataview_info(env, value, &byte_length, &raw, nullptr, nullptr);
+    } else if (value.IsArrayBuffer()) {
+        status = napi_get_arraybuffer_info(env, value, &raw, &byte_length);
+    }
+    
+    if (status != napi_ok) {
+        return false;
     }
     
-    return algorithms;
+    *bytes = anidb::ByteSpan(raw, byte_length);
+    return true;
 }
 
 Napi::Error CreateError(Napi::Env env, anidb_result_t result, const std::string& context) {
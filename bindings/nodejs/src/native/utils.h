@@ -2,7 +2,7 @@
 #define UTILS_H
 
 #include <napi.h>
-#include "../../../anidb_client_core/include/anidb.h"
+#include "../../../anidb_client_core/include/anidb.hpp"
 
 namespace Utils {
     // Convert JavaScript hash algorithm string to native enum
@@ -11,8 +11,30 @@ namespace Utils {
     // Convert native hash algorithm to string
     std::string HashAlgorithmToString(anidb_hash_algorithm_t algo);
     
-    // Parse hash algorithms from JavaScript array or string
-    std::vector<anidb_hash_algorithm_t> ParseHashAlgorithms(Napi::Value value);
+    // Parse hash algorithms from a JavaScript array, string or number.
+    // Duplicates are dropped and an empty set becomes ED2K. Throws a
+    // RangeError and returns false for an unknown algorithm number.
+    bool ParseHashAlgorithms(Napi::Env env, Napi::Value value, anidb::AlgorithmSet* algorithms);
+    
+    // Parse the options shared by processFile and processFileAsync.
+    // Throws and returns false on invalid options.
+    bool ParseProcessOptions(Napi::Env env, const Napi::Object& options, anidb::ProcessOptions* out);
+    
+    // Parse the options shared by every batch method
+    bool ParseBatchOptions(Napi::Env env, const Napi::Object& options, anidb::BatchOptions* out);
+    
+    // Parse the walker options of scanAndProcess. Throws a TypeError and
+    // returns false if a pattern list is not an array of strings.
+    bool ParseScanOptions(Napi::Env env, const Napi::Object& options, anidb::ScanOptions* out);
+    
+    // Append the strings of a JavaScript array to a path list, encoding
+    // each one straight into the list's buffer. Throws a TypeError and
+    // returns false if an element is not a string.
+    bool ReadPaths(Napi::Env env, const Napi::Array& array, anidb::PathList* paths);
+    
+    // Resolve the memory behind a Buffer, TypedArray, DataView or
+    // ArrayBuffer without copying it. Returns false for any other value.
+    bool GetByteView(Napi::Env env, Napi::Value value, anidb::ByteSpan* bytes);
     
     // Create JavaScript error from AniDB result
     Napi::Error CreateError(Napi::Env env, anidb_result_t result, const std::string& context = "");
@@ -0,0 +1,230 @@
+/**
+ * Lazy view over a binary batch result
+ *
+ * Decodes the buffer produced by `processBatchBinary` (layout documented in
+ * `native/result_codec.h`) on demand: strings and hash texts are only built
+ * for the records that are read, and digests are returned as views into the
+ * buffer without copying.
+ */
+
+import { BatchResult, FileResult, HashAlgorithm, Status } from './types';
+
+const MAGIC = 0x52424441;
+const VERSION = 1;
+const HEADER_SIZE = 32;
+const NO_STRING = 0xffffffff;
+
+/** Offset and length of each digest within a record, by algorithm */
+const DIGESTS: Record<number, [number, number]> = {
+  [HashAlgorithm.ED2K]: [40, 16],
+  [HashAlgorithm.CRC32]: [56, 4],
+  [HashAlgorithm.MD5]: [60, 16],
+  [HashAlgorithm.SHA1]: [76, 20],
+  [HashAlgorithm.TTH]: [96, 24]
+};
+
+/** Names used as keys of `FileResult.hashes` */
+const ALGORITHM_NAMES: Record<number, string> = {
+  [HashAlgorithm.ED2K]: 'ED2K',
+  [HashAlgorithm.CRC32]: 'CRC32',
+  [HashAlgorithm.MD5]: 'MD5',
+  [HashAlgorithm.SHA1]: 'SHA1',
+  [HashAlgorithm.TTH]: 'TTH'
+};
+
+const BASE32_ALPHABET = 'abcdefghijklmnopqrstuvwxyz234567';
+
+const decoder = new TextDecoder();
+
+function toHex(bytes: Uint8Array): string {
+  let text = '';
+  for (let i = 0; i < bytes.length; i++) {
+    text += bytes[i].toString(16).padStart(2, '0');
+  }
+  return text;
+}
+
+/** Unpadded base32, lowercase as produced by the core */
+function toBase32(bytes: Uint8Array): string {
+  let text = '';
+  let buffer = 0;
+  let bits = 0;
+  for (let i = 0; i < bytes.length; i++) {
+    buffer = ((buffer << 8) | bytes[i]) & 0xffff;
+    bits += 8;
+    while (bits >= 5) {
+      text += BASE32_ALPHABET[(buffer >>> (bits - 5)) & 31];
+      bits -= 5;
+    }
+  }
+  if (bits > 0) {
+    text += BASE32_ALPHABET[(buffer << (5 - bits)) & 31];
+  }
+  return text;
+}
+
+/**
+ * Batch result backed by a single ArrayBuffer
+ */
+export class BatchResultView implements Iterable<FileResult> {
+  private readonly view: DataView;
+  private readonly bytes: Uint8Array;
+  private readonly recordSize: number;
+  private readonly stringTable: number;
+
+  /** Number of file records */
+  readonly length: number;
+
+  /** Number of successfully processed files */
+  readonly successfulFiles: number;
+
+  /** Number of failed files */
+  readonly failedFiles: number;
+
+  /** Total processing time in milliseconds */
+  readonly totalTimeMs: number;
+
+  constructor(buffer: ArrayBuffer) {
+    if (buffer.byteLength < HEADER_SIZE) {
+      throw new Error('Binary batch result is truncated');
+    }
+    this.view = new DataView(buffer);
+    this.bytes = new Uint8Array(buffer);
+
+    if (this.view.getUint32(0, true) !== MAGIC || this.view.getUint16(4, true) !== VERSION) {
+      throw new Error('Unsupported binary batch result');
+    }
+    this.recordSize = this.view.getUint16(6, true);
+    this.length = this.view.getUint32(8, true);
+    this.successfulFiles = this.view.getUint32(12, true);
+    this.failedFiles = this.view.getUint32(16, true);
+    this.stringTable = this.view.getUint32(20, true);
+    this.totalTimeMs = this.u64(24);
+
+    if (this.stringTable < HEADER_SIZE + this.length * this.recordSize ||
+        this.stringTable > buffer.byteLength) {
+      throw new Error('Binary batch result is truncated');
+    }
+  }
+
+  /** Total number of files */
+  get totalFiles(): number {
+    return this.length;
+  }
+
+  /** File path of record `index` */
+  filePath(index: number): string {
+    return this.string(this.record(index)) ?? '';
+  }
+
+  /** Error message of record `index`, if it failed */
+  error(index: number): string | undefined {
+    return this.string(this.record(index) + 8);
+  }
+
+  /** File size in bytes of record `index` */
+  fileSize(index: number): number {
+    return this.u64(this.record(index) + 16);
+  }
+
+  /** Processing time in milliseconds of record `index` */
+  processingTimeMs(index: number): number {
+    return this.u64(this.record(index) + 24);
+  }
+
+  /** Processing status of record `index` */
+  status(index: number): Status {
+    return this.view.getUint32(this.record(index) + 32, true);
+  }
+
+  /**
+   * Raw digest of record `index`, or undefined if it was not calculated
+   *
+   * The returned array shares memory with this view.
+   */
+  digest(index: number, algorithm: HashAlgorithm): Uint8Array | undefined {
+    const base = this.record(index);
+    const layout = DIGESTS[algorithm];
+    if (!layout || (this.view.getUint32(base + 36, true) & (1 << algorithm)) === 0) {
+      return undefined;
+    }
+    const [offset, length] = layout;
+    return this.bytes.subarray(base + offset, base + offset + length);
+  }
+
+  /** Hash of record `index` formatted as the core formats it */
+  hash(index: number, algorithm: HashAlgorithm): string | undefined {
+    const digest = this.digest(index, algorithm);
+    if (!digest) {
+      return undefined;
+    }
+    return algorithm === HashAlgorithm.TTH ? toBase32(digest) : toHex(digest);
+  }
+
+  /** All hashes of record `index`, keyed like `FileResult.hashes` */
+  hashes(index: number): Record<string, string> {
+    const hashes: Record<string, string> = {};
+    for (const key of Object.keys(DIGESTS)) {
+      const algorithm = Number(key) as HashAlgorithm;
+      const text = this.hash(index, algorithm);
+      if (text !== undefined) {
+        hashes[ALGORITHM_NAMES[algorithm]] = text;
+      }
+    }
+    return hashes;
+  }
+
+  /** Record `index` decoded as a plain file result */
+  get(index: number): FileResult {
+    const result: FileResult = {
+      filePath: this.filePath(index),
+      fileSize: this.fileSize(index),
+      status: this.status(index),
+      hashes: this.hashes(index),
+      processingTimeMs: this.processingTimeMs(index)
+    };
+    const error = this.error(index);
+    if (error !== undefined) {
+      result.error = error;
+    }
+    return result;
+  }
+
+  *[Symbol.iterator](): Iterator<FileResult> {
+    for (let i = 0; i < this.length; i++) {
+      yield this.get(i);
+    }
+  }
+
+  /** Decode every record into a regular batch result */
+  toBatchResult(): BatchResult {
+    return {
+      totalFiles: this.totalFiles,
+      successfulFiles: this.successfulFiles,
+      failedFiles: this.failedFiles,
+      results: Array.from(this),
+      totalTimeMs: this.totalTimeMs
+    };
+  }
+
+  private record(index: number): number {
+    if (!Number.isInteger(index) || index < 0 || index >= this.length) {
+      throw new RangeError(`Record index ${index} out of range`);
+    }
+    return HEADER_SIZE + index * this.recordSize;
+  }
+
+  private u64(offset: number): number {
+    return this.view.getUint32(offset, true) + this.view.getUint32(offset + 4, true) * 2 ** 32;
+  }
+
+  private string(offset: number): string | undefined {
+    const start = this.view.getUint32(offset, true);
+    if (start === NO_STRING) {
+      return undefined;
+    }
+    const begin = this.stringTable + start;
+    const end = begin + this.view.getUint32(offset + 4, true);
+    return decoder.decode(this.bytes.subarray(begin, end));
+  }
+}
@@ -6,9 +6,12 @@
  * Client configuration options
  */
 export interface AniDBConfig {
-  /** Cache directory path (default: .anidb_cache) */
+  /** Hash cache directory, enabling a cache kept between runs */
   cacheDir?: string;
   
+  /** Keep a hash cache in memory when cacheDir is unset (default: false) */
+  hashCache?: boolean;
+  
   /** Maximum concurrent file operations (default: 4) */
   maxConcurrentFiles?: number;
   
@@ -26,8 +29,81 @@ export interface AniDBConfig {
   
   /** AniDB password (optional) */
   password?: string;
+  
+  /** How files are read from disk (default: IoMode.AUTO) */
+  ioMode?: IoMode | 'auto' | 'buffered' | 'mmap' | 'direct' | 'io_uring';
+  
+  /**
+   * Tune chunk size, hashing queue depth and readers per device from the
+   * observed throughput of batches (default: false). chunkSize and
+   * maxConcurrentFiles become the starting point and upper bound.
+   */
+  autoTune?: boolean;
+  
+  /**
+   * AniDB UDP API server as "host:port" (default: api.anidb.net:9000).
+   * Meant for test servers such as the mock in anidb-test-utils.
+   */
+  server?: string;
+  
+  /**
+   * Packets per second sent to `server`, replacing AniDB's flood limits.
+   * Ignored unless `server` is set.
+   */
+  requestRate?: number;
+  
+  /** How long to wait for each AniDB response (default: 30000) */
+  requestTimeoutMs?: number;
+  
+  /**
+   * Events held natively while the event loop is busy (default: 4096).
+   * High-rate events are dropped once half of them are in use.
+   */
+  maxPendingEvents?: number;
 }
 
+/**
+ * File read modes
+ *
+ * Modes a platform cannot honour fall back to buffered reads.
+ */
+export enum IoMode {
+  /** Let the library choose (currently buffered) */
+  AUTO = 0,
+  
+  /** Page-cached reads with sequential readahead */
+  BUFFERED = 1,
+  
+  /** Memory-map files read-only (Unix) */
+  MMAP = 2,
+  
+  /** Bypass the page cache, e.g. for hashing a NAS library once (Linux/macOS) */
+  DIRECT = 3,
+  
+  /** Read ahead through a shared io_uring, several chunks per file (Linux) */
+  IO_URING = 4
+}
+
+/**
+ * Scheduling priority of file work
+ *
+ * Hashing slots and AniDB lookups go to higher priorities first, and
+ * background files pause between chunks while interactive work runs.
+ */
+export enum Priority {
+  /** Regular work */
+  NORMAL = 0,
+  
+  /** Bulk work such as library scans */
+  BACKGROUND = 1,
+  
+  /** Work a user is waiting on */
+  INTERACTIVE = 2
+}
+
+/** Priority as an enum value or its name */
+export type PriorityOption = Priority | 'normal' | 'background' | 'interactive';
+
 /**
  * Hash algorithm identifiers
  */
@@ -48,6 +124,14 @@ export enum HashAlgorithm {
   TTH = 5
 }
 
+/**
+ * Memory that can be hashed in place without copying
+ *
+ * Views over a `SharedArrayBuffer` are hashed through the shared memory
+ * directly; other threads must not write to it until hashing completes.
+ */
+export type HashInput = ArrayBufferView | ArrayBuffer | SharedArrayBuffer;
+
 /**
  * Processing status codes
  */
@@ -134,6 +218,16 @@ export interface ProcessOptions {
   /** Verify existing hashes in cache (default: false) */
   verifyExisting?: boolean;
   
+  /**
+   * Keep per-chunk ED2K digests in the cache and, when a cached file has
+   * grown or changed, re-read only the chunks that look different
+   * (default: false). Changes are detected by sampling each chunk.
+   */
+  partialRehash?: boolean;
+  
+  /** Scheduling priority (default: 'normal') */
+  priority?: PriorityOption;
+  
   /** Progress callback (alternative to events) */
   onProgress?: (progress: ProgressInfo) => void;
 }
@@ -154,6 +248,9 @@ export interface BatchOptions {
   /** Skip files already in cache (default: false) */
   skipExisting?: boolean;
   
+  /** Scheduling priority of every file (default: 'normal') */
+  priority?: PriorityOption;
+  
   /** Progress callback */
   onProgress?: (progress: BatchProgressInfo) => void;
   
@@ -161,6 +258,29 @@ export interface BatchOptions {
   onFileComplete?: (result: FileResult) => void;
 }
 
+/**
+ * Directory scan options
+ */
+export interface ScanOptions {
+  /** Glob patterns a file must match (default: common media extensions) */
+  include?: string[];
+  
+  /** Glob patterns that exclude a file even if it is included */
+  exclude?: string[];
+  
+  /** Match the default media extensions when include is empty (default: true) */
+  useDefaults?: boolean;
+  
+  /** Descend into subdirectories (default: true) */
+  recursive?: boolean;
+  
+  /** Follow symbolic links (default: false) */
+  followLinks?: boolean;
+  
+  /** Maximum depth below the root when recursive (default: unlimited) */
+  maxDepth?: number;
+}
+
 /**
  * File processing result
  */
@@ -180,8 +300,71 @@ export interface FileResult {
   /** Processing time in milliseconds */
   processingTimeMs: number;
   
+  /** Where the processing time went (not carried by binary batch results) */
+  timings?: StageTimings;
+  
   /** Error message if failed */
   error?: string;
+  
+  /** Index of the file in the input array (streamed batch results only) */
+  index?: number;
+}
+
+/**
+ * Time one file spent in each processing stage, in milliseconds
+ *
+ * Stages that did not run are 0: a file answered from the cache only has
+ * a cache lookup.
+ */
+export interface StageTimings {
+  /** Opening the file */
+  openMs: number;
+  
+  /** Waiting for data from the disk */
+  readMs: number;
+  
+  /** Waiting for a hashing slot or for hashing workers to keep up */
+  poolWaitMs: number;
+  
+  /** Hashing, all algorithms together */
+  hashMs: number;
+  
+  /** Stat'ing the file and looking it up in the cache */
+  cacheLookupMs: number;
+  
+  /** Hashing time per algorithm; parallel algorithms overlap */
+  hashMsByAlgorithm: Record<string, number>;
+}
+
+/**
+ * How a file compares to the hash cache before it is read in full
+ */
+export enum PrefilterStatus {
+  /** Nothing cached matches; the file needs a full hash */
+  UNKNOWN = 0,
+  
+  /** The file's path and metadata are cached, so its hashes are known */
+  KNOWN_IDENTITY = 1,
+  
+  /** A cached file has the same quick fingerprint, so the contents were
+   *  most likely hashed before under another path */
+  KNOWN_CONTENT = 2
+}
+
+/**
+ * Prefilter outcome for one file
+ */
+export interface PrefilterResult {
+  status: PrefilterStatus;
+  
+  /** File size in bytes (0 if the file could not be stat'ed) */
+  fileSize: number;
+  
+  /** Quick fingerprint as 16 hex digits, null if none was computed */
+  fingerprint: string | null;
+  
+  /** Bytes read to compute the fingerprint */
+  bytesRead: number;
 }
 
 /**
@@ -227,6 +410,34 @@ export interface AnimeInfo {
   source: 'anidb' | 'cache' | 'filename';
 }
 
+/**
+ * A file to identify by hash
+ */
+export interface IdentifyRequest {
+  /** ED2K hash of the file (32 hex characters) */
+  ed2kHash: string;
+  
+  /** File size in bytes */
+  fileSize: number;
+}
+
+/**
+ * Identification result for one file of a batch
+ */
+export interface IdentifyResult {
+  /** Index of the file in the request array */
+  index: number;
+  
+  /** Anime info, or null if the file could not be identified */
+  info: AnimeInfo | null;
+  
+  /** Error message when info is null */
+  error?: string;
+  
+  /** Error code when info is null (FILE_NOT_FOUND if AniDB does not know the file) */
+  code?: ErrorCode;
+}
+
 /**
  * Progress information
  */
@@ -331,6 +542,105 @@ export interface AniDBEvent {
   context?: string;
 }
 
+/**
+ * Event delivery counters since the client was created
+ */
+export interface EventStats {
+  /** Events delivered to listeners */
+  delivered: number;
+  
+  /** Memory warnings merged into a later one before delivery */
+  coalesced: number;
+  
+  /** Events dropped because listeners fell behind */
+  dropped: number;
+}
+
+/**
+ * Latency histogram
+ *
+ * Bucket i counts samples up to 4^i microseconds that did not fit the
+ * previous bucket; the last bucket has no upper bound.
+ */
+export interface Histogram {
+  /** Number of samples */
+  count: number;
+  
+  /** Sum of all samples in microseconds */
+  sumUs: number;
+  
+  /** Samples per bucket, not cumulative */
+  buckets: number[];
+}
+
+/**
+ * Processing metrics of one client since it was created
+ */
+export interface Metrics {
+  filesProcessed: number;
+  filesFailed: number;
+  
+  /** Bytes read from disk for hashing */
+  bytesRead: number;
+  
+  cacheHits: number;
+  cacheMisses: number;
+  
+  /** cacheHits / (cacheHits + cacheMisses), 0 before the first lookup */
+  cacheHitRatio: number;
+  
+  /** Files being processed right now */
+  filesInFlight: number;
+  
+  /** Files of running batches not started yet */
+  filesQueued: number;
+  
+  /** Events waiting to be delivered */
+  eventsQueued: number;
+  
+  /** Hashing slots in use, shared by every client in the process */
+  hashSlotsBusy: number;
+  hashSlotsTotal: number;
+  
+  /** AniDB requests waiting for the rate limiter */
+  networkRequestsWaiting: number;
+  
+  /** Total time AniDB requests waited for the rate limiter */
+  rateLimitWaitMs: number;
+  
+  /** AniDB packets sent again after a timeout or a busy server */
+  networkRetries: number;
+  
+  /** AniDB responses that did not arrive within the request timeout */
+  networkTimeouts: number;
+  
+  fileLatency: Histogram;
+  openLatency: Histogram;
+  readLatency: Histogram;
+  poolWait: Histogram;
+  hashLatency: Histogram;
+  cacheLookupLatency: Histogram;
+  
+  /** AniDB lookups, including authentication and rate limiting */
+  networkLatency: Histogram;
+  
+  /** Files read per I/O backend, after any fallback to buffered reads */
+  filesRead: {
+    buffered: number;
+    mmap: number;
+    direct: number;
+    ioUring: number;
+  };
+  
+  /** Values in use, picked by the tuner when autoTune is set */
+  tuning: {
+    chunkSize: number;
+    hashQueueDepth: number;
+    /** Highest reader limit of any device */
+    readersPerDevice: number;
+  };
+}
+
 /**
  * Callback types
  */
@@ -358,4 +668,84 @@ export interface StreamEvent {
   totalBytes?: number;
   result?: FileResult;
   error?: Error;
-}
\ No newline at end of file
+}
+/**
+ * CPU features detected at startup and the hash kernels selected from them
+ */
+export interface CpuFeatures {
+  sse2: boolean;
+  sse41: boolean;
+  avx2: boolean;
+  avx512f: boolean;
+  pclmulqdq: boolean;
+  neon: boolean;
+  /** ARMv8 CRC32 instructions */
+  crc32: boolean;
+
+  /** MD4 kernel used for ED2K chunks */
+  md4Kernel: 'scalar' | 'sse4.1' | 'avx2' | 'avx512' | 'neon';
+
+  /** Number of ED2K chunks hashed at once */
+  md4Lanes: number;
+
+  /** CRC32 kernel */
+  crc32Kernel: 'table' | 'pclmulqdq' | 'armv8';
+}
+
+/**
+ * Statistics of one native buffer pool
+ */
+export interface PoolStats {
+  /** Size of the buffers in this pool */
+  bufferSize: number;
+
+  /** Buffers held idle */
+  pooledBuffers: number;
+
+  /** Bytes held idle */
+  pooledBytes: number;
+
+  /** Bytes handed out and not yet released */
+  bytesInUse: number;
+
+  /** Highest bytes in use and pooled at the same time */
+  peakBytes: number;
+
+  /** Allocations served from the pool */
+  hits: number;
+
+  /** Allocations that had to allocate a new buffer */
+  misses: number;
+
+  /** hits / (hits + misses) */
+  hitRate: number;
+}
+
+/**
+ * Native memory usage, shared by every client in the process
+ */
+export interface MemoryStats {
+  /** Bytes counted against the memory limit, pooled buffers included */
+  totalMemoryUsed: number;
+
+  /** Bytes currently handed to JavaScript through the binding */
+  ffiAllocated: number;
+
+  /** Highest ffiAllocated seen */
+  ffiPeak: number;
+
+  /** Bytes held idle in the buffer pools */
+  poolMemory: number;
+
+  poolHits: number;
+  poolMisses: number;
+  activeAllocations: number;
+
+  /** Memory limit in bytes */
+  memoryLimit: number;
+
+  memoryPressure: 'low' | 'medium' | 'high' | 'critical';
+
+  /** Pools, smallest buffers first */
+  pools: PoolStats[];
+}
@@ -1,7 +1,18 @@
-import { AniDBClient, HashAlgorithm, Status, ErrorCode } from '../src';
+import {
+  AniDBClient, HashAlgorithm, Status, ErrorCode, ProgressInfo,
+  getMemoryStats, setMemoryLimit, evictStaleBuffers, shrinkMemory, BatchResultView
+} from '../src';
 import * as fs from 'fs';
 import * as path from 'path';
 import * as os from 'os';
+import { Readable } from 'stream';
+import { pipeline } from 'stream/promises';
+
+function* chunksOf(data: Buffer, size: number): Generator<Buffer> {
+  for (let offset = 0; offset < data.length; offset += size) {
+    yield data.subarray(offset, offset + size);
+  }
+}
 
 describe('AniDBClient', () => {
   let client: AniDBClient;
@@ -117,6 +128,22 @@ describe('AniDBClient', () => {
       
       expect(progressEvents.length).toBeGreaterThan(0);
     });
+    
+    it('should report exact byte progress through onProgress', async () => {
+      const updates: ProgressInfo[] = [];
+      
+      const result = await client.processFile(testFile, {
+        onProgress: (info) => updates.push(info)
+      });
+      
+      expect(updates.length).toBeGreaterThan(0);
+      const last = updates[updates.length - 1];
+      expect(last.bytesProcessed).toBe(result.fileSize);
+      expect(last.totalBytes).toBe(result.fileSize);
+      for (let i = 1; i < updates.length; i++) {
+        expect(updates[i].bytesProcessed).toBeGreaterThanOrEqual(updates[i - 1].bytesProcessed);
+      }
+    });
   });
   
   describe('processFileSync', () => {
@@ -190,6 +217,118 @@ describe('AniDBClient', () => {
       // Should still complete successfully
       expect(result.successfulFiles).toBe(3);
     });
+    
+    it('should return the same results in binary form', async () => {
+      const mixedFiles = [...testFiles, '/non/existent/file.mkv'];
+      const options = { algorithms: ['ed2k', 'crc32', 'tth'], continueOnError: true };
+      
+      const plain = await client.processBatch(mixedFiles, options);
+      const view = await client.processBatchBinary(mixedFiles, options);
+      
+      expect(view).toBeInstanceOf(BatchResultView);
+      expect(view.length).toBe(4);
+      expect(view.failedFiles).toBe(1);
+      expect(view.digest(0, HashAlgorithm.ED2K)).toHaveLength(16);
+      expect(view.digest(3, HashAlgorithm.ED2K)).toBeUndefined();
+      
+      const decoded = view.toBatchResult();
+      expect(decoded.results.map(r => r.hashes)).toEqual(plain.results.map(r => r.hashes));
+      expect(decoded.results.map(r => r.filePath)).toEqual(plain.results.map(r => r.filePath));
+      expect(decoded.results[3].error).toBe(plain.results[3].error);
+    });
+  });
+  
+  describe('processBatchStream', () => {
+    let testFiles: string[];
+    
+    beforeAll(async () => {
+      testFiles = [];
+      for (let i = 0; i < 3; i++) {
+        const file = path.join(path.dirname(testFile), `stream${i}.dat`);
+        await fs.promises.writeFile(file, Buffer.alloc(256 * 1024, i));
+        testFiles.push(file);
+      }
+    });
+    
+    afterAll(async () => {
+      for (const file of testFiles) {
+        await fs.promises.unlink(file).catch(() => {});
+      }
+    });
+    
+    it('should yield one result per file', async () => {
+      const mixedFiles = [...testFiles, '/non/existent/file.mkv'];
+      const seen: number[] = [];
+      
+      for await (const result of client.processBatchStream(mixedFiles, { continueOnError: true })) {
+        expect(result.filePath).toBe(mixedFiles[result.index!]);
+        if (result.index === 3) {
+          expect(result.status).toBe(Status.FAILED);
+        } else {
+          expect(result.status).toBe(Status.COMPLETED);
+          expect(result.hashes.ed2k).toBeDefined();
+        }
+        seen.push(result.index!);
+      }
+      
+      expect(seen.sort()).toEqual([0, 1, 2, 3]);
+    });
+    
+    it('should stop early when the loop exits', async () => {
+      let count = 0;
+      for await (const _ of client.processBatchStream(testFiles, { maxConcurrent: 1 })) {
+        count++;
+        break;
+      }
+      
+      expect(count).toBe(1);
+    });
+  });
+  
+  describe('scanAndProcess', () => {
+    let scanDir: string;
+    
+    beforeAll(async () => {
+      scanDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'anidb-scan-'));
+      await fs.promises.mkdir(path.join(scanDir, 'nested'));
+      await fs.promises.writeFile(path.join(scanDir, 'a.mkv'), Buffer.alloc(64 * 1024, 1));
+      await fs.promises.writeFile(path.join(scanDir, 'nested', 'b.mkv'), Buffer.alloc(64 * 1024, 2));
+      await fs.promises.writeFile(path.join(scanDir, 'nested', 'c.txt'), 'not media');
+    });
+    
+    afterAll(async () => {
+      await fs.promises.rm(scanDir, { recursive: true, force: true });
+    });
+    
+    it('should hash every matching file under the root', async () => {
+      const found: string[] = [];
+      for await (const result of client.scanAndProcess(scanDir)) {
+        expect(result.status).toBe(Status.COMPLETED);
+        expect(result.hashes.ed2k).toBeDefined();
+        found.push(path.relative(scanDir, result.filePath));
+      }
+      
+      expect(found.sort()).toEqual(['a.mkv', path.join('nested', 'b.mkv')]);
+    });
+    
+    it('should apply scan options', async () => {
+      const found: string[] = [];
+      for await (const result of client.scanAndProcess(scanDir, { include: ['*.txt'], recursive: true })) {
+        found.push(path.basename(result.filePath));
+      }
+      expect(found).toEqual(['c.txt']);
+      
+      let count = 0;
+      for await (const _ of client.scanAndProcess(scanDir, { recursive: false })) {
+        count++;
+      }
+      expect(count).toBe(1);
+    });
+    
+    it('should reject a missing root', async () => {
+      const scan = client.scanAndProcess(path.join(scanDir, 'missing'));
+      await expect(scan.next()).rejects.toThrow();
+    });
   });
   
   describe('calculateHash', () => {
@@ -218,7 +357,69 @@ describe('AniDBClient', () => {
     });
   });
   
+  describe('calculateHashes', () => {
+    it('should calculate several hashes in one call', async () => {
+      const buffer = Buffer.from('abc', 'utf8');
+      const hashes = await client.calculateHashes(buffer, ['crc32', 'md5', 'sha1']);
+      
+      expect(hashes).toEqual({
+        crc32: '352441c2',
+        md5: '900150983cd24fb0d6963f7d28e17f72',
+        sha1: 'a9993e364706816aba3e25717850c26c9cd0d89d'
+      });
+    });
+    
+    it('should hash views and shared memory without copying', async () => {
+      const shared = new SharedArrayBuffer(16);
+      const bytes = new Uint8Array(shared);
+      bytes.set(Buffer.from('xxabcxx', 'utf8'));
+      
+      const view = new Uint8Array(shared, 2, 3);
+      const fromView = await client.calculateHashes(view, ['md5']);
+      expect(fromView.md5).toBe('900150983cd24fb0d6963f7d28e17f72');
+      
+      const fromShared = await client.calculateHashes(shared, ['md5']);
+      const fromCopy = await client.calculateHashes(Buffer.from(bytes), ['md5']);
+      expect(fromShared).toEqual(fromCopy);
+    });
+    
+    it('should match the synchronous buffer hash', async () => {
+      const bytes = new Uint8Array(3 * 1024 * 1024).fill(0x5a);
+      const hashes = await client.calculateHashes(bytes.buffer, [HashAlgorithm.ED2K]);
+      
+      expect(hashes.ed2k).toBe(client.calculateHashBuffer(Buffer.from(bytes.buffer), 'ed2k'));
+    });
+  });
+  
+  describe('createHashWriter', () => {
+    it('should hash piped data like the whole buffer', async () => {
+      const data = Buffer.alloc(2 * 9728000 + 123);
+      for (let i = 0; i < data.length; i++) {
+        data[i] = i % 251;
+      }
+      
+      const writer = client.createHashWriter(['ed2k', 'md5']);
+      await pipeline(Readable.from(chunksOf(data, 65536)), writer);
+      
+      const expected = await client.calculateHashes(data, ['ed2k', 'md5']);
+      expect(await writer.digest()).toEqual(expected);
+      expect(writer.bytesHashed).toBe(data.length);
+    });
+    
+    it('should hash an empty stream', async () => {
+      const writer = client.createHashWriter(['md5']);
+      writer.end();
+      
+      expect(await writer.digest()).toEqual({ md5: 'd41d8cd98f00b204e9800998ecf8427e' });
+    });
+  });
+  
   describe('cache operations', () => {
+    beforeEach(() => {
+      client.destroy();
+      client = new AniDBClient({ hashCache: true });
+    });
+    
     it('should check if file is cached', async () => {
       // Process file first
       await client.processFile(testFile);
@@ -284,6 +485,64 @@ describe('AniDBClient', () => {
       
       expect(hashEvents.length).toBeGreaterThanOrEqual(2);
     });
+    
+    it('should count delivered events', async () => {
+      const delivered = new Promise((resolve) => client.once('file:complete', resolve));
+      
+      await client.processFile(testFile);
+      await delivered;
+      
+      const stats = client.getEventStats();
+      expect(stats.delivered).toBeGreaterThanOrEqual(2);
+      expect(stats.dropped).toBe(0);
+    });
+  });
+
+  describe('metrics', () => {
+    it('should report stage timings and client metrics', async () => {
+      const first = await client.processFile(testFile, { algorithms: ['ed2k', 'crc32'] });
+      expect(first.timings).toBeDefined();
+      expect(first.timings!.hashMs).toBeGreaterThanOrEqual(0);
+      expect(Object.keys(first.timings!.hashMsByAlgorithm)).toHaveLength(2);
+
+      const second = await client.processFile(testFile, { algorithms: ['ed2k', 'crc32'] });
+      expect(second.timings!.hashMs).toBe(0);
+
+      const metrics = client.getMetrics();
+      expect(metrics.filesProcessed).toBe(2);
+      expect(metrics.cacheHits).toBe(1);
+      expect(metrics.cacheHitRatio).toBeCloseTo(0.5);
+      expect(metrics.filesInFlight).toBe(0);
+      expect(metrics.fileLatency.count).toBe(2);
+      expect(metrics.fileLatency.buckets).toHaveLength(16);
+    });
+  });
+
+  describe('native memory', () => {
+    it('should report pool statistics', () => {
+      const stats = getMemoryStats();
+      
+      expect(stats.pools).toHaveLength(4);
+      expect(stats.poolMemory).toBeLessThanOrEqual(stats.totalMemoryUsed);
+      for (const pool of stats.pools) {
+        expect(pool.hitRate).toBeGreaterThanOrEqual(0);
+        expect(pool.hitRate).toBeLessThanOrEqual(1);
+      }
+    });
+    
+    it('should change the limit and free pooled buffers', () => {
+      const original = getMemoryStats().memoryLimit;
+      
+      setMemoryLimit(64 * 1024 * 1024);
+      expect(getMemoryStats().memoryLimit).toBe(64 * 1024 * 1024);
+      expect(() => setMemoryLimit(0)).toThrow();
+      
+      evictStaleBuffers(0);
+      expect(getMemoryStats().poolMemory).toBe(0);
+      expect(shrinkMemory(0)).toBe(0);
+      
+      setMemoryLimit(original);
+    });
   });
   
   describe('streaming', () => {
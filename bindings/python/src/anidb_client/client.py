@@ -178,6 +178,7 @@ class AniDBClient:
         native_options.algorithm_count = len(options.algorithms)
         native_options.enable_progress = int(options.enable_progress)
         native_options.verify_existing = int(options.verify_existing)
+        native_options.partial_rehash = int(options.partial_rehash)
         native_options.progress_callback = ctypes.cast(progress_ref, ctypes.c_void_p) if progress_ref else None
         native_options.user_data = None
         
@@ -65,7 +65,7 @@ except OSError as e:
     raise ImportError(f"Failed to load AniDB client library: {e}")
 
 # Constants
-ABI_VERSION = 1
+ABI_VERSION = 2
 
 # Enums
 class Result(IntEnum):
@@ -133,6 +133,14 @@ class Config(Structure):
         ("enable_debug_logging", c_int),
         ("username", c_char_p),
         ("password", c_char_p),
+        ("client_name", c_char_p),
+        ("client_version", c_char_p),
+        ("io_mode", c_int),
+        ("auto_tune", c_int),
+        ("server", c_char_p),
+        ("request_rate", c_double),
+        ("request_timeout_ms", c_uint32),
+        ("enable_hash_cache", c_int),
     ]
 
 class ProcessOptions(Structure):
@@ -142,8 +150,10 @@ class ProcessOptions(Structure):
         ("algorithm_count", c_size_t),
         ("enable_progress", c_int),
         ("verify_existing", c_int),
+        ("partial_rehash", c_int),
         ("progress_callback", c_void_p),
         ("user_data", c_void_p),
+        ("priority", c_int),
     ]
 
 class HashResult(Structure):
@@ -152,6 +162,17 @@ class HashResult(Structure):
         ("algorithm", c_int),
         ("hash_value", c_char_p),
         ("hash_length", c_size_t),
+        ("hash_time_us", c_uint64),
+    ]
+
+class StageTimings(Structure):
+    """Time a file spent in each processing stage."""
+    _fields_ = [
+        ("open_us", c_uint64),
+        ("read_us", c_uint64),
+        ("pool_wait_us", c_uint64),
+        ("hash_us", c_uint64),
+        ("cache_lookup_us", c_uint64),
     ]
 
 class FileResult(Structure):
@@ -164,6 +185,7 @@ class FileResult(Structure):
         ("hash_count", c_size_t),
         ("processing_time_ms", c_uint64),
         ("error_message", c_char_p),
+        ("timings", StageTimings),
     ]
 
 class AnimeInfo(Structure):
@@ -188,6 +210,14 @@ class BatchOptions(Structure):
         ("progress_callback", c_void_p),
         ("completion_callback", c_void_p),
         ("user_data", c_void_p),
+        ("priority", c_int),
+    ]
+
+class SizeCollision(Structure):
+    """A batch file that shares its size with another file of the batch."""
+    _fields_ = [
+        ("file_size", c_uint64),
+        ("path_index", c_size_t),
     ]
 
 class BatchResult(Structure):
@@ -198,6 +228,8 @@ class BatchResult(Structure):
         ("failed_files", c_size_t),
         ("results", POINTER(FileResult)),
         ("total_time_ms", c_uint64),
+        ("size_collisions", POINTER(SizeCollision)),
+        ("size_collision_count", c_size_t),
     ]
 
 # Event data structures
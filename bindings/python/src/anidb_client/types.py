@@ -100,6 +100,7 @@ class ProcessOptions:
     algorithms: List[HashAlgorithm] = field(default_factory=lambda: [HashAlgorithm.ED2K])
     enable_progress: bool = True
     verify_existing: bool = False
+    partial_rehash: bool = False
     progress_callback: Optional[Callable[[float, int, int], None]] = None
     
     def __post_init__(self):
@@ -122,6 +122,7 @@ public final class AniDBClient: @unchecked Sendable {
                     algorithm_count: algoArray.count,
                     enable_progress: progress != nil ? 1 : 0,
                     verify_existing: 0,
+                    partial_rehash: 0,
                     progress_callback: progressContext != nil ? progressCallback : nil,
                     user_data: progressContext.map { Unmanaged.passUnretained($0).toOpaque() }
                 )
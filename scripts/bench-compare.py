@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Compare benchmark results against a stored baseline.
+
+Results and baselines share one format, written by the C ABI benchmark
+(anidb_client_core/examples/c_benchmark.c) and the Node benchmark
+(bindings/nodejs/bench/benchmark.js):
+
+    {
+      "suite": "c_abi",
+      "metrics": {
+        "hash_buffer.ed2k": {"value": 1.9, "unit": "GB/s", "better": "higher"},
+        "events.latency_mean_ms": {"value": 0.4, "unit": "ms", "better": "lower",
+                                   "tolerance": 1.0}
+      }
+    }
+
+A metric regresses when it moves in the wrong direction by more than its
+tolerance (relative; the baseline's value wins over the result's, and
+--tolerance applies to metrics that have none). Metrics missing from either
+side are reported but never fail the comparison, so suites can grow.
+
+Usage:
+    bench-compare.py BASELINE RESULTS [--tolerance 0.10]
+    bench-compare.py BASELINE RESULTS --update
+
+Exits with 1 when a metric regressed and 2 when the baseline is missing.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+
+
+def load(path):
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    if not isinstance(data.get("metrics"), dict):
+        sys.exit(f"{path}: no metrics object")
+    return data
+
+
+def compare(baseline, results, default_tolerance):
+    regressions = 0
+    base_metrics = baseline["metrics"]
+    new_metrics = results["metrics"]
+
+    print(f"{'metric':34} {'baseline':>12} {'current':>12} {'change':>8}  unit")
+    for name in sorted(set(base_metrics) | set(new_metrics)):
+        base = base_metrics.get(name)
+        new = new_metrics.get(name)
+        if base is None:
+            print(f"{name:34} {'-':>12} {float(new['value']):12.3f} {'':>8}  new")
+            continue
+        if new is None:
+            print(f"{name:34} {float(base['value']):12.3f} {'-':>12} {'':>8}  missing")
+            continue
+
+        before, after = float(base["value"]), float(new["value"])
+        change = (after - before) / before if before else 0.0
+        tolerance = base.get("tolerance", new.get("tolerance", default_tolerance))
+        higher_is_better = base.get("better", "higher") == "higher"
+        worse = -change if higher_is_better else change
+
+        flag = ""
+        if worse > tolerance:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:34} {before:12.3f} {after:12.3f} {change:+8.1%}  {base.get('unit', '')}{flag}")
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("results")
+    parser.add_argument("--tolerance", type=float, default=0.10,
+                        help="allowed relative change for metrics without their own (default 0.10)")
+    parser.add_argument("--update", action="store_true",
+                        help="store RESULTS as the new baseline")
+    args = parser.parse_args()
+
+    results = load(args.results)
+    if args.update:
+        os.makedirs(os.path.dirname(os.path.abspath(args.baseline)), exist_ok=True)
+        shutil.copyfile(args.results, args.baseline)
+        print(f"Baseline {args.baseline} updated ({len(results['metrics'])} metrics)")
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print(f"No baseline at {args.baseline}; record one with --update on the reference machine",
+              file=sys.stderr)
+        return 2
+
+    baseline = load(args.baseline)
+    if baseline.get("suite") != results.get("suite"):
+        sys.exit(f"suite mismatch: {baseline.get('suite')} vs {results.get('suite')}")
+
+    regressions = compare(baseline, results, args.tolerance)
+    if regressions:
+        print(f"\n{regressions} metric(s) regressed", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())